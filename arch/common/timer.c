@@ -8,13 +8,6 @@
 
 #include "timer.h"
 
-static enum ZIP_CMP
-cmpDateTime(const UA_DateTime *a, const UA_DateTime *b) {
-    if(*a == *b)
-        return ZIP_CMP_EQ;
-    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
-}
-
 static enum ZIP_CMP
 cmpId(const UA_UInt64 *a, const UA_UInt64 *b) {
     if(*a == *b)
@@ -22,9 +15,223 @@ cmpId(const UA_UInt64 *a, const UA_UInt64 *b) {
     return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
 }
 
-ZIP_FUNCTIONS(UA_TimerTree, UA_TimerEntry, treeEntry, UA_DateTime, nextTime, cmpDateTime)
 ZIP_FUNCTIONS(UA_TimerIdTree, UA_TimerEntry, idTreeEntry, UA_UInt64, id, cmpId)
 
+#define UA_TIMER_WHEEL_MASK (UA_TIMER_WHEEL_SLOTS - 1)
+#define UA_TIMER_TOPLEVEL (UA_TIMER_WHEEL_LEVELS - 1)
+
+/* Number of trailing zero bits. Must not be called with zero. */
+static UA_UInt32
+ctz64(UA_UInt64 x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (UA_UInt32)__builtin_ctzll(x);
+#else
+    UA_UInt32 n = 0;
+    while(!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* Offset of the first occupied slot, starting the search at the slot index
+ * start and wrapping around */
+static UA_UInt32
+firstOccupied(UA_UInt64 occupied, UA_UInt32 start) {
+    UA_UInt64 rot = (start == 0) ? occupied :
+        (occupied >> start) | (occupied << (UA_TIMER_WHEEL_SLOTS - start));
+    return ctz64(rot);
+}
+
+static void
+insertEntry(UA_Timer *t, UA_TimerEntry *te) {
+    /* Entries that are already due are added to the current tick */
+    UA_Int64 tick = te->nextTime >> UA_TIMER_TICK_SHIFT;
+    if(tick < t->current)
+        tick = t->current;
+
+    /* Find the level. Clamp to the end of the top level. */
+    UA_UInt64 delta = (UA_UInt64)(tick - t->current);
+    UA_UInt32 level = 0;
+    while(level < UA_TIMER_TOPLEVEL &&
+          delta >= ((UA_UInt64)1 << (UA_TIMER_WHEEL_BITS * (level + 1))))
+        level++;
+    UA_UInt64 horizon = (UA_UInt64)1 << (UA_TIMER_WHEEL_BITS * UA_TIMER_WHEEL_LEVELS);
+    if(delta >= horizon)
+        tick = t->current + (UA_Int64)(horizon - 1);
+
+    /* Insert into the slot */
+    UA_UInt32 pos = (UA_UInt32)(tick >> (UA_TIMER_WHEEL_BITS * level)) & UA_TIMER_WHEEL_MASK;
+    UA_UInt32 idx = (level * UA_TIMER_WHEEL_SLOTS) + pos;
+    UA_UInt64 bit = (UA_UInt64)1 << pos;
+    if(!(t->occupied[level] & bit)) {
+        TAILQ_INIT(&t->slots[idx]);
+        t->slotMin[idx] = te->nextTime;
+        t->occupied[level] |= bit;
+        t->stale[level] &= ~bit;
+    } else if(te->nextTime < t->slotMin[idx]) {
+        t->slotMin[idx] = te->nextTime;
+    }
+    TAILQ_INSERT_TAIL(&t->slots[idx], te, slotEntry);
+    te->slot = (UA_UInt16)idx;
+    t->wheelSize++;
+}
+
+static void
+updateSlot(UA_Timer *t, UA_UInt32 idx) {
+    struct UA_TimerSlot *slot = &t->slots[idx];
+    UA_UInt32 level = idx / UA_TIMER_WHEEL_SLOTS;
+    UA_UInt64 bit = (UA_UInt64)1 << (idx & UA_TIMER_WHEEL_MASK);
+    t->stale[level] &= ~bit;
+    if(TAILQ_EMPTY(slot)) {
+        t->occupied[level] &= ~bit;
+        return;
+    }
+    UA_DateTime min = UA_INT64_MAX;
+    UA_TimerEntry *te;
+    TAILQ_FOREACH(te, slot, slotEntry) {
+        if(te->nextTime < min)
+            min = te->nextTime;
+    }
+    t->slotMin[idx] = min;
+}
+
+/* Must be called before the nextTime of the entry is modified. Removing the
+ * earliest entry of a slot does not rescan the slot. Otherwise draining a large
+ * slot in order would take quadratic time. */
+static void
+removeEntry(UA_Timer *t, UA_TimerEntry *te) {
+    UA_UInt32 idx = te->slot;
+    TAILQ_REMOVE(&t->slots[idx], te, slotEntry);
+    t->wheelSize--;
+    if(TAILQ_EMPTY(&t->slots[idx]))
+        updateSlot(t, idx);
+    else if(te->nextTime == t->slotMin[idx])
+        t->stale[idx / UA_TIMER_WHEEL_SLOTS] |=
+            (UA_UInt64)1 << (idx & UA_TIMER_WHEEL_MASK);
+}
+
+static UA_DateTime
+getSlotMin(UA_Timer *t, UA_UInt32 level, UA_UInt32 pos) {
+    UA_UInt32 idx = (level * UA_TIMER_WHEEL_SLOTS) + pos;
+    if(t->stale[level] & ((UA_UInt64)1 << pos))
+        updateSlot(t, idx);
+    return t->slotMin[idx];
+}
+
+/* The earliest nextTime in the wheel. Within a level below the top level, the
+ * slots hold disjoint tick ranges. So only the first occupied slot after the
+ * current tick needs to be considered. The top level can contain clamped
+ * entries beyond the horizon and all its slots are checked. */
+static UA_DateTime
+nextWheelTime(UA_Timer *t) {
+    UA_DateTime next = UA_INT64_MAX;
+    if(t->wheelSize == 0)
+        return next;
+    for(UA_UInt32 level = 0; level < UA_TIMER_WHEEL_LEVELS; level++) {
+        UA_UInt64 occupied = t->occupied[level];
+        if(!occupied)
+            continue;
+        if(level == UA_TIMER_TOPLEVEL) {
+            while(occupied) {
+                UA_DateTime slotMin = getSlotMin(t, level, ctz64(occupied));
+                if(slotMin < next)
+                    next = slotMin;
+                occupied &= occupied - 1;
+            }
+            break;
+        }
+        UA_Int64 block = t->current >> (UA_TIMER_WHEEL_BITS * level);
+        if(level > 0)
+            block++;
+        UA_UInt32 start = (UA_UInt32)block & UA_TIMER_WHEEL_MASK;
+        UA_UInt32 pos = (start + firstOccupied(occupied, start)) & UA_TIMER_WHEEL_MASK;
+        UA_DateTime slotMin = getSlotMin(t, level, pos);
+        if(slotMin < next)
+            next = slotMin;
+    }
+    return next;
+}
+
+/* The next tick (>= current) where either a slot of the lowest level is
+ * occupied or a slot of a higher level has to be cascaded down */
+static UA_Int64
+nextEventTick(UA_Timer *t) {
+    UA_Int64 next = UA_INT64_MAX;
+    for(UA_UInt32 level = 0; level < UA_TIMER_WHEEL_LEVELS; level++) {
+        UA_UInt64 occupied = t->occupied[level];
+        if(!occupied)
+            continue;
+        UA_UInt32 shift = UA_TIMER_WHEEL_BITS * level;
+        UA_Int64 block = t->current >> shift;
+        if(level > 0)
+            block++;
+        UA_UInt32 start = (UA_UInt32)block & UA_TIMER_WHEEL_MASK;
+        UA_Int64 tick = (block + firstOccupied(occupied, start)) << shift;
+        if(tick < next)
+            next = tick;
+    }
+    return next;
+}
+
+/* Move the entries of the higher-level slots that start at the current tick
+ * down to the lower levels. Begin with the highest level, as these entries can
+ * end up in the slots of the levels below. */
+static void
+cascade(UA_Timer *t) {
+    for(UA_UInt32 level = UA_TIMER_TOPLEVEL; level > 0; level--) {
+        UA_UInt32 shift = UA_TIMER_WHEEL_BITS * level;
+        if(t->current & (((UA_Int64)1 << shift) - 1))
+            continue;
+        UA_UInt32 pos = (UA_UInt32)(t->current >> shift) & UA_TIMER_WHEEL_MASK;
+        UA_UInt64 bit = (UA_UInt64)1 << pos;
+        if(!(t->occupied[level] & bit))
+            continue;
+        /* Detach the slot before re-inserting. Clamped entries can end up in
+         * the same slot again. */
+        t->occupied[level] &= ~bit;
+        t->stale[level] &= ~bit;
+        UA_TimerEntry *te = TAILQ_FIRST(&t->slots[(level * UA_TIMER_WHEEL_SLOTS) + pos]);
+        while(te) {
+            UA_TimerEntry *next = TAILQ_NEXT(te, slotEntry);
+            t->wheelSize--;
+            insertEntry(t, te);
+            te = next;
+        }
+    }
+}
+
+/* Move the entries <= now from the current slot of the lowest level into the
+ * batch. The batch is sorted by the nextTime. Entries with the same nextTime
+ * keep their insertion order. */
+static void
+collectDue(UA_Timer *t, UA_DateTime now, struct UA_TimerSlot *batch) {
+    UA_UInt32 idx = (UA_UInt32)t->current & UA_TIMER_WHEEL_MASK;
+    if(!(t->occupied[0] & ((UA_UInt64)1 << idx)))
+        return;
+    struct UA_TimerSlot *slot = &t->slots[idx];
+    UA_Boolean removed = false;
+    UA_TimerEntry *te, *te_tmp;
+    TAILQ_FOREACH_SAFE(te, slot, slotEntry, te_tmp) {
+        if(te->nextTime > now)
+            continue;
+        TAILQ_REMOVE(slot, te, slotEntry);
+        t->wheelSize--;
+        removed = true;
+        te->slot = UA_TIMER_PROCESSING;
+        UA_TimerEntry *prev = TAILQ_LAST(batch, UA_TimerSlot);
+        while(prev && prev->nextTime > te->nextTime)
+            prev = TAILQ_PREV(prev, UA_TimerSlot, slotEntry);
+        if(prev)
+            TAILQ_INSERT_AFTER(batch, prev, te, slotEntry);
+        else
+            TAILQ_INSERT_HEAD(batch, te, slotEntry);
+    }
+    if(removed)
+        updateSlot(t, idx);
+}
+
 static UA_DateTime
 calculateNextTime(UA_DateTime currentTime, UA_DateTime baseTime,
                   UA_DateTime interval) {
@@ -49,44 +256,87 @@ UA_Timer_init(UA_Timer *t) {
     UA_LOCK_INIT(&t->timerMutex);
 }
 
-/* Global variables, only used behind the mutex */
-static UA_DateTime earliest, latest, adjustedNextTime;
+typedef struct {
+    UA_TimerEntry *te;
+    UA_DateTime earliest;
+    UA_DateTime latest;
+    UA_DateTime adjustedNextTime;
+} UA_TimerBatchContext;
 
-static void *
-findTimer2Batch(void *context, UA_TimerEntry *compare) {
-    UA_TimerEntry *te = (UA_TimerEntry*)context;
+/* Returns true if a perfect match was found */
+static UA_Boolean
+findTimer2Batch(UA_TimerBatchContext *ctx, UA_TimerEntry *compare) {
+    UA_TimerEntry *te = ctx->te;
 
     /* NextTime deviation within interval? */
-    if(compare->nextTime < earliest || compare->nextTime > latest)
-        return NULL;
+    if(compare->nextTime < ctx->earliest || compare->nextTime > ctx->latest)
+        return false;
 
     /* Check if one interval is a multiple of the other */
     if(te->interval < compare->interval && compare->interval % te->interval != 0)
-        return NULL;
+        return false;
     if(te->interval > compare->interval && te->interval % compare->interval != 0)
-        return NULL;
+        return false;
 
-    adjustedNextTime = compare->nextTime; /* Candidate found */
+    ctx->adjustedNextTime = compare->nextTime; /* Candidate found */
 
     /* Abort when a perfect match is found */
-    return (te->interval == compare->interval) ? te : NULL;
+    return (te->interval == compare->interval);
 }
 
 /* Adjust the nextTime to batch cyclic callbacks. Look in an interval around the
  * original nextTime. Deviate from the original nextTime by at most 1/4 of the
- * interval and at most by 1s. */
+ * interval and at most by 1s. Only the wheel slots that overlap with that
+ * interval are searched. */
 static void
 batchTimerEntry(UA_Timer *t, UA_TimerEntry *te) {
     if(te->timerPolicy != UA_TIMERPOLICY_CURRENTTIME)
         return;
-    UA_UInt64 deviate = te->interval / 4;
+    UA_DateTime deviate = te->interval / 4;
     if(deviate > UA_DATETIME_SEC)
         deviate = UA_DATETIME_SEC;
-    earliest = te->nextTime - deviate;
-    latest = te->nextTime + deviate;
-    adjustedNextTime = te->nextTime;
-    ZIP_ITER(UA_TimerIdTree, &t->idTree, findTimer2Batch, te);
-    te->nextTime = adjustedNextTime;
+    UA_TimerBatchContext ctx;
+    ctx.te = te;
+    ctx.earliest = te->nextTime - deviate;
+    ctx.latest = te->nextTime + deviate;
+    ctx.adjustedNextTime = te->nextTime;
+
+    UA_Int64 first = ctx.earliest >> UA_TIMER_TICK_SHIFT;
+    UA_Int64 last = ctx.latest >> UA_TIMER_TICK_SHIFT;
+    if(first < t->current)
+        first = t->current;
+    for(UA_UInt32 level = 0; level < UA_TIMER_WHEEL_LEVELS; level++) {
+        if(!t->occupied[level])
+            continue;
+        /* The range of blocks held on this level */
+        UA_UInt32 shift = UA_TIMER_WHEEL_BITS * level;
+        UA_Int64 minBlock = t->current >> shift;
+        UA_Int64 maxBlock = minBlock + UA_TIMER_WHEEL_SLOTS;
+        if(level == 0)
+            maxBlock--;
+        else
+            minBlock++;
+        UA_Int64 lo = first >> shift;
+        UA_Int64 hi = last >> shift;
+        if(lo < minBlock)
+            lo = minBlock;
+        if(hi > maxBlock)
+            hi = maxBlock;
+        for(UA_Int64 block = lo; block <= hi; block++) {
+            UA_UInt32 pos = (UA_UInt32)block & UA_TIMER_WHEEL_MASK;
+            if(!(t->occupied[level] & ((UA_UInt64)1 << pos)))
+                continue;
+            UA_TimerEntry *compare;
+            TAILQ_FOREACH(compare, &t->slots[(level * UA_TIMER_WHEEL_SLOTS) + pos],
+                          slotEntry) {
+                if(findTimer2Batch(&ctx, compare))
+                    goto done;
+            }
+        }
+    }
+
+ done:
+    te->nextTime = ctx.adjustedNextTime;
 }
 
 /* Adding repeated callbacks: Add an entry with the "nextTime" timestamp in the
@@ -132,15 +382,22 @@ UA_Timer_add(UA_Timer *t, UA_ApplicationCallback callback,
     te->nextTime = nextTime;
     te->timerPolicy = timerPolicy;
 
+    UA_LOCK(&t->timerMutex);
+
+    /* Move an empty wheel forward. So the entry does not have to be cascaded
+     * down from the top level when the wheel was idle. */
+    UA_Int64 nowTick = now >> UA_TIMER_TICK_SHIFT;
+    if(t->wheelSize == 0 && nowTick > t->current)
+        t->current = nowTick;
+
     /* Adjust the nextTime to batch cyclic callbacks */
     batchTimerEntry(t, te);
 
     /* Insert into the timer */
-    UA_LOCK(&t->timerMutex);
     te->id = ++t->idCounter;
     if(callbackId)
         *callbackId = te->id;
-    ZIP_INSERT(UA_TimerTree, &t->tree, te);
+    insertEntry(t, te);
     ZIP_INSERT(UA_TimerIdTree, &t->idTree, te);
     UA_UNLOCK(&t->timerMutex);
 
@@ -174,11 +431,13 @@ UA_Timer_modify(UA_Timer *t, UA_UInt64 callbackId,
         return UA_STATUSCODE_BADNOTFOUND;
     }
 
-    /* The entry is either in the timer tree or current processed. If
-     * in-process, the entry is re-added to the timer-tree right after. */
-    UA_Boolean processing = (ZIP_REMOVE(UA_TimerTree, &t->tree, te) == NULL);
+    /* The entry is either in the wheel or currently processed. If in-process,
+     * the entry is re-added to the wheel right after. */
+    UA_Boolean processing = (te->slot == UA_TIMER_PROCESSING);
+    if(!processing)
+        removeEntry(t, te);
 
-    /* The nextTime must only be modified after ZIP_REMOVE. The logic is
+    /* The nextTime must only be modified after removeEntry. The logic is
      * identical to the creation of a new timer. */
     te->nextTime = (baseTime == NULL) ?
         now + interval : calculateNextTime(now, *baseTime, interval);
@@ -191,7 +450,7 @@ UA_Timer_modify(UA_Timer *t, UA_UInt64 callbackId,
     if(processing)
         te->nextTime -= interval; /* adjust for re-adding after processing */
     else
-        ZIP_INSERT(UA_TimerTree, &t->tree, te);
+        insertEntry(t, te);
 
     UA_UNLOCK(&t->timerMutex);
     return UA_STATUSCODE_GOOD;
@@ -206,11 +465,11 @@ UA_Timer_remove(UA_Timer *t, UA_UInt64 callbackId) {
         return;
     }
 
-    /* The entry is either in the timer tree or in the process tree. If in the
-     * process tree, leave a sentinel (callback == NULL) to delete it during
-     * processing. Do not edit the process tree while iterating over it. */
-    UA_Boolean processing = (ZIP_REMOVE(UA_TimerTree, &t->tree, te) == NULL);
-    if(!processing) {
+    /* The entry is either in the wheel or in the processed batch. If in the
+     * batch, leave a sentinel (callback == NULL) to delete it during
+     * processing. Do not edit the batch while iterating over it. */
+    if(te->slot != UA_TIMER_PROCESSING) {
+        removeEntry(t, te);
         ZIP_REMOVE(UA_TimerIdTree, &t->idTree, te);
         UA_free(te);
     } else {
@@ -220,16 +479,8 @@ UA_Timer_remove(UA_Timer *t, UA_UInt64 callbackId) {
     UA_UNLOCK(&t->timerMutex);
 }
 
-struct TimerProcessContext {
-    UA_Timer *t;
-    UA_DateTime now;
-};
-
-static void *
-processEntryCallback(void *context, UA_TimerEntry *te) {
-    struct TimerProcessContext *tpc = (struct TimerProcessContext*)context;
-    UA_Timer *t = tpc->t;
-
+static void
+processEntry(UA_Timer *t, UA_TimerEntry *te, UA_DateTime now) {
     /* Execute the callback */
     if(te->callback) {
         te->callback(te->application, te->data);
@@ -239,7 +490,7 @@ processEntryCallback(void *context, UA_TimerEntry *te) {
     if(!te->callback || te->timerPolicy == UA_TIMERPOLICY_ONCE) {
         ZIP_REMOVE(UA_TimerIdTree, &t->idTree, te);
         UA_free(te);
-        return NULL;
+        return;
     }
 
     /* Set the time for the next regular execution */
@@ -256,40 +507,54 @@ processEntryCallback(void *context, UA_TimerEntry *te) {
      *
      * Otherwise calculate the next execution time based on the original base
      * time. */
-    if(te->nextTime < tpc->now) {
+    if(te->nextTime < now) {
         te->nextTime = (te->timerPolicy == UA_TIMERPOLICY_CURRENTTIME) ?
-            tpc->now + te->interval :
-            calculateNextTime(tpc->now, te->nextTime, te->interval);
+            now + te->interval :
+            calculateNextTime(now, te->nextTime, te->interval);
     }
 
-    /* Insert back into the time-sorted tree */
-    ZIP_INSERT(UA_TimerTree, &t->tree, te);
-    return NULL;
+    /* Insert back into the wheel */
+    insertEntry(t, te);
 }
 
 UA_DateTime
 UA_Timer_process(UA_Timer *t, UA_DateTime now) {
     UA_LOCK(&t->timerMutex);
 
-    /* Move all entries <= now to the processTree */
-    UA_TimerTree processTree;
-    ZIP_INIT(&processTree);
-    ZIP_UNZIP(UA_TimerTree, &t->tree, &now, &processTree, &t->tree);
-
-    /* Consistency check. The smallest not-processed entry isn't ready. */
-    UA_assert(!ZIP_MIN(UA_TimerTree, &t->tree) ||
-              ZIP_MIN(UA_TimerTree, &t->tree)->nextTime > now);
-        
-    /* Iterate over the entries that need processing in-order. This also
-     * moves them back to the regular time-ordered tree. */
-    struct TimerProcessContext ctx;
-    ctx.t = t;
-    ctx.now = now;
-    ZIP_ITER(UA_TimerTree, &processTree, processEntryCallback, &ctx);
-        
+    /* Advance the wheel up to the tick of now. Jump directly to the ticks
+     * where a slot needs to be cascaded or processed. Move all entries <= now
+     * into the batch. */
+    struct UA_TimerSlot batch;
+    TAILQ_INIT(&batch);
+    UA_Int64 target = now >> UA_TIMER_TICK_SHIFT;
+    if(target < t->current)
+        target = t->current;
+    while(t->wheelSize > 0) {
+        UA_Int64 tick = nextEventTick(t);
+        if(tick > target)
+            break;
+        if(tick != t->current) {
+            t->current = tick;
+            cascade(t);
+        }
+        collectDue(t, now, &batch);
+        /* Before the target tick, all entries of the slot were due and the
+         * slot is now empty */
+        if(tick == target)
+            break;
+    }
+    t->current = target;
+
+    /* Process the batch in-order. Entries that are re-inserted are not
+     * processed again before the next call. */
+    UA_TimerEntry *te;
+    while((te = TAILQ_FIRST(&batch))) {
+        TAILQ_REMOVE(&batch, te, slotEntry);
+        processEntry(t, te, now);
+    }
+
     /* Compute the timestamp of the earliest next callback */
-    UA_TimerEntry *first = ZIP_MIN(UA_TimerTree, &t->tree);
-    UA_DateTime next = (first) ? first->nextTime : UA_INT64_MAX;
+    UA_DateTime next = nextWheelTime(t);
     UA_UNLOCK(&t->timerMutex);
     return next;
 }
@@ -297,8 +562,7 @@ UA_Timer_process(UA_Timer *t, UA_DateTime now) {
 UA_DateTime
 UA_Timer_next(UA_Timer *t) {
     UA_LOCK(&t->timerMutex);
-    UA_TimerEntry *first = ZIP_MIN(UA_TimerTree, &t->tree);
-    UA_DateTime next = (first) ? first->nextTime : UA_INT64_MAX;
+    UA_DateTime next = nextWheelTime(t);
     UA_UNLOCK(&t->timerMutex);
     return next;
 }
@@ -314,9 +578,11 @@ UA_Timer_clear(UA_Timer *t) {
     UA_LOCK(&t->timerMutex);
 
     ZIP_ITER(UA_TimerIdTree, &t->idTree, freeEntryCallback, NULL);
-    t->tree.root = NULL;
     t->idTree.root = NULL;
     t->idCounter = 0;
+    memset(t->occupied, 0, sizeof(t->occupied));
+    t->wheelSize = 0;
+    t->current = 0;
 
     UA_UNLOCK(&t->timerMutex);
 
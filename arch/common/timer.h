@@ -12,6 +12,7 @@
 #include <open62541/types.h>
 #include <open62541/plugin/eventloop.h>
 #include "ziptree.h"
+#include "open62541_queue.h"
 
 _UA_BEGIN_DECLS
 
@@ -26,8 +27,27 @@ _UA_BEGIN_DECLS
 /* Callback where the application is either a client or a server */
 typedef void (*UA_ApplicationCallback)(void *application, void *data);
 
+/* The timer entries are kept in a hierarchical timing wheel. The time is
+ * divided into ticks of 2^UA_TIMER_TICK_SHIFT * 100ns (~0.1ms). Every level of
+ * the wheel has UA_TIMER_WHEEL_SLOTS slots. A slot on level L covers
+ * UA_TIMER_WHEEL_SLOTS^L ticks. Entries are placed on the lowest level whose
+ * range still covers their nextTime. When the current tick reaches the range
+ * of a slot on a higher level, its entries are cascaded down to the lower
+ * levels. Adding, removing and expiring an entry takes O(1) operations. The
+ * highest level reaches ~81 days into the future. Entries beyond that are kept
+ * in the last slot of the highest level and cascaded again. */
+#define UA_TIMER_TICK_SHIFT 10
+#define UA_TIMER_WHEEL_BITS 6
+#define UA_TIMER_WHEEL_SLOTS (1 << UA_TIMER_WHEEL_BITS)
+#define UA_TIMER_WHEEL_LEVELS 6
+
+/* Slot index of entries that are currently processed */
+#define UA_TIMER_PROCESSING 0xFFFF
+
 typedef struct UA_TimerEntry {
-    ZIP_ENTRY(UA_TimerEntry) treeEntry;
+    TAILQ_ENTRY(UA_TimerEntry) slotEntry;
+    UA_UInt16 slot;                  /* Index of the wheel slot or
+                                      * UA_TIMER_PROCESSING */
     UA_TimerPolicy timerPolicy;      /* Timer policy to handle cycle misses */
     UA_DateTime nextTime;            /* The next time when the callback is to be
                                       * executed */
@@ -44,11 +64,21 @@ typedef struct UA_TimerEntry {
     UA_UInt64 id;                            /* Id of the entry */
 } UA_TimerEntry;
 
-typedef ZIP_HEAD(UA_TimerTree, UA_TimerEntry) UA_TimerTree;
+TAILQ_HEAD(UA_TimerSlot, UA_TimerEntry);
 typedef ZIP_HEAD(UA_TimerIdTree, UA_TimerEntry) UA_TimerIdTree;
 
 typedef struct {
-    UA_TimerTree tree;     /* The root of the time-sorted tree */
+    /* The slots of all levels. A slot is only initialized while its bit in
+     * the occupied-bitmap of the level is set. */
+    struct UA_TimerSlot slots[UA_TIMER_WHEEL_LEVELS * UA_TIMER_WHEEL_SLOTS];
+    UA_DateTime slotMin[UA_TIMER_WHEEL_LEVELS * UA_TIMER_WHEEL_SLOTS];
+    UA_UInt64 occupied[UA_TIMER_WHEEL_LEVELS];
+    /* The earliest entry of the slot was removed. The slotMin is then only a
+     * lower bound. It is recomputed when the slot minimum is needed next. */
+    UA_UInt64 stale[UA_TIMER_WHEEL_LEVELS];
+    UA_Int64 current;      /* The last processed tick */
+    size_t wheelSize;      /* Number of entries in the wheel */
+
     UA_TimerIdTree idTree; /* The root of the id-sorted tree */
     UA_UInt64 idCounter;   /* Generate unique identifiers. Identifiers are
                             * always above zero. */
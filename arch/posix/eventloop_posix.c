@@ -157,8 +157,20 @@ processDelayed(UA_EventLoopPOSIX *el) {
 /* EventLoop Lifecycle */
 /***********************/
 
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+static UA_StatusCode startReactors(UA_EventLoopPOSIX *el);
+static void stopReactors(UA_EventLoopPOSIX *el);
+static void joinReactors(UA_EventLoopPOSIX *el);
+#endif
+
 static UA_StatusCode
 UA_EventLoopPOSIX_start(UA_EventLoopPOSIX *el) {
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    /* Clean up the reactor threads from the last run */
+    if(el->eventLoop.state == UA_EVENTLOOPSTATE_STOPPED)
+        joinReactors(el);
+#endif
+
     UA_LOCK(&el->elMutex);
 
     if(el->eventLoop.state != UA_EVENTLOOPSTATE_FRESH &&
@@ -242,6 +254,18 @@ UA_EventLoopPOSIX_start(UA_EventLoopPOSIX *el) {
     }
 #endif
 
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    /* Start the reactor threads before the EventSources open sockets */
+    if(startReactors(el) != UA_STATUSCODE_GOOD) {
+        UA_close(el->selfpipe[0]);
+        UA_close(el->selfpipe[1]);
+        UA_close(el->epollfd);
+        UA_UNLOCK(&el->elMutex);
+        joinReactors(el);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+#endif
+
     /* Start the EventSources */
     UA_StatusCode res = UA_STATUSCODE_GOOD;
     UA_EventSource *es = el->eventLoop.eventSources;
@@ -286,6 +310,12 @@ checkClosed(UA_EventLoopPOSIX *el) {
     UA_close(el->epollfd);
 #endif
 
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    /* All fds are closed. The reactor threads are joined once the lock is
+     * released. */
+    stopReactors(el);
+#endif
+
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
                  "The EventLoop has stopped");
 }
@@ -388,6 +418,12 @@ UA_EventLoopPOSIX_run(UA_EventLoopPOSIX *el, UA_UInt32 timeout) {
 
     el->executing = false;
     UA_UNLOCK(&el->elMutex);
+
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    if(el->eventLoop.state == UA_EVENTLOOPSTATE_STOPPED)
+        joinReactors(el);
+#endif
+
     return rv;
 }
 
@@ -503,6 +539,11 @@ UA_EventLoopPOSIX_DateTime_localTimeUtcOffset(UA_EventLoop *el) {
 
 static UA_StatusCode
 UA_EventLoopPOSIX_free(UA_EventLoopPOSIX *el) {
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    if(el->eventLoop.state == UA_EVENTLOOPSTATE_STOPPED)
+        joinReactors(el);
+#endif
+
     UA_LOCK(&el->elMutex);
 
     /* Check if the EventLoop can be deleted */
@@ -537,6 +578,9 @@ UA_EventLoopPOSIX_free(UA_EventLoopPOSIX *el) {
     /* Clean up */
     UA_UNLOCK(&el->elMutex);
     UA_LOCK_DESTROY(&el->elMutex);
+#if !defined(UA_HAVE_EPOLL)
+    UA_LOCK_DESTROY(&el->listenEventsLock);
+#endif
     UA_free(el);
     return UA_STATUSCODE_GOOD;
 }
@@ -558,6 +602,9 @@ UA_EventLoop_new_POSIX(const UA_Logger *logger) {
         return NULL;
 
     UA_LOCK_INIT(&el->elMutex);
+#if !defined(UA_HAVE_EPOLL)
+    UA_LOCK_INIT(&el->listenEventsLock);
+#endif
     UA_Timer_init(&el->timer);
 
     /* Initialize the queue */
@@ -754,9 +801,15 @@ UA_EventLoopPOSIX_registerFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
 }
 
 UA_StatusCode
-UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
-    /* Do nothing, it is enough if the data was changed in the rfd */
-    UA_LOCK_ASSERT(&el->elMutex);
+UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd,
+                           short listenEvents) {
+    /* It is enough if the data was changed in the rfd. The fd sets are
+     * assembled anew in every iteration. Wake up the EventLoop so that the
+     * change takes effect right away. */
+    UA_LOCK(&el->listenEventsLock);
+    rfd->listenEvents = listenEvents;
+    UA_UNLOCK(&el->listenEventsLock);
+    UA_EventLoopPOSIX_cancel(el);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -807,6 +860,7 @@ setFDSets(UA_EventLoopPOSIX *el, fd_set *readset, fd_set *writeset, fd_set *errs
     UA_FD highestfd = el->selfpipe[0];
     FD_SET(el->selfpipe[0], readset);
 
+    UA_LOCK(&el->listenEventsLock);
     for(size_t i = 0; i < el->fdsSize; i++) {
         UA_FD currentFD = el->fds[i]->fd;
 
@@ -823,6 +877,7 @@ setFDSets(UA_EventLoopPOSIX *el, fd_set *readset, fd_set *writeset, fd_set *errs
         if(currentFD > highestfd)
             highestfd = currentFD;
     }
+    UA_UNLOCK(&el->listenEventsLock);
     return highestfd;
 }
 
@@ -904,6 +959,18 @@ UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
 
 #else /* defined(UA_HAVE_EPOLL) */
 
+/* The epoll set of the reactor that polls the rfd */
+static UA_FD
+getEpollFD(UA_EventLoopPOSIX *el, const UA_RegisteredFD *rfd) {
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    if(rfd->reactor > 0) {
+        UA_assert(rfd->reactor <= el->reactorsSize);
+        return el->reactors[rfd->reactor - 1].epollfd;
+    }
+#endif
+    return el->epollfd;
+}
+
 UA_StatusCode
 UA_EventLoopPOSIX_registerFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
     struct epoll_event event;
@@ -915,7 +982,7 @@ UA_EventLoopPOSIX_registerFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
     if(rfd->listenEvents & UA_FDEVENT_OUT)
         event.events |= EPOLLOUT;
 
-    int err = epoll_ctl(el->epollfd, EPOLL_CTL_ADD, rfd->fd, &event);
+    int err = epoll_ctl(getEpollFD(el, rfd), EPOLL_CTL_ADD, rfd->fd, &event);
     if(err != 0) {
         UA_LOG_SOCKET_ERRNO_WRAP(
            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
@@ -927,17 +994,19 @@ UA_EventLoopPOSIX_registerFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
 }
 
 UA_StatusCode
-UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd,
+                           short listenEvents) {
+    rfd->listenEvents = listenEvents;
     struct epoll_event event;
     memset(&event, 0, sizeof(struct epoll_event));
     event.data.ptr = rfd;
     event.events = 0;
-    if(rfd->listenEvents & UA_FDEVENT_IN)
+    if(listenEvents & UA_FDEVENT_IN)
         event.events |= EPOLLIN;
-    if(rfd->listenEvents & UA_FDEVENT_OUT)
+    if(listenEvents & UA_FDEVENT_OUT)
         event.events |= EPOLLOUT;
 
-    int err = epoll_ctl(el->epollfd, EPOLL_CTL_MOD, rfd->fd, &event);
+    int err = epoll_ctl(getEpollFD(el, rfd), EPOLL_CTL_MOD, rfd->fd, &event);
     if(err != 0) {
         UA_LOG_SOCKET_ERRNO_WRAP(
            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
@@ -950,7 +1019,7 @@ UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
 
 void
 UA_EventLoopPOSIX_deregisterFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
-    int res = epoll_ctl(el->epollfd, EPOLL_CTL_DEL, rfd->fd, NULL);
+    int res = epoll_ctl(getEpollFD(el, rfd), EPOLL_CTL_DEL, rfd->fd, NULL);
     if(res != 0) {
         UA_LOG_SOCKET_ERRNO_WRAP(
            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
@@ -959,6 +1028,41 @@ UA_EventLoopPOSIX_deregisterFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
     }
 }
 
+/* Process all received events. The EventLoop thread holds the EventLoop lock.
+ * The reactor threads dispatch without it. */
+static void
+processEpollEvents(UA_EventLoopPOSIX *el, UA_FD selfpipe,
+                   struct epoll_event *epoll_events, int events) {
+    for(int i = 0; i < events; i++) {
+        UA_RegisteredFD *rfd = (UA_RegisteredFD*)epoll_events[i].data.ptr;
+
+        /* The self-pipe has received */
+        if(!rfd) {
+            flushSelfPipe(selfpipe);
+            continue;
+        }
+
+        /* The rfd is already registered for removal. Don't process incoming
+         * events any longer. The closing of a reactor fd can be triggered from
+         * other threads. Then the EventSource checks under its own lock. */
+        if(rfd->reactor == 0 && rfd->dc.callback)
+            continue;
+
+        /* Get the event */
+        short revent = 0;
+        if((epoll_events[i].events & EPOLLIN) == EPOLLIN) {
+            revent = UA_FDEVENT_IN;
+        } else if((epoll_events[i].events & EPOLLOUT) == EPOLLOUT) {
+            revent = UA_FDEVENT_OUT;
+        } else {
+            revent = UA_FDEVENT_ERR;
+        }
+
+        /* Call the EventSource callback */
+        rfd->eventSourceCB(rfd->es, rfd, revent);
+    }
+}
+
 UA_StatusCode
 UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
     UA_assert(listenTimeout >= 0);
@@ -1002,38 +1106,310 @@ UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
-    /* Process all received events */
-    for(int i = 0; i < events; i++) {
-        UA_RegisteredFD *rfd = (UA_RegisteredFD*)epoll_events[i].data.ptr;
+    processEpollEvents(el, el->selfpipe[0], epoll_events, events);
+    return UA_STATUSCODE_GOOD;
+}
 
-        /* The self-pipe has received */
-        if(!rfd) {
-            flushSelfPipe(el->selfpipe[0]);
-            continue;
+#endif /* defined(UA_HAVE_EPOLL) */
+
+/*******************/
+/* Reactor Threads */
+/*******************/
+
+size_t
+UA_EventLoopPOSIX_reactorsSize(UA_EventLoopPOSIX *el) {
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    return el->reactorsSize + 1;
+#else
+    (void)el;
+    return 1;
+#endif
+}
+
+size_t
+UA_EventLoopPOSIX_nextReactor(UA_EventLoopPOSIX *el) {
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    UA_LOCK_ASSERT(&el->elMutex);
+    if(el->reactorsSize == 0)
+        return 0;
+    el->nextReactor = (el->nextReactor + 1) % (el->reactorsSize + 1);
+    return el->nextReactor;
+#else
+    (void)el;
+    return 0;
+#endif
+}
+
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+static void
+wakeReactor(UA_EventLoopPOSIXReactor *r) {
+    ssize_t err = write(r->selfpipe[1], ".", 1);
+    if(err <= 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+            UA_LOG_WARNING(r->el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                           "Eventloop\t| Error signaling the reactor (%s)",
+                           errno_str));
+    }
+}
+#endif
+
+void
+UA_EventLoopPOSIX_addDelayedFDCallback(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    if(rfd->reactor > 0) {
+        UA_EventLoopPOSIXReactor *r = &el->reactors[rfd->reactor - 1];
+        UA_LOCK(&r->lock);
+        rfd->dc.next = r->delayed;
+        r->delayed = &rfd->dc;
+        UA_UNLOCK(&r->lock);
+        wakeReactor(r);
+        return;
+    }
+#endif
+    UA_EventLoopPOSIX_addDelayedCallback(&el->eventLoop, &rfd->dc);
+}
+
+UA_StatusCode
+UA_EventLoopPOSIX_addReactorTimer(UA_EventLoopPOSIX *el, size_t reactor,
+                                  UA_Callback callback, void *application,
+                                  void *data, UA_Double interval_ms,
+                                  UA_DateTime *baseTime,
+                                  UA_TimerPolicy timerPolicy,
+                                  UA_UInt64 *callbackId) {
+    UA_DateTime now = el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
+    if(reactor == 0)
+        return UA_Timer_add(&el->timer, callback, application, data,
+                            interval_ms, now, baseTime, timerPolicy, callbackId);
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    if(reactor <= el->reactorsSize) {
+        UA_EventLoopPOSIXReactor *r = &el->reactors[reactor - 1];
+        UA_StatusCode res = UA_Timer_add(&r->timer, callback, application, data,
+                                         interval_ms, now, baseTime,
+                                         timerPolicy, callbackId);
+        /* Wake up the reactor to recompute the timeout */
+        if(res == UA_STATUSCODE_GOOD)
+            wakeReactor(r);
+        return res;
+    }
+#endif
+    return UA_STATUSCODE_BADINTERNALERROR;
+}
+
+void
+UA_EventLoopPOSIX_removeReactorTimer(UA_EventLoopPOSIX *el, size_t reactor,
+                                     UA_UInt64 callbackId) {
+    if(reactor == 0) {
+        UA_Timer_remove(&el->timer, callbackId);
+        return;
+    }
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    if(reactor <= el->reactorsSize)
+        UA_Timer_remove(&el->reactors[reactor - 1].timer, callbackId);
+#endif
+}
+
+UA_ByteString *
+UA_EventLoopPOSIX_rxBuffer(UA_EventLoopPOSIX *el, size_t reactor,
+                           UA_ByteString *defaultBuffer) {
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    if(reactor == 0 || reactor > el->reactorsSize)
+        return defaultBuffer;
+    /* Only used from within the reactor thread. Grow lazily to the size of the
+     * default buffer. */
+    UA_ByteString *buf = &el->reactors[reactor - 1].rxBuffer;
+    if(buf->length < defaultBuffer->length) {
+        UA_ByteString_clear(buf);
+        if(UA_ByteString_allocBuffer(buf, defaultBuffer->length) !=
+           UA_STATUSCODE_GOOD)
+            return NULL;
+    }
+    return buf;
+#else
+    (void)el;
+    (void)reactor;
+    return defaultBuffer;
+#endif
+}
+
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+
+/* Returns whether a callback was processed. The callbacks run without the
+ * reactor lock. Delayed callbacks added meanwhile run in the next iteration. */
+static UA_Boolean
+processReactorDelayed(UA_EventLoopPOSIXReactor *r) {
+    UA_LOCK(&r->lock);
+    UA_DelayedCallback *dc = r->delayed;
+    r->delayed = NULL;
+    UA_UNLOCK(&r->lock);
+    if(!dc)
+        return false;
+    while(dc) {
+        UA_DelayedCallback *next = dc->next; /* The callback can free the dc */
+        if(dc->callback)
+            dc->callback(dc->application, dc->context);
+        dc = next;
+    }
+    return true;
+}
+
+static UA_Boolean
+reactorRunning(UA_EventLoopPOSIXReactor *r) {
+    UA_LOCK(&r->lock);
+    UA_Boolean running = r->running;
+    UA_UNLOCK(&r->lock);
+    return running;
+}
+
+/* Milliseconds until the next timer of the reactor is due. -1 if there is no
+ * timer. */
+static int
+reactorTimeout(UA_EventLoopPOSIXReactor *r) {
+    UA_EventLoop *el = &r->el->eventLoop;
+    UA_DateTime next = UA_Timer_next(&r->timer);
+    if(next == UA_INT64_MAX)
+        return -1;
+    UA_DateTime wait = next - el->dateTime_nowMonotonic(el);
+    if(wait <= 0)
+        return 0;
+    wait = (wait + UA_DATETIME_MSEC - 1) / UA_DATETIME_MSEC; /* Round up */
+    return (wait > UA_INT32_MAX) ? UA_INT32_MAX : (int)wait;
+}
+
+static void *
+reactorLoop(void *data) {
+    UA_EventLoopPOSIXReactor *r = (UA_EventLoopPOSIXReactor*)data;
+    UA_EventLoopPOSIX *el = r->el;
+    struct epoll_event epoll_events[64];
+    while(reactorRunning(r)) {
+        int events = epoll_wait(r->epollfd, epoll_events, 64, reactorTimeout(r));
+        if(events == -1 && errno != EINTR) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                            "Eventloop\t| Reactor thread stopped (%s)",
+                            errno_str));
+            break;
         }
 
-        /* The rfd is already registered for removal. Don't process incoming
-         * events any longer. */
-        if(rfd->dc.callback)
-            continue;
+        /* Dispatch without the EventLoop lock. The fds of this reactor are
+         * only freed in this thread. So the returned events remain valid. */
+        if(events > 0)
+            processEpollEvents(el, r->selfpipe[0], epoll_events, events);
+        UA_Timer_process(&r->timer,
+                         el->eventLoop.dateTime_nowMonotonic(&el->eventLoop));
+
+        /* Fds were closed. Let the EventLoop thread check whether all
+         * EventSources have stopped. Signal the self-pipe directly. The
+         * executing flag checked in UA_EventLoopPOSIX_cancel requires the
+         * EventLoop lock. */
+        if(processReactorDelayed(r)) {
+            ssize_t err = write(el->selfpipe[1], ".", 1);
+            (void)err;
+        }
+    }
+    return NULL;
+}
 
-        /* Get the event */
-        short revent = 0;
-        if((epoll_events[i].events & EPOLLIN) == EPOLLIN) {
-            revent = UA_FDEVENT_IN;
-        } else if((epoll_events[i].events & EPOLLOUT) == EPOLLOUT) {
-            revent = UA_FDEVENT_OUT;
-        } else {
-            revent = UA_FDEVENT_ERR;
+/* Signal the reactor threads to stop. They are joined later on without
+ * holding the EventLoop lock. */
+static void
+stopReactors(UA_EventLoopPOSIX *el) {
+    for(size_t i = 0; i < el->reactorsSize; i++) {
+        UA_EventLoopPOSIXReactor *r = &el->reactors[i];
+        UA_LOCK(&r->lock);
+        UA_assert(r->delayed == NULL);
+        r->running = false;
+        UA_UNLOCK(&r->lock);
+        ssize_t err = write(r->selfpipe[1], ".", 1);
+        (void)err;
+    }
+}
+
+/* Must be called without holding the lock. Otherwise a reactor thread waiting
+ * for the lock cannot finish. */
+static void
+joinReactors(UA_EventLoopPOSIX *el) {
+    if(!el->reactors)
+        return;
+    for(size_t i = 0; i < el->reactorsSize; i++) {
+        UA_EventLoopPOSIXReactor *r = &el->reactors[i];
+        pthread_join(r->thread, NULL);
+        UA_assert(!r->running);
+        UA_close(r->selfpipe[0]);
+        UA_close(r->selfpipe[1]);
+        UA_close(r->epollfd);
+        UA_Timer_clear(&r->timer);
+        UA_ByteString_clear(&r->rxBuffer);
+        UA_LOCK_DESTROY(&r->lock);
+    }
+    UA_free(el->reactors);
+    el->reactors = NULL;
+    el->reactorsSize = 0;
+    el->nextReactor = 0;
+}
+
+static UA_StatusCode
+startReactors(UA_EventLoopPOSIX *el) {
+    UA_LOCK_ASSERT(&el->elMutex);
+    UA_assert(el->reactors == NULL);
+
+    const UA_UInt16 *threads = (const UA_UInt16*)
+        UA_KeyValueMap_getScalar(&el->eventLoop.params,
+                                 UA_QUALIFIEDNAME(0, "reactor-threads"),
+                                 &UA_TYPES[UA_TYPES_UINT16]);
+    if(!threads || *threads == 0)
+        return UA_STATUSCODE_GOOD;
+
+    el->reactors = (UA_EventLoopPOSIXReactor*)
+        UA_calloc(*threads, sizeof(UA_EventLoopPOSIXReactor));
+    if(!el->reactors)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    for(; el->reactorsSize < *threads; el->reactorsSize++) {
+        UA_EventLoopPOSIXReactor *r = &el->reactors[el->reactorsSize];
+        r->el = el;
+        r->running = true;
+
+        /* Create the epoll set and the self-pipe */
+        r->epollfd = epoll_create1(0);
+        if(r->epollfd == -1)
+            goto error;
+        if(UA_EventLoopPOSIX_pipe(r->selfpipe) != 0) {
+            UA_close(r->epollfd);
+            goto error;
         }
 
-        /* Call the EventSource callback */
-        rfd->eventSourceCB(rfd->es, rfd, revent);
+        /* Listen on the self-pipe (NULL data pointer) and start the thread */
+        struct epoll_event event;
+        memset(&event, 0, sizeof(struct epoll_event));
+        event.events = EPOLLIN;
+        UA_LOCK_INIT(&r->lock);
+        UA_Timer_init(&r->timer);
+        if(epoll_ctl(r->epollfd, EPOLL_CTL_ADD, r->selfpipe[0], &event) != 0 ||
+           pthread_create(&r->thread, NULL, reactorLoop, r) != 0) {
+            UA_Timer_clear(&r->timer);
+            UA_LOCK_DESTROY(&r->lock);
+            UA_close(r->selfpipe[0]);
+            UA_close(r->selfpipe[1]);
+            UA_close(r->epollfd);
+            goto error;
+        }
     }
+
+    UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                "Eventloop\t| Started %u reactor threads", (unsigned)*threads);
     return UA_STATUSCODE_GOOD;
+
+ error:
+    UA_LOG_SOCKET_ERRNO_WRAP(
+       UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                      "Eventloop\t| Could not start the reactor threads (%s)",
+                      errno_str));
+    stopReactors(el);
+    return UA_STATUSCODE_BADINTERNALERROR;
 }
 
-#endif /* defined(UA_HAVE_EPOLL) */
+#endif /* UA_HAVE_EVENTLOOP_REACTORS */
+
 
 #if defined(UA_ARCHITECTURE_WIN32) || defined(__APPLE__)
 int UA_EventLoopPOSIX_pipe(SOCKET fds[2]) {
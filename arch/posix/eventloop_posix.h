@@ -260,6 +260,12 @@ typedef int SOCKET;
 # include <sys/epoll.h>
 #endif
 
+/* Additional reactor threads with their own epoll set. This requires epoll,
+ * pthreads and SO_REUSEPORT to shard the listen sockets. */
+#if defined(UA_HAVE_EPOLL) && UA_MULTITHREADING >= 100 && defined(SO_REUSEPORT)
+# define UA_HAVE_EVENTLOOP_REACTORS
+#endif
+
 /*---------------------------*/
 /* File Handling Definitions */
 /*---------------------------*/
@@ -355,6 +361,10 @@ struct UA_RegisteredFD {
 
     UA_EventSource *es; /* Backpointer to the EventSource */
     UA_FDCallback eventSourceCB;
+
+    /* The reactor that polls the fd. Zero is the thread running the EventLoop.
+     * Set before registering and fixed for the lifetime of the fd. */
+    size_t reactor;
 };
 
 enum ZIP_CMP cmpFD(const UA_FD *a, const UA_FD *b);
@@ -376,7 +386,37 @@ typedef struct {
     UA_FDTree fds;
 } UA_POSIXConnectionManager;
 
+struct UA_EventLoopPOSIX;
+typedef struct UA_EventLoopPOSIX UA_EventLoopPOSIX;
+
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+/* A reactor thread polls its own set of fds and dispatches the events without
+ * the EventLoop lock. So the EventSource callbacks for the fds of different
+ * reactors run in parallel. The EventSources protect their connection state
+ * with their own locks. The fds of a reactor are closed in the reactor thread
+ * itself. So an fd is never freed while an event for it is pending. */
 typedef struct {
+    UA_EventLoopPOSIX *el;
+    pthread_t thread;
+    UA_FD epollfd;
+    UA_FD selfpipe[2]; /* 0: read, 1: write */
+
+    /* Timers that are processed in the reactor thread */
+    UA_Timer timer;
+
+    /* Receive buffer for the fds of the reactor. Only used within the reactor
+     * thread. */
+    UA_ByteString rxBuffer;
+
+    /* Protects the running flag and the delayed callbacks (closing) for the
+     * fds of the reactor. Never held during a callback. */
+    UA_Lock lock;
+    UA_Boolean running;
+    UA_DelayedCallback *delayed;
+} UA_EventLoopPOSIXReactor;
+#endif
+
+struct UA_EventLoopPOSIX {
     UA_EventLoop eventLoop;
 
     /* Timer */
@@ -411,15 +451,28 @@ typedef struct {
 #else
     UA_RegisteredFD **fds;
     size_t fdsSize;
+#if UA_MULTITHREADING >= 100
+    /* Protects the listenEvents of the registered fds. They can be modified
+     * without holding the EventLoop lock (when sending). */
+    UA_Lock listenEventsLock;
+#endif
 #endif
 
     /* Self-pipe to cancel blocking wait */
     UA_FD selfpipe[2]; /* 0: read, 1: write */
 
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    /* Additional reactor threads. The reactor with index i is used by fds with
+     * rfd->reactor == i + 1. */
+    UA_EventLoopPOSIXReactor *reactors;
+    size_t reactorsSize;
+    size_t nextReactor; /* Round-robin assignment of new connections */
+#endif
+
 #if UA_MULTITHREADING >= 100
     UA_Lock elMutex;
 #endif
-} UA_EventLoopPOSIX;
+};
 
 /* The following functions differ between epoll and normal select */
 
@@ -427,9 +480,12 @@ typedef struct {
 UA_StatusCode
 UA_EventLoopPOSIX_registerFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd);
 
-/* Modify the events that the fd listens on */
+/* Set the events that the fd listens on. Can be called without holding the
+ * EventLoop lock (when sending). Then the EventSource must serialize the calls
+ * for the rfd with its own lock. */
 UA_StatusCode
-UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd);
+UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd,
+                           short listenEvents);
 
 /* Deregister but do not close the fd. No further events are received. */
 void
@@ -438,6 +494,42 @@ UA_EventLoopPOSIX_deregisterFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd);
 UA_StatusCode
 UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout);
 
+/* Number of reactors that poll fds. Always at least one (the EventLoop thread
+ * itself). */
+size_t
+UA_EventLoopPOSIX_reactorsSize(UA_EventLoopPOSIX *el);
+
+/* Select the reactor for a new connection (round-robin) */
+size_t
+UA_EventLoopPOSIX_nextReactor(UA_EventLoopPOSIX *el);
+
+/* Add the delayed callback of the rfd (usually for closing). The callback is
+ * executed in the thread of the reactor that polls the fd. Can be called
+ * without the EventLoop lock. */
+void
+UA_EventLoopPOSIX_addDelayedFDCallback(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd);
+
+/* Add a timer that is processed in the thread of the reactor, for example for
+ * timeouts of the connections polled by the reactor. The callback is executed
+ * without the EventLoop lock. Reactor zero uses the timer of the EventLoop. */
+UA_StatusCode
+UA_EventLoopPOSIX_addReactorTimer(UA_EventLoopPOSIX *el, size_t reactor,
+                                  UA_Callback callback, void *application,
+                                  void *data, UA_Double interval_ms,
+                                  UA_DateTime *baseTime,
+                                  UA_TimerPolicy timerPolicy,
+                                  UA_UInt64 *callbackId);
+
+void
+UA_EventLoopPOSIX_removeReactorTimer(UA_EventLoopPOSIX *el, size_t reactor,
+                                     UA_UInt64 callbackId);
+
+/* Receive buffer to be used in the thread of the reactor. Reactor zero uses the
+ * default buffer. Returns NULL if the buffer could not be allocated. */
+UA_ByteString *
+UA_EventLoopPOSIX_rxBuffer(UA_EventLoopPOSIX *el, size_t reactor,
+                           UA_ByteString *defaultBuffer);
+
 /* Helper functions across EventSources */
 
 UA_StatusCode
@@ -12,13 +12,21 @@
 #if defined(UA_ARCHITECTURE_POSIX) || defined(UA_ARCHITECTURE_WIN32)
 
 /* Configuration parameters */
-#define TCP_MANAGERPARAMS 2
+#define TCP_MANAGERPARAMS 3
+#define TCP_MANAGERPARAMINDEX_BACKLOG 2
 
 static UA_KeyValueRestriction tcpManagerParams[TCP_MANAGERPARAMS] = {
     {{0, UA_STRING_STATIC("recv-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
-    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
+    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("send-backlog")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
 };
 
+/* Default limit for the queued outgoing data per connection (16MB) */
+#define TCP_DEFAULT_SEND_BACKLOG (1u << 24)
+
+/* Maximum number of queued buffers that are sent with one syscall */
+#define TCP_MAXIOV 16
+
 #define TCP_PARAMETERSSIZE 5
 #define TCP_PARAMINDEX_ADDR 0
 #define TCP_PARAMINDEX_PORT 1
@@ -34,17 +42,191 @@ static UA_KeyValueRestriction tcpConnectionParams[TCP_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("reuse")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false}
 };
 
+/* Outgoing buffer that could not be sent without blocking */
+typedef struct TCP_SendBuffer {
+    TAILQ_ENTRY(TCP_SendBuffer) next;
+    UA_ByteString buf;
+} TCP_SendBuffer;
+
 typedef struct {
     UA_RegisteredFD rfd;
 
     UA_ConnectionManager_connectionCallback applicationCB;
     void *application;
     void *context;
+
+    /* Queued outgoing buffers. They are sent out when the socket becomes
+     * writable (UA_FDEVENT_OUT). */
+    TAILQ_HEAD(, TCP_SendBuffer) sendQueue;
+    size_t sendQueueSize; /* Number of bytes that are not yet sent */
+    size_t sendOffset;    /* Bytes of the first buffer that are already sent */
+
+#if UA_MULTITHREADING >= 100
+    /* Protects the send queue, the listenEvents and the closing state (the
+     * delayed callback is set). Sending takes only this lock and not the
+     * EventLoop lock. It is never held while calling into the application. */
+    UA_Lock sendLock;
+#endif
 } TCP_FD;
 
+typedef struct {
+    UA_POSIXConnectionManager pcm;
+
+#if UA_MULTITHREADING >= 100
+    /* Protects the tree of fds. Sending looks up the connection with only
+     * this lock held and then takes the sendLock of the connection. */
+    UA_Lock fdsLock;
+#endif
+} TCP_ConnectionManager;
+
 static void
 TCP_shutdown(UA_ConnectionManager *cm, TCP_FD *conn);
 
+static void
+TCP_clearSendQueue(TCP_FD *conn) {
+    TCP_SendBuffer *sb, *sb_tmp;
+    TAILQ_FOREACH_SAFE(sb, &conn->sendQueue, next, sb_tmp) {
+        TAILQ_REMOVE(&conn->sendQueue, sb, next);
+        UA_ByteString_clear(&sb->buf);
+        UA_free(sb);
+    }
+    conn->sendQueueSize = 0;
+    conn->sendOffset = 0;
+}
+
+static void
+TCP_freeConnection(TCP_FD *conn) {
+    TCP_clearSendQueue(conn);
+    UA_LOCK_DESTROY(&conn->sendLock);
+    UA_free(conn);
+}
+
+/* Add to the tree of fds */
+static void
+TCP_addConnection(TCP_ConnectionManager *tcm, TCP_FD *conn) {
+    UA_LOCK(&tcm->fdsLock);
+    ZIP_INSERT(UA_FDTree, &tcm->pcm.fds, &conn->rfd);
+    tcm->pcm.fdsSize++;
+    UA_UNLOCK(&tcm->fdsLock);
+}
+
+/* The connection is closing (the delayed close is registered). The callbacks of
+ * the reactor threads can race with closing from another thread. So this is
+ * checked by the EventSource and not (only) by the EventLoop. */
+static UA_Boolean
+TCP_isClosing(TCP_FD *conn) {
+    UA_LOCK(&conn->sendLock);
+    UA_Boolean closing = (conn->rfd.dc.callback != NULL);
+    UA_UNLOCK(&conn->sendLock);
+    return closing;
+}
+
+/* Accepting in a reactor thread can race with stopping. The state is changed
+ * to STOPPING with the fdsLock held. */
+static UA_Boolean
+TCP_isStopping(TCP_ConnectionManager *tcm) {
+    UA_LOCK(&tcm->fdsLock);
+    UA_Boolean stopping =
+        (tcm->pcm.cm.eventSource.state == UA_EVENTSOURCESTATE_STOPPING);
+    UA_UNLOCK(&tcm->fdsLock);
+    return stopping;
+}
+
+/* Look up the connection and take its sendLock */
+static TCP_FD *
+TCP_lockConnection(TCP_ConnectionManager *tcm, uintptr_t connectionId) {
+    UA_FD fd = (UA_FD)connectionId;
+    UA_LOCK(&tcm->fdsLock);
+    TCP_FD *conn = (TCP_FD*)ZIP_FIND(UA_FDTree, &tcm->pcm.fds, &fd);
+    if(conn)
+        UA_LOCK(&conn->sendLock);
+    UA_UNLOCK(&tcm->fdsLock);
+    return conn;
+}
+
+/* Send as much of the queued data as possible without blocking. Several
+ * buffers are combined into one syscall where possible. */
+static UA_StatusCode
+TCP_flushSendQueue(TCP_FD *conn) {
+    while(!TAILQ_EMPTY(&conn->sendQueue)) {
+        UA_RESET_ERRNO;
+#ifndef UA_ARCHITECTURE_WIN32
+        struct iovec iov[TCP_MAXIOV];
+        size_t iovSize = 0;
+        size_t offset = conn->sendOffset;
+        TCP_SendBuffer *sb = TAILQ_FIRST(&conn->sendQueue);
+        for(; sb && iovSize < TCP_MAXIOV; sb = TAILQ_NEXT(sb, next)) {
+            iov[iovSize].iov_base = sb->buf.data + offset;
+            iov[iovSize].iov_len = sb->buf.length - offset;
+            iovSize++;
+            offset = 0;
+        }
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(struct msghdr));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovSize;
+        ssize_t n = sendmsg(conn->rfd.fd, &msg, MSG_NOSIGNAL);
+#else
+        TCP_SendBuffer *sb = TAILQ_FIRST(&conn->sendQueue);
+        int n = UA_send(conn->rfd.fd, (const char*)sb->buf.data + conn->sendOffset,
+                        sb->buf.length - conn->sendOffset, MSG_NOSIGNAL);
+#endif
+        if(n < 0) {
+            if(UA_ERRNO == UA_INTERRUPTED)
+                continue;
+            if(UA_ERRNO == UA_WOULDBLOCK || UA_ERRNO == UA_AGAIN)
+                return UA_STATUSCODE_GOOD; /* Wait for the next out-event */
+            return UA_STATUSCODE_BADCONNECTIONCLOSED;
+        }
+
+        /* Remove the buffers that were sent completely */
+        size_t written = (size_t)n;
+        conn->sendQueueSize -= written;
+        while(written > 0) {
+            sb = TAILQ_FIRST(&conn->sendQueue);
+            size_t remaining = sb->buf.length - conn->sendOffset;
+            if(written < remaining) {
+                conn->sendOffset += written;
+                break;
+            }
+            written -= remaining;
+            conn->sendOffset = 0;
+            TAILQ_REMOVE(&conn->sendQueue, sb, next);
+            UA_ByteString_clear(&sb->buf);
+            UA_free(sb);
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Flush the send queue and listen for out-events as long as data remains in
+ * the queue. The caller shuts down the connection if sending fails. */
+static UA_StatusCode
+TCP_flush(UA_EventLoopPOSIX *el, TCP_FD *conn) {
+    UA_LOCK_ASSERT(&conn->sendLock);
+
+    /* Not yet connected. The queue is flushed once the connection is
+     * established. */
+    if(!(conn->rfd.listenEvents & UA_FDEVENT_IN))
+        return UA_STATUSCODE_GOOD;
+
+    UA_StatusCode res = TCP_flushSendQueue(conn);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "TCP %u\t| Send failed with error %s",
+                        (unsigned)conn->rfd.fd, errno_str));
+        return res;
+    }
+
+    short listenEvents = UA_FDEVENT_IN;
+    if(!TAILQ_EMPTY(&conn->sendQueue))
+        listenEvents |= UA_FDEVENT_OUT;
+    if(listenEvents != conn->rfd.listenEvents)
+        UA_EventLoopPOSIX_modifyFD(el, &conn->rfd, listenEvents);
+    return UA_STATUSCODE_GOOD;
+}
+
 /* Do not merge packets on the socket (disable Nagle's algorithm) */
 static UA_StatusCode
 TCP_setNoNagle(UA_FD sockfd) {
@@ -60,12 +242,19 @@ static void
 TCP_checkStopped(UA_POSIXConnectionManager *pcm) {
     UA_LOCK_ASSERT(&((UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop)->elMutex);
 
-    if(pcm->fdsSize == 0 &&
-       pcm->cm.eventSource.state == UA_EVENTSOURCESTATE_STOPPING) {
+    /* Connections are added in the reactor threads without the EventLoop lock.
+     * They read the state with the fdsLock held. */
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)pcm;
+    UA_LOCK(&tcm->fdsLock);
+    UA_Boolean stopped = (pcm->fdsSize == 0 &&
+                          pcm->cm.eventSource.state == UA_EVENTSOURCESTATE_STOPPING);
+    if(stopped)
+        pcm->cm.eventSource.state = UA_EVENTSOURCESTATE_STOPPED;
+    UA_UNLOCK(&tcm->fdsLock);
+
+    if(stopped)
         UA_LOG_DEBUG(pcm->cm.eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
                      "TCP\t| All sockets closed, the EventLoop has stopped");
-        pcm->cm.eventSource.state = UA_EVENTSOURCESTATE_STOPPED;
-    }
 }
 
 static void
@@ -89,10 +278,16 @@ TCP_delayedClose(void *application, void *context) {
     /* Deregister from the EventLoop */
     UA_EventLoopPOSIX_deregisterFD(el, &conn->rfd);
 
-    /* Deregister internally */
+    /* Deregister internally. Then wait for a concurrent sender that has
+     * looked up the connection before. */
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)pcm;
+    UA_LOCK(&tcm->fdsLock);
     ZIP_REMOVE(UA_FDTree, &pcm->fds, &conn->rfd);
     UA_assert(pcm->fdsSize > 0);
     pcm->fdsSize--;
+    UA_UNLOCK(&tcm->fdsLock);
+    UA_LOCK(&conn->sendLock);
+    UA_UNLOCK(&conn->sendLock);
 
     /* Signal closing to the application */
     conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
@@ -113,7 +308,7 @@ TCP_delayedClose(void *application, void *context) {
                           (unsigned)conn->rfd.fd, errno_str));
     }
 
-    UA_free(conn);
+    TCP_freeConnection(conn);
 
     /* Check if this was the last connection for a closing ConnectionManager */
     TCP_checkStopped(pcm);
@@ -135,12 +330,16 @@ getSockError(TCP_FD *conn) {
     return (err == 0) ? error : err;
 }
 
-/* Gets called when a connection socket opens, receives data or closes */
+/* Gets called when a connection socket opens, receives data or closes. The
+ * reactor threads call this without the EventLoop lock. */
 static void
 TCP_connectionSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn,
                              short event) {
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
-    UA_LOCK_ASSERT(&el->elMutex);
+
+    /* Don't process events any longer for a closing connection */
+    if(TCP_isClosing(conn))
+        return;
 
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                  "TCP %u\t| Activity on the socket",
@@ -160,6 +359,18 @@ TCP_connectionSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn,
      * initiate the connection. So we check manually for error conditions on
      * the socket. */
     if(event == UA_FDEVENT_OUT) {
+        /* The connection is established and the socket can take more of the
+         * queued data */
+        UA_LOCK(&conn->sendLock);
+        if(conn->rfd.listenEvents & UA_FDEVENT_IN) {
+            UA_StatusCode res = TCP_flush(el, conn);
+            UA_UNLOCK(&conn->sendLock);
+            if(res != UA_STATUSCODE_GOOD)
+                TCP_shutdown(cm, conn);
+            return;
+        }
+        UA_UNLOCK(&conn->sendLock);
+
         int error = getSockError(conn);
         if(error != 0) {
             UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
@@ -173,9 +384,16 @@ TCP_connectionSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn,
                      "TCP %u\t| Opening a new connection",
                      (unsigned)conn->rfd.fd);
 
-        /* Now we are interested in read-events. */
-        conn->rfd.listenEvents = UA_FDEVENT_IN;
-        UA_EventLoopPOSIX_modifyFD(el, &conn->rfd);
+        /* Now we are interested in read-events. And in write-events if data
+         * was queued before the connection was established. */
+        UA_LOCK(&conn->sendLock);
+        UA_EventLoopPOSIX_modifyFD(el, &conn->rfd, UA_FDEVENT_IN);
+        UA_StatusCode res = TCP_flush(el, conn);
+        UA_UNLOCK(&conn->sendLock);
+        if(res != UA_STATUSCODE_GOOD) {
+            TCP_shutdown(cm, conn);
+            return;
+        }
 
         /* A new socket has opened. Signal it to the application. */
         conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
@@ -185,13 +403,34 @@ TCP_connectionSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn,
         return;
     }
 
+    /* The EventLoop signals only the in-event if the socket is both readable
+     * and writable. So also flush here to not starve the send queue. */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_LOCK(&conn->sendLock);
+    if(!TAILQ_EMPTY(&conn->sendQueue))
+        res = TCP_flush(el, conn);
+    UA_UNLOCK(&conn->sendLock);
+    if(res != UA_STATUSCODE_GOOD) {
+        TCP_shutdown(cm, conn);
+        return;
+    }
+
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                  "TCP %u\t| Allocate receive buffer",
                  (unsigned)conn->rfd.fd);
 
-    /* Use the already allocated receive-buffer */
+    /* Use the already allocated receive-buffer. Every reactor thread has its
+     * own. */
     UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
-    UA_ByteString response = pcm->rxBuffer;
+    UA_ByteString *rxBuffer =
+        UA_EventLoopPOSIX_rxBuffer(el, conn->rfd.reactor, &pcm->rxBuffer);
+    if(!rxBuffer) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP %u\t| Could not allocate the receive buffer",
+                       (unsigned)conn->rfd.fd);
+        return;
+    }
+    UA_ByteString response = *rxBuffer;
 
     /* Receive */
     UA_RESET_ERRNO;
@@ -231,12 +470,16 @@ TCP_connectionSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn,
                         &UA_KEYVALUEMAP_NULL, response);
 }
 
-/* Gets called when a new connection opens or if the listenSocket is closed */
+/* Gets called when a new connection opens or if the listenSocket is closed.
+ * The reactor threads call this without the EventLoop lock. */
 static void
 TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
-    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)cm;
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
-    UA_LOCK_ASSERT(&el->elMutex);
+
+    /* Don't accept any longer on a closing listen socket */
+    if(TCP_isClosing(conn))
+        return;
 
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                  "TCP %u\t| Callback on server socket",
@@ -253,7 +496,7 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
             return;
 
         /* Close the listen socket */
-        if(cm->eventSource.state != UA_EVENTSOURCESTATE_STOPPING) {
+        if(!TCP_isStopping(tcm)) {
             UA_LOG_SOCKET_ERRNO_WRAP(
                 UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                                "TCP %u\t| Error %s, closing the server socket",
@@ -307,9 +550,12 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
     }
 
     newConn->rfd.fd = newsockfd;
+    TAILQ_INIT(&newConn->sendQueue);
+    UA_LOCK_INIT(&newConn->sendLock);
     newConn->rfd.listenEvents = UA_FDEVENT_IN;
     newConn->rfd.es = &cm->eventSource;
     newConn->rfd.eventSourceCB = (UA_FDCallback)TCP_connectionSocketCallback;
+    newConn->rfd.reactor = conn->rfd.reactor; /* Same reactor as the listen socket */
     newConn->applicationCB = conn->applicationCB;
     newConn->application = conn->application;
     newConn->context = conn->context;
@@ -320,14 +566,13 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
         UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                        "TCP %u\t| Error registering the socket",
                        (unsigned)newsockfd);
-        UA_free(newConn);
+        TCP_freeConnection(newConn);
         UA_close(newsockfd);
         return;
     }
 
     /* Register internally in the EventSource */
-    ZIP_INSERT(UA_FDTree, &pcm->fds, &newConn->rfd);
-    pcm->fdsSize++;
+    TCP_addConnection(tcm, newConn);
 
     /* Forward the remote hostname to the application */
     UA_KeyValuePair kvp;
@@ -344,6 +589,11 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
                            newConn->application, &newConn->context,
                            UA_CONNECTIONSTATE_ESTABLISHED,
                            &kvm, UA_BYTESTRING_NULL);
+
+    /* The ConnectionManager has begun stopping concurrently. The connection
+     * was added after all connections were shut down. So close it here. */
+    if(TCP_isStopping(tcm))
+        TCP_shutdown(cm, newConn);
 }
 
 static UA_StatusCode
@@ -351,7 +601,7 @@ TCP_registerListenSocket(UA_POSIXConnectionManager *pcm, struct addrinfo *ai,
                          const char *hostname, UA_UInt16 port,
                          void *application, void *context,
                          UA_ConnectionManager_connectionCallback connectionCallback,
-                         UA_Boolean validate, UA_Boolean reuseaddr) {
+                         UA_Boolean validate, UA_Boolean reuseaddr, size_t reactor) {
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
     UA_LOCK_ASSERT(&el->elMutex);
 
@@ -411,6 +661,21 @@ TCP_registerListenSocket(UA_POSIXConnectionManager *pcm, struct addrinfo *ai,
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    /* Every reactor has its own listen socket for the same address. The kernel
+     * distributes the incoming connections between them. */
+    int reuseport = 1;
+    if(UA_EventLoopPOSIX_reactorsSize(el) > 1 &&
+       UA_setsockopt(listenSocket, SOL_SOCKET, SO_REUSEPORT,
+                     (const char*)&reuseport, sizeof(reuseport)) == -1) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP %u\t| Could not share the socket between the reactors",
+                       (unsigned)listenSocket);
+        UA_close(listenSocket);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+#endif
+
     /* Set the socket non-blocking */
     if(UA_EventLoopPOSIX_setNonBlocking(listenSocket) != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
@@ -497,9 +762,12 @@ TCP_registerListenSocket(UA_POSIXConnectionManager *pcm, struct addrinfo *ai,
     }
 
     newConn->rfd.fd = listenSocket;
+    TAILQ_INIT(&newConn->sendQueue);
+    UA_LOCK_INIT(&newConn->sendLock);
     newConn->rfd.listenEvents = UA_FDEVENT_IN;
     newConn->rfd.es = &pcm->cm.eventSource;
     newConn->rfd.eventSourceCB = (UA_FDCallback)TCP_listenSocketCallback;
+    newConn->rfd.reactor = reactor;
     newConn->applicationCB = connectionCallback;
     newConn->application = application;
     newConn->context = context;
@@ -510,15 +778,14 @@ TCP_registerListenSocket(UA_POSIXConnectionManager *pcm, struct addrinfo *ai,
         UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                        "TCP %u\t| Error registering the socket",
                        (unsigned)listenSocket);
-        UA_free(newConn);
+        TCP_freeConnection(newConn);
         UA_EventLoopPOSIX_setReusable(listenSocket); /* Ensure reuse is possible */
         UA_close(listenSocket);
         return res;
     }
 
     /* Register internally */
-    ZIP_INSERT(UA_FDTree, &pcm->fds, &newConn->rfd);
-    pcm->fdsSize++;
+    TCP_addConnection((TCP_ConnectionManager*)pcm, newConn);
 
     /* Set up the callback parameters */
     UA_String listenAddress = UA_STRING((char*)(uintptr_t)hostname);
@@ -543,7 +810,8 @@ TCP_registerListenSockets(UA_POSIXConnectionManager *pcm, const char *hostname,
                           UA_UInt16 port, void *application, void *context,
                           UA_ConnectionManager_connectionCallback connectionCallback,
                           UA_Boolean validate, UA_Boolean reuseaddr) {
-    UA_LOCK_ASSERT(&((UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop)->elMutex);
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
 
     /* Create a string for the port */
     char portstr[6];
@@ -571,13 +839,22 @@ TCP_registerListenSockets(UA_POSIXConnectionManager *pcm, const char *hostname,
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+    /* Open one listen socket per reactor. A dynamic port (zero) cannot be
+     * shared, it is only opened for the EventLoop thread. */
+    size_t reactors = UA_EventLoopPOSIX_reactorsSize(el);
+    if(validate || port == 0)
+        reactors = 1;
+
     /* Add listen sockets. Aggregate the results to see if at least one
      * listen-socket was established. */
     UA_StatusCode total_result = UA_INT32_MAX;
     struct addrinfo *ai = res;
     while(ai) {
-        total_result &= TCP_registerListenSocket(pcm, ai, hostname, port, application, context,
-                                                 connectionCallback, validate, reuseaddr);
+        for(size_t r = 0; r < reactors; r++)
+            total_result &= TCP_registerListenSocket(pcm, ai, hostname, port,
+                                                     application, context,
+                                                     connectionCallback, validate,
+                                                     reuseaddr, r);
         ai = ai->ai_next;
     }
     UA_freeaddrinfo(res);
@@ -590,15 +867,20 @@ static void
 TCP_shutdown(UA_ConnectionManager *cm, TCP_FD *conn) {
     /* Already closing - nothing to do */
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
-    UA_LOCK_ASSERT(&el->elMutex);
-
+    UA_LOCK(&conn->sendLock);
     if(conn->rfd.dc.callback) {
         UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                      "TCP %u\t| Cannot close - already closing",
                      (unsigned)conn->rfd.fd);
+        UA_UNLOCK(&conn->sendLock);
         return;
     }
 
+    /* Last attempt to send out queued data (e.g. an ERR message) before the
+     * socket is shut down */
+    if(!TAILQ_EMPTY(&conn->sendQueue))
+        TCP_flushSendQueue(conn);
+
     /* Shutdown the socket to cancel the current select/epoll */
     UA_shutdown(conn->rfd.fd, UA_SHUT_RDWR);
 
@@ -612,9 +894,10 @@ TCP_shutdown(UA_ConnectionManager *cm, TCP_FD *conn) {
     dc->callback = TCP_delayedClose;
     dc->application = cm;
     dc->context = conn;
+    UA_UNLOCK(&conn->sendLock);
 
-    /* Adding a delayed callback does not take a lock */
-    UA_EventLoopPOSIX_addDelayedCallback((UA_EventLoop*)el, dc);
+    /* Closed in the thread of the reactor that polls the socket */
+    UA_EventLoopPOSIX_addDelayedFDCallback(el, &conn->rfd);
 }
 
 static UA_StatusCode
@@ -624,7 +907,10 @@ TCP_shutdownConnection(UA_ConnectionManager *cm, uintptr_t connectionId) {
     UA_LOCK(&el->elMutex);
 
     UA_FD fd = (UA_FD)connectionId;
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)pcm;
+    UA_LOCK(&tcm->fdsLock);
     TCP_FD *conn = (TCP_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
+    UA_UNLOCK(&tcm->fdsLock);
     if(!conn) {
         UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                        "TCP\t| Cannot close TCP connection %u - not found",
@@ -639,54 +925,127 @@ TCP_shutdownConnection(UA_ConnectionManager *cm, uintptr_t connectionId) {
     return UA_STATUSCODE_GOOD;
 }
 
+/* Append the (remaining) buffer to the send queue. Takes ownership of the
+ * buffer. */
+static UA_StatusCode
+TCP_enqueueSend(UA_POSIXConnectionManager *pcm, TCP_FD *conn,
+                UA_ByteString *buf, size_t offset) {
+    TCP_SendBuffer *sb = (TCP_SendBuffer*)UA_malloc(sizeof(TCP_SendBuffer));
+    if(!sb)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    if(buf->data == pcm->txBuffer.data) {
+        /* The static send buffer is reused right away. Copy the content. */
+        UA_StatusCode res =
+            UA_ByteString_allocBuffer(&sb->buf, buf->length - offset);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(sb);
+            return res;
+        }
+        memcpy(sb->buf.data, buf->data + offset, buf->length - offset);
+        UA_ByteString_init(buf);
+    } else {
+        sb->buf = *buf;
+        UA_ByteString_init(buf);
+        /* A partially sent buffer is only possible for an empty queue */
+        UA_assert(offset == 0 || TAILQ_EMPTY(&conn->sendQueue));
+        if(TAILQ_EMPTY(&conn->sendQueue))
+            conn->sendOffset = offset;
+    }
+
+    conn->sendQueueSize += sb->buf.length - offset;
+    TAILQ_INSERT_TAIL(&conn->sendQueue, sb, next);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Shut down the socket after sending has failed. The EventLoop then sees the
+ * hangup on the socket and closes the connection. This does not require the
+ * EventLoop lock. */
+static void
+TCP_abortSend(UA_EventLoopPOSIX *el, TCP_FD *conn) {
+    UA_LOCK_ASSERT(&conn->sendLock);
+    UA_shutdown(conn->rfd.fd, UA_SHUT_RDWR);
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "TCP %u\t| Shutdown after a failed send",
+                 (unsigned)conn->rfd.fd);
+}
+
+/* Sending does not take the EventLoop lock. Only the connection is locked. So
+ * sending from a thread that holds other locks (e.g. a worker thread holding
+ * the server lock) cannot wait on the EventLoop. */
 static UA_StatusCode
 TCP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
                        const UA_KeyValueMap *params, UA_ByteString *buf) {
-    /* We may not have a lock. But we need not take it. As the connectionId is
-     * the fd, no need to do a lookup and access internal data strucures. */
-
-    /* Prevent OS signals when sending to a closed socket */
-    int flags = MSG_NOSIGNAL;
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX *)cm->eventSource.eventLoop;
 
-    struct pollfd tmp_poll_fd;
-    tmp_poll_fd.fd = (UA_FD)connectionId;
-    tmp_poll_fd.events = UA_POLLOUT;
+    /* Look up the connection. Don't send on a connection that is closing. */
+    TCP_FD *conn = TCP_lockConnection(tcm, connectionId);
+    if(!conn || conn->rfd.dc.callback) {
+        if(conn)
+            UA_UNLOCK(&conn->sendLock);
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
 
-    /* Send the full buffer. This may require several calls to send */
+    /* Send right away if no earlier data is waiting. Stop when the socket
+     * would block. Prevent OS signals when sending to a closed socket. */
     size_t nWritten = 0;
-    do {
-        ssize_t n = 0;
-        do {
+    if(TAILQ_EMPTY(&conn->sendQueue) && (conn->rfd.listenEvents & UA_FDEVENT_IN)) {
+        while(nWritten < buf->length) {
             UA_RESET_ERRNO;
             UA_LOG_DEBUG(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
                          "TCP %u\t| Attempting to send", (unsigned)connectionId);
-            size_t bytes_to_send = buf->length - nWritten;
-            n = UA_send((UA_FD)connectionId,
-                        (const char*)buf->data + nWritten,
-                        bytes_to_send, flags);
+            ssize_t n = UA_send(conn->rfd.fd, (const char*)buf->data + nWritten,
+                                buf->length - nWritten, MSG_NOSIGNAL);
             if(n < 0) {
-                /* An error we cannot recover from? */
-                if(UA_ERRNO != UA_INTERRUPTED && UA_ERRNO != UA_WOULDBLOCK &&
-                   UA_ERRNO != UA_AGAIN)
-                    goto shutdown;
-
-                /* Poll for the socket resources to become available and retry
-                 * (blocking) */
-                int poll_ret;
-                do {
-                    UA_RESET_ERRNO;
-                    poll_ret = UA_poll(&tmp_poll_fd, 1, 100);
-                    if(poll_ret < 0 && UA_ERRNO != UA_INTERRUPTED)
-                        goto shutdown;
-                } while(poll_ret <= 0);
+                if(UA_ERRNO == UA_INTERRUPTED)
+                    continue;
+                if(UA_ERRNO == UA_WOULDBLOCK || UA_ERRNO == UA_AGAIN)
+                    break;
+                goto shutdown; /* An error we cannot recover from */
             }
-        } while(n < 0);
-        nWritten += (size_t)n;
-    } while(nWritten < buf->length);
+            nWritten += (size_t)n;
+        }
 
-    /* Clean up and return */
-    UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
-    return UA_STATUSCODE_GOOD;
+        /* Done */
+        if(nWritten == buf->length) {
+            UA_UNLOCK(&conn->sendLock);
+            UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+            return UA_STATUSCODE_GOOD;
+        }
+    }
+
+    /* Queue the remaining data. It is sent once the socket is writable. */
+    UA_StatusCode res = TCP_enqueueSend(&tcm->pcm, conn, buf, nWritten);
+    if(res != UA_STATUSCODE_GOOD)
+        goto shutdown;
+
+    /* A peer that does not receive fast enough accumulates outgoing data. Close
+     * the connection when the backlog limit is exceeded. */
+    UA_UInt32 backlog = TCP_DEFAULT_SEND_BACKLOG;
+    const UA_UInt32 *configBacklog = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 tcpManagerParams[TCP_MANAGERPARAMINDEX_BACKLOG].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(configBacklog)
+        backlog = *configBacklog;
+    if(backlog > 0 && conn->sendQueueSize > backlog) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP %u\t| The send backlog of %lu bytes exceeds the limit. "
+                       "Closing the connection.", (unsigned)connectionId,
+                       (unsigned long)conn->sendQueueSize);
+        TCP_abortSend(el, conn);
+        UA_UNLOCK(&conn->sendLock);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+
+    /* Send what can be sent now and listen for out-events for the rest */
+    res = TCP_flush(el, conn);
+    if(res != UA_STATUSCODE_GOOD)
+        TCP_abortSend(el, conn);
+    UA_UNLOCK(&conn->sendLock);
+    return (res == UA_STATUSCODE_GOOD) ? res : UA_STATUSCODE_BADCONNECTIONCLOSED;
 
  shutdown:
     /* Error -> shutdown the connection  */
@@ -694,7 +1053,8 @@ TCP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
        UA_LOG_ERROR(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
                     "TCP %u\t| Send failed with error %s",
                     (unsigned)connectionId, errno_str));
-    TCP_shutdownConnection(cm, connectionId);
+    TCP_abortSend(el, conn);
+    UA_UNLOCK(&conn->sendLock);
     UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
     return UA_STATUSCODE_BADCONNECTIONCLOSED;
 }
@@ -874,10 +1234,13 @@ TCP_openActiveConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *p
     }
 
     newConn->rfd.fd = newSock;
+    TAILQ_INIT(&newConn->sendQueue);
+    UA_LOCK_INIT(&newConn->sendLock);
     newConn->rfd.es = &pcm->cm.eventSource;
     newConn->rfd.eventSourceCB = (UA_FDCallback)TCP_connectionSocketCallback;
     newConn->rfd.listenEvents = UA_FDEVENT_OUT; /* Switched to _IN once the
                                                  * connection is open */
+    newConn->rfd.reactor = UA_EventLoopPOSIX_nextReactor(el);
     newConn->applicationCB = connectionCallback;
     newConn->application = application;
     newConn->context = context;
@@ -888,13 +1251,12 @@ TCP_openActiveConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *p
         UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                        "TCP\t| Registering the socket to connect to %s failed", hostname);
         UA_close(newSock);
-        UA_free(newConn);
+        TCP_freeConnection(newConn);
         return res;
     }
 
     /* Register internally in the EventSource */
-    ZIP_INSERT(UA_FDTree, &pcm->fds, &newConn->rfd);
-    pcm->fdsSize++;
+    TCP_addConnection((TCP_ConnectionManager*)pcm, newConn);
 
     UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                 "TCP %u\t| Opening a connection to \"%s\" on port %s",
@@ -996,6 +1358,17 @@ TCP_eventSourceStart(UA_ConnectionManager *cm) {
     if(res != UA_STATUSCODE_GOOD)
         goto finish;
 
+#if UA_MULTITHREADING >= 100
+    /* Sending does not take the EventLoop lock. So concurrent senders cannot
+     * share the static send buffer. Allocate a buffer for every message. */
+    if(pcm->txBuffer.length > 0) {
+        UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                    "TCP\t| The send-bufsize parameter is ignored "
+                    "with multithreading");
+        UA_ByteString_clear(&pcm->txBuffer);
+    }
+#endif
+
     /* Set the EventSource to the started state */
     cm->eventSource.state = UA_EVENTSOURCESTATE_STARTED;
 
@@ -1013,7 +1386,8 @@ TCP_shutdownCB(void *application, UA_RegisteredFD *rfd) {
 
 static void
 TCP_eventSourceStop(UA_ConnectionManager *cm) {
-    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)cm;
+    UA_POSIXConnectionManager *pcm = &tcm->pcm;
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
     (void)el;
 
@@ -1022,11 +1396,12 @@ TCP_eventSourceStop(UA_ConnectionManager *cm) {
     UA_LOG_DEBUG(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
                  "TCP\t| Shutting down the ConnectionManager");
 
-    /* Prevent new connections to open */
+    /* Prevent new connections to open and shutdown all existing connection.
+     * The reactor threads check for the state after adding a connection. */
+    UA_LOCK(&tcm->fdsLock);
     cm->eventSource.state = UA_EVENTSOURCESTATE_STOPPING;
-
-    /* Shutdown all existing connection */
     ZIP_ITER(UA_FDTree, &pcm->fds, TCP_shutdownCB, cm);
+    UA_UNLOCK(&tcm->fdsLock);
 
     /* All sockets closed? Otherwise iterate some more. */
     TCP_checkStopped(pcm);
@@ -1047,6 +1422,7 @@ TCP_eventSourceDelete(UA_ConnectionManager *cm) {
     UA_ByteString_clear(&pcm->txBuffer);
     UA_KeyValueMap_clear(&cm->eventSource.params);
     UA_String_clear(&cm->eventSource.name);
+    UA_LOCK_DESTROY(&((TCP_ConnectionManager*)cm)->fdsLock);
     UA_free(cm);
 
     return UA_STATUSCODE_GOOD;
@@ -1056,10 +1432,13 @@ static const char *tcpName = "tcp";
 
 UA_ConnectionManager *
 UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName) {
-    UA_POSIXConnectionManager *cm = (UA_POSIXConnectionManager*)
-        UA_calloc(1, sizeof(UA_POSIXConnectionManager));
-    if(!cm)
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)
+        UA_calloc(1, sizeof(TCP_ConnectionManager));
+    if(!tcm)
         return NULL;
+    UA_LOCK_INIT(&tcm->fdsLock);
+
+    UA_POSIXConnectionManager *cm = &tcm->pcm;
 
     cm->cm.eventSource.eventSourceType = UA_EVENTSOURCETYPE_CONNECTIONMANAGER;
     UA_String_copy(&eventSourceName, &cm->cm.eventSource.name);
@@ -0,0 +1,1505 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "open62541/types.h"
+#include "eventloop_posix.h"
+
+#if defined(UA_ARCHITECTURE_POSIX) && defined(__linux__) && defined(__has_include)
+# if __has_include(<linux/io_uring.h>)
+#  define UA_HAVE_IO_URING
+# endif
+#endif
+
+#ifdef UA_HAVE_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/* The io_uring TCP ConnectionManager uses the io_uring interface of the Linux
+ * kernel directly (without liburing). The ring fd is registered in the POSIX
+ * EventLoop and signals when completions are available. So timers, the other
+ * EventSources and the locking of the EventLoop stay unchanged.
+ *
+ * - Listen sockets use a multishot accept. One submission accepts connections
+ *   until it is cancelled.
+ * - Connections use a multishot recv. The kernel selects a buffer from a ring
+ *   of provided buffers. The buffer is returned to the ring after the
+ *   application callback. This replaces the static rxBuffer.
+ * - Sending takes ownership of the buffer. It is queued and sent with sendmsg
+ *   once the previous send has completed.
+ * - Submissions are prepared in the submission queue and submitted together
+ *   after processing the completions or (for submissions from other callbacks)
+ *   in a delayed callback. This batches all submissions of an EventLoop
+ *   iteration into one syscall.
+ *
+ * All operations of a connection carry a pointer to the connection and the
+ * operation type in the user_data. The connection is freed (in a delayed
+ * callback) only once all of its operations have completed. */
+
+/* Configuration parameters */
+#define URING_MANAGERPARAMS 4
+#define URING_MANAGERPARAMINDEX_RECVBUFSIZE 0
+#define URING_MANAGERPARAMINDEX_RECVBUFS 1
+#define URING_MANAGERPARAMINDEX_BACKLOG 2
+#define URING_MANAGERPARAMINDEX_ENTRIES 3
+
+static UA_KeyValueRestriction uringManagerParams[URING_MANAGERPARAMS] = {
+    {{0, UA_STRING_STATIC("recv-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("recv-buffers")}, &UA_TYPES[UA_TYPES_UINT16], false, true, false},
+    {{0, UA_STRING_STATIC("send-backlog")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("ring-entries")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
+};
+
+#define URING_DEFAULT_RECVBUFSIZE (1u << 14) /* 16kB */
+#define URING_DEFAULT_RECVBUFS 64
+#define URING_DEFAULT_SEND_BACKLOG (1u << 24) /* 16MB */
+#define URING_DEFAULT_ENTRIES 256
+
+/* Maximum number of queued buffers that are sent with one operation */
+#define URING_MAXIOV 16
+
+/* Buffer group of the provided receive buffers */
+#define URING_BUFGROUP 0
+
+#define URING_PARAMETERSSIZE 4
+#define URING_PARAMINDEX_ADDR 0
+#define URING_PARAMINDEX_PORT 1
+#define URING_PARAMINDEX_LISTEN 2
+#define URING_PARAMINDEX_VALIDATE 3
+
+static UA_KeyValueRestriction uringConnectionParams[URING_PARAMETERSSIZE] = {
+    {{0, UA_STRING_STATIC("address")}, &UA_TYPES[UA_TYPES_STRING], false, true, true},
+    {{0, UA_STRING_STATIC("port")}, &UA_TYPES[UA_TYPES_UINT16], true, true, false},
+    {{0, UA_STRING_STATIC("listen")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
+    {{0, UA_STRING_STATIC("validate")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false}
+};
+
+/* Operation types encoded in the lower bits of the user_data */
+#define URING_OP_MASK 0x07
+#define URING_OP_RECV 1    /* Multishot recv (or accept for listen sockets) */
+#define URING_OP_CONNECT 2
+#define URING_OP_SEND 3
+#define URING_OP_CANCEL 4
+
+typedef struct URING_SendBuffer {
+    TAILQ_ENTRY(URING_SendBuffer) next;
+    UA_ByteString buf;
+} URING_SendBuffer;
+
+typedef struct {
+    UA_RegisteredFD rfd; /* Key in the tree of the ConnectionManager. The fd
+                          * itself is not registered in the EventLoop. */
+
+    UA_ConnectionManager_connectionCallback applicationCB;
+    void *application;
+    void *context;
+
+    UA_Boolean listen;
+    UA_Boolean established;
+    UA_Boolean closing;
+    UA_Boolean armed;   /* Multishot recv/accept is active */
+    UA_Boolean sending; /* Send operation in flight */
+    size_t pending;     /* Operations without a final completion */
+
+    /* Outgoing buffers. The first sendIovSize buffers are in flight. */
+    TAILQ_HEAD(, URING_SendBuffer) sendQueue;
+    size_t sendQueueSize; /* Number of bytes that are not yet sent */
+    size_t sendOffset;    /* Bytes of the first buffer that are already sent */
+    struct iovec sendIov[URING_MAXIOV];
+    struct msghdr sendMsg;
+
+    /* Remote address of an active connection while connecting */
+    struct sockaddr_storage remote;
+    socklen_t remoteSize;
+} URING_FD;
+
+typedef struct {
+    UA_POSIXConnectionManager pcm;
+
+    /* The ring fd is registered in the EventLoop */
+    UA_RegisteredFD ringRFD;
+
+    /* Submission queue */
+    void *sqRing;
+    size_t sqRingSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned *sqFlags;
+    unsigned sqMask;
+    unsigned sqEntries;
+    unsigned sqLocalTail; /* Prepared but not yet visible for the kernel */
+
+    /* Completion queue (in the same mapping as the submission queue) */
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe *cqes;
+
+    /* Ring of provided receive buffers. The tail is overlaid with the reserved
+     * field of the first entry. */
+    struct io_uring_buf *bufRing;
+    size_t bufRingSize;
+    UA_UInt16 *bufRingTail;
+    UA_UInt16 bufTail;
+    UA_UInt16 bufCount;
+    UA_UInt32 bufSize;
+    UA_Byte *bufs;
+
+    /* Submit the prepared operations at the end of the iteration */
+    UA_DelayedCallback submitDC;
+    UA_Boolean submitScheduled;
+} URING_ConnectionManager;
+
+static void
+URING_shutdown(URING_ConnectionManager *ucm, URING_FD *conn, UA_Boolean force);
+
+/*********************/
+/* Ring Manipulation */
+/*********************/
+
+static int
+URING_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+                        flags, NULL, 0);
+}
+
+static void
+URING_submit(URING_ConnectionManager *ucm) {
+    if(ucm->ringRFD.fd == UA_INVALID_FD)
+        return;
+    __atomic_store_n(ucm->sqTail, ucm->sqLocalTail, __ATOMIC_RELEASE);
+    unsigned toSubmit = ucm->sqLocalTail - __atomic_load_n(ucm->sqHead, __ATOMIC_ACQUIRE);
+    if(toSubmit == 0)
+        return;
+    int ret;
+    do {
+        ret = URING_enter(ucm->ringRFD.fd, toSubmit, 0, 0);
+    } while(ret < 0 && errno == EINTR);
+    /* EBUSY/EAGAIN: The completions have to be processed first. The remaining
+     * submissions are retried with the next submit. */
+    if(ret < 0 && errno != EBUSY && errno != EAGAIN) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+            UA_LOG_ERROR(ucm->pcm.cm.eventSource.eventLoop->logger,
+                         UA_LOGCATEGORY_NETWORK,
+                         "TCP-URING\t| Submitting to the ring failed (%s)",
+                         errno_str));
+    }
+}
+
+/* Get the next free submission entry. Submits the prepared entries if the
+ * queue is full. */
+static struct io_uring_sqe *
+URING_getSQE(URING_ConnectionManager *ucm) {
+    if(ucm->ringRFD.fd == UA_INVALID_FD)
+        return NULL;
+    unsigned head = __atomic_load_n(ucm->sqHead, __ATOMIC_ACQUIRE);
+    if(ucm->sqLocalTail - head >= ucm->sqEntries) {
+        URING_submit(ucm);
+        head = __atomic_load_n(ucm->sqHead, __ATOMIC_ACQUIRE);
+        if(ucm->sqLocalTail - head >= ucm->sqEntries)
+            return NULL;
+    }
+    struct io_uring_sqe *sqe = &ucm->sqes[ucm->sqLocalTail & ucm->sqMask];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    ucm->sqLocalTail++;
+    return sqe;
+}
+
+static void
+URING_delayedSubmit(void *application, void *context);
+
+/* Submit the prepared operations in a delayed callback. This is used when an
+ * operation is prepared outside of the completion processing. */
+static void
+URING_scheduleSubmit(URING_ConnectionManager *ucm) {
+    if(ucm->submitScheduled)
+        return;
+    ucm->submitScheduled = true;
+    ucm->submitDC.callback = URING_delayedSubmit;
+    ucm->submitDC.application = ucm;
+    ucm->submitDC.context = NULL;
+    UA_EventLoop *el = ucm->pcm.cm.eventSource.eventLoop;
+    el->addDelayedCallback(el, &ucm->submitDC);
+}
+
+static void
+URING_recycleBuffer(URING_ConnectionManager *ucm, UA_UInt16 bid) {
+    struct io_uring_buf *b = &ucm->bufRing[ucm->bufTail & (ucm->bufCount - 1)];
+    b->addr = (UA_UInt64)(uintptr_t)(ucm->bufs + ((size_t)bid * ucm->bufSize));
+    b->len = ucm->bufSize;
+    b->bid = bid;
+    ucm->bufTail++;
+    __atomic_store_n(ucm->bufRingTail, ucm->bufTail, __ATOMIC_RELEASE);
+}
+
+static void
+URING_teardown(URING_ConnectionManager *ucm) {
+    if(ucm->ringRFD.fd == UA_INVALID_FD)
+        return;
+    if(ucm->bufRing) {
+        struct io_uring_buf_reg reg;
+        memset(&reg, 0, sizeof(reg));
+        reg.bgid = URING_BUFGROUP;
+        syscall(__NR_io_uring_register, ucm->ringRFD.fd,
+                IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        munmap(ucm->bufRing, ucm->bufRingSize);
+        ucm->bufRing = NULL;
+    }
+    UA_free(ucm->bufs);
+    ucm->bufs = NULL;
+    if(ucm->sqes)
+        munmap(ucm->sqes, ucm->sqesSize);
+    if(ucm->sqRing)
+        munmap(ucm->sqRing, ucm->sqRingSize);
+    ucm->sqes = NULL;
+    ucm->sqRing = NULL;
+    UA_close(ucm->ringRFD.fd);
+    ucm->ringRFD.fd = UA_INVALID_FD;
+}
+
+static UA_StatusCode
+URING_setup(URING_ConnectionManager *ucm, UA_UInt32 entries,
+            UA_UInt16 bufCount, UA_UInt32 bufSize) {
+    const UA_Logger *logger = ucm->pcm.cm.eventSource.eventLoop->logger;
+
+    /* Create the ring */
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CLAMP;
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if(fd < 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+            UA_LOG_ERROR(logger, UA_LOGCATEGORY_NETWORK,
+                         "TCP-URING\t| io_uring is not available (%s)", errno_str));
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+    ucm->ringRFD.fd = fd;
+    if(!(p.features & IORING_FEAT_SINGLE_MMAP) ||
+       !(p.features & IORING_FEAT_NODROP)) {
+        UA_LOG_ERROR(logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP-URING\t| The kernel does not support the required "
+                     "io_uring features");
+        URING_teardown(ucm);
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+
+    /* Map the submission and completion queue (a single mapping) */
+    size_t sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cqSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ucm->sqRingSize = (sqSize > cqSize) ? sqSize : cqSize;
+    void *ring = mmap(NULL, ucm->sqRingSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if(ring == MAP_FAILED) {
+        URING_teardown(ucm);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    ucm->sqRing = ring;
+    ucm->sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(NULL, ucm->sqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if(sqes == MAP_FAILED) {
+        URING_teardown(ucm);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    ucm->sqes = (struct io_uring_sqe*)sqes;
+
+    UA_Byte *r = (UA_Byte*)ring;
+    ucm->sqHead = (unsigned*)(r + p.sq_off.head);
+    ucm->sqTail = (unsigned*)(r + p.sq_off.tail);
+    ucm->sqFlags = (unsigned*)(r + p.sq_off.flags);
+    ucm->sqMask = *(unsigned*)(r + p.sq_off.ring_mask);
+    ucm->sqEntries = p.sq_entries;
+    ucm->sqLocalTail = *ucm->sqTail;
+    ucm->cqHead = (unsigned*)(r + p.cq_off.head);
+    ucm->cqTail = (unsigned*)(r + p.cq_off.tail);
+    ucm->cqMask = *(unsigned*)(r + p.cq_off.ring_mask);
+    ucm->cqes = (struct io_uring_cqe*)(r + p.cq_off.cqes);
+
+    /* The submission entries are used in order */
+    unsigned *sqArray = (unsigned*)(r + p.sq_off.array);
+    for(unsigned i = 0; i < p.sq_entries; i++)
+        sqArray[i] = i;
+
+    /* Register the ring of provided receive buffers */
+    ucm->bufCount = bufCount;
+    ucm->bufSize = bufSize;
+    ucm->bufTail = 0;
+    ucm->bufRingSize = bufCount * sizeof(struct io_uring_buf);
+    void *bufRing = mmap(NULL, ucm->bufRingSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ucm->bufs = (UA_Byte*)UA_malloc((size_t)bufCount * bufSize);
+    if(bufRing == MAP_FAILED || !ucm->bufs) {
+        if(bufRing != MAP_FAILED)
+            munmap(bufRing, ucm->bufRingSize);
+        URING_teardown(ucm);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (UA_UInt64)(uintptr_t)bufRing;
+    reg.ring_entries = bufCount;
+    reg.bgid = URING_BUFGROUP;
+    if(syscall(__NR_io_uring_register, fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+            UA_LOG_ERROR(logger, UA_LOGCATEGORY_NETWORK,
+                         "TCP-URING\t| Could not register the receive buffers (%s)",
+                         errno_str));
+        munmap(bufRing, ucm->bufRingSize);
+        URING_teardown(ucm);
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+    ucm->bufRing = (struct io_uring_buf*)bufRing;
+    ucm->bufRingTail = &ucm->bufRing[0].resv;
+    for(UA_UInt16 i = 0; i < bufCount; i++)
+        URING_recycleBuffer(ucm, i);
+
+    return UA_STATUSCODE_GOOD;
+}
+
+/*****************************/
+/* Operations on Connections */
+/*****************************/
+
+static UA_UInt64
+URING_userData(URING_FD *conn, UA_UInt64 op) {
+    return (UA_UInt64)(uintptr_t)conn | op;
+}
+
+/* Multishot accept for listen sockets and multishot recv for connections */
+static UA_StatusCode
+URING_arm(URING_ConnectionManager *ucm, URING_FD *conn) {
+    struct io_uring_sqe *sqe = URING_getSQE(ucm);
+    if(!sqe)
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    sqe->fd = conn->rfd.fd;
+    if(conn->listen) {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+    } else {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = URING_BUFGROUP;
+    }
+    sqe->user_data = URING_userData(conn, URING_OP_RECV);
+    conn->armed = true;
+    conn->pending++;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Send the queued buffers (up to URING_MAXIOV) if no send is in flight */
+static UA_StatusCode
+URING_flush(URING_ConnectionManager *ucm, URING_FD *conn) {
+    if(!conn->established || conn->sending || TAILQ_EMPTY(&conn->sendQueue))
+        return UA_STATUSCODE_GOOD;
+    struct io_uring_sqe *sqe = URING_getSQE(ucm);
+    if(!sqe)
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+
+    size_t iovSize = 0;
+    size_t offset = conn->sendOffset;
+    URING_SendBuffer *sb = TAILQ_FIRST(&conn->sendQueue);
+    for(; sb && iovSize < URING_MAXIOV; sb = TAILQ_NEXT(sb, next)) {
+        conn->sendIov[iovSize].iov_base = sb->buf.data + offset;
+        conn->sendIov[iovSize].iov_len = sb->buf.length - offset;
+        iovSize++;
+        offset = 0;
+    }
+    memset(&conn->sendMsg, 0, sizeof(struct msghdr));
+    conn->sendMsg.msg_iov = conn->sendIov;
+    conn->sendMsg.msg_iovlen = iovSize;
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = conn->rfd.fd;
+    sqe->addr = (UA_UInt64)(uintptr_t)&conn->sendMsg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = URING_userData(conn, URING_OP_SEND);
+    conn->sending = true;
+    conn->pending++;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Remove the buffers that were sent completely */
+static void
+URING_consumeSent(URING_FD *conn, size_t written) {
+    conn->sendQueueSize -= written;
+    while(written > 0) {
+        URING_SendBuffer *sb = TAILQ_FIRST(&conn->sendQueue);
+        size_t remaining = sb->buf.length - conn->sendOffset;
+        if(written < remaining) {
+            conn->sendOffset += written;
+            break;
+        }
+        written -= remaining;
+        conn->sendOffset = 0;
+        TAILQ_REMOVE(&conn->sendQueue, sb, next);
+        UA_ByteString_clear(&sb->buf);
+        UA_free(sb);
+    }
+}
+
+static void
+URING_clearSendQueue(URING_FD *conn) {
+    URING_SendBuffer *sb, *sb_tmp;
+    TAILQ_FOREACH_SAFE(sb, &conn->sendQueue, next, sb_tmp) {
+        TAILQ_REMOVE(&conn->sendQueue, sb, next);
+        UA_ByteString_clear(&sb->buf);
+        UA_free(sb);
+    }
+    conn->sendQueueSize = 0;
+    conn->sendOffset = 0;
+}
+
+/* Test if the ConnectionManager can be stopped */
+static void
+URING_checkStopped(URING_ConnectionManager *ucm) {
+    UA_ConnectionManager *cm = &ucm->pcm.cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    if(ucm->pcm.fdsSize > 0 || ucm->submitScheduled ||
+       cm->eventSource.state != UA_EVENTSOURCESTATE_STOPPING)
+        return;
+
+    /* All operations have completed. Remove the ring. */
+    UA_EventLoopPOSIX_deregisterFD(el, &ucm->ringRFD);
+    URING_teardown(ucm);
+
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "TCP-URING\t| All sockets closed, the EventLoop has stopped");
+    cm->eventSource.state = UA_EVENTSOURCESTATE_STOPPED;
+}
+
+static void
+URING_delayedSubmit(void *application, void *context) {
+    URING_ConnectionManager *ucm = (URING_ConnectionManager*)application;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)ucm->pcm.cm.eventSource.eventLoop;
+    UA_LOCK(&el->elMutex);
+    ucm->submitScheduled = false;
+    URING_submit(ucm);
+    URING_checkStopped(ucm);
+    UA_UNLOCK(&el->elMutex);
+}
+
+static void
+URING_delayedClose(void *application, void *context) {
+    URING_ConnectionManager *ucm = (URING_ConnectionManager*)application;
+    UA_ConnectionManager *cm = &ucm->pcm.cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    URING_FD *conn = (URING_FD*)context;
+
+    UA_LOCK(&el->elMutex);
+
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                 "TCP-URING %u\t| Delayed closing of the connection",
+                 (unsigned)conn->rfd.fd);
+
+    /* Ensure reuse is possible right away */
+    UA_EventLoopPOSIX_setReusable(conn->rfd.fd);
+
+    /* Deregister internally */
+    ZIP_REMOVE(UA_FDTree, &ucm->pcm.fds, &conn->rfd);
+    UA_assert(ucm->pcm.fdsSize > 0);
+    ucm->pcm.fdsSize--;
+
+    /* Signal closing to the application */
+    conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
+                        conn->application, &conn->context,
+                        UA_CONNECTIONSTATE_CLOSING,
+                        &UA_KEYVALUEMAP_NULL, UA_BYTESTRING_NULL);
+
+    /* Close the socket */
+    UA_RESET_ERRNO;
+    int ret = UA_close(conn->rfd.fd);
+    if(ret == 0) {
+        UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                    "TCP-URING %u\t| Socket closed", (unsigned)conn->rfd.fd);
+    } else {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                          "TCP-URING %u\t| Could not close the socket (%s)",
+                          (unsigned)conn->rfd.fd, errno_str));
+    }
+
+    URING_clearSendQueue(conn);
+    UA_free(conn);
+
+    /* Check if this was the last connection for a closing ConnectionManager */
+    URING_checkStopped(ucm);
+
+    UA_UNLOCK(&el->elMutex);
+}
+
+/* An operation of the connection has completed for good. Free the closing
+ * connection once nothing is in flight anymore. */
+static void
+URING_release(URING_ConnectionManager *ucm, URING_FD *conn) {
+    UA_assert(conn->pending > 0);
+    conn->pending--;
+    if(!conn->closing || conn->pending > 0 || conn->rfd.dc.callback)
+        return;
+    UA_DelayedCallback *dc = &conn->rfd.dc;
+    dc->callback = URING_delayedClose;
+    dc->application = ucm;
+    dc->context = conn;
+    UA_EventLoop *el = ucm->pcm.cm.eventSource.eventLoop;
+    el->addDelayedCallback(el, dc);
+}
+
+/* Shut down the socket and cancel all operations in flight */
+static void
+URING_closeSocket(URING_ConnectionManager *ucm, URING_FD *conn) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)ucm->pcm.cm.eventSource.eventLoop;
+
+    /* Last attempt to send out queued data (e.g. an ERR message) before the
+     * socket is shut down */
+    if(conn->established && !conn->sending && !TAILQ_EMPTY(&conn->sendQueue)) {
+        struct iovec iov[URING_MAXIOV];
+        size_t iovSize = 0;
+        size_t offset = conn->sendOffset;
+        URING_SendBuffer *sb = TAILQ_FIRST(&conn->sendQueue);
+        for(; sb && iovSize < URING_MAXIOV; sb = TAILQ_NEXT(sb, next)) {
+            iov[iovSize].iov_base = sb->buf.data + offset;
+            iov[iovSize].iov_len = sb->buf.length - offset;
+            iovSize++;
+            offset = 0;
+        }
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(struct msghdr));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovSize;
+        sendmsg(conn->rfd.fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    }
+
+    /* Shutdown the socket. This completes the receive operation. */
+    UA_shutdown(conn->rfd.fd, UA_SHUT_RDWR);
+
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "TCP-URING %u\t| Shutdown triggered", (unsigned)conn->rfd.fd);
+
+    /* Cancel the remaining operations (e.g. accept and connect) */
+    if(conn->pending > 0) {
+        struct io_uring_sqe *sqe = URING_getSQE(ucm);
+        if(sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = conn->rfd.fd;
+            sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+            sqe->user_data = URING_userData(conn, URING_OP_CANCEL);
+            conn->pending++;
+            URING_scheduleSubmit(ucm);
+        }
+        return;
+    }
+
+    /* Nothing in flight. Close right away (delayed). */
+    conn->pending++;
+    URING_release(ucm, conn);
+}
+
+/* Close the connection. The connection is freed once all operations have
+ * completed. Without force, a send in flight is completed first. */
+static void
+URING_shutdown(URING_ConnectionManager *ucm, URING_FD *conn, UA_Boolean force) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)ucm->pcm.cm.eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    if(conn->closing) {
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP-URING %u\t| Cannot close - already closing",
+                     (unsigned)conn->rfd.fd);
+        if(force && conn->sending)
+            URING_closeSocket(ucm, conn);
+        return;
+    }
+    conn->closing = true;
+
+    /* Wait for the send in flight. The socket is shut down after it
+     * completes. */
+    if(conn->sending && !force)
+        return;
+
+    URING_closeSocket(ucm, conn);
+}
+
+/***********************/
+/* Completion Handling */
+/***********************/
+
+/* Do not merge packets on the socket (disable Nagle's algorithm) */
+static UA_StatusCode
+URING_setNoNagle(UA_FD sockfd) {
+    int val = 1;
+    int res = UA_setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &val, sizeof(val));
+    if(res < 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+URING_accepted(URING_ConnectionManager *ucm, URING_FD *listenConn, UA_FD newsockfd) {
+    UA_ConnectionManager *cm = &ucm->pcm.cm;
+    const UA_Logger *logger = cm->eventSource.eventLoop->logger;
+
+    /* Log the name of the remote host. The multishot accept does not return
+     * the remote address. */
+    struct sockaddr_storage remote;
+    socklen_t remote_size = sizeof(remote);
+    char hoststr[UA_MAXHOSTNAME_LENGTH];
+    hoststr[0] = 0;
+    if(getpeername(newsockfd, (struct sockaddr*)&remote, &remote_size) != 0 ||
+       UA_getnameinfo((struct sockaddr*)&remote, remote_size, hoststr,
+                      sizeof(hoststr), NULL, 0, NI_NUMERICHOST) != 0) {
+        UA_LOG_WARNING(logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP-URING %u\t| Could not resolve the remote address",
+                       (unsigned)newsockfd);
+    }
+    UA_LOG_INFO(logger, UA_LOGCATEGORY_NETWORK,
+                "TCP-URING %u\t| Connection opened from \"%s\" via the server socket %u",
+                (unsigned)newsockfd, hoststr, (unsigned)listenConn->rfd.fd);
+
+    /* Allocate the connection. TCP_NODELAY is inherited from the listen
+     * socket. */
+    URING_FD *newConn = (URING_FD*)UA_calloc(1, sizeof(URING_FD));
+    if(!newConn) {
+        UA_LOG_WARNING(logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP-URING %u\t| Error allocating memory for the socket",
+                       (unsigned)newsockfd);
+        UA_close(newsockfd);
+        return;
+    }
+    newConn->rfd.fd = newsockfd;
+    newConn->rfd.es = &cm->eventSource;
+    newConn->established = true;
+    TAILQ_INIT(&newConn->sendQueue);
+    newConn->applicationCB = listenConn->applicationCB;
+    newConn->application = listenConn->application;
+    newConn->context = listenConn->context;
+
+    /* Start receiving */
+    if(URING_arm(ucm, newConn) != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP-URING %u\t| Error starting to receive on the socket",
+                       (unsigned)newsockfd);
+        UA_free(newConn);
+        UA_close(newsockfd);
+        return;
+    }
+
+    /* Register internally in the EventSource */
+    ZIP_INSERT(UA_FDTree, &ucm->pcm.fds, &newConn->rfd);
+    ucm->pcm.fdsSize++;
+
+    /* Forward the remote hostname to the application */
+    UA_KeyValuePair kvp;
+    kvp.key = UA_QUALIFIEDNAME(0, "remote-address");
+    UA_String hostName = UA_STRING(hoststr);
+    UA_Variant_setScalar(&kvp.value, &hostName, &UA_TYPES[UA_TYPES_STRING]);
+    UA_KeyValueMap kvm = {1, &kvp};
+
+    /* The socket has opened. Signal it to the application. */
+    newConn->applicationCB(cm, (uintptr_t)newsockfd,
+                           newConn->application, &newConn->context,
+                           UA_CONNECTIONSTATE_ESTABLISHED,
+                           &kvm, UA_BYTESTRING_NULL);
+}
+
+static void
+URING_processAccept(URING_ConnectionManager *ucm, URING_FD *conn,
+                    const struct io_uring_cqe *cqe) {
+    const UA_Logger *logger = ucm->pcm.cm.eventSource.eventLoop->logger;
+    UA_Boolean more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+    if(!more)
+        conn->armed = false;
+
+    if(cqe->res >= 0) {
+        if(conn->closing)
+            UA_close(cqe->res);
+        else
+            URING_accepted(ucm, conn, cqe->res);
+    } else if(!conn->closing && cqe->res != -ECANCELED &&
+              !UA_IS_TEMPORARY_ACCEPT_ERROR(-cqe->res)) {
+        UA_LOG_WARNING(logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP-URING %u\t| Error %i, closing the server socket",
+                       (unsigned)conn->rfd.fd, -cqe->res);
+        URING_shutdown(ucm, conn, true);
+    }
+
+    /* Re-arm the multishot accept */
+    if(!more && !conn->closing && URING_arm(ucm, conn) != UA_STATUSCODE_GOOD)
+        URING_shutdown(ucm, conn, true);
+    if(!more)
+        URING_release(ucm, conn);
+}
+
+static void
+URING_processRecv(URING_ConnectionManager *ucm, URING_FD *conn,
+                  const struct io_uring_cqe *cqe) {
+    UA_ConnectionManager *cm = &ucm->pcm.cm;
+    const UA_Logger *logger = cm->eventSource.eventLoop->logger;
+    UA_Boolean more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+    if(!more)
+        conn->armed = false;
+
+    if(cqe->res > 0) {
+        /* Callback to the application layer with the provided buffer. Then
+         * return the buffer to the ring. */
+        UA_assert(cqe->flags & IORING_CQE_F_BUFFER);
+        UA_UInt16 bid = (UA_UInt16)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        if(!conn->closing) {
+            UA_LOG_DEBUG(logger, UA_LOGCATEGORY_NETWORK,
+                         "TCP-URING %u\t| Received message of size %u",
+                         (unsigned)conn->rfd.fd, (unsigned)cqe->res);
+            UA_ByteString msg;
+            msg.data = ucm->bufs + ((size_t)bid * ucm->bufSize);
+            msg.length = (size_t)cqe->res;
+            conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
+                                conn->application, &conn->context,
+                                UA_CONNECTIONSTATE_ESTABLISHED,
+                                &UA_KEYVALUEMAP_NULL, msg);
+        }
+        URING_recycleBuffer(ucm, bid);
+    } else if(cqe->res == 0) {
+        /* Orderly shutdown of the socket */
+        UA_LOG_DEBUG(logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP-URING %u\t| recv signaled the socket was shutdown",
+                     (unsigned)conn->rfd.fd);
+        URING_shutdown(ucm, conn, true);
+    } else if(cqe->res != -ENOBUFS) {
+        /* No buffers available is temporary. Everything else closes. */
+        if(!conn->closing && cqe->res != -ECANCELED) {
+            UA_LOG_INFO(logger, UA_LOGCATEGORY_NETWORK,
+                        "TCP-URING %u\t| The connection closes with error %i",
+                        (unsigned)conn->rfd.fd, -cqe->res);
+        }
+        URING_shutdown(ucm, conn, true);
+    }
+
+    /* Re-arm the multishot recv */
+    if(!more && !conn->closing && URING_arm(ucm, conn) != UA_STATUSCODE_GOOD)
+        URING_shutdown(ucm, conn, true);
+    if(!more)
+        URING_release(ucm, conn);
+}
+
+static void
+URING_processConnect(URING_ConnectionManager *ucm, URING_FD *conn,
+                     const struct io_uring_cqe *cqe) {
+    UA_ConnectionManager *cm = &ucm->pcm.cm;
+    const UA_Logger *logger = cm->eventSource.eventLoop->logger;
+
+    if(!conn->closing) {
+        if(cqe->res < 0) {
+            UA_LOG_INFO(logger, UA_LOGCATEGORY_NETWORK,
+                        "TCP-URING %u\t| The connection closes with error %i",
+                        (unsigned)conn->rfd.fd, -cqe->res);
+            URING_shutdown(ucm, conn, true);
+        } else {
+            UA_LOG_DEBUG(logger, UA_LOGCATEGORY_NETWORK,
+                         "TCP-URING %u\t| Opening a new connection",
+                         (unsigned)conn->rfd.fd);
+            conn->established = true;
+            if(URING_arm(ucm, conn) != UA_STATUSCODE_GOOD ||
+               URING_flush(ucm, conn) != UA_STATUSCODE_GOOD) {
+                URING_shutdown(ucm, conn, true);
+            } else {
+                /* A new socket has opened. Signal it to the application. */
+                conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
+                                    conn->application, &conn->context,
+                                    UA_CONNECTIONSTATE_ESTABLISHED,
+                                    &UA_KEYVALUEMAP_NULL, UA_BYTESTRING_NULL);
+            }
+        }
+    }
+    URING_release(ucm, conn);
+}
+
+static void
+URING_processSend(URING_ConnectionManager *ucm, URING_FD *conn,
+                  const struct io_uring_cqe *cqe) {
+    conn->sending = false;
+    if(cqe->res >= 0)
+        URING_consumeSent(conn, (size_t)cqe->res);
+
+    if(conn->closing) {
+        /* The socket was not shut down yet to complete the send */
+        if(cqe->res >= 0 && !conn->rfd.dc.callback)
+            URING_closeSocket(ucm, conn);
+    } else if(cqe->res < 0) {
+        UA_LOG_ERROR(ucm->pcm.cm.eventSource.eventLoop->logger,
+                     UA_LOGCATEGORY_NETWORK,
+                     "TCP-URING %u\t| Send failed with error %i",
+                     (unsigned)conn->rfd.fd, -cqe->res);
+        URING_shutdown(ucm, conn, true);
+    } else if(URING_flush(ucm, conn) != UA_STATUSCODE_GOOD) {
+        URING_shutdown(ucm, conn, true);
+    }
+    URING_release(ucm, conn);
+}
+
+/* Gets called when completions are available on the ring */
+static void
+URING_ringCallback(UA_ConnectionManager *cm, UA_RegisteredFD *rfd, short event) {
+    URING_ConnectionManager *ucm = (URING_ConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    while(true) {
+        unsigned head = *ucm->cqHead;
+        unsigned tail = __atomic_load_n(ucm->cqTail, __ATOMIC_ACQUIRE);
+        if(head == tail) {
+            /* Completions that did not fit into the queue are flushed with the
+             * next enter */
+            if(!(__atomic_load_n(ucm->sqFlags, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW))
+                break;
+            URING_enter(ucm->ringRFD.fd, 0, 0, IORING_ENTER_GETEVENTS);
+            if(head == __atomic_load_n(ucm->cqTail, __ATOMIC_ACQUIRE))
+                break;
+            continue;
+        }
+
+        /* Copy the entry and free the slot before processing */
+        struct io_uring_cqe cqe = ucm->cqes[head & ucm->cqMask];
+        __atomic_store_n(ucm->cqHead, head + 1, __ATOMIC_RELEASE);
+
+        URING_FD *conn = (URING_FD*)(uintptr_t)(cqe.user_data & ~(UA_UInt64)URING_OP_MASK);
+        switch(cqe.user_data & URING_OP_MASK) {
+        case URING_OP_RECV:
+            if(conn->listen)
+                URING_processAccept(ucm, conn, &cqe);
+            else
+                URING_processRecv(ucm, conn, &cqe);
+            break;
+        case URING_OP_CONNECT:
+            URING_processConnect(ucm, conn, &cqe);
+            break;
+        case URING_OP_SEND:
+            URING_processSend(ucm, conn, &cqe);
+            break;
+        case URING_OP_CANCEL:
+            URING_release(ucm, conn);
+            break;
+        default:
+            break;
+        }
+    }
+
+    /* Submit everything that was prepared while processing the completions */
+    URING_submit(ucm);
+}
+
+/***************************/
+/* ConnectionManager API   */
+/***************************/
+
+static UA_StatusCode
+URING_registerListenSocket(URING_ConnectionManager *ucm, struct addrinfo *ai,
+                           const char *hostname, UA_UInt16 port,
+                           void *application, void *context,
+                           UA_ConnectionManager_connectionCallback connectionCallback,
+                           UA_Boolean validate) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)ucm->pcm.cm.eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    /* Create the server socket */
+    UA_RESET_ERRNO;
+    UA_FD listenSocket = UA_socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+                                   ai->ai_protocol);
+    if(listenSocket == UA_INVALID_FD) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                          "TCP-URING\t| Error opening the listen socket on "
+                          "port %u (%s)", port, errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Use AF_INET6 sockets only for IPv6. Allow rebinding to the
+     * IP/port combination. Eg. to restart the server. */
+    int optval = 1;
+    if((ai->ai_family == AF_INET6 &&
+        UA_setsockopt(listenSocket, IPPROTO_IPV6, IPV6_V6ONLY,
+                      (const char*)&optval, sizeof(optval)) == -1) ||
+       UA_EventLoopPOSIX_setReusable(listenSocket) != UA_STATUSCODE_GOOD ||
+       URING_setNoNagle(listenSocket) != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP-URING %u\t| Could not set the socket options",
+                       (unsigned)listenSocket);
+        UA_close(listenSocket);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Bind socket to address */
+    UA_RESET_ERRNO;
+    if(UA_bind(listenSocket, ai->ai_addr, (socklen_t)ai->ai_addrlen) < 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                          "TCP-URING %u\t| Error binding the socket to port %u (%s)",
+                          (unsigned)listenSocket, port, errno_str));
+        UA_close(listenSocket);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Get the port being used if dynamic porting was used */
+    if(port == 0) {
+        struct sockaddr_storage sin;
+        socklen_t len = sizeof(sin);
+        UA_getsockname(listenSocket, (struct sockaddr*)&sin, &len);
+        port = (sin.ss_family == AF_INET6) ?
+            ntohs(((struct sockaddr_in6*)&sin)->sin6_port) :
+            ntohs(((struct sockaddr_in*)&sin)->sin_port);
+    }
+
+    /* Only validate, don't actually start listening */
+    if(validate) {
+        UA_close(listenSocket);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Start listening */
+    UA_RESET_ERRNO;
+    if(UA_listen(listenSocket, UA_MAXBACKLOG) < 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                          "TCP-URING %u\t| Error listening on the socket (%s)",
+                          (unsigned)listenSocket, errno_str));
+        UA_close(listenSocket);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Allocate the connection */
+    URING_FD *newConn = (URING_FD*)UA_calloc(1, sizeof(URING_FD));
+    if(!newConn) {
+        UA_close(listenSocket);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    newConn->rfd.fd = listenSocket;
+    newConn->rfd.es = &ucm->pcm.cm.eventSource;
+    newConn->listen = true;
+    TAILQ_INIT(&newConn->sendQueue);
+    newConn->applicationCB = connectionCallback;
+    newConn->application = application;
+    newConn->context = context;
+
+    /* Start accepting connections */
+    UA_StatusCode res = URING_arm(ucm, newConn);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(newConn);
+        UA_close(listenSocket);
+        return res;
+    }
+    URING_scheduleSubmit(ucm);
+
+    /* Register internally */
+    ZIP_INSERT(UA_FDTree, &ucm->pcm.fds, &newConn->rfd);
+    ucm->pcm.fdsSize++;
+
+    /* If the INADDR_ANY is used, use the local hostname */
+    char hoststr[UA_MAXHOSTNAME_LENGTH];
+    if(!hostname) {
+        UA_gethostname(hoststr, UA_MAXHOSTNAME_LENGTH);
+        hostname = hoststr;
+    }
+    UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                "TCP-URING %u\t| Creating listen socket for \"%s\" on port %u",
+                (unsigned)listenSocket, hostname, port);
+
+    /* Announce the listen-socket in the application */
+    UA_String listenAddress = UA_STRING((char*)(uintptr_t)hostname);
+    UA_KeyValuePair params[2];
+    params[0].key = UA_QUALIFIEDNAME(0, "listen-address");
+    UA_Variant_setScalar(&params[0].value, &listenAddress, &UA_TYPES[UA_TYPES_STRING]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen-port");
+    UA_Variant_setScalar(&params[1].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_KeyValueMap paramMap = {2, params};
+    connectionCallback(&ucm->pcm.cm, (uintptr_t)listenSocket,
+                       application, &newConn->context,
+                       UA_CONNECTIONSTATE_ESTABLISHED,
+                       &paramMap, UA_BYTESTRING_NULL);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+URING_registerListenSockets(URING_ConnectionManager *ucm, const char *hostname,
+                            UA_UInt16 port, void *application, void *context,
+                            UA_ConnectionManager_connectionCallback connectionCallback,
+                            UA_Boolean validate) {
+    char portstr[6];
+    mp_snprintf(portstr, sizeof(portstr), "%d", port);
+
+    /* Get all the interface and IPv4/6 combinations for the configured hostname */
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof hints);
+#if UA_IPV6
+    hints.ai_family = AF_UNSPEC; /* Allow IPv4 and IPv6 */
+#else
+    hints.ai_family = AF_INET;   /* IPv4 only */
+#endif
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = AI_PASSIVE;
+    if(UA_getaddrinfo(hostname, portstr, &hints, &res) != 0) {
+        UA_LOG_WARNING(ucm->pcm.cm.eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP-URING\t| Lookup for \"%s\" on port %u failed",
+                       hostname, port);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Succeed if at least one listen socket was established */
+    UA_StatusCode total_result = UA_INT32_MAX;
+    for(struct addrinfo *ai = res; ai; ai = ai->ai_next)
+        total_result &= URING_registerListenSocket(ucm, ai, hostname, port,
+                                                   application, context,
+                                                   connectionCallback, validate);
+    UA_freeaddrinfo(res);
+    return total_result;
+}
+
+static UA_StatusCode
+URING_openPassiveConnection(URING_ConnectionManager *ucm, const UA_KeyValueMap *params,
+                            void *application, void *context,
+                            UA_ConnectionManager_connectionCallback connectionCallback,
+                            UA_Boolean validate) {
+    const UA_UInt16 *port = (const UA_UInt16*)
+        UA_KeyValueMap_getScalar(params, uringConnectionParams[URING_PARAMINDEX_PORT].name,
+                                 &UA_TYPES[UA_TYPES_UINT16]);
+    UA_assert(port); /* existence is checked before */
+
+    const UA_Variant *addrs =
+        UA_KeyValueMap_get(params, uringConnectionParams[URING_PARAMINDEX_ADDR].name);
+    size_t addrsSize = 0;
+    if(addrs)
+        addrsSize = (UA_Variant_isScalar(addrs)) ? 1 : addrs->arrayLength;
+
+    /* Undefined or empty addresses array -> listen on all interfaces */
+    if(addrsSize == 0)
+        return URING_registerListenSockets(ucm, NULL, *port, application,
+                                           context, connectionCallback, validate);
+
+    /* Iterate over the configured hostnames */
+    UA_String *hostStrings = (UA_String*)addrs->data;
+    UA_StatusCode retval = UA_STATUSCODE_BADINTERNALERROR;
+    for(size_t i = 0; i < addrsSize; i++) {
+        char hostname[UA_MAXHOSTNAME_LENGTH];
+        if(hostStrings[i].length >= sizeof(hostname))
+            continue;
+        memcpy(hostname, hostStrings[i].data, hostStrings[i].length);
+        hostname[hostStrings[i].length] = '\0';
+        if(URING_registerListenSockets(ucm, hostname, *port, application, context,
+                                       connectionCallback, validate) == UA_STATUSCODE_GOOD)
+            retval = UA_STATUSCODE_GOOD;
+    }
+    return retval;
+}
+
+static UA_StatusCode
+URING_openActiveConnection(URING_ConnectionManager *ucm, const UA_KeyValueMap *params,
+                           void *application, void *context,
+                           UA_ConnectionManager_connectionCallback connectionCallback,
+                           UA_Boolean validate) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)ucm->pcm.cm.eventSource.eventLoop;
+
+    /* Prepare the port parameter as a string */
+    char portStr[UA_MAXPORTSTR_LENGTH];
+    const UA_UInt16 *port = (const UA_UInt16*)
+        UA_KeyValueMap_getScalar(params, uringConnectionParams[URING_PARAMINDEX_PORT].name,
+                                 &UA_TYPES[UA_TYPES_UINT16]);
+    UA_assert(port); /* existence is checked before */
+    mp_snprintf(portStr, UA_MAXPORTSTR_LENGTH, "%d", *port);
+
+    /* Prepare the hostname string */
+    char hostname[UA_MAXHOSTNAME_LENGTH];
+    const UA_String *addr = (const UA_String*)
+        UA_KeyValueMap_getScalar(params, uringConnectionParams[URING_PARAMINDEX_ADDR].name,
+                                 &UA_TYPES[UA_TYPES_STRING]);
+    if(!addr || addr->length >= UA_MAXHOSTNAME_LENGTH) {
+        UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP-URING\t| Open TCP Connection: No valid hostname defined");
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    memcpy(hostname, addr->data, addr->length);
+    hostname[addr->length] = 0;
+
+    /* Resolve the address */
+    struct addrinfo hints, *info;
+    memset(&hints, 0, sizeof(struct addrinfo));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if(UA_getaddrinfo(hostname, portStr, &hints, &info) != 0) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP-URING\t| Lookup of %s failed", hostname);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Create the socket. It remains blocking, io_uring waits for readiness
+     * internally. */
+    UA_FD newSock = UA_socket(info->ai_family, info->ai_socktype | SOCK_CLOEXEC,
+                              info->ai_protocol);
+    if(newSock == UA_INVALID_FD || URING_setNoNagle(newSock) != UA_STATUSCODE_GOOD ||
+       info->ai_addrlen > sizeof(struct sockaddr_storage)) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP-URING\t| Could not create socket to connect to %s",
+                       hostname);
+        if(newSock != UA_INVALID_FD)
+            UA_close(newSock);
+        UA_freeaddrinfo(info);
+        return UA_STATUSCODE_BADDISCONNECT;
+    }
+
+    /* Only validate, don't actually open the connection */
+    if(validate) {
+        UA_freeaddrinfo(info);
+        UA_close(newSock);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    URING_FD *newConn = (URING_FD*)UA_calloc(1, sizeof(URING_FD));
+    if(!newConn) {
+        UA_freeaddrinfo(info);
+        UA_close(newSock);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    newConn->rfd.fd = newSock;
+    newConn->rfd.es = &ucm->pcm.cm.eventSource;
+    TAILQ_INIT(&newConn->sendQueue);
+    newConn->applicationCB = connectionCallback;
+    newConn->application = application;
+    newConn->context = context;
+    memcpy(&newConn->remote, info->ai_addr, info->ai_addrlen);
+    newConn->remoteSize = (socklen_t)info->ai_addrlen;
+    UA_freeaddrinfo(info);
+
+    /* Asynchronous connect. The address remains in the connection until the
+     * operation has completed. */
+    struct io_uring_sqe *sqe = URING_getSQE(ucm);
+    if(!sqe) {
+        UA_free(newConn);
+        UA_close(newSock);
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    }
+    sqe->opcode = IORING_OP_CONNECT;
+    sqe->fd = newSock;
+    sqe->addr = (UA_UInt64)(uintptr_t)&newConn->remote;
+    sqe->off = newConn->remoteSize;
+    sqe->user_data = URING_userData(newConn, URING_OP_CONNECT);
+    newConn->pending++;
+    URING_scheduleSubmit(ucm);
+
+    /* Register internally in the EventSource */
+    ZIP_INSERT(UA_FDTree, &ucm->pcm.fds, &newConn->rfd);
+    ucm->pcm.fdsSize++;
+
+    UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                "TCP-URING %u\t| Opening a connection to \"%s\" on port %s",
+                (unsigned)newSock, hostname, portStr);
+
+    /* Signal the new connection to the application as asynchonously opening */
+    connectionCallback(&ucm->pcm.cm, (uintptr_t)newSock,
+                       application, &newConn->context,
+                       UA_CONNECTIONSTATE_OPENING, &UA_KEYVALUEMAP_NULL,
+                       UA_BYTESTRING_NULL);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+URING_openConnection(UA_ConnectionManager *cm, const UA_KeyValueMap *params,
+                     void *application, void *context,
+                     UA_ConnectionManager_connectionCallback connectionCallback) {
+    URING_ConnectionManager *ucm = (URING_ConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK(&el->elMutex);
+
+    if(cm->eventSource.state != UA_EVENTSOURCESTATE_STARTED) {
+        UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP-URING\t| Cannot open a connection for a "
+                     "ConnectionManager that is not started");
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Check the parameters */
+    UA_StatusCode res =
+        UA_KeyValueRestriction_validate(el->eventLoop.logger, "TCP-URING",
+                                        uringConnectionParams,
+                                        URING_PARAMETERSSIZE, params);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&el->elMutex);
+        return res;
+    }
+
+    UA_Boolean validate = false;
+    const UA_Boolean *validateParam = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params,
+                                 uringConnectionParams[URING_PARAMINDEX_VALIDATE].name,
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(validateParam)
+        validate = *validateParam;
+
+    UA_Boolean listen = false;
+    const UA_Boolean *listenParam = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params,
+                                 uringConnectionParams[URING_PARAMINDEX_LISTEN].name,
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(listenParam)
+        listen = *listenParam;
+
+    if(listen) {
+        res = URING_openPassiveConnection(ucm, params, application, context,
+                                          connectionCallback, validate);
+    } else {
+        res = URING_openActiveConnection(ucm, params, application, context,
+                                         connectionCallback, validate);
+    }
+
+    UA_UNLOCK(&el->elMutex);
+    return res;
+}
+
+static UA_StatusCode
+URING_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
+                         const UA_KeyValueMap *params, UA_ByteString *buf) {
+    URING_ConnectionManager *ucm = (URING_ConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK(&el->elMutex);
+
+    /* Look up the connection. Don't send on a connection that is closing. */
+    UA_FD fd = (UA_FD)connectionId;
+    URING_FD *conn = (URING_FD*)ZIP_FIND(UA_FDTree, &ucm->pcm.fds, &fd);
+    if(!conn || conn->closing || conn->listen) {
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+
+    /* Take ownership of the buffer. The network buffers are always allocated
+     * on the heap for this ConnectionManager (no static send buffer). */
+    URING_SendBuffer *sb = (URING_SendBuffer*)UA_malloc(sizeof(URING_SendBuffer));
+    if(!sb) {
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+        URING_shutdown(ucm, conn, true);
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+    sb->buf = *buf;
+    UA_ByteString_init(buf);
+    conn->sendQueueSize += sb->buf.length;
+    TAILQ_INSERT_TAIL(&conn->sendQueue, sb, next);
+
+    /* A peer that does not receive fast enough accumulates outgoing data. Close
+     * the connection when the backlog limit is exceeded. */
+    UA_UInt32 backlog = URING_DEFAULT_SEND_BACKLOG;
+    const UA_UInt32 *configBacklog = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 uringManagerParams[URING_MANAGERPARAMINDEX_BACKLOG].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(configBacklog)
+        backlog = *configBacklog;
+    if(backlog > 0 && conn->sendQueueSize > backlog) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP-URING %u\t| The send backlog of %lu bytes exceeds the "
+                       "limit. Closing the connection.", (unsigned)connectionId,
+                       (unsigned long)conn->sendQueueSize);
+        URING_shutdown(ucm, conn, true);
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+
+    /* Prepare the send operation. Submitted at the end of the iteration. */
+    UA_StatusCode res = URING_flush(ucm, conn);
+    if(res != UA_STATUSCODE_GOOD) {
+        URING_shutdown(ucm, conn, true);
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+    if(conn->sending)
+        URING_scheduleSubmit(ucm);
+
+    UA_UNLOCK(&el->elMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+URING_shutdownConnection(UA_ConnectionManager *cm, uintptr_t connectionId) {
+    URING_ConnectionManager *ucm = (URING_ConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK(&el->elMutex);
+
+    UA_FD fd = (UA_FD)connectionId;
+    URING_FD *conn = (URING_FD*)ZIP_FIND(UA_FDTree, &ucm->pcm.fds, &fd);
+    if(!conn) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP-URING\t| Cannot close TCP connection %u - not found",
+                       (unsigned)connectionId);
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADNOTFOUND;
+    }
+
+    URING_shutdown(ucm, conn, false);
+
+    UA_UNLOCK(&el->elMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+URING_eventSourceStart(UA_ConnectionManager *cm) {
+    URING_ConnectionManager *ucm = (URING_ConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    if(!el)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_LOCK(&el->elMutex);
+
+    /* Check the state */
+    if(cm->eventSource.state != UA_EVENTSOURCESTATE_STOPPED) {
+        UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP-URING\t| To start the ConnectionManager, it has to be "
+                     "registered in an EventLoop and not started yet");
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Check the parameters */
+    UA_StatusCode res =
+        UA_KeyValueRestriction_validate(el->eventLoop.logger, "TCP-URING",
+                                        uringManagerParams, URING_MANAGERPARAMS,
+                                        &cm->eventSource.params);
+    if(res != UA_STATUSCODE_GOOD)
+        goto finish;
+
+    UA_UInt32 bufSize = URING_DEFAULT_RECVBUFSIZE;
+    const UA_UInt32 *bufSizeParam = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 uringManagerParams[URING_MANAGERPARAMINDEX_RECVBUFSIZE].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(bufSizeParam)
+        bufSize = *bufSizeParam;
+
+    /* The number of buffers in the ring has to be a power of two */
+    UA_UInt16 bufCount = URING_DEFAULT_RECVBUFS;
+    const UA_UInt16 *bufCountParam = (const UA_UInt16*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 uringManagerParams[URING_MANAGERPARAMINDEX_RECVBUFS].name,
+                                 &UA_TYPES[UA_TYPES_UINT16]);
+    if(bufCountParam)
+        bufCount = *bufCountParam;
+
+    UA_UInt32 entries = URING_DEFAULT_ENTRIES;
+    const UA_UInt32 *entriesParam = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 uringManagerParams[URING_MANAGERPARAMINDEX_ENTRIES].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(entriesParam)
+        entries = *entriesParam;
+
+    if(bufSize == 0 || bufCount == 0 || (bufCount & (bufCount - 1)) != 0 ||
+       bufCount > (1u << 15) || entries == 0) {
+        UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP-URING\t| Invalid configuration of the receive buffers "
+                     "or the ring size");
+        res = UA_STATUSCODE_BADCONFIGURATIONERROR;
+        goto finish;
+    }
+
+    /* Create the ring and register it in the EventLoop */
+    res = URING_setup(ucm, entries, bufCount, bufSize);
+    if(res != UA_STATUSCODE_GOOD)
+        goto finish;
+    ucm->ringRFD.es = &cm->eventSource;
+    ucm->ringRFD.listenEvents = UA_FDEVENT_IN;
+    ucm->ringRFD.eventSourceCB = (UA_FDCallback)URING_ringCallback;
+    ucm->ringRFD.reactor = 0;
+    res = UA_EventLoopPOSIX_registerFD(el, &ucm->ringRFD);
+    if(res != UA_STATUSCODE_GOOD) {
+        URING_teardown(ucm);
+        goto finish;
+    }
+
+    /* Set the EventSource to the started state */
+    cm->eventSource.state = UA_EVENTSOURCESTATE_STARTED;
+
+ finish:
+    UA_UNLOCK(&el->elMutex);
+    return res;
+}
+
+static void *
+URING_shutdownCB(void *application, UA_RegisteredFD *rfd) {
+    URING_shutdown((URING_ConnectionManager*)application, (URING_FD*)rfd, true);
+    return NULL;
+}
+
+static void
+URING_eventSourceStop(UA_ConnectionManager *cm) {
+    URING_ConnectionManager *ucm = (URING_ConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK(&el->elMutex);
+
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "TCP-URING\t| Shutting down the ConnectionManager");
+
+    /* Prevent new connections to open */
+    cm->eventSource.state = UA_EVENTSOURCESTATE_STOPPING;
+
+    /* Shutdown all existing connection */
+    ZIP_ITER(UA_FDTree, &ucm->pcm.fds, URING_shutdownCB, ucm);
+
+    /* All sockets closed? Otherwise iterate some more. */
+    URING_checkStopped(ucm);
+
+    UA_UNLOCK(&el->elMutex);
+}
+
+static UA_StatusCode
+URING_eventSourceDelete(UA_ConnectionManager *cm) {
+    if(cm->eventSource.state >= UA_EVENTSOURCESTATE_STARTING) {
+        UA_LOG_ERROR(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_EVENTLOOP,
+                     "TCP-URING\t| The EventSource must be stopped before it "
+                     "can be deleted");
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    UA_KeyValueMap_clear(&cm->eventSource.params);
+    UA_String_clear(&cm->eventSource.name);
+    UA_free(cm);
+    return UA_STATUSCODE_GOOD;
+}
+
+static const char *tcpName = "tcp";
+
+UA_ConnectionManager *
+UA_ConnectionManager_new_POSIX_TCP_IOURING(const UA_String eventSourceName) {
+    URING_ConnectionManager *ucm = (URING_ConnectionManager*)
+        UA_calloc(1, sizeof(URING_ConnectionManager));
+    if(!ucm)
+        return NULL;
+
+    UA_ConnectionManager *cm = &ucm->pcm.cm;
+    ucm->ringRFD.fd = UA_INVALID_FD;
+    cm->eventSource.eventSourceType = UA_EVENTSOURCETYPE_CONNECTIONMANAGER;
+    UA_String_copy(&eventSourceName, &cm->eventSource.name);
+    cm->eventSource.start = (UA_StatusCode (*)(UA_EventSource *))URING_eventSourceStart;
+    cm->eventSource.stop = (void (*)(UA_EventSource *))URING_eventSourceStop;
+    cm->eventSource.free = (UA_StatusCode (*)(UA_EventSource *))URING_eventSourceDelete;
+    cm->protocol = UA_STRING((char*)(uintptr_t)tcpName);
+    cm->openConnection = URING_openConnection;
+    cm->allocNetworkBuffer = UA_EventLoopPOSIX_allocNetworkBuffer;
+    cm->freeNetworkBuffer = UA_EventLoopPOSIX_freeNetworkBuffer;
+    cm->sendWithConnection = URING_sendWithConnection;
+    cm->closeConnection = URING_shutdownConnection;
+    return cm;
+}
+
+#elif defined(UA_ARCHITECTURE_POSIX) && defined(__linux__)
+
+/* The kernel headers for io_uring are not available */
+UA_ConnectionManager *
+UA_ConnectionManager_new_POSIX_TCP_IOURING(const UA_String eventSourceName) {
+    return NULL;
+}
+
+#endif /* UA_HAVE_IO_URING */
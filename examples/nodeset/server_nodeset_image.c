@@ -0,0 +1,133 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information. */
+
+/* Starting a server from a prebuilt address-space image
+ * ------------------------------------------------------
+ * Called with ``--generate <file>``, the example loads ns0 and the example
+ * nodeset into a server and writes the content of its Nodestore into an image
+ * file. This is done by the build after the nodeset was generated. Called with
+ * ``<file>``, the server is started with an Image Nodestore. The nodes are then
+ * decoded from the image when they are first accessed. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/plugin/nodestore_default.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "open62541/namespace_example_generated.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXAMPLE_NAMESPACE "http://yourorganisation.org/test/"
+
+UA_Boolean running = true;
+
+static void stopHandler(int sign) {
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "received ctrl-c");
+    running = false;
+}
+
+static UA_StatusCode
+generateImage(const char *path) {
+    UA_Server *server = UA_Server_new();
+    UA_StatusCode retval = namespace_example_generated(server);
+    UA_ByteString image = UA_BYTESTRING_NULL;
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = UA_Nodestore_saveImage(&UA_Server_getConfig(server)->nodestore,
+                                        &image);
+    UA_Server_delete(server);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER,
+                     "Could not create the image: %s", UA_StatusCode_name(retval));
+        return retval;
+    }
+
+    FILE *f = fopen(path, "wb");
+    if(!f || fwrite(image.data, 1, image.length, f) != image.length)
+        retval = UA_STATUSCODE_BADINTERNALERROR;
+    if(f)
+        fclose(f);
+    if(retval == UA_STATUSCODE_GOOD)
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER,
+                    "Wrote an image of %lu bytes to %s",
+                    (unsigned long)image.length, path);
+    else
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER,
+                     "Could not write the image to %s", path);
+    UA_ByteString_clear(&image);
+    return retval;
+}
+
+static UA_StatusCode
+loadImage(const char *path, UA_ByteString *image) {
+    FILE *f = fopen(path, "rb");
+    if(!f)
+        return UA_STATUSCODE_BADNOTFOUND;
+    UA_StatusCode retval = UA_STATUSCODE_BADINTERNALERROR;
+    long size = -1;
+    if(fseek(f, 0, SEEK_END) == 0)
+        size = ftell(f);
+    if(size > 0 && fseek(f, 0, SEEK_SET) == 0) {
+        retval = UA_ByteString_allocBuffer(image, (size_t)size);
+        if(retval == UA_STATUSCODE_GOOD &&
+           fread(image->data, 1, image->length, f) != image->length) {
+            UA_ByteString_clear(image);
+            retval = UA_STATUSCODE_BADINTERNALERROR;
+        }
+    }
+    fclose(f);
+    return retval;
+}
+
+int main(int argc, char** argv) {
+    if(argc == 3 && strcmp(argv[1], "--generate") == 0)
+        return generateImage(argv[2]) == UA_STATUSCODE_GOOD ?
+            EXIT_SUCCESS : EXIT_FAILURE;
+
+    if(argc != 2) {
+        printf("Usage: %s [--generate] <image-file>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    signal(SIGINT, stopHandler);
+    signal(SIGTERM, stopHandler);
+
+    /* The image memory has to outlive the server */
+    UA_ByteString image = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = loadImage(argv[1], &image);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER,
+                     "Could not read the image file %s", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    retval = UA_Nodestore_Image(&config.nodestore, &image, NULL);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER,
+                     "Invalid image: %s", UA_StatusCode_name(retval));
+        UA_ByteString_clear(&image);
+        return EXIT_FAILURE;
+    }
+    UA_ServerConfig_setDefault(&config);
+    UA_Server *server = UA_Server_newWithConfig(&config);
+    if(!server) {
+        UA_ByteString_clear(&image);
+        return EXIT_FAILURE;
+    }
+
+    /* The namespace array is not part of the image. Register the namespace of
+     * the example nodeset with the same index as during the generation. */
+    UA_UInt16 nsIdx = UA_Server_addNamespace(server, EXAMPLE_NAMESPACE);
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER,
+                "The example nodeset from the image uses ns=%d", nsIdx);
+
+    retval = UA_Server_run(server, &running);
+    UA_Server_delete(server);
+    UA_ByteString_clear(&image);
+    return retval == UA_STATUSCODE_GOOD ? EXIT_SUCCESS : EXIT_FAILURE;
+}
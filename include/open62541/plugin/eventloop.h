@@ -470,7 +470,21 @@ struct UA_InterruptManager {
  *   well. But expect accordingly longer sleep-times for timed events when the
  *   clock is set to the past. See the man-page of "clock_gettime" on how to get
  *   a clock source id for a character-device such as /dev/ptp0. (default:
- *   CLOCK_MONOTONIC_RAW) */
+ *   CLOCK_MONOTONIC_RAW)
+ *
+ * **Reactor threads (Linux with multithreading only)**
+ *
+ * 0:reactor-threads [uint16]
+ *   Number of additional threads that poll sockets with their own epoll set
+ *   (default: 0). The TCP ConnectionManager opens a listen socket per reactor
+ *   with SO_REUSEPORT so that the kernel distributes the incoming connections.
+ *   Outgoing connections are assigned round-robin. A connection stays with its
+ *   reactor until it is closed. The reactor threads dispatch the events
+ *   without the EventLoop lock. So the connection callbacks of the
+ *   ConnectionManager can execute in parallel for connections of different
+ *   reactors. Applications that need to serialize with the EventLoop take its
+ *   lock within the callback. Timers and delayed callbacks registered at the
+ *   EventLoop are processed in the thread that runs the EventLoop. */
 
 UA_EXPORT UA_EventLoop *
 UA_EventLoop_new_POSIX(const UA_Logger *logger);
@@ -501,7 +515,14 @@ UA_EventLoop_new_POSIX(const UA_Logger *logger);
  * 0:send-bufsize [uint32]
  *    Size of the statically allocated buffer for sending messages. This then
  *    becomes an upper bound for the message size. If undefined a fresh buffer
- *    is allocated for every `allocNetworkBuffer` (default: no buffer).
+ *    is allocated for every `allocNetworkBuffer` (default: no buffer). Ignored
+ *    with multithreading, as sending can then happen concurrently.
+ *
+ * 0:send-backlog [uint32]
+ *    Sending does not block the EventLoop. Data that cannot be written to the
+ *    socket right away is queued for the connection. If the queued data
+ *    exceeds this number of bytes, then the connection is closed. Zero
+ *    disables the limit (default 16MB).
  *
  * **Open Connection Parameters:**
  *
@@ -699,6 +720,44 @@ UA_ConnectionManager_new_POSIX_UDP(const UA_String eventSourceName);
  *    Drop message if it cannot be sent in time (default: true). */
 UA_EXPORT UA_ConnectionManager *
 UA_ConnectionManager_new_POSIX_Ethernet(const UA_String eventSourceName);
+
+/**
+ * io_uring TCP Connection Manager
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Alternative to the TCP ConnectionManager based on the io_uring interface of
+ * the Linux kernel (at least version 6.0). It is registered in the POSIX
+ * EventLoop like the TCP ConnectionManager and uses the same protocol name
+ * ("tcp"), the same open connection parameters and callback parameters. So it
+ * can replace the TCP ConnectionManager without further changes.
+ *
+ * Listen sockets accept with a single multishot operation. Connections receive
+ * with a multishot operation into a ring of buffers provided to the kernel.
+ * All operations prepared within an EventLoop iteration are submitted with a
+ * single syscall. This reduces the number of syscalls per request
+ * considerably when many connections are active.
+ *
+ * Returns NULL if io_uring is not available at compile time. Starting the
+ * ConnectionManager fails if the kernel does not support the required
+ * features.
+ *
+ * **Configuration parameters for the ConnectionManager (set before start)**
+ *
+ * 0:recv-bufsize [uint32]
+ *    Size of each receive buffer in the ring (default 16kB).
+ *
+ * 0:recv-buffers [uint16]
+ *    Number of receive buffers in the ring. Must be a power of two
+ *    (default 64).
+ *
+ * 0:send-backlog [uint32]
+ *    If the queued outgoing data of a connection exceeds this number of
+ *    bytes, then the connection is closed. Zero disables the limit
+ *    (default 16MB).
+ *
+ * 0:ring-entries [uint32]
+ *    Size of the submission queue (default 256). */
+UA_EXPORT UA_ConnectionManager *
+UA_ConnectionManager_new_POSIX_TCP_IOURING(const UA_String eventSourceName);
 #endif
 
 /**
@@ -302,6 +302,16 @@ UA_NodePointer_toExpandedNodeId(UA_NodePointer np);
 UA_NodeId UA_EXPORT
 UA_NodePointer_toNodeId(UA_NodePointer np);
 
+/* Create a NodePointer that points directly to the node. The NodePointer is
+ * only valid while a reference to the node is held, that is, before the node
+ * is released to the Nodestore. */
+UA_NodePointer UA_EXPORT
+UA_NodePointer_fromNode(const UA_NodeHead *node);
+
+/* Returns the node if the NodePointer points directly to it. Otherwise NULL. */
+UA_EXPORT const UA_NodeHead *
+UA_NodePointer_getNode(UA_NodePointer np);
+
 /**
  * Base Node Attributes
  * --------------------
@@ -414,6 +424,9 @@ struct UA_NodeHead {
     /* Members specific to open62541 */
     void *context;
     UA_Boolean constructed; /* Constructors were called */
+    UA_Boolean synthesized; /* Created by the server for a single access and
+                             * not stored in the Nodestore. Deleted with
+                             * deleteNode when it is released. */
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     UA_MonitoredItem *monitoredItems; /* MonitoredItems for Events and immediate
                                        * DataChanges (no sampling interval). */
@@ -785,7 +798,9 @@ typedef struct {
                                UA_BrowseDirection referenceDirections);
 
     /* Similar to the normal ``getNode``. But it can take advantage of the
-     * NodePointer structure, e.g. if it contains a direct pointer. */
+     * NodePointer structure, e.g. if it contains a direct pointer. A direct
+     * pointer to a node that was since replaced or removed is resolved via its
+     * NodeId. */
     const UA_Node * (*getNodeFromPtr)(void *nsCtx, UA_NodePointer ptr,
                                       UA_UInt32 attributeMask,
                                       UA_ReferenceTypeSet references,
@@ -852,6 +867,12 @@ typedef struct {
     /* Execute a callback for every node in the nodestore. */
     void (*iterate)(void *nsCtx, UA_NodestoreVisitor visitor,
                     void *visitorCtx);
+
+    /* Set if ``getNode``, ``getNodeFromPtr`` and ``releaseNode`` can be called
+     * from several threads concurrently, also while another thread edits the
+     * nodes. Then the server can execute Read requests without holding the
+     * server lock. */
+    UA_Boolean concurrentReads;
 } UA_Nodestore;
 
 /* Attributes must be of a matching type (VariableAttributes, ObjectAttributes,
@@ -203,6 +203,29 @@ typedef struct {
     size_t secureChannelNonceLength;
 
     UA_SecurityPolicyCryptoModule cryptoModule;
+
+    /* Optional single-pass authenticated encryption (AEAD, e.g. AES-GCM or
+     * ChaCha20-Poly1305). If defined, SignAndEncrypt chunks are not padded and
+     * not signed and encrypted in two separate passes. Instead the
+     * authentication tag is computed during the encryption and takes the
+     * place of the signature. The tag length is the signature size of the
+     * cryptoModule. The encryptionAlgorithm block size is then only used as
+     * the IV length for the key derivation.
+     *
+     * @param channelContext the channelContext with the keys
+     * @param aad the unencrypted headers of the chunk. They are authenticated
+     *            but not encrypted.
+     * @param data the data that is en-/decrypted in place
+     * @param tag the authentication tag */
+    UA_StatusCode (*encryptAuthenticated)(void *channelContext,
+                                          const UA_ByteString *aad,
+                                          UA_ByteString *data, UA_ByteString *tag)
+    UA_FUNC_ATTR_WARN_UNUSED_RESULT;
+
+    UA_StatusCode (*decryptAuthenticated)(void *channelContext,
+                                          const UA_ByteString *aad,
+                                          UA_ByteString *data, const UA_ByteString *tag)
+    UA_FUNC_ATTR_WARN_UNUSED_RESULT;
 } UA_SecurityPolicySymmetricModule;
 
 typedef struct {
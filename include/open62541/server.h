@@ -224,6 +224,7 @@ struct UA_ServerConfig {
     /* Limits for Sessions */
     UA_UInt16 maxSessions;
     UA_Double maxSessionTimeout; /* in ms */
+    UA_UInt32 maxRegisteredNodesPerSession; /* 0 -> unlimited */
 
     /* Operation limits */
     UA_UInt32 maxNodesPerRead;
@@ -252,6 +253,51 @@ struct UA_ServerConfig {
     size_t maxAsyncOperationQueueSize; /* 0 => unlimited */
     /* Notify workers when an async operation was enqueued */
     UA_Server_AsyncOperationNotifyCallback asyncOperationNotifyCallback;
+
+    /* Number of internal threads that decode requests and encode responses
+     * outside of the EventLoop thread. The services are executed one at a time
+     * under the server lock (see concurrentReadServices for the exception).
+     * The responses of a SecureChannel are sent in the order of the requests.
+     * Supported on POSIX only.
+     * 0 => disabled, everything runs in the EventLoop thread (default) */
+    size_t serviceWorkers;
+
+    /* Execute Read and Browse requests in the service workers concurrently.
+     * They take the server lock in shared mode. That excludes the other
+     * services and the EventLoop from changing the server state, but not other
+     * Read and Browse requests. Requires serviceWorkers > 0 and a Nodestore
+     * with concurrentReads (UA_Nodestore_HashMapConcurrent). Otherwise the
+     * option has no effect.
+     *
+     * Attention: When enabled, the following access control callbacks are
+     * called concurrently from several threads and must be thread-safe:
+     * getUserRightsMask, getUserAccessLevel, getUserExecutable and
+     * allowBrowseNode. The same holds for custom Nodestore plugins (which
+     * declare the concurrentReads support). Value callbacks (onRead),
+     * DataSources and external value backends are still called under the
+     * exclusive lock. So are all other user callbacks.
+     * false => disabled (default) */
+    UA_Boolean concurrentReadServices;
+
+    /* Read and Call requests with at least this many operations are split
+     * into chunks that the service workers execute in parallel. The results
+     * keep the order of the request. Every chunk still takes the server lock.
+     * With concurrentReadServices, the chunks of a Read request take the lock
+     * in shared mode and run concurrently. DataSource read callbacks and
+     * method callbacks are called without holding the exclusive lock, so slow
+     * callbacks run concurrently. If the parallel execution is not possible
+     * (e.g. a request is executed from a user callback that holds the server
+     * lock), the operations are executed sequentially.
+     *
+     * Attention: When enabled, the DataSource read and method callbacks are
+     * called concurrently from several threads. Also the same callback for
+     * different operations of a single request. The callbacks must be
+     * thread-safe. They can use the server API, which takes the server lock
+     * internally.
+     *
+     * Requires serviceWorkers > 0. The per-operation timings are logged on the
+     * debug level. 0 => disabled (default) */
+    size_t parallelOperationsThreshold;
 #endif
 
     /* Discovery
@@ -1526,7 +1572,19 @@ UA_Server_deleteReference(UA_Server *server, const UA_NodeId sourceNodeId,
  * needed. ``deleteEventNode`` specifies whether the node representation of the
  * event should be deleted after invoking the method. This can be useful if
  * events with the similar attributes are triggered frequently. ``UA_TRUE``
- * would cause the node to be deleted. */
+ * would cause the node to be deleted.
+ *
+ * Creating and deleting the node representation (including the instantiation
+ * of all children of the EventType) is expensive. The method
+ * ``UA_Server_triggerEventFields`` triggers an event without materializing it
+ * in the information model. The event fields are given in a flat map keyed by
+ * their browse path (relative to the event). Fields nested deeper than one
+ * level use a single key whose name contains the path elements separated by
+ * ``/`` (e.g. ``0:EnabledState/Id``), all in the namespace of the key. The
+ * EventFilters of the MonitoredItems read the values directly from the map.
+ * Only the Value attribute of the fields can be selected. The standard fields
+ * `EventId`, `EventType`, `SourceNode` and `ReceiveTime` are set by the
+ * server. */
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
 
@@ -1555,6 +1613,21 @@ UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
                        const UA_NodeId originId, UA_ByteString *outEventId,
                        const UA_Boolean deleteEventNode);
 
+/* Triggers an event that is represented as a map of fields (no node)
+ *
+ * @param server The server object
+ * @param eventType The type of the event. Must be a subtype of BaseEventType
+ * @param originId The node that emits the event
+ * @param eventFields The event fields keyed by their browse path. The map is
+ *        not modified and can be reused for the next event. Can be NULL.
+ * @param outEventId the EventId of the new event
+ * @return The StatusCode of the UA_Server_triggerEventFields method */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_triggerEventFields(UA_Server *server, const UA_NodeId eventType,
+                             const UA_NodeId originId,
+                             const UA_KeyValueMap *eventFields,
+                             UA_ByteString *outEventId);
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS_EVENTS */
 
 /**
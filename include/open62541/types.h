@@ -1442,6 +1442,12 @@ typedef struct {
      * memory is not freed if decoding fails afterwards. */
     void *callocContext;
     void * (*calloc)(void *callocContext, size_t nelem, size_t elsize);
+
+    /* Decoded Strings and ByteStrings point into the input buffer instead of
+     * being copied. This is only used together with the calloc override, as
+     * the decoded value must not be cleaned up with UA_clear. The input buffer
+     * needs to outlive the decoded value. */
+    UA_Boolean borrowStrings;
 } UA_DecodeBinaryOptions;
 
 /* Decodes a data structure from the input buffer in the binary format. It is
@@ -20,6 +20,7 @@
 #include <mbedtls/sha256.h>
 
 #include "securitypolicy_common.h"
+#include "../ua_certificategroup_cache.h"
 
 #define REMOTECERTIFICATETRUSTED 1
 #define ISSUERKNOWN              2
@@ -28,9 +29,11 @@
 
 /* Configuration parameters */
 
-#define MEMORYCERTSTORE_PARAMETERSSIZE 2
+#define MEMORYCERTSTORE_PARAMETERSSIZE 4
 #define MEMORYCERTSTORE_PARAMINDEX_MAXTRUSTLISTSIZE 0
 #define MEMORYCERTSTORE_PARAMINDEX_MAXREJECTEDLISTSIZE 1
+#define MEMORYCERTSTORE_PARAMINDEX_MAXVERIFICATIONCACHESIZE 2
+#define MEMORYCERTSTORE_PARAMINDEX_VERIFICATIONCACHETTL 3
 
 static const struct {
     UA_QualifiedName name;
@@ -38,7 +41,9 @@ static const struct {
     UA_Boolean required;
 } MemoryCertStoreParameters[MEMORYCERTSTORE_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("max-trust-listsize")}, &UA_TYPES[UA_TYPES_UINT16], false},
-    {{0, UA_STRING_STATIC("max-rejected-listsize")}, &UA_TYPES[UA_TYPES_STRING], false}
+    {{0, UA_STRING_STATIC("max-rejected-listsize")}, &UA_TYPES[UA_TYPES_STRING], false},
+    {{0, UA_STRING_STATIC("maxVerificationCacheSize")}, &UA_TYPES[UA_TYPES_UINT32], false},
+    {{0, UA_STRING_STATIC("verificationCacheTtl")}, &UA_TYPES[UA_TYPES_UINT32], false}
 };
 
 typedef struct {
@@ -51,6 +56,9 @@ typedef struct {
 
     UA_Boolean reloadRequired;
 
+    /* Successful verifications with the current trust list */
+    UA_CertificateCache verificationCache;
+
     mbedtls_x509_crt trustedCertificates;
     mbedtls_x509_crt issuerCertificates;
     mbedtls_x509_crl trustedCrls;
@@ -68,6 +76,7 @@ MemoryCertStore_removeFromTrustList(UA_CertificateGroup *certGroup, const UA_Tru
 
     MemoryCertStore *context = (MemoryCertStore *)certGroup->context;
     context->reloadRequired = true;
+    UA_CertificateCache_invalidate(&context->verificationCache);
     return UA_TrustListDataType_remove(trustList, &context->trustList);
 }
 
@@ -94,6 +103,7 @@ MemoryCertStore_setTrustList(UA_CertificateGroup *certGroup, const UA_TrustListD
         return UA_STATUSCODE_BADINTERNALERROR;
     }
     context->reloadRequired = true;
+    UA_CertificateCache_invalidate(&context->verificationCache);
     /* Remove the section of the trust list that needs to be reset, while keeping the remaining parts intact */
     return UA_TrustListDataType_set(trustList, &context->trustList);
 }
@@ -110,6 +120,7 @@ MemoryCertStore_addToTrustList(UA_CertificateGroup *certGroup, const UA_TrustLis
         return UA_STATUSCODE_BADINTERNALERROR;
     }
     context->reloadRequired = true;
+    UA_CertificateCache_invalidate(&context->verificationCache);
     return UA_TrustListDataType_add(trustList, &context->trustList);
 }
 
@@ -273,6 +284,8 @@ MemoryCertStore_clear(UA_CertificateGroup *certGroup) {
         mbedtls_x509_crl_free(&context->trustedCrls);
         mbedtls_x509_crl_free(&context->issuerCrls);
 
+        UA_CertificateCache_clear(&context->verificationCache);
+
         UA_free(context);
         certGroup->context = NULL;
     }
@@ -618,13 +631,26 @@ MemoryCertStore_verifyCertificate(UA_CertificateGroup *certGroup,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
 
+    /* Verified before with the current trust list? */
+    MemoryCertStore *context = (MemoryCertStore *)certGroup->context;
+    if(context && !context->reloadRequired &&
+       UA_CertificateCache_lookup(&context->verificationCache, certificate))
+        return UA_STATUSCODE_GOOD;
+
     UA_StatusCode retval = verifyCertificate(certGroup, certificate);
     if(retval != UA_STATUSCODE_GOOD) {
         if(MemoryCertStore_addToRejectedList(certGroup, certificate) != UA_STATUSCODE_GOOD) {
             UA_LOG_WARNING(certGroup->logging, UA_LOGCATEGORY_SECURITYPOLICY,
                            "Could not append certificate to rejected list");
         }
+        return retval;
     }
+
+    /* Cache the result until the certificate expires */
+    UA_DateTime notAfter;
+    if(UA_CertificateUtils_getExpirationDate((UA_ByteString*)(uintptr_t)certificate,
+                                             &notAfter) == UA_STATUSCODE_GOOD)
+        UA_CertificateCache_add(&context->verificationCache, certificate, notAfter);
     return retval;
 }
 
@@ -667,6 +693,8 @@ UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
     /* Default values */
     context->maxTrustListSize = 65535;
     context->maxRejectedListSize = 100;
+    UA_UInt32 maxVerificationCacheSize = UA_CERTIFICATECACHE_DEFAULTSIZE;
+    UA_UInt32 verificationCacheTtl = UA_CERTIFICATECACHE_DEFAULTTTL;
 
     if(params) {
         const UA_UInt32 *maxTrustListSize = (const UA_UInt32*)
@@ -684,7 +712,25 @@ UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
         if(maxRejectedListSize) {
             context->maxRejectedListSize = *maxRejectedListSize;
         }
+
+        const UA_UInt32 *cacheSize = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(params, MemoryCertStoreParameters[MEMORYCERTSTORE_PARAMINDEX_MAXVERIFICATIONCACHESIZE].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+
+        const UA_UInt32 *cacheTtl = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(params, MemoryCertStoreParameters[MEMORYCERTSTORE_PARAMINDEX_VERIFICATIONCACHETTL].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+
+        if(cacheSize) {
+            maxVerificationCacheSize = *cacheSize;
+        }
+
+        if(cacheTtl) {
+            verificationCacheTtl = *cacheTtl;
+        }
     }
+    UA_CertificateCache_init(&context->verificationCache,
+                             maxVerificationCacheSize, verificationCacheTtl);
 
     UA_TrustListDataType_add(trustList, &context->trustList);
     reloadCertificates(certGroup);
@@ -62,6 +62,10 @@ typedef struct {
     UA_ByteString remoteSymEncryptingKey;
     UA_ByteString remoteSymIv;
 
+    /* Verifying received chunks happens without the server lock. So the
+     * message digest cannot be shared with other channels. */
+    mbedtls_md_context_t remoteMdContext;
+
     mbedtls_x509_crt remoteCertificate;
 } Aes128Sha256PsaOaep_ChannelContext;
 
@@ -260,9 +264,8 @@ sym_verify_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext *cc,
     /* Compute MAC */
     if(signature->length != UA_SHA256_LENGTH)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
-    Aes128Sha256PsaOaep_PolicyContext *pc = cc->policyContext;
     unsigned char mac[UA_SHA256_LENGTH];
-    if(mbedtls_hmac(&pc->sha256MdContext, &cc->remoteSymSigningKey,
+    if(mbedtls_hmac(&cc->remoteMdContext, &cc->remoteSymSigningKey,
                     message, mac) != UA_STATUSCODE_GOOD)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
@@ -439,6 +442,7 @@ channelContext_deleteContext_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelC
     UA_ByteString_clear(&cc->remoteSymEncryptingKey);
     UA_ByteString_clear(&cc->remoteSymIv);
 
+    mbedtls_md_free(&cc->remoteMdContext);
     mbedtls_x509_crt_free(&cc->remoteCertificate);
 
     UA_free(cc);
@@ -469,8 +473,16 @@ channelContext_newContext_sp_aes128sha256rsaoaep(const UA_SecurityPolicy *securi
     UA_ByteString_init(&cc->remoteSymEncryptingKey);
     UA_ByteString_init(&cc->remoteSymIv);
 
+    mbedtls_md_init(&cc->remoteMdContext);
     mbedtls_x509_crt_init(&cc->remoteCertificate);
 
+    const mbedtls_md_info_t *mdInfo = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    if(mbedtls_md_setup(&cc->remoteMdContext, mdInfo, 1) != 0) {
+        channelContext_deleteContext_sp_aes128sha256rsaoaep(cc);
+        *pp_contextData = NULL;
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
     // TODO: this can be optimized so that we dont allocate memory before parsing the certificate
     UA_StatusCode retval = parseRemoteCertificate_sp_aes128sha256rsaoaep(cc, remoteCertificate);
     if(retval != UA_STATUSCODE_GOOD) {
@@ -59,6 +59,10 @@ typedef struct {
     UA_ByteString remoteSymEncryptingKey;
     UA_ByteString remoteSymIv;
 
+    /* Verifying received chunks happens without the server lock. So the
+     * message digest cannot be shared with other channels. */
+    mbedtls_md_context_t remoteMdContext;
+
     mbedtls_x509_crt remoteCertificate;
 } Aes256Sha256RsaPss_ChannelContext;
 
@@ -256,9 +260,8 @@ sym_verify_sp_aes256sha256rsapss(Aes256Sha256RsaPss_ChannelContext *cc,
     /* Compute MAC */
     if(signature->length != UA_SHA256_LENGTH)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
-    Aes256Sha256RsaPss_PolicyContext *pc = cc->policyContext;
     unsigned char mac[UA_SHA256_LENGTH];
-    if(mbedtls_hmac(&pc->sha256MdContext, &cc->remoteSymSigningKey, message, mac) != UA_STATUSCODE_GOOD)
+    if(mbedtls_hmac(&cc->remoteMdContext, &cc->remoteSymSigningKey, message, mac) != UA_STATUSCODE_GOOD)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
     /* Compare with Signature */
@@ -531,6 +534,7 @@ channelContext_deleteContext_sp_aes256sha256rsapss(Aes256Sha256RsaPss_ChannelCon
     UA_ByteString_clear(&cc->remoteSymEncryptingKey);
     UA_ByteString_clear(&cc->remoteSymIv);
 
+    mbedtls_md_free(&cc->remoteMdContext);
     mbedtls_x509_crt_free(&cc->remoteCertificate);
 
     UA_free(cc);
@@ -561,8 +565,16 @@ channelContext_newContext_sp_aes256sha256rsapss(const UA_SecurityPolicy *securit
     UA_ByteString_init(&cc->remoteSymEncryptingKey);
     UA_ByteString_init(&cc->remoteSymIv);
 
+    mbedtls_md_init(&cc->remoteMdContext);
     mbedtls_x509_crt_init(&cc->remoteCertificate);
 
+    const mbedtls_md_info_t *mdInfo = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    if(mbedtls_md_setup(&cc->remoteMdContext, mdInfo, 1) != 0) {
+        channelContext_deleteContext_sp_aes256sha256rsapss(cc);
+        *pp_contextData = NULL;
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
     // TODO: this can be optimized so that we dont allocate memory before parsing the certificate
     UA_StatusCode retval = parseRemoteCertificate_sp_aes256sha256rsapss(cc, remoteCertificate);
     if(retval != UA_STATUSCODE_GOOD) {
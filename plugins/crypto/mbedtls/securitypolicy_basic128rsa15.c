@@ -61,6 +61,10 @@ typedef struct {
     UA_ByteString remoteSymEncryptingKey;
     UA_ByteString remoteSymIv;
 
+    /* Verifying received chunks happens without the server lock. So the
+     * message digest cannot be shared with other channels. */
+    mbedtls_md_context_t remoteMdContext;
+
     mbedtls_x509_crt remoteCertificate;
 } Basic128Rsa15_ChannelContext;
 
@@ -282,10 +286,8 @@ sym_verify_sp_basic128rsa15(Basic128Rsa15_ChannelContext *cc,
     if(signature->length != UA_SHA1_LENGTH)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
-    Basic128Rsa15_PolicyContext *pc = cc->policyContext;
-
     unsigned char mac[UA_SHA1_LENGTH];
-    if(mbedtls_hmac(&pc->sha1MdContext, &cc->remoteSymSigningKey,
+    if(mbedtls_hmac(&cc->remoteMdContext, &cc->remoteSymSigningKey,
                     message, mac) != UA_STATUSCODE_GOOD)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
@@ -460,6 +462,7 @@ channelContext_deleteContext_sp_basic128rsa15(Basic128Rsa15_ChannelContext *cc)
     UA_ByteString_clear(&cc->remoteSymSigningKey);
     UA_ByteString_clear(&cc->remoteSymEncryptingKey);
     UA_ByteString_clear(&cc->remoteSymIv);
+    mbedtls_md_free(&cc->remoteMdContext);
     mbedtls_x509_crt_free(&cc->remoteCertificate);
     UA_free(cc);
 }
@@ -489,8 +492,16 @@ channelContext_newContext_sp_basic128rsa15(const UA_SecurityPolicy *securityPoli
     UA_ByteString_init(&cc->remoteSymEncryptingKey);
     UA_ByteString_init(&cc->remoteSymIv);
 
+    mbedtls_md_init(&cc->remoteMdContext);
     mbedtls_x509_crt_init(&cc->remoteCertificate);
 
+    const mbedtls_md_info_t *mdInfo = mbedtls_md_info_from_type(MBEDTLS_MD_SHA1);
+    if(mbedtls_md_setup(&cc->remoteMdContext, mdInfo, 1) != 0) {
+        channelContext_deleteContext_sp_basic128rsa15(cc);
+        *pp_contextData = NULL;
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
     // TODO: this can be optimized so that we dont allocate memory before parsing the certificate
     UA_StatusCode retval = parseRemoteCertificate_sp_basic128rsa15(cc, remoteCertificate);
     if(retval != UA_STATUSCODE_GOOD) {
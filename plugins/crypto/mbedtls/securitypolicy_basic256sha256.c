@@ -63,6 +63,10 @@ typedef struct {
     UA_ByteString remoteSymEncryptingKey;
     UA_ByteString remoteSymIv;
 
+    /* Verifying received chunks happens without the server lock. So the
+     * message digest cannot be shared with other channels. */
+    mbedtls_md_context_t remoteMdContext;
+
     mbedtls_x509_crt remoteCertificate;
 } Basic256Sha256_ChannelContext;
 
@@ -263,9 +267,8 @@ sym_verify_sp_basic256sha256(Basic256Sha256_ChannelContext *cc,
     if(signature->length != UA_SHA256_LENGTH)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
-    Basic256Sha256_PolicyContext *pc = cc->policyContext;
     unsigned char mac[UA_SHA256_LENGTH];
-    if(mbedtls_hmac(&pc->sha256MdContext, &cc->remoteSymSigningKey, message, mac) != UA_STATUSCODE_GOOD)
+    if(mbedtls_hmac(&cc->remoteMdContext, &cc->remoteSymSigningKey, message, mac) != UA_STATUSCODE_GOOD)
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
     /* Compare with Signature */
@@ -440,6 +443,7 @@ channelContext_deleteContext_sp_basic256sha256(Basic256Sha256_ChannelContext *cc
     UA_ByteString_clear(&cc->remoteSymEncryptingKey);
     UA_ByteString_clear(&cc->remoteSymIv);
 
+    mbedtls_md_free(&cc->remoteMdContext);
     mbedtls_x509_crt_free(&cc->remoteCertificate);
 
     UA_free(cc);
@@ -470,8 +474,16 @@ channelContext_newContext_sp_basic256sha256(const UA_SecurityPolicy *securityPol
     UA_ByteString_init(&cc->remoteSymEncryptingKey);
     UA_ByteString_init(&cc->remoteSymIv);
 
+    mbedtls_md_init(&cc->remoteMdContext);
     mbedtls_x509_crt_init(&cc->remoteCertificate);
 
+    const mbedtls_md_info_t *mdInfo = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    if(mbedtls_md_setup(&cc->remoteMdContext, mdInfo, 1) != 0) {
+        channelContext_deleteContext_sp_basic256sha256(cc);
+        *pp_contextData = NULL;
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
     // TODO: this can be optimized so that we dont allocate memory before parsing the certificate
     UA_StatusCode retval = parseRemoteCertificate_sp_basic256sha256(cc, remoteCertificate);
     if(retval != UA_STATUSCODE_GOOD) {
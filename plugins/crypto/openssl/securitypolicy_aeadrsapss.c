@@ -0,0 +1,803 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *    Copyright 2022 (c) Fraunhofer IOSB (Author: Noel Graf)
+ */
+
+/* SecurityPolicies with single-pass authenticated encryption (AES-256-GCM or
+ * ChaCha20-Poly1305) for the symmetric part of the SecureChannel. The
+ * asymmetric part (OPN) is identical to Aes256_Sha256_RsaPss. In
+ * SignAndEncrypt mode the chunks are not padded and the 16 byte authentication
+ * tag replaces the HMAC signature. In Sign mode the tag is computed over the
+ * chunk with an empty plaintext (i.e. GMAC for AES-GCM). */
+
+#include <open62541/plugin/securitypolicy_default.h>
+#include <open62541/util.h>
+
+#if defined(UA_ENABLE_ENCRYPTION_OPENSSL)
+
+#include "securitypolicy_common.h"
+
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+#include <openssl/rand.h>
+
+#define UA_SECURITYPOLICY_AEADRSAPSS_RSAPADDING_LEN 66
+/* The AEAD key is also used for the authentication. No separate signing key. */
+#define UA_SECURITYPOLICY_AEADRSAPSS_SYM_SIGNING_KEY_LENGTH 0
+#define UA_SECURITYPOLICY_AEADRSAPSS_SYM_ENCRYPTION_KEY_LENGTH 32
+#define UA_SECURITYPOLICY_AEADRSAPSS_MINASYMKEYLENGTH 256
+#define UA_SECURITYPOLICY_AEADRSAPSS_MAXASYMKEYLENGTH 512
+
+typedef struct {
+    EVP_PKEY *localPrivateKey;
+    EVP_PKEY *csrLocalPrivateKey;
+    UA_ByteString localCertThumbprint;
+    const EVP_CIPHER *cipher; /* AES-256-GCM or ChaCha20-Poly1305 */
+    const UA_Logger *logger;
+} Policy_Context_AeadRsaPss;
+
+typedef struct {
+    UA_OpenSSL_AeadCtx encryptCtx; /* Local key */
+    UA_OpenSSL_AeadCtx decryptCtx; /* Remote key */
+
+    Policy_Context_AeadRsaPss *policyContext;
+    UA_ByteString remoteCertificate;
+    X509 *remoteCertificateX509; /* X509 */
+} Channel_Context_AeadRsaPss;
+
+/* create the policy context */
+
+static UA_StatusCode
+UA_Policy_AeadRsaPss_New_Context(UA_SecurityPolicy *securityPolicy,
+                                 const UA_ByteString localPrivateKey,
+                                 const EVP_CIPHER *cipher,
+                                 const UA_Logger *logger) {
+    Policy_Context_AeadRsaPss *context =
+        (Policy_Context_AeadRsaPss *)UA_malloc(
+            sizeof(Policy_Context_AeadRsaPss));
+    if(context == NULL) {
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    context->localPrivateKey = UA_OpenSSL_LoadPrivateKey(&localPrivateKey);
+    if (!context->localPrivateKey) {
+        UA_free(context);
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    }
+
+    context->csrLocalPrivateKey = NULL;
+
+    UA_StatusCode retval = UA_Openssl_X509_GetCertificateThumbprint(
+        &securityPolicy->localCertificate, &context->localCertThumbprint, true);
+    if(retval != UA_STATUSCODE_GOOD) {
+        EVP_PKEY_free(context->localPrivateKey);
+        UA_free(context);
+        return retval;
+    }
+
+    context->cipher = cipher;
+    context->logger = logger;
+    securityPolicy->policyContext = context;
+
+    return UA_STATUSCODE_GOOD;
+}
+
+/* clear the policy context */
+
+static void
+UA_Policy_AeadRsaPss_Clear_Context(UA_SecurityPolicy *policy) {
+    if(policy == NULL)
+        return;
+
+    UA_ByteString_clear(&policy->localCertificate);
+
+    /* delete all allocated members in the context */
+
+    Policy_Context_AeadRsaPss *pc =
+        (Policy_Context_AeadRsaPss *)policy->policyContext;
+    if (pc == NULL) {
+        return;
+    }
+
+    EVP_PKEY_free(pc->localPrivateKey);
+    EVP_PKEY_free(pc->csrLocalPrivateKey);
+    UA_ByteString_clear(&pc->localCertThumbprint);
+    UA_free(pc);
+
+    return;
+}
+
+static UA_StatusCode
+createSigningRequest_sp_aeadrsapss(UA_SecurityPolicy *securityPolicy,
+                                   const UA_String *subjectName,
+                                   const UA_ByteString *nonce,
+                                   const UA_KeyValueMap *params,
+                                   UA_ByteString *csr,
+                                   UA_ByteString *newPrivateKey) {
+    /* Check parameter */
+    if(!securityPolicy || !csr)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+     if(!securityPolicy->policyContext)
+         return UA_STATUSCODE_BADINTERNALERROR;
+
+    Policy_Context_AeadRsaPss *pc =
+        (Policy_Context_AeadRsaPss*)securityPolicy->policyContext;
+
+    return UA_OpenSSL_CreateSigningRequest(pc->localPrivateKey, &pc->csrLocalPrivateKey,
+                                           securityPolicy, subjectName,
+                                           nonce, csr, newPrivateKey);
+}
+
+static UA_StatusCode
+updateCertificateAndPrivateKey_sp_aeadrsapss(UA_SecurityPolicy *securityPolicy,
+                                             const UA_ByteString newCertificate,
+                                             const UA_ByteString newPrivateKey) {
+    if(!securityPolicy)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    if(!securityPolicy->policyContext)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    Policy_Context_AeadRsaPss *pc =
+        (Policy_Context_AeadRsaPss *)securityPolicy->policyContext;
+
+    UA_Boolean isLocalKey = false;
+    if(newPrivateKey.length <= 0) {
+        if(UA_CertificateUtils_comparePublicKeys(&newCertificate, &securityPolicy->localCertificate) == 0)
+            isLocalKey = true;
+    }
+
+    UA_ByteString_clear(&securityPolicy->localCertificate);
+    UA_ByteString_clear(&pc->localCertThumbprint);
+
+    UA_StatusCode retval =
+        UA_OpenSSL_LoadLocalCertificate(&newCertificate,
+                                        &securityPolicy->localCertificate);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Set the new private key */
+    if(newPrivateKey.length > 0) {
+        EVP_PKEY_free(pc->localPrivateKey);
+        pc->localPrivateKey = UA_OpenSSL_LoadPrivateKey(&newPrivateKey);
+    } else {
+        if(!isLocalKey) {
+            EVP_PKEY_free(pc->localPrivateKey);
+            pc->localPrivateKey = pc->csrLocalPrivateKey;
+            pc->csrLocalPrivateKey = NULL;
+        }
+    }
+
+    if(!pc->localPrivateKey) {
+        retval = UA_STATUSCODE_BADNOTSUPPORTED;
+        goto error;
+    }
+
+    retval = UA_Openssl_X509_GetCertificateThumbprint(&securityPolicy->localCertificate,
+                                                      &pc->localCertThumbprint, true);
+    if(retval != UA_STATUSCODE_GOOD)
+        goto error;
+
+    return UA_STATUSCODE_GOOD;
+
+error:
+    UA_LOG_ERROR(securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+                 "Could not update certificate and private key");
+    if(securityPolicy->policyContext)
+        UA_Policy_AeadRsaPss_Clear_Context(securityPolicy);
+    return retval;
+}
+
+/* create the channel context */
+
+static UA_StatusCode
+UA_ChannelModule_AeadRsaPss_New_Context(const UA_SecurityPolicy *securityPolicy,
+                                                 const UA_ByteString *remoteCertificate,
+                                                 void **channelContext) {
+    if(securityPolicy == NULL || remoteCertificate == NULL || channelContext == NULL) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    Channel_Context_AeadRsaPss *context =
+        (Channel_Context_AeadRsaPss *)UA_malloc(
+            sizeof(Channel_Context_AeadRsaPss));
+    if(context == NULL) {
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    memset(&context->encryptCtx, 0, sizeof(UA_OpenSSL_AeadCtx));
+    memset(&context->decryptCtx, 0, sizeof(UA_OpenSSL_AeadCtx));
+
+    UA_StatusCode retval =
+        UA_copyCertificate(&context->remoteCertificate, remoteCertificate);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_free(context);
+        return retval;
+    }
+
+    /* decode to X509 */
+    context->remoteCertificateX509 = UA_OpenSSL_LoadCertificate(&context->remoteCertificate);
+    if (context->remoteCertificateX509 == NULL) {
+        UA_ByteString_clear (&context->remoteCertificate);
+        UA_free (context);
+        return UA_STATUSCODE_BADCERTIFICATECHAININCOMPLETE;
+    }
+
+    context->policyContext =
+        (Policy_Context_AeadRsaPss *)(securityPolicy->policyContext);
+
+    *channelContext = context;
+
+    UA_LOG_INFO(
+        securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+        "The AeadRsaPss security policy channel with openssl is created.");
+
+    return UA_STATUSCODE_GOOD;
+}
+
+/* delete the channel context */
+
+static void
+UA_ChannelModule_AeadRsaPss_Delete_Context(void *channelContext) {
+    if(channelContext != NULL) {
+        Channel_Context_AeadRsaPss *cc =
+            (Channel_Context_AeadRsaPss *)channelContext;
+        X509_free(cc->remoteCertificateX509);
+        UA_ByteString_clear(&cc->remoteCertificate);
+        UA_OpenSSL_AeadCtx_clear(&cc->encryptCtx);
+        UA_OpenSSL_AeadCtx_clear(&cc->decryptCtx);
+
+        UA_LOG_INFO(
+            cc->policyContext->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+            "The AeadRsaPss security policy channel with openssl is deleted.");
+        UA_free(cc);
+    }
+}
+
+/* Verifies the signature of the message using the provided keys in the context.
+ * AsymmetricSignatureAlgorithm_RSA-PKCS15-SHA2-256
+ */
+
+static UA_StatusCode
+UA_AsySig_AeadRsaPss_Verify(void *channelContext, const UA_ByteString *message,
+                                     const UA_ByteString *signature) {
+    if(message == NULL || signature == NULL || channelContext == NULL) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    Channel_Context_AeadRsaPss *cc =
+        (Channel_Context_AeadRsaPss *)channelContext;
+    UA_StatusCode retval = UA_OpenSSL_RSA_PSS_SHA256_Verify(
+        message, cc->remoteCertificateX509, signature);
+
+    return retval;
+}
+
+/* Compares the supplied certificate with the certificate
+ * in the endpoint context
+ */
+
+static UA_StatusCode
+UA_compareCertificateThumbprint_AeadRsaPss(const UA_SecurityPolicy *securityPolicy,
+                                                    const UA_ByteString *certificateThumbprint) {
+    if(securityPolicy == NULL || certificateThumbprint == NULL) {
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    }
+    Policy_Context_AeadRsaPss *pc =
+        (Policy_Context_AeadRsaPss *)securityPolicy->policyContext;
+    if(!UA_ByteString_equal(certificateThumbprint, &pc->localCertThumbprint))
+        return UA_STATUSCODE_BADCERTIFICATEINVALID;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Generates a thumbprint for the specified certificate */
+
+static UA_StatusCode
+UA_makeCertificateThumbprint_AeadRsaPss(const UA_SecurityPolicy *securityPolicy,
+                                                 const UA_ByteString *certificate,
+                                                 UA_ByteString *thumbprint) {
+    return UA_Openssl_X509_GetCertificateThumbprint(certificate, thumbprint, false);
+}
+
+static UA_StatusCode
+UA_Asym_AeadRsaPss_Decrypt(void *channelContext, UA_ByteString *data) {
+    if(channelContext == NULL || data == NULL)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    Channel_Context_AeadRsaPss *cc = (Channel_Context_AeadRsaPss *)channelContext;
+    UA_StatusCode ret = UA_Openssl_RSA_Oaep_Sha2_Decrypt(data, cc->policyContext->localPrivateKey);
+    return ret;
+}
+
+static size_t
+UA_Asym_AeadRsaPss_getRemoteSignatureSize(const void *channelContext) {
+    if(channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    const Channel_Context_AeadRsaPss *cc = (const Channel_Context_AeadRsaPss *)channelContext;
+    UA_Int32 keyLen = 0;
+    UA_Openssl_RSA_Public_GetKeyLength(cc->remoteCertificateX509, &keyLen);
+    return (size_t)keyLen;
+}
+
+static size_t
+UA_AsySig_AeadRsaPss_getLocalSignatureSize(const void *channelContext) {
+    if(channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    const Channel_Context_AeadRsaPss *cc = (const Channel_Context_AeadRsaPss *)channelContext;
+    Policy_Context_AeadRsaPss *pc = cc->policyContext;
+    UA_Int32 keyLen = 0;
+    UA_Openssl_RSA_Private_GetKeyLength(pc->localPrivateKey, &keyLen);
+    return (size_t)keyLen;
+}
+
+static size_t
+UA_AsymEn_AeadRsaPss_getRemotePlainTextBlockSize(const void *channelContext) {
+    if(channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    const Channel_Context_AeadRsaPss *cc =
+        (const Channel_Context_AeadRsaPss *)channelContext;
+    UA_Int32 keyLen = 0;
+    UA_Openssl_RSA_Public_GetKeyLength(cc->remoteCertificateX509, &keyLen);
+    return (size_t)keyLen - UA_SECURITYPOLICY_AEADRSAPSS_RSAPADDING_LEN;
+}
+
+static size_t
+UA_AsymEn_AeadRsaPss_getRemoteBlockSize(const void *channelContext) {
+    if(channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    const Channel_Context_AeadRsaPss *cc =
+        (const Channel_Context_AeadRsaPss *)channelContext;
+    UA_Int32 keyLen = 0;
+    UA_Openssl_RSA_Public_GetKeyLength(cc->remoteCertificateX509, &keyLen);
+    return (size_t)keyLen;
+}
+
+static size_t
+UA_AsymEn_AeadRsaPss_getRemoteKeyLength(const void *channelContext) {
+    if(channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    const Channel_Context_AeadRsaPss *cc =
+        (const Channel_Context_AeadRsaPss *)channelContext;
+    UA_Int32 keyLen = 0;
+    UA_Openssl_RSA_Public_GetKeyLength(cc->remoteCertificateX509, &keyLen);
+    return (size_t)keyLen * 8;
+}
+
+static UA_StatusCode
+UA_Sym_AeadRsaPss_generateNonce(void *policyContext,
+                                         UA_ByteString *out) {
+    UA_Int32 rc = RAND_bytes(out->data, (int)out->length);
+    if(rc != 1) {
+        return UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static size_t
+UA_SymEn_AeadRsaPss_getLocalKeyLength(const void *channelContext) {
+    /* 32 bytes 256 bits */
+    return UA_SECURITYPOLICY_AEADRSAPSS_SYM_ENCRYPTION_KEY_LENGTH;
+}
+
+static size_t
+UA_SymSig_AeadRsaPss_getLocalKeyLength(const void *channelContext) {
+    return UA_SECURITYPOLICY_AEADRSAPSS_SYM_SIGNING_KEY_LENGTH;
+}
+
+static UA_StatusCode
+UA_Sym_AeadRsaPss_generateKey(void *policyContext,
+                                       const UA_ByteString *secret,
+                                       const UA_ByteString *seed, UA_ByteString *out) {
+    return UA_Openssl_Random_Key_PSHA256_Derive(secret, seed, out);
+}
+
+static UA_StatusCode
+UA_CertSig_AeadRsaPss_Verify(void *channelContext, const UA_ByteString *message,
+                             const UA_ByteString *signature) {
+    if(message == NULL || signature == NULL || channelContext == NULL) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    Channel_Context_AeadRsaPss *cc =
+        (Channel_Context_AeadRsaPss *)channelContext;
+    UA_StatusCode retval = UA_OpenSSL_RSA_PKCS1_V15_SHA256_Verify(
+        message, cc->remoteCertificateX509, signature);
+
+    return retval;
+}
+
+static UA_StatusCode
+UA_CertSig_AeadRsaPss_sign(void *channelContext, const UA_ByteString *message,
+                           UA_ByteString *signature) {
+    if(channelContext == NULL || message == NULL ||
+       signature == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_AeadRsaPss *cc = (Channel_Context_AeadRsaPss *)channelContext;
+    Policy_Context_AeadRsaPss *pc = cc->policyContext;
+    return UA_Openssl_RSA_PKCS1_V15_SHA256_Sign(message, pc->localPrivateKey, signature);
+}
+
+static size_t
+UA_CertSig_AeadRsaPss_getRemoteSignatureSize(const void *channelContext) {
+    if(channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    const Channel_Context_AeadRsaPss *cc = (const Channel_Context_AeadRsaPss *)channelContext;
+    UA_Int32 keyLen = 0;
+    UA_Openssl_RSA_Public_GetKeyLength(cc->remoteCertificateX509, &keyLen);
+    return (size_t)keyLen;
+}
+
+static size_t
+UA_CertSig_AeadRsaPss_getLocalSignatureSize(const void *channelContext) {
+    if(channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    const Channel_Context_AeadRsaPss *cc = (const Channel_Context_AeadRsaPss *)channelContext;
+    Policy_Context_AeadRsaPss *pc = cc->policyContext;
+    UA_Int32 keyLen = 0;
+    UA_Openssl_RSA_Private_GetKeyLength(pc->localPrivateKey, &keyLen);
+    return (size_t)keyLen;
+}
+
+/* The signing keys have zero length. Nothing to set. */
+static UA_StatusCode
+UA_ChannelModule_AeadRsaPss_setLocalSymSigningKey(void *channelContext,
+                                                  const UA_ByteString *key) {
+    if(key == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+UA_ChannelM_AeadRsaPss_setLocalSymEncryptingKey(void *channelContext,
+                                                const UA_ByteString *key) {
+    if(key == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_AeadRsaPss *cc = (Channel_Context_AeadRsaPss *)channelContext;
+    return UA_OpenSSL_AeadCtx_setKey(&cc->encryptCtx, cc->policyContext->cipher,
+                                     key, true);
+}
+
+static UA_StatusCode
+UA_ChannelM_AeadRsaPss_setLocalSymIv(void *channelContext,
+                                     const UA_ByteString *iv) {
+    if(iv == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_AeadRsaPss *cc = (Channel_Context_AeadRsaPss *)channelContext;
+    return UA_OpenSSL_AeadCtx_setIv(&cc->encryptCtx, iv);
+}
+
+static size_t
+UA_SymEn_AeadRsaPss_getRemoteKeyLength(const void *channelContext) {
+    /* 32 bytes 256 bits */
+    return UA_SECURITYPOLICY_AEADRSAPSS_SYM_ENCRYPTION_KEY_LENGTH;
+}
+
+/* The "block size" is the length of the derived IV */
+static size_t
+UA_SymEn_AeadRsaPss_getBlockSize(const void *channelContext) {
+    return UA_OPENSSL_AEAD_IV_LENGTH;
+}
+
+/* Stream cipher, no padding to a block boundary */
+static size_t
+UA_SymEn_AeadRsaPss_getPlainTextBlockSize(const void *channelContext) {
+    return 1;
+}
+
+static size_t
+UA_SymSig_AeadRsaPss_getRemoteKeyLength(const void *channelContext) {
+    return UA_SECURITYPOLICY_AEADRSAPSS_SYM_SIGNING_KEY_LENGTH;
+}
+
+static UA_StatusCode
+UA_ChannelM_AeadRsaPss_setRemoteSymSigningKey(void *channelContext,
+                                              const UA_ByteString *key) {
+    if(key == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+UA_ChannelM_AeadRsaPss_setRemoteSymEncryptingKey(void *channelContext,
+                                                 const UA_ByteString *key) {
+    if(key == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_AeadRsaPss *cc = (Channel_Context_AeadRsaPss *)channelContext;
+    return UA_OpenSSL_AeadCtx_setKey(&cc->decryptCtx, cc->policyContext->cipher,
+                                     key, false);
+}
+
+static UA_StatusCode
+UA_ChannelM_AeadRsaPss_setRemoteSymIv(void *channelContext,
+                                      const UA_ByteString *iv) {
+    if(iv == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_AeadRsaPss *cc = (Channel_Context_AeadRsaPss *)channelContext;
+    return UA_OpenSSL_AeadCtx_setIv(&cc->decryptCtx, iv);
+}
+
+static UA_StatusCode
+UA_AsySig_AeadRsaPss_sign(void *channelContext, const UA_ByteString *message,
+                                   UA_ByteString *signature) {
+    if(channelContext == NULL || message == NULL ||
+       signature == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_AeadRsaPss *cc =
+        (Channel_Context_AeadRsaPss *)channelContext;
+    Policy_Context_AeadRsaPss *pc = cc->policyContext;
+    return UA_Openssl_RSA_PSS_SHA256_Sign(message, pc->localPrivateKey, signature);
+}
+
+static UA_StatusCode
+UA_AsymEn_AeadRsaPss_encrypt(void *channelContext, UA_ByteString *data) {
+    if(channelContext == NULL || data == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_AeadRsaPss *cc =
+        (Channel_Context_AeadRsaPss *)channelContext;
+    return UA_Openssl_RSA_OAEP_SHA2_Encrypt(
+        data, UA_SECURITYPOLICY_AEADRSAPSS_RSAPADDING_LEN,
+        cc->remoteCertificateX509);
+}
+
+static size_t
+UA_SymSig_AeadRsaPss_getRemoteSignatureSize(const void *channelContext) {
+    return UA_OPENSSL_AEAD_TAG_LENGTH;
+}
+
+/* Sign-only mode: authenticate the message with an empty plaintext */
+static UA_StatusCode
+UA_SymSig_AeadRsaPss_verify(void *channelContext, const UA_ByteString *message,
+                            const UA_ByteString *signature) {
+    if(channelContext == NULL || message == NULL ||
+       signature == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_AeadRsaPss *cc = (Channel_Context_AeadRsaPss *)channelContext;
+    UA_ByteString empty = UA_BYTESTRING_NULL;
+    return UA_OpenSSL_AeadCtx_decrypt(&cc->decryptCtx, message, &empty, signature);
+}
+
+static UA_StatusCode
+UA_SymSig_AeadRsaPss_sign(void *channelContext, const UA_ByteString *message,
+                          UA_ByteString *signature) {
+    if(channelContext == NULL || message == NULL ||
+       signature == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_AeadRsaPss *cc = (Channel_Context_AeadRsaPss *)channelContext;
+    UA_ByteString empty = UA_BYTESTRING_NULL;
+    return UA_OpenSSL_AeadCtx_encrypt(&cc->encryptCtx, message, &empty, signature);
+}
+
+static size_t
+UA_SymSig_AeadRsaPss_getLocalSignatureSize(const void *channelContext) {
+    return UA_OPENSSL_AEAD_TAG_LENGTH;
+}
+
+/* Separate encryption without authentication is not possible. The
+ * SecureChannel uses encryptAuthenticated/decryptAuthenticated instead. */
+static UA_StatusCode
+UA_SymEn_AeadRsaPss_decrypt(void *channelContext, UA_ByteString *data) {
+    return UA_STATUSCODE_BADNOTSUPPORTED;
+}
+
+static UA_StatusCode
+UA_SymEn_AeadRsaPss_encrypt(void *channelContext, UA_ByteString *data) {
+    return UA_STATUSCODE_BADNOTSUPPORTED;
+}
+
+static UA_StatusCode
+UA_Sym_AeadRsaPss_encryptAuthenticated(void *channelContext, const UA_ByteString *aad,
+                                       UA_ByteString *data, UA_ByteString *tag) {
+    if(channelContext == NULL || aad == NULL || data == NULL || tag == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_AeadRsaPss *cc = (Channel_Context_AeadRsaPss *)channelContext;
+    return UA_OpenSSL_AeadCtx_encrypt(&cc->encryptCtx, aad, data, tag);
+}
+
+static UA_StatusCode
+UA_Sym_AeadRsaPss_decryptAuthenticated(void *channelContext, const UA_ByteString *aad,
+                                       UA_ByteString *data, const UA_ByteString *tag) {
+    if(channelContext == NULL || aad == NULL || data == NULL || tag == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_AeadRsaPss *cc = (Channel_Context_AeadRsaPss *)channelContext;
+    return UA_OpenSSL_AeadCtx_decrypt(&cc->decryptCtx, aad, data, tag);
+}
+
+static UA_StatusCode
+UA_ChannelM_AeadRsaPss_compareCertificate(const void *channelContext,
+                                                   const UA_ByteString *certificate) {
+    if(channelContext == NULL || certificate == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    const Channel_Context_AeadRsaPss *cc =
+        (const Channel_Context_AeadRsaPss *)channelContext;
+    return UA_OpenSSL_X509_compare(certificate, cc->remoteCertificateX509);
+}
+
+static size_t
+UA_AsymEn_AeadRsaPss_getLocalKeyLength(const void *channelContext) {
+    if(channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    const Channel_Context_AeadRsaPss *cc =
+        (const Channel_Context_AeadRsaPss *)channelContext;
+    Policy_Context_AeadRsaPss *pc = cc->policyContext;
+    UA_Int32 keyLen = 0;
+    UA_Openssl_RSA_Private_GetKeyLength(pc->localPrivateKey, &keyLen);
+    return (size_t)keyLen * 8;
+}
+
+/* the common setup for both AEAD ciphers */
+
+static UA_StatusCode
+UA_SecurityPolicy_AeadRsaPss(UA_SecurityPolicy *policy, const char *policyUri,
+                             const char *symEncryptionUri, const EVP_CIPHER *cipher,
+                             const UA_ByteString localCertificate,
+                             const UA_ByteString localPrivateKey,
+                             const UA_Logger *logger) {
+
+    UA_SecurityPolicyAsymmetricModule *const asymmetricModule = &policy->asymmetricModule;
+    UA_SecurityPolicySymmetricModule *const symmetricModule = &policy->symmetricModule;
+    UA_SecurityPolicyChannelModule *const channelModule = &policy->channelModule;
+    UA_StatusCode retval;
+
+    UA_LOG_INFO(logger, UA_LOGCATEGORY_SECURITYPOLICY,
+                "The %s security policy with openssl is added.", policyUri);
+
+    UA_Openssl_Init();
+    memset(policy, 0, sizeof(UA_SecurityPolicy));
+    policy->logger = logger;
+    policy->policyUri = UA_STRING((char*)(uintptr_t)policyUri);
+    policy->certificateGroupId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVERCONFIGURATION_CERTIFICATEGROUPS_DEFAULTAPPLICATIONGROUP);
+    policy->certificateTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_RSASHA256APPLICATIONCERTIFICATETYPE);
+    policy->securityLevel = 30;
+
+    /* set ChannelModule context  */
+
+    channelModule->newContext = UA_ChannelModule_AeadRsaPss_New_Context;
+    channelModule->deleteContext = UA_ChannelModule_AeadRsaPss_Delete_Context;
+    channelModule->setLocalSymSigningKey =
+        UA_ChannelModule_AeadRsaPss_setLocalSymSigningKey;
+    channelModule->setLocalSymEncryptingKey =
+        UA_ChannelM_AeadRsaPss_setLocalSymEncryptingKey;
+    channelModule->setLocalSymIv = UA_ChannelM_AeadRsaPss_setLocalSymIv;
+    channelModule->setRemoteSymSigningKey =
+        UA_ChannelM_AeadRsaPss_setRemoteSymSigningKey;
+    channelModule->setRemoteSymEncryptingKey =
+        UA_ChannelM_AeadRsaPss_setRemoteSymEncryptingKey;
+    channelModule->setRemoteSymIv = UA_ChannelM_AeadRsaPss_setRemoteSymIv;
+    channelModule->compareCertificate =
+        UA_ChannelM_AeadRsaPss_compareCertificate;
+
+    /* Load and convert to DER if necessary */
+    retval =
+        UA_OpenSSL_LoadLocalCertificate(&localCertificate, &policy->localCertificate);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* AsymmetricModule - signature algorithm */
+
+    UA_SecurityPolicySignatureAlgorithm *asySigAlgorithm =
+        &asymmetricModule->cryptoModule.signatureAlgorithm;
+    asySigAlgorithm->uri =
+        UA_STRING("http://opcfoundation.org/UA/security/rsa-pss-sha2-256\0");
+    asySigAlgorithm->verify = UA_AsySig_AeadRsaPss_Verify;
+    asySigAlgorithm->getRemoteSignatureSize =
+        UA_Asym_AeadRsaPss_getRemoteSignatureSize;
+    asySigAlgorithm->getLocalSignatureSize =
+        UA_AsySig_AeadRsaPss_getLocalSignatureSize;
+    asySigAlgorithm->sign = UA_AsySig_AeadRsaPss_sign;
+    asySigAlgorithm->getLocalKeyLength = NULL;
+    asySigAlgorithm->getRemoteKeyLength = NULL;
+
+    /*  AsymmetricModule encryption algorithm */
+
+    UA_SecurityPolicyEncryptionAlgorithm *asymEncryAlg =
+        &asymmetricModule->cryptoModule.encryptionAlgorithm;
+    asymEncryAlg->uri = UA_STRING("http://opcfoundation.org/UA/security/rsa-oaep-sha2-256\0");
+    asymEncryAlg->decrypt = UA_Asym_AeadRsaPss_Decrypt;
+    asymEncryAlg->getRemotePlainTextBlockSize =
+        UA_AsymEn_AeadRsaPss_getRemotePlainTextBlockSize;
+    asymEncryAlg->getRemoteBlockSize = UA_AsymEn_AeadRsaPss_getRemoteBlockSize;
+    asymEncryAlg->getRemoteKeyLength = UA_AsymEn_AeadRsaPss_getRemoteKeyLength;
+    asymEncryAlg->encrypt = UA_AsymEn_AeadRsaPss_encrypt;
+    asymEncryAlg->getLocalKeyLength = UA_AsymEn_AeadRsaPss_getLocalKeyLength;
+
+    /* asymmetricModule */
+
+    asymmetricModule->compareCertificateThumbprint =
+        UA_compareCertificateThumbprint_AeadRsaPss;
+    asymmetricModule->makeCertificateThumbprint =
+        UA_makeCertificateThumbprint_AeadRsaPss;
+
+    /* SymmetricModule */
+
+    symmetricModule->secureChannelNonceLength = 32;
+    symmetricModule->generateNonce = UA_Sym_AeadRsaPss_generateNonce;
+    symmetricModule->generateKey = UA_Sym_AeadRsaPss_generateKey;
+    symmetricModule->encryptAuthenticated = UA_Sym_AeadRsaPss_encryptAuthenticated;
+    symmetricModule->decryptAuthenticated = UA_Sym_AeadRsaPss_decryptAuthenticated;
+
+    /* Symmetric encryption Algorithm */
+
+    UA_SecurityPolicyEncryptionAlgorithm *symEncryptionAlgorithm =
+        &symmetricModule->cryptoModule.encryptionAlgorithm;
+    symEncryptionAlgorithm->uri = UA_STRING((char*)(uintptr_t)symEncryptionUri);
+    symEncryptionAlgorithm->getLocalKeyLength = UA_SymEn_AeadRsaPss_getLocalKeyLength;
+    symEncryptionAlgorithm->getRemoteKeyLength = UA_SymEn_AeadRsaPss_getRemoteKeyLength;
+    symEncryptionAlgorithm->getRemoteBlockSize = UA_SymEn_AeadRsaPss_getBlockSize;
+    symEncryptionAlgorithm->getRemotePlainTextBlockSize = UA_SymEn_AeadRsaPss_getPlainTextBlockSize;
+    symEncryptionAlgorithm->decrypt = UA_SymEn_AeadRsaPss_decrypt;
+    symEncryptionAlgorithm->encrypt = UA_SymEn_AeadRsaPss_encrypt;
+
+    /* Symmetric signature Algorithm */
+
+    UA_SecurityPolicySignatureAlgorithm *symSignatureAlgorithm =
+        &symmetricModule->cryptoModule.signatureAlgorithm;
+    symSignatureAlgorithm->uri = UA_STRING((char*)(uintptr_t)symEncryptionUri);
+    symSignatureAlgorithm->getLocalKeyLength = UA_SymSig_AeadRsaPss_getLocalKeyLength;
+    symSignatureAlgorithm->getRemoteKeyLength = UA_SymSig_AeadRsaPss_getRemoteKeyLength;
+    symSignatureAlgorithm->getRemoteSignatureSize = UA_SymSig_AeadRsaPss_getRemoteSignatureSize;
+    symSignatureAlgorithm->verify = UA_SymSig_AeadRsaPss_verify;
+    symSignatureAlgorithm->sign = UA_SymSig_AeadRsaPss_sign;
+    symSignatureAlgorithm->getLocalSignatureSize = UA_SymSig_AeadRsaPss_getLocalSignatureSize;
+
+    retval = UA_Policy_AeadRsaPss_New_Context(policy, localPrivateKey, cipher, logger);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&policy->localCertificate);
+        return retval;
+    }
+
+    policy->createSigningRequest = createSigningRequest_sp_aeadrsapss;
+    policy->updateCertificateAndPrivateKey = updateCertificateAndPrivateKey_sp_aeadrsapss;
+    policy->clear = UA_Policy_AeadRsaPss_Clear_Context;
+
+    /* Certificate Signing Algorithm */
+    policy->certificateSigningAlgorithm.uri =
+        UA_STRING("http://www.w3.org/2001/04/xmldsig-more#rsa-sha256\0");
+    policy->certificateSigningAlgorithm.verify =
+        (UA_StatusCode (*)(void *, const UA_ByteString *, const UA_ByteString *))UA_CertSig_AeadRsaPss_Verify;
+    policy->certificateSigningAlgorithm.sign =
+        (UA_StatusCode (*)(void *, const UA_ByteString *, UA_ByteString *))UA_CertSig_AeadRsaPss_sign;
+    policy->certificateSigningAlgorithm.getLocalSignatureSize =
+        (size_t (*)(const void *))UA_CertSig_AeadRsaPss_getLocalSignatureSize;
+    policy->certificateSigningAlgorithm.getRemoteSignatureSize =
+        (size_t (*)(const void *))UA_CertSig_AeadRsaPss_getRemoteSignatureSize;
+    policy->certificateSigningAlgorithm.getLocalKeyLength = NULL; // TODO: Write function
+    policy->certificateSigningAlgorithm.getRemoteKeyLength = NULL; // TODO: Write function
+
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_SecurityPolicy_Aes256GcmRsaPss(UA_SecurityPolicy *policy,
+                                  const UA_ByteString localCertificate,
+                                  const UA_ByteString localPrivateKey,
+                                  const UA_Logger *logger) {
+    return UA_SecurityPolicy_AeadRsaPss(policy,
+        "http://open62541.org/UA/SecurityPolicy#Aes256Gcm_RsaPss",
+        "http://www.w3.org/2009/xmlenc11#aes256-gcm", EVP_aes_256_gcm(),
+        localCertificate, localPrivateKey, logger);
+}
+
+UA_StatusCode
+UA_SecurityPolicy_ChaCha20Poly1305RsaPss(UA_SecurityPolicy *policy,
+                                         const UA_ByteString localCertificate,
+                                         const UA_ByteString localPrivateKey,
+                                         const UA_Logger *logger) {
+    return UA_SecurityPolicy_AeadRsaPss(policy,
+        "http://open62541.org/UA/SecurityPolicy#ChaCha20Poly1305_RsaPss",
+        "http://open62541.org/UA/security/chacha20-poly1305", EVP_chacha20_poly1305(),
+        localCertificate, localPrivateKey, logger);
+}
+
+#endif
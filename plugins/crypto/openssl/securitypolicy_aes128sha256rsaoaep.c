@@ -36,11 +36,8 @@ typedef struct {
 } Policy_Context_Aes128Sha256RsaOaep;
 
 typedef struct {
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    UA_OpenSSL_SymmetricContext sym;
     UA_ByteString localSymIv;
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
     UA_ByteString remoteSymIv;
 
     Policy_Context_Aes128Sha256RsaOaep *policyContext;
@@ -209,11 +206,8 @@ UA_ChannelModule_Aes128Sha256RsaOaep_New_Context(const UA_SecurityPolicy *securi
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    UA_ByteString_init(&context->localSymSigningKey);
-    UA_ByteString_init(&context->localSymEncryptingKey);
+    memset(&context->sym, 0, sizeof(UA_OpenSSL_SymmetricContext));
     UA_ByteString_init(&context->localSymIv);
-    UA_ByteString_init(&context->remoteSymSigningKey);
-    UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
 
     UA_StatusCode retval =
@@ -252,11 +246,8 @@ UA_ChannelModule_Aes128Sha256RsaOaep_Delete_Context(void *channelContext) {
             (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
         X509_free(cc->remoteCertificateX509);
         UA_ByteString_clear(&cc->remoteCertificate);
-        UA_ByteString_clear(&cc->localSymSigningKey);
-        UA_ByteString_clear(&cc->localSymEncryptingKey);
+        UA_OpenSSL_SymmetricContext_clear(&cc->sym);
         UA_ByteString_clear(&cc->localSymIv);
-        UA_ByteString_clear(&cc->remoteSymSigningKey);
-        UA_ByteString_clear(&cc->remoteSymEncryptingKey);
         UA_ByteString_clear(&cc->remoteSymIv);
 
         UA_LOG_INFO(
@@ -416,8 +407,7 @@ UA_ChannelModule_Aes128Sha256RsaOaep_setLocalSymSigningKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_MacCtx_setKey(&cc->sym.signCtx, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -427,8 +417,7 @@ UA_ChannelM_Aes128Sha256RsaOaep_setLocalSymEncryptingKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_CipherCtx_setKey(&cc->sym.encryptCtx, EVP_aes_128_cbc(), key, true);
 }
 
 static UA_StatusCode
@@ -466,8 +455,7 @@ UA_ChannelM_Aes128Sha256RsaOaep_setRemoteSymSigningKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_MacCtx_setKey(&cc->sym.verifyCtx, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -477,8 +465,7 @@ UA_ChannelM_Aes128Sha256RsaOaep_setRemoteSymEncryptingKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_CipherCtx_setKey(&cc->sym.decryptCtx, EVP_aes_128_cbc(), key, false);
 }
 
 static UA_StatusCode
@@ -527,7 +514,7 @@ UA_SymSig_Aes128Sha256RsaOaep_verify(void *channelContext, const UA_ByteString *
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature);
+    return UA_OpenSSL_MacCtx_verify(cc->sym.verifyCtx, message, signature);
 }
 
 static UA_StatusCode
@@ -539,7 +526,7 @@ UA_SymSig_Aes128Sha256RsaOaep_sign(void *channelContext, const UA_ByteString *me
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_MacCtx_sign(cc->sym.signCtx, message, signature);
 }
 
 static size_t
@@ -553,8 +540,7 @@ UA_SymEn_Aes128Sha256RsaOaep_decrypt(void *channelContext, UA_ByteString *data)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_AES_128_CBC_Decrypt(&cc->remoteSymIv, &cc->remoteSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_CipherCtx_crypt(cc->sym.decryptCtx, &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -564,8 +550,7 @@ UA_SymEn_Aes128Sha256RsaOaep_encrypt(void *channelContext, UA_ByteString *data)
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_AES_128_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_CipherCtx_crypt(cc->sym.encryptCtx, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
@@ -36,11 +36,8 @@ typedef struct {
 } Policy_Context_Aes256Sha256RsaPss;
 
 typedef struct {
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    UA_OpenSSL_SymmetricContext sym;
     UA_ByteString localSymIv;
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
     UA_ByteString remoteSymIv;
 
     Policy_Context_Aes256Sha256RsaPss *policyContext;
@@ -206,11 +203,8 @@ UA_ChannelModule_Aes256Sha256RsaPss_New_Context(const UA_SecurityPolicy *securit
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    UA_ByteString_init(&context->localSymSigningKey);
-    UA_ByteString_init(&context->localSymEncryptingKey);
+    memset(&context->sym, 0, sizeof(UA_OpenSSL_SymmetricContext));
     UA_ByteString_init(&context->localSymIv);
-    UA_ByteString_init(&context->remoteSymSigningKey);
-    UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
 
     UA_StatusCode retval =
@@ -249,11 +243,8 @@ UA_ChannelModule_Aes256Sha256RsaPss_Delete_Context(void *channelContext) {
             (Channel_Context_Aes256Sha256RsaPss *)channelContext;
         X509_free(cc->remoteCertificateX509);
         UA_ByteString_clear(&cc->remoteCertificate);
-        UA_ByteString_clear(&cc->localSymSigningKey);
-        UA_ByteString_clear(&cc->localSymEncryptingKey);
+        UA_OpenSSL_SymmetricContext_clear(&cc->sym);
         UA_ByteString_clear(&cc->localSymIv);
-        UA_ByteString_clear(&cc->remoteSymSigningKey);
-        UA_ByteString_clear(&cc->remoteSymEncryptingKey);
         UA_ByteString_clear(&cc->remoteSymIv);
 
         UA_LOG_INFO(
@@ -462,8 +453,7 @@ UA_ChannelModule_Aes256Sha256RsaPss_setLocalSymSigningKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_MacCtx_setKey(&cc->sym.signCtx, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -473,8 +463,7 @@ UA_ChannelM_Aes256Sha256RsaPss_setLocalSymEncryptingKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_CipherCtx_setKey(&cc->sym.encryptCtx, EVP_aes_256_cbc(), key, true);
 }
 
 static UA_StatusCode
@@ -512,8 +501,7 @@ UA_ChannelM_Aes256Sha256RsaPss_setRemoteSymSigningKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_MacCtx_setKey(&cc->sym.verifyCtx, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -523,8 +511,7 @@ UA_ChannelM_Aes256Sha256RsaPss_setRemoteSymEncryptingKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_CipherCtx_setKey(&cc->sym.decryptCtx, EVP_aes_256_cbc(), key, false);
 }
 
 static UA_StatusCode
@@ -575,7 +562,7 @@ UA_SymSig_Aes256Sha256RsaPss_verify(void *channelContext, const UA_ByteString *m
 
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature);
+    return UA_OpenSSL_MacCtx_verify(cc->sym.verifyCtx, message, signature);
 }
 
 static UA_StatusCode
@@ -587,7 +574,7 @@ UA_SymSig_Aes256Sha256RsaPss_sign(void *channelContext, const UA_ByteString *mes
 
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_MacCtx_sign(cc->sym.signCtx, message, signature);
 }
 
 static size_t
@@ -601,8 +588,7 @@ UA_SymEn_Aes256Sha256RsaPss_decrypt(void *channelContext, UA_ByteString *data) {
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    return UA_OpenSSL_AES_256_CBC_Decrypt(&cc->remoteSymIv, &cc->remoteSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_CipherCtx_crypt(cc->sym.decryptCtx, &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -612,8 +598,7 @@ UA_SymEn_Aes256Sha256RsaPss_encrypt(void *channelContext, UA_ByteString *data) {
 
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    return UA_OpenSSL_AES_256_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_CipherCtx_crypt(cc->sym.encryptCtx, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
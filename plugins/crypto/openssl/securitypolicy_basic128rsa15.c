@@ -32,11 +32,8 @@ typedef struct {
 } Policy_Context_Basic128Rsa15;
 
 typedef struct {
-    UA_ByteString             localSymSigningKey;
-    UA_ByteString             localSymEncryptingKey;
+    UA_OpenSSL_SymmetricContext sym;
     UA_ByteString             localSymIv;
-    UA_ByteString             remoteSymSigningKey;
-    UA_ByteString             remoteSymEncryptingKey;
     UA_ByteString             remoteSymIv;
 
     Policy_Context_Basic128Rsa15 * policyContext;
@@ -201,11 +198,8 @@ UA_ChannelModule_Basic128Rsa15_New_Context (const UA_SecurityPolicy * securityPo
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    UA_ByteString_init(&context->localSymSigningKey);
-    UA_ByteString_init(&context->localSymEncryptingKey);
+    memset(&context->sym, 0, sizeof(UA_OpenSSL_SymmetricContext));
     UA_ByteString_init(&context->localSymIv);
-    UA_ByteString_init(&context->remoteSymSigningKey);
-    UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
 
     UA_StatusCode retval = UA_copyCertificate (&context->remoteCertificate,
@@ -244,11 +238,8 @@ UA_ChannelModule_Basic128Rsa15_Delete_Context (void * channelContext) {
                                               channelContext;
         X509_free (cc->remoteCertificateX509);
         UA_ByteString_clear (&cc->remoteCertificate);
-        UA_ByteString_clear (&cc->localSymSigningKey);
-        UA_ByteString_clear (&cc->localSymEncryptingKey);
+        UA_OpenSSL_SymmetricContext_clear(&cc->sym);
         UA_ByteString_clear (&cc->localSymIv);
-        UA_ByteString_clear (&cc->remoteSymSigningKey);
-        UA_ByteString_clear (&cc->remoteSymEncryptingKey);
         UA_ByteString_clear (&cc->remoteSymIv);
         UA_LOG_INFO (cc->policyContext->logger,
                  UA_LOGCATEGORY_SECURITYPOLICY,
@@ -266,8 +257,7 @@ UA_ChannelModule_Basic128Rsa15_setLocalSymSigningKey (void *                chan
     }
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_MacCtx_setKey(&cc->sym.signCtx, EVP_sha1(), key);
 }
 
 static UA_StatusCode
@@ -278,8 +268,7 @@ UA_ChannelModule_Basic128Rsa15_setLocalSymEncryptingKey (void *                c
     }
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_CipherCtx_setKey(&cc->sym.encryptCtx, EVP_aes_128_cbc(), key, true);
 }
 
 static UA_StatusCode
@@ -302,8 +291,7 @@ UA_ChannelModule_Basic128Rsa15_setRemoteSymSigningKey (void *                cha
     }
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_MacCtx_setKey(&cc->sym.verifyCtx, EVP_sha1(), key);
 }
 
 static UA_StatusCode
@@ -314,8 +302,7 @@ UA_ChannelModule_Basic128Rsa15_setRemoteSymEncryptingKey (void *
     }
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_CipherCtx_setKey(&cc->sym.decryptCtx, EVP_aes_128_cbc(), key, false);
 }
 
 static UA_StatusCode
@@ -534,7 +521,7 @@ UA_SymEn_Basic128Rsa15_Encrypt (void *channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    return UA_OpenSSL_AES_128_CBC_Encrypt (&cc->localSymIv, &cc->localSymEncryptingKey, data);
+    return UA_OpenSSL_CipherCtx_crypt(cc->sym.encryptCtx, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
@@ -543,7 +530,7 @@ UA_SymEn_Basic128Rsa15_Decrypt (void *                    channelContext,
     if(channelContext == NULL || data == NULL)
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    return UA_OpenSSL_AES_128_CBC_Decrypt (&cc->remoteSymIv, &cc->remoteSymEncryptingKey, data);
+    return UA_OpenSSL_CipherCtx_crypt(cc->sym.decryptCtx, &cc->remoteSymIv, data);
 }
 
 static size_t
@@ -564,9 +551,7 @@ UA_SymSig_Basic128Rsa15_Verify (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Verify (message,
-                                        &cc->remoteSymSigningKey,
-                                        signature);
+    return UA_OpenSSL_MacCtx_verify(cc->sym.verifyCtx, message, signature);
 }
 
 static UA_StatusCode
@@ -577,7 +562,7 @@ UA_SymSig_Basic128Rsa15_Sign (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Sign (message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_MacCtx_sign(cc->sym.signCtx, message, signature);
 }
 
 /* the main entry of Basic128Rsa15 */
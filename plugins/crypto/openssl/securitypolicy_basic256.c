@@ -30,11 +30,8 @@ typedef struct {
 } Policy_Context_Basic256;
 
 typedef struct {
-    UA_ByteString             localSymSigningKey;
-    UA_ByteString             localSymEncryptingKey;
+    UA_OpenSSL_SymmetricContext sym;
     UA_ByteString             localSymIv;
-    UA_ByteString             remoteSymSigningKey;
-    UA_ByteString             remoteSymEncryptingKey;
     UA_ByteString             remoteSymIv;
 
     Policy_Context_Basic256 * policyContext;
@@ -199,11 +196,8 @@ UA_ChannelModule_Basic256_New_Context (const UA_SecurityPolicy * securityPolicy,
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    UA_ByteString_init(&context->localSymSigningKey);
-    UA_ByteString_init(&context->localSymEncryptingKey);
+    memset(&context->sym, 0, sizeof(UA_OpenSSL_SymmetricContext));
     UA_ByteString_init(&context->localSymIv);
-    UA_ByteString_init(&context->remoteSymSigningKey);
-    UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
 
     UA_StatusCode retval = UA_copyCertificate (&context->remoteCertificate,
@@ -242,11 +236,8 @@ UA_ChannelModule_Basic256_Delete_Context (void * channelContext) {
                                            channelContext;
         X509_free (cc->remoteCertificateX509);
         UA_ByteString_clear (&cc->remoteCertificate);
-        UA_ByteString_clear (&cc->localSymSigningKey);
-        UA_ByteString_clear (&cc->localSymEncryptingKey);
+        UA_OpenSSL_SymmetricContext_clear(&cc->sym);
         UA_ByteString_clear (&cc->localSymIv);
-        UA_ByteString_clear (&cc->remoteSymSigningKey);
-        UA_ByteString_clear (&cc->remoteSymEncryptingKey);
         UA_ByteString_clear (&cc->remoteSymIv);
         UA_LOG_INFO (cc->policyContext->logger,
                  UA_LOGCATEGORY_SECURITYPOLICY,
@@ -292,8 +283,7 @@ UA_ChannelModule_Basic256_setLocalSymSigningKey (void *                channelCo
     }
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_MacCtx_setKey(&cc->sym.signCtx, EVP_sha1(), key);
 }
 
 static UA_StatusCode
@@ -304,8 +294,7 @@ UA_ChannelModule_Basic256_setLocalSymEncryptingKey (void *                channe
     }
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_CipherCtx_setKey(&cc->sym.encryptCtx, EVP_aes_256_cbc(), key, true);
 }
 
 static UA_StatusCode
@@ -328,8 +317,7 @@ UA_ChannelModule_Basic256_setRemoteSymSigningKey (void *                channelC
     }
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_MacCtx_setKey(&cc->sym.verifyCtx, EVP_sha1(), key);
 }
 
 static UA_StatusCode
@@ -340,8 +328,7 @@ UA_ChannelModule_Basic256_setRemoteSymEncryptingKey (void *                chann
     }
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_CipherCtx_setKey(&cc->sym.decryptCtx, EVP_aes_256_cbc(), key, false);
 }
 
 static UA_StatusCode
@@ -535,7 +522,7 @@ UA_SymEn_Basic256_Encrypt (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Encrypt (&cc->localSymIv, &cc->localSymEncryptingKey, data);
+    return UA_OpenSSL_CipherCtx_crypt(cc->sym.encryptCtx, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
@@ -544,7 +531,7 @@ UA_SymEn_Basic256_Decrypt (void *                    channelContext,
     if(channelContext == NULL || data == NULL)
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Decrypt (&cc->remoteSymIv, &cc->remoteSymEncryptingKey, data);
+    return UA_OpenSSL_CipherCtx_crypt(cc->sym.decryptCtx, &cc->remoteSymIv, data);
 }
 
 static size_t
@@ -566,9 +553,7 @@ UA_SymSig_Basic256_Verify (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Verify (message,
-                                        &cc->remoteSymSigningKey,
-                                        signature);
+    return UA_OpenSSL_MacCtx_verify(cc->sym.verifyCtx, message, signature);
 }
 
 static UA_StatusCode
@@ -579,7 +564,7 @@ UA_SymSig_Basic256_Sign (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Sign (message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_MacCtx_sign(cc->sym.signCtx, message, signature);
 }
 
 /* the main entry of Basic256 */
@@ -32,6 +32,9 @@ modification history
 #include <openssl/rand.h>
 #include <openssl/ecdsa.h>
 #include <openssl/kdf.h>
+#include <openssl/crypto.h>
+
+#include <limits.h>
 
 #if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
 #include <openssl/core_names.h>
@@ -641,199 +644,289 @@ UA_Openssl_RSA_PSS_SHA256_Sign (const UA_ByteString * message,
                                         RSA_PKCS1_PSS_PADDING, outSignature);
 }
 
+/* Symmetric cipher and MAC contexts. The key is set up once. For every chunk,
+ * only the IV is reset and the MAC state is restored from the keyed state. */
+
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Verify (const UA_ByteString *     message,
-                               const UA_ByteString *     key,
-                               const UA_ByteString *     signature
-                              ) {
-    unsigned char buf[SHA256_DIGEST_LENGTH] = {0};
-    UA_ByteString mac = {SHA256_DIGEST_LENGTH, buf};
-
-    if (HMAC (EVP_sha256(), key->data, (int) key->length, message->data, message->length,
-              mac.data, (unsigned int *) &mac.length) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    if (UA_ByteString_equal (signature, &mac)) {
-        return UA_STATUSCODE_GOOD;
-    }
-    else {
+UA_OpenSSL_CipherCtx_setKey(EVP_CIPHER_CTX **ctx, const EVP_CIPHER *cipherAlg,
+                            const UA_ByteString *key, UA_Boolean encrypt) {
+    if(key->length != (size_t)EVP_CIPHER_key_length(cipherAlg))
         return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* Reuse the context when the keys are renewed */
+    if(*ctx == NULL) {
+        *ctx = EVP_CIPHER_CTX_new();
+        if(*ctx == NULL)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
     }
+
+    /* The IV is set for every chunk */
+    int opensslRet = EVP_CipherInit_ex(*ctx, cipherAlg, NULL, key->data,
+                                       NULL, encrypt ? 1 : 0);
+    if(opensslRet != 1)
+        goto errout;
+
+    /* Disable padding. Padding is done in the stack before calling encryption.
+     * Also EVP_DecryptFinal() would return an error if padding is enabled and
+     * the final block is not correctly formatted. */
+    opensslRet = EVP_CIPHER_CTX_set_padding(*ctx, 0);
+    if(opensslRet != 1)
+        goto errout;
+    return UA_STATUSCODE_GOOD;
+
+ errout:
+    EVP_CIPHER_CTX_free(*ctx);
+    *ctx = NULL;
+    return UA_STATUSCODE_BADINTERNALERROR;
 }
 
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Sign (const UA_ByteString *     message,
-                             const UA_ByteString *     key,
-                             UA_ByteString *           signature
-                             ) {
-    if (HMAC (EVP_sha256(), key->data, (int) key->length, message->data,
-              message->length,
-              signature->data, (unsigned int *) &(signature->length)) == NULL) {
+UA_OpenSSL_CipherCtx_crypt(EVP_CIPHER_CTX *ctx, const UA_ByteString *iv,
+                           UA_ByteString *data /* [in/out]*/) {
+    /* No key set */
+    if(ctx == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    return UA_STATUSCODE_GOOD;
-}
 
-static UA_StatusCode
-UA_OpenSSL_Decrypt (const UA_ByteString * iv,
-                    const UA_ByteString * key,
-                    const EVP_CIPHER *    cipherAlg,
-                    UA_ByteString *       data  /* [in/out]*/) {
-    UA_ByteString    ivCopy    = {0, NULL};
-    UA_ByteString    cipherTxt = {0, NULL};
-    EVP_CIPHER_CTX * ctx       = NULL;
-    UA_StatusCode    ret;
-    int              opensslRet;
-    int              outLen;
-    int              tmpLen;
+    /* Ensure that we have a multiple of the block size */
+    if(data->length % (size_t)EVP_CIPHER_CTX_block_size(ctx) != 0 ||
+       data->length > INT_MAX ||
+       iv->length != (size_t)EVP_CIPHER_CTX_iv_length(ctx))
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* copy the IV because the AES_cbc_encrypt function overwrites it. */
+    /* Reset to the IV. The key schedule and the direction are kept. */
+    int opensslRet = EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv->data, -1);
+    if(opensslRet != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-    ret = UA_ByteString_copy (iv, &ivCopy);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
+    /* Process the data in place */
+    int outLen = 0;
+    int tmpLen = 0;
+    opensslRet = EVP_CipherUpdate(ctx, data->data, &outLen,
+                                  data->data, (int)data->length);
+    if(opensslRet != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-    ret = UA_ByteString_copy (data, &cipherTxt);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
+    /* Final does nothing as padding is disabled */
+    opensslRet = EVP_CipherFinal_ex(ctx, data->data + outLen, &tmpLen);
+    if(opensslRet != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    data->length = (size_t)(outLen + tmpLen);
+    return UA_STATUSCODE_GOOD;
+}
 
-    ctx = EVP_CIPHER_CTX_new ();
-    if (ctx == NULL) {
-        ret = UA_STATUSCODE_BADOUTOFMEMORY;
-        goto errout;
+UA_StatusCode
+UA_OpenSSL_MacCtx_setKey(UA_OpenSSL_MAC_CTX **ctx, const EVP_MD *md,
+                         const UA_ByteString *key) {
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L) && !defined(LIBRESSL_VERSION_NUMBER)
+    if(*ctx == NULL) {
+        EVP_MAC *mac = EVP_MAC_fetch(NULL, OSSL_MAC_NAME_HMAC, NULL);
+        if(mac == NULL)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        *ctx = EVP_MAC_CTX_new(mac);
+        EVP_MAC_free(mac); /* The context keeps a reference */
+        if(*ctx == NULL)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    OSSL_PARAM params[2];
+    params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+                                                 (char *)(uintptr_t)EVP_MD_get0_name(md), 0);
+    params[1] = OSSL_PARAM_construct_end();
+    if(EVP_MAC_init(*ctx, key->data, key->length, params) != 1) {
+        EVP_MAC_CTX_free(*ctx);
+        *ctx = NULL;
+        return UA_STATUSCODE_BADINTERNALERROR;
     }
+#else
+    if(*ctx == NULL) {
+        *ctx = HMAC_CTX_new();
+        if(*ctx == NULL)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    if(HMAC_Init_ex(*ctx, key->data, (int)key->length, md, NULL) != 1) {
+        HMAC_CTX_free(*ctx);
+        *ctx = NULL;
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+#endif
+    return UA_STATUSCODE_GOOD;
+}
 
-    /* call EVP_* to decrypt */
+static UA_StatusCode
+UA_OpenSSL_MacCtx_compute(UA_OpenSSL_MAC_CTX *ctx, const UA_ByteString *message,
+                          unsigned char *out, size_t outSize, size_t *outLen) {
+    /* No key set */
+    if(ctx == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-    opensslRet = EVP_DecryptInit_ex (ctx, cipherAlg, NULL, key->data, ivCopy.data);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    /* EVP_DecryptFinal() will return an error code if padding is enabled
-     * and the final block is not correctly formatted.
-     */
-    EVP_CIPHER_CTX_set_padding (ctx, 0);
-    opensslRet = EVP_DecryptUpdate (ctx, data->data, &outLen,
-                                    cipherTxt.data, (int) cipherTxt.length);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    opensslRet = EVP_DecryptFinal_ex (ctx, data->data + outLen, &tmpLen);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    outLen += tmpLen;
-    data->length = (size_t) outLen;
-    ret = UA_STATUSCODE_GOOD;
+    /* Restart from the keyed state */
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L) && !defined(LIBRESSL_VERSION_NUMBER)
+    if(EVP_MAC_init(ctx, NULL, 0, NULL) != 1 ||
+       EVP_MAC_update(ctx, message->data, message->length) != 1 ||
+       EVP_MAC_final(ctx, out, outLen, outSize) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+#else
+    unsigned int len = 0;
+    if(outSize < HMAC_size(ctx) ||
+       HMAC_Init_ex(ctx, NULL, 0, NULL, NULL) != 1 ||
+       HMAC_Update(ctx, message->data, message->length) != 1 ||
+       HMAC_Final(ctx, out, &len) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    *outLen = len;
+#endif
+    return UA_STATUSCODE_GOOD;
+}
 
-errout:
-    UA_ByteString_clear (&ivCopy);
-    UA_ByteString_clear (&cipherTxt);
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
-    }
-    return ret;
+UA_StatusCode
+UA_OpenSSL_MacCtx_sign(UA_OpenSSL_MAC_CTX *ctx, const UA_ByteString *message,
+                       UA_ByteString *signature) {
+    return UA_OpenSSL_MacCtx_compute(ctx, message, signature->data,
+                                     signature->length, &signature->length);
 }
 
-static UA_StatusCode
-UA_OpenSSL_Encrypt (const UA_ByteString * iv,
-                    const UA_ByteString * key,
-                    const EVP_CIPHER *    cipherAlg,
-                    UA_ByteString *       data  /* [in/out]*/
-                    ) {
-
-    UA_ByteString    ivCopy   = {0, NULL};
-    UA_ByteString    plainTxt = {0, NULL};
-    EVP_CIPHER_CTX * ctx      = NULL;
-    UA_StatusCode    ret;
-    int              opensslRet;
-    int              outLen;
-    int              tmpLen;
+UA_StatusCode
+UA_OpenSSL_MacCtx_verify(UA_OpenSSL_MAC_CTX *ctx, const UA_ByteString *message,
+                         const UA_ByteString *signature) {
+    unsigned char buf[EVP_MAX_MD_SIZE];
+    size_t len = 0;
+    UA_StatusCode ret = UA_OpenSSL_MacCtx_compute(ctx, message, buf, sizeof(buf), &len);
+    if(ret != UA_STATUSCODE_GOOD)
+        return ret;
+    if(signature->length != len || CRYPTO_memcmp(signature->data, buf, len) != 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_OpenSSL_SymmetricContext_clear(UA_OpenSSL_SymmetricContext *sc) {
+    EVP_CIPHER_CTX_free(sc->encryptCtx);
+    EVP_CIPHER_CTX_free(sc->decryptCtx);
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L) && !defined(LIBRESSL_VERSION_NUMBER)
+    EVP_MAC_CTX_free(sc->signCtx);
+    EVP_MAC_CTX_free(sc->verifyCtx);
+#else
+    HMAC_CTX_free(sc->signCtx);
+    HMAC_CTX_free(sc->verifyCtx);
+#endif
+    memset(sc, 0, sizeof(UA_OpenSSL_SymmetricContext));
+}
 
-    /* copy the IV because the AES_cbc_encrypt function overwrites it. */
+void
+UA_OpenSSL_AeadCtx_clear(UA_OpenSSL_AeadCtx *ac) {
+    EVP_CIPHER_CTX_free(ac->ctx);
+    memset(ac, 0, sizeof(UA_OpenSSL_AeadCtx));
+}
 
-    ret = UA_ByteString_copy (iv, &ivCopy);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
+UA_StatusCode
+UA_OpenSSL_AeadCtx_setKey(UA_OpenSSL_AeadCtx *ac, const EVP_CIPHER *cipherAlg,
+                          const UA_ByteString *key, UA_Boolean encrypt) {
+    if(key->length != (size_t)EVP_CIPHER_key_length(cipherAlg) ||
+       EVP_CIPHER_iv_length(cipherAlg) != UA_OPENSSL_AEAD_IV_LENGTH)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-    ret = UA_ByteString_copy (data, &plainTxt);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
+    /* Reuse the context when the keys are renewed */
+    if(ac->ctx == NULL) {
+        ac->ctx = EVP_CIPHER_CTX_new();
+        if(ac->ctx == NULL)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    ctx = EVP_CIPHER_CTX_new ();
-    if (ctx == NULL) {
-        ret = UA_STATUSCODE_BADOUTOFMEMORY;
-        goto errout;
+    /* The nonce is set for every chunk */
+    if(EVP_CipherInit_ex(ac->ctx, cipherAlg, NULL, key->data,
+                         NULL, encrypt ? 1 : 0) != 1) {
+        EVP_CIPHER_CTX_free(ac->ctx);
+        ac->ctx = NULL;
+        return UA_STATUSCODE_BADINTERNALERROR;
     }
+    ac->counter = 0;
+    return UA_STATUSCODE_GOOD;
+}
 
-    /* call EVP_* to encrypt */
+UA_StatusCode
+UA_OpenSSL_AeadCtx_setIv(UA_OpenSSL_AeadCtx *ac, const UA_ByteString *iv) {
+    if(iv->length != UA_OPENSSL_AEAD_IV_LENGTH)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    memcpy(ac->iv, iv->data, UA_OPENSSL_AEAD_IV_LENGTH);
+    ac->counter = 0;
+    return UA_STATUSCODE_GOOD;
+}
 
-    opensslRet = EVP_EncryptInit_ex (ctx, cipherAlg, NULL, key->data, ivCopy.data);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
+/* Set the nonce for the next chunk and feed the additional data */
+static UA_StatusCode
+UA_OpenSSL_AeadCtx_begin(UA_OpenSSL_AeadCtx *ac, const UA_ByteString *aad,
+                         const UA_ByteString *data, size_t tagLength) {
+    /* No key set */
+    if(ac->ctx == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* Disable padding. Padding is done in the stack before calling encryption.
-     * Ensure that we have a multiple of the block size */
-    if(data->length % (size_t)EVP_CIPHER_CTX_block_size(ctx)) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    opensslRet = EVP_CIPHER_CTX_set_padding(ctx, 0);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
+    /* A nonce must never be reused with the same key. The SecurityToken has
+     * to be renewed long before the counter wraps around. */
+    if(ac->counter == UA_UINT64_MAX ||
+       aad->length > INT_MAX || data->length > INT_MAX ||
+       tagLength != UA_OPENSSL_AEAD_TAG_LENGTH)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* Encrypt the data */
-    opensslRet = EVP_EncryptUpdate (ctx, data->data, &outLen,
-                                    plainTxt.data, (int) plainTxt.length);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
+    UA_Byte nonce[UA_OPENSSL_AEAD_IV_LENGTH];
+    memcpy(nonce, ac->iv, UA_OPENSSL_AEAD_IV_LENGTH);
+    UA_UInt64 counter = ac->counter++;
+    for(size_t i = 0; i < 8; i++) {
+        nonce[UA_OPENSSL_AEAD_IV_LENGTH - 1 - i] ^= (UA_Byte)(counter & 0xff);
+        counter >>= 8;
     }
 
-    /* Encrypt-final does nothing as padding is disabled */
-    opensslRet = EVP_EncryptFinal_ex(ctx, data->data + outLen, &tmpLen);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    outLen += tmpLen;
-    data->length = (size_t) outLen;
-    ret = UA_STATUSCODE_GOOD;
+    /* Keep the key schedule and the direction */
+    if(EVP_CipherInit_ex(ac->ctx, NULL, NULL, NULL, nonce, -1) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-errout:
-    UA_ByteString_clear (&ivCopy);
-    UA_ByteString_clear (&plainTxt);
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
-    }
-    return ret;
+    /* Authenticate the additional data (no output buffer) */
+    int outLen = 0;
+    if(aad->length > 0 &&
+       EVP_CipherUpdate(ac->ctx, NULL, &outLen, aad->data, (int)aad->length) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Decrypt (const UA_ByteString * iv,
-                                const UA_ByteString * key,
-                                UA_ByteString *       data  /* [in/out]*/
-                                ) {
-    return UA_OpenSSL_Decrypt (iv, key, EVP_aes_256_cbc (), data);
+UA_OpenSSL_AeadCtx_encrypt(UA_OpenSSL_AeadCtx *ac, const UA_ByteString *aad,
+                           UA_ByteString *data /* [in/out]*/, UA_ByteString *tag) {
+    UA_StatusCode res = UA_OpenSSL_AeadCtx_begin(ac, aad, data, tag->length);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Stream cipher, the output has the same length as the input */
+    int outLen = 0;
+    int tmpLen = 0;
+    if(data->length > 0 &&
+       EVP_CipherUpdate(ac->ctx, data->data, &outLen,
+                        data->data, (int)data->length) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    if(EVP_CipherFinal_ex(ac->ctx, data->data + outLen, &tmpLen) != 1 ||
+       EVP_CIPHER_CTX_ctrl(ac->ctx, EVP_CTRL_AEAD_GET_TAG,
+                           (int)tag->length, tag->data) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Encrypt (const UA_ByteString * iv,
-                            const UA_ByteString * key,
-                            UA_ByteString *       data  /* [in/out]*/
-                            ) {
-    return UA_OpenSSL_Encrypt (iv, key, EVP_aes_256_cbc (), data);
+UA_OpenSSL_AeadCtx_decrypt(UA_OpenSSL_AeadCtx *ac, const UA_ByteString *aad,
+                           UA_ByteString *data /* [in/out]*/,
+                           const UA_ByteString *tag) {
+    UA_StatusCode res = UA_OpenSSL_AeadCtx_begin(ac, aad, data, tag->length);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    int outLen = 0;
+    int tmpLen = 0;
+    if(data->length > 0 &&
+       EVP_CipherUpdate(ac->ctx, data->data, &outLen,
+                        data->data, (int)data->length) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* The tag is checked in the final step */
+    if(EVP_CIPHER_CTX_ctrl(ac->ctx, EVP_CTRL_AEAD_SET_TAG, (int)tag->length,
+                           (void*)(uintptr_t)tag->data) != 1 ||
+       EVP_CipherFinal_ex(ac->ctx, data->data + outLen, &tmpLen) != 1)
+        return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
@@ -948,39 +1041,6 @@ UA_Openssl_Random_Key_PSHA1_Derive (const UA_ByteString *     secret,
     return UA_STATUSCODE_GOOD;
 }
 
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Verify (const UA_ByteString *     message,
-                             const UA_ByteString *     key,
-                             const UA_ByteString *     signature
-                             ) {
-    unsigned char buf[SHA1_DIGEST_LENGTH] = {0};
-    UA_ByteString mac = {SHA1_DIGEST_LENGTH, buf};
-
-    if(HMAC (EVP_sha1(), key->data, (int) key->length, message->data, message->length,
-             mac.data, (unsigned int *) &mac.length) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    if (UA_ByteString_equal (signature, &mac)) {
-        return UA_STATUSCODE_GOOD;
-    }
-    else {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-}
-
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Sign (const UA_ByteString *     message,
-                           const UA_ByteString *     key,
-                           UA_ByteString *           signature
-                           ) {
-    if (HMAC (EVP_sha1(), key->data, (int) key->length, message->data,
-              message->length,
-              signature->data, (unsigned int *) &(signature->length)) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    return UA_STATUSCODE_GOOD;
-}
-
 UA_StatusCode
 UA_Openssl_RSA_PKCS1_V15_Decrypt (UA_ByteString *       data,
                                   EVP_PKEY * privateKey) {
@@ -1005,22 +1065,6 @@ UA_Openssl_RSA_PKCS1_V15_Encrypt (UA_ByteString * data,
     return ret;
 }
 
-UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Decrypt (const UA_ByteString * iv,
-                                const UA_ByteString * key,
-                                UA_ByteString *       data  /* [in/out]*/
-                                ) {
-    return UA_OpenSSL_Decrypt (iv, key, EVP_aes_128_cbc (), data);
-}
-
-UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Encrypt (const UA_ByteString * iv,
-                                const UA_ByteString * key,
-                                UA_ByteString *       data  /* [in/out]*/
-                                ) {
-    return UA_OpenSSL_Encrypt (iv, key, EVP_aes_128_cbc (), data);
-}
-
 static UA_StatusCode
 UA_OpenSSL_X509_AddSubjectAttributes(const UA_String* subject, X509_NAME* name) {
     char *subj = (char *)UA_malloc(subject->length + 1);
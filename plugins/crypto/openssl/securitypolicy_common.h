@@ -18,6 +18,7 @@
 
 #include <openssl/x509.h>
 #include <openssl/evp.h>
+#include <openssl/hmac.h>
 
 #define UA_SHA1_LENGTH 20
 
@@ -132,25 +133,78 @@ UA_Openssl_ECDSA_SHA256_Verify (const UA_ByteString * message,
                                 X509 * publicKeyX509,
                                 const UA_ByteString * signature);
 
+/* Cipher and MAC contexts for the symmetric keys of a SecureChannel. They are
+ * keyed once when the keys are set (on every SecurityToken renewal) and reused
+ * for all chunks. */
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L) && !defined(LIBRESSL_VERSION_NUMBER)
+typedef EVP_MAC_CTX UA_OpenSSL_MAC_CTX;
+#else
+typedef HMAC_CTX UA_OpenSSL_MAC_CTX;
+#endif
+
+typedef struct {
+    EVP_CIPHER_CTX *encryptCtx;    /* Local encrypting key */
+    EVP_CIPHER_CTX *decryptCtx;    /* Remote encrypting key */
+    UA_OpenSSL_MAC_CTX *signCtx;   /* Local signing key */
+    UA_OpenSSL_MAC_CTX *verifyCtx; /* Remote signing key */
+} UA_OpenSSL_SymmetricContext;
+
+void
+UA_OpenSSL_SymmetricContext_clear(UA_OpenSSL_SymmetricContext *sc);
+
+/* Creates the context if *ctx is NULL. Otherwise it is re-keyed. */
+UA_StatusCode
+UA_OpenSSL_CipherCtx_setKey(EVP_CIPHER_CTX **ctx, const EVP_CIPHER *cipherAlg,
+                            const UA_ByteString *key, UA_Boolean encrypt);
+
+/* En- or decrypts in place, depending on how the key was set */
+UA_StatusCode
+UA_OpenSSL_CipherCtx_crypt(EVP_CIPHER_CTX *ctx, const UA_ByteString *iv,
+                           UA_ByteString *data /* [in/out]*/);
+
+UA_StatusCode
+UA_OpenSSL_MacCtx_setKey(UA_OpenSSL_MAC_CTX **ctx, const EVP_MD *md,
+                         const UA_ByteString *key);
+
+UA_StatusCode
+UA_OpenSSL_MacCtx_sign(UA_OpenSSL_MAC_CTX *ctx, const UA_ByteString *message,
+                       UA_ByteString *signature);
+
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Verify(const UA_ByteString *message,
-                              const UA_ByteString *key,
-                              const UA_ByteString *signature);
+UA_OpenSSL_MacCtx_verify(UA_OpenSSL_MAC_CTX *ctx, const UA_ByteString *message,
+                         const UA_ByteString *signature);
+
+/* Single-pass authenticated encryption (AES-GCM, ChaCha20-Poly1305) with a
+ * key that is used in one direction only. The nonce of every chunk is the IV
+ * from the key derivation XOR a chunk counter (as in TLS 1.3). Both sides reset
+ * the counter when the key is set and count the chunks in the same order. */
+#define UA_OPENSSL_AEAD_IV_LENGTH 12
+#define UA_OPENSSL_AEAD_TAG_LENGTH 16
+
+typedef struct {
+    EVP_CIPHER_CTX *ctx;
+    UA_Byte iv[UA_OPENSSL_AEAD_IV_LENGTH];
+    UA_UInt64 counter;
+} UA_OpenSSL_AeadCtx;
+
+void
+UA_OpenSSL_AeadCtx_clear(UA_OpenSSL_AeadCtx *ac);
 
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Sign(const UA_ByteString *message,
-                            const UA_ByteString *key,
-                            UA_ByteString *signature);
+UA_OpenSSL_AeadCtx_setKey(UA_OpenSSL_AeadCtx *ac, const EVP_CIPHER *cipherAlg,
+                          const UA_ByteString *key, UA_Boolean encrypt);
 
 UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Decrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
+UA_OpenSSL_AeadCtx_setIv(UA_OpenSSL_AeadCtx *ac, const UA_ByteString *iv);
 
 UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Encrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
+UA_OpenSSL_AeadCtx_encrypt(UA_OpenSSL_AeadCtx *ac, const UA_ByteString *aad,
+                           UA_ByteString *data /* [in/out]*/, UA_ByteString *tag);
+
+UA_StatusCode
+UA_OpenSSL_AeadCtx_decrypt(UA_OpenSSL_AeadCtx *ac, const UA_ByteString *aad,
+                           UA_ByteString *data /* [in/out]*/,
+                           const UA_ByteString *tag);
 
 UA_StatusCode
 UA_OpenSSL_X509_compare(const UA_ByteString *cert, const X509 *b);
@@ -173,16 +227,6 @@ UA_Openssl_Random_Key_PSHA1_Derive(const UA_ByteString *secret,
                                    const UA_ByteString *seed,
                                    UA_ByteString *out);
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Verify(const UA_ByteString *message,
-                            const UA_ByteString *key,
-                            const UA_ByteString *signature);
-
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Sign(const UA_ByteString *message,
-                          const UA_ByteString *key,
-                          UA_ByteString *signature);
-
-UA_StatusCode
 UA_Openssl_RSA_PKCS1_V15_Decrypt(UA_ByteString *data,
                                  EVP_PKEY *privateKey);
 
@@ -191,16 +235,6 @@ UA_Openssl_RSA_PKCS1_V15_Encrypt(UA_ByteString *data,
                                  size_t paddingSize,
                                  X509 *publicX509);
 
-UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Decrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
-
-UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Encrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
-
 UA_StatusCode
 UA_OpenSSL_CreateSigningRequest(EVP_PKEY *localPrivateKey,
                                 EVP_PKEY **csrLocalPrivateKey,
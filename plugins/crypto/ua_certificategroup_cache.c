@@ -0,0 +1,111 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_certificategroup_cache.h"
+
+#ifdef UA_ENABLE_ENCRYPTION
+
+void
+UA_CertificateCache_init(UA_CertificateCache *cache, size_t maxSize,
+                         UA_UInt32 ttlMs) {
+    memset(cache, 0, sizeof(UA_CertificateCache));
+    cache->maxSize = maxSize;
+    cache->ttl = (UA_DateTime)ttlMs * UA_DATETIME_MSEC;
+}
+
+void
+UA_CertificateCache_clear(UA_CertificateCache *cache) {
+    for(size_t i = 0; i < cache->size; i++)
+        UA_ByteString_clear(&cache->entries[i].certificate);
+    UA_free(cache->entries);
+    cache->entries = NULL;
+    cache->size = 0;
+    cache->next = 0;
+}
+
+void
+UA_CertificateCache_invalidate(UA_CertificateCache *cache) {
+    /* The entries with the old version are no longer found and get replaced
+     * over time */
+    cache->trustListVersion++;
+}
+
+static UA_Boolean
+entryValid(const UA_CertificateCache *cache, const UA_CertificateCacheEntry *e,
+           UA_DateTime nowMonotonic, UA_DateTime now) {
+    return (e->trustListVersion == cache->trustListVersion &&
+            e->validUntil > nowMonotonic && e->notAfter > now);
+}
+
+UA_Boolean
+UA_CertificateCache_lookup(UA_CertificateCache *cache,
+                           const UA_ByteString *certificate) {
+    if(cache->size == 0)
+        return false;
+    UA_UInt32 hash = UA_ByteString_hash(0, certificate->data, certificate->length);
+    UA_DateTime nowMonotonic = UA_DateTime_nowMonotonic();
+    UA_DateTime now = UA_DateTime_now();
+    for(size_t i = 0; i < cache->size; i++) {
+        UA_CertificateCacheEntry *e = &cache->entries[i];
+        if(e->hash != hash || !UA_ByteString_equal(&e->certificate, certificate))
+            continue;
+        return entryValid(cache, e, nowMonotonic, now);
+    }
+    return false;
+}
+
+void
+UA_CertificateCache_add(UA_CertificateCache *cache,
+                        const UA_ByteString *certificate,
+                        UA_DateTime notAfter) {
+    if(cache->maxSize == 0)
+        return;
+
+    /* Allocate the entries on first use */
+    if(!cache->entries) {
+        cache->entries = (UA_CertificateCacheEntry*)
+            UA_calloc(cache->maxSize, sizeof(UA_CertificateCacheEntry));
+        if(!cache->entries)
+            return; /* Caching is optional */
+    }
+
+    /* Reuse the entry of the same certificate or an invalid entry. Otherwise
+     * take a new entry or replace the oldest one. */
+    UA_UInt32 hash = UA_ByteString_hash(0, certificate->data, certificate->length);
+    UA_DateTime nowMonotonic = UA_DateTime_nowMonotonic();
+    UA_DateTime now = UA_DateTime_now();
+    UA_CertificateCacheEntry *e = NULL;
+    for(size_t i = 0; i < cache->size; i++) {
+        UA_CertificateCacheEntry *c = &cache->entries[i];
+        if((c->hash == hash && UA_ByteString_equal(&c->certificate, certificate)) ||
+           !entryValid(cache, c, nowMonotonic, now)) {
+            e = c;
+            break;
+        }
+    }
+    if(!e) {
+        if(cache->size < cache->maxSize) {
+            e = &cache->entries[cache->size++];
+        } else {
+            e = &cache->entries[cache->next];
+            cache->next = (cache->next + 1) % cache->maxSize;
+        }
+    }
+
+    /* Set the entry */
+    if(!UA_ByteString_equal(&e->certificate, certificate)) {
+        UA_ByteString_clear(&e->certificate);
+        if(UA_ByteString_copy(certificate, &e->certificate) != UA_STATUSCODE_GOOD) {
+            e->validUntil = 0; /* Mark as invalid */
+            return;
+        }
+    }
+    e->hash = hash;
+    e->trustListVersion = cache->trustListVersion;
+    e->validUntil = nowMonotonic + cache->ttl;
+    e->notAfter = notAfter;
+}
+
+#endif /* UA_ENABLE_ENCRYPTION */
@@ -0,0 +1,81 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_CERTIFICATEGROUP_CACHE_H_
+#define UA_CERTIFICATEGROUP_CACHE_H_
+
+#include <open62541/util.h>
+
+#ifdef UA_ENABLE_ENCRYPTION
+
+_UA_BEGIN_DECLS
+
+/* Cache for successful certificate verifications in a CertificateGroup.
+ *
+ * Every OPN with asymmetric security and every X509 UserIdentityToken is
+ * verified against the trust list. The full verification builds the chain and
+ * checks all signatures and CRLs. When many clients (re)connect at once, the
+ * same certificates are verified over and over again.
+ *
+ * Only positive results are cached. The entries are keyed on the exact
+ * certificate (including an attached chain) and the version of the trust
+ * list. Every change to the trust list (including CRLs) increases the version
+ * and thereby invalidates all entries. In addition, an entry expires after the
+ * time-to-live or when the certificate expires. The TTL bounds how long a
+ * change that is not visible in the trust list (e.g. an expired issuer) can
+ * go unnoticed.
+ *
+ * The cache has a fixed maximum number of entries. If full, the oldest entry
+ * is replaced. */
+
+#define UA_CERTIFICATECACHE_DEFAULTSIZE 256
+#define UA_CERTIFICATECACHE_DEFAULTTTL 60000 /* ms */
+
+typedef struct {
+    UA_ByteString certificate; /* Exact match */
+    UA_UInt32 hash;
+    UA_UInt32 trustListVersion;
+    UA_DateTime validUntil;    /* Monotonic time */
+    UA_DateTime notAfter;      /* Expiry of the certificate (UtcTime) */
+} UA_CertificateCacheEntry;
+
+typedef struct {
+    UA_UInt32 trustListVersion;
+    UA_DateTime ttl;
+    size_t maxSize; /* Zero disables the cache */
+    size_t size;
+    size_t next;    /* Ring buffer position of the oldest entry */
+    UA_CertificateCacheEntry *entries;
+} UA_CertificateCache;
+
+void
+UA_CertificateCache_init(UA_CertificateCache *cache, size_t maxSize,
+                         UA_UInt32 ttlMs);
+
+void
+UA_CertificateCache_clear(UA_CertificateCache *cache);
+
+/* Call whenever the trust list or the CRLs change */
+void
+UA_CertificateCache_invalidate(UA_CertificateCache *cache);
+
+/* Returns true if the certificate was verified successfully before with the
+ * current trust list */
+UA_Boolean
+UA_CertificateCache_lookup(UA_CertificateCache *cache,
+                           const UA_ByteString *certificate);
+
+/* Remember a successful verification. The notAfter (UtcTime) of the
+ * certificate limits the lifetime of the entry. */
+void
+UA_CertificateCache_add(UA_CertificateCache *cache,
+                        const UA_ByteString *certificate,
+                        UA_DateTime notAfter);
+
+_UA_END_DECLS
+
+#endif /* UA_ENABLE_ENCRYPTION */
+
+#endif /* UA_CERTIFICATEGROUP_CACHE_H_ */
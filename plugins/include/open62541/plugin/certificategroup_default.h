@@ -31,6 +31,15 @@ UA_CertificateGroup_AcceptAll(UA_CertificateGroup *certGroup);
  * 0:max-rejected-listsize [uint32]
  *    The maximum number of certificate files that can be stored in the rejected list.
  *    (default: 100).
+ *
+ * 0:maxVerificationCacheSize [uint32]
+ *    The maximum number of successful certificate verifications that are
+ *    cached. Every change of the trust list invalidates the cache. Zero
+ *    disables the cache. (default: 256).
+ *
+ * 0:verificationCacheTtl [uint32]
+ *    The time in milliseconds after which a cached verification is repeated.
+ *    (default: 60000).
  */
 UA_EXPORT UA_StatusCode
 UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
@@ -57,6 +66,15 @@ UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
  *    The maximum number of certificate files that can be stored in the rejected list.
  *    (default: 100).
  *
+ * 0:maxVerificationCacheSize [uint32]
+ *    The maximum number of successful certificate verifications that are
+ *    cached. Every change of the trust list invalidates the cache. Zero
+ *    disables the cache. (default: 256).
+ *
+ * 0:verificationCacheTtl [uint32]
+ *    The time in milliseconds after which a cached verification is repeated.
+ *    (default: 60000).
+ *
  * **PKI folder structure**
  *
  * pki
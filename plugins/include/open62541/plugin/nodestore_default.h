@@ -18,6 +18,40 @@ _UA_BEGIN_DECLS
 UA_EXPORT UA_StatusCode
 UA_Nodestore_HashMap(UA_Nodestore *ns);
 
+/* Replace the local reference targets of all nodes with direct pointers to the
+ * target nodes. Following a reference (Browse, TranslateBrowsePathsToNodeIds,
+ * ...) then no longer requires a hash lookup. References added afterwards are
+ * not resolved until the next call.
+ *
+ * Nodes that are removed or replaced while direct pointers to them exist are
+ * kept as tombstones. The attributes and references of a tombstone are freed,
+ * but the allocation keeps the size of the original node. Pointers to
+ * tombstones are resolved via their NodeId. Tombstones are freed in batches
+ * once the nodes pointing to them are removed or replaced, at the latest with
+ * the next call. Call this only while no node is retrieved from the Nodestore,
+ * e.g. after the information model was loaded or between iterations of the
+ * server main loop. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_HashMap_resolveReferences(UA_Nodestore *ns);
+
+#if UA_MULTITHREADING >= 100
+/* Variant of the HashMap Nodestore for servers where many threads read nodes
+ * concurrently. Lookups do not take a lock. They find the node with atomic
+ * loads and pin it with an atomic reference counter. Writers are serialized
+ * internally. Replaced/removed nodes and tables are reclaimed only once all
+ * readers that could still see them have left (epoch-based reclamation).
+ *
+ * Edits are copy-on-write: getEditNode returns a copy that replaces the
+ * original atomically in releaseNode. Nested edits of the same node share the
+ * copy. Every releaseNode of an edit publishes the changes made so far. Until
+ * then, getNode returns the previous version (also to the editing thread). An
+ * open edit wins over a concurrent update: replaceNode fails with
+ * BadInternalError while the node is being edited. If the node is removed
+ * while an edit is open, the edit is discarded on release. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_HashMapConcurrent(UA_Nodestore *ns);
+#endif
+
 /* The ZipTree Nodestore holds all nodes in RAM in a tree structure. The lookup
  * time is about O(log n). Adding/removing nodes does not require resizing of
  * the underlying array with the linear overhead.
@@ -27,6 +61,43 @@ UA_Nodestore_HashMap(UA_Nodestore *ns);
 UA_EXPORT UA_StatusCode
 UA_Nodestore_ZipTree(UA_Nodestore *ns);
 
+/* See UA_Nodestore_HashMap_resolveReferences */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_ZipTree_resolveReferences(UA_Nodestore *ns);
+
+/* The Image Nodestore serves the nodes from a prebuilt binary image of an
+ * address space. Startup does not depend on the size of the information model.
+ * Only the ReferenceTypes are decoded right away. All other nodes are decoded
+ * when they are first accessed. Changes are kept in a writable overlay in RAM.
+ *
+ * The image is created with UA_Nodestore_saveImage from a fully initialized
+ * Nodestore, e.g. at build time after ns0 and the companion specifications were
+ * loaded into a server. The server recognizes a Nodestore that already
+ * contains ns0 and only attaches the DataSources and method callbacks of ns0.
+ * Contexts, callbacks, value backends and the namespace array are not part of
+ * the image. Register the namespaces of the image in the same order before the
+ * nodes are used. Values from DataSources are not saved. The image is not
+ * portable between platforms with a different byte order.
+ *
+ * The image memory is not copied and must outlive the Nodestore. The custom
+ * types are used to decode values and can be NULL. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_Image(UA_Nodestore *ns, const UA_ByteString *image,
+                   const UA_DataTypeArray *customTypes);
+
+#ifdef UA_ARCHITECTURE_POSIX
+/* Memory-map the image file read-only and create an Image Nodestore. The
+ * mapping is released when the Nodestore is cleared. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_ImageFile(UA_Nodestore *ns, const char *path,
+                       const UA_DataTypeArray *customTypes);
+#endif
+
+/* Serialize all nodes of the Nodestore into an image for UA_Nodestore_Image.
+ * The image is allocated and has to be freed with UA_ByteString_clear. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_saveImage(UA_Nodestore *ns, UA_ByteString *image);
+
 _UA_END_DECLS
 
 #endif /* UA_NODESTORE_DEFAULT_H_ */
@@ -58,6 +58,23 @@ UA_SecurityPolicy_EccNistP256(UA_SecurityPolicy *policy,
                             const UA_ByteString localPrivateKey,
                             const UA_Logger *logger);
 
+#if defined(UA_ENABLE_ENCRYPTION_OPENSSL)
+/* Aes256_Sha256_RsaPss for the OPN handshake with single-pass authenticated
+ * encryption (AEAD) of the symmetric chunks. These are not (yet) standardized
+ * and use open62541-specific PolicyUris. */
+UA_EXPORT UA_StatusCode
+UA_SecurityPolicy_Aes256GcmRsaPss(UA_SecurityPolicy *policy,
+                                  const UA_ByteString localCertificate,
+                                  const UA_ByteString localPrivateKey,
+                                  const UA_Logger *logger);
+
+UA_EXPORT UA_StatusCode
+UA_SecurityPolicy_ChaCha20Poly1305RsaPss(UA_SecurityPolicy *policy,
+                                         const UA_ByteString localCertificate,
+                                         const UA_ByteString localPrivateKey,
+                                         const UA_Logger *logger);
+#endif
+
 #if defined(__linux__) || defined(UA_ARCHITECTURE_WIN32)
 UA_EXPORT UA_StatusCode
 UA_SecurityPolicy_Filestore(UA_SecurityPolicy *policy,
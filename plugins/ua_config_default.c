@@ -515,6 +515,9 @@ setDefaultConfig(UA_ServerConfig *conf, UA_UInt16 portNumber) {
 #if UA_MULTITHREADING >= 100
     conf->maxAsyncOperationQueueSize = 0;
     conf->asyncOperationTimeout = 120000; /* Async Operation Timeout in ms (2 minutes) */
+    conf->serviceWorkers = 0; /* Process the services in the EventLoop thread */
+    conf->parallelOperationsThreshold = 0; /* Execute the operations in order */
+    conf->concurrentReadServices = false; /* Read and Browse take the server lock */
 #endif
 
 #ifdef UA_ENABLE_PUBSUB
@@ -945,6 +945,8 @@ parseJSONConfig(UA_ServerConfig *config, UA_ByteString json_config) {
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT16](&ctx, &config->maxSessions, NULL);
                 else if(strcmp(field, "maxSessionTimeout") == 0)
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_DOUBLE](&ctx, &config->maxSessionTimeout, NULL);
+                else if(strcmp(field, "maxRegisteredNodesPerSession") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->maxRegisteredNodesPerSession, NULL);
                 else if(strcmp(field, "maxNodesPerRead") == 0)
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->maxNodesPerRead, NULL);
                 else if(strcmp(field, "maxNodesPerWrite") == 0)
@@ -971,6 +973,12 @@ parseJSONConfig(UA_ServerConfig *config, UA_ByteString json_config) {
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_DOUBLE](&ctx, &config->asyncOperationTimeout, NULL);
                 else if(strcmp(field, "maxAsyncOperationQueueSize") == 0)
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT64](&ctx, &config->maxAsyncOperationQueueSize, NULL);
+                else if(strcmp(field, "serviceWorkers") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT64](&ctx, &config->serviceWorkers, NULL);
+                else if(strcmp(field, "parallelOperationsThreshold") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT64](&ctx, &config->parallelOperationsThreshold, NULL);
+                else if(strcmp(field, "concurrentReadServices") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_BOOLEAN](&ctx, &config->concurrentReadServices, NULL);
 #endif
 
 #ifdef UA_ENABLE_DISCOVERY
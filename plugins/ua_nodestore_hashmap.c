@@ -14,21 +14,47 @@
     (type *)((uintptr_t)ptr - offsetof(type,member))
 #endif
 
-/* The default Nodestore is simply a hash-map from NodeIds to Nodes. To find an
- * entry, iterate over candidate positions according to the NodeId hash.
+/* The default Nodestore is simply a hash-map from NodeIds to Nodes. The size of
+ * the table is a power of two. To find an entry, start at the position of the
+ * NodeId hash and probe linearly:
  *
  * - Tombstone or non-matching NodeId: continue searching
  * - Matching NodeId: Return the entry
- * - NULL: Abort the search */
+ * - NULL: Abort the search
+ *
+ * The full NodeId hash is stored inline in the slot as a fingerprint. Most
+ * non-matching slots are skipped without touching the entry.
+ *
+ * Resizing is incremental. The new slot array replaces the current one and the
+ * previous array is kept until all of its entries have been migrated. Every
+ * insert and remove migrates a bounded number of slots. Until the migration is
+ * done, lookups probe both arrays. Migrated slots in the previous array become
+ * tombstones so that the remaining probe sequences stay intact.
+ *
+ * UA_Nodestore_HashMap_resolveReferences replaces the local reference targets
+ * with direct pointers to the entries. Every entry counts the direct pointers
+ * to it. When an entry is removed, the direct pointers from its references are
+ * dropped. An entry that is removed or replaced while direct pointers to it
+ * remain cannot be freed right away. Its content is cleared except for the
+ * NodeId and it goes to the graveyard. getNodeFromPtr resolves pointers into
+ * the graveyard via the NodeId. Graves without pointers are swept when the
+ * graveyard has doubled in size. The next resolve pass redirects (or converts
+ * back to NodeIds) all pointers into the graveyard and then frees it.
+ *
+ * The count can be too high if direct targets are removed from a node in-place
+ * (getEditNode). The grave is then kept until the next resolve pass. */
 
 typedef struct UA_NodeMapEntry {
-    struct UA_NodeMapEntry *orig; /* the version this is a copy from (or NULL) */
+    struct UA_NodeMapEntry *orig; /* the version this is a copy from (or NULL).
+                                   * In the graveyard: the next entry. */
     UA_UInt16 refCount; /* How many consumers have a reference to the node? */
     UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
+    UA_UInt32 directRefs; /* Reference targets that point directly to the entry */
     UA_Node node;
 } UA_NodeMapEntry;
 
 #define UA_NODEMAP_MINSIZE 64
+#define UA_NODEMAP_MIGRATESTEP 64 /* Slots migrated per insert/remove */
 #define UA_NODEMAP_TOMBSTONE ((UA_NodeMapEntry*)0x01)
 
 typedef struct {
@@ -38,9 +64,18 @@ typedef struct {
 
 typedef struct {
     UA_NodeMapSlot *slots;
-    UA_UInt32 size;
-    UA_UInt32 count;
-    UA_UInt32 sizePrimeIndex;
+    UA_UInt32 size; /* Power of two */
+    UA_UInt32 count; /* Entries in both slot arrays */
+    UA_UInt32 tombstones; /* Tombstones also lengthen the probe sequences */
+
+    /* Previous slot array during a migration (or NULL). The slots below
+     * migrateIdx are migrated. */
+    UA_NodeMapSlot *oldSlots;
+    UA_UInt32 oldSize;
+    UA_UInt32 migrateIdx;
+    UA_NodeMapEntry *graveyard; /* Removed entries with direct pointers to them */
+    UA_UInt32 graveyardSize;
+    UA_UInt32 graveyardSweep; /* Sweep when the graveyard has this size */
 
     /* Maps ReferenceTypeIndex to the NodeId of the ReferenceType */
     UA_NodeId referenceTypeIds[UA_REFERENCETYPESET_MAX];
@@ -51,45 +86,71 @@ typedef struct {
 /* HashMap Utilities */
 /*********************/
 
-/* The size of the hash-map is always a prime number. They are chosen to be
- * close to the next power of 2. So the size ca. doubles with each prime. */
-static UA_UInt32 const primes[] = {
-    7,         13,         31,         61,         127,         251,
-    509,       1021,       2039,       4093,       8191,        16381,
-    32749,     65521,      131071,     262139,     524287,      1048573,
-    2097143,   4194301,    8388593,    16777213,   33554393,    67108859,
-    134217689, 268435399,  536870909,  1073741789, 2147483647,  4294967291
-};
-
-static UA_UInt32 mod(UA_UInt32 h, UA_UInt32 size) { return h % size; }
-static UA_UInt32 mod2(UA_UInt32 h, UA_UInt32 size) { return 1 + (h % (size - 2)); }
-
-static UA_UInt16
-higher_prime_index(UA_UInt32 n) {
-    UA_UInt16 low  = 0;
-    UA_UInt16 high = (UA_UInt16)(sizeof(primes) / sizeof(UA_UInt32));
-    while(low != high) {
-        UA_UInt16 mid = (UA_UInt16)(low + ((high - low) / 2));
-        if(n > primes[mid])
-            low = (UA_UInt16)(mid + 1);
-        else
-            high = mid;
-    }
-    return low;
+/* Smallest power of two that is >= n */
+static UA_UInt32
+higher_power_of_two(UA_UInt32 n) {
+    UA_UInt32 size = UA_NODEMAP_MINSIZE;
+    while(size < n && size < (UA_UInt32)0x80000000)
+        size <<= 1;
+    return size;
+}
+
+/* Probe the slot array for an entry with the NodeId */
+static UA_NodeMapSlot *
+findSlot(UA_NodeMapSlot *slots, UA_UInt32 size, UA_UInt32 h,
+         const UA_NodeId *nodeid) {
+    UA_UInt32 mask = size - 1;
+    UA_UInt32 idx = h & mask;
+    UA_UInt32 startIdx = idx;
+
+    do {
+        UA_NodeMapSlot *slot = &slots[idx];
+        if(slot->entry > UA_NODEMAP_TOMBSTONE) {
+            if(slot->nodeIdHash == h &&
+               UA_NodeId_equal(&slot->entry->node.head.nodeId, nodeid))
+                return slot;
+        } else {
+            if(slot->entry == NULL)
+                return NULL; /* No further entry possible */
+        }
+
+        idx = (idx + 1) & mask;
+    } while(idx != startIdx);
+
+    return NULL;
+}
+
+/* Returns the first empty slot or tombstone in the probe sequence */
+static UA_NodeMapSlot *
+findEmptySlot(const UA_NodeMap *ns, UA_UInt32 h) {
+    UA_UInt32 mask = ns->size - 1;
+    UA_UInt32 idx = h & mask;
+    UA_UInt32 startIdx = idx;
+    do {
+        UA_NodeMapSlot *slot = &ns->slots[idx];
+        if(slot->entry <= UA_NODEMAP_TOMBSTONE)
+            return slot;
+        idx = (idx + 1) & mask;
+    } while(idx != startIdx);
+    return NULL;
 }
 
 /* Returns an empty slot or null if the nodeid exists or if no empty slot is found. */
 static UA_NodeMapSlot *
 findFreeSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
     UA_UInt32 h = UA_NodeId_hash(nodeid);
-    UA_UInt32 size = ns->size;
-    UA_UInt64 idx = mod(h, size); /* Use 64bit container to avoid overflow  */
-    UA_UInt32 startIdx = (UA_UInt32)idx;
-    UA_UInt32 hash2 = mod2(h, size);
+
+    /* Not yet migrated? */
+    if(ns->oldSlots && findSlot(ns->oldSlots, ns->oldSize, h, nodeid))
+        return NULL;
+
+    UA_UInt32 mask = ns->size - 1;
+    UA_UInt32 idx = h & mask;
+    UA_UInt32 startIdx = idx;
 
     UA_NodeMapSlot *candidate = NULL;
     do {
-        UA_NodeMapSlot *slot = &ns->slots[(UA_UInt32)idx];
+        UA_NodeMapSlot *slot = &ns->slots[idx];
 
         if(slot->entry > UA_NODEMAP_TOMBSTONE) {
             /* A Node with the NodeId does already exist */
@@ -105,46 +166,76 @@ findFreeSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
                 return candidate;
         }
 
-        idx += hash2;
-        if(idx >= size)
-            idx -= size;
-    } while((UA_UInt32)idx != startIdx);
+        idx = (idx + 1) & mask;
+    } while(idx != startIdx);
 
     return candidate;
 }
 
-/* The occupancy of the table after the call will be about 50% */
+static UA_NodeMapSlot *
+findOccupiedSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
+    UA_UInt32 h = UA_NodeId_hash(nodeid);
+    UA_NodeMapSlot *slot = findSlot(ns->slots, ns->size, h, nodeid);
+    if(!slot && ns->oldSlots)
+        slot = findSlot(ns->oldSlots, ns->oldSize, h, nodeid);
+    return slot;
+}
+
+/* Move up to maxSlots slots from the previous to the current slot array. The
+ * current array has room for all entries. */
+static void
+migrate(UA_NodeMap *ns, UA_UInt32 maxSlots) {
+    if(!ns->oldSlots)
+        return;
+    UA_UInt32 end = ns->oldSize;
+    if(end - ns->migrateIdx > maxSlots)
+        end = ns->migrateIdx + maxSlots;
+    for(; ns->migrateIdx < end; ns->migrateIdx++) {
+        UA_NodeMapSlot *os = &ns->oldSlots[ns->migrateIdx];
+        if(os->entry <= UA_NODEMAP_TOMBSTONE)
+            continue;
+        UA_NodeMapSlot *s = findEmptySlot(ns, os->nodeIdHash);
+        UA_assert(s);
+        if(s->entry == UA_NODEMAP_TOMBSTONE)
+            --ns->tombstones;
+        *s = *os;
+        os->entry = UA_NODEMAP_TOMBSTONE;
+    }
+    if(ns->migrateIdx < ns->oldSize)
+        return;
+    UA_free(ns->oldSlots);
+    ns->oldSlots = NULL;
+    ns->oldSize = 0;
+    ns->migrateIdx = 0;
+}
+
+/* Start a migration to a new slot array. The occupancy of the table after the
+ * migration will be between 25% and 50%. The tombstones are removed. */
 static UA_StatusCode
 expand(UA_NodeMap *ns) {
-    UA_UInt32 osize = ns->size;
-    UA_UInt32 count = ns->count;
     /* Resize only when table after removal of unused elements is either too
        full or too empty */
-    if(count * 2 < osize && (count * 8 > osize || osize <= UA_NODEMAP_MINSIZE))
+    UA_UInt32 count = ns->count;
+    if((count + ns->tombstones) * 4 < ns->size * 3 &&
+       (count * 8 > ns->size || ns->size <= UA_NODEMAP_MINSIZE))
         return UA_STATUSCODE_GOOD;
 
-    UA_NodeMapSlot *oslots = ns->slots;
-    UA_UInt32 nindex = higher_prime_index(count * 2);
-    UA_UInt32 nsize = primes[nindex];
-    UA_NodeMapSlot *nslots= (UA_NodeMapSlot*)UA_calloc(nsize, sizeof(UA_NodeMapSlot));
+    UA_UInt32 nsize = higher_power_of_two(count * 2);
+    UA_NodeMapSlot *nslots = (UA_NodeMapSlot*)UA_calloc(nsize, sizeof(UA_NodeMapSlot));
     if(!nslots)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
+    /* Complete an ongoing migration first. This happens only if the table
+     * changes very quickly in size. */
+    migrate(ns, UA_UINT32_MAX);
+
+    ns->oldSlots = ns->slots;
+    ns->oldSize = ns->size;
+    ns->migrateIdx = 0;
     ns->slots = nslots;
     ns->size = nsize;
-    ns->sizePrimeIndex = nindex;
-
-    /* recompute the position of every entry and insert the pointer */
-    for(size_t i = 0, j = 0; i < osize && j < count; ++i) {
-        if(oslots[i].entry <= UA_NODEMAP_TOMBSTONE)
-            continue;
-        UA_NodeMapSlot *s = findFreeSlot(ns, &oslots[i].entry->node.head.nodeId);
-        UA_assert(s);
-        *s = oslots[i];
-        ++j;
-    }
-
-    UA_free(oslots);
+    ns->tombstones = 0;
+    migrate(ns, UA_NODEMAP_MIGRATESTEP);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -192,12 +283,71 @@ deleteNodeMapEntry(UA_NodeMapEntry *entry) {
     UA_free(entry);
 }
 
+static UA_NodeMapEntry *
+getDirectEntry(UA_NodePointer ptr) {
+    const UA_NodeHead *head = UA_NodePointer_getNode(ptr);
+    if(!head)
+        return NULL;
+    return container_of((const UA_Node*)head, UA_NodeMapEntry, node);
+}
+
+static void *
+dropDirectTarget(void *context, UA_ReferenceTarget *t) {
+    UA_NodeMapEntry *target = getDirectEntry(t->targetId);
+    if(target) {
+        UA_assert(target->directRefs > 0);
+        --target->directRefs;
+    }
+    return NULL;
+}
+
+/* Free the graves without direct pointers to them */
 static void
-cleanupNodeMapEntry(UA_NodeMapEntry *entry) {
+sweepGraveyard(UA_NodeMap *ns) {
+    UA_NodeMapEntry **next = &ns->graveyard;
+    while(*next) {
+        UA_NodeMapEntry *entry = *next;
+        if(entry->directRefs > 0) {
+            next = &entry->orig;
+            continue;
+        }
+        *next = entry->orig;
+        deleteNodeMapEntry(entry);
+        --ns->graveyardSize;
+    }
+    ns->graveyardSweep = ns->graveyardSize * 2;
+    if(ns->graveyardSweep < UA_NODEMAP_MINSIZE)
+        ns->graveyardSweep = UA_NODEMAP_MINSIZE;
+}
+
+/* Keep only the NodeId. Direct pointers to the entry remain valid. */
+static void
+buryNodeMapEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    UA_NodeId id = entry->node.head.nodeId;
+    UA_NodeId_init(&entry->node.head.nodeId);
+    UA_Node_clear(&entry->node);
+    entry->node.head.nodeId = id;
+    entry->orig = ns->graveyard;
+    ns->graveyard = entry;
+    ++ns->graveyardSize;
+    if(ns->graveyardSize >= ns->graveyardSweep)
+        sweepGraveyard(ns);
+}
+
+static void
+cleanupNodeMapEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
     if(entry->refCount > 0)
         return;
     if(entry->deleted) {
-        deleteNodeMapEntry(entry);
+        /* Drop the direct pointers from the references of the entry. Then
+         * graves can become unreferenced. */
+        for(size_t i = 0; i < entry->node.head.referencesSize; i++)
+            UA_NodeReferenceKind_iterate(&entry->node.head.references[i],
+                                         dropDirectTarget, NULL);
+        if(entry->directRefs > 0)
+            buryNodeMapEntry(ns, entry);
+        else
+            deleteNodeMapEntry(entry);
         return;
     }
     for(size_t i = 0; i < entry->node.head.referencesSize; i++) {
@@ -207,33 +357,6 @@ cleanupNodeMapEntry(UA_NodeMapEntry *entry) {
     }
 }
 
-static UA_NodeMapSlot *
-findOccupiedSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
-    UA_UInt32 h = UA_NodeId_hash(nodeid);
-    UA_UInt32 size = ns->size;
-    UA_UInt64 idx = mod(h, size); /* Use 64bit container to avoid overflow */
-    UA_UInt32 hash2 = mod2(h, size);
-    UA_UInt32 startIdx = (UA_UInt32)idx;
-
-    do {
-        UA_NodeMapSlot *slot= &ns->slots[(UA_UInt32)idx];
-        if(slot->entry > UA_NODEMAP_TOMBSTONE) {
-            if(slot->nodeIdHash == h &&
-               UA_NodeId_equal(&slot->entry->node.head.nodeId, nodeid))
-                return slot;
-        } else {
-            if(slot->entry == NULL)
-                return NULL; /* No further entry possible */
-        }
-
-        idx += hash2;
-        if(idx >= size)
-            idx -= size;
-    } while((UA_UInt32)idx != startIdx);
-
-    return NULL;
-}
-
 /***********************/
 /* Interface functions */
 /***********************/
@@ -271,6 +394,18 @@ UA_NodeMap_getNodeFromPtr(void *context, UA_NodePointer ptr,
                           UA_UInt32 attributeMask,
                           UA_ReferenceTypeSet references,
                           UA_BrowseDirection referenceDirections) {
+    /* Direct pointer to a node that was not replaced or removed. Otherwise the
+     * pointer can be into the graveyard. Then look up the NodeId. */
+    const UA_NodeHead *head = UA_NodePointer_getNode(ptr);
+    if(head) {
+        UA_NodeMapEntry *entry =
+            container_of((const UA_Node*)head, UA_NodeMapEntry, node);
+        if(!entry->deleted) {
+            ++entry->refCount;
+            return &entry->node;
+        }
+    }
+
     if(!UA_NodePointer_isLocal(ptr))
         return NULL;
     UA_NodeId id = UA_NodePointer_toNodeId(ptr);
@@ -285,7 +420,7 @@ UA_NodeMap_releaseNode(void *context, const UA_Node *node) {
     UA_assert(&entry->node == node);
     UA_assert(entry->refCount > 0);
     --entry->refCount;
-    cleanupNodeMapEntry(entry);
+    cleanupNodeMapEntry((UA_NodeMap*)context, entry);
 }
 
 static UA_StatusCode
@@ -312,17 +447,22 @@ UA_NodeMap_getNodeCopy(void *context, const UA_NodeId *nodeid,
 static UA_StatusCode
 UA_NodeMap_removeNode(void *context, const UA_NodeId *nodeid) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
+    migrate(ns, UA_NODEMAP_MIGRATESTEP);
     UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
     if(!slot)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
 
+    /* Only count the tombstones of the current slot array */
+    if(slot >= ns->slots && slot < &ns->slots[ns->size])
+        ++ns->tombstones;
+
     UA_NodeMapEntry *entry = slot->entry;
     slot->entry = UA_NODEMAP_TOMBSTONE;
     entry->deleted = true;
-    cleanupNodeMapEntry(entry);
+    cleanupNodeMapEntry(ns, entry);
     --ns->count;
     /* Downsize the hashmap if it is very empty */
-    if(ns->count * 8 < ns->size && ns->size > UA_NODEMAP_MINSIZE)
+    if(!ns->oldSlots && ns->count * 8 < ns->size && ns->size > UA_NODEMAP_MINSIZE)
         expand(ns); /* Can fail. Just continue with the bigger hashmap. */
     return UA_STATUSCODE_GOOD;
 }
@@ -335,38 +475,29 @@ static UA_StatusCode
 UA_NodeMap_insertNode(void *context, UA_Node *node,
                       UA_NodeId *addedNodeId) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    if(ns->size * 3 <= ns->count * 4) {
+    migrate(ns, UA_NODEMAP_MIGRATESTEP);
+    if(ns->size * 3 <= (ns->count + ns->tombstones) * 4) {
         if(expand(ns) != UA_STATUSCODE_GOOD){
             deleteNodeMapEntry(container_of(node, UA_NodeMapEntry, node));
             return UA_STATUSCODE_BADINTERNALERROR;
         }
     }
 
-    UA_NodeMapSlot *slot;
+    UA_NodeMapSlot *slot = NULL;
     if(node->head.nodeId.identifierType == UA_NODEIDTYPE_NUMERIC &&
        node->head.nodeId.identifier.numeric == 0) {
         /* Create a random nodeid: Start at least with 50,000 to make sure we
          * don not conflict with nodes from the spec. If we find a conflict, we
-         * just try another identifier until we have tried all possible
-         * identifiers. Since the size is prime and we don't change the increase
-         * val, we will reach the starting id again. E.g. adding a nodeset will
-         * create children while there are still other nodes which need to be
-         * created. Thus the node ids may collide. */
-        UA_UInt32 size = ns->size;
-        UA_UInt64 identifier = mod(50000 + size+1, UA_UINT32_MAX); /* Use 64bit to
-                                                                    * avoid overflow */
-        UA_UInt32 increase = mod2(ns->count+1, size);
-        UA_UInt32 startId = (UA_UInt32)identifier; /* mod ensures us that the id
-                                                    * is a valid 32 bit integer */
-
-        do {
-            node->head.nodeId.identifier.numeric = (UA_UInt32)identifier;
-            slot = findFreeSlot(ns, &node->head.nodeId);
-            if(slot)
-                break;
-            identifier += increase;
-            if(identifier >= size)
-                identifier -= size;
+         * just try another identifier until we have tried all identifiers in
+         * the range [50000, 50000 + size). The increase is odd and the size a
+         * power of two. So we visit every identifier in the range. E.g. adding
+         * a nodeset will create children while there are still other nodes
+         * which need to be created. Thus the node ids may collide. */
+        UA_UInt32 mask = ns->size - 1;
+        UA_UInt32 offset = (ns->count + 1) * 0x9E3779B1u; /* Scatter */
+        UA_UInt32 increase = (offset >> 16) | 0x01;
+        for(UA_UInt32 i = 0; i <= mask; i++) {
+            UA_UInt32 identifier = 50000 + ((offset + (i * increase)) & mask);
 #if SIZE_MAX <= UA_UINT32_MAX
             /* The compressed "immediate" representation of nodes does not
              * support the full range on 32bit systems. Generate smaller
@@ -374,7 +505,11 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
             if(identifier >= (0x01 << 24))
                 identifier = identifier % (0x01 << 24);
 #endif
-        } while((UA_UInt32)identifier != startId);
+            node->head.nodeId.identifier.numeric = identifier;
+            slot = findFreeSlot(ns, &node->head.nodeId);
+            if(slot)
+                break;
+        }
     } else {
         slot = findFreeSlot(ns, &node->head.nodeId);
     }
@@ -417,6 +552,8 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
 
     /* Insert the node */
     UA_NodeMapEntry *newEntry = container_of(node, UA_NodeMapEntry, node);
+    if(slot->entry == UA_NODEMAP_TOMBSTONE)
+        --ns->tombstones;
     slot->nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
     slot->entry = newEntry;
     ++ns->count;
@@ -445,7 +582,7 @@ UA_NodeMap_replaceNode(void *context, UA_Node *node) {
     /* Replace the entry */
     slot->entry = newEntry;
     oldEntry->deleted = true;
-    cleanupNodeMapEntry(oldEntry);
+    cleanupNodeMapEntry(ns, oldEntry);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -461,14 +598,16 @@ static void
 UA_NodeMap_iterate(void *context, UA_NodestoreVisitor visitor,
                    void *visitorContext) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
+    migrate(ns, UA_UINT32_MAX); /* Iterate over a single slot array */
     for(UA_UInt32 i = 0; i < ns->size; ++i) {
         UA_NodeMapSlot *slot = &ns->slots[i];
         if(slot->entry > UA_NODEMAP_TOMBSTONE) {
             /* The visitor can delete the node. So refcount here. */
-            slot->entry->refCount++;
-            visitor(visitorContext, &slot->entry->node);
-            slot->entry->refCount--;
-            cleanupNodeMapEntry(slot->entry);
+            UA_NodeMapEntry *entry = slot->entry;
+            entry->refCount++;
+            visitor(visitorContext, &entry->node);
+            entry->refCount--;
+            cleanupNodeMapEntry(ns, entry);
         }
     }
 }
@@ -480,6 +619,7 @@ UA_NodeMap_delete(void *context) {
         return;
 
     UA_NodeMap *ns = (UA_NodeMap*)context;
+    migrate(ns, UA_UINT32_MAX);
     UA_UInt32 size = ns->size;
     UA_NodeMapSlot *slots = ns->slots;
     for(UA_UInt32 i = 0; i < size; ++i) {
@@ -492,6 +632,13 @@ UA_NodeMap_delete(void *context) {
     }
     UA_free(ns->slots);
 
+    /* Free the graveyard */
+    while(ns->graveyard) {
+        UA_NodeMapEntry *entry = ns->graveyard;
+        ns->graveyard = entry->orig;
+        deleteNodeMapEntry(entry);
+    }
+
     /* Clean up the ReferenceTypes index array */
     for(size_t i = 0; i < ns->referenceTypeCounter; i++)
         UA_NodeId_clear(&ns->referenceTypeIds[i]);
@@ -499,15 +646,78 @@ UA_NodeMap_delete(void *context) {
     UA_free(ns);
 }
 
+/* Point the target to the current entry with the NodeId. Or to the NodeId if
+ * there is no such entry. */
+static void *
+resolveReferenceTarget(void *context, UA_ReferenceTarget *t) {
+    UA_NodeMap *ns = (UA_NodeMap*)context;
+    if(!UA_NodePointer_isLocal(t->targetId))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(t->targetId);
+    UA_NodeMapSlot *slot = findOccupiedSlot(ns, &id);
+    UA_NodeMapEntry *prev = getDirectEntry(t->targetId);
+    if(slot) {
+        if(slot->entry == prev)
+            return NULL; /* Already resolved */
+        UA_NodePointer old = t->targetId;
+        slot->entry->directRefs++;
+        t->targetId = UA_NodePointer_fromNode(&slot->entry->node.head);
+        UA_NodePointer_clear(&old);
+    } else {
+        /* Not found. Pointers into the graveyard become NodeIds again. */
+        if(!prev)
+            return NULL;
+        UA_NodePointer np;
+        UA_StatusCode res = UA_NodePointer_copy(t->targetId, &np);
+        if(res != UA_STATUSCODE_GOOD)
+            return (void*)0x01;
+        t->targetId = np;
+    }
+    if(prev)
+        prev->directRefs--;
+    return NULL;
+}
+
+UA_StatusCode
+UA_Nodestore_HashMap_resolveReferences(UA_Nodestore *ns) {
+    if(ns->getNode != UA_NodeMap_getNode)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    UA_NodeMap *nm = (UA_NodeMap*)ns->context;
+    migrate(nm, UA_UINT32_MAX);
+
+    /* Resolve the targets of all nodes in the table */
+    for(UA_UInt32 i = 0; i < nm->size; ++i) {
+        UA_NodeMapEntry *entry = nm->slots[i].entry;
+        if(entry <= UA_NODEMAP_TOMBSTONE)
+            continue;
+        for(size_t j = 0; j < entry->node.head.referencesSize; j++) {
+            UA_NodeReferenceKind *rk = &entry->node.head.references[j];
+            if(UA_NodeReferenceKind_iterate(rk, resolveReferenceTarget, nm))
+                return UA_STATUSCODE_BADOUTOFMEMORY; /* Keep the graveyard */
+        }
+    }
+
+    /* No more pointers into the graveyard. Except from removed nodes that
+     * are still retrieved. */
+    sweepGraveyard(nm);
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_Nodestore_HashMap(UA_Nodestore *ns) {
     /* Allocate and initialize the nodemap */
     UA_NodeMap *nodemap = (UA_NodeMap*)UA_malloc(sizeof(UA_NodeMap));
     if(!nodemap)
         return UA_STATUSCODE_BADOUTOFMEMORY;
-    nodemap->sizePrimeIndex = higher_prime_index(UA_NODEMAP_MINSIZE);
-    nodemap->size = primes[nodemap->sizePrimeIndex];
+    nodemap->size = UA_NODEMAP_MINSIZE;
     nodemap->count = 0;
+    nodemap->tombstones = 0;
+    nodemap->graveyard = NULL;
+    nodemap->graveyardSize = 0;
+    nodemap->graveyardSweep = UA_NODEMAP_MINSIZE;
+    nodemap->oldSlots = NULL;
+    nodemap->oldSize = 0;
+    nodemap->migrateIdx = 0;
     nodemap->slots = (UA_NodeMapSlot*)
         UA_calloc(nodemap->size, sizeof(UA_NodeMapSlot));
     if(!nodemap->slots) {
@@ -531,6 +741,7 @@ UA_Nodestore_HashMap(UA_Nodestore *ns) {
     ns->removeNode = UA_NodeMap_removeNode;
     ns->getReferenceTypeId = UA_NodeMap_getReferenceTypeId;
     ns->iterate = UA_NodeMap_iterate;
+    ns->concurrentReads = false;
 
     /* All nodes are stored in RAM. Changes are made in-situ. GetEditNode is
      * identical to GetNode -- but the Node pointer is non-const. */
@@ -0,0 +1,889 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/util.h>
+#include <open62541/plugin/nodestore_default.h>
+
+#if UA_MULTITHREADING >= 100
+
+#ifndef container_of
+#define container_of(ptr, type, member) \
+    (type *)((uintptr_t)ptr - offsetof(type,member))
+#endif
+
+/* Concurrent variant of the HashMap Nodestore. The layout of the hash-map is
+ * the same (linear probing in a power-of-two table, the NodeId hash stored as
+ * a fingerprint). But readers never take a lock:
+ *
+ * - The table and its slots are only accessed with atomic loads. Writers
+ *   publish entries and tables with atomic exchanges. Published nodes are
+ *   immutable. Edits are made on a copy that replaces the published entry.
+ * - A reader pins the entry it found with an atomic reference counter. If the
+ *   entry was unpublished in the meantime, the lookup is retried.
+ * - Unpublished entries and tables are retired. They are freed only when all
+ *   readers that could still see them have left. Readers announce themselves
+ *   in the counter of the current epoch. Writers flip between two epochs once
+ *   the readers of the previous epoch have left. Then the memory retired two
+ *   epochs ago can be freed. Reclamation never waits for readers.
+ *
+ * Writers (insert, replace, remove and the release of edits) are serialized by
+ * a mutex. Concurrent edits of the same node from different threads are not
+ * supported. They require external synchronization (e.g. the server lock).
+ * Edits are never lost silently. replaceNode fails while an edit of the node is
+ * open. An edit is only dropped if its node was removed. */
+
+#define UA_CNODEMAP_MINSIZE 64
+#define UA_CNODEMAP_TOMBSTONE ((UA_CNodeMapEntry*)0x01)
+
+/* Lifecycle of an entry */
+#define UA_CENTRY_NEW     ((void*)0x00) /* Not (yet) published */
+#define UA_CENTRY_LIVE    ((void*)0x01) /* In the table */
+#define UA_CENTRY_DELETED ((void*)0x02) /* Unpublished, but still referenced */
+#define UA_CENTRY_RETIRED ((void*)0x03) /* Waiting for the readers to leave */
+
+typedef struct UA_CNodeMapEntry {
+    struct UA_CNodeMapEntry *orig; /* The version this is a copy from (or NULL).
+                                    * The copy holds a reference on it. */
+    struct UA_CNodeMapEntry *edit; /* Open edit-copy of a published entry */
+    struct UA_CNodeMapEntry *next; /* For the retired and limbo lists */
+    size_t editRefs;               /* Open edits of an edit-copy */
+    volatile size_t refCount;      /* Consumers holding the node */
+    void *state;
+    UA_UInt32 nodeIdHash;
+    UA_Node node;
+} UA_CNodeMapEntry;
+
+typedef struct UA_CNodeMapTable {
+    struct UA_CNodeMapTable *next; /* For the limbo list */
+    UA_UInt32 size;
+    UA_CNodeMapEntry **slots;
+} UA_CNodeMapTable;
+
+/* The reader counters are spread over cache lines. Otherwise all lookups
+ * contend for the same counter. */
+#define UA_CNODEMAP_READERSTRIPES 16
+
+typedef struct {
+    volatile size_t count;
+    UA_Byte padding[64 - sizeof(size_t)];
+} UA_CNodeMapReaders;
+
+typedef struct {
+    UA_CNodeMapReaders readers[2][UA_CNODEMAP_READERSTRIPES];
+    void *epoch; /* 0 or 1 */
+
+    UA_CNodeMapTable *table;
+    UA_UInt32 count;
+    UA_UInt32 tombstones;
+
+    /* Entries released by readers after they were unpublished. Lock-free
+     * stack. Moved to the limbo list of the current epoch by the writers. */
+    UA_CNodeMapEntry *retired;
+
+    /* Retired memory that might still be seen by readers of the epoch */
+    UA_CNodeMapEntry *limbo[2];
+    UA_CNodeMapTable *limboTables[2];
+
+    UA_Lock lock; /* Serializes the writers */
+
+    /* Maps ReferenceTypeIndex to the NodeId of the ReferenceType */
+    UA_NodeId referenceTypeIds[UA_REFERENCETYPESET_MAX];
+    UA_Byte referenceTypeCounter;
+} UA_CNodeMap;
+
+/*********************/
+/* HashMap Utilities */
+/*********************/
+
+/* Smallest power of two that is >= n */
+static UA_UInt32
+higher_power_of_two(UA_UInt32 n) {
+    UA_UInt32 size = UA_CNODEMAP_MINSIZE;
+    while(size < n && size < (UA_UInt32)0x80000000)
+        size <<= 1;
+    return size;
+}
+
+static UA_CNodeMapTable *
+createTable(UA_UInt32 size) {
+    UA_CNodeMapTable *t = (UA_CNodeMapTable*)
+        UA_calloc(1, sizeof(UA_CNodeMapTable) + (size * sizeof(UA_CNodeMapEntry*)));
+    if(!t)
+        return NULL;
+    t->size = size;
+    t->slots = (UA_CNodeMapEntry**)(uintptr_t)&t[1];
+    return t;
+}
+
+static UA_CNodeMapEntry *
+createEntry(UA_NodeClass nodeClass) {
+    size_t size = sizeof(UA_CNodeMapEntry) - sizeof(UA_Node);
+    switch(nodeClass) {
+    case UA_NODECLASS_OBJECT:
+        size += sizeof(UA_ObjectNode);
+        break;
+    case UA_NODECLASS_VARIABLE:
+        size += sizeof(UA_VariableNode);
+        break;
+    case UA_NODECLASS_METHOD:
+        size += sizeof(UA_MethodNode);
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        size += sizeof(UA_ObjectTypeNode);
+        break;
+    case UA_NODECLASS_VARIABLETYPE:
+        size += sizeof(UA_VariableTypeNode);
+        break;
+    case UA_NODECLASS_REFERENCETYPE:
+        size += sizeof(UA_ReferenceTypeNode);
+        break;
+    case UA_NODECLASS_DATATYPE:
+        size += sizeof(UA_DataTypeNode);
+        break;
+    case UA_NODECLASS_VIEW:
+        size += sizeof(UA_ViewNode);
+        break;
+    default:
+        return NULL;
+    }
+    UA_CNodeMapEntry *entry = (UA_CNodeMapEntry*)UA_calloc(1, size);
+    if(!entry)
+        return NULL;
+    entry->node.head.nodeClass = nodeClass;
+    return entry;
+}
+
+static void
+deleteEntry(UA_CNodeMapEntry *entry) {
+    UA_Node_clear(&entry->node);
+    UA_free(entry);
+}
+
+/*******************/
+/* Epochs / Readers */
+/*******************/
+
+/* The threads have disjoint stacks. The stack address is a cheap way to spread
+ * the threads over the reader counters. Returns the "ticket" for leaving. */
+static size_t
+enterEpoch(UA_CNodeMap *ns) {
+    UA_Byte local;
+    UA_UInt32 h = (UA_UInt32)((uintptr_t)&local >> 16) * 0x9E3779B1u;
+    size_t stripe = h >> 28; /* 16 stripes */
+    while(true) {
+        size_t e = (uintptr_t)UA_atomic_load(&ns->epoch);
+        UA_atomic_addSize(&ns->readers[e][stripe].count, 1);
+        /* The epoch was flipped in between. The writer might not have seen us.
+         * Try again in the new epoch. */
+        if((uintptr_t)UA_atomic_load(&ns->epoch) == e)
+            return (e * UA_CNODEMAP_READERSTRIPES) + stripe;
+        UA_atomic_subSize(&ns->readers[e][stripe].count, 1);
+    }
+}
+
+static void
+leaveEpoch(UA_CNodeMap *ns, size_t ticket) {
+    UA_atomic_subSize(&ns->readers[ticket / UA_CNODEMAP_READERSTRIPES]
+                      [ticket % UA_CNODEMAP_READERSTRIPES].count, 1);
+}
+
+static UA_Boolean
+epochEmpty(UA_CNodeMap *ns, size_t e) {
+    for(size_t i = 0; i < UA_CNODEMAP_READERSTRIPES; i++) {
+        if(UA_atomic_addSize(&ns->readers[e][i].count, 0) > 0)
+            return false;
+    }
+    return true;
+}
+
+/* Called by the last consumer of an unpublished entry. The state transition
+ * ensures that only one thread retires the entry. */
+static void
+retireEntry(UA_CNodeMap *ns, UA_CNodeMapEntry *entry) {
+    if(UA_atomic_cmpxchg(&entry->state, UA_CENTRY_DELETED,
+                         UA_CENTRY_RETIRED) != UA_CENTRY_DELETED)
+        return;
+    /* Push to the lock-free stack. The writer only ever takes the entire
+     * stack, so there is no ABA problem. */
+    UA_CNodeMapEntry *head;
+    do {
+        head = (UA_CNodeMapEntry*)UA_atomic_load((void**)&ns->retired);
+        entry->next = head;
+    } while(UA_atomic_cmpxchg((void**)&ns->retired, head, entry) != head);
+}
+
+/* Dropping the last reference races with the writer that unpublishes the
+ * entry. Both may retire it. The epoch keeps the entry from being reclaimed
+ * before the state is checked here. */
+static void
+releaseEntry(UA_CNodeMap *ns, UA_CNodeMapEntry *entry) {
+    size_t ticket = enterEpoch(ns);
+    if(UA_atomic_subSize(&entry->refCount, 1) == 0 &&
+       UA_atomic_load(&entry->state) == UA_CENTRY_DELETED)
+        retireEntry(ns, entry);
+    leaveEpoch(ns, ticket);
+}
+
+/* Pin the entry. Fails if the entry is not (or no longer) published. Must be
+ * called from within an epoch or while holding a reference. */
+static UA_Boolean
+acquireEntry(UA_CNodeMap *ns, UA_CNodeMapEntry *entry) {
+    UA_atomic_addSize(&entry->refCount, 1);
+    if(UA_atomic_load(&entry->state) == UA_CENTRY_LIVE)
+        return true;
+    releaseEntry(ns, entry);
+    return false;
+}
+
+static UA_CNodeMapEntry *
+lookupEntry(UA_CNodeMap *ns, const UA_NodeId *nodeid, UA_UInt32 h) {
+    UA_CNodeMapTable *t = (UA_CNodeMapTable*)UA_atomic_load((void**)&ns->table);
+    UA_UInt32 mask = t->size - 1;
+    UA_UInt32 idx = h & mask;
+    UA_UInt32 startIdx = idx;
+
+    do {
+        UA_CNodeMapEntry *entry = (UA_CNodeMapEntry*)
+            UA_atomic_load((void**)&t->slots[idx]);
+        if(entry > UA_CNODEMAP_TOMBSTONE) {
+            if(entry->nodeIdHash == h &&
+               UA_NodeId_equal(&entry->node.head.nodeId, nodeid))
+                return entry;
+        } else {
+            if(entry == NULL)
+                return NULL; /* No further entry possible */
+        }
+
+        idx = (idx + 1) & mask;
+    } while(idx != startIdx);
+
+    return NULL;
+}
+
+/* Returns a pinned entry or NULL */
+static UA_CNodeMapEntry *
+findEntry(UA_CNodeMap *ns, const UA_NodeId *nodeid) {
+    UA_UInt32 h = UA_NodeId_hash(nodeid);
+    size_t ticket = enterEpoch(ns);
+    UA_CNodeMapEntry *entry;
+    do {
+        entry = lookupEntry(ns, nodeid, h);
+    } while(entry && !acquireEntry(ns, entry)); /* Replaced in between */
+    leaveEpoch(ns, ticket);
+    return entry;
+}
+
+/***********/
+/* Writers */
+/***********/
+
+/* Free the memory of the previous epoch if all its readers have left. Then
+ * flip the epoch. Only called with the writer lock held. */
+static void
+reclaim(UA_CNodeMap *ns) {
+    size_t e = (uintptr_t)ns->epoch;
+
+    /* Move the entries retired by the readers into the current epoch */
+    UA_CNodeMapEntry *retired = (UA_CNodeMapEntry*)
+        UA_atomic_xchg((void**)&ns->retired, NULL);
+    while(retired) {
+        UA_CNodeMapEntry *next = retired->next;
+        retired->next = ns->limbo[e];
+        ns->limbo[e] = retired;
+        retired = next;
+    }
+
+    /* Readers of the previous epoch are still active */
+    size_t prev = 1 - e;
+    if(!epochEmpty(ns, prev))
+        return;
+
+    /* Nobody can see the memory retired in the previous epoch anymore */
+    while(ns->limbo[prev]) {
+        UA_CNodeMapEntry *next = ns->limbo[prev]->next;
+        deleteEntry(ns->limbo[prev]);
+        ns->limbo[prev] = next;
+    }
+    while(ns->limboTables[prev]) {
+        UA_CNodeMapTable *next = ns->limboTables[prev]->next;
+        UA_free(ns->limboTables[prev]);
+        ns->limboTables[prev] = next;
+    }
+
+    UA_atomic_xchg(&ns->epoch, (void*)(uintptr_t)prev);
+}
+
+/* Writers are the only ones to modify the slots. They don't need atomic loads.
+ * Returns an empty slot or null if the nodeid exists or if no empty slot is
+ * found. */
+static UA_CNodeMapEntry **
+findFreeSlot(UA_CNodeMapTable *t, const UA_NodeId *nodeid) {
+    UA_UInt32 h = UA_NodeId_hash(nodeid);
+    UA_UInt32 mask = t->size - 1;
+    UA_UInt32 idx = h & mask;
+    UA_UInt32 startIdx = idx;
+
+    UA_CNodeMapEntry **candidate = NULL;
+    do {
+        UA_CNodeMapEntry **slot = &t->slots[idx];
+        if(*slot > UA_CNODEMAP_TOMBSTONE) {
+            /* A Node with the NodeId does already exist */
+            if((*slot)->nodeIdHash == h &&
+               UA_NodeId_equal(&(*slot)->node.head.nodeId, nodeid))
+                return NULL;
+        } else {
+            /* Found a candidate node */
+            if(!candidate)
+                candidate = slot;
+            /* No matching node can come afterwards */
+            if(*slot == NULL)
+                return candidate;
+        }
+
+        idx = (idx + 1) & mask;
+    } while(idx != startIdx);
+
+    return candidate;
+}
+
+static UA_CNodeMapEntry **
+findOccupiedSlot(UA_CNodeMapTable *t, const UA_NodeId *nodeid) {
+    UA_UInt32 h = UA_NodeId_hash(nodeid);
+    UA_UInt32 mask = t->size - 1;
+    UA_UInt32 idx = h & mask;
+    UA_UInt32 startIdx = idx;
+
+    do {
+        UA_CNodeMapEntry **slot = &t->slots[idx];
+        if(*slot > UA_CNODEMAP_TOMBSTONE) {
+            if((*slot)->nodeIdHash == h &&
+               UA_NodeId_equal(&(*slot)->node.head.nodeId, nodeid))
+                return slot;
+        } else {
+            if(*slot == NULL)
+                return NULL; /* No further entry possible */
+        }
+
+        idx = (idx + 1) & mask;
+    } while(idx != startIdx);
+
+    return NULL;
+}
+
+/* Build the resized table privately and publish it at once. The old table is
+ * retired. The occupancy of the table after the call will be between 25% and
+ * 50%. The tombstones are removed. */
+static UA_StatusCode
+expand(UA_CNodeMap *ns) {
+    UA_CNodeMapTable *ot = ns->table;
+    UA_UInt32 osize = ot->size;
+    UA_UInt32 count = ns->count;
+    /* Resize only when table after removal of unused elements is either too
+       full or too empty */
+    if((count + ns->tombstones) * 4 < osize * 3 &&
+       (count * 8 > osize || osize <= UA_CNODEMAP_MINSIZE))
+        return UA_STATUSCODE_GOOD;
+
+    UA_CNodeMapTable *nt = createTable(higher_power_of_two(count * 2));
+    if(!nt)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Recompute the position of every entry and insert the pointer */
+    for(size_t i = 0, j = 0; i < osize && j < count; ++i) {
+        if(ot->slots[i] <= UA_CNODEMAP_TOMBSTONE)
+            continue;
+        UA_CNodeMapEntry **s = findFreeSlot(nt, &ot->slots[i]->node.head.nodeId);
+        UA_assert(s);
+        *s = ot->slots[i];
+        ++j;
+    }
+
+    UA_atomic_xchg((void**)&ns->table, nt);
+    ns->tombstones = 0;
+    size_t e = (uintptr_t)ns->epoch;
+    ot->next = ns->limboTables[e];
+    ns->limboTables[e] = ot;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Convert large reference arrays into trees before the node becomes
+ * immutable */
+static void
+prepareEntry(UA_CNodeMapEntry *entry) {
+    for(size_t i = 0; i < entry->node.head.referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &entry->node.head.references[i];
+        if(rk->targetsSize > 16 && !rk->hasRefTree)
+            UA_NodeReferenceKind_switch(rk);
+    }
+}
+
+static void
+unpublishEntry(UA_CNodeMap *ns, UA_CNodeMapEntry *entry) {
+    UA_atomic_xchg(&entry->state, UA_CENTRY_DELETED);
+    if(UA_atomic_addSize(&entry->refCount, 0) == 0)
+        retireEntry(ns, entry);
+}
+
+/* Atomically swap the entry in the slot. The old entry is retired once it is
+ * no longer referenced. */
+static void
+publishReplace(UA_CNodeMap *ns, UA_CNodeMapEntry **slot,
+               UA_CNodeMapEntry *oldEntry, UA_CNodeMapEntry *newEntry) {
+    prepareEntry(newEntry);
+    newEntry->nodeIdHash = oldEntry->nodeIdHash;
+    UA_atomic_xchg(&newEntry->state, UA_CENTRY_LIVE);
+    UA_atomic_xchg((void**)slot, newEntry);
+    unpublishEntry(ns, oldEntry);
+}
+
+/***********************/
+/* Interface functions */
+/***********************/
+
+static UA_Node *
+UA_CNodeMap_newNode(void *context, UA_NodeClass nodeClass) {
+    UA_CNodeMapEntry *entry = createEntry(nodeClass);
+    if(!entry)
+        return NULL;
+    return &entry->node;
+}
+
+static void
+UA_CNodeMap_deleteNode(void *context, UA_Node *node) {
+    UA_CNodeMap *ns = (UA_CNodeMap*)context;
+    UA_CNodeMapEntry *entry = container_of(node, UA_CNodeMapEntry, node);
+    UA_assert(&entry->node == node);
+    if(entry->orig)
+        releaseEntry(ns, entry->orig);
+    deleteEntry(entry);
+}
+
+static const UA_Node *
+UA_CNodeMap_getNode(void *context, const UA_NodeId *nodeid,
+                    UA_UInt32 attributeMask,
+                    UA_ReferenceTypeSet references,
+                    UA_BrowseDirection referenceDirections) {
+    UA_CNodeMapEntry *entry = findEntry((UA_CNodeMap*)context, nodeid);
+    return (entry) ? &entry->node : NULL;
+}
+
+static const UA_Node *
+UA_CNodeMap_getNodeFromPtr(void *context, UA_NodePointer ptr,
+                           UA_UInt32 attributeMask,
+                           UA_ReferenceTypeSet references,
+                           UA_BrowseDirection referenceDirections) {
+    /* Direct pointer to a node that is still published. The caller keeps the
+     * pointed-to node alive. */
+    const UA_NodeHead *head = UA_NodePointer_getNode(ptr);
+    if(head) {
+        UA_CNodeMapEntry *entry =
+            container_of((const UA_Node*)head, UA_CNodeMapEntry, node);
+        if(acquireEntry((UA_CNodeMap*)context, entry))
+            return &entry->node;
+    }
+
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return UA_CNodeMap_getNode(context, &id, attributeMask,
+                               references, referenceDirections);
+}
+
+/* Returns the shared edit-copy of the published node */
+static UA_Node *
+UA_CNodeMap_getEditNode(void *context, const UA_NodeId *nodeid,
+                        UA_UInt32 attributeMask,
+                        UA_ReferenceTypeSet references,
+                        UA_BrowseDirection referenceDirections) {
+    UA_CNodeMap *ns = (UA_CNodeMap*)context;
+    UA_LOCK(&ns->lock);
+    UA_CNodeMapEntry **slot = findOccupiedSlot(ns->table, nodeid);
+    if(!slot) {
+        UA_UNLOCK(&ns->lock);
+        return NULL;
+    }
+
+    UA_CNodeMapEntry *entry = *slot;
+    UA_CNodeMapEntry *copy = entry->edit;
+    if(copy) {
+        copy->editRefs++;
+        UA_UNLOCK(&ns->lock);
+        return &copy->node;
+    }
+
+    copy = createEntry(entry->node.head.nodeClass);
+    if(!copy || UA_Node_copy(&entry->node, &copy->node) != UA_STATUSCODE_GOOD) {
+        UA_free(copy);
+        UA_UNLOCK(&ns->lock);
+        return NULL;
+    }
+
+    /* Published entries are only unpublished with the lock held. So we can
+     * take the reference without the check in acquireEntry. */
+    UA_atomic_addSize(&entry->refCount, 1);
+    copy->orig = entry;
+    copy->editRefs = 1;
+    entry->edit = copy;
+    UA_UNLOCK(&ns->lock);
+    return &copy->node;
+}
+
+static UA_Node *
+UA_CNodeMap_getEditNodeFromPtr(void *context, UA_NodePointer ptr,
+                               UA_UInt32 attributeMask,
+                               UA_ReferenceTypeSet references,
+                               UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return UA_CNodeMap_getEditNode(context, &id, attributeMask,
+                                   references, referenceDirections);
+}
+
+/* Releasing an edit publishes the changes. The last edit publishes the copy
+ * itself. While other edits of the copy are still open, a snapshot of the copy
+ * is published instead. The copy then remains editable and becomes an
+ * edit-copy of the snapshot. replaceNode fails while an edit is open. So the
+ * original can only have been removed in the meantime. Then the edit is
+ * dropped together with the node. */
+static void
+releaseEdit(UA_CNodeMap *ns, UA_CNodeMapEntry *copy) {
+    UA_LOCK(&ns->lock);
+    UA_assert(copy->editRefs > 0);
+    copy->editRefs--;
+
+    UA_CNodeMapEntry *orig = copy->orig;
+    UA_CNodeMapEntry **slot =
+        findOccupiedSlot(ns->table, &orig->node.head.nodeId);
+    if(!slot || *slot != orig) {
+        /* Removed */
+        if(copy->editRefs == 0) {
+            orig->edit = NULL;
+            deleteEntry(copy);
+            releaseEntry(ns, orig);
+        }
+        UA_UNLOCK(&ns->lock);
+        return;
+    }
+
+    if(copy->editRefs > 0) {
+        /* Publish a snapshot. If that fails, the changes become visible with
+         * the release of the last edit. */
+        UA_CNodeMapEntry *snap = createEntry(copy->node.head.nodeClass);
+        if(!snap || UA_Node_copy(&copy->node, &snap->node) != UA_STATUSCODE_GOOD) {
+            UA_free(snap);
+            UA_UNLOCK(&ns->lock);
+            return;
+        }
+        orig->edit = NULL;
+        snap->edit = copy;
+        publishReplace(ns, slot, orig, snap);
+        UA_atomic_addSize(&snap->refCount, 1); /* Published, see getEditNode */
+        copy->orig = snap;
+    } else {
+        orig->edit = NULL;
+        copy->orig = NULL;
+        publishReplace(ns, slot, orig, copy);
+    }
+    releaseEntry(ns, orig);
+    reclaim(ns);
+    UA_UNLOCK(&ns->lock);
+}
+
+static void
+UA_CNodeMap_releaseNode(void *context, const UA_Node *node) {
+    if(!node)
+        return;
+    UA_CNodeMap *ns = (UA_CNodeMap*)context;
+    UA_CNodeMapEntry *entry = container_of(node, UA_CNodeMapEntry, node);
+    UA_assert(&entry->node == node);
+    /* Only edit-copies are handed out before they are published */
+    if(UA_atomic_load(&entry->state) == UA_CENTRY_NEW) {
+        releaseEdit(ns, entry);
+        return;
+    }
+    UA_assert(UA_atomic_addSize(&entry->refCount, 0) > 0);
+    releaseEntry(ns, entry);
+}
+
+static UA_StatusCode
+UA_CNodeMap_getNodeCopy(void *context, const UA_NodeId *nodeid,
+                        UA_Node **outNode) {
+    UA_CNodeMap *ns = (UA_CNodeMap*)context;
+    UA_CNodeMapEntry *entry = findEntry(ns, nodeid);
+    if(!entry)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    UA_CNodeMapEntry *newItem = createEntry(entry->node.head.nodeClass);
+    if(!newItem) {
+        releaseEntry(ns, entry);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    UA_StatusCode retval = UA_Node_copy(&entry->node, &newItem->node);
+    if(retval != UA_STATUSCODE_GOOD) {
+        releaseEntry(ns, entry);
+        deleteEntry(newItem);
+        return retval;
+    }
+    /* Keep the reference to the original. So it cannot be reclaimed and
+     * reused for a different node before replaceNode. */
+    newItem->orig = entry;
+    *outNode = &newItem->node;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+UA_CNodeMap_removeNode(void *context, const UA_NodeId *nodeid) {
+    UA_CNodeMap *ns = (UA_CNodeMap*)context;
+    UA_LOCK(&ns->lock);
+    UA_CNodeMapEntry **slot = findOccupiedSlot(ns->table, nodeid);
+    if(!slot) {
+        UA_UNLOCK(&ns->lock);
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    }
+
+    UA_CNodeMapEntry *entry = *slot;
+    UA_atomic_xchg((void**)slot, UA_CNODEMAP_TOMBSTONE);
+    unpublishEntry(ns, entry);
+    --ns->count;
+    ++ns->tombstones;
+    /* Downsize the hashmap if it is very empty */
+    if(ns->count * 8 < ns->table->size && ns->table->size > UA_CNODEMAP_MINSIZE)
+        expand(ns); /* Can fail. Just continue with the bigger hashmap. */
+    reclaim(ns);
+    UA_UNLOCK(&ns->lock);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+insertNode(UA_CNodeMap *ns, UA_Node *node, UA_NodeId *addedNodeId) {
+    if(ns->table->size * 3 <= (ns->count + ns->tombstones) * 4) {
+        if(expand(ns) != UA_STATUSCODE_GOOD)
+            return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    UA_CNodeMapTable *t = ns->table;
+    UA_CNodeMapEntry **slot = NULL;
+    if(node->head.nodeId.identifierType == UA_NODEIDTYPE_NUMERIC &&
+       node->head.nodeId.identifier.numeric == 0) {
+        /* Create a random nodeid. See the HashMap Nodestore for details. */
+        UA_UInt32 mask = t->size - 1;
+        UA_UInt32 offset = (ns->count + 1) * 0x9E3779B1u; /* Scatter */
+        UA_UInt32 increase = (offset >> 16) | 0x01;
+        for(UA_UInt32 i = 0; i <= mask; i++) {
+            UA_UInt32 identifier = 50000 + ((offset + (i * increase)) & mask);
+#if SIZE_MAX <= UA_UINT32_MAX
+            /* The compressed "immediate" representation of nodes does not
+             * support the full range on 32bit systems. Generate smaller
+             * identifiers as they can be stored more compactly. */
+            if(identifier >= (0x01 << 24))
+                identifier = identifier % (0x01 << 24);
+#endif
+            node->head.nodeId.identifier.numeric = identifier;
+            slot = findFreeSlot(t, &node->head.nodeId);
+            if(slot)
+                break;
+        }
+    } else {
+        slot = findFreeSlot(t, &node->head.nodeId);
+    }
+
+    if(!slot)
+        return UA_STATUSCODE_BADNODEIDEXISTS;
+
+    /* Copy the NodeId */
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    if(addedNodeId) {
+        retval = UA_NodeId_copy(&node->head.nodeId, addedNodeId);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+
+    /* For new ReferencetypeNodes add to the index map */
+    if(node->head.nodeClass == UA_NODECLASS_REFERENCETYPE) {
+        UA_ReferenceTypeNode *refNode = &node->referenceTypeNode;
+        if(ns->referenceTypeCounter >= UA_REFERENCETYPESET_MAX)
+            return UA_STATUSCODE_BADINTERNALERROR;
+
+        retval = UA_NodeId_copy(&node->head.nodeId,
+                                &ns->referenceTypeIds[ns->referenceTypeCounter]);
+        if(retval != UA_STATUSCODE_GOOD)
+            return UA_STATUSCODE_BADINTERNALERROR;
+
+        /* Assign the ReferenceTypeIndex to the new ReferenceTypeNode */
+        refNode->referenceTypeIndex = ns->referenceTypeCounter;
+        refNode->subTypes = UA_REFTYPESET(ns->referenceTypeCounter);
+
+        ns->referenceTypeCounter++;
+    }
+
+    /* Publish the node */
+    UA_CNodeMapEntry *newEntry = container_of(node, UA_CNodeMapEntry, node);
+    prepareEntry(newEntry);
+    newEntry->nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
+    UA_atomic_xchg(&newEntry->state, UA_CENTRY_LIVE);
+    if(*slot == UA_CNODEMAP_TOMBSTONE)
+        --ns->tombstones;
+    UA_atomic_xchg((void**)slot, newEntry);
+    ++ns->count;
+    return retval;
+}
+
+/* If this function fails in any way, the node parameter is deleted here, so
+ * the caller function does not need to take care of it anymore */
+static UA_StatusCode
+UA_CNodeMap_insertNode(void *context, UA_Node *node,
+                       UA_NodeId *addedNodeId) {
+    UA_CNodeMap *ns = (UA_CNodeMap*)context;
+    UA_CNodeMapEntry *entry = container_of(node, UA_CNodeMapEntry, node);
+    UA_LOCK(&ns->lock);
+    if(entry->orig) {
+        releaseEntry(ns, entry->orig);
+        entry->orig = NULL;
+    }
+    UA_StatusCode res = insertNode(ns, node, addedNodeId);
+    if(res != UA_STATUSCODE_GOOD)
+        deleteEntry(entry);
+    reclaim(ns);
+    UA_UNLOCK(&ns->lock);
+    return res;
+}
+
+static UA_StatusCode
+UA_CNodeMap_replaceNode(void *context, UA_Node *node) {
+    UA_CNodeMap *ns = (UA_CNodeMap*)context;
+    UA_CNodeMapEntry *newEntry = container_of(node, UA_CNodeMapEntry, node);
+    UA_CNodeMapEntry *orig = newEntry->orig;
+    newEntry->orig = NULL;
+
+    UA_LOCK(&ns->lock);
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_CNodeMapEntry **slot = findOccupiedSlot(ns->table, &node->head.nodeId);
+    if(!slot) {
+        res = UA_STATUSCODE_BADNODEIDUNKNOWN;
+    } else if(*slot != orig) {
+        /* The node was already updated since the copy was made */
+        res = UA_STATUSCODE_BADINTERNALERROR;
+    } else if(orig->edit) {
+        /* An edit is open. It would be lost if the node is replaced. */
+        res = UA_STATUSCODE_BADINTERNALERROR;
+    } else {
+        publishReplace(ns, slot, orig, newEntry);
+    }
+
+    if(res != UA_STATUSCODE_GOOD)
+        deleteEntry(newEntry);
+    if(orig)
+        releaseEntry(ns, orig);
+    reclaim(ns);
+    UA_UNLOCK(&ns->lock);
+    return res;
+}
+
+static const UA_NodeId *
+UA_CNodeMap_getReferenceTypeId(void *nsCtx, UA_Byte refTypeIndex) {
+    UA_CNodeMap *ns = (UA_CNodeMap*)nsCtx;
+    if(refTypeIndex >= ns->referenceTypeCounter)
+        return NULL;
+    return &ns->referenceTypeIds[refTypeIndex];
+}
+
+static void
+UA_CNodeMap_iterate(void *context, UA_NodestoreVisitor visitor,
+                    void *visitorContext) {
+    UA_CNodeMap *ns = (UA_CNodeMap*)context;
+    /* Stay in the epoch so that the table is not reclaimed. The visitor can
+     * delete the node. So refcount here. */
+    size_t ticket = enterEpoch(ns);
+    UA_CNodeMapTable *t = (UA_CNodeMapTable*)UA_atomic_load((void**)&ns->table);
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        UA_CNodeMapEntry *entry = (UA_CNodeMapEntry*)
+            UA_atomic_load((void**)&t->slots[i]);
+        if(entry <= UA_CNODEMAP_TOMBSTONE || !acquireEntry(ns, entry))
+            continue;
+        visitor(visitorContext, &entry->node);
+        releaseEntry(ns, entry);
+    }
+    leaveEpoch(ns, ticket);
+}
+
+static void
+UA_CNodeMap_delete(void *context) {
+    /* Already cleaned up? */
+    if(!context)
+        return;
+
+    UA_CNodeMap *ns = (UA_CNodeMap*)context;
+    UA_CNodeMapTable *t = ns->table;
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        if(t->slots[i] > UA_CNODEMAP_TOMBSTONE) {
+            /* On debugging builds, check that all nodes were release */
+            UA_assert(t->slots[i]->refCount == 0);
+            UA_assert(t->slots[i]->edit == NULL);
+            deleteEntry(t->slots[i]);
+        }
+    }
+    UA_free(t);
+
+    /* Free the retired memory. No readers are left. */
+    UA_CNodeMapEntry *retired = ns->retired;
+    while(retired) {
+        UA_CNodeMapEntry *next = retired->next;
+        deleteEntry(retired);
+        retired = next;
+    }
+    for(size_t e = 0; e < 2; e++) {
+        while(ns->limbo[e]) {
+            UA_CNodeMapEntry *next = ns->limbo[e]->next;
+            deleteEntry(ns->limbo[e]);
+            ns->limbo[e] = next;
+        }
+        while(ns->limboTables[e]) {
+            UA_CNodeMapTable *next = ns->limboTables[e]->next;
+            UA_free(ns->limboTables[e]);
+            ns->limboTables[e] = next;
+        }
+    }
+
+    /* Clean up the ReferenceTypes index array */
+    for(size_t i = 0; i < ns->referenceTypeCounter; i++)
+        UA_NodeId_clear(&ns->referenceTypeIds[i]);
+
+    UA_LOCK_DESTROY(&ns->lock);
+    UA_free(ns);
+}
+
+UA_StatusCode
+UA_Nodestore_HashMapConcurrent(UA_Nodestore *ns) {
+    /* Allocate and initialize the nodemap */
+    UA_CNodeMap *nodemap = (UA_CNodeMap*)UA_calloc(1, sizeof(UA_CNodeMap));
+    if(!nodemap)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    nodemap->table = createTable(UA_CNODEMAP_MINSIZE);
+    if(!nodemap->table) {
+        UA_free(nodemap);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    UA_LOCK_INIT(&nodemap->lock);
+
+    /* Populate the nodestore */
+    ns->context = nodemap;
+    ns->clear = UA_CNodeMap_delete;
+    ns->newNode = UA_CNodeMap_newNode;
+    ns->deleteNode = UA_CNodeMap_deleteNode;
+    ns->getNode = UA_CNodeMap_getNode;
+    ns->getNodeFromPtr = UA_CNodeMap_getNodeFromPtr;
+    ns->getEditNode = UA_CNodeMap_getEditNode;
+    ns->getEditNodeFromPtr = UA_CNodeMap_getEditNodeFromPtr;
+    ns->releaseNode = UA_CNodeMap_releaseNode;
+    ns->getNodeCopy = UA_CNodeMap_getNodeCopy;
+    ns->insertNode = UA_CNodeMap_insertNode;
+    ns->replaceNode = UA_CNodeMap_replaceNode;
+    ns->removeNode = UA_CNodeMap_removeNode;
+    ns->getReferenceTypeId = UA_CNodeMap_getReferenceTypeId;
+    ns->iterate = UA_CNodeMap_iterate;
+    ns->concurrentReads = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+#endif /* UA_MULTITHREADING >= 100 */
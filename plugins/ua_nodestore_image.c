@@ -0,0 +1,942 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/plugin/nodestore_default.h>
+
+#ifdef UA_ARCHITECTURE_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* The Image Nodestore serves nodes from a prebuilt binary image of an address
+ * space. The image is not copied. It can be memory-mapped directly from a file.
+ * Nodes are decoded lazily when they are first accessed and then kept in a
+ * writable overlay (a HashMap Nodestore). All changes go to the overlay. The
+ * image itself is never modified.
+ *
+ * Image layout (all integers are little-endian UInt32):
+ *
+ * - Header: magic, version, nodesSize, referenceTypesSize, indexOffset
+ * - Node records (see encodeNode)
+ * - Index: nodesSize x (NodeId hash, record offset), sorted by the hash
+ * - ReferenceTypes: referenceTypesSize x (position in the index), in the order
+ *   of the ReferenceTypeIndex
+ *
+ * Variable-length fields in the records are encoded in the OPC UA binary
+ * encoding with a length prefix. A bit per index entry marks the nodes that
+ * were already loaded into the overlay. That way removed nodes are not
+ * resurrected from the image.
+ *
+ * The ReferenceTypeIndex of a ReferenceTypeNode is assigned when it is
+ * inserted into a Nodestore. Therefore all ReferenceTypeNodes are loaded in
+ * their original order when the image is opened. */
+
+#define UA_NODESTORE_IMAGE_MAGIC 0x494e4155 /* "UANI" */
+#define UA_NODESTORE_IMAGE_VERSION 1
+#define UA_NODESTORE_IMAGE_HEADERSIZE 20
+#define UA_NODESTORE_IMAGE_FIRSTID 50000
+
+typedef struct {
+    UA_Nodestore overlay;
+    UA_ByteString image;
+    UA_DecodeBinaryOptions decodeOptions;
+    UA_UInt32 nodesSize;
+    const UA_Byte *index;
+    UA_Byte *loaded; /* Bitfield over the index positions */
+    UA_UInt32 nextId;
+    UA_Boolean mapped; /* The image was mapped by UA_Nodestore_ImageFile */
+} UA_NodestoreImage;
+
+static UA_UInt32
+loadUInt32(const UA_Byte *p) {
+    return (UA_UInt32)p[0] | ((UA_UInt32)p[1] << 8) |
+        ((UA_UInt32)p[2] << 16) | ((UA_UInt32)p[3] << 24);
+}
+
+static void
+storeUInt32(UA_Byte *p, UA_UInt32 v) {
+    p[0] = (UA_Byte)v;
+    p[1] = (UA_Byte)(v >> 8);
+    p[2] = (UA_Byte)(v >> 16);
+    p[3] = (UA_Byte)(v >> 24);
+}
+
+/****************/
+/* Image Writer */
+/****************/
+
+/* The writer stops at the first error. So that the encoding functions do not
+ * need to check the result of every step. */
+typedef struct {
+    UA_ByteString buf; /* The length is the capacity */
+    size_t pos;
+    UA_StatusCode res;
+} ImageWriter;
+
+static UA_Byte *
+reserve(ImageWriter *w, size_t len) {
+    if(w->res != UA_STATUSCODE_GOOD)
+        return NULL;
+    if(w->pos + len > w->buf.length) {
+        size_t newLength = (w->buf.length > 0) ? w->buf.length : 1024;
+        while(w->pos + len > newLength)
+            newLength *= 2;
+        UA_Byte *data = (UA_Byte*)UA_realloc(w->buf.data, newLength);
+        if(!data) {
+            w->res = UA_STATUSCODE_BADOUTOFMEMORY;
+            return NULL;
+        }
+        w->buf.data = data;
+        w->buf.length = newLength;
+    }
+    UA_Byte *p = &w->buf.data[w->pos];
+    w->pos += len;
+    return p;
+}
+
+static void
+writeUInt32(ImageWriter *w, UA_UInt32 v) {
+    UA_Byte *p = reserve(w, 4);
+    if(p)
+        storeUInt32(p, v);
+}
+
+static void
+writeByte(ImageWriter *w, UA_Byte v) {
+    UA_Byte *p = reserve(w, 1);
+    if(p)
+        *p = v;
+}
+
+static void
+writeField(ImageWriter *w, const void *src, const UA_DataType *type) {
+    if(w->res != UA_STATUSCODE_GOOD)
+        return;
+    size_t len = UA_calcSizeBinary(src, type, NULL);
+    if(len == 0 || len > UA_UINT32_MAX) {
+        w->res = UA_STATUSCODE_BADENCODINGERROR;
+        return;
+    }
+    writeUInt32(w, (UA_UInt32)len);
+    UA_ByteString out = {len, reserve(w, len)};
+    if(out.data)
+        w->res = UA_encodeBinary(src, type, &out, NULL);
+}
+
+static void
+writeLocalizedTextList(ImageWriter *w, const UA_LocalizedTextListEntry *lt) {
+    UA_UInt32 count = 0;
+    for(const UA_LocalizedTextListEntry *e = lt; e; e = e->next)
+        count++;
+    writeUInt32(w, count);
+    for(; lt; lt = lt->next)
+        writeField(w, &lt->localizedText, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+}
+
+static void *
+writeReferenceTarget(void *context, UA_ReferenceTarget *t) {
+    ImageWriter *w = (ImageWriter*)context;
+    UA_ExpandedNodeId target = UA_NodePointer_toExpandedNodeId(t->targetId);
+    writeField(w, &target, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    writeUInt32(w, t->targetNameHash);
+    return NULL;
+}
+
+static void
+writeVariableAttributes(ImageWriter *w, const UA_Node *node) {
+    /* Only static values are part of the image. DataSources, callbacks and
+     * value backends have to be attached again at runtime. */
+    const UA_VariableNode *vn = &node->variableNode; /* Same layout for the
+                                                      * VariableTypeNode */
+    writeField(w, &vn->dataType, &UA_TYPES[UA_TYPES_NODEID]);
+    writeUInt32(w, (UA_UInt32)vn->valueRank);
+    writeUInt32(w, (UA_UInt32)vn->arrayDimensionsSize);
+    for(size_t i = 0; i < vn->arrayDimensionsSize; i++)
+        writeUInt32(w, vn->arrayDimensions[i]);
+    UA_DataValue empty;
+    UA_DataValue_init(&empty);
+    const UA_DataValue *value = &empty;
+    if(vn->valueSource == UA_VALUESOURCE_DATA &&
+       vn->valueBackend.backendType == UA_VALUEBACKENDTYPE_NONE)
+        value = &vn->value.data.value;
+    writeField(w, value, &UA_TYPES[UA_TYPES_DATAVALUE]);
+}
+
+static void
+encodeNode(ImageWriter *w, const UA_Node *node) {
+    const UA_NodeHead *head = &node->head;
+    writeField(w, &head->nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+    writeUInt32(w, (UA_UInt32)head->nodeClass);
+    writeField(w, &head->browseName, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+    writeLocalizedTextList(w, head->displayName);
+    writeLocalizedTextList(w, head->description);
+    writeUInt32(w, head->writeMask);
+    writeByte(w, head->constructed);
+
+    writeUInt32(w, (UA_UInt32)head->referencesSize);
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &head->references[i];
+        writeByte(w, rk->referenceTypeIndex);
+        writeByte(w, rk->isInverse);
+        writeUInt32(w, (UA_UInt32)rk->targetsSize);
+        UA_NodeReferenceKind_iterate(rk, writeReferenceTarget, w);
+    }
+
+    switch(head->nodeClass) {
+    case UA_NODECLASS_VARIABLE:
+        writeVariableAttributes(w, node);
+        writeByte(w, node->variableNode.accessLevel);
+        writeField(w, &node->variableNode.minimumSamplingInterval,
+                   &UA_TYPES[UA_TYPES_DOUBLE]);
+        writeByte(w, node->variableNode.historizing);
+        writeByte(w, node->variableNode.isDynamic);
+        break;
+    case UA_NODECLASS_VARIABLETYPE:
+        writeVariableAttributes(w, node);
+        writeByte(w, node->variableTypeNode.isAbstract);
+        break;
+    case UA_NODECLASS_METHOD:
+        writeByte(w, node->methodNode.executable);
+        break;
+    case UA_NODECLASS_OBJECT:
+        writeByte(w, node->objectNode.eventNotifier);
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        writeByte(w, node->objectTypeNode.isAbstract);
+        break;
+    case UA_NODECLASS_REFERENCETYPE:
+        writeByte(w, node->referenceTypeNode.isAbstract);
+        writeByte(w, node->referenceTypeNode.symmetric);
+        writeField(w, &node->referenceTypeNode.inverseName,
+                   &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+        writeByte(w, node->referenceTypeNode.referenceTypeIndex);
+        for(size_t i = 0; i < UA_REFERENCETYPESET_MAX / 32; i++)
+            writeUInt32(w, node->referenceTypeNode.subTypes.bits[i]);
+        break;
+    case UA_NODECLASS_DATATYPE:
+        writeByte(w, node->dataTypeNode.isAbstract);
+        break;
+    case UA_NODECLASS_VIEW:
+        writeByte(w, node->viewNode.eventNotifier);
+        writeByte(w, node->viewNode.containsNoLoops);
+        break;
+    default:
+        w->res = UA_STATUSCODE_BADENCODINGERROR;
+        break;
+    }
+}
+
+typedef struct {
+    UA_UInt32 hash;
+    UA_UInt32 offset;
+    UA_UInt32 refType; /* ReferenceTypeIndex + 1 or zero */
+} ImageIndexEntry;
+
+typedef struct {
+    ImageWriter w;
+    ImageIndexEntry *index;
+    size_t indexSize;
+    size_t indexCapacity;
+} ImageSaveContext;
+
+static void
+saveNodeVisitor(void *context, const UA_Node *node) {
+    ImageSaveContext *sc = (ImageSaveContext*)context;
+    if(sc->w.res != UA_STATUSCODE_GOOD)
+        return;
+
+    if(sc->indexSize == sc->indexCapacity) {
+        size_t newCapacity = (sc->indexCapacity > 0) ? sc->indexCapacity * 2 : 1024;
+        ImageIndexEntry *index = (ImageIndexEntry*)
+            UA_realloc(sc->index, newCapacity * sizeof(ImageIndexEntry));
+        if(!index) {
+            sc->w.res = UA_STATUSCODE_BADOUTOFMEMORY;
+            return;
+        }
+        sc->index = index;
+        sc->indexCapacity = newCapacity;
+    }
+
+    ImageIndexEntry *e = &sc->index[sc->indexSize++];
+    e->hash = UA_NodeId_hash(&node->head.nodeId);
+    e->offset = (UA_UInt32)sc->w.pos;
+    e->refType = 0;
+    if(node->head.nodeClass == UA_NODECLASS_REFERENCETYPE)
+        e->refType = (UA_UInt32)node->referenceTypeNode.referenceTypeIndex + 1;
+    encodeNode(&sc->w, node);
+    if(sc->w.pos > UA_UINT32_MAX)
+        sc->w.res = UA_STATUSCODE_BADENCODINGERROR;
+}
+
+static int
+cmpIndexEntry(const void *a, const void *b) {
+    const ImageIndexEntry *aa = (const ImageIndexEntry*)a;
+    const ImageIndexEntry *bb = (const ImageIndexEntry*)b;
+    if(aa->hash != bb->hash)
+        return (aa->hash < bb->hash) ? -1 : 1;
+    if(aa->offset != bb->offset)
+        return (aa->offset < bb->offset) ? -1 : 1;
+    return 0;
+}
+
+UA_StatusCode
+UA_Nodestore_saveImage(UA_Nodestore *ns, UA_ByteString *image) {
+    if(!ns || !ns->iterate || !image)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    ImageSaveContext sc;
+    memset(&sc, 0, sizeof(ImageSaveContext));
+    reserve(&sc.w, UA_NODESTORE_IMAGE_HEADERSIZE);
+    ns->iterate(ns->context, saveNodeVisitor, &sc);
+
+    /* Sort the index by the NodeId hash */
+    if(sc.indexSize > 0)
+        qsort(sc.index, sc.indexSize, sizeof(ImageIndexEntry), cmpIndexEntry);
+
+    /* Position of the ReferenceTypes in the index */
+    UA_UInt32 refPos[UA_REFERENCETYPESET_MAX];
+    size_t refCount = 0;
+    for(size_t i = 0; i < sc.indexSize; i++) {
+        if(sc.index[i].refType == 0)
+            continue;
+        UA_UInt32 refIndex = sc.index[i].refType - 1;
+        if(refIndex >= UA_REFERENCETYPESET_MAX) {
+            sc.w.res = UA_STATUSCODE_BADINTERNALERROR;
+            break;
+        }
+        refPos[refIndex] = (UA_UInt32)i;
+        refCount++;
+    }
+
+    /* The ReferenceTypeIndex has to be dense. It is reassigned in-order when
+     * the ReferenceTypeNodes are loaded from the image. */
+    for(size_t i = 0; i < refCount && sc.w.res == UA_STATUSCODE_GOOD; i++) {
+        if(sc.index[refPos[i]].refType != i + 1)
+            sc.w.res = UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Write the index and the ReferenceType table */
+    size_t indexOffset = sc.w.pos;
+    if(indexOffset > UA_UINT32_MAX || sc.indexSize > UA_UINT32_MAX)
+        sc.w.res = UA_STATUSCODE_BADENCODINGERROR;
+    for(size_t i = 0; i < sc.indexSize; i++) {
+        writeUInt32(&sc.w, sc.index[i].hash);
+        writeUInt32(&sc.w, sc.index[i].offset);
+    }
+    for(size_t i = 0; i < refCount; i++)
+        writeUInt32(&sc.w, refPos[i]);
+    UA_free(sc.index);
+
+    if(sc.w.res != UA_STATUSCODE_GOOD) {
+        UA_free(sc.w.buf.data);
+        return sc.w.res;
+    }
+
+    /* Write the header */
+    UA_Byte *header = sc.w.buf.data;
+    storeUInt32(&header[0], UA_NODESTORE_IMAGE_MAGIC);
+    storeUInt32(&header[4], UA_NODESTORE_IMAGE_VERSION);
+    storeUInt32(&header[8], (UA_UInt32)sc.indexSize);
+    storeUInt32(&header[12], (UA_UInt32)refCount);
+    storeUInt32(&header[16], (UA_UInt32)indexOffset);
+
+    image->data = sc.w.buf.data;
+    image->length = sc.w.pos;
+    return UA_STATUSCODE_GOOD;
+}
+
+/****************/
+/* Image Reader */
+/****************/
+
+typedef struct {
+    const UA_ByteString *buf;
+    const UA_DecodeBinaryOptions *options;
+    size_t pos;
+    UA_StatusCode res;
+} ImageReader;
+
+static UA_UInt32
+readUInt32(ImageReader *r) {
+    if(r->res != UA_STATUSCODE_GOOD)
+        return 0;
+    if(r->buf->length - r->pos < 4) {
+        r->res = UA_STATUSCODE_BADDECODINGERROR;
+        return 0;
+    }
+    UA_UInt32 v = loadUInt32(&r->buf->data[r->pos]);
+    r->pos += 4;
+    return v;
+}
+
+static UA_Byte
+readByte(ImageReader *r) {
+    if(r->res != UA_STATUSCODE_GOOD)
+        return 0;
+    if(r->buf->length - r->pos < 1) {
+        r->res = UA_STATUSCODE_BADDECODINGERROR;
+        return 0;
+    }
+    return r->buf->data[r->pos++];
+}
+
+/* The destination is initialized also if decoding fails */
+static void
+readField(ImageReader *r, void *dst, const UA_DataType *type) {
+    UA_init(dst, type);
+    UA_UInt32 len = readUInt32(r);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+    if(r->buf->length - r->pos < len) {
+        r->res = UA_STATUSCODE_BADDECODINGERROR;
+        return;
+    }
+    UA_ByteString field = {len, &r->buf->data[r->pos]};
+    r->res = UA_decodeBinary(&field, dst, type, r->options);
+    r->pos += len;
+}
+
+static void
+readLocalizedTextList(ImageReader *r, UA_LocalizedTextListEntry **list) {
+    UA_UInt32 count = readUInt32(r);
+    for(UA_UInt32 i = 0; i < count && r->res == UA_STATUSCODE_GOOD; i++) {
+        UA_LocalizedTextListEntry *e = (UA_LocalizedTextListEntry*)
+            UA_malloc(sizeof(UA_LocalizedTextListEntry));
+        if(!e) {
+            r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+            return;
+        }
+        e->next = NULL;
+        readField(r, &e->localizedText, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+        *list = e; /* Append to keep the order */
+        list = &e->next;
+    }
+}
+
+static void
+readReferences(ImageReader *r, UA_NodeHead *head) {
+    UA_UInt32 refsSize = readUInt32(r);
+    if(r->res != UA_STATUSCODE_GOOD || refsSize == 0)
+        return;
+    if(refsSize > r->buf->length - r->pos) {
+        r->res = UA_STATUSCODE_BADDECODINGERROR;
+        return;
+    }
+    head->references = (UA_NodeReferenceKind*)
+        UA_calloc(refsSize, sizeof(UA_NodeReferenceKind));
+    if(!head->references) {
+        r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    head->referencesSize = refsSize;
+
+    /* The targets are always restored into an array. The Nodestore switches to
+     * the tree representation for large ReferenceKinds. */
+    for(size_t i = 0; i < refsSize && r->res == UA_STATUSCODE_GOOD; i++) {
+        UA_NodeReferenceKind *rk = &head->references[i];
+        rk->referenceTypeIndex = readByte(r);
+        rk->isInverse = readByte(r);
+        UA_UInt32 targetsSize = readUInt32(r);
+        if(r->res != UA_STATUSCODE_GOOD || targetsSize == 0)
+            continue;
+        if(targetsSize > r->buf->length - r->pos) {
+            r->res = UA_STATUSCODE_BADDECODINGERROR;
+            return;
+        }
+        rk->targets.array = (UA_ReferenceTarget*)
+            UA_calloc(targetsSize, sizeof(UA_ReferenceTarget));
+        if(!rk->targets.array) {
+            r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+            return;
+        }
+        for(size_t j = 0; j < targetsSize && r->res == UA_STATUSCODE_GOOD; j++) {
+            UA_ExpandedNodeId target;
+            readField(r, &target, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+            UA_ReferenceTarget *t = &rk->targets.array[j];
+            t->targetNameHash = readUInt32(r);
+            if(r->res == UA_STATUSCODE_GOOD)
+                r->res = UA_NodePointer_copy(UA_NodePointer_fromExpandedNodeId(&target),
+                                             &t->targetId);
+            UA_ExpandedNodeId_clear(&target);
+            if(r->res == UA_STATUSCODE_GOOD)
+                rk->targetsSize++;
+        }
+    }
+}
+
+static void
+readVariableAttributes(ImageReader *r, UA_Node *node) {
+    UA_VariableNode *vn = &node->variableNode;
+    readField(r, &vn->dataType, &UA_TYPES[UA_TYPES_NODEID]);
+    vn->valueRank = (UA_Int32)readUInt32(r);
+    UA_UInt32 dimsSize = readUInt32(r);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+    if(dimsSize > 0) {
+        if(dimsSize > (r->buf->length - r->pos) / 4) {
+            r->res = UA_STATUSCODE_BADDECODINGERROR;
+            return;
+        }
+        vn->arrayDimensions = (UA_UInt32*)
+            UA_Array_new(dimsSize, &UA_TYPES[UA_TYPES_UINT32]);
+        if(!vn->arrayDimensions) {
+            r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+            return;
+        }
+        vn->arrayDimensionsSize = dimsSize;
+        for(size_t i = 0; i < dimsSize; i++)
+            vn->arrayDimensions[i] = readUInt32(r);
+    }
+    vn->valueSource = UA_VALUESOURCE_DATA;
+    readField(r, &vn->value.data.value, &UA_TYPES[UA_TYPES_DATAVALUE]);
+}
+
+static UA_StatusCode
+decodeNode(UA_NodestoreImage *ns, UA_UInt32 offset, UA_Node **outNode) {
+    ImageReader r = {&ns->image, &ns->decodeOptions, offset, UA_STATUSCODE_GOOD};
+
+    /* Create the node of the right class */
+    UA_NodeId id;
+    readField(&r, &id, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_NodeClass nodeClass = (UA_NodeClass)readUInt32(&r);
+    if(r.res != UA_STATUSCODE_GOOD) {
+        UA_NodeId_clear(&id);
+        return r.res;
+    }
+    UA_Node *node = ns->overlay.newNode(ns->overlay.context, nodeClass);
+    if(!node) {
+        UA_NodeId_clear(&id);
+        return UA_STATUSCODE_BADDECODINGERROR;
+    }
+
+    UA_NodeHead *head = &node->head;
+    head->nodeId = id;
+    readField(&r, &head->browseName, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+    readLocalizedTextList(&r, &head->displayName);
+    readLocalizedTextList(&r, &head->description);
+    head->writeMask = readUInt32(&r);
+    head->constructed = readByte(&r);
+    readReferences(&r, head);
+
+    switch(nodeClass) {
+    case UA_NODECLASS_VARIABLE:
+        readVariableAttributes(&r, node);
+        node->variableNode.accessLevel = readByte(&r);
+        readField(&r, &node->variableNode.minimumSamplingInterval,
+                  &UA_TYPES[UA_TYPES_DOUBLE]);
+        node->variableNode.historizing = readByte(&r);
+        node->variableNode.isDynamic = readByte(&r);
+        break;
+    case UA_NODECLASS_VARIABLETYPE:
+        readVariableAttributes(&r, node);
+        node->variableTypeNode.isAbstract = readByte(&r);
+        break;
+    case UA_NODECLASS_METHOD:
+        node->methodNode.executable = readByte(&r);
+        break;
+    case UA_NODECLASS_OBJECT:
+        node->objectNode.eventNotifier = readByte(&r);
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        node->objectTypeNode.isAbstract = readByte(&r);
+        break;
+    case UA_NODECLASS_REFERENCETYPE:
+        node->referenceTypeNode.isAbstract = readByte(&r);
+        node->referenceTypeNode.symmetric = readByte(&r);
+        readField(&r, &node->referenceTypeNode.inverseName,
+                  &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+        node->referenceTypeNode.referenceTypeIndex = readByte(&r);
+        for(size_t i = 0; i < UA_REFERENCETYPESET_MAX / 32; i++)
+            node->referenceTypeNode.subTypes.bits[i] = readUInt32(&r);
+        break;
+    case UA_NODECLASS_DATATYPE:
+        node->dataTypeNode.isAbstract = readByte(&r);
+        break;
+    case UA_NODECLASS_VIEW:
+        node->viewNode.eventNotifier = readByte(&r);
+        node->viewNode.containsNoLoops = readByte(&r);
+        break;
+    default:
+        r.res = UA_STATUSCODE_BADDECODINGERROR;
+        break;
+    }
+
+    if(r.res != UA_STATUSCODE_GOOD) {
+        ns->overlay.deleteNode(ns->overlay.context, node);
+        return r.res;
+    }
+    *outNode = node;
+    return UA_STATUSCODE_GOOD;
+}
+
+/*****************/
+/* Image Lookup  */
+/*****************/
+
+static UA_UInt32
+indexHash(const UA_NodestoreImage *ns, UA_UInt32 pos) {
+    return loadUInt32(&ns->index[pos * 8]);
+}
+
+static UA_UInt32
+indexOffset(const UA_NodestoreImage *ns, UA_UInt32 pos) {
+    return loadUInt32(&ns->index[(pos * 8) + 4]);
+}
+
+static UA_Boolean
+isLoaded(const UA_NodestoreImage *ns, UA_UInt32 pos) {
+    return (ns->loaded[pos / 8] & (1 << (pos % 8))) != 0;
+}
+
+static void
+setLoaded(UA_NodestoreImage *ns, UA_UInt32 pos) {
+    ns->loaded[pos / 8] |= (UA_Byte)(1 << (pos % 8));
+}
+
+/* Returns the position in the index or UA_UINT32_MAX if not found */
+static UA_UInt32
+findImageNode(const UA_NodestoreImage *ns, const UA_NodeId *nodeId) {
+    /* Binary search for the first entry with the hash */
+    UA_UInt32 hash = UA_NodeId_hash(nodeId);
+    UA_UInt32 lo = 0, hi = ns->nodesSize;
+    while(lo < hi) {
+        UA_UInt32 mid = lo + ((hi - lo) / 2);
+        if(indexHash(ns, mid) < hash)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    /* Compare the NodeId of all entries with a matching hash */
+    for(; lo < ns->nodesSize && indexHash(ns, lo) == hash; lo++) {
+        ImageReader r = {&ns->image, &ns->decodeOptions,
+                         indexOffset(ns, lo), UA_STATUSCODE_GOOD};
+        UA_NodeId id;
+        readField(&r, &id, &UA_TYPES[UA_TYPES_NODEID]);
+        UA_Boolean found = (r.res == UA_STATUSCODE_GOOD && UA_NodeId_equal(&id, nodeId));
+        UA_NodeId_clear(&id);
+        if(found)
+            return lo;
+    }
+    return UA_UINT32_MAX;
+}
+
+/* Decode the node at the index position and insert into the overlay */
+static UA_StatusCode
+loadNodeAt(UA_NodestoreImage *ns, UA_UInt32 pos) {
+    setLoaded(ns, pos);
+    UA_Node *node = NULL;
+    UA_StatusCode res = decodeNode(ns, indexOffset(ns, pos), &node);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* The overlay assigns a new ReferenceTypeIndex and resets the subtypes */
+    if(node->head.nodeClass != UA_NODECLASS_REFERENCETYPE)
+        return ns->overlay.insertNode(ns->overlay.context, node, NULL);
+
+    UA_Byte refIndex = node->referenceTypeNode.referenceTypeIndex;
+    UA_ReferenceTypeSet subTypes = node->referenceTypeNode.subTypes;
+    UA_NodeId id;
+    res = UA_NodeId_copy(&node->head.nodeId, &id);
+    if(res != UA_STATUSCODE_GOOD) {
+        ns->overlay.deleteNode(ns->overlay.context, node);
+        return res;
+    }
+    res = ns->overlay.insertNode(ns->overlay.context, node, NULL);
+    if(res == UA_STATUSCODE_GOOD) {
+        UA_Node *edit = ns->overlay.getEditNode(ns->overlay.context, &id,
+                                                UA_NODEATTRIBUTESMASK_NONE,
+                                                UA_REFERENCETYPESET_NONE,
+                                                UA_BROWSEDIRECTION_INVALID);
+        if(edit && edit->referenceTypeNode.referenceTypeIndex == refIndex)
+            edit->referenceTypeNode.subTypes = subTypes;
+        else
+            res = UA_STATUSCODE_BADINTERNALERROR;
+        ns->overlay.releaseNode(ns->overlay.context, edit);
+    }
+    UA_NodeId_clear(&id);
+    return res;
+}
+
+/* Load the node from the image if it was not loaded before */
+static UA_StatusCode
+loadNode(UA_NodestoreImage *ns, const UA_NodeId *nodeId) {
+    UA_UInt32 pos = findImageNode(ns, nodeId);
+    if(pos == UA_UINT32_MAX || isLoaded(ns, pos))
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    return loadNodeAt(ns, pos);
+}
+
+/***********************/
+/* Interface functions */
+/***********************/
+
+static UA_Node *
+UA_NodestoreImage_newNode(void *context, UA_NodeClass nodeClass) {
+    UA_NodestoreImage *ns = (UA_NodestoreImage*)context;
+    return ns->overlay.newNode(ns->overlay.context, nodeClass);
+}
+
+static void
+UA_NodestoreImage_deleteNode(void *context, UA_Node *node) {
+    UA_NodestoreImage *ns = (UA_NodestoreImage*)context;
+    ns->overlay.deleteNode(ns->overlay.context, node);
+}
+
+static const UA_Node *
+UA_NodestoreImage_getNode(void *context, const UA_NodeId *nodeId,
+                          UA_UInt32 attributeMask,
+                          UA_ReferenceTypeSet references,
+                          UA_BrowseDirection referenceDirections) {
+    UA_NodestoreImage *ns = (UA_NodestoreImage*)context;
+    const UA_Node *node =
+        ns->overlay.getNode(ns->overlay.context, nodeId, attributeMask,
+                            references, referenceDirections);
+    if(node || loadNode(ns, nodeId) != UA_STATUSCODE_GOOD)
+        return node;
+    return ns->overlay.getNode(ns->overlay.context, nodeId, attributeMask,
+                               references, referenceDirections);
+}
+
+static const UA_Node *
+UA_NodestoreImage_getNodeFromPtr(void *context, UA_NodePointer ptr,
+                                 UA_UInt32 attributeMask,
+                                 UA_ReferenceTypeSet references,
+                                 UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return UA_NodestoreImage_getNode(context, &id, attributeMask,
+                                     references, referenceDirections);
+}
+
+static UA_Node *
+UA_NodestoreImage_getEditNode(void *context, const UA_NodeId *nodeId,
+                              UA_UInt32 attributeMask,
+                              UA_ReferenceTypeSet references,
+                              UA_BrowseDirection referenceDirections) {
+    UA_NodestoreImage *ns = (UA_NodestoreImage*)context;
+    UA_Node *node =
+        ns->overlay.getEditNode(ns->overlay.context, nodeId, attributeMask,
+                                references, referenceDirections);
+    if(node || loadNode(ns, nodeId) != UA_STATUSCODE_GOOD)
+        return node;
+    return ns->overlay.getEditNode(ns->overlay.context, nodeId, attributeMask,
+                                   references, referenceDirections);
+}
+
+static UA_Node *
+UA_NodestoreImage_getEditNodeFromPtr(void *context, UA_NodePointer ptr,
+                                     UA_UInt32 attributeMask,
+                                     UA_ReferenceTypeSet references,
+                                     UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return UA_NodestoreImage_getEditNode(context, &id, attributeMask,
+                                         references, referenceDirections);
+}
+
+static void
+UA_NodestoreImage_releaseNode(void *context, const UA_Node *node) {
+    UA_NodestoreImage *ns = (UA_NodestoreImage*)context;
+    ns->overlay.releaseNode(ns->overlay.context, node);
+}
+
+static UA_StatusCode
+UA_NodestoreImage_getNodeCopy(void *context, const UA_NodeId *nodeId,
+                              UA_Node **outNode) {
+    UA_NodestoreImage *ns = (UA_NodestoreImage*)context;
+    UA_StatusCode res = ns->overlay.getNodeCopy(ns->overlay.context, nodeId, outNode);
+    if(res != UA_STATUSCODE_BADNODEIDUNKNOWN ||
+       loadNode(ns, nodeId) != UA_STATUSCODE_GOOD)
+        return res;
+    return ns->overlay.getNodeCopy(ns->overlay.context, nodeId, outNode);
+}
+
+static UA_StatusCode
+UA_NodestoreImage_insertNode(void *context, UA_Node *node,
+                             UA_NodeId *addedNodeId) {
+    UA_NodestoreImage *ns = (UA_NodestoreImage*)context;
+    UA_NodeId *id = &node->head.nodeId;
+    if(id->identifierType == UA_NODEIDTYPE_NUMERIC && id->identifier.numeric == 0) {
+        /* Assign a fresh NodeId that is neither in the image nor the overlay */
+        for(;;) {
+            id->identifier.numeric = ns->nextId++;
+            if(ns->nextId == 0)
+                ns->nextId = UA_NODESTORE_IMAGE_FIRSTID;
+            if(findImageNode(ns, id) != UA_UINT32_MAX)
+                continue;
+            const UA_Node *other =
+                ns->overlay.getNode(ns->overlay.context, id,
+                                    UA_NODEATTRIBUTESMASK_NONE,
+                                    UA_REFERENCETYPESET_NONE,
+                                    UA_BROWSEDIRECTION_INVALID);
+            if(!other)
+                break;
+            ns->overlay.releaseNode(ns->overlay.context, other);
+        }
+    } else {
+        /* The NodeId exists in the image. Nodes that were loaded and then
+         * removed can be added again. */
+        UA_UInt32 pos = findImageNode(ns, id);
+        if(pos != UA_UINT32_MAX && !isLoaded(ns, pos)) {
+            ns->overlay.deleteNode(ns->overlay.context, node);
+            return UA_STATUSCODE_BADNODEIDEXISTS;
+        }
+    }
+    return ns->overlay.insertNode(ns->overlay.context, node, addedNodeId);
+}
+
+static UA_StatusCode
+UA_NodestoreImage_replaceNode(void *context, UA_Node *node) {
+    UA_NodestoreImage *ns = (UA_NodestoreImage*)context;
+    return ns->overlay.replaceNode(ns->overlay.context, node);
+}
+
+static UA_StatusCode
+UA_NodestoreImage_removeNode(void *context, const UA_NodeId *nodeId) {
+    UA_NodestoreImage *ns = (UA_NodestoreImage*)context;
+    /* Not loaded yet. Mark as loaded so that it is not loaded anymore. */
+    UA_UInt32 pos = findImageNode(ns, nodeId);
+    if(pos != UA_UINT32_MAX && !isLoaded(ns, pos)) {
+        setLoaded(ns, pos);
+        return UA_STATUSCODE_GOOD;
+    }
+    return ns->overlay.removeNode(ns->overlay.context, nodeId);
+}
+
+static const UA_NodeId *
+UA_NodestoreImage_getReferenceTypeId(void *context, UA_Byte refTypeIndex) {
+    UA_NodestoreImage *ns = (UA_NodestoreImage*)context;
+    return ns->overlay.getReferenceTypeId(ns->overlay.context, refTypeIndex);
+}
+
+static void
+UA_NodestoreImage_iterate(void *context, UA_NodestoreVisitor visitor,
+                          void *visitorCtx) {
+    UA_NodestoreImage *ns = (UA_NodestoreImage*)context;
+    for(UA_UInt32 i = 0; i < ns->nodesSize; i++) {
+        if(!isLoaded(ns, i))
+            loadNodeAt(ns, i);
+    }
+    ns->overlay.iterate(ns->overlay.context, visitor, visitorCtx);
+}
+
+static void
+UA_NodestoreImage_clear(void *context) {
+    UA_NodestoreImage *ns = (UA_NodestoreImage*)context;
+    ns->overlay.clear(ns->overlay.context);
+#ifdef UA_ARCHITECTURE_POSIX
+    if(ns->mapped)
+        munmap(ns->image.data, ns->image.length);
+#endif
+    UA_free(ns->loaded);
+    UA_free(ns);
+}
+
+UA_StatusCode
+UA_Nodestore_Image(UA_Nodestore *ns, const UA_ByteString *image,
+                   const UA_DataTypeArray *customTypes) {
+    if(!ns || !image)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* Validate the header */
+    if(image->length < UA_NODESTORE_IMAGE_HEADERSIZE ||
+       loadUInt32(&image->data[0]) != UA_NODESTORE_IMAGE_MAGIC ||
+       loadUInt32(&image->data[4]) != UA_NODESTORE_IMAGE_VERSION)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    UA_UInt32 nodesSize = loadUInt32(&image->data[8]);
+    UA_UInt32 refTypesSize = loadUInt32(&image->data[12]);
+    UA_UInt32 indexOffset = loadUInt32(&image->data[16]);
+    if(refTypesSize > UA_REFERENCETYPESET_MAX ||
+       indexOffset < UA_NODESTORE_IMAGE_HEADERSIZE ||
+       (UA_UInt64)indexOffset + (UA_UInt64)nodesSize * 8 +
+       (UA_UInt64)refTypesSize * 4 > image->length)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    /* Allocate the context */
+    UA_NodestoreImage *ctx = (UA_NodestoreImage*)UA_calloc(1, sizeof(UA_NodestoreImage));
+    if(!ctx)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    ctx->loaded = (UA_Byte*)UA_calloc((nodesSize / 8) + 1, 1);
+    UA_StatusCode res = (ctx->loaded) ?
+        UA_Nodestore_HashMap(&ctx->overlay) : UA_STATUSCODE_BADOUTOFMEMORY;
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(ctx->loaded);
+        UA_free(ctx);
+        return res;
+    }
+    ctx->image = *image;
+    ctx->decodeOptions.customTypes = customTypes;
+    ctx->nodesSize = nodesSize;
+    ctx->index = &image->data[indexOffset];
+    ctx->nextId = UA_NODESTORE_IMAGE_FIRSTID;
+
+    /* Load the ReferenceTypes in the order of their ReferenceTypeIndex */
+    const UA_Byte *refTypes = &ctx->index[(size_t)nodesSize * 8];
+    for(UA_UInt32 i = 0; i < refTypesSize; i++) {
+        UA_UInt32 pos = loadUInt32(&refTypes[i * 4]);
+        res = (pos < nodesSize && !isLoaded(ctx, pos)) ?
+            loadNodeAt(ctx, pos) : UA_STATUSCODE_BADDECODINGERROR;
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_NodestoreImage_clear(ctx);
+            return res;
+        }
+    }
+
+    /* Populate the nodestore */
+    ns->context = ctx;
+    ns->clear = UA_NodestoreImage_clear;
+    ns->newNode = UA_NodestoreImage_newNode;
+    ns->deleteNode = UA_NodestoreImage_deleteNode;
+    ns->getNode = UA_NodestoreImage_getNode;
+    ns->getNodeFromPtr = UA_NodestoreImage_getNodeFromPtr;
+    ns->getEditNode = UA_NodestoreImage_getEditNode;
+    ns->getEditNodeFromPtr = UA_NodestoreImage_getEditNodeFromPtr;
+    ns->releaseNode = UA_NodestoreImage_releaseNode;
+    ns->getNodeCopy = UA_NodestoreImage_getNodeCopy;
+    ns->insertNode = UA_NodestoreImage_insertNode;
+    ns->replaceNode = UA_NodestoreImage_replaceNode;
+    ns->removeNode = UA_NodestoreImage_removeNode;
+    ns->getReferenceTypeId = UA_NodestoreImage_getReferenceTypeId;
+    ns->iterate = UA_NodestoreImage_iterate;
+    ns->concurrentReads = false;
+    return UA_STATUSCODE_GOOD;
+}
+
+#ifdef UA_ARCHITECTURE_POSIX
+UA_StatusCode
+UA_Nodestore_ImageFile(UA_Nodestore *ns, const char *path,
+                       const UA_DataTypeArray *customTypes) {
+    if(!ns || !path)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return UA_STATUSCODE_BADNOTFOUND;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return UA_STATUSCODE_BADDECODINGERROR;
+    }
+
+    /* The mapping stays valid after the file is closed */
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    UA_ByteString image = {(size_t)st.st_size, (UA_Byte*)data};
+    UA_StatusCode res = UA_Nodestore_Image(ns, &image, customTypes);
+    if(res != UA_STATUSCODE_GOOD) {
+        munmap(data, (size_t)st.st_size);
+        return res;
+    }
+    ((UA_NodestoreImage*)ns->context)->mapped = true;
+    return UA_STATUSCODE_GOOD;
+}
+#endif
@@ -23,9 +23,11 @@ struct NodeEntry {
     UA_UInt32 nodeIdHash;
     UA_UInt16 refCount; /* How many consumers have a reference to the node? */
     UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
+    UA_UInt32 directRefs; /* Reference targets that point directly to the entry */
     NodeEntry *orig;    /* If a copy is made to replace a node, track that we
                          * replace only the node from which the copy was made.
-                         * Important for concurrent operations. */
+                         * Important for concurrent operations. In the
+                         * graveyard: the next entry. */
     UA_NodeId nodeId; /* This is actually a UA_Node that also starts with a NodeId */
 };
 
@@ -45,12 +47,20 @@ cmpNodeId(const void *a, const void *b) {
     return (enum ZIP_CMP)UA_NodeId_order(&aa->nodeId, &bb->nodeId);
 }
 
+#define GRAVEYARD_MINSWEEP 64
+
 ZIP_HEAD(NodeTree, NodeEntry);
 typedef struct NodeTree NodeTree;
 
 typedef struct {
     NodeTree root;
 
+    /* Removed entries that reference targets can still point to. See
+     * UA_Nodestore_HashMap_resolveReferences for the scheme. */
+    NodeEntry *graveyard;
+    size_t graveyardSize;
+    size_t graveyardSweep; /* Sweep when the graveyard has this size */
+
     /* Maps ReferenceTypeIndex to the NodeId of the ReferenceType */
     UA_NodeId referenceTypeIds[UA_REFERENCETYPESET_MAX];
     UA_Byte referenceTypeCounter;
@@ -103,12 +113,72 @@ deleteEntry(NodeEntry *entry) {
     UA_free(entry);
 }
 
+static NodeEntry *
+getDirectEntry(UA_NodePointer ptr) {
+    const UA_NodeHead *head = UA_NodePointer_getNode(ptr);
+    if(!head)
+        return NULL;
+    return container_of(&head->nodeId, NodeEntry, nodeId);
+}
+
+static void *
+dropDirectTarget(void *context, UA_ReferenceTarget *t) {
+    NodeEntry *target = getDirectEntry(t->targetId);
+    if(target) {
+        UA_assert(target->directRefs > 0);
+        --target->directRefs;
+    }
+    return NULL;
+}
+
+/* Free the graves without direct pointers to them */
+static void
+sweepGraveyard(ZipContext *ns) {
+    NodeEntry **next = &ns->graveyard;
+    while(*next) {
+        NodeEntry *entry = *next;
+        if(entry->directRefs > 0) {
+            next = &entry->orig;
+            continue;
+        }
+        *next = entry->orig;
+        deleteEntry(entry);
+        --ns->graveyardSize;
+    }
+    ns->graveyardSweep = ns->graveyardSize * 2;
+    if(ns->graveyardSweep < GRAVEYARD_MINSWEEP)
+        ns->graveyardSweep = GRAVEYARD_MINSWEEP;
+}
+
+/* Keep only the NodeId. Direct pointers to the entry remain valid. */
 static void
-cleanupEntry(NodeEntry *entry) {
+buryEntry(ZipContext *ns, NodeEntry *entry) {
+    UA_NodeId id = entry->nodeId;
+    UA_NodeId_init(&entry->nodeId);
+    UA_Node_clear((UA_Node*)&entry->nodeId);
+    entry->nodeId = id;
+    entry->orig = ns->graveyard;
+    ns->graveyard = entry;
+    ++ns->graveyardSize;
+    if(ns->graveyardSize >= ns->graveyardSweep)
+        sweepGraveyard(ns);
+}
+
+static void
+cleanupEntry(ZipContext *ns, NodeEntry *entry) {
     if(entry->refCount > 0)
         return;
     if(entry->deleted) {
-        deleteEntry(entry);
+        /* Drop the direct pointers from the references of the entry. Then
+         * graves can become unreferenced. */
+        UA_NodeHead *head = (UA_NodeHead*)&entry->nodeId;
+        for(size_t i = 0; i < head->referencesSize; i++)
+            UA_NodeReferenceKind_iterate(&head->references[i],
+                                         dropDirectTarget, NULL);
+        if(entry->directRefs > 0)
+            buryEntry(ns, entry);
+        else
+            deleteEntry(entry);
         return;
     }
     UA_NodeHead *head = (UA_NodeHead*)&entry->nodeId;
@@ -159,6 +229,17 @@ zipNsGetNodeFromPtr(void *nsCtx, UA_NodePointer ptr,
                     UA_UInt32 attributeMask,
                     UA_ReferenceTypeSet references,
                     UA_BrowseDirection referenceDirections) {
+    /* Direct pointer to a node that was not replaced or removed. Otherwise the
+     * pointer can be into the graveyard. Then look up the NodeId. */
+    const UA_NodeHead *head = UA_NodePointer_getNode(ptr);
+    if(head) {
+        NodeEntry *entry = container_of(&head->nodeId, NodeEntry, nodeId);
+        if(!entry->deleted) {
+            ++entry->refCount;
+            return (const UA_Node*)&entry->nodeId;
+        }
+    }
+
     if(!UA_NodePointer_isLocal(ptr))
         return NULL;
     UA_NodeId id = UA_NodePointer_toNodeId(ptr);
@@ -173,7 +254,7 @@ zipNsReleaseNode(void *nsCtx, const UA_Node *node) {
     NodeEntry *entry = container_of(node, NodeEntry, nodeId);
     UA_assert(entry->refCount > 0);
     --entry->refCount;
-    cleanupEntry(entry);
+    cleanupEntry((ZipContext*)nsCtx, entry);
 }
 
 static UA_StatusCode
@@ -320,7 +401,7 @@ zipNsRemoveNode(void *nsCtx, const UA_NodeId *nodeId) {
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
     ZIP_REMOVE(NodeTree, &ns->root, entry);
     entry->deleted = true;
-    cleanupEntry(entry);
+    cleanupEntry(ns, entry);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -371,6 +452,13 @@ zipNsClear(void *nsCtx) {
     ZipContext *ns = (ZipContext*)nsCtx;
     ZIP_ITER(NodeTree, &ns->root, deleteNodeVisitor, NULL);
 
+    /* Free the graveyard */
+    while(ns->graveyard) {
+        NodeEntry *entry = ns->graveyard;
+        ns->graveyard = entry->orig;
+        deleteEntry(entry);
+    }
+
     /* Clean up the ReferenceTypes index array */
     for(size_t i = 0; i < ns->referenceTypeCounter; i++)
         UA_NodeId_clear(&ns->referenceTypeIds[i]);
@@ -378,6 +466,68 @@ zipNsClear(void *nsCtx) {
     UA_free(ns);
 }
 
+/* Point the target to the current entry with the NodeId. Or to the NodeId if
+ * there is no such entry. */
+static void *
+resolveReferenceTarget(void *context, UA_ReferenceTarget *t) {
+    ZipContext *ns = (ZipContext*)context;
+    if(!UA_NodePointer_isLocal(t->targetId))
+        return NULL;
+    NodeEntry dummy;
+    dummy.nodeId = UA_NodePointer_toNodeId(t->targetId);
+    dummy.nodeIdHash = UA_NodeId_hash(&dummy.nodeId);
+    NodeEntry *entry = ZIP_FIND(NodeTree, &ns->root, &dummy);
+    NodeEntry *prev = getDirectEntry(t->targetId);
+    if(entry) {
+        if(entry == prev)
+            return NULL; /* Already resolved */
+        UA_NodePointer old = t->targetId;
+        entry->directRefs++;
+        t->targetId = UA_NodePointer_fromNode((UA_NodeHead*)&entry->nodeId);
+        UA_NodePointer_clear(&old);
+    } else {
+        /* Not found. Pointers into the graveyard become NodeIds again. */
+        if(!prev)
+            return NULL;
+        UA_NodePointer np;
+        UA_StatusCode res = UA_NodePointer_copy(t->targetId, &np);
+        if(res != UA_STATUSCODE_GOOD)
+            return (void*)0x01;
+        t->targetId = np;
+    }
+    if(prev)
+        prev->directRefs--;
+    return NULL;
+}
+
+static void *
+resolveNodeVisitor(void *data, NodeEntry *entry) {
+    UA_NodeHead *head = (UA_NodeHead*)&entry->nodeId;
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        void *res = UA_NodeReferenceKind_iterate(&head->references[i],
+                                                 resolveReferenceTarget, data);
+        if(res)
+            return res;
+    }
+    return NULL;
+}
+
+UA_StatusCode
+UA_Nodestore_ZipTree_resolveReferences(UA_Nodestore *ns) {
+    if(ns->getNode != zipNsGetNode)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    ZipContext *ctx = (ZipContext*)ns->context;
+
+    /* Resolve the targets of all nodes in the tree */
+    if(ZIP_ITER(NodeTree, &ctx->root, resolveNodeVisitor, ctx))
+        return UA_STATUSCODE_BADOUTOFMEMORY; /* Keep the graveyard */
+
+    /* No more pointers into the graveyard. Except from removed nodes that
+     * are still retrieved. */
+    sweepGraveyard(ctx);
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_Nodestore_ZipTree(UA_Nodestore *ns) {
     /* Allocate and initialize the context */
@@ -386,6 +536,9 @@ UA_Nodestore_ZipTree(UA_Nodestore *ns) {
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     ZIP_INIT(&ctx->root);
+    ctx->graveyard = NULL;
+    ctx->graveyardSize = 0;
+    ctx->graveyardSweep = GRAVEYARD_MINSWEEP;
     ctx->referenceTypeCounter = 0;
 
     /* Populate the nodestore */
@@ -402,6 +555,7 @@ UA_Nodestore_ZipTree(UA_Nodestore *ns) {
     ns->removeNode = zipNsRemoveNode;
     ns->getReferenceTypeId = zipNsGetReferenceTypeId;
     ns->iterate = zipNsIterate;
+    ns->concurrentReads = false;
 
     /* All nodes are stored in RAM. Changes are made in-situ. GetEditNode is
      * identical to GetNode -- but the Node pointer is non-const. */
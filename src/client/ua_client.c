@@ -255,6 +255,11 @@ UA_Client_clear(UA_Client *client) {
     client->namespaces = NULL;
     client->namespacesSize = 0;
 
+    /* Free the requestId index of the async service calls */
+    UA_free(client->asyncServiceCallsById);
+    client->asyncServiceCallsById = NULL;
+    client->asyncServiceBuckets = 0;
+
 #if UA_MULTITHREADING >= 100
     UA_LOCK_DESTROY(&client->clientMutex);
 #endif
@@ -339,6 +344,93 @@ notifyClientState(UA_Client *client) {
                                      client->sessionState, client->connectStatus);
 }
 
+/***********************/
+/* Async Service Index */
+/***********************/
+
+#define UA_ASYNCSERVICEINDEX_MINSIZE 16
+
+static enum ZIP_CMP
+cmpDeadline(const UA_DateTime *a, const UA_DateTime *b) {
+    if(*a == *b)
+        return ZIP_CMP_EQ;
+    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+ZIP_FUNCTIONS(UA_AsyncServiceDeadlineTree, AsyncServiceCall, deadlineEntry,
+              UA_DateTime, deadline, cmpDeadline)
+
+static void
+asyncServiceIndexInsert(UA_Client *client, AsyncServiceCall *ac) {
+    AsyncServiceCall **b = &client->asyncServiceCallsById
+        [ac->requestId & (client->asyncServiceBuckets - 1)];
+    ac->idNext = *b;
+    *b = ac;
+}
+
+/* Ensure there is at least one bucket per call after adding one more. Called
+ * before the request is sent, so that attaching the call cannot fail. */
+static UA_StatusCode
+asyncServiceReserve(UA_Client *client) {
+    if(client->asyncServiceCallsSize < client->asyncServiceBuckets)
+        return UA_STATUSCODE_GOOD;
+
+    UA_UInt32 size = (client->asyncServiceBuckets == 0) ?
+        UA_ASYNCSERVICEINDEX_MINSIZE : client->asyncServiceBuckets * 2;
+    AsyncServiceCall **byId = (AsyncServiceCall**)
+        UA_calloc(size, sizeof(AsyncServiceCall*));
+    if(!byId)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    UA_free(client->asyncServiceCallsById);
+    client->asyncServiceCallsById = byId;
+    client->asyncServiceBuckets = size;
+
+    /* Rehash from the list of calls */
+    AsyncServiceCall *ac;
+    LIST_FOREACH(ac, &client->asyncServiceCalls, pointers) {
+        asyncServiceIndexInsert(client, ac);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Synchronous calls are not added to the deadline tree. They run the EventLoop
+ * until their own timeout is reached. */
+static void
+asyncServiceAttach(UA_Client *client, AsyncServiceCall *ac) {
+    UA_assert(client->asyncServiceCallsSize < client->asyncServiceBuckets);
+    LIST_INSERT_HEAD(&client->asyncServiceCalls, ac, pointers);
+    asyncServiceIndexInsert(client, ac);
+    client->asyncServiceCallsSize++;
+    ac->deadline = ac->start + ((UA_DateTime)ac->timeout * UA_DATETIME_MSEC);
+    if(!ac->syncResponse)
+        ZIP_INSERT(UA_AsyncServiceDeadlineTree, &client->asyncServiceDeadlines, ac);
+}
+
+static void
+asyncServiceDetach(UA_Client *client, AsyncServiceCall *ac) {
+    LIST_REMOVE(ac, pointers);
+    AsyncServiceCall **e = &client->asyncServiceCallsById
+        [ac->requestId & (client->asyncServiceBuckets - 1)];
+    while(*e != ac)
+        e = &(*e)->idNext;
+    *e = ac->idNext;
+    client->asyncServiceCallsSize--;
+    if(!ac->syncResponse)
+        ZIP_REMOVE(UA_AsyncServiceDeadlineTree, &client->asyncServiceDeadlines, ac);
+}
+
+static AsyncServiceCall *
+asyncServiceLookup(UA_Client *client, UA_UInt32 requestId) {
+    if(client->asyncServiceBuckets == 0)
+        return NULL;
+    AsyncServiceCall *ac = client->asyncServiceCallsById
+        [requestId & (client->asyncServiceBuckets - 1)];
+    while(ac && ac->requestId != requestId)
+        ac = ac->idNext;
+    return ac;
+}
+
 /****************/
 /* Raw Services */
 /****************/
@@ -415,16 +507,12 @@ sendRequest(UA_Client *client, const void *request,
 static const UA_NodeId
 serviceFaultId = {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_SERVICEFAULT_ENCODING_DEFAULTBINARY}};
 
-/* Look for the async callback in the linked list, execute and delete it */
+/* Look for the async callback in the requestId index, execute and delete it */
 static UA_StatusCode
 processMSGResponse(UA_Client *client, UA_UInt32 requestId,
                    const UA_ByteString *msg) {
     /* Find the callback */
-    AsyncServiceCall *ac;
-    LIST_FOREACH(ac, &client->asyncServiceCalls, pointers) {
-        if(ac->requestId == requestId)
-            break;
-    }
+    AsyncServiceCall *ac = asyncServiceLookup(client, requestId);
 
     /* Part 6, 6.7.6: After the security validation is complete the receiver
      * shall verify the RequestId and the SequenceNumber. If these checks fail a
@@ -442,7 +530,7 @@ processMSGResponse(UA_Client *client, UA_UInt32 requestId,
     const UA_DataType *responseType = ac->responseType;
 
     /* Dequeue ac. We might disconnect the client (remove all ac) in the callback. */
-    LIST_REMOVE(ac, pointers);
+    asyncServiceDetach(client, ac);
 
     /* Decode the response type */
     size_t offset = 0;
@@ -615,9 +703,16 @@ __Client_Service(UA_Client *client, const void *request,
      * reconnection within the EventLoop run method. */
     UA_UInt32 channelId = client->channel.securityToken.channelId;
 
+    /* Make room in the requestId index */
+    UA_StatusCode retval = asyncServiceReserve(client);
+    if(retval != UA_STATUSCODE_GOOD) {
+        respHeader->serviceResult = retval;
+        return;
+    }
+
     /* Send the request */
     UA_UInt32 requestId = 0;
-    UA_StatusCode retval = sendRequest(client, request, requestType, &requestId);
+    retval = sendRequest(client, request, requestType, &requestId);
     if(retval != UA_STATUSCODE_GOOD) {
         /* If sending failed, the status is set to closing. The SecureChannel is
          * the actually closed in the next iteration of the EventLoop. */
@@ -645,10 +740,10 @@ __Client_Service(UA_Client *client, const void *request,
     if(ac.timeout == 0)
         ac.timeout = UA_UINT32_MAX; /* 0 -> unlimited */
 
-    LIST_INSERT_HEAD(&client->asyncServiceCalls, &ac, pointers);
+    asyncServiceAttach(client, &ac);
 
     /* Time until which the request has to be answered */
-    UA_DateTime maxDate = ac.start + ((UA_DateTime)ac.timeout * UA_DATETIME_MSEC);
+    UA_DateTime maxDate = ac.deadline;
 
     /* Run the EventLoop until the request was processed, the request has timed
      * out or the client connection fails */
@@ -691,7 +786,7 @@ __Client_Service(UA_Client *client, const void *request,
     }
 
     /* Detach from the internal async service list */
-    LIST_REMOVE(&ac, pointers);
+    asyncServiceDetach(client, &ac);
 
     /* Return the status code */
     respHeader->serviceResult = retval;
@@ -736,6 +831,13 @@ __Client_AsyncService_removeAll(UA_Client *client, UA_StatusCode statusCode) {
     if(asyncServiceCalls.lh_first)
         asyncServiceCalls.lh_first->pointers.le_prev = &asyncServiceCalls.lh_first;
 
+    /* Reset the index. The calls in the local list are no longer attached. */
+    if(client->asyncServiceBuckets > 0)
+        memset(client->asyncServiceCallsById, 0,
+               client->asyncServiceBuckets * sizeof(AsyncServiceCall*));
+    client->asyncServiceCallsSize = 0;
+    ZIP_INIT(&client->asyncServiceDeadlines);
+
     /* Cancel and remove the elements from the local list */
     AsyncServiceCall *ac, *ac_tmp;
     LIST_FOREACH_SAFE(ac, &asyncServiceCalls, pointers, ac_tmp) {
@@ -759,13 +861,18 @@ __Client_AsyncService(UA_Client *client, const void *request,
         return UA_STATUSCODE_BADSERVERNOTCONNECTED;
     }
 
+    /* Make room in the requestId index */
+    UA_StatusCode retval = asyncServiceReserve(client);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
     /* Prepare the entry for the linked list */
     AsyncServiceCall *ac = (AsyncServiceCall*)UA_malloc(sizeof(AsyncServiceCall));
     if(!ac)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     /* Call the service and set the requestId */
-    UA_StatusCode retval = sendRequest(client, request, requestType, &ac->requestId);
+    retval = sendRequest(client, request, requestType, &ac->requestId);
     if(retval != UA_STATUSCODE_GOOD) {
         /* If sending failed, the status is set to closing. The SecureChannel is
          * the actually closed in the next iteration of the EventLoop. */
@@ -789,7 +896,7 @@ __Client_AsyncService(UA_Client *client, const void *request,
     if(ac->timeout == 0)
         ac->timeout = UA_UINT32_MAX; /* 0 -> unlimited */
 
-    LIST_INSERT_HEAD(&client->asyncServiceCalls, ac, pointers);
+    asyncServiceAttach(client, ac);
 
     /* Return the generated request id */
     if(requestId)
@@ -831,13 +938,9 @@ UA_Client_cancelByRequestId(UA_Client *client, UA_UInt32 requestId,
                             UA_UInt32 *cancelCount) {
     lockClient(client);
     UA_StatusCode res = UA_STATUSCODE_BADNOTFOUND;
-    AsyncServiceCall *ac;
-    LIST_FOREACH(ac, &client->asyncServiceCalls, pointers) {
-        if(ac->requestId != requestId)
-            continue;
+    AsyncServiceCall *ac = asyncServiceLookup(client, requestId);
+    if(ac)
         res = cancelByRequestHandle(client, ac->requestHandle, cancelCount);
-        break;
-    }
     unlockClient(client);
     return res;
 }
@@ -900,26 +1003,18 @@ UA_Client_removeCallback(UA_Client *client, UA_UInt64 callbackId) {
 
 static void
 asyncServiceTimeoutCheck(UA_Client *client) {
-    /* Make this function reentrant. One of the async callbacks could indirectly
-     * operate on the list. Moving all elements to a local list before iterating
-     * that. */
+    /* Pop the expired calls from the deadline tree in order. The tree is
+     * consulted anew after each callback. One of the async callbacks could
+     * indirectly operate on the pending calls. New calls get a deadline after
+     * the current time and are not cancelled here. */
     UA_EventLoop *el = client->config.eventLoop;
     UA_DateTime now = el->dateTime_nowMonotonic(el);
-    UA_AsyncServiceList asyncServiceCalls;
-    AsyncServiceCall *ac, *ac_tmp;
-    LIST_INIT(&asyncServiceCalls);
-    LIST_FOREACH_SAFE(ac, &client->asyncServiceCalls, pointers, ac_tmp) {
-        if(!ac->timeout)
-           continue;
-        if(ac->start + (UA_DateTime)(ac->timeout * UA_DATETIME_MSEC) <= now) {
-            LIST_REMOVE(ac, pointers);
-            LIST_INSERT_HEAD(&asyncServiceCalls, ac, pointers);
-        }
-    }
-
-    /* Cancel and remove the elements from the local list */
-    LIST_FOREACH_SAFE(ac, &asyncServiceCalls, pointers, ac_tmp) {
-        LIST_REMOVE(ac, pointers);
+    AsyncServiceCall *ac;
+    while((ac = ZIP_MIN(UA_AsyncServiceDeadlineTree,
+                        &client->asyncServiceDeadlines))) {
+        if(ac->deadline > now)
+            break;
+        asyncServiceDetach(client, ac);
         __Client_AsyncService_cancel(client, ac, UA_STATUSCODE_BADTIMEOUT);
     }
 }
@@ -82,6 +82,8 @@ __Client_Subscriptions_backgroundPublishInactivityCheck(UA_Client *client);
 
 typedef struct AsyncServiceCall {
     LIST_ENTRY(AsyncServiceCall) pointers;
+    struct AsyncServiceCall *idNext;           /* Chain in the requestId index */
+    ZIP_ENTRY(AsyncServiceCall) deadlineEntry; /* Only for async calls */
     UA_UInt32 requestId;     /* Unique id */
     UA_UInt32 requestHandle; /* Potentially non-unique if manually defined in
                               * the request header*/
@@ -90,6 +92,7 @@ typedef struct AsyncServiceCall {
     void *userdata;
     UA_DateTime start;
     UA_UInt32 timeout;
+    UA_DateTime deadline; /* start + timeout. Key in the deadline tree. */
     UA_Response *syncResponse; /* If non-null, then this is the synchronous
                                 * response to be filled. Set back to null to
                                 * indicate that the response was filled. */
@@ -97,6 +100,9 @@ typedef struct AsyncServiceCall {
 
 typedef LIST_HEAD(UA_AsyncServiceList, AsyncServiceCall) UA_AsyncServiceList;
 
+ZIP_HEAD(UA_AsyncServiceDeadlineTree, AsyncServiceCall);
+typedef struct UA_AsyncServiceDeadlineTree UA_AsyncServiceDeadlineTree;
+
 void
 __Client_AsyncService_removeAll(UA_Client *client, UA_StatusCode statusCode);
 
@@ -160,8 +166,15 @@ struct UA_Client {
     UA_DateTime lastConnectivityCheck;
     UA_Boolean pendingConnectivityCheck;
 
-    /* Async Service */
+    /* Async Service. The pending calls are indexed by their requestId in a
+     * hash table (one bucket per call, power of two). The async calls (not the
+     * synchronous ones that handle their timeout in the loop) are also ordered
+     * by their deadline. */
     UA_AsyncServiceList asyncServiceCalls;
+    AsyncServiceCall **asyncServiceCallsById;
+    UA_UInt32 asyncServiceBuckets;
+    size_t asyncServiceCallsSize;
+    UA_AsyncServiceDeadlineTree asyncServiceDeadlines;
 
     /* Subscriptions */
     LIST_HEAD(, UA_Client_NotificationsAckNumber) pendingNotificationsAcks;
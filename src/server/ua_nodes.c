@@ -79,10 +79,10 @@ UA_NodePointer_copy(UA_NodePointer in, UA_NodePointer *out) {
     in.immediate &= ~(uintptr_t)UA_NODEPOINTER_MASK;
     switch(tag) {
     case UA_NODEPOINTER_TAG_NODE:
-        in.id = &in.node->nodeId;
-        goto nodeid; /* fallthrough */
+        /* Copy in the same representation that the NodeId would have. Then
+         * the copy is ordered like the original. */
+        return UA_NodePointer_copy(UA_NodePointer_fromNodeId(&in.node->nodeId), out);
     case UA_NODEPOINTER_TAG_NODEID:
-    nodeid:
         out->id = UA_NodeId_new();
         if(!out->id)
             return UA_STATUSCODE_BADOUTOFMEMORY;
@@ -130,12 +130,12 @@ UA_NodePointer_order(UA_NodePointer p1, UA_NodePointer p2) {
     /* Extract the tag and resolve pointers to nodes */
     UA_Byte tag1 = p1.immediate & UA_NODEPOINTER_MASK;
     if(tag1 == UA_NODEPOINTER_TAG_NODE) {
-        p1 = UA_NodePointer_fromNodeId(&p1.node->nodeId);
+        p1 = UA_NodePointer_fromNodeId(&UA_NodePointer_getNode(p1)->nodeId);
         tag1 = p1.immediate & UA_NODEPOINTER_MASK;
     }
     UA_Byte tag2 = p2.immediate & UA_NODEPOINTER_MASK;
     if(tag2 == UA_NODEPOINTER_TAG_NODE) {
-        p2 = UA_NodePointer_fromNodeId(&p2.node->nodeId);
+        p2 = UA_NodePointer_fromNodeId(&UA_NodePointer_getNode(p2)->nodeId);
         tag2 = p2.immediate & UA_NODEPOINTER_MASK;
     }
 
@@ -143,10 +143,13 @@ UA_NodePointer_order(UA_NodePointer p1, UA_NodePointer p2) {
     if(tag1 != tag2)
         return (tag1 > tag2) ? UA_ORDER_MORE : UA_ORDER_LESS;
 
-    /* Immediate */
-    if(UA_LIKELY(tag1 == UA_NODEPOINTER_TAG_IMMEDIATE))
+    /* Immediate. Can be equal after resolving node pointers. */
+    if(UA_LIKELY(tag1 == UA_NODEPOINTER_TAG_IMMEDIATE)) {
+        if(p1.immediate == p2.immediate)
+            return UA_ORDER_EQ;
         return (p1.immediate > p2.immediate) ?
             UA_ORDER_MORE : UA_ORDER_LESS;
+    }
 
     /* Compare from pointers */
     p1.immediate &= ~(uintptr_t)UA_NODEPOINTER_MASK;
@@ -224,12 +227,28 @@ UA_NodePointer_fromExpandedNodeId(const UA_ExpandedNodeId *id) {
     return UA_NodePointer_fromNodeId(&id->nodeId);
 }
 
+UA_NodePointer
+UA_NodePointer_fromNode(const UA_NodeHead *node) {
+    UA_NodePointer np;
+    np.node = node;
+    np.immediate |= UA_NODEPOINTER_TAG_NODE;
+    return np;
+}
+
+const UA_NodeHead *
+UA_NodePointer_getNode(UA_NodePointer np) {
+    if((np.immediate & UA_NODEPOINTER_MASK) != UA_NODEPOINTER_TAG_NODE)
+        return NULL;
+    np.immediate &= ~(uintptr_t)UA_NODEPOINTER_MASK;
+    return np.node;
+}
+
 UA_ExpandedNodeId
 UA_NodePointer_toExpandedNodeId(UA_NodePointer np) {
     /* Resolve node pointer to get the NodeId */
     UA_Byte tag = np.immediate & UA_NODEPOINTER_MASK;
     if(tag == UA_NODEPOINTER_TAG_NODE) {
-        np = UA_NodePointer_fromNodeId(&np.node->nodeId);
+        np = UA_NodePointer_fromNodeId(&UA_NodePointer_getNode(np)->nodeId);
         tag = np.immediate & UA_NODEPOINTER_MASK;
     }
 
@@ -546,7 +565,9 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
     UA_StatusCode retval = UA_NodeId_copy(&srchead->nodeId, &dsthead->nodeId);
     retval |= UA_QualifiedName_copy(&srchead->browseName, &dsthead->browseName);
 
-    /* Copy the display name in several languages */
+    /* Copy the display name in several languages. Keep the order, the first
+     * entry is the default locale. */
+    UA_LocalizedTextListEntry **displayNameTail = &dsthead->displayName;
     for(UA_LocalizedTextListEntry *lt = srchead->displayName; lt != NULL; lt = lt->next) {
         UA_LocalizedTextListEntry *newEntry = (UA_LocalizedTextListEntry *)
             UA_calloc(1, sizeof(UA_LocalizedTextListEntry));
@@ -556,12 +577,13 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
         }
         retval |= UA_LocalizedText_copy(&lt->localizedText, &newEntry->localizedText);
 
-        /* Add to the linked list possibly in reverse order */
-        newEntry->next = dsthead->displayName;
-        dsthead->displayName = newEntry;
+        *displayNameTail = newEntry;
+        displayNameTail = &newEntry->next;
     }
 
-    /* Copy the description in several languages */
+    /* Copy the description in several languages. Keep the order, the first
+     * entry is the default locale. */
+    UA_LocalizedTextListEntry **descriptionTail = &dsthead->description;
     for(UA_LocalizedTextListEntry *lt = srchead->description; lt != NULL; lt = lt->next) {
         UA_LocalizedTextListEntry *newEntry = (UA_LocalizedTextListEntry *)
             UA_calloc(1, sizeof(UA_LocalizedTextListEntry));
@@ -571,9 +593,8 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
         }
         retval |= UA_LocalizedText_copy(&lt->localizedText, &newEntry->localizedText);
 
-        /* Add to the linked list possibly in reverse order */
-        newEntry->next = dsthead->description;
-        dsthead->description= newEntry;
+        *descriptionTail = newEntry;
+        descriptionTail = &newEntry->next;
     }
 
     dsthead->writeMask = srchead->writeMask;
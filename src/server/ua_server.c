@@ -439,6 +439,8 @@ UA_Server_delete(UA_Server *server) {
     LIST_FOREACH_SAFE(current, &server->sessions, pointers, temp) {
         UA_Server_removeSession(server, current, UA_SHUTDOWNREASON_CLOSE);
     }
+    UA_free(server->sessionsByToken);
+    UA_free(server->sessionsById);
     UA_Array_delete(server->namespaces, server->namespacesSize, &UA_TYPES[UA_TYPES_STRING]);
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS
@@ -458,12 +460,20 @@ UA_Server_delete(UA_Server *server) {
     UA_AsyncManager_clear(&server->asyncManager, server);
 #endif
 
+#ifdef UA_HAVE_SERVER_WORKERS
+    UA_ServerWorkers_clear(&server->workers);
+#endif
+
     /* Clean up the Admin Session */
     UA_Session_clear(&server->adminSession, server);
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     server->adminSubscription = NULL;
     UA_assert(server->monitoredItemsSize == 0);
     UA_assert(server->subscriptionsSize == 0);
+    UA_assert(LIST_EMPTY(&server->samplingGroups));
+#endif
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    UA_EventIndex_delete(server);
 #endif
 
     /* Remove all server components (all stopped by now) */
@@ -483,6 +493,9 @@ UA_Server_delete(UA_Server *server) {
 #if UA_MULTITHREADING >= 100
     UA_LOCK_DESTROY(&server->serviceMutex);
 #endif
+#ifdef UA_HAVE_SERVER_WORKERS
+    pthread_rwlock_destroy(&server->sharedLock);
+#endif
 
     UA_GDSManager_clear(&server->gdsManager);
 
@@ -528,6 +541,16 @@ UA_Server_init(UA_Server *server) {
 #endif
 
     UA_LOCK_INIT(&server->serviceMutex);
+#ifdef UA_HAVE_SERVER_WORKERS
+    pthread_rwlockattr_t rwattr;
+    pthread_rwlockattr_init(&rwattr);
+#ifdef __GLIBC__
+    /* Don't starve lockServer with a constant stream of shared holders */
+    pthread_rwlockattr_setkind_np(&rwattr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    pthread_rwlock_init(&server->sharedLock, &rwattr);
+    pthread_rwlockattr_destroy(&rwattr);
+#endif
     lockServer(server);
 
     /* Initialize the adminSession */
@@ -567,6 +590,10 @@ UA_Server_init(UA_Server *server) {
     UA_AsyncManager_init(&server->asyncManager, server);
 #endif
 
+#ifdef UA_HAVE_SERVER_WORKERS
+    UA_ServerWorkers_init(&server->workers);
+#endif
+
     /* Initialize namespace 0*/
     res = initNS0(server);
     UA_CHECK_STATUS(res, goto cleanup);
@@ -1242,6 +1269,21 @@ UA_Server_run_startup(UA_Server *server) {
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+    /* Start the worker threads for request processing */
+#ifdef UA_HAVE_SERVER_WORKERS
+    retVal = UA_ServerWorkers_start(&server->workers, server);
+    if(retVal != UA_STATUSCODE_GOOD) {
+        ZIP_ITER(UA_ServerComponentTree, &server->serverComponents,
+                 stopServerComponent, NULL);
+        unlockServer(server);
+        return retVal;
+    }
+#elif UA_MULTITHREADING >= 100
+    if(config->serviceWorkers > 0)
+        UA_LOG_WARNING(config->logging, UA_LOGCATEGORY_SERVER,
+                       "Service worker threads are not supported on this platform");
+#endif
+
     /* Set the server to STARTED. From here on, only use
      * UA_Server_run_shutdown(server) to stop the server. */
     setServerLifecycleState(server, UA_LIFECYCLESTATE_STARTED);
@@ -1321,6 +1363,15 @@ UA_Server_run_shutdown(UA_Server *server) {
     ZIP_ITER(UA_ServerComponentTree, &server->serverComponents,
              stopServerComponent, NULL);
 
+#ifdef UA_HAVE_SERVER_WORKERS
+    /* Stop the worker threads. They process the remaining jobs and need the
+     * server lock for that. From now on all requests are processed in the
+     * EventLoop thread. */
+    unlockServer(server);
+    UA_ServerWorkers_stop(&server->workers);
+    lockServer(server);
+#endif
+
     /* Are we already stopped? */
     if(testStoppedCondition(server)) {
         setServerLifecycleState(server, UA_LIFECYCLESTATE_STOPPED);
@@ -1338,12 +1389,16 @@ UA_Server_run_shutdown(UA_Server *server) {
     UA_Server_run_iterate(server, true);
     lockServer(server);
 
-    /* Iterate the EventLoop until the server is stopped */
+    /* Iterate the EventLoop until the server is stopped. Iterate without the
+     * server lock. The reactor threads of the EventLoop call into the server
+     * (e.g. to close connections) and need to take it. */
     UA_StatusCode res = UA_STATUSCODE_GOOD;
     UA_EventLoop *el = server->config.eventLoop;
     while(!testStoppedCondition(server) &&
           res == UA_STATUSCODE_GOOD) {
+        unlockServer(server);
         res = el->run(el, 100);
+        lockServer(server);
     }
 
     /* Stop the EventLoop. Iterate until stopped. */
@@ -1351,7 +1406,9 @@ UA_Server_run_shutdown(UA_Server *server) {
     while(el->state != UA_EVENTLOOPSTATE_STOPPED &&
           el->state != UA_EVENTLOOPSTATE_FRESH &&
           res == UA_STATUSCODE_GOOD) {
+        unlockServer(server);
         res = el->run(el, 100);
+        lockServer(server);
     }
 
     /* Set server lifecycle state to stopped if not already the case */
@@ -1376,14 +1433,66 @@ UA_Server_run(UA_Server *server, const volatile UA_Boolean *running) {
     return UA_Server_run_shutdown(server);
 }
 
+#ifdef UA_HAVE_SERVER_WORKERS
+/* Nesting of lockServerShared and of lockServer while the shared lock is held
+ * (upgrade) in the current thread */
+static UA_THREAD_LOCAL size_t sharedLockDepth = 0;
+static UA_THREAD_LOCAL size_t upgradeDepth = 0;
+
+void lockServerShared(UA_Server *server) {
+    if(UA_ServerWorkers_sharedLock == server) {
+        sharedLockDepth++;
+        return;
+    }
+    UA_assert(!UA_ServerWorkers_sharedLock);
+    pthread_rwlock_rdlock(&server->sharedLock);
+    UA_ServerWorkers_sharedLock = server;
+    sharedLockDepth = 1;
+}
+
+UA_Boolean holdsServerLockSharedOnce(UA_Server *server) {
+    return (UA_ServerWorkers_sharedLock == server &&
+            sharedLockDepth == 1 && upgradeDepth == 0);
+}
+
+void unlockServerShared(UA_Server *server) {
+    UA_assert(UA_ServerWorkers_sharedLock == server);
+    UA_assert(upgradeDepth == 0);
+    if(--sharedLockDepth > 0)
+        return;
+    UA_ServerWorkers_sharedLock = NULL;
+    pthread_rwlock_unlock(&server->sharedLock);
+}
+#endif
+
 void lockServer(UA_Server *server) {
+#ifdef UA_HAVE_SERVER_WORKERS
+    /* Upgrade from the shared lock. Release it first. Otherwise two upgrading
+     * threads would wait for each other. */
+    if(UA_ServerWorkers_sharedLock == server && upgradeDepth++ == 0)
+        pthread_rwlock_unlock(&server->sharedLock);
+#endif
     if(UA_LIKELY(server->config.eventLoop && server->config.eventLoop->lock))
         server->config.eventLoop->lock(server->config.eventLoop);
     UA_LOCK(&server->serviceMutex);
+#ifdef UA_HAVE_SERVER_WORKERS
+    if(server->lockDepth++ == 0)
+        pthread_rwlock_wrlock(&server->sharedLock);
+#endif
 }
 
 void unlockServer(UA_Server *server) {
+#ifdef UA_HAVE_SERVER_WORKERS
+    UA_assert(server->lockDepth > 0);
+    if(--server->lockDepth == 0)
+        pthread_rwlock_unlock(&server->sharedLock);
+#endif
     if(UA_LIKELY(server->config.eventLoop && server->config.eventLoop->unlock))
         server->config.eventLoop->unlock(server->config.eventLoop);
     UA_UNLOCK(&server->serviceMutex);
+#ifdef UA_HAVE_SERVER_WORKERS
+    /* Downgrade to the shared lock */
+    if(UA_ServerWorkers_sharedLock == server && --upgradeDepth == 0)
+        pthread_rwlock_rdlock(&server->sharedLock);
+#endif
 }
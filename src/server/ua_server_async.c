@@ -97,6 +97,10 @@ processAsyncResults(UA_Server *server) {
     UA_AsyncManager *am = &server->asyncManager;
     UA_LOCK_ASSERT(&server->serviceMutex);
 
+    /* Integrate later, the next checkTimeouts runs after at most 1s */
+    if(am->parallelBatches > 0)
+        return 0;
+
     UA_UInt32 count = 0;
     UA_AsyncOperation *ao;
     UA_LOCK(&am->queueLock);
@@ -406,6 +410,30 @@ UA_Server_setMethodNodeAsync(UA_Server *server, const UA_NodeId id,
     return res;
 }
 
+#ifdef UA_HAVE_SERVER_WORKERS
+typedef struct {
+    UA_Session *session;
+    UA_UInt32 requestId;
+    UA_UInt32 requestHandle;
+    UA_AsyncServiceOperation operationCallback;
+    uintptr_t reqOp;
+    size_t reqOpSize;
+    uintptr_t respOp;
+    size_t respOpSize;
+    UA_AsyncResponse **ar;
+} UA_ParallelAsyncOperations;
+
+/* The AsyncResponse is created lazily by the first async operation. This is
+ * safe as every operation executes with the server lock taken. */
+static void
+processParallelAsyncOperation(UA_Server *server, void *context, size_t index) {
+    UA_ParallelAsyncOperations *p = (UA_ParallelAsyncOperations*)context;
+    p->operationCallback(server, p->session, p->requestId, p->requestHandle, index,
+                         (void*)(p->reqOp + (index * p->reqOpSize)),
+                         (void*)(p->respOp + (index * p->respOpSize)), p->ar);
+}
+#endif
+
 UA_StatusCode
 UA_Server_processServiceOperationsAsync(UA_Server *server, UA_Session *session,
                                         UA_UInt32 requestId, UA_UInt32 requestHandle,
@@ -429,6 +457,25 @@ UA_Server_processServiceOperationsAsync(UA_Server *server, UA_Session *session,
     /* Finish / dispatch the operations. This may allocate a new AsyncResponse internally */
     uintptr_t respOp = (uintptr_t)*respPos;
     uintptr_t reqOp = *(uintptr_t*)((uintptr_t)requestOperations + sizeof(size_t));
+
+#ifdef UA_HAVE_SERVER_WORKERS
+    /* Execute large requests in parallel */
+    size_t threshold = server->config.parallelOperationsThreshold;
+    if(threshold > 0 && ops >= threshold) {
+        UA_ParallelAsyncOperations p = {
+            session, requestId, requestHandle, operationCallback,
+            reqOp, requestOperationsType->memSize,
+            respOp, responseOperationsType->memSize, ar};
+        UA_AsyncManager *am = &server->asyncManager;
+        am->parallelBatches++;
+        UA_ServerWorkers_processOperations(server, session,
+                                           processParallelAsyncOperation,
+                                           &p, ops);
+        am->parallelBatches--;
+        return UA_STATUSCODE_GOOD;
+    }
+#endif
+
     for(size_t i = 0; i < ops; i++) {
         operationCallback(server, session, requestId, requestHandle,
                           i, (void*)reqOp, (void*)respOp, ar);
@@ -72,6 +72,10 @@ typedef struct {
                                              * is still "alive" (not timed out). */
     UA_AsyncOperationQueue resultQueue;     /* Results to be integrated */
     size_t opsCount; /* How many operations are transient (in one of the three queues)? */
+    size_t parallelBatches; /* Requests whose operations are executed in
+                             * parallel without the server lock. Their
+                             * AsyncResponse is still being assembled. So no
+                             * results are integrated meanwhile. */
 
     UA_UInt64 checkTimeoutCallbackId; /* Registered repeated callbacks */
 } UA_AsyncManager;
@@ -33,13 +33,18 @@ void UA_debug_dumpCompleteChunk(UA_Server *const server, UA_Connection *const co
 /* Binary Protocol Server Component */
 /************************************/
 
-/* Maximum numbers of sockets to listen on */
-#define UA_MAXSERVERCONNECTIONS 16
-
-typedef struct {
+/* Context of the server sockets and of the connections accepted on them */
+typedef struct UA_ServerConnection {
+    UA_Boolean serverSocket;
     UA_ConnectionState state;
     uintptr_t connectionId;
     UA_ConnectionManager *connectionManager;
+    LIST_ENTRY(UA_ServerConnection) next; /* Server sockets only */
+
+    /* Connections with a SecureChannel. The unlockedReceive flag is set under
+     * the server lock by the reactor thread of the connection. */
+    UA_SecureChannel *channel;
+    UA_Boolean unlockedReceive;
 } UA_ServerConnection;
 
 /* Reverse connect */
@@ -68,7 +73,9 @@ typedef struct {
     const UA_Logger *logging; /* shortcut */
     UA_UInt64 houseKeepingCallbackId;
 
-    UA_ServerConnection serverConnections[UA_MAXSERVERCONNECTIONS];
+    /* Sockets the server listens on. With reactor threads in the EventLoop,
+     * there is one listen socket per reactor and address. */
+    LIST_HEAD(, UA_ServerConnection) serverConnections;
     size_t serverConnectionsSize;
 
     UA_ConnectionConfig tcpConnectionConfig; /* Extracted from the server config
@@ -83,6 +90,34 @@ typedef struct {
     UA_UInt64 lastReverseConnectHandle;
 } UA_BinaryProtocolManager;
 
+#ifdef UA_HAVE_SERVER_WORKERS
+
+/* A MSG request that is decoded, processed and encoded in a worker thread. The
+ * encoded response is sent out from the EventLoop thread. The jobs of a
+ * SecureChannel are processed one after the other, so that the responses keep
+ * the order of the requests. */
+struct UA_ServiceJob {
+    UA_ServerWorkerJob workerJob;   /* Dispatch to the worker thread */
+    UA_DelayedCallback dc;          /* Return to the EventLoop thread */
+    SIMPLEQ_ENTRY(UA_ServiceJob) next;
+    UA_BinaryProtocolManager *bpm;
+    UA_SecureChannel *channel;
+    UA_UInt32 requestId;
+    UA_ByteString request;  /* Starts with the NodeId of the request type */
+    UA_ByteString response; /* Starts with the NodeId of the response type.
+                             * Empty for async responses. */
+    UA_StatusCode result;   /* A bad result closes the channel */
+};
+
+static void
+deleteServiceJob(UA_ServiceJob *job) {
+    UA_ByteString_clear(&job->request);
+    UA_ByteString_clear(&job->response);
+    UA_free(job);
+}
+
+#endif
+
 void setReverseConnectState(UA_Server *server, reverse_connect_context *context,
                             UA_SecureChannelState newState);
 UA_StatusCode attemptReverseConnect(UA_BinaryProtocolManager *bpm,
@@ -104,12 +139,40 @@ setBinaryProtocolManagerState(UA_BinaryProtocolManager *bpm,
         bpm->sc.notifyState(&bpm->sc, state);
 }
 
+/* Set BinaryProtocolManager to STOPPED if it is STOPPING and the last socket
+ * just closed */
+static void
+checkBinaryProtocolManagerStopped(UA_BinaryProtocolManager *bpm) {
+    if(bpm->sc.state == UA_LIFECYCLESTATE_STOPPING &&
+       bpm->serverConnectionsSize == 0 &&
+       LIST_EMPTY(&bpm->reverseConnects) &&
+       TAILQ_EMPTY(&bpm->channels)) {
+        setBinaryProtocolManagerState(bpm, UA_LIFECYCLESTATE_STOPPED);
+    }
+}
+
 static void
 deleteServerSecureChannel(UA_BinaryProtocolManager *bpm,
                           UA_SecureChannel *channel) {
     UA_Server *server = bpm->sc.server;
     UA_LOCK_ASSERT(&server->serviceMutex);
 
+#ifdef UA_HAVE_SERVER_WORKERS
+    /* A worker thread still processes a request of the channel. Drop the
+     * requests that have not been started. The channel is deleted when the
+     * worker returns (see serviceJobDone). */
+    UA_ServiceJob *active = SIMPLEQ_FIRST(&channel->serviceJobs);
+    if(active) {
+        UA_ServiceJob *job;
+        while((job = SIMPLEQ_NEXT(active, next))) {
+            SIMPLEQ_REMOVE_AFTER(&channel->serviceJobs, active, next);
+            deleteServiceJob(job);
+        }
+        channel->state = UA_SECURECHANNELSTATE_CLOSED;
+        return;
+    }
+#endif
+
     /* Clean up the SecureChannel. This is the only place where
      * UA_SecureChannel_clear must be called within the server code-base.
      *
@@ -387,6 +450,84 @@ sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
     return UA_MessageContext_finish(&mc);
 }
 
+/* Same as the array encoding in ua_types_encoding_binary.c */
+static UA_StatusCode
+encodeArrayMessageContext(UA_MessageContext *mc, const void *array, size_t size,
+                          const UA_DataType *type) {
+    UA_Int32 signedLength = -1;
+    if(size > UA_INT32_MAX)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    if(size > 0)
+        signedLength = (UA_Int32)size;
+    else if(array == UA_EMPTY_ARRAY_SENTINEL)
+        signedLength = 0;
+    UA_StatusCode retval =
+        UA_MessageContext_encode(mc, &signedLength, &UA_TYPES[UA_TYPES_INT32]);
+    uintptr_t ptr = (uintptr_t)array;
+    for(size_t i = 0; i < size && retval == UA_STATUSCODE_GOOD; i++) {
+        retval = UA_MessageContext_encode(mc, (const void*)ptr, type);
+        ptr += type->memSize;
+    }
+    return retval;
+}
+
+UA_StatusCode
+sendResponseWithNotificationMessage(UA_Server *server, UA_SecureChannel *channel,
+                                    UA_UInt32 requestId, UA_Response *response,
+                                    const UA_DataType *responseType,
+                                    const UA_ByteString *notificationMessage) {
+    if(!channel)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* If the overall service call failed, answer with a ServiceFault */
+    if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+        return sendServiceFault(server, channel, requestId,
+                                response->responseHeader.requestHandle,
+                                response->responseHeader.serviceResult);
+
+    /* Prepare the ResponseHeader */
+    UA_EventLoop *el = server->config.eventLoop;
+    response->responseHeader.timestamp = el->dateTime_now(el);
+
+    /* Start the message context */
+    UA_MessageContext mc;
+    UA_StatusCode retval = UA_MessageContext_begin(&mc, channel, requestId, UA_MESSAGETYPE_MSG);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Encode the response type */
+    retval = UA_MessageContext_encode(&mc, &responseType->binaryEncodingId,
+                                      &UA_TYPES[UA_TYPES_NODEID]);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Encode the response member by member. Use the encoded
+     * NotificationMessage in its place. */
+    uintptr_t ptr = (uintptr_t)response;
+    for(size_t i = 0; i < responseType->membersSize; i++) {
+        const UA_DataTypeMember *m = &responseType->members[i];
+        const UA_DataType *mt = m->memberType;
+        ptr += m->padding;
+        if(m->isArray) {
+            size_t size = *(const size_t*)ptr;
+            ptr += sizeof(size_t);
+            retval = encodeArrayMessageContext(&mc, *(void* const*)ptr, size, mt);
+            ptr += sizeof(void*);
+        } else {
+            if(mt == &UA_TYPES[UA_TYPES_NOTIFICATIONMESSAGE])
+                retval = UA_MessageContext_encodeBuffer(&mc, notificationMessage);
+            else
+                retval = UA_MessageContext_encode(&mc, (const void*)ptr, mt);
+            ptr += mt->memSize;
+        }
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval; /* The message context was aborted */
+    }
+
+    /* Finish / send out */
+    return UA_MessageContext_finish(&mc);
+}
+
 /* A Session is "bound" to a SecureChannel if it was created by the
  * SecureChannel or if it was activated on it. A Session can only be bound to
  * one SecureChannel. A Session can only be closed from the SecureChannel to
@@ -396,34 +537,40 @@ sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
 UA_StatusCode
 getBoundSession(UA_Server *server, const UA_SecureChannel *channel,
                 const UA_NodeId *token, UA_Session **session) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_READ(server);
     UA_EventLoop *el = server->config.eventLoop;
     UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
 
-    for(UA_Session *s = channel->sessions; s; s = s->next) {
-        if(!UA_NodeId_equal(token, &s->authenticationToken))
-            continue;
-
+    session_list_entry *entry = lookupSessionByToken(server, token);
+    if(entry && entry->session.channel == channel) {
         /* Has the session timed out? */
-        if(s->validTill < nowMonotonic) {
+        if(entry->session.validTill < nowMonotonic) {
+            lockConcurrentRead(server);
             server->serverDiagnosticsSummary.rejectedSessionCount++;
+            unlockConcurrentRead(server);
             return UA_STATUSCODE_BADSESSIONCLOSED;
         }
 
         /* Return the session */
-        *session = s;
+        *session = &entry->session;
         return UA_STATUSCODE_GOOD;
     }
 
+    /* The statistics are updated with the exclusive lock. If it was upgraded
+     * from the shared lock, the session entry has to be looked up again. */
+    lockConcurrentRead(server);
+
     /* Session exists on another SecureChannel */
 #ifdef UA_ENABLE_DIAGNOSTICS
-    UA_Session *tmpSession = getSessionByToken(server, token);
-    if(tmpSession)
-        tmpSession->diagnostics.unauthorizedRequestCount++;
+    entry = lookupSessionByToken(server, token);
+    if(entry && entry->session.channel != channel &&
+       entry->session.validTill >= nowMonotonic)
+        entry->session.diagnostics.unauthorizedRequestCount++;
 #endif
 
     /* Update the rejected statistics */
     server->serverDiagnosticsSummary.rejectedSessionCount++;
+    unlockConcurrentRead(server);
     return UA_STATUSCODE_BADSESSIONIDINVALID;
 }
 
@@ -462,14 +609,19 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
                                             requestId, UA_STATUSCODE_BADSERVICEUNSUPPORTED);
     }
 
-    /* Decode the request */
+    /* Decode the request into the arena of the channel. Strings point into
+     * the message buffer. */
     UA_Request request;
     size_t requestPos = offset; /* Store the offset (for sendServiceFault) */
     UA_DecodeBinaryOptions opt;
     memset(&opt, 0, sizeof(UA_DecodeBinaryOptions));
     opt.customTypes = server->config.customDataTypes;
+    opt.callocContext = &channel->requestArena;
+    opt.calloc = UA_Arena_calloc;
+    opt.borrowStrings = true;
     retval = UA_decodeBinaryInternal(msg, &offset, &request, sd->requestType, &opt);
     if(retval != UA_STATUSCODE_GOOD) {
+        UA_Arena_reset(&channel->requestArena);
         UA_LOG_DEBUG_CHANNEL(server->config.logging, channel,
                              "Could not decode the request with StatusCode %s",
                              UA_StatusCode_name(retval));
@@ -493,17 +645,303 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
         retval = sendResponse(server, channel, requestId, &response, sd->responseType);
     }
 
-    /* Clean up */
-    UA_clear(&request, sd->requestType);
+    /* Clean up. The request is released with the arena. */
     UA_clear(&response, sd->responseType);
+    UA_Arena_reset(&channel->requestArena);
     return retval;
 }
 
+/* Send an ERR message and close the channel */
+static void
+closeChannelAfterError(UA_Server *server, UA_SecureChannel *channel,
+                       UA_StatusCode retval) {
+    if(!UA_SecureChannel_isConnected(channel)) {
+        UA_LOG_INFO_CHANNEL(server->config.logging, channel,
+                            "Processing the message failed. Channel already closed "
+                            "with StatusCode %s. ", UA_StatusCode_name(retval));
+        return;
+    }
+
+    UA_LOG_INFO_CHANNEL(server->config.logging, channel,
+                        "Processing the message failed with StatusCode %s. "
+                        "Closing the channel.", UA_StatusCode_name(retval));
+    UA_TcpErrorMessage errMsg;
+    UA_TcpErrorMessage_init(&errMsg);
+    errMsg.error = retval;
+    UA_SecureChannel_sendError(channel, &errMsg);
+    UA_ShutdownReason reason;
+    switch(retval) {
+    case UA_STATUSCODE_BADSECURITYMODEREJECTED:
+    case UA_STATUSCODE_BADSECURITYCHECKSFAILED:
+    case UA_STATUSCODE_BADSECURECHANNELIDINVALID:
+    case UA_STATUSCODE_BADSECURECHANNELTOKENUNKNOWN:
+    case UA_STATUSCODE_BADSECURITYPOLICYREJECTED:
+    case UA_STATUSCODE_BADCERTIFICATEUSENOTALLOWED:
+        reason = UA_SHUTDOWNREASON_SECURITYREJECT;
+        break;
+    default:
+        reason = UA_SHUTDOWNREASON_CLOSE;
+        break;
+    }
+    UA_SecureChannel_shutdown(channel, reason);
+}
+
+#ifdef UA_HAVE_SERVER_WORKERS
+
+/* Encode the response into a buffer. The chunking and encryption happens later
+ * in the EventLoop thread. Bad responses are sent as a ServiceFault. */
+static UA_StatusCode
+encodeServiceResponse(UA_Server *server, UA_Response *response,
+                      const UA_DataType *responseType, UA_ByteString *out) {
+    UA_ServiceFault fault;
+    if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+        UA_ServiceFault_init(&fault);
+        fault.responseHeader.requestHandle = response->responseHeader.requestHandle;
+        fault.responseHeader.serviceResult = response->responseHeader.serviceResult;
+        response = (UA_Response*)&fault;
+        responseType = &UA_TYPES[UA_TYPES_SERVICEFAULT];
+    }
+
+    UA_EventLoop *el = server->config.eventLoop;
+    response->responseHeader.timestamp = el->dateTime_now(el);
+
+    const UA_NodeId *typeId = &responseType->binaryEncodingId;
+    size_t typeIdSize = UA_calcSizeBinary(typeId, &UA_TYPES[UA_TYPES_NODEID], NULL);
+    size_t responseSize = UA_calcSizeBinary(response, responseType, NULL);
+    if(typeIdSize == 0 || responseSize == 0)
+        return UA_STATUSCODE_BADENCODINGERROR;
+
+    UA_StatusCode res = UA_ByteString_allocBuffer(out, typeIdSize + responseSize);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_Byte *pos = out->data;
+    const UA_Byte *end = &out->data[out->length];
+    res = UA_encodeBinaryInternal(typeId, &UA_TYPES[UA_TYPES_NODEID],
+                                  &pos, &end, NULL, NULL, NULL);
+    res |= UA_encodeBinaryInternal(response, responseType,
+                                   &pos, &end, NULL, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_ByteString_clear(out);
+    return res;
+}
+
+/* Mirrors decodeHeaderSendServiceFault */
+static UA_StatusCode
+decodeHeaderEncodeServiceFault(UA_Server *server, const UA_ByteString *msg,
+                               size_t offset, UA_StatusCode error,
+                               UA_ByteString *out) {
+    UA_RequestHeader requestHeader;
+    UA_StatusCode res =
+        UA_decodeBinaryInternal(msg, &offset, &requestHeader,
+                                &UA_TYPES[UA_TYPES_REQUESTHEADER], NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_ServiceFault fault;
+    UA_ServiceFault_init(&fault);
+    fault.responseHeader.requestHandle = requestHeader.requestHandle;
+    fault.responseHeader.serviceResult = error;
+    UA_RequestHeader_clear(&requestHeader);
+    return encodeServiceResponse(server, (UA_Response*)&fault,
+                                 &UA_TYPES[UA_TYPES_SERVICEFAULT], out);
+}
+
+/* Read and Browse can be executed under the shared server lock. See the
+ * documentation of UA_ServerConfig::concurrentReadServices. */
+static UA_Boolean
+useSharedLock(UA_Server *server, const UA_ServiceDescription *sd) {
+    return (server->config.concurrentReadServices &&
+            server->config.nodestore.concurrentReads &&
+            (sd->requestType == &UA_TYPES[UA_TYPES_READREQUEST] ||
+             sd->requestType == &UA_TYPES[UA_TYPES_BROWSEREQUEST]));
+}
+
+/* Same as processMSG. But only the service itself is executed under the server
+ * lock. Runs in a worker thread. Or in the EventLoop thread with the server
+ * lock held if the workers are stopped. */
+static UA_StatusCode
+processServiceJobMSG(UA_Server *server, UA_ServiceJob *job, UA_Boolean locked) {
+    UA_SecureChannel *channel = job->channel;
+    const UA_ByteString *msg = &job->request;
+
+    /* Decode the nodeid */
+    size_t offset = 0;
+    UA_NodeId requestTypeId;
+    UA_StatusCode retval = UA_NodeId_decodeBinary(msg, &offset, &requestTypeId);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    if(requestTypeId.namespaceIndex != 0 ||
+       requestTypeId.identifierType != UA_NODEIDTYPE_NUMERIC)
+        UA_NodeId_clear(&requestTypeId); /* leads to badserviceunsupported */
+
+    /* Get the service pointers */
+    UA_ServiceDescription *sd = getServiceDescription(requestTypeId.identifier.numeric);
+    if(!sd) {
+        UA_LOG_INFO_CHANNEL(server->config.logging, channel,
+                            "Unknown request with type identifier %" PRIi32,
+                            requestTypeId.identifier.numeric);
+        return decodeHeaderEncodeServiceFault(server, msg, offset,
+                                              UA_STATUSCODE_BADSERVICEUNSUPPORTED,
+                                              &job->response);
+    }
+
+    /* Decode the request into the arena of the channel. Only one request of
+     * the channel is processed at a time. */
+    UA_Request request;
+    size_t requestPos = offset; /* Store the offset (for the ServiceFault) */
+    UA_DecodeBinaryOptions opt;
+    memset(&opt, 0, sizeof(UA_DecodeBinaryOptions));
+    opt.customTypes = server->config.customDataTypes;
+    opt.callocContext = &channel->requestArena;
+    opt.calloc = UA_Arena_calloc;
+    opt.borrowStrings = true;
+    retval = UA_decodeBinaryInternal(msg, &offset, &request, sd->requestType, &opt);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_Arena_reset(&channel->requestArena);
+        UA_LOG_DEBUG_CHANNEL(server->config.logging, channel,
+                             "Could not decode the request with StatusCode %s",
+                             UA_StatusCode_name(retval));
+        return decodeHeaderEncodeServiceFault(server, msg, requestPos,
+                                              retval, &job->response);
+    }
+
+    /* Initialize the response */
+    UA_Response response;
+    UA_init(&response, sd->responseType);
+    response.responseHeader.requestHandle = request.requestHeader.requestHandle;
+
+    /* Process the request. Don't respond if the channel was closed in the
+     * meantime. */
+    UA_Boolean async = true;
+    UA_Boolean shared = (!locked && useSharedLock(server, sd));
+    if(shared)
+        lockServerShared(server);
+    else
+        lockServer(server);
+    if(channel->state == UA_SECURECHANNELSTATE_OPEN)
+        async = UA_Server_processRequest(server, channel, job->requestId,
+                                         sd, &request, &response);
+    if(shared)
+        unlockServerShared(server);
+    else
+        unlockServer(server);
+
+    /* Encode the response if not async */
+    if(UA_LIKELY(!async))
+        retval = encodeServiceResponse(server, &response, sd->responseType,
+                                       &job->response);
+
+    /* Clean up. The request is released with the arena. */
+    UA_clear(&response, sd->responseType);
+    UA_Arena_reset(&channel->requestArena);
+    return retval;
+}
+
+static void
+runServiceJob(UA_Server *server, UA_ServiceJob *job, UA_Boolean locked) {
+    job->result = processServiceJobMSG(server, job, locked);
+
+    /* Return to the EventLoop thread and wake it up */
+    UA_EventLoop *el = server->config.eventLoop;
+    el->addDelayedCallback(el, &job->dc);
+    el->cancel(el);
+}
+
+static void
+processServiceJob(UA_Server *server, UA_ServerWorkerJob *workerJob) {
+    runServiceJob(server, (UA_ServiceJob*)workerJob, false);
+}
+
+static void
+startServiceJob(UA_Server *server, UA_ServiceJob *job) {
+    /* Process in the current thread if the workers are stopped */
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_StatusCode res = UA_ServerWorkers_dispatch(&server->workers, &job->workerJob);
+    if(res != UA_STATUSCODE_GOOD)
+        runServiceJob(server, job, true);
+}
+
+/* Send the response and start the next job of the channel. Runs in the
+ * EventLoop thread. */
+static void
+serviceJobDone(void *application, void *context) {
+    UA_ServiceJob *job = (UA_ServiceJob*)application;
+    UA_BinaryProtocolManager *bpm = job->bpm;
+    UA_SecureChannel *channel = job->channel;
+    UA_Server *server = bpm->sc.server;
+
+    lockServer(server);
+
+    UA_assert(SIMPLEQ_FIRST(&channel->serviceJobs) == job);
+    SIMPLEQ_REMOVE_HEAD(&channel->serviceJobs, next);
+
+    /* Send the response */
+    UA_StatusCode res = job->result;
+    if(res == UA_STATUSCODE_GOOD && job->response.length > 0) {
+        if(channel->state == UA_SECURECHANNELSTATE_OPEN) {
+            UA_MessageContext mc;
+            res = UA_MessageContext_begin(&mc, channel, job->requestId,
+                                          UA_MESSAGETYPE_MSG);
+            if(res == UA_STATUSCODE_GOOD)
+                res = UA_MessageContext_encodeBuffer(&mc, &job->response);
+            if(res == UA_STATUSCODE_GOOD)
+                res = UA_MessageContext_finish(&mc);
+        }
+    }
+    if(res != UA_STATUSCODE_GOOD)
+        closeChannelAfterError(server, channel, res);
+    deleteServiceJob(job);
+
+    /* Continue with the next request of the channel. Or complete the deferred
+     * deletion of the channel. */
+    UA_ServiceJob *nextJob = SIMPLEQ_FIRST(&channel->serviceJobs);
+    if(nextJob) {
+        startServiceJob(server, nextJob);
+    } else if(channel->state == UA_SECURECHANNELSTATE_CLOSED) {
+        deleteServerSecureChannel(bpm, channel);
+        checkBinaryProtocolManagerStopped(bpm);
+    }
+
+    unlockServer(server);
+}
+
+static UA_StatusCode
+enqueueServiceJob(UA_BinaryProtocolManager *bpm, UA_SecureChannel *channel,
+                  UA_UInt32 requestId, const UA_ByteString *msg) {
+    if(channel->state != UA_SECURECHANNELSTATE_OPEN)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_ServiceJob *job = (UA_ServiceJob*)UA_calloc(1, sizeof(UA_ServiceJob));
+    if(!job)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_ByteString_copy(msg, &job->request);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(job);
+        return res;
+    }
+    job->workerJob.callback = processServiceJob;
+    job->dc.callback = serviceJobDone;
+    job->dc.application = job;
+    job->bpm = bpm;
+    job->channel = channel;
+    job->requestId = requestId;
+
+    /* Start right away if no other request of the channel is in progress */
+    UA_Boolean idle = SIMPLEQ_EMPTY(&channel->serviceJobs);
+    SIMPLEQ_INSERT_TAIL(&channel->serviceJobs, job, next);
+    if(idle)
+        startServiceJob(bpm->sc.server, job);
+    return UA_STATUSCODE_GOOD;
+}
+
+#endif /* UA_HAVE_SERVER_WORKERS */
+
 /* Takes decoded messages starting at the nodeid of the content type. */
 static UA_StatusCode
-processSecureChannelMessage(UA_Server *server, UA_SecureChannel *channel,
+processSecureChannelMessage(UA_BinaryProtocolManager *bpm, UA_SecureChannel *channel,
                             UA_MessageType messagetype, UA_UInt32 requestId,
                             UA_ByteString *message) {
+    UA_Server *server = bpm->sc.server;
     UA_LOCK_ASSERT(&server->serviceMutex);
 
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
@@ -518,6 +956,12 @@ processSecureChannelMessage(UA_Server *server, UA_SecureChannel *channel,
         break;
     case UA_MESSAGETYPE_MSG:
         UA_LOG_TRACE_CHANNEL(server->config.logging, channel, "Process a MSG");
+#ifdef UA_HAVE_SERVER_WORKERS
+        if(server->config.serviceWorkers > 0) {
+            retval = enqueueServiceJob(bpm, channel, requestId, message);
+            break;
+        }
+#endif
         retval = processMSG(server, channel, requestId, message);
         break;
     case UA_MESSAGETYPE_CLO:
@@ -529,38 +973,8 @@ processSecureChannelMessage(UA_Server *server, UA_SecureChannel *channel,
         retval = UA_STATUSCODE_BADTCPMESSAGETYPEINVALID;
         break;
     }
-    if(retval != UA_STATUSCODE_GOOD) {
-        if(!UA_SecureChannel_isConnected(channel)) {
-            UA_LOG_INFO_CHANNEL(server->config.logging, channel,
-                                "Processing the message failed. Channel already closed "
-                                "with StatusCode %s. ", UA_StatusCode_name(retval));
-            return retval;
-        }
-
-        UA_LOG_INFO_CHANNEL(server->config.logging, channel,
-                            "Processing the message failed with StatusCode %s. "
-                            "Closing the channel.", UA_StatusCode_name(retval));
-        UA_TcpErrorMessage errMsg;
-        UA_TcpErrorMessage_init(&errMsg);
-        errMsg.error = retval;
-        UA_SecureChannel_sendError(channel, &errMsg);
-        UA_ShutdownReason reason;
-        switch(retval) {
-        case UA_STATUSCODE_BADSECURITYMODEREJECTED:
-        case UA_STATUSCODE_BADSECURITYCHECKSFAILED:
-        case UA_STATUSCODE_BADSECURECHANNELIDINVALID:
-        case UA_STATUSCODE_BADSECURECHANNELTOKENUNKNOWN:
-        case UA_STATUSCODE_BADSECURITYPOLICYREJECTED:
-        case UA_STATUSCODE_BADCERTIFICATEUSENOTALLOWED:
-            reason = UA_SHUTDOWNREASON_SECURITYREJECT;
-            break;
-        default:
-            reason = UA_SHUTDOWNREASON_CLOSE;
-            break;
-        }
-        UA_SecureChannel_shutdown(channel, reason);
-    }
-
+    if(retval != UA_STATUSCODE_GOOD)
+        closeChannelAfterError(server, channel, retval);
     return retval;
 }
 
@@ -718,6 +1132,96 @@ addDiscoveryUrl(UA_Server *server, const UA_String hostname, UA_UInt16 port) {
     }
 }
 
+/* Chunks of an open channel without a pending token renewal are decrypted with
+ * the symmetric keys of the channel only. Then the reassembly runs without the
+ * server lock. */
+static UA_Boolean
+canReceiveUnlocked(const UA_SecureChannel *channel) {
+    return (channel->state == UA_SECURECHANNELSTATE_OPEN &&
+            channel->renewState == UA_SECURECHANNELRENEWSTATE_NORMAL);
+}
+
+/* Reassemble and decrypt the chunks received on the connection. The channel
+ * state for this is pinned to the reactor thread of the connection. The server
+ * lock is taken only to process the complete messages. If locked is true, the
+ * caller holds the lock already. */
+static void
+processConnectionBuffer(UA_BinaryProtocolManager *bpm, UA_ServerConnection *conn,
+                        UA_ByteString msg, UA_Boolean locked) {
+    UA_Server *server = bpm->sc.server;
+    UA_SecureChannel *channel = conn->channel;
+    UA_Boolean ownLock = false;
+
+#ifdef UA_DEBUG_DUMP_PKGS
+    UA_dump_hex_pkg(message->data, message->length);
+#endif
+#ifdef UA_DEBUG_DUMP_PKGS_FILE
+    UA_debug_dumpCompleteChunk(server, channel->connection, message);
+#endif
+
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
+
+    /* OPN chunks use the SecurityPolicy and certificate verification of the
+     * server. Keep the lock for the entire buffer then. */
+    UA_StatusCode retval = UA_SecureChannel_loadBuffer(channel, msg);
+    if(!locked && !UA_SecureChannel_onlySymmetricChunks(channel)) {
+        lockServer(server);
+        locked = ownLock = true;
+    }
+
+    /* Process all complete messages */
+    while(UA_LIKELY(retval == UA_STATUSCODE_GOOD)) {
+        UA_MessageType messageType;
+        UA_UInt32 requestId = 0;
+        UA_ByteString payload = UA_BYTESTRING_NULL;
+        UA_Boolean copied = false;
+        retval = UA_SecureChannel_getCompleteMessage(channel, &messageType, &requestId,
+                                                     &payload, &copied, nowMonotonic);
+        if(retval != UA_STATUSCODE_GOOD || payload.length == 0)
+            break;
+
+        /* Hand the message to the server */
+        UA_Boolean msgLock = !locked;
+        if(msgLock)
+            lockServer(server);
+        retval = processSecureChannelMessage(bpm, channel,
+                                             messageType, requestId, &payload);
+        conn->unlockedReceive = canReceiveUnlocked(channel);
+        if(msgLock) {
+            if(conn->unlockedReceive)
+                unlockServer(server);
+            else
+                locked = ownLock = true; /* Keep the lock for the remaining chunks */
+        }
+        if(copied)
+            UA_ByteString_clear(&payload);
+    }
+    retval |= UA_SecureChannel_persistBuffer(channel);
+
+    if(retval != UA_STATUSCODE_GOOD) {
+        if(!locked) {
+            lockServer(server);
+            ownLock = true;
+        }
+
+        UA_LOG_WARNING_CHANNEL(bpm->logging, channel,
+                               "Processing the message failed with error %s",
+                               UA_StatusCode_name(retval));
+
+        /* Send an ERR message and close the connection */
+        UA_TcpErrorMessage error;
+        error.error = retval;
+        error.reason = UA_STRING_NULL;
+        UA_SecureChannel_sendError(channel, &error);
+        UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_ABORT);
+        conn->unlockedReceive = false;
+    }
+
+    if(ownLock)
+        unlockServer(server);
+}
+
 /* Callback of a TCP socket (server socket or an active connection) */
 static void
 serverNetworkCallbackLocked(UA_ConnectionManager *cm, uintptr_t connectionId,
@@ -729,29 +1233,29 @@ serverNetworkCallbackLocked(UA_ConnectionManager *cm, uintptr_t connectionId,
     UA_LOCK_ASSERT(&bpm->sc.server->serviceMutex);
 
     /* A server socket that is not yet registered in the server. Register it and
-     * set the connection context to the pointer in the
+     * set the connection context to the entry in the
      * bpm->serverConnections list. New connections on that server socket
      * inherit the context (and on the first callback we set the context of
-     * client-connections to a SecureChannel). */
+     * client-connections to their own UA_ServerConnection). */
     if(*connectionContext == NULL) {
         /* The socket is closing without being previously registered -> ignore */
         if(state == UA_CONNECTIONSTATE_CLOSED ||
            state == UA_CONNECTIONSTATE_CLOSING)
             return;
 
-        /* Cannot register */
-        if(bpm->serverConnectionsSize >= UA_MAXSERVERCONNECTIONS) {
+        /* Allocate the entry for the server socket */
+        UA_ServerConnection *sc = (UA_ServerConnection*)
+            UA_calloc(1, sizeof(UA_ServerConnection));
+        if(!sc) {
             UA_LOG_WARNING(bpm->logging, UA_LOGCATEGORY_SERVER,
-                           "Cannot register server socket - too many already open");
+                           "Cannot register server socket - out of memory");
             cm->closeConnection(cm, connectionId);
             return;
         }
 
-        /* Find and use a free connection slot */
+        LIST_INSERT_HEAD(&bpm->serverConnections, sc, next);
         bpm->serverConnectionsSize++;
-        UA_ServerConnection *sc = bpm->serverConnections;
-        while(sc->connectionId != 0)
-            sc++;
+        sc->serverSocket = true;
         sc->state = state;
         sc->connectionId = connectionId;
         sc->connectionManager = cm;
@@ -770,98 +1274,57 @@ serverNetworkCallbackLocked(UA_ConnectionManager *cm, uintptr_t connectionId,
     }
 
     UA_ServerConnection *sc = (UA_ServerConnection*)*connectionContext;
-    UA_SecureChannel *channel = (UA_SecureChannel*)*connectionContext;
-    UA_Boolean serverSocket = (sc >= bpm->serverConnections &&
-                               sc < &bpm->serverConnections[UA_MAXSERVERCONNECTIONS]);
 
     /* The connection is closing. This is the last callback for it. */
     if(state == UA_CONNECTIONSTATE_CLOSING) {
-        if(serverSocket) {
+        if(sc->serverSocket) {
             /* Server socket is closed */
-            sc->state = UA_CONNECTIONSTATE_CLOSED;
-            sc->connectionId = 0;
+            LIST_REMOVE(sc, next);
             bpm->serverConnectionsSize--;
         } else {
             /* A connection attached to a SecureChannel is closing. This is the
              * only place where deleteSecureChannel must be used. */
-            deleteServerSecureChannel(bpm, channel);
+            deleteServerSecureChannel(bpm, sc->channel);
         }
+        UA_free(sc);
 
-        /* Set BinaryProtocolManager to STOPPED if it is STOPPING and the last
-         * socket just closed */
-        if(bpm->sc.state == UA_LIFECYCLESTATE_STOPPING &&
-           bpm->serverConnectionsSize == 0 &&
-           LIST_EMPTY(&bpm->reverseConnects) &&
-           TAILQ_EMPTY(&bpm->channels)) {
-           setBinaryProtocolManagerState(bpm, UA_LIFECYCLESTATE_STOPPED);
-        }
+        checkBinaryProtocolManagerStopped(bpm);
         return;
     }
 
-    UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    if(serverSocket) {
-        /* A new connection is opening. This is the only place where
-         * createSecureChannel is used. */
-        retval = createServerSecureChannel(bpm, cm, connectionId, &channel);
+    if(sc->serverSocket) {
+        /* A new connection is opening. It inherited the context of the server
+         * socket. This is the only place where createSecureChannel is used. */
+        UA_ServerConnection *conn = (UA_ServerConnection*)
+            UA_calloc(1, sizeof(UA_ServerConnection));
+        UA_StatusCode retval = UA_STATUSCODE_BADOUTOFMEMORY;
+        if(conn)
+            retval = createServerSecureChannel(bpm, cm, connectionId, &conn->channel);
         if(retval != UA_STATUSCODE_GOOD) {
             UA_LOG_WARNING(bpm->logging, UA_LOGCATEGORY_SERVER,
                            "TCP %lu\t| Could not accept the connection with status %s",
-                           (unsigned long)sc->connectionId, UA_StatusCode_name(retval));
+                           (unsigned long)connectionId, UA_StatusCode_name(retval));
+            UA_free(conn);
             *connectionContext = NULL;
             cm->closeConnection(cm, connectionId);
             return;
         }
 
-        /* Set the new channel as the new context for the connection */
-        *connectionContext = (void*)channel;
+        /* Set the new connection as the new context */
+        conn->state = state;
+        conn->connectionId = connectionId;
+        conn->connectionManager = cm;
+        *connectionContext = (void*)conn;
+        sc = conn;
 
         /* Set the channel state to CONNECTED until the HEL message is received */
-        channel->state = UA_SECURECHANNELSTATE_CONNECTED;
+        conn->channel->state = UA_SECURECHANNELSTATE_CONNECTED;
 
-        UA_LOG_INFO_CHANNEL(bpm->logging, channel, "SecureChannel created");
+        UA_LOG_INFO_CHANNEL(bpm->logging, conn->channel, "SecureChannel created");
     }
 
     /* Received a message on a normal connection */
-#ifdef UA_DEBUG_DUMP_PKGS
-    UA_dump_hex_pkg(message->data, message->length);
-#endif
-#ifdef UA_DEBUG_DUMP_PKGS_FILE
-    UA_debug_dumpCompleteChunk(server, channel->connection, message);
-#endif
-
-    UA_EventLoop *el = bpm->sc.server->config.eventLoop;
-    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
-
-    /* Process all complete messages */
-    retval = UA_SecureChannel_loadBuffer(channel, msg);
-    while(UA_LIKELY(retval == UA_STATUSCODE_GOOD)) {
-        UA_MessageType messageType;
-        UA_UInt32 requestId = 0;
-        UA_ByteString payload = UA_BYTESTRING_NULL;
-        UA_Boolean copied = false;
-        retval = UA_SecureChannel_getCompleteMessage(channel, &messageType, &requestId,
-                                                     &payload, &copied, nowMonotonic);
-        if(retval != UA_STATUSCODE_GOOD || payload.length == 0)
-            break;
-        retval = processSecureChannelMessage(bpm->sc.server, channel,
-                                             messageType, requestId, &payload);
-        if(copied)
-            UA_ByteString_clear(&payload);
-    }
-    retval |= UA_SecureChannel_persistBuffer(channel);
-
-    if(retval != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_CHANNEL(bpm->logging, channel,
-                               "Processing the message failed with error %s",
-                               UA_StatusCode_name(retval));
-
-        /* Send an ERR message and close the connection */
-        UA_TcpErrorMessage error;
-        error.error = retval;
-        error.reason = UA_STRING_NULL;
-        UA_SecureChannel_sendError(channel, &error);
-        UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_ABORT);
-    }
+    processConnectionBuffer(bpm, sc, msg, true);
 }
 
 void
@@ -871,6 +1334,18 @@ serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
                       const UA_KeyValueMap *params,
                       UA_ByteString msg) {
     UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)application;
+
+    /* Received data on an open channel. Only take the lock to process the
+     * complete messages. Closing and opening of connections is done under the
+     * server lock. The unlockedReceive flag is only changed from the reactor
+     * thread that serves the connection. */
+    UA_ServerConnection *conn = (UA_ServerConnection*)*connectionContext;
+    if(conn && !conn->serverSocket && conn->unlockedReceive &&
+       state != UA_CONNECTIONSTATE_CLOSING) {
+        processConnectionBuffer(bpm, conn, msg, false);
+        return;
+    }
+
     lockServer(bpm->sc.server);
     serverNetworkCallbackLocked(cm, connectionId, application, connectionContext,
                                 state, params, msg);
@@ -1251,12 +1726,7 @@ serverReverseConnectCallbackLocked(UA_ConnectionManager *cm, uintptr_t connectio
             UA_free(context);
 
             /* Check if the Binary Protocol Manager is stopped */
-            if(bpm->sc.state == UA_LIFECYCLESTATE_STOPPING &&
-               bpm->serverConnectionsSize == 0 &&
-               LIST_EMPTY(&bpm->reverseConnects) &&
-               TAILQ_EMPTY(&bpm->channels)) {
-                setBinaryProtocolManagerState(bpm, UA_LIFECYCLESTATE_STOPPED);
-            }
+            checkBinaryProtocolManagerStopped(bpm);
             return;
         }
 
@@ -1316,7 +1786,7 @@ serverReverseConnectCallbackLocked(UA_ConnectionManager *cm, uintptr_t connectio
                                                      &requestId, &payload, &copied, nowMonotonic);
         if(retval != UA_STATUSCODE_GOOD || payload.length == 0)
             break;
-        retval = processSecureChannelMessage(bpm->sc.server, context->channel,
+        retval = processSecureChannelMessage(bpm, context->channel,
                                              messageType, requestId, &payload);
         if(copied)
             UA_ByteString_clear(&payload);
@@ -1463,12 +1933,12 @@ UA_BinaryProtocolManager_stop(UA_ServerComponent *comp) {
         UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_CLOSE);
     }
 
-    /* Stop all server sockets */
-    for(size_t i = 0; i < UA_MAXSERVERCONNECTIONS; i++) {
-        UA_ServerConnection *sc = &bpm->serverConnections[i];
+    /* Stop all server sockets. They are removed from the list in the
+     * CLOSING callback. */
+    UA_ServerConnection *sc, *sc_tmp;
+    LIST_FOREACH_SAFE(sc, &bpm->serverConnections, next, sc_tmp) {
         UA_ConnectionManager *cm = sc->connectionManager;
-        if(sc->connectionId > 0)
-            cm->closeConnection(cm, sc->connectionId);
+        cm->closeConnection(cm, sc->connectionId);
     }
 
     /* If open sockets remain, set to STOPPING */
@@ -1500,6 +1970,7 @@ UA_BinaryProtocolManager_new(UA_Server *server) {
         return NULL;
 
     TAILQ_INIT(&bpm->channels);
+    LIST_INIT(&bpm->serverConnections);
 
     bpm->sc.name = UA_STRING("binary");
     bpm->sc.start = UA_BinaryProtocolManager_start;
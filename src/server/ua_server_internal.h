@@ -26,6 +26,7 @@
 #include "ua_session.h"
 #include "ua_services.h"
 #include "ua_server_async.h"
+#include "ua_server_workers.h"
 #include "../util/ua_util_internal.h"
 #include "ziptree.h"
 
@@ -185,6 +186,11 @@ getServerComponentByName(UA_Server *server, UA_String name);
 typedef struct session_list_entry {
     UA_DelayedCallback cleanupCallback;
     LIST_ENTRY(session_list_entry) pointers;
+    /* Chaining in the buckets of the hash indexes */
+    struct session_list_entry *tokenNext;
+    struct session_list_entry *idNext;
+    UA_UInt32 tokenHash;
+    UA_UInt32 idHash;
     UA_Session session;
 } session_list_entry;
 
@@ -207,9 +213,20 @@ struct UA_Server {
     UA_AsyncManager asyncManager;
 #endif
 
+#ifdef UA_HAVE_SERVER_WORKERS
+    UA_ServerWorkers workers;
+#endif
+
     /* Session Management */
     LIST_HEAD(session_list, session_list_entry) sessions;
     UA_UInt32 sessionCount;
+
+    /* Hash indexes of the sessions by authenticationToken and sessionId. The
+     * number of buckets is zero or a power of two. It grows with the number of
+     * sessions. */
+    session_list_entry **sessionsByToken;
+    session_list_entry **sessionsById;
+    UA_UInt32 sessionBuckets;
     UA_UInt32 activeSessionCount;
 
     /* Session for local access to the services for upkeep and the C API. Comes
@@ -242,6 +259,13 @@ struct UA_Server {
                                                  * server. They may be detached
                                                  * from a session. */
     UA_UInt32 lastSubscriptionId; /* To generate unique SubscriptionIds */
+    LIST_HEAD(, UA_SamplingGroup) samplingGroups; /* Shared timers for the
+                                                   * cyclic sampling */
+
+# ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    struct UA_EventIndex *eventIndex; /* Cached event propagation. Created
+                                       * lazily, can be NULL. */
+# endif
 
 # ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
     LIST_HEAD(, UA_ConditionSource) conditionSources;
@@ -253,6 +277,14 @@ struct UA_Server {
     UA_Lock serviceMutex;
 #endif
 
+#ifdef UA_HAVE_SERVER_WORKERS
+    /* Read-side lock for the service workers (see lockServerShared).
+     * lockServer takes it exclusively in addition to the serviceMutex. */
+    pthread_rwlock_t sharedLock;
+    size_t lockDepth; /* Recursion depth of lockServer. Protected by the
+                       * serviceMutex. */
+#endif
+
     /* Statistics */
     UA_SecureChannelStatistics secureChannelStatistics;
     UA_ServerDiagnosticsSummaryDataType serverDiagnosticsSummary;
@@ -325,6 +357,18 @@ void
 UA_Server_removeSession(UA_Server *server, session_list_entry *sentry,
                         UA_ShutdownReason shutdownReason);
 
+#if UA_MULTITHREADING >= 100
+/* A pinned session is not freed when it is removed. This allows to use the
+ * session pointer while the server lock is released. The removal itself
+ * (subscriptions, access control, etc.) is not deferred. */
+void
+UA_Server_pinSession(UA_Server *server, UA_Session *session);
+
+/* Frees the session if it was removed while it was pinned */
+void
+UA_Server_unpinSession(UA_Server *server, UA_Session *session);
+#endif
+
 UA_StatusCode
 UA_Server_removeSessionByToken(UA_Server *server, const UA_NodeId *token,
                                UA_ShutdownReason shutdownReason);
@@ -332,6 +376,14 @@ UA_Server_removeSessionByToken(UA_Server *server, const UA_NodeId *token,
 void
 UA_Server_cleanupSessions(UA_Server *server, UA_DateTime nowMonotonic);
 
+/* Lookup in the hash indexes. Does not check whether the session has timed
+ * out. */
+session_list_entry *
+lookupSessionByToken(UA_Server *server, const UA_NodeId *token);
+
+session_list_entry *
+lookupSessionById(UA_Server *server, const UA_NodeId *sessionId);
+
 UA_Session *
 getSessionByToken(UA_Server *server, const UA_NodeId *token);
 
@@ -432,6 +484,15 @@ UA_StatusCode
 sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
              UA_Response *response, const UA_DataType *responseType);
 
+/* Send a Publish or Republish response. The NotificationMessage is given in
+ * its binary encoding and copied into the message chunks. The
+ * notificationMessage member of the response structure is ignored. */
+UA_StatusCode
+sendResponseWithNotificationMessage(UA_Server *server, UA_SecureChannel *channel,
+                                    UA_UInt32 requestId, UA_Response *response,
+                                    const UA_DataType *responseType,
+                                    const UA_ByteString *notificationMessage);
+
 /* Many services come as an array of operations. This function generalizes the
  * processing of the operations. */
 typedef void (*UA_ServiceOperation)(UA_Server *server, UA_Session *session,
@@ -449,6 +510,19 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
                                    const UA_DataType *responseOperationsType)
     UA_FUNC_ATTR_WARN_UNUSED_RESULT;
 
+/* Same as above. But the operations must be independent of each other. Then
+ * large requests are executed in parallel by the service workers. See
+ * config->parallelOperationsThreshold. */
+UA_StatusCode
+UA_Server_processServiceOperationsParallel(UA_Server *server, UA_Session *session,
+                                           UA_ServiceOperation operationCallback,
+                                           const void *context,
+                                           const size_t *requestOperations,
+                                           const UA_DataType *requestOperationsType,
+                                           size_t *responseOperations,
+                                           const UA_DataType *responseOperationsType)
+    UA_FUNC_ATTR_WARN_UNUSED_RESULT;
+
 /*********************/
 /* Locking/Unlocking */
 /*********************/
@@ -459,6 +533,49 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
 void lockServer(UA_Server *server);
 void unlockServer(UA_Server *server);
 
+#ifdef UA_HAVE_SERVER_WORKERS
+/* The service workers execute Read and Browse requests with the server lock
+ * taken in shared mode (see UA_ServerConfig::concurrentReadServices). This
+ * excludes lockServer, but neither the EventLoop lock nor other shared
+ * holders. So the server state can be read but not modified. lockServer in a
+ * thread that holds the shared lock upgrades to the exclusive lock. The shared
+ * lock is released while the thread waits for the exclusive lock. So pointers
+ * into the server state (except for pinned sessions and nodes that are held
+ * from the Nodestore) must be looked up again afterwards. Must not be called
+ * when the thread holds the exclusive lock already. */
+void lockServerShared(UA_Server *server);
+void unlockServerShared(UA_Server *server);
+
+/* Whether the current thread holds the shared lock exactly once and without an
+ * upgrade. Then unlockServerShared releases it completely. */
+UA_Boolean holdsServerLockSharedOnce(UA_Server *server);
+
+/* The read path asserts that the lock is held in either mode. The parts of the
+ * read path that modify shared state or call user callbacks (except for the
+ * access control) take the lock exclusively if only the shared lock is held. */
+# define UA_LOCK_ASSERT_READ(server)                            \
+    do {                                                        \
+        if(UA_ServerWorkers_sharedLock != (server))             \
+            UA_LOCK_ASSERT(&(server)->serviceMutex);            \
+    } while(0)
+
+static UA_INLINE void
+lockConcurrentRead(UA_Server *server) {
+    if(UA_ServerWorkers_sharedLock == server)
+        lockServer(server);
+}
+
+static UA_INLINE void
+unlockConcurrentRead(UA_Server *server) {
+    if(UA_ServerWorkers_sharedLock == server)
+        unlockServer(server);
+}
+#else
+# define UA_LOCK_ASSERT_READ(server) UA_LOCK_ASSERT(&(server)->serviceMutex)
+# define lockConcurrentRead(server)
+# define unlockConcurrentRead(server)
+#endif
+
 /******************************************/
 /* Internal function calls, without locks */
 /******************************************/
@@ -575,9 +692,30 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
  * notification */
 UA_StatusCode
 filterEvent(UA_Server *server, UA_Session *session,
-            const UA_NodeId *eventNode, UA_EventFilter *filter,
+            const UA_EventInstance *event, UA_EventFilter *filter,
+            UA_EventFilterCompiled *compiled,
             UA_EventFieldList *efl, UA_EventFilterResult *result);
 
+UA_StatusCode
+triggerEventFields(UA_Server *server, const UA_NodeId eventType,
+                   const UA_NodeId origin, const UA_KeyValueMap *eventFields,
+                   UA_ByteString *outEventId);
+
+/* The nodes that emit the events of an origin and their event MonitoredItems
+ * are cached in an index. The index is dropped when the event propagation
+ * hierarchy changes on a visited node. That is, when a propagation reference or
+ * an event MonitoredItem is added or removed, or when the node is deleted. */
+void
+UA_EventIndex_delete(UA_Server *server);
+
+void
+UA_EventIndex_nodeChanged(UA_Server *server, const UA_NodeId *nodeId);
+
+void
+UA_EventIndex_referenceChanged(UA_Server *server, UA_Byte refTypeIndex,
+                               const UA_NodeId *sourceId,
+                               const UA_NodeId *targetId);
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS_EVENTS */
 
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
@@ -819,11 +957,6 @@ initNS0PushManagement(UA_Server *server);
 
 
 #ifdef UA_ENABLE_DIAGNOSTICS
-void createSessionObject(UA_Server *server, UA_Session *session);
-
-void createSubscriptionObject(UA_Server *server, UA_Session *session,
-                              UA_Subscription *sub);
-
 UA_StatusCode
 readDiagnostics(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
                 const UA_NodeId *nodeId, void *nodeContext, UA_Boolean sourceTimestamp,
@@ -861,12 +994,98 @@ readSessionSecurityDiagnostics(UA_Server *server,
 #define UA_NODESTORE_DELETE(server, node)                               \
     server->config.nodestore.deleteNode(server->config.nodestore.context, node)
 
+#ifdef UA_ENABLE_DIAGNOSTICS
+/* The diagnostics objects of the Sessions and Subscriptions are virtual. Their
+ * nodes are not stored in the Nodestore but synthesized from the live
+ * UA_Session and UA_Subscription structures when they are accessed. This also
+ * applies to the two ns0 nodes that reference them.
+ *
+ * The virtual nodes in namespace 1 have an opaque ByteString NodeId with a
+ * fixed prefix. This includes the session object whose NodeId is the
+ * SessionId. So the NodeId alone tells whether a node can be virtual. A
+ * synthesized node has the "synthesized" flag set in its head and is deleted
+ * when it is released. Getting a virtual node only reads the session state and
+ * works under the shared server lock. */
+#define UA_DIAGNOSTICS_NODEID_PREFIX "DIAG"
+#define UA_DIAGNOSTICS_NODEID_LENGTH 28
+
+static UA_INLINE UA_Boolean
+isDiagnosticsNodeId(const UA_NodeId *id) {
+    if(id->namespaceIndex == 1)
+        return (id->identifierType == UA_NODEIDTYPE_BYTESTRING &&
+                id->identifier.byteString.length == UA_DIAGNOSTICS_NODEID_LENGTH &&
+                memcmp(id->identifier.byteString.data,
+                       UA_DIAGNOSTICS_NODEID_PREFIX, 4) == 0);
+    return (id->namespaceIndex == 0 &&
+            id->identifierType == UA_NODEIDTYPE_NUMERIC &&
+            (id->identifier.numeric ==
+             UA_NS0ID_SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY ||
+             id->identifier.numeric ==
+             UA_NS0ID_SERVER_SERVERDIAGNOSTICS_SUBSCRIPTIONDIAGNOSTICSARRAY));
+}
+
+/* Create a new random SessionId. It is the NodeId of the session object. */
+UA_StatusCode
+createDiagnosticsSessionId(UA_NodeId *sessionId);
+
+/* Returns NULL if the NodeId does not point to a virtual node. Then the node
+ * is looked up in the Nodestore. */
+const UA_Node *
+getDiagnosticsNode(UA_Server *server, const UA_NodeId *nodeId,
+                   UA_ReferenceTypeSet references,
+                   UA_BrowseDirection referenceDirections);
+
+const UA_Node *
+getDiagnosticsNodeFromPtr(UA_Server *server, UA_NodePointer target,
+                          UA_ReferenceTypeSet references,
+                          UA_BrowseDirection referenceDirections);
+#endif
+
+static UA_INLINE const UA_Node *
+UA_NODESTORE_GET_SELECTIVE(UA_Server *server, const UA_NodeId *nodeId,
+                           UA_UInt32 attrMask, UA_ReferenceTypeSet refs,
+                           UA_BrowseDirection refDirs) {
+#ifdef UA_ENABLE_DIAGNOSTICS
+    if(isDiagnosticsNodeId(nodeId)) {
+        const UA_Node *node = getDiagnosticsNode(server, nodeId, refs, refDirs);
+        if(node)
+            return node;
+    }
+#endif
+    return server->config.nodestore.getNode(server->config.nodestore.context,
+                                            nodeId, attrMask, refs, refDirs);
+}
+
+static UA_INLINE const UA_Node *
+UA_NODESTORE_GETFROMREF_SELECTIVE(UA_Server *server, UA_NodePointer target,
+                                  UA_UInt32 attrMask, UA_ReferenceTypeSet refs,
+                                  UA_BrowseDirection refDirs) {
+#ifdef UA_ENABLE_DIAGNOSTICS
+    const UA_Node *node = getDiagnosticsNodeFromPtr(server, target, refs, refDirs);
+    if(node)
+        return node;
+#endif
+    return server->config.nodestore.getNodeFromPtr(server->config.nodestore.context,
+                                                   target, attrMask, refs, refDirs);
+}
+
+static UA_INLINE void
+UA_NODESTORE_RELEASE(UA_Server *server, const UA_Node *node) {
+#ifdef UA_ENABLE_DIAGNOSTICS
+    if(node && node->head.synthesized) {
+        UA_NODESTORE_DELETE(server, (UA_Node*)(uintptr_t)node);
+        return;
+    }
+#endif
+    server->config.nodestore.releaseNode(server->config.nodestore.context, node);
+}
+
 /* Get the node with all attributes and references */
 static UA_INLINE const UA_Node *
 UA_NODESTORE_GET(UA_Server *server, const UA_NodeId *nodeId) {
-    return server->config.nodestore.
-        getNode(server->config.nodestore.context, nodeId, UA_NODEATTRIBUTESMASK_ALL,
-                UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    return UA_NODESTORE_GET_SELECTIVE(server, nodeId, UA_NODEATTRIBUTESMASK_ALL,
+                                      UA_REFERENCETYPESET_ALL,
+                                      UA_BROWSEDIRECTION_BOTH);
 }
 
 /* Get the editable node with all attributes and references */
@@ -881,26 +1100,15 @@ UA_NODESTORE_GET_EDIT(UA_Server *server, const UA_NodeId *nodeId) {
 /* Get the node with all attributes and references */
 static UA_INLINE const UA_Node *
 UA_NODESTORE_GETFROMREF(UA_Server *server, UA_NodePointer target) {
-    return server->config.nodestore.
-        getNodeFromPtr(server->config.nodestore.context, target, UA_NODEATTRIBUTESMASK_ALL,
-                       UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    return UA_NODESTORE_GETFROMREF_SELECTIVE(server, target, UA_NODEATTRIBUTESMASK_ALL,
+                                             UA_REFERENCETYPESET_ALL,
+                                             UA_BROWSEDIRECTION_BOTH);
 }
 
-#define UA_NODESTORE_GET_SELECTIVE(server, nodeid, attrMask, refs, refDirs) \
-    server->config.nodestore.getNode(server->config.nodestore.context,      \
-                                     nodeid, attrMask, refs, refDirs)
-
 #define UA_NODESTORE_GET_EDIT_SELECTIVE(server, nodeid, attrMask, refs, refDirs) \
     server->config.nodestore.getEditNode(server->config.nodestore.context,       \
                                          nodeid, attrMask, refs, refDirs)
 
-#define UA_NODESTORE_GETFROMREF_SELECTIVE(server, target, attrMask, refs, refDirs) \
-    server->config.nodestore.getNodeFromPtr(server->config.nodestore.context,      \
-                                            target, attrMask, refs, refDirs)
-
-#define UA_NODESTORE_RELEASE(server, node)                              \
-    server->config.nodestore.releaseNode(server->config.nodestore.context, node)
-
 #define UA_NODESTORE_GETCOPY(server, nodeid, outnode)                      \
     server->config.nodestore.getNodeCopy(server->config.nodestore.context, \
                                          nodeid, outnode)
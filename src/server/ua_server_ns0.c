@@ -909,20 +909,32 @@ UA_StatusCode
 initNS0(UA_Server *server) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    /* Initialize base nodes which are always required an cannot be created
-     * through the NS compiler */
-    server->bootstrapNS0 = true;
-    UA_StatusCode retVal = createNS0_base(server);
+    /* The Nodestore already contains ns0, e.g. from a prebuilt image. Then
+     * only the DataSources and callbacks are attached below. */
+    UA_StatusCode retVal = UA_STATUSCODE_GOOD;
+    UA_NodeId rootId = UA_NS0ID(ROOTFOLDER);
+    const UA_Node *root =
+        UA_NODESTORE_GET_SELECTIVE(server, &rootId, UA_NODEATTRIBUTESMASK_NONE,
+                                   UA_REFERENCETYPESET_NONE,
+                                   UA_BROWSEDIRECTION_INVALID);
+    if(root) {
+        UA_NODESTORE_RELEASE(server, root);
+    } else {
+        /* Initialize base nodes which are always required an cannot be
+         * created through the NS compiler */
+        server->bootstrapNS0 = true;
+        retVal = createNS0_base(server);
 
 #ifdef UA_GENERATED_NAMESPACE_ZERO
-    /* Load nodes and references generated from the XML ns0 definition */
-    retVal |= namespace0_generated(server);
+        /* Load nodes and references generated from the XML ns0 definition */
+        retVal |= namespace0_generated(server);
 #else
-    /* Create a minimal server object */
-    retVal |= minimalServerObject(server);
+        /* Create a minimal server object */
+        retVal |= minimalServerObject(server);
 #endif
 
-    server->bootstrapNS0 = false;
+        server->bootstrapNS0 = false;
+    }
 
     if(retVal != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
@@ -13,7 +13,7 @@
 #ifdef UA_ENABLE_DIAGNOSTICS
 
 static UA_Boolean
-equalBrowseName(UA_String *bn, char *n) {
+equalBrowseName(const UA_String *bn, char *n) {
     UA_String name = UA_STRING(n);
     return UA_String_equal(bn, &name);
 }
@@ -67,39 +67,26 @@ fillSubscriptionDiagnostics(UA_Subscription *sub,
     }
 }
 
-/* The node context points to the subscription */
+/* Returns the SubscriptionDiagnostics (name is NULL) or one of its members */
 static UA_StatusCode
-readSubscriptionDiagnostics(UA_Server *server,
-                            const UA_NodeId *sessionId, void *sessionContext,
-                            const UA_NodeId *nodeId, void *nodeContext,
-                            UA_Boolean sourceTimestamp,
-                            const UA_NumericRange *range, UA_DataValue *value) {
-    /* Check the Subscription pointer */
-    UA_Subscription *sub = (UA_Subscription*)nodeContext;
-    if(!sub)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    /* Read the BrowseName */
-    UA_QualifiedName bn;
-    UA_StatusCode res = UA_Server_readBrowseName(server, *nodeId, &bn);
-    if(res != UA_STATUSCODE_GOOD)
-        return res;
-
+readSubscriptionDiagnostics(UA_Subscription *sub, const UA_String *name,
+                            UA_DataValue *value) {
     /* Set the value */
     UA_SubscriptionDiagnosticsDataType sddt;
     UA_SubscriptionDiagnosticsDataType_init(&sddt);
     fillSubscriptionDiagnostics(sub, &sddt);
 
     char memberName[128];
-    memcpy(memberName, bn.name.data, bn.name.length);
-    memberName[bn.name.length] = 0;
-
-    size_t memberOffset;
-    const UA_DataType *memberType;
+    size_t memberOffset = 0;
+    const UA_DataType *memberType = NULL;
     UA_Boolean isArray;
-    UA_Boolean found =
-        UA_DataType_getStructMember(&UA_TYPES[UA_TYPES_SUBSCRIPTIONDIAGNOSTICSDATATYPE],
-                                    memberName, &memberOffset, &memberType, &isArray);
+    UA_Boolean found = false;
+    if(name && name->length < sizeof(memberName)) {
+        memcpy(memberName, name->data, name->length);
+        memberName[name->length] = 0;
+        found = UA_DataType_getStructMember(&UA_TYPES[UA_TYPES_SUBSCRIPTIONDIAGNOSTICSDATATYPE],
+                                            memberName, &memberOffset, &memberType, &isArray);
+    }
     if(!found) {
         /* Not the member, but the main subscription diagnostics variable... */
         memberOffset = 0;
@@ -107,12 +94,11 @@ readSubscriptionDiagnostics(UA_Server *server,
     }
 
     void *content = (void*)(((uintptr_t)&sddt) + memberOffset);
-    res = UA_Variant_setScalarCopy(&value->value, content, memberType);
+    UA_StatusCode res = UA_Variant_setScalarCopy(&value->value, content, memberType);
     if(UA_LIKELY(res == UA_STATUSCODE_GOOD))
         value->hasValue = true;
 
     UA_SubscriptionDiagnosticsDataType_clear(&sddt);
-    UA_QualifiedName_clear(&bn);
     return res;
 }
 
@@ -159,80 +145,6 @@ readSubscriptionDiagnosticsArray(UA_Server *server,
     return UA_STATUSCODE_GOOD;
 }
 
-void
-createSubscriptionObject(UA_Server *server, UA_Session *session,
-                         UA_Subscription *sub) {
-    UA_ExpandedNodeId *children = NULL;
-    size_t childrenSize = 0;
-    UA_ReferenceTypeSet refTypes;
-    UA_NodeId hasComponent = UA_NS0ID(HASCOMPONENT);
-
-    char subIdStr[32];
-    itoaUnsigned(sub->subscriptionId, subIdStr, 10);
-
-    /* Find the NodeId of the SubscriptionDiagnosticsArray */
-    UA_BrowsePath bp;
-    UA_BrowsePath_init(&bp);
-    bp.startingNode = sub->session->sessionId;
-    UA_RelativePathElement rpe[1];
-    memset(rpe, 0, sizeof(UA_RelativePathElement) * 1);
-    rpe[0].targetName = UA_QUALIFIEDNAME(0, "SubscriptionDiagnosticsArray");
-    bp.relativePath.elements = rpe;
-    bp.relativePath.elementsSize = 1;
-    UA_BrowsePathResult bpr = translateBrowsePathToNodeIds(server, &bp);
-    if(bpr.targetsSize < 1)
-        return;
-
-    /* Create an object for the subscription. Instantiates all the mandatory
-     * children. */
-    UA_VariableAttributes var_attr = UA_VariableAttributes_default;
-    var_attr.displayName.text = UA_STRING(subIdStr);
-    var_attr.dataType = UA_TYPES[UA_TYPES_SUBSCRIPTIONDIAGNOSTICSDATATYPE].typeId;
-    UA_NodeId refId = UA_NS0ID(HASCOMPONENT);
-    UA_QualifiedName browseName = UA_QUALIFIEDNAME(0, subIdStr);
-    UA_NodeId typeId = UA_NS0ID(SUBSCRIPTIONDIAGNOSTICSTYPE);
-    /* Assign a random free NodeId */
-    UA_StatusCode res = addNode(server, UA_NODECLASS_VARIABLE, UA_NODEID_NUMERIC(1, 0),
-                                bpr.targets[0].targetId.nodeId,
-                                refId, browseName, typeId, &var_attr,
-                                &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES], NULL,
-                                &sub->ns0Id);
-    UA_CHECK_STATUS(res, goto cleanup);
-
-    /* Add a second reference from the overall SubscriptionDiagnosticsArray variable */
-    const UA_NodeId subDiagArray = UA_NS0ID(SERVER_SERVERDIAGNOSTICS_SUBSCRIPTIONDIAGNOSTICSARRAY);
-    res = addRefWithSession(server, session,  &subDiagArray, &refId, &sub->ns0Id, true);
-    if(res != UA_STATUSCODE_GOOD)
-        goto cleanup;
-
-    /* Get all children (including the variable itself) and set the contenxt + callback */
-    res = referenceTypeIndices(server, &hasComponent, &refTypes, false);
-    if(UA_LIKELY(res == UA_STATUSCODE_GOOD)) {
-        res = browseRecursive(server, 1, &sub->ns0Id,
-                              UA_BROWSEDIRECTION_FORWARD, &refTypes,
-                              UA_NODECLASS_VARIABLE, true, &childrenSize, &children);
-    }
-    if(res != UA_STATUSCODE_GOOD)
-        goto cleanup;
-
-    /* Add the callback to all variables  */
-    UA_DataSource subDiagSource = {readSubscriptionDiagnostics, NULL};
-    for(size_t i = 0; i < childrenSize; i++) {
-        setVariableNode_dataSource(server, children[i].nodeId, subDiagSource);
-        setNodeContext(server, children[i].nodeId, sub);
-    }
-
-    UA_Array_delete(children, childrenSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
-
- cleanup:
-    UA_BrowsePathResult_clear(&bpr);
-    if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SESSION(server->config.logging, session,
-                               "Creating the subscription diagnostics object failed "
-                               "with StatusCode %s", UA_StatusCode_name(res));
-    }
-}
-
 /***********************/
 /* Session Diagnostics */
 /***********************/
@@ -347,28 +259,11 @@ setSessionSecurityDiagnostics(UA_Session *session,
     }
 }
 
+/* Returns the session diagnostics variable with the name (or a member thereof) */
 static UA_StatusCode
-readSessionDiagnostics(UA_Server *server,
-                       const UA_NodeId *sessionId, void *sessionContext,
-                       const UA_NodeId *nodeId, void *nodeContext,
-                       UA_Boolean sourceTimestamp,
-                       const UA_NumericRange *range, UA_DataValue *value) {
-    lockServer(server);
-
-    /* Get the Session */
-    UA_Session *session = getSessionById(server, sessionId);
-    if(!session) {
-        unlockServer(server);
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-
-    /* Read the BrowseName */
-    UA_QualifiedName bn;
-    UA_StatusCode res = readWithReadValue(server, nodeId, UA_ATTRIBUTEID_BROWSENAME, &bn);
-    if(res != UA_STATUSCODE_GOOD) {
-        unlockServer(server);
-        return res;
-    }
+readSessionDiagnostics(UA_Server *server, UA_Session *session,
+                       const UA_String *name, UA_DataValue *value) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
 
     union {
         UA_SessionDiagnosticsDataType sddt;
@@ -378,23 +273,22 @@ readSessionDiagnostics(UA_Server *server,
     UA_Boolean isArray = false;
     const UA_DataType *type = NULL;
     UA_Boolean securityDiagnostics = false;
+    UA_StatusCode res;
 
     char memberName[128];
     size_t memberOffset;
     UA_Boolean found;
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS
-    if(equalBrowseName(&bn.name, "SubscriptionDiagnosticsArray")) {
-        res = setSessionSubscriptionDiagnostics(server, session, value);
-        goto cleanup;
-    }
+    if(equalBrowseName(name, "SubscriptionDiagnosticsArray"))
+        return setSessionSubscriptionDiagnostics(server, session, value);
 #endif
 
-    if(equalBrowseName(&bn.name, "SessionDiagnostics")) {
+    if(equalBrowseName(name, "SessionDiagnostics")) {
         setSessionDiagnostics(session, &data.sddt);
         content = &data.sddt;
         type = &UA_TYPES[UA_TYPES_SESSIONDIAGNOSTICSDATATYPE];
-    } else if(equalBrowseName(&bn.name, "SessionSecurityDiagnostics")) {
+    } else if(equalBrowseName(name, "SessionSecurityDiagnostics")) {
         setSessionSecurityDiagnostics(session, &data.ssddt);
         securityDiagnostics = true;
         content = &data.ssddt;
@@ -402,8 +296,10 @@ readSessionDiagnostics(UA_Server *server,
     } else {
         /* Try to find the member in SessionDiagnosticsDataType and
          * SessionSecurityDiagnosticsDataType */
-        memcpy(memberName, bn.name.data, bn.name.length);
-        memberName[bn.name.length] = 0;
+        if(name->length >= sizeof(memberName))
+            return UA_STATUSCODE_BADNOTIMPLEMENTED;
+        memcpy(memberName, name->data, name->length);
+        memberName[name->length] = 0;
         found = UA_DataType_getStructMember(&UA_TYPES[UA_TYPES_SESSIONDIAGNOSTICSDATATYPE],
                                             memberName, &memberOffset, &type, &isArray);
         if(found) {
@@ -413,10 +309,8 @@ readSessionDiagnostics(UA_Server *server,
             const UA_DataType *dt = &UA_TYPES[UA_TYPES_SESSIONSECURITYDIAGNOSTICSDATATYPE];
             found = UA_DataType_getStructMember(dt, memberName, &memberOffset,
                                                 &type, &isArray);
-            if(!found) {
-                res = UA_STATUSCODE_BADNOTIMPLEMENTED;
-                goto cleanup;
-            }
+            if(!found)
+                return UA_STATUSCODE_BADNOTIMPLEMENTED;
             setSessionSecurityDiagnostics(session, &data.ssddt);
             securityDiagnostics = true;
             content = (void*)(((uintptr_t)&data.ssddt) + memberOffset);
@@ -437,10 +331,6 @@ readSessionDiagnostics(UA_Server *server,
         UA_SessionSecurityDiagnosticsDataType_clear(&data.ssddt);
     else
         UA_SessionDiagnosticsDataType_clear(&data.sddt);
-
- cleanup:
-    UA_QualifiedName_clear(&bn);
-    unlockServer(server);
     return res;
 }
 
@@ -476,50 +366,594 @@ readSessionSecurityDiagnostics(UA_Server *server,
     return UA_STATUSCODE_GOOD;
 }
 
-void
-createSessionObject(UA_Server *server, UA_Session *session) {
-    UA_ExpandedNodeId *children = NULL;
-    size_t childrenSize = 0;
-    UA_ReferenceTypeSet refTypes;
-    UA_NodeId hasComponent = UA_NS0ID(HASCOMPONENT);
-
-    /* Create an object for the session. Instantiates all the mandatory children. */
-    UA_ObjectAttributes object_attr = UA_ObjectAttributes_default;
-    object_attr.displayName.text = session->sessionName;
-    UA_NodeId parentId = UA_NS0ID(SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY);
-    UA_NodeId refId = UA_NS0ID(HASCOMPONENT);
-    UA_QualifiedName browseName = UA_QUALIFIEDNAME(0, "");
-    browseName.name = session->sessionName; /* shallow copy */
-    UA_NodeId typeId = UA_NS0ID(SESSIONDIAGNOSTICSOBJECTTYPE);
-    UA_StatusCode res = addNode(server, UA_NODECLASS_OBJECT, session->sessionId,
-                                parentId, refId, browseName, typeId, &object_attr,
-                                &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES], NULL, NULL);
-    if(res != UA_STATUSCODE_GOOD)
+/*****************/
+/* Virtual Nodes */
+/*****************/
+
+/* The diagnostics object of every Session and the diagnostics variable of every
+ * Subscription are not stored in the Nodestore. The nodes are synthesized from
+ * the instance declarations of the SessionDiagnosticsObjectType and the
+ * SubscriptionDiagnosticsType when they are accessed. The values are read from
+ * the live UA_Session and UA_Subscription structures.
+ *
+ * The virtual nodes have an opaque ByteString NodeId in namespace 1. It
+ * starts with the "DIAG" prefix and encodes the random GUID of the session,
+ * the SubscriptionId (zero for the session) and the numerical ns0 NodeId of
+ * the instance declaration (zero for the session object or the subscription
+ * variable itself). The SessionId is the NodeId of the session object. */
+
+#define DIAGNOSTICS_MAX_DEPTH 8
+
+/* Virtual nodes cannot keep MonitoredItems that are notified for every change.
+ * So they are always sampled cyclically. */
+#define DIAGNOSTICS_MINIMUMSAMPLINGINTERVAL 100.0
+
+typedef struct {
+    UA_Guid session;
+    UA_UInt32 subscriptionId;
+    UA_UInt32 declId;
+} DiagnosticsNodeId;
+
+/* The NodeId points into the buffer */
+static UA_NodeId
+diagnosticsNodeIdFromBuf(const DiagnosticsNodeId *d,
+                         UA_Byte buf[UA_DIAGNOSTICS_NODEID_LENGTH]) {
+    memcpy(buf, UA_DIAGNOSTICS_NODEID_PREFIX, 4);
+    memcpy(&buf[4], &d->session, 16);
+    memcpy(&buf[20], &d->subscriptionId, 4);
+    memcpy(&buf[24], &d->declId, 4);
+    UA_NodeId id;
+    UA_NodeId_init(&id);
+    id.namespaceIndex = 1;
+    id.identifierType = UA_NODEIDTYPE_BYTESTRING;
+    id.identifier.byteString.length = UA_DIAGNOSTICS_NODEID_LENGTH;
+    id.identifier.byteString.data = buf;
+    return id;
+}
+
+static UA_StatusCode
+encodeDiagnosticsNodeId(const DiagnosticsNodeId *d, UA_NodeId *id) {
+    UA_Byte buf[UA_DIAGNOSTICS_NODEID_LENGTH];
+    UA_NodeId tmp = diagnosticsNodeIdFromBuf(d, buf);
+    return UA_NodeId_copy(&tmp, id);
+}
+
+static UA_Boolean
+decodeDiagnosticsNodeId(const UA_NodeId *id, DiagnosticsNodeId *d) {
+    if(id->namespaceIndex != 1 || !isDiagnosticsNodeId(id))
+        return false;
+    const UA_Byte *data = id->identifier.byteString.data;
+    memcpy(&d->session, &data[4], 16);
+    memcpy(&d->subscriptionId, &data[20], 4);
+    memcpy(&d->declId, &data[24], 4);
+    return true;
+}
+
+UA_StatusCode
+createDiagnosticsSessionId(UA_NodeId *sessionId) {
+    DiagnosticsNodeId d = {UA_Guid_random(), 0, 0};
+    return encodeDiagnosticsNodeId(&d, sessionId);
+}
+
+static UA_Guid
+sessionGuid(const UA_Session *session) {
+    DiagnosticsNodeId d = {UA_GUID_NULL, 0, 0};
+    decodeDiagnosticsNodeId(&session->sessionId, &d);
+    return d.session;
+}
+
+static session_list_entry *
+lookupDiagnosticsSession(UA_Server *server, const DiagnosticsNodeId *d) {
+    UA_Byte buf[UA_DIAGNOSTICS_NODEID_LENGTH];
+    DiagnosticsNodeId s = {d->session, 0, 0};
+    UA_NodeId sessionId = diagnosticsNodeIdFromBuf(&s, buf);
+    return lookupSessionById(server, &sessionId);
+}
+
+static UA_StatusCode
+readVirtualDiagnostics(UA_Server *server,
+                       const UA_NodeId *sessionId, void *sessionContext,
+                       const UA_NodeId *nodeId, void *nodeContext,
+                       UA_Boolean sourceTimestamp,
+                       const UA_NumericRange *range, UA_DataValue *value) {
+    DiagnosticsNodeId d;
+    if(!decodeDiagnosticsNodeId(nodeId, &d))
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    lockServer(server);
+
+    /* The Session (or Subscription) can be gone in the meantime */
+    UA_StatusCode res = UA_STATUSCODE_BADNODEIDUNKNOWN;
+    const UA_Node *decl = NULL;
+    const UA_String *name = NULL;
+    session_list_entry *entry = lookupDiagnosticsSession(server, &d);
+    if(!entry)
         goto cleanup;
 
-    /* Recursively browse all children */
-    res = referenceTypeIndices(server, &hasComponent, &refTypes, false);
+    /* The BrowseName of the instance declaration selects the value */
+    if(d.declId != 0) {
+        UA_NodeId id = UA_NODEID_NUMERIC(0, d.declId);
+        decl = UA_NODESTORE_GET_SELECTIVE(server, &id, UA_NODEATTRIBUTESMASK_BROWSENAME,
+                                          UA_REFERENCETYPESET_NONE,
+                                          UA_BROWSEDIRECTION_INVALID);
+        if(!decl)
+            goto cleanup;
+        name = &decl->head.browseName.name;
+    }
+
+    if(d.subscriptionId == 0) {
+        if(name)
+            res = readSessionDiagnostics(server, &entry->session, name, value);
+    }
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    else {
+        UA_Subscription *sub =
+            UA_Session_getSubscriptionById(&entry->session, d.subscriptionId);
+        if(sub)
+            res = readSubscriptionDiagnostics(sub, name, value);
+    }
+#endif
+
+ cleanup:
+    if(decl)
+        UA_NODESTORE_RELEASE(server, decl);
+    unlockServer(server);
+    return res;
+}
+
+static UA_StatusCode
+addLocalReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
+                  const UA_NodeId *target, UA_UInt32 targetNameHash) {
+    UA_ExpandedNodeId en;
+    UA_ExpandedNodeId_init(&en);
+    en.nodeId = *target; /* shallow copy */
+    return UA_Node_addReference(node, refTypeIndex, isForward, &en, targetNameHash);
+}
+
+static UA_StatusCode
+addDiagnosticsReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
+                        const DiagnosticsNodeId *target, UA_UInt32 targetNameHash) {
+    UA_NodeId id;
+    UA_StatusCode res = encodeDiagnosticsNodeId(target, &id);
     if(res != UA_STATUSCODE_GOOD)
-        goto cleanup;
-    res = browseRecursive(server, 1, &session->sessionId,
-                          UA_BROWSEDIRECTION_FORWARD, &refTypes,
-                          UA_NODECLASS_VARIABLE, false, &childrenSize, &children);
+        return res;
+    res = addLocalReference(node, refTypeIndex, isForward, &id, targetNameHash);
+    UA_NodeId_clear(&id);
+    return res;
+}
+
+static UA_UInt32
+nameHash(char *name) {
+    UA_QualifiedName qn = UA_QUALIFIEDNAME(0, name);
+    return UA_QualifiedName_hash(&qn);
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+static UA_UInt32
+subscriptionNameHash(UA_UInt32 subscriptionId) {
+    char subIdStr[16];
+    itoaUnsigned(subscriptionId, subIdStr, 10);
+    return nameHash(subIdStr);
+}
+#endif
+
+/* The instance declarations are connected with HasComponent and HasProperty */
+static UA_Boolean
+isChildReference(UA_Byte refTypeIndex) {
+    return (refTypeIndex == UA_REFERENCETYPEINDEX_HASCOMPONENT ||
+            refTypeIndex == UA_REFERENCETYPEINDEX_HASPROPERTY);
+}
+
+/* Returns zero if the target is not a numerical ns0 NodeId */
+static UA_UInt32
+ns0TargetId(const UA_ReferenceTarget *t) {
+    if(!UA_NodePointer_isLocal(t->targetId))
+        return 0;
+    UA_NodeId id = UA_NodePointer_toNodeId(t->targetId);
+    if(id.namespaceIndex != 0 || id.identifierType != UA_NODEIDTYPE_NUMERIC)
+        return 0;
+    return id.identifier.numeric;
+}
+
+static void *
+firstTarget(void *context, UA_ReferenceTarget *t) {
+    return t;
+}
+
+static const UA_ReferenceTarget *
+getDeclarationParent(const UA_Node *decl, UA_Byte *refTypeIndex) {
+    for(size_t i = 0; i < decl->head.referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &decl->head.references[i];
+        if(!rk->isInverse || !isChildReference(rk->referenceTypeIndex))
+            continue;
+        const UA_ReferenceTarget *t = (const UA_ReferenceTarget*)
+            UA_NodeReferenceKind_iterate(rk, firstTarget, NULL);
+        if(t) {
+            *refTypeIndex = rk->referenceTypeIndex;
+            return t;
+        }
+    }
+    return NULL;
+}
+
+/* Walk up from the instance declaration until the type is reached */
+static UA_Boolean
+isDeclarationOf(UA_Server *server, UA_UInt32 declId, UA_UInt32 typeId) {
+    UA_ReferenceTypeSet refs =
+        UA_ReferenceTypeSet_union(UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASCOMPONENT),
+                                  UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASPROPERTY));
+    for(size_t depth = 0; depth < DIAGNOSTICS_MAX_DEPTH && declId != 0; depth++) {
+        if(declId == typeId)
+            return true;
+        UA_NodeId id = UA_NODEID_NUMERIC(0, declId);
+        const UA_Node *decl =
+            UA_NODESTORE_GET_SELECTIVE(server, &id, UA_NODEATTRIBUTESMASK_NONE,
+                                       refs, UA_BROWSEDIRECTION_INVERSE);
+        if(!decl)
+            return false;
+        UA_Byte refTypeIndex;
+        const UA_ReferenceTarget *parent = getDeclarationParent(decl, &refTypeIndex);
+        declId = (parent) ? ns0TargetId(parent) : 0;
+        UA_NODESTORE_RELEASE(server, decl);
+    }
+    return false;
+}
+
+static UA_Boolean
+isMandatory(UA_Server *server, UA_UInt32 declId) {
+    UA_NodeId id = UA_NODEID_NUMERIC(0, declId);
+    const UA_Node *decl =
+        UA_NODESTORE_GET_SELECTIVE(server, &id, UA_NODEATTRIBUTESMASK_NONE,
+                                   UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASMODELLINGRULE),
+                                   UA_BROWSEDIRECTION_FORWARD);
+    if(!decl)
+        return false;
+
+    UA_Boolean mandatory = false;
+    UA_ExpandedNodeId rule = UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_MODELLINGRULE_MANDATORY);
+    for(size_t i = 0; i < decl->head.referencesSize; i++) {
+        const UA_NodeReferenceKind *rk = &decl->head.references[i];
+        if(rk->isInverse ||
+           rk->referenceTypeIndex != UA_REFERENCETYPEINDEX_HASMODELLINGRULE)
+            continue;
+        if(UA_NodeReferenceKind_findTarget(rk, &rule)) {
+            mandatory = true;
+            break;
+        }
+    }
+    UA_NODESTORE_RELEASE(server, decl);
+    return mandatory;
+}
+
+typedef struct {
+    UA_Server *server;
+    UA_Node *node;
+    DiagnosticsNodeId child;
+    UA_Byte refTypeIndex;
+    UA_StatusCode res;
+} ChildrenContext;
+
+static void *
+addMandatoryChild(void *context, UA_ReferenceTarget *t) {
+    ChildrenContext *cc = (ChildrenContext*)context;
+    cc->child.declId = ns0TargetId(t);
+    if(cc->child.declId == 0 || !isMandatory(cc->server, cc->child.declId))
+        return NULL;
+    cc->res = addDiagnosticsReference(cc->node, cc->refTypeIndex, true,
+                                      &cc->child, t->targetNameHash);
+    return (cc->res != UA_STATUSCODE_GOOD) ? cc : NULL;
+}
+
+/* Reference the virtual nodes for the mandatory children of the instance
+ * declaration (or type) */
+static UA_StatusCode
+addMandatoryChildren(UA_Server *server, UA_Node *node, const UA_Node *decl,
+                     const DiagnosticsNodeId *d) {
+    ChildrenContext cc;
+    cc.server = server;
+    cc.node = node;
+    cc.child = *d;
+    cc.refTypeIndex = 0;
+    cc.res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < decl->head.referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &decl->head.references[i];
+        if(rk->isInverse || !isChildReference(rk->referenceTypeIndex))
+            continue;
+        cc.refTypeIndex = rk->referenceTypeIndex;
+        UA_NodeReferenceKind_iterate(rk, addMandatoryChild, &cc);
+        if(cc.res != UA_STATUSCODE_GOOD)
+            break;
+    }
+    return cc.res;
+}
+
+static void
+setVirtualValue(UA_VariableNode *vn) {
+    if(vn->valueSource == UA_VALUESOURCE_DATA)
+        UA_DataValue_clear(&vn->value.data.value);
+    vn->valueSource = UA_VALUESOURCE_DATASOURCE;
+    vn->value.dataSource.read = readVirtualDiagnostics;
+    vn->value.dataSource.write = NULL;
+    vn->accessLevel = UA_ACCESSLEVELMASK_READ;
+    if(vn->minimumSamplingInterval < DIAGNOSTICS_MINIMUMSAMPLINGINTERVAL)
+        vn->minimumSamplingInterval = DIAGNOSTICS_MINIMUMSAMPLINGINTERVAL;
+}
+
+static UA_Node *
+synthesizeSessionObject(UA_Server *server, UA_Session *session,
+                        UA_Boolean forward, UA_Boolean inverse) {
+    UA_NodeId typeId = UA_NS0ID(SESSIONDIAGNOSTICSOBJECTTYPE);
+    const UA_Node *type = UA_NODESTORE_GET(server, &typeId);
+    if(!type)
+        return NULL;
+
+    UA_Node *node = UA_NODESTORE_NEW(server, UA_NODECLASS_OBJECT);
+    if(!node) {
+        UA_NODESTORE_RELEASE(server, type);
+        return NULL;
+    }
+
+    UA_LocalizedText displayName;
+    UA_LocalizedText_init(&displayName);
+    displayName.text = session->sessionName; /* shallow copy */
+    UA_StatusCode res = UA_NodeId_copy(&session->sessionId, &node->head.nodeId);
+    res |= UA_String_copy(&session->sessionName, &node->head.browseName.name);
+    res |= UA_Node_insertOrUpdateDisplayName(&node->head, &displayName);
+    res |= addLocalReference(node, UA_REFERENCETYPEINDEX_HASTYPEDEFINITION, true,
+                             &typeId, UA_QualifiedName_hash(&type->head.browseName));
+    if(inverse) {
+        UA_NodeId parentId = UA_NS0ID(SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY);
+        res |= addLocalReference(node, UA_REFERENCETYPEINDEX_HASCOMPONENT, false,
+                                 &parentId, nameHash("SessionsDiagnosticsSummary"));
+    }
+    if(forward && res == UA_STATUSCODE_GOOD) {
+        DiagnosticsNodeId d = {sessionGuid(session), 0, 0};
+        res = addMandatoryChildren(server, node, type, &d);
+    }
+
+    UA_NODESTORE_RELEASE(server, type);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_DELETE(server, node);
+        return NULL;
+    }
+    return node;
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+static UA_Node *
+synthesizeSubscriptionVariable(UA_Server *server, UA_Session *session,
+                               UA_Subscription *sub,
+                               UA_Boolean forward, UA_Boolean inverse) {
+    UA_NodeId typeId = UA_NS0ID(SUBSCRIPTIONDIAGNOSTICSTYPE);
+    const UA_Node *type = UA_NODESTORE_GET(server, &typeId);
+    if(!type)
+        return NULL;
+
+    UA_Node *node = UA_NODESTORE_NEW(server, UA_NODECLASS_VARIABLE);
+    if(!node) {
+        UA_NODESTORE_RELEASE(server, type);
+        return NULL;
+    }
+
+    char subIdStr[16];
+    UA_LocalizedText displayName;
+    UA_LocalizedText_init(&displayName);
+    displayName.text.length = itoaUnsigned(sub->subscriptionId, subIdStr, 10);
+    displayName.text.data = (UA_Byte*)subIdStr;
+
+    DiagnosticsNodeId d = {sessionGuid(session), sub->subscriptionId, 0};
+    UA_VariableNode *vn = &node->variableNode;
+    UA_StatusCode res = encodeDiagnosticsNodeId(&d, &node->head.nodeId);
+    res |= UA_String_copy(&displayName.text, &node->head.browseName.name);
+    res |= UA_Node_insertOrUpdateDisplayName(&node->head, &displayName);
+    res |= UA_NodeId_copy(&UA_TYPES[UA_TYPES_SUBSCRIPTIONDIAGNOSTICSDATATYPE].typeId,
+                          &vn->dataType);
+    vn->valueRank = UA_VALUERANK_SCALAR;
+    setVirtualValue(vn);
+    res |= addLocalReference(node, UA_REFERENCETYPEINDEX_HASTYPEDEFINITION, true,
+                             &typeId, UA_QualifiedName_hash(&type->head.browseName));
+
+    /* Referenced from the SubscriptionDiagnosticsArray of the session and
+     * from the server-wide SubscriptionDiagnosticsArray */
+    if(inverse) {
+        UA_UInt32 arrayHash = nameHash("SubscriptionDiagnosticsArray");
+        DiagnosticsNodeId p = {d.session, 0,
+            UA_NS0ID_SESSIONDIAGNOSTICSOBJECTTYPE_SUBSCRIPTIONDIAGNOSTICSARRAY};
+        UA_NodeId arrayId = UA_NS0ID(SERVER_SERVERDIAGNOSTICS_SUBSCRIPTIONDIAGNOSTICSARRAY);
+        res |= addDiagnosticsReference(node, UA_REFERENCETYPEINDEX_HASCOMPONENT,
+                                       false, &p, arrayHash);
+        res |= addLocalReference(node, UA_REFERENCETYPEINDEX_HASCOMPONENT,
+                                 false, &arrayId, arrayHash);
+    }
+    if(forward && res == UA_STATUSCODE_GOOD)
+        res = addMandatoryChildren(server, node, type, &d);
+
+    UA_NODESTORE_RELEASE(server, type);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_DELETE(server, node);
+        return NULL;
+    }
+    return node;
+}
+
+static UA_StatusCode
+addSubscriptionReferences(UA_Node *node, UA_Session *session) {
+    DiagnosticsNodeId d = {sessionGuid(session), 0, 0};
+    UA_Subscription *sub;
+    TAILQ_FOREACH(sub, &session->subscriptions, sessionListEntry) {
+        if(sub->statusChange != UA_STATUSCODE_GOOD)
+            continue;
+        d.subscriptionId = sub->subscriptionId;
+        UA_StatusCode res =
+            addDiagnosticsReference(node, UA_REFERENCETYPEINDEX_HASCOMPONENT, true,
+                                    &d, subscriptionNameHash(sub->subscriptionId));
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+#endif
+
+/* Synthesize the virtual node from a copy of the instance declaration */
+static UA_Node *
+synthesizeDeclaration(UA_Server *server, UA_Session *session,
+                      const DiagnosticsNodeId *d,
+                      UA_Boolean forward, UA_Boolean inverse) {
+    UA_NodeId declId = UA_NODEID_NUMERIC(0, d->declId);
+    const UA_Node *decl = UA_NODESTORE_GET(server, &declId);
+    if(!decl)
+        return NULL;
+
+    /* The instance declaration has to be part of the type */
+    UA_Node *node = NULL;
+    UA_Byte parentRefType = 0;
+    UA_UInt32 typeId = (d->subscriptionId == 0) ?
+        UA_NS0ID_SESSIONDIAGNOSTICSOBJECTTYPE : UA_NS0ID_SUBSCRIPTIONDIAGNOSTICSTYPE;
+    const UA_ReferenceTarget *parent = getDeclarationParent(decl, &parentRefType);
+    UA_UInt32 parentId = (parent) ? ns0TargetId(parent) : 0;
+    UA_ReferenceTypeSet keep = UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASTYPEDEFINITION);
+    UA_StatusCode res = UA_STATUSCODE_BADNODEIDUNKNOWN;
+    if(isDeclarationOf(server, parentId, typeId))
+        res = UA_NODESTORE_GETCOPY(server, &declId, &node);
     if(res != UA_STATUSCODE_GOOD)
         goto cleanup;
 
-    /* Add the callback to all variables  */
-    UA_DataSource sessionDiagSource = {readSessionDiagnostics, NULL};
-    for(size_t i = 0; i < childrenSize; i++) {
-        setVariableNode_dataSource(server, children[i].nodeId, sessionDiagSource);
+    /* Replace the NodeId and the references of the copy. The
+     * TypeDefinition is kept. */
+    UA_Node_deleteReferencesSubset(node, &keep);
+    UA_NodeId_clear(&node->head.nodeId);
+    res = encodeDiagnosticsNodeId(d, &node->head.nodeId);
+    node->head.context = NULL;
+    if(node->head.nodeClass == UA_NODECLASS_VARIABLE)
+        setVirtualValue(&node->variableNode);
+
+    if(inverse && res == UA_STATUSCODE_GOOD) {
+        DiagnosticsNodeId p = *d;
+        p.declId = (parentId == typeId) ? 0 : parentId;
+        res = addDiagnosticsReference(node, parentRefType, false,
+                                      &p, parent->targetNameHash);
     }
 
+    if(forward && res == UA_STATUSCODE_GOOD)
+        res = addMandatoryChildren(server, node, decl, d);
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    if(forward && res == UA_STATUSCODE_GOOD && d->subscriptionId == 0 &&
+       d->declId == UA_NS0ID_SESSIONDIAGNOSTICSOBJECTTYPE_SUBSCRIPTIONDIAGNOSTICSARRAY)
+        res = addSubscriptionReferences(node, session);
+#endif
+
  cleanup:
-    if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SESSION(server->config.logging, session,
-                               "Creating the session diagnostics object failed "
-                               "with StatusCode %s", UA_StatusCode_name(res));
+    UA_NODESTORE_RELEASE(server, decl);
+    if(res != UA_STATUSCODE_GOOD && node) {
+        UA_NODESTORE_DELETE(server, node);
+        node = NULL;
+    }
+    return node;
+}
+
+/* The ns0 nodes that reference the virtual nodes are copied with the
+ * additional references */
+static UA_Node *
+synthesizeDiagnosticsArray(UA_Server *server, const UA_NodeId *nodeId) {
+    if(server->sessionCount == 0)
+        return NULL;
+
+    UA_Node *node = NULL;
+    UA_StatusCode res = UA_NODESTORE_GETCOPY(server, nodeId, &node);
+    if(res != UA_STATUSCODE_GOOD)
+        return NULL;
+
+    session_list_entry *entry;
+    LIST_FOREACH(entry, &server->sessions, pointers) {
+        UA_Session *session = &entry->session;
+        if(nodeId->identifier.numeric ==
+           UA_NS0ID_SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY) {
+            UA_QualifiedName bn;
+            bn.namespaceIndex = 0;
+            bn.name = session->sessionName;
+            res = addLocalReference(node, UA_REFERENCETYPEINDEX_HASCOMPONENT, true,
+                                    &session->sessionId, UA_QualifiedName_hash(&bn));
+        }
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        else {
+            res = addSubscriptionReferences(node, session);
+        }
+#endif
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_NODESTORE_DELETE(server, node);
+            return NULL;
+        }
     }
-    UA_Array_delete(children, childrenSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    return node;
+}
+
+const UA_Node *
+getDiagnosticsNode(UA_Server *server, const UA_NodeId *nodeId,
+                   UA_ReferenceTypeSet references,
+                   UA_BrowseDirection referenceDirections) {
+    UA_LOCK_ASSERT_READ(server);
+
+    /* Add only the (expensive) hierarchical references that were requested */
+    UA_Boolean children =
+        UA_ReferenceTypeSet_contains(&references, UA_REFERENCETYPEINDEX_HASCOMPONENT) ||
+        UA_ReferenceTypeSet_contains(&references, UA_REFERENCETYPEINDEX_HASPROPERTY);
+    UA_Boolean forward = children &&
+        (referenceDirections == UA_BROWSEDIRECTION_FORWARD ||
+         referenceDirections == UA_BROWSEDIRECTION_BOTH);
+    UA_Boolean inverse = children &&
+        (referenceDirections == UA_BROWSEDIRECTION_INVERSE ||
+         referenceDirections == UA_BROWSEDIRECTION_BOTH);
+
+    UA_Node *node = NULL;
+    if(nodeId->namespaceIndex == 0) {
+        /* Without the forward references, the ns0 node is used as is */
+        if(!forward)
+            return NULL;
+        node = synthesizeDiagnosticsArray(server, nodeId);
+    } else {
+        DiagnosticsNodeId d;
+        if(!decodeDiagnosticsNodeId(nodeId, &d))
+            return NULL;
+        session_list_entry *entry = lookupDiagnosticsSession(server, &d);
+        if(!entry)
+            return NULL;
+        UA_Session *session = &entry->session;
+
+        if(d.subscriptionId == 0) {
+            node = (d.declId == 0) ?
+                synthesizeSessionObject(server, session, forward, inverse) :
+                synthesizeDeclaration(server, session, &d, forward, inverse);
+        }
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        else {
+            UA_Subscription *sub = UA_Session_getSubscriptionById(session, d.subscriptionId);
+            if(!sub)
+                return NULL;
+            node = (d.declId == 0) ?
+                synthesizeSubscriptionVariable(server, session, sub, forward, inverse) :
+                synthesizeDeclaration(server, session, &d, forward, inverse);
+        }
+#endif
+    }
+    if(!node)
+        return NULL;
+
+    /* The node is deleted when it is released */
+    node->head.synthesized = true;
+    return node;
+}
+
+const UA_Node *
+getDiagnosticsNodeFromPtr(UA_Server *server, UA_NodePointer target,
+                          UA_ReferenceTypeSet references,
+                          UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(target))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(target);
+    if(!isDiagnosticsNodeId(&id))
+        return NULL;
+    return getDiagnosticsNode(server, &id, references, referenceDirections);
 }
 
 /***************************/
@@ -242,6 +242,7 @@ checkSessionActive(UA_Server *server, void *data) {
             fileInfoContext->fileInfo.openCount -= 1;
 
             UA_ByteString_clear(&fileContext->file);
+            UA_NodeId_clear(&fileContext->sessionId);
             UA_free(fileContext);
 
             /* Updating OpenCount Variable in the information model */
@@ -679,13 +680,15 @@ openTrustList(UA_Server *server,
 
     UA_FileContext *fileContext = (UA_FileContext*)UA_calloc(1, sizeof(UA_FileContext));
     fileContext->file = encTrustList;
-    fileContext->sessionId = *sessionId;
     fileContext->openFileMode = fileOpenMode;
     fileContext->currentPos = 0;
     fileContext->dataToWrite = UA_BYTESTRING_NULL;
-    retval = createFileHandleId(fileInfo, &fileContext->fileHandle);
+    retval = UA_NodeId_copy(sessionId, &fileContext->sessionId);
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = createFileHandleId(fileInfo, &fileContext->fileHandle);
     if(retval != UA_STATUSCODE_GOOD) {
         UA_ByteString_clear(&fileContext->file);
+        UA_NodeId_clear(&fileContext->sessionId);
         UA_free(fileContext);
         return retval;
     }
@@ -750,13 +753,15 @@ openTrustListWithMask(UA_Server *server,
 
     UA_FileContext *fileContext = (UA_FileContext*)UA_calloc(1, sizeof(UA_FileContext));
     fileContext->file = encTrustList;
-    fileContext->sessionId = *sessionId;
     fileContext->openFileMode = UA_OPENFILEMODE_READ;
     fileContext->currentPos = 0;
     fileContext->dataToWrite = UA_BYTESTRING_NULL;
-    retval = createFileHandleId(fileInfo, &fileContext->fileHandle);
+    retval = UA_NodeId_copy(sessionId, &fileContext->sessionId);
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = createFileHandleId(fileInfo, &fileContext->fileHandle);
     if(retval != UA_STATUSCODE_GOOD) {
         UA_ByteString_clear(&fileContext->file);
+        UA_NodeId_clear(&fileContext->sessionId);
         UA_free(fileContext);
         return retval;
     }
@@ -911,6 +916,7 @@ closeTrustList(UA_Server *server,
 
     UA_ByteString_clear(&fileContext->file);
     UA_ByteString_clear(&fileContext->dataToWrite);
+    UA_NodeId_clear(&fileContext->sessionId);
     UA_free(fileContext);
 
     /* Updating OpenCount Variable in the information model */
@@ -974,6 +980,7 @@ closeAndUpdateTrustList(UA_Server *server,
 
     UA_ByteString_clear(&fileContext->file);
     UA_ByteString_clear(&fileContext->dataToWrite);
+    UA_NodeId_clear(&fileContext->sessionId);
     UA_free(fileContext);
 
     /* Updating OpenCount Variable in the information model */
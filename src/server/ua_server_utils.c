@@ -279,13 +279,34 @@ UA_Server_editNode(UA_Server *server, UA_Session *session, const UA_NodeId *node
     return retval;
 }
 
-UA_StatusCode
-UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
-                                   UA_ServiceOperation operationCallback,
-                                   const void *context, const size_t *requestOperations,
-                                   const UA_DataType *requestOperationsType,
-                                   size_t *responseOperations,
-                                   const UA_DataType *responseOperationsType) {
+#ifdef UA_HAVE_SERVER_WORKERS
+typedef struct {
+    UA_Session *session;
+    UA_ServiceOperation operationCallback;
+    const void *context;
+    uintptr_t reqOp;
+    size_t reqOpSize;
+    uintptr_t respOp;
+    size_t respOpSize;
+} UA_ParallelServiceOperations;
+
+static void
+processParallelServiceOperation(UA_Server *server, void *context, size_t index) {
+    UA_ParallelServiceOperations *p = (UA_ParallelServiceOperations*)context;
+    p->operationCallback(server, p->session, p->context,
+                         (void*)(p->reqOp + (index * p->reqOpSize)),
+                         (void*)(p->respOp + (index * p->respOpSize)));
+}
+#endif
+
+static UA_StatusCode
+processServiceOperations(UA_Server *server, UA_Session *session,
+                         UA_ServiceOperation operationCallback,
+                         const void *context, const size_t *requestOperations,
+                         const UA_DataType *requestOperationsType,
+                         size_t *responseOperations,
+                         const UA_DataType *responseOperationsType,
+                         UA_Boolean parallel) {
     size_t ops = *requestOperations;
     if(ops == 0)
         return UA_STATUSCODE_BADNOTHINGTODO;
@@ -300,6 +321,22 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
     uintptr_t respOp = (uintptr_t)*respPos;
     /* No padding after size_t */
     uintptr_t reqOp = *(uintptr_t*)((uintptr_t)requestOperations + sizeof(size_t));
+
+#ifdef UA_HAVE_SERVER_WORKERS
+    /* Execute large requests in parallel */
+    size_t threshold = server->config.parallelOperationsThreshold;
+    if(parallel && threshold > 0 && ops >= threshold) {
+        UA_ParallelServiceOperations p = {
+            session, operationCallback, context,
+            reqOp, requestOperationsType->memSize,
+            respOp, responseOperationsType->memSize};
+        UA_ServerWorkers_processOperations(server, session,
+                                           processParallelServiceOperation,
+                                           &p, ops);
+        return UA_STATUSCODE_GOOD;
+    }
+#endif
+
     for(size_t i = 0; i < ops; i++) {
         operationCallback(server, session, context, (void*)reqOp, (void*)respOp);
         reqOp += requestOperationsType->memSize;
@@ -308,6 +345,33 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
+                                   UA_ServiceOperation operationCallback,
+                                   const void *context, const size_t *requestOperations,
+                                   const UA_DataType *requestOperationsType,
+                                   size_t *responseOperations,
+                                   const UA_DataType *responseOperationsType) {
+    return processServiceOperations(server, session, operationCallback, context,
+                                    requestOperations, requestOperationsType,
+                                    responseOperations, responseOperationsType,
+                                    false);
+}
+
+UA_StatusCode
+UA_Server_processServiceOperationsParallel(UA_Server *server, UA_Session *session,
+                                           UA_ServiceOperation operationCallback,
+                                           const void *context,
+                                           const size_t *requestOperations,
+                                           const UA_DataType *requestOperationsType,
+                                           size_t *responseOperations,
+                                           const UA_DataType *responseOperationsType) {
+    return processServiceOperations(server, session, operationCallback, context,
+                                    requestOperations, requestOperationsType,
+                                    responseOperations, responseOperationsType,
+                                    true);
+}
+
 /* A few global NodeId definitions */
 const UA_NodeId subtypeId = {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_HASSUBTYPE}};
 const UA_NodeId hierarchicalReferences = {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_HIERARCHICALREFERENCES}};
@@ -0,0 +1,325 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "ua_server_internal.h"
+
+#ifdef UA_HAVE_SERVER_WORKERS
+
+void
+UA_ServerWorkers_init(UA_ServerWorkers *sw) {
+    memset(sw, 0, sizeof(UA_ServerWorkers));
+    pthread_mutex_init(&sw->mutex, NULL);
+    pthread_cond_init(&sw->cond, NULL);
+    SIMPLEQ_INIT(&sw->jobs);
+}
+
+void
+UA_ServerWorkers_clear(UA_ServerWorkers *sw) {
+    UA_assert(!sw->running);
+    UA_assert(sw->threadsSize == 0);
+    pthread_cond_destroy(&sw->cond);
+    pthread_mutex_destroy(&sw->mutex);
+}
+
+static void *
+workerLoop(void *data) {
+    UA_ServerWorkers *sw = (UA_ServerWorkers*)data;
+    pthread_mutex_lock(&sw->mutex);
+    while(true) {
+        UA_ServerWorkerJob *job = SIMPLEQ_FIRST(&sw->jobs);
+        if(!job) {
+            /* Leave only once the queue is drained */
+            if(!sw->running)
+                break;
+            pthread_cond_wait(&sw->cond, &sw->mutex);
+            continue;
+        }
+        SIMPLEQ_REMOVE_HEAD(&sw->jobs, next);
+
+        /* Execute the job without holding the mutex */
+        pthread_mutex_unlock(&sw->mutex);
+        job->callback(sw->server, job);
+        pthread_mutex_lock(&sw->mutex);
+    }
+    pthread_mutex_unlock(&sw->mutex);
+    return NULL;
+}
+
+UA_StatusCode
+UA_ServerWorkers_start(UA_ServerWorkers *sw, UA_Server *server) {
+    size_t threads = server->config.serviceWorkers;
+    if(threads == 0 || sw->running)
+        return UA_STATUSCODE_GOOD;
+
+    sw->threads = (pthread_t*)UA_calloc(threads, sizeof(pthread_t));
+    if(!sw->threads)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    sw->server = server;
+    sw->running = true;
+    for(; sw->threadsSize < threads; sw->threadsSize++) {
+        int err = pthread_create(&sw->threads[sw->threadsSize],
+                                 NULL, workerLoop, sw);
+        if(err != 0) {
+            UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
+                         "Could not start a service worker thread");
+            UA_ServerWorkers_stop(sw);
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+    }
+
+    UA_LOG_INFO(server->config.logging, UA_LOGCATEGORY_SERVER,
+                "Started %lu service worker threads", (unsigned long)threads);
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_ServerWorkers_stop(UA_ServerWorkers *sw) {
+    pthread_mutex_lock(&sw->mutex);
+    sw->running = false;
+    pthread_cond_broadcast(&sw->cond);
+    pthread_mutex_unlock(&sw->mutex);
+
+    for(size_t i = 0; i < sw->threadsSize; i++)
+        pthread_join(sw->threads[i], NULL);
+    UA_free(sw->threads);
+    sw->threads = NULL;
+    sw->threadsSize = 0;
+}
+
+UA_StatusCode
+UA_ServerWorkers_dispatch(UA_ServerWorkers *sw, UA_ServerWorkerJob *job) {
+    pthread_mutex_lock(&sw->mutex);
+    if(!sw->running) {
+        pthread_mutex_unlock(&sw->mutex);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    SIMPLEQ_INSERT_TAIL(&sw->jobs, job, next);
+    pthread_cond_signal(&sw->cond);
+    pthread_mutex_unlock(&sw->mutex);
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_Boolean
+UA_ServerWorkers_cancel(UA_ServerWorkers *sw, UA_ServerWorkerJob *job) {
+    pthread_mutex_lock(&sw->mutex);
+    UA_Boolean found = false;
+    UA_ServerWorkerJob *prev = NULL, *j;
+    SIMPLEQ_FOREACH(j, &sw->jobs, next) {
+        if(j == job) {
+            if(prev)
+                SIMPLEQ_REMOVE_AFTER(&sw->jobs, prev, next);
+            else
+                SIMPLEQ_REMOVE_HEAD(&sw->jobs, next);
+            found = true;
+            break;
+        }
+        prev = j;
+    }
+    pthread_mutex_unlock(&sw->mutex);
+    return found;
+}
+
+/*******************************/
+/* Parallel Service Operations */
+/*******************************/
+
+UA_THREAD_LOCAL UA_Boolean UA_ServerWorkers_parallelOperation = false;
+UA_THREAD_LOCAL UA_Server *UA_ServerWorkers_sharedLock = NULL;
+
+typedef struct {
+    UA_Server *server;
+    UA_ServerWorkerOperation operation;
+    void *context;
+    size_t ops;
+    size_t chunkSize;
+    UA_Boolean shared; /* Take the shared lock for the chunks */
+    volatile size_t claimed; /* Operations claimed so far (atomic) */
+
+    pthread_mutex_t mutex; /* Protects the fields below */
+    pthread_cond_t cond;   /* Signals finished jobs */
+    size_t pending;        /* Dispatched jobs that have not finished */
+    UA_DateTime opTimeSum;
+    UA_DateTime opTimeMax;
+} UA_OperationBatch;
+
+typedef struct {
+    UA_ServerWorkerJob job; /* Must be the first member */
+    UA_OperationBatch *batch;
+} UA_OperationBatchJob;
+
+/* Claim and execute chunks until all operations are claimed. The server lock
+ * is taken once per chunk. */
+static void
+processBatch(UA_OperationBatch *b) {
+    UA_Server *server = b->server;
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime sum = 0, max = 0;
+    UA_Boolean parallel = UA_ServerWorkers_parallelOperation;
+    UA_ServerWorkers_parallelOperation = true;
+    while(true) {
+        size_t end = UA_atomic_addSize(&b->claimed, b->chunkSize);
+        size_t start = end - b->chunkSize;
+        if(start >= b->ops)
+            break;
+        if(end > b->ops)
+            end = b->ops;
+        if(b->shared)
+            lockServerShared(server);
+        else
+            lockServer(server);
+        for(size_t i = start; i < end; i++) {
+            UA_DateTime begin = el->dateTime_nowMonotonic(el);
+            b->operation(server, b->context, i);
+            UA_DateTime duration = el->dateTime_nowMonotonic(el) - begin;
+            sum += duration;
+            if(duration > max)
+                max = duration;
+        }
+        if(b->shared)
+            unlockServerShared(server);
+        else
+            unlockServer(server);
+    }
+    UA_ServerWorkers_parallelOperation = parallel;
+
+    pthread_mutex_lock(&b->mutex);
+    b->opTimeSum += sum;
+    if(max > b->opTimeMax)
+        b->opTimeMax = max;
+    pthread_mutex_unlock(&b->mutex);
+}
+
+static void
+batchJobCallback(UA_Server *server, UA_ServerWorkerJob *job) {
+    UA_OperationBatch *b = ((UA_OperationBatchJob*)job)->batch;
+    processBatch(b);
+    pthread_mutex_lock(&b->mutex);
+    b->pending--;
+    pthread_cond_signal(&b->cond);
+    pthread_mutex_unlock(&b->mutex);
+}
+
+void
+UA_ServerWorkers_processOperations(UA_Server *server, UA_Session *session,
+                                   UA_ServerWorkerOperation operation,
+                                   void *context, size_t ops) {
+    UA_ServerWorkers *sw = &server->workers;
+
+    /* The operations run under the lock in the mode of the caller. The lock is
+     * released while the operations run. This is only possible if it is not
+     * held further up the stack (e.g. by a user callback). Otherwise, and if
+     * there are no workers, execute the operations sequentially. */
+    UA_Boolean shared = (UA_ServerWorkers_sharedLock == server);
+    UA_Boolean release;
+    if(shared) {
+        release = holdsServerLockSharedOnce(server);
+    } else {
+        UA_LOCK_ASSERT(&server->serviceMutex);
+        release = (server->lockDepth == 1);
+    }
+
+    /* Small chunks balance the load if some operations are slow. Every thread
+     * gets about four chunks. */
+    size_t threads = sw->threadsSize + 1;
+    size_t chunkSize = ops / (threads * 4);
+    if(chunkSize == 0)
+        chunkSize = 1;
+    size_t helpers = ((ops + chunkSize - 1) / chunkSize) - 1;
+    if(helpers > sw->threadsSize)
+        helpers = sw->threadsSize;
+
+    UA_OperationBatchJob *jobs = NULL;
+    if(release && helpers > 0)
+        jobs = (UA_OperationBatchJob*)UA_calloc(helpers, sizeof(UA_OperationBatchJob));
+    if(!jobs) {
+        for(size_t i = 0; i < ops; i++)
+            operation(server, context, i);
+        return;
+    }
+
+    UA_OperationBatch b;
+    memset(&b, 0, sizeof(UA_OperationBatch));
+    b.server = server;
+    b.operation = operation;
+    b.context = context;
+    b.ops = ops;
+    b.chunkSize = chunkSize;
+    b.shared = shared;
+    pthread_mutex_init(&b.mutex, NULL);
+    pthread_cond_init(&b.cond, NULL);
+
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime begin = el->dateTime_nowMonotonic(el);
+
+    /* Release the server lock before the workers start. Also the shared lock.
+     * Otherwise the workers could wait for the shared lock behind a thread
+     * that waits for the exclusive lock, which in turn waits for this thread.
+     * The session is pinned so that it is not freed while the lock is
+     * released. The SecureChannel and the request/response memory are kept
+     * alive by the active service job of the channel (see
+     * deleteServerSecureChannel). */
+    UA_Server_pinSession(server, session);
+    if(shared)
+        unlockServerShared(server);
+    else
+        unlockServer(server);
+
+    /* Hand the jobs to the workers */
+    size_t dispatched = 0;
+    for(; dispatched < helpers; dispatched++) {
+        jobs[dispatched].job.callback = batchJobCallback;
+        jobs[dispatched].batch = &b;
+        pthread_mutex_lock(&b.mutex);
+        b.pending++;
+        pthread_mutex_unlock(&b.mutex);
+        if(UA_ServerWorkers_dispatch(sw, &jobs[dispatched].job) != UA_STATUSCODE_GOOD) {
+            pthread_mutex_lock(&b.mutex);
+            b.pending--;
+            pthread_mutex_unlock(&b.mutex);
+            break;
+        }
+    }
+
+    /* Work on the operations in this thread as well */
+    processBatch(&b);
+
+    /* All operations are claimed. Take back the jobs that no worker has
+     * started. The workers might all be busy, e.g. with other requests that
+     * wait for their own batches. Then wait for the started jobs. */
+    size_t helped = dispatched;
+    for(size_t i = 0; i < dispatched; i++) {
+        if(!UA_ServerWorkers_cancel(sw, &jobs[i].job))
+            continue;
+        helped--;
+        pthread_mutex_lock(&b.mutex);
+        b.pending--;
+        pthread_mutex_unlock(&b.mutex);
+    }
+    pthread_mutex_lock(&b.mutex);
+    while(b.pending > 0)
+        pthread_cond_wait(&b.cond, &b.mutex);
+    pthread_mutex_unlock(&b.mutex);
+
+    if(shared)
+        lockServerShared(server);
+    else
+        lockServer(server);
+    UA_Server_unpinSession(server, session);
+
+    UA_DateTime end = el->dateTime_nowMonotonic(el);
+    UA_LOG_DEBUG_SESSION(server->config.logging, session,
+                         "Executed %lu operations in parallel on %lu threads "
+                         "in %.3f ms (per operation: avg %.3f ms, max %.3f ms)",
+                         (unsigned long)ops, (unsigned long)(helped + 1),
+                         (double)(end - begin) / UA_DATETIME_MSEC,
+                         ((double)b.opTimeSum / (double)ops) / UA_DATETIME_MSEC,
+                         (double)b.opTimeMax / UA_DATETIME_MSEC);
+
+    pthread_cond_destroy(&b.cond);
+    pthread_mutex_destroy(&b.mutex);
+    UA_free(jobs);
+}
+
+#endif /* UA_HAVE_SERVER_WORKERS */
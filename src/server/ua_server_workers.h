@@ -0,0 +1,94 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef UA_SERVER_WORKERS_H_
+#define UA_SERVER_WORKERS_H_
+
+#include <open62541/server.h>
+
+#include "open62541_queue.h"
+#include "ua_session.h"
+
+_UA_BEGIN_DECLS
+
+/* The worker threads are implemented with pthreads. So they are available only
+ * with multithreading on POSIX. */
+#if UA_MULTITHREADING >= 100 && defined(UA_ARCHITECTURE_POSIX)
+#define UA_HAVE_SERVER_WORKERS 1
+
+struct UA_ServerWorkerJob;
+typedef struct UA_ServerWorkerJob UA_ServerWorkerJob;
+
+typedef void (*UA_ServerWorkerCallback)(UA_Server *server, UA_ServerWorkerJob *job);
+
+/* The job memory is owned by the caller. It must remain valid until the
+ * callback was executed. The callback runs in a worker thread without holding
+ * any lock. */
+struct UA_ServerWorkerJob {
+    SIMPLEQ_ENTRY(UA_ServerWorkerJob) next;
+    UA_ServerWorkerCallback callback;
+};
+
+typedef struct {
+    UA_Server *server;
+    pthread_mutex_t mutex; /* Protects the job queue and the running flag */
+    pthread_cond_t cond;   /* Signals new jobs and the shutdown */
+    SIMPLEQ_HEAD(, UA_ServerWorkerJob) jobs;
+    pthread_t *threads;
+    size_t threadsSize;
+    UA_Boolean running;
+} UA_ServerWorkers;
+
+void UA_ServerWorkers_init(UA_ServerWorkers *sw);
+void UA_ServerWorkers_clear(UA_ServerWorkers *sw);
+
+/* Start config->serviceWorkers threads. Does nothing if the number is zero. */
+UA_StatusCode
+UA_ServerWorkers_start(UA_ServerWorkers *sw, UA_Server *server);
+
+/* Process the remaining jobs and join the threads. Must not be called with the
+ * server lock held, as the remaining jobs might need it. */
+void UA_ServerWorkers_stop(UA_ServerWorkers *sw);
+
+/* Hand the job to a worker thread. Returns an error if the workers are not
+ * running. Then the caller has to process the job itself. */
+UA_StatusCode
+UA_ServerWorkers_dispatch(UA_ServerWorkers *sw, UA_ServerWorkerJob *job);
+
+/* Remove the job from the queue if no worker has taken it yet. Returns
+ * true if the job was removed. Then the callback is never executed. */
+UA_Boolean
+UA_ServerWorkers_cancel(UA_ServerWorkers *sw, UA_ServerWorkerJob *job);
+
+/* Set in the threads that execute the operations of a parallel batch. Then
+ * user callbacks that can be slow (DataSource read and method callbacks) are
+ * called without holding the exclusive server lock. */
+extern UA_THREAD_LOCAL UA_Boolean UA_ServerWorkers_parallelOperation;
+
+/* The server whose lock the thread holds in shared mode (see
+ * lockServerShared). Remains set while the lock is upgraded. */
+extern UA_THREAD_LOCAL UA_Server *UA_ServerWorkers_sharedLock;
+
+typedef void (*UA_ServerWorkerOperation)(UA_Server *server, void *context,
+                                         size_t index);
+
+/* Execute the operations with index [0, ops) in chunks. The workers and the
+ * calling thread claim the chunks in parallel. Must be called with the server
+ * lock held, either exclusive or shared (see lockServerShared). The lock is
+ * released while the operations run. Each thread takes the lock in the same
+ * mode for every chunk it executes. The session is pinned meanwhile. It might
+ * get removed (but not freed) before the operations are done. If the lock is
+ * held more than once (e.g. by a user callback further up the stack) or if
+ * there are no workers, the operations are executed sequentially in the
+ * calling thread without releasing the lock. */
+void
+UA_ServerWorkers_processOperations(UA_Server *server, UA_Session *session,
+                                   UA_ServerWorkerOperation operation,
+                                   void *context, size_t ops);
+
+#endif /* UA_MULTITHREADING >= 100 && UA_ARCHITECTURE_POSIX */
+
+_UA_END_DECLS
+
+#endif /* UA_SERVER_WORKERS_H_ */
@@ -242,8 +242,10 @@ processServiceInternal(UA_Server *server, UA_SecureChannel *channel, UA_Session
                                "Service %" PRIu32 " refused on a non-activated session",
                                sd->requestType->binaryEncodingId.identifier.numeric);
 #endif
+        lockConcurrentRead(server);
         UA_Server_removeSessionByToken(server, &session->authenticationToken,
                                        UA_SHUTDOWNREASON_ABORT);
+        unlockConcurrentRead(server);
         rh->serviceResult = UA_STATUSCODE_BADSESSIONNOTACTIVATED;
         return false;
     }
@@ -260,6 +262,14 @@ processServiceInternal(UA_Server *server, UA_SecureChannel *channel, UA_Session
         rh->serviceResult = Service_Publish(server, session, &request->publishRequest, requestId);
         return (rh->serviceResult == UA_STATUSCODE_GOOD);
     }
+
+    /* The republish response copies the encoded NotificationMessage */
+    if(sd->requestType == &UA_TYPES[UA_TYPES_REPUBLISHREQUEST]) {
+        rh->serviceResult = Service_RepublishEncoded(server, session,
+                                                     &request->republishRequest,
+                                                     requestId);
+        return (rh->serviceResult == UA_STATUSCODE_GOOD);
+    }
 #endif
 
     /* An async call request might not be answered immediately */
@@ -281,7 +291,7 @@ UA_Boolean
 UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
                          UA_UInt32 requestId, UA_ServiceDescription *sd,
                          const UA_Request *request, UA_Response *response) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_READ(server);
 
     /* Set the authenticationToken from the create session request to help
      * fuzzing cover more lines */
@@ -290,8 +300,9 @@ UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
         &request->requestHeader.authenticationToken;
     if(!UA_NodeId_isNull(authenticationToken) &&
        !UA_NodeId_isNull(&unsafe_fuzz_authenticationToken)) {
-        UA_NodeId_clear(authenticationToken);
-        UA_NodeId_copy(&unsafe_fuzz_authenticationToken, authenticationToken);
+        /* The request is decoded into an arena and not cleaned up
+         * individually. So a shallow copy is sufficient. */
+        *authenticationToken = unsafe_fuzz_authenticationToken;
     }
 #endif
 
@@ -305,6 +316,14 @@ UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
     /* The session can be NULL if not required */
     response->responseHeader.serviceResult = UA_STATUSCODE_GOOD;
 
+    /* Under the shared lock, the session might be removed while the lock is
+     * upgraded. Pin the session so that it is not freed meanwhile. */
+#ifdef UA_HAVE_SERVER_WORKERS
+    UA_Boolean pinned = (session && UA_ServerWorkers_sharedLock == server);
+    if(pinned)
+        UA_Server_pinSession(server, session);
+#endif
+
     /* Process the service */
     UA_Boolean async =
         processServiceInternal(server, channel, session, requestId, sd, request, response);
@@ -325,5 +344,10 @@ UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
     }
 #endif
 
+#ifdef UA_HAVE_SERVER_WORKERS
+    if(pinned)
+        UA_Server_unpinSession(server, session);
+#endif
+
     return async;
 }
@@ -210,6 +210,13 @@ void Service_Republish(UA_Server *server, UA_Session *session,
                        const UA_RepublishRequest *request,
                        UA_RepublishResponse *response);
 
+/* Special service for the binary protocol. The response is sent with the
+ * encoded NotificationMessage from the retransmission queue. Do not answer if
+ * StatusCode == Good. */
+UA_StatusCode
+Service_RepublishEncoded(UA_Server *server, UA_Session *session,
+                         const UA_RepublishRequest *request, UA_UInt32 requestId);
+
 void Service_DeleteSubscriptions(UA_Server *server, UA_Session *session,
                                  const UA_DeleteSubscriptionsRequest *request,
                                  UA_DeleteSubscriptionsResponse *response);
@@ -74,7 +74,7 @@ attributeId2AttributeMask(UA_AttributeId id) {
 static UA_UInt32
 getUserWriteMask(UA_Server *server, const UA_Session *session,
                  const UA_NodeHead *head) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_READ(server);
     if(session == &server->adminSession)
         return 0xFFFFFFFF; /* the local admin user has all rights */
     return head->writeMask & server->config.accessControl.
@@ -87,7 +87,7 @@ getUserWriteMask(UA_Server *server, const UA_Session *session,
 static UA_Byte
 getUserAccessLevel(UA_Server *server, const UA_Session *session,
                    const UA_VariableNode *node) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_READ(server);
     if(session == &server->adminSession)
         return 0xFF; /* the local admin user has all rights */
     return node->accessLevel & server->config.accessControl.
@@ -100,7 +100,7 @@ getUserAccessLevel(UA_Server *server, const UA_Session *session,
 static UA_Boolean
 getUserExecutable(UA_Server *server, const UA_Session *session,
                   const UA_MethodNode *node) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_READ(server);
     if(session == &server->adminSession)
         return true; /* the local admin user has all rights */
     return node->executable & server->config.accessControl.
@@ -141,14 +141,16 @@ static UA_StatusCode
 readValueAttributeFromNode(UA_Server *server, UA_Session *session,
                            const UA_VariableNode *vn, UA_DataValue *v,
                            UA_NumericRange *rangeptr) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_READ(server);
     /* Update the value by the user callback */
     if(vn->value.data.callback.onRead) {
+        lockConcurrentRead(server);
         vn->value.data.callback.onRead(server,
                                        session ? &session->sessionId : NULL,
                                        session ? session->context : NULL,
                                        &vn->head.nodeId, vn->head.context, rangeptr,
                                        &vn->value.data.value);
+        unlockConcurrentRead(server);
         vn = (const UA_VariableNode*)
             UA_NODESTORE_GET_SELECTIVE(server, &vn->head.nodeId,
                                        UA_NODEATTRIBUTESMASK_VALUE,
@@ -179,19 +181,39 @@ readValueAttributeFromDataSource(UA_Server *server, UA_Session *session,
                                  const UA_VariableNode *vn, UA_DataValue *v,
                                  UA_TimestampsToReturn timestamps,
                                  UA_NumericRange *rangeptr) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_READ(server);
     if(!vn->value.dataSource.read)
         return UA_STATUSCODE_BADINTERNALERROR;
     UA_Boolean sourceTimeStamp = (timestamps == UA_TIMESTAMPSTORETURN_SOURCE ||
                                   timestamps == UA_TIMESTAMPSTORETURN_BOTH);
     UA_DataValue v2;
     UA_DataValue_init(&v2);
+    /* Parallel operations call the (potentially slow) read without the
+     * exclusive lock. The node remains pinned in the nodestore until it is
+     * released. A parallel operation under the shared lock keeps it, as it
+     * does not block other readers. Otherwise, Read requests under the shared
+     * lock take the exclusive lock, as the DataSources are not required to be
+     * thread-safe without parallel operations. */
+#ifdef UA_HAVE_SERVER_WORKERS
+    UA_Boolean parallel = UA_ServerWorkers_parallelOperation;
+    UA_Boolean exclusive = (UA_ServerWorkers_sharedLock != server);
+    if(parallel && exclusive)
+        unlockServer(server);
+    if(!parallel)
+        lockConcurrentRead(server);
+#endif
     UA_StatusCode retval = vn->value.dataSource.
         read(server,
              session ? &session->sessionId : NULL,
              session ? session->context : NULL,
              &vn->head.nodeId, vn->head.context,
              sourceTimeStamp, rangeptr, &v2);
+#ifdef UA_HAVE_SERVER_WORKERS
+    if(!parallel)
+        unlockConcurrentRead(server);
+    if(parallel && exclusive)
+        lockServer(server);
+#endif
     if(v2.hasValue && v2.value.storageType == UA_VARIANT_DATA_NODELETE) {
         retval = UA_DataValue_copy(&v2, v);
         UA_DataValue_clear(&v2);
@@ -229,18 +251,24 @@ readValueAttributeComplete(UA_Server *server, UA_Session *session,
             //TODO change old structure to value backend
             break;
         case UA_VALUEBACKENDTYPE_EXTERNAL:
+            /* The external value is user memory that is updated under the
+             * server lock */
+            lockConcurrentRead(server);
             if(vn->valueBackend.backend.external.callback.notificationRead) {
                 retval = vn->valueBackend.backend.external.callback.
                     notificationRead(server,
                                      session ? &session->sessionId : NULL,
                                      session ? session->context : NULL,
                                      &vn->head.nodeId, vn->head.context, rangeptr);
-                if(retval != UA_STATUSCODE_GOOD)
+                if(retval != UA_STATUSCODE_GOOD) {
+                    unlockConcurrentRead(server);
                     break;
+                }
             }
 
             /* Check that a value is available */
             if(!vn->valueBackend.backend.external.value) {
+                unlockConcurrentRead(server);
                 retval = UA_STATUSCODE_BADNOTREADABLE;
                 break;
             }
@@ -251,6 +279,7 @@ readValueAttributeComplete(UA_Server *server, UA_Session *session,
                     *vn->valueBackend.backend.external.value, v, *rangeptr);
             else
                 retval = UA_DataValue_copy(*vn->valueBackend.backend.external.value, v);
+            unlockConcurrentRead(server);
             break;
         case UA_VALUEBACKENDTYPE_NONE:
             /* Read the value */
@@ -405,13 +434,17 @@ ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
                                           &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
         break;
     case UA_ATTRIBUTEID_DISPLAYNAME: {
+        lockConcurrentRead(server); /* The session locales can change */
         UA_LocalizedText lt = UA_Session_getNodeDisplayName(session, &node->head);
+        unlockConcurrentRead(server);
         retval = UA_Variant_setScalarCopy(&v->value, &lt,
                                           &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
         break;
     }
     case UA_ATTRIBUTEID_DESCRIPTION: {
+        lockConcurrentRead(server); /* The session locales can change */
         UA_LocalizedText lt = UA_Session_getNodeDescription(session, &node->head);
+        unlockConcurrentRead(server);
         retval = UA_Variant_setScalarCopy(&v->value, &lt,
                                           &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
         break;
@@ -604,12 +637,25 @@ ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
 void
 Operation_Read(UA_Server *server, UA_Session *session, UA_TimestampsToReturn *ttr,
                const UA_ReadValueId *rvi, UA_DataValue *dv) {
-    /* Get the node (with only the selected attribute if the NodeStore supports that) */
-    const UA_Node *node =
-        UA_NODESTORE_GET_SELECTIVE(server, &rvi->nodeId,
-                                   attributeId2AttributeMask((UA_AttributeId)rvi->attributeId),
-                                   UA_REFERENCETYPESET_NONE,
-                                   UA_BROWSEDIRECTION_INVALID);
+    /* Get the node (with only the selected attribute if the NodeStore supports
+     * that). Registered nodes are accessed directly. */
+    const UA_Node *node = NULL;
+    UA_RegisteredNode *rn = NULL;
+    if(UA_RegisteredNode_isHandle(&rvi->nodeId)) {
+        /* The handle table and the cached node pointer are session state
+         * that is edited under the server lock */
+        lockConcurrentRead(server);
+        rn = UA_Session_getRegisteredNode(session, &rvi->nodeId);
+        if(rn)
+            node = UA_RegisteredNode_getNode(server, rn);
+        unlockConcurrentRead(server);
+    }
+    if(!rn) {
+        node = UA_NODESTORE_GET_SELECTIVE(server, &rvi->nodeId,
+                                          attributeId2AttributeMask((UA_AttributeId)rvi->attributeId),
+                                          UA_REFERENCETYPESET_NONE,
+                                          UA_BROWSEDIRECTION_INVALID);
+    }
     if(!node) {
         dv->hasStatus = true;
         dv->status = UA_STATUSCODE_BADNODEIDUNKNOWN;
@@ -625,7 +671,7 @@ void
 Service_Read(UA_Server *server, UA_Session *session,
              const UA_ReadRequest *request, UA_ReadResponse *response) {
     UA_LOG_DEBUG_SESSION(server->config.logging, session, "Processing ReadRequest");
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_READ(server);
 
     /* Check if the timestampstoreturn is valid */
     if(request->timestampsToReturn > UA_TIMESTAMPSTORETURN_NEITHER) {
@@ -646,10 +692,8 @@ Service_Read(UA_Server *server, UA_Session *session,
         return;
     }
 
-    UA_LOCK_ASSERT(&server->serviceMutex);
-
     response->responseHeader.serviceResult =
-        UA_Server_processServiceOperations(server, session,
+        UA_Server_processServiceOperationsParallel(server, session,
                                            (UA_ServiceOperation)Operation_Read,
                                            &request->timestampsToReturn,
                                            &request->nodesToReadSize,
@@ -1783,6 +1827,20 @@ void
 Operation_Write(UA_Server *server, UA_Session *session, void *context,
                 const UA_WriteValue *wv, UA_StatusCode *result) {
     UA_assert(session != NULL);
+
+    /* Registered nodes are accessed directly */
+    UA_RegisteredNode *rn = UA_Session_getRegisteredNode(session, &wv->nodeId);
+    if(rn) {
+        UA_Node *node = UA_RegisteredNode_getEditNode(server, rn);
+        if(!node) {
+            *result = UA_STATUSCODE_BADNODEIDUNKNOWN;
+            return;
+        }
+        *result = copyAttributeIntoNode(server, session, node, wv);
+        UA_NODESTORE_RELEASE(server, node);
+        return;
+    }
+
     *result = UA_Server_editNode(server, session, &wv->nodeId, wv->attributeId,
                                  UA_REFERENCETYPESET_NONE, UA_BROWSEDIRECTION_INVALID,
                                  (UA_EditNodeCallback)copyAttributeIntoNode,
@@ -386,10 +386,15 @@ callWithMethodAndObject(UA_Server *server, UA_Session *session,
     /* Release the output arguments node */
     UA_NODESTORE_RELEASE(server, (const UA_Node*)outputArguments);
 
-    /* Call the method. If this is an async method, unlock the server lock for
-     * the duration of the (long-running) call. */
+    /* Call the method. If this is an async method (or a parallel operation
+     * executed by a service worker), unlock the server lock for the duration of
+     * the (long-running) call. */
 #if UA_MULTITHREADING >= 100
-    if(method->async)
+    UA_Boolean unlock = method->async;
+# ifdef UA_HAVE_SERVER_WORKERS
+    unlock |= UA_ServerWorkers_parallelOperation;
+# endif
+    if(unlock)
         unlockServer(server);
 #endif
     result->statusCode = method->method(server, &session->sessionId, session->context,
@@ -398,7 +403,7 @@ callWithMethodAndObject(UA_Server *server, UA_Session *session,
                                         request->inputArgumentsSize, mutableInputArgs,
                                         result->outputArgumentsSize, result->outputArguments);
 #if UA_MULTITHREADING >= 100
-    if(method->async)
+    if(unlock)
         lockServer(server);
 #endif
 
@@ -412,6 +417,12 @@ Operation_CallMethodAsync(UA_Server *server, UA_Session *session, UA_UInt32 requ
                           UA_UInt32 requestHandle, size_t opIndex,
                           UA_CallMethodRequest *opRequest, UA_CallMethodResult *opResult,
                           UA_AsyncResponse **ar) {
+    /* Resolve registered NodeIds */
+    UA_CallMethodRequest resolved = *opRequest;
+    resolved.objectId = *UA_Session_resolveNodeId(session, &opRequest->objectId);
+    resolved.methodId = *UA_Session_resolveNodeId(session, &opRequest->methodId);
+    opRequest = &resolved;
+
     /* Get the method node. We only need the nodeClass and executable attribute.
      * Take all forward hasProperty references to get the input/output argument
      * definition variables. */
@@ -509,6 +520,12 @@ Service_CallAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
 static void
 Operation_CallMethod(UA_Server *server, UA_Session *session, void *context,
                      const UA_CallMethodRequest *request, UA_CallMethodResult *result) {
+    /* Resolve registered NodeIds */
+    UA_CallMethodRequest resolved = *request;
+    resolved.objectId = *UA_Session_resolveNodeId(session, &request->objectId);
+    resolved.methodId = *UA_Session_resolveNodeId(session, &request->methodId);
+    request = &resolved;
+
     /* Get the method node. We only need the nodeClass and executable attribute.
      * Take all forward hasProperty references to get the input/output argument
      * definition variables. */
@@ -559,7 +576,7 @@ void Service_Call(UA_Server *server, UA_Session *session,
     }
 
     response->responseHeader.serviceResult =
-        UA_Server_processServiceOperations(server, session,
+        UA_Server_processServiceOperationsParallel(server, session,
                   (UA_ServiceOperation)Operation_CallMethod, NULL,
                   &request->methodsToCallSize, &UA_TYPES[UA_TYPES_CALLMETHODREQUEST],
                   &response->resultsSize, &UA_TYPES[UA_TYPES_CALLMETHODRESULT]);
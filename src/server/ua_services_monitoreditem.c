@@ -355,6 +355,12 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session,
                               UA_MonitoredItemCreateResult *result) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
+    /* Resolve a registered NodeId. The MonitoredItem stores the original. */
+    UA_MonitoredItemCreateRequest resolved = *request;
+    resolved.itemToMonitor.nodeId =
+        *UA_Session_resolveNodeId(session, &request->itemToMonitor.nodeId);
+    request = &resolved;
+
     /* Check available capacity */
     if(!cmc->localMon &&
        (((server->config.maxMonitoredItems != 0) &&
@@ -470,6 +476,11 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session,
         return;
     }
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    /* Compile the EventFilter */
+    UA_MonitoredItem_compileEventFilter(newMon);
+#endif
+
     /* Initialize the value status so the first sample always passes the filter */
     newMon->lastValue.hasStatus = true;
     newMon->lastValue.status = ~(UA_StatusCode)0;
@@ -731,6 +742,9 @@ Operation_ModifyMonitoredItem(UA_Server *server, UA_Session *session, UA_Subscri
     /* Move over the new settings */
     UA_MonitoringParameters_clear(&mon->parameters);
     mon->parameters = params;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    UA_MonitoredItem_compileEventFilter(mon);
+#endif
 
     /* Re-register the callback if necessary */
     if(oldSamplingInterval != mon->parameters.samplingInterval) {
@@ -1926,6 +1926,9 @@ deleteNodeSet(UA_Server *server, UA_Session *session,
         UA_NODESTORE_RELEASE(server, member);
         if(removeTargetRefs)
             removeIncomingReferences(server, session, &member->head);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+        UA_EventIndex_nodeChanged(server, &refTree->targets[i-1].nodeId);
+#endif
         UA_NODESTORE_REMOVE(server, &member->head.nodeId);
     }
 }
@@ -2168,6 +2171,11 @@ Operation_addReference(UA_Server *server, UA_Session *session, void *context,
     }
 
  cleanup:
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    if(*retval == UA_STATUSCODE_GOOD)
+        UA_EventIndex_referenceChanged(server, refTypeIndex, &item->sourceNodeId,
+                                       &item->targetNodeId.nodeId);
+#endif
     if(targetNode)
         UA_NODESTORE_RELEASE(server, targetNode);
     UA_NODESTORE_RELEASE(server, sourceNode);
@@ -2271,6 +2279,11 @@ Operation_deleteReference(UA_Server *server, UA_Session *session, void *context,
     if(*retval != UA_STATUSCODE_GOOD)
         return;
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    UA_EventIndex_referenceChanged(server, refTypeIndex, &item->sourceNodeId,
+                                   &item->targetNodeId.nodeId);
+#endif
+
     if(!item->deleteBidirectional || item->targetNodeId.serverIndex != 0)
         return;
 
@@ -16,10 +16,111 @@
 #include "ua_server_internal.h"
 #include "ua_services.h"
 
+/**************/
+/* Hash Index */
+/**************/
+
+#define UA_SESSIONINDEX_MINSIZE 16
+
+static void
+sessionIndexInsert(UA_Server *server, session_list_entry *entry) {
+    UA_UInt32 mask = server->sessionBuckets - 1;
+    session_list_entry **tb = &server->sessionsByToken[entry->tokenHash & mask];
+    entry->tokenNext = *tb;
+    *tb = entry;
+    session_list_entry **ib = &server->sessionsById[entry->idHash & mask];
+    entry->idNext = *ib;
+    *ib = entry;
+}
+
+static void
+sessionIndexRemove(UA_Server *server, session_list_entry *entry) {
+    UA_UInt32 mask = server->sessionBuckets - 1;
+    session_list_entry **e = &server->sessionsByToken[entry->tokenHash & mask];
+    while(*e != entry)
+        e = &(*e)->tokenNext;
+    *e = entry->tokenNext;
+    e = &server->sessionsById[entry->idHash & mask];
+    while(*e != entry)
+        e = &(*e)->idNext;
+    *e = entry->idNext;
+}
+
+/* Ensure there is at least one bucket per session after adding one more */
+static UA_StatusCode
+sessionIndexReserve(UA_Server *server) {
+    if(server->sessionCount < server->sessionBuckets)
+        return UA_STATUSCODE_GOOD;
+
+    UA_UInt32 size = (server->sessionBuckets == 0) ?
+        UA_SESSIONINDEX_MINSIZE : server->sessionBuckets * 2;
+    session_list_entry **byToken = (session_list_entry**)
+        UA_calloc(size, sizeof(session_list_entry*));
+    session_list_entry **byId = (session_list_entry**)
+        UA_calloc(size, sizeof(session_list_entry*));
+    if(!byToken || !byId) {
+        UA_free(byToken);
+        UA_free(byId);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    UA_free(server->sessionsByToken);
+    UA_free(server->sessionsById);
+    server->sessionsByToken = byToken;
+    server->sessionsById = byId;
+    server->sessionBuckets = size;
+
+    /* Rehash from the list of sessions */
+    session_list_entry *entry;
+    LIST_FOREACH(entry, &server->sessions, pointers) {
+        sessionIndexInsert(server, entry);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+session_list_entry *
+lookupSessionByToken(UA_Server *server, const UA_NodeId *token) {
+    if(server->sessionBuckets == 0)
+        return NULL;
+    UA_UInt32 hash = UA_NodeId_hash(token);
+    session_list_entry *entry =
+        server->sessionsByToken[hash & (server->sessionBuckets - 1)];
+    for(; entry; entry = entry->tokenNext) {
+        if(entry->tokenHash == hash &&
+           UA_NodeId_equal(&entry->session.authenticationToken, token))
+            return entry;
+    }
+    return NULL;
+}
+
+session_list_entry *
+lookupSessionById(UA_Server *server, const UA_NodeId *sessionId) {
+    if(server->sessionBuckets == 0)
+        return NULL;
+    UA_UInt32 hash = UA_NodeId_hash(sessionId);
+    session_list_entry *entry =
+        server->sessionsById[hash & (server->sessionBuckets - 1)];
+    for(; entry; entry = entry->idNext) {
+        if(entry->idHash == hash &&
+           UA_NodeId_equal(&entry->session.sessionId, sessionId))
+            return entry;
+    }
+    return NULL;
+}
+
 /* Delayed callback to free the session memory */
 static void
 removeSessionCallback(UA_Server *server, session_list_entry *entry) {
     lockServer(server);
+#if UA_MULTITHREADING >= 100
+    /* Still used by parallel operations. Freed when the last pin is released
+     * in UA_Server_unpinSession. */
+    if(entry->session.pinned > 0) {
+        entry->session.freePending = true;
+        unlockServer(server);
+        return;
+    }
+#endif
     UA_Session_clear(&entry->session, server);
     unlockServer(server);
     UA_free(entry);
@@ -65,6 +166,7 @@ UA_Server_removeSession(UA_Server *server, session_list_entry *sentry,
     /* Detach the session from the session manager and make the capacity
      * available */
     LIST_REMOVE(sentry, pointers);
+    sessionIndexRemove(server, sentry);
     server->sessionCount--;
 
     switch(shutdownReason) {
@@ -97,18 +199,42 @@ UA_Server_removeSession(UA_Server *server, session_list_entry *sentry,
     el->addDelayedCallback(el, &sentry->cleanupCallback);
 }
 
+#if UA_MULTITHREADING >= 100
+void
+UA_Server_pinSession(UA_Server *server, UA_Session *session) {
+    UA_LOCK_ASSERT_READ(server);
+    UA_atomic_addSize(&session->pinned, 1);
+}
+
+void
+UA_Server_unpinSession(UA_Server *server, UA_Session *session) {
+    UA_LOCK_ASSERT_READ(server);
+    UA_assert(session->pinned > 0);
+    /* freePending is set under the exclusive lock. So it cannot change while
+     * the lock is held in shared mode. */
+    if(UA_atomic_subSize(&session->pinned, 1) > 0 || !session->freePending)
+        return;
+
+    /* The session was removed while it was pinned. Only sessions of the
+     * session manager can be removed. So the session is embedded in a list
+     * entry whose cleanup callback is already set up. */
+    session->freePending = false;
+    session_list_entry *sentry = (session_list_entry*)
+        ((uintptr_t)session - offsetof(session_list_entry, session));
+    UA_EventLoop *el = server->config.eventLoop;
+    el->addDelayedCallback(el, &sentry->cleanupCallback);
+}
+#endif
+
 UA_StatusCode
 UA_Server_removeSessionByToken(UA_Server *server, const UA_NodeId *token,
                                UA_ShutdownReason shutdownReason) {
     UA_LOCK_ASSERT(&server->serviceMutex);
-    session_list_entry *entry;
-    LIST_FOREACH(entry, &server->sessions, pointers) {
-        if(UA_NodeId_equal(&entry->session.authenticationToken, token)) {
-            UA_Server_removeSession(server, entry, shutdownReason);
-            return UA_STATUSCODE_GOOD;
-        }
-    }
-    return UA_STATUSCODE_BADSESSIONIDINVALID;
+    session_list_entry *entry = lookupSessionByToken(server, token);
+    if(!entry)
+        return UA_STATUSCODE_BADSESSIONIDINVALID;
+    UA_Server_removeSession(server, entry, shutdownReason);
+    return UA_STATUSCODE_GOOD;
 }
 
 void
@@ -133,53 +259,43 @@ UA_Session *
 getSessionByToken(UA_Server *server, const UA_NodeId *token) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    session_list_entry *current = NULL;
-    LIST_FOREACH(current, &server->sessions, pointers) {
-        /* Token does not match */
-        if(!UA_NodeId_equal(&current->session.authenticationToken, token))
-            continue;
-
-        /* Session has timed out */
-        UA_EventLoop *el = server->config.eventLoop;
-        UA_DateTime now = el->dateTime_nowMonotonic(el);
-        if(now > current->session.validTill) {
-            UA_LOG_INFO_SESSION(server->config.logging, &current->session,
-                                "Client tries to use a session that has timed out");
-            return NULL;
-        }
+    session_list_entry *entry = lookupSessionByToken(server, token);
+    if(!entry)
+        return NULL;
 
-        return &current->session;
+    /* Session has timed out */
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    if(now > entry->session.validTill) {
+        UA_LOG_INFO_SESSION(server->config.logging, &entry->session,
+                            "Client tries to use a session that has timed out");
+        return NULL;
     }
 
-    return NULL;
+    return &entry->session;
 }
 
 UA_Session *
 getSessionById(UA_Server *server, const UA_NodeId *sessionId) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    session_list_entry *current = NULL;
-    LIST_FOREACH(current, &server->sessions, pointers) {
-        /* Token does not match */
-        if(!UA_NodeId_equal(&current->session.sessionId, sessionId))
-            continue;
-
-        /* Session has timed out */
-        UA_EventLoop *el = server->config.eventLoop;
-        UA_DateTime now = el->dateTime_nowMonotonic(el);
-        if(now > current->session.validTill) {
-            UA_LOG_INFO_SESSION(server->config.logging, &current->session,
-                                "Client tries to use a session that has timed out");
-            return NULL;
-        }
-
-        return &current->session;
+    session_list_entry *entry = lookupSessionById(server, sessionId);
+    if(!entry) {
+        if(UA_NodeId_equal(sessionId, &server->adminSession.sessionId))
+            return &server->adminSession;
+        return NULL;
     }
 
-    if(UA_NodeId_equal(sessionId, &server->adminSession.sessionId))
-        return &server->adminSession;
+    /* Session has timed out */
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    if(now > entry->session.validTill) {
+        UA_LOG_INFO_SESSION(server->config.logging, &entry->session,
+                            "Client tries to use a session that has timed out");
+        return NULL;
+    }
 
-    return NULL;
+    return &entry->session;
 }
 
 static UA_StatusCode
@@ -235,6 +351,11 @@ UA_Server_createSession(UA_Server *server, UA_SecureChannel *channel,
         return UA_STATUSCODE_BADTOOMANYSESSIONS;
     }
 
+    /* Make room in the hash index */
+    UA_StatusCode res = sessionIndexReserve(server);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
     session_list_entry *newentry = (session_list_entry*)
         UA_malloc(sizeof(session_list_entry));
     if(!newentry)
@@ -242,7 +363,15 @@ UA_Server_createSession(UA_Server *server, UA_SecureChannel *channel,
 
     /* Initialize the Session */
     UA_Session_init(&newentry->session);
+#ifdef UA_ENABLE_DIAGNOSTICS
+    res = createDiagnosticsSessionId(&newentry->session.sessionId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(newentry);
+        return res;
+    }
+#else
     newentry->session.sessionId = UA_NODEID_GUID(1, UA_Guid_random());
+#endif
     newentry->session.authenticationToken = UA_NODEID_GUID(1, UA_Guid_random());
 
     newentry->session.timeout = server->config.maxSessionTimeout;
@@ -260,7 +389,10 @@ UA_Server_createSession(UA_Server *server, UA_SecureChannel *channel,
     UA_Session_updateLifetime(&newentry->session, now, nowMonotonic);
 
     /* Add to the server */
+    newentry->tokenHash = UA_NodeId_hash(&newentry->session.authenticationToken);
+    newentry->idHash = UA_NodeId_hash(&newentry->session.sessionId);
     LIST_INSERT_HEAD(&server->sessions, newentry, pointers);
+    sessionIndexInsert(server, newentry);
     server->sessionCount++;
 
     *session = &newentry->session;
@@ -350,9 +482,10 @@ Service_CreateSession(UA_Server *server, UA_SecureChannel *channel,
 #endif
 
     /* Prepare the response */
-    response->sessionId = newSession->sessionId;
     response->revisedSessionTimeout = (UA_Double)newSession->timeout;
     response->authenticationToken = newSession->authenticationToken;
+    response->responseHeader.serviceResult |=
+        UA_NodeId_copy(&newSession->sessionId, &response->sessionId);
     response->responseHeader.serviceResult |=
         UA_ByteString_copy(&newSession->serverNonce, &response->serverNonce);
 
@@ -394,9 +527,6 @@ Service_CreateSession(UA_Server *server, UA_SecureChannel *channel,
     newSession->diagnostics.clientConnectionTime = el->dateTime_now(el);
     newSession->diagnostics.clientLastContactTime =
         newSession->diagnostics.clientConnectionTime;
-
-    /* Create the object in the information model */
-    createSessionObject(server, newSession);
 #endif
 
     UA_LOG_INFO_SESSION(server->config.logging, newSession, "Session created");
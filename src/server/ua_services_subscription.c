@@ -93,11 +93,6 @@ Service_CreateSubscription(UA_Server *server, UA_Session *session,
     /* Attach the Subscription to the session */
     UA_Session_attachSubscription(session, sub);
 
-    /* Create representation in the Session object */
-#ifdef UA_ENABLE_DIAGNOSTICS
-    createSubscriptionObject(server, session, sub);
-#endif
-
     /* Set the subscription state. This also registers the callback.
      * Note that also a disabled subscription publishes keepalives. */
     UA_SubscriptionState sState = (request->publishingEnabled) ?
@@ -378,20 +373,17 @@ Service_DeleteSubscriptions(UA_Server *server, UA_Session *session,
                   &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
 }
 
-void
-Service_Republish(UA_Server *server, UA_Session *session,
-                  const UA_RepublishRequest *request,
-                  UA_RepublishResponse *response) {
-    UA_LOG_DEBUG_SESSION(server->config.logging, session,
-                         "Processing RepublishRequest");
+/* Find the NotificationMessage in the retransmission queue */
+static UA_StatusCode
+getRepublishMessage(UA_Server *server, UA_Session *session,
+                    const UA_RepublishRequest *request,
+                    UA_NotificationMessageEntry **entry) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
     /* Get the subscription */
     UA_Subscription *sub = UA_Session_getSubscriptionById(session, request->subscriptionId);
-    if(!sub) {
-        response->responseHeader.serviceResult = UA_STATUSCODE_BADSUBSCRIPTIONIDINVALID;
-        return;
-    }
+    if(!sub)
+        return UA_STATUSCODE_BADSUBSCRIPTIONIDINVALID;
 
     /* Reset the lifetime counter */
     Subscription_resetLifetime(sub);
@@ -402,23 +394,63 @@ Service_Republish(UA_Server *server, UA_Session *session,
 #endif
 
     /* Find the notification in the retransmission queue  */
-    UA_NotificationMessageEntry *entry;
-    TAILQ_FOREACH(entry, &sub->retransmissionQueue, listEntry) {
-        if(entry->message.sequenceNumber == request->retransmitSequenceNumber)
+    UA_NotificationMessageEntry *e;
+    TAILQ_FOREACH(e, &sub->retransmissionQueue, listEntry) {
+        if(e->sequenceNumber == request->retransmitSequenceNumber)
             break;
     }
-    if(!entry) {
-        response->responseHeader.serviceResult = UA_STATUSCODE_BADMESSAGENOTAVAILABLE;
-        return;
-    }
-
-    response->responseHeader.serviceResult =
-        UA_NotificationMessage_copy(&entry->message, &response->notificationMessage);
+    if(!e)
+        return UA_STATUSCODE_BADMESSAGENOTAVAILABLE;
 
     /* Update the subscription statistics for the case where we return a message */
 #ifdef UA_ENABLE_DIAGNOSTICS
     sub->republishMessageCount++;
 #endif
+
+    *entry = e;
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+Service_Republish(UA_Server *server, UA_Session *session,
+                  const UA_RepublishRequest *request,
+                  UA_RepublishResponse *response) {
+    UA_LOG_DEBUG_SESSION(server->config.logging, session,
+                         "Processing RepublishRequest");
+
+    UA_NotificationMessageEntry *entry = NULL;
+    response->responseHeader.serviceResult =
+        getRepublishMessage(server, session, request, &entry);
+    if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+        return;
+
+    /* Decode the stored NotificationMessage */
+    response->responseHeader.serviceResult =
+        UA_decodeBinary(&entry->message, &response->notificationMessage,
+                        &UA_TYPES[UA_TYPES_NOTIFICATIONMESSAGE], NULL);
+}
+
+UA_StatusCode
+Service_RepublishEncoded(UA_Server *server, UA_Session *session,
+                         const UA_RepublishRequest *request,
+                         UA_UInt32 requestId) {
+    UA_LOG_DEBUG_SESSION(server->config.logging, session,
+                         "Processing RepublishRequest with RequestId %u", requestId);
+
+    UA_NotificationMessageEntry *entry = NULL;
+    UA_StatusCode res = getRepublishMessage(server, session, request, &entry);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Send the stored NotificationMessage as is */
+    UA_RepublishResponse response;
+    UA_RepublishResponse_init(&response);
+    response.responseHeader.requestHandle = request->requestHeader.requestHandle;
+    sendResponseWithNotificationMessage(server, session->channel, requestId,
+                                        (UA_Response*)&response,
+                                        &UA_TYPES[UA_TYPES_REPUBLISHRESPONSE],
+                                        &entry->message);
+    return UA_STATUSCODE_GOOD;
 }
 
 static UA_StatusCode
@@ -434,7 +466,7 @@ setTransferredSequenceNumbers(const UA_Subscription *sub, UA_TransferResult *res
     UA_NotificationMessageEntry *entry;
     size_t i = 0;
     TAILQ_FOREACH(entry, &sub->retransmissionQueue, listEntry) {
-        result->availableSequenceNumbers[i] = entry->message.sequenceNumber;
+        result->availableSequenceNumbers[i] = entry->sequenceNumber;
         i++;
     }
 
@@ -549,6 +581,10 @@ Operation_TransferSubscription(UA_Server *server, UA_Session *session,
     sub->dataChangeNotifications = 0;
     sub->eventNotifications = 0;
 
+    /* The free Notifications were moved over with the memcpy */
+    sub->freeNotifications = NULL;
+    sub->freeNotificationsSize = 0;
+
     TAILQ_INIT(&newSub->retransmissionQueue);
     UA_NotificationMessageEntry *nme, *nme_tmp;
     TAILQ_FOREACH_SAFE(nme, &sub->retransmissionQueue, listEntry, nme_tmp) {
@@ -784,7 +784,7 @@ browse(struct BrowseContext *bc) {
 
     /* Check AccessControl rights */
     if(bc->session != &bc->server->adminSession) {
-        UA_LOCK_ASSERT(&bc->server->serviceMutex);
+        UA_LOCK_ASSERT_READ(bc->server);
         if(!bc->server->config.accessControl.
            allowBrowseNode(bc->server, &bc->server->config.accessControl,
                            &bc->session->sessionId, bc->session->context,
@@ -832,6 +832,7 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     memset(&cp, 0, sizeof(ContinuationPoint));
     cp.maxReferences = *maxrefs;
     cp.browseDescription = *descr; /* Shallow copy. Deep-copy later if we persist the cp. */
+    cp.browseDescription.nodeId = *UA_Session_resolveNodeId(session, &descr->nodeId);
 
     /* How many references can we return at most? */
     if(cp.maxReferences == 0) {
@@ -893,11 +894,13 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     if(bc.done)
         return;
 
-    /* Persist the continuation point */
+    /* Persist the continuation point. This modifies the session. Take the
+     * exclusive lock if Browse runs under the shared lock. */
 
     ContinuationPoint *cp2 = NULL;
     UA_Guid *ident = NULL;
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    lockConcurrentRead(server);
 
     /* Enough space for the continuation point? */
     if(session->availableContinuationPoints == 0) {
@@ -942,9 +945,11 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     cp2->next = session->continuationPoints;
     session->continuationPoints = cp2;
     --session->availableContinuationPoints;
+    unlockConcurrentRead(server);
     return;
 
  cleanup:
+    unlockConcurrentRead(server);
     if(cp2) {
         ContinuationPoint_clear(cp2);
         UA_free(cp2);
@@ -957,7 +962,7 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
 void Service_Browse(UA_Server *server, UA_Session *session,
                     const UA_BrowseRequest *request, UA_BrowseResponse *response) {
     UA_LOG_DEBUG_SESSION(server->config.logging, session, "Processing BrowseRequest");
-    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_LOCK_ASSERT_READ(server);
 
     /* Test the number of operations in the request */
     if(server->config.maxNodesPerBrowse != 0 &&
@@ -1458,7 +1463,6 @@ void Service_RegisterNodes(UA_Server *server, UA_Session *session,
                          "Processing RegisterNodesRequest");
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    //TODO: hang the nodeids to the session if really needed
     if(request->nodesToRegisterSize == 0) {
         response->responseHeader.serviceResult = UA_STATUSCODE_BADNOTHINGTODO;
         return;
@@ -1471,11 +1475,37 @@ void Service_RegisterNodes(UA_Server *server, UA_Session *session,
         return;
     }
 
-    response->responseHeader.serviceResult =
-        UA_Array_copy(request->nodesToRegister, request->nodesToRegisterSize,
-                      (void**)&response->registeredNodeIds, &UA_TYPES[UA_TYPES_NODEID]);
-    if(response->responseHeader.serviceResult == UA_STATUSCODE_GOOD)
-        response->registeredNodeIdsSize = request->nodesToRegisterSize;
+    response->registeredNodeIds = (UA_NodeId*)
+        UA_Array_new(request->nodesToRegisterSize, &UA_TYPES[UA_TYPES_NODEID]);
+    if(!response->registeredNodeIds) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    response->registeredNodeIdsSize = request->nodesToRegisterSize;
+
+    /* Hand out handles that are bound to the session */
+    for(size_t i = 0; i < request->nodesToRegisterSize; i++) {
+        UA_StatusCode res =
+            UA_Session_registerNode(server, session, &request->nodesToRegister[i],
+                                    &response->registeredNodeIds[i]);
+        if(res == UA_STATUSCODE_GOOD)
+            continue;
+
+        /* Roll back the handles of this request. The client does not receive
+         * them and could never unregister them. */
+        for(size_t j = 0; j < i; j++) {
+            if(!UA_NodeId_equal(&request->nodesToRegister[j],
+                                &response->registeredNodeIds[j]))
+                UA_Session_unregisterNode(server, session,
+                                          &response->registeredNodeIds[j]);
+        }
+        UA_Array_delete(response->registeredNodeIds,
+                        response->registeredNodeIdsSize, &UA_TYPES[UA_TYPES_NODEID]);
+        response->registeredNodeIds = NULL;
+        response->registeredNodeIdsSize = 0;
+        response->responseHeader.serviceResult = res;
+        return;
+    }
 }
 
 void Service_UnregisterNodes(UA_Server *server, UA_Session *session,
@@ -1485,9 +1515,10 @@ void Service_UnregisterNodes(UA_Server *server, UA_Session *session,
                          "Processing UnRegisterNodesRequest");
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    //TODO: remove the nodeids from the session if really needed
-    if(request->nodesToUnregisterSize == 0)
+    if(request->nodesToUnregisterSize == 0) {
         response->responseHeader.serviceResult = UA_STATUSCODE_BADNOTHINGTODO;
+        return;
+    }
 
     /* Test the number of operations in the request */
     if(server->config.maxNodesPerRegisterNodes != 0 &&
@@ -1495,4 +1526,7 @@ void Service_UnregisterNodes(UA_Server *server, UA_Session *session,
         response->responseHeader.serviceResult = UA_STATUSCODE_BADTOOMANYOPERATIONS;
         return;
     }
+
+    for(size_t i = 0; i < request->nodesToUnregisterSize; i++)
+        UA_Session_unregisterNode(server, session, &request->nodesToUnregister[i]);
 }
@@ -25,6 +25,10 @@ void UA_Session_init(UA_Session *session) {
 #endif
 }
 
+static void
+removeRegisteredNode(UA_Server *server, UA_Session *session,
+                     UA_RegisteredNode *rn);
+
 void UA_Session_clear(UA_Session *session, UA_Server* server) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
@@ -37,10 +41,6 @@ void UA_Session_clear(UA_Session *session, UA_Server* server) {
     }
 #endif
 
-#ifdef UA_ENABLE_DIAGNOSTICS
-    deleteNode(server, session->sessionId, true);
-#endif
-
     UA_Session_detachFromSecureChannel(session);
     UA_ApplicationDescription_clear(&session->clientDescription);
     UA_NodeId_clear(&session->authenticationToken);
@@ -64,12 +64,194 @@ void UA_Session_clear(UA_Session *session, UA_Server* server) {
     session->localeIds = NULL;
     session->localeIdsSize = 0;
 
+    for(size_t i = 0; i < session->registeredNodesSize; i++) {
+        if(session->registeredNodes[i])
+            removeRegisteredNode(server, session, session->registeredNodes[i]);
+    }
+    UA_free(session->registeredNodes);
+    session->registeredNodes = NULL;
+    session->registeredNodesSize = 0;
+    session->registeredNodesFree = 0;
+
 #ifdef UA_ENABLE_DIAGNOSTICS
     UA_SessionDiagnosticsDataType_clear(&session->diagnostics);
     UA_SessionSecurityDiagnosticsDataType_clear(&session->securityDiagnostics);
 #endif
 }
 
+/********************/
+/* Registered Nodes */
+/********************/
+
+static enum ZIP_CMP
+cmpRegisteredNode(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
+
+ZIP_FUNCTIONS(UA_RegisteredNodeTree, UA_RegisteredNode, treeEntry,
+              UA_NodeId, nodeId, cmpRegisteredNode)
+
+static void
+removeRegisteredNode(UA_Server *server, UA_Session *session,
+                     UA_RegisteredNode *rn) {
+    session->registeredNodes[rn->handle] = NULL;
+    session->registeredNodesCount--;
+    if(rn->handle < session->registeredNodesFree)
+        session->registeredNodesFree = rn->handle;
+    ZIP_REMOVE(UA_RegisteredNodeTree, &session->registeredNodesTree, rn);
+    UA_NODESTORE_RELEASE(server, (const UA_Node*)UA_NodePointer_getNode(rn->node));
+    UA_NodeId_clear(&rn->nodeId);
+    UA_free(rn);
+}
+
+/* Returns UA_MAXREGISTEREDNODES if no handle is available */
+static UA_UInt32
+getFreeHandle(UA_Session *session) {
+    /* Search for a free entry */
+    for(size_t i = session->registeredNodesFree;
+        i < session->registeredNodesSize; i++) {
+        if(!session->registeredNodes[i])
+            return (UA_UInt32)i;
+    }
+
+    /* Grow the table */
+    size_t oldSize = session->registeredNodesSize;
+    if(oldSize == UA_MAXREGISTEREDNODES)
+        return UA_MAXREGISTEREDNODES;
+    size_t newSize = (oldSize == 0) ? 16 : oldSize * 2;
+    if(newSize > UA_MAXREGISTEREDNODES)
+        newSize = UA_MAXREGISTEREDNODES;
+    UA_RegisteredNode **table = (UA_RegisteredNode**)
+        UA_realloc(session->registeredNodes, newSize * sizeof(UA_RegisteredNode*));
+    if(!table)
+        return UA_MAXREGISTEREDNODES;
+    memset(&table[oldSize], 0, (newSize - oldSize) * sizeof(UA_RegisteredNode*));
+    session->registeredNodes = table;
+    session->registeredNodesSize = newSize;
+    return (UA_UInt32)oldSize;
+}
+
+UA_StatusCode
+UA_Session_registerNode(UA_Server *server, UA_Session *session,
+                        const UA_NodeId *nodeId, UA_NodeId *registeredNodeId) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    /* Already registered. Return the same handle. */
+    UA_RegisteredNode *rn =
+        ZIP_FIND(UA_RegisteredNodeTree, &session->registeredNodesTree, nodeId);
+    if(rn) {
+        if(rn->registered < UA_UINT32_MAX)
+            rn->registered++;
+        *registeredNodeId = UA_NODEID_NUMERIC(nodeId->namespaceIndex,
+                                              UA_REGISTEREDNODE_HANDLEBASE + rn->handle);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Test the number of registered nodes in the session */
+    if(server->config.maxRegisteredNodesPerSession != 0 &&
+       session->registeredNodesCount >= server->config.maxRegisteredNodesPerSession)
+        return UA_STATUSCODE_BADTOOMANYOPERATIONS;
+
+    /* Get a handle */
+    UA_UInt32 handle = getFreeHandle(session);
+    if(handle == UA_MAXREGISTEREDNODES)
+        return UA_NodeId_copy(nodeId, registeredNodeId);
+
+    /* The NodeId does not need to exist. Then return the original NodeId. The
+     * reference to the node is kept until the node is unregistered. */
+    const UA_Node *node = UA_NODESTORE_GET(server, nodeId);
+    if(!node)
+        return UA_NodeId_copy(nodeId, registeredNodeId);
+
+#ifdef UA_ENABLE_DIAGNOSTICS
+    /* Virtual diagnostics nodes are synthesized for every access and cannot be
+     * kept. Return the original NodeId. */
+    if(node->head.synthesized) {
+        UA_NODESTORE_RELEASE(server, node);
+        return UA_NodeId_copy(nodeId, registeredNodeId);
+    }
+#endif
+
+    /* The handle must not hide an existing node */
+    UA_NodeId handleId =
+        UA_NODEID_NUMERIC(nodeId->namespaceIndex, UA_REGISTEREDNODE_HANDLEBASE + handle);
+    const UA_Node *other =
+        UA_NODESTORE_GET_SELECTIVE(server, &handleId, 0, UA_REFERENCETYPESET_NONE,
+                                   UA_BROWSEDIRECTION_INVALID);
+    if(other) {
+        UA_NODESTORE_RELEASE(server, other);
+        UA_NODESTORE_RELEASE(server, node);
+        return UA_NodeId_copy(nodeId, registeredNodeId);
+    }
+
+    /* Create the entry */
+    rn = (UA_RegisteredNode*)UA_calloc(1, sizeof(UA_RegisteredNode));
+    if(!rn) {
+        UA_NODESTORE_RELEASE(server, node);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    UA_StatusCode res = UA_NodeId_copy(nodeId, &rn->nodeId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_RELEASE(server, node);
+        UA_free(rn);
+        return res;
+    }
+    rn->node = UA_NodePointer_fromNode(&node->head);
+    rn->handle = handle;
+    rn->registered = 1;
+    ZIP_INSERT(UA_RegisteredNodeTree, &session->registeredNodesTree, rn);
+    session->registeredNodes[handle] = rn;
+    session->registeredNodesCount++;
+    session->registeredNodesFree = handle + 1;
+    *registeredNodeId = handleId;
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_Session_unregisterNode(UA_Server *server, UA_Session *session,
+                          const UA_NodeId *registeredNodeId) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_RegisteredNode *rn = UA_Session_getRegisteredNode(session, registeredNodeId);
+    if(!rn)
+        return;
+    rn->registered--;
+    if(rn->registered == 0)
+        removeRegisteredNode(server, session, rn);
+}
+
+static const UA_Node *
+updateRegisteredNode(UA_Server *server, UA_RegisteredNode *rn, const UA_Node *node) {
+    /* Not found or the cached pointer is current */
+    const UA_NodeHead *cached = UA_NodePointer_getNode(rn->node);
+    if(!node || &node->head == cached)
+        return node;
+
+    /* The node was replaced. Move the reference from the old to the new node.
+     * Getting the node via the direct pointer is cheap. */
+    const UA_Node *current =
+        UA_NODESTORE_GETFROMREF(server, UA_NodePointer_fromNode(&node->head));
+    if(current) {
+        rn->node = UA_NodePointer_fromNode(&current->head);
+        UA_NODESTORE_RELEASE(server, (const UA_Node*)cached);
+    }
+    return node;
+}
+
+const UA_Node *
+UA_RegisteredNode_getNode(UA_Server *server, UA_RegisteredNode *rn) {
+    const UA_Node *node = UA_NODESTORE_GETFROMREF(server, rn->node);
+    return updateRegisteredNode(server, rn, node);
+}
+
+UA_Node *
+UA_RegisteredNode_getEditNode(UA_Server *server, UA_RegisteredNode *rn) {
+    UA_Node *node = server->config.nodestore.
+        getEditNodeFromPtr(server->config.nodestore.context, rn->node,
+                           UA_NODEATTRIBUTESMASK_ALL, UA_REFERENCETYPESET_ALL,
+                           UA_BROWSEDIRECTION_BOTH);
+    return (UA_Node*)(uintptr_t)updateRegisteredNode(server, rn, node);
+}
+
 void
 UA_Session_attachToSecureChannel(UA_Session *session, UA_SecureChannel *channel) {
     /* Ensure the Session is not attached to another SecureChannel */
@@ -248,14 +430,11 @@ UA_Session_queuePublishReq(UA_Session *session, UA_PublishResponseEntry* entry,
 UA_StatusCode
 UA_Server_closeSession(UA_Server *server, const UA_NodeId *sessionId) {
     lockServer(server);
-    session_list_entry *entry;
     UA_StatusCode res = UA_STATUSCODE_BADSESSIONIDINVALID;
-    LIST_FOREACH(entry, &server->sessions, pointers) {
-        if(UA_NodeId_equal(&entry->session.sessionId, sessionId)) {
-            UA_Server_removeSession(server, entry, UA_SHUTDOWNREASON_CLOSE);
-            res = UA_STATUSCODE_GOOD;
-            break;
-        }
+    session_list_entry *entry = lookupSessionById(server, sessionId);
+    if(entry) {
+        UA_Server_removeSession(server, entry, UA_SHUTDOWNREASON_CLOSE);
+        res = UA_STATUSCODE_GOOD;
     }
     unlockServer(server);
     return res;
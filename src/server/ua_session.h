@@ -10,8 +10,10 @@
 #define UA_SESSION_H_
 
 #include <open62541/util.h>
+#include <open62541/plugin/nodestore.h>
 
 #include "../ua_securechannel.h"
+#include "ziptree.h"
 
 _UA_BEGIN_DECLS
 
@@ -27,6 +29,23 @@ ContinuationPoint_clear(ContinuationPoint *cp);
 struct UA_Subscription;
 typedef struct UA_Subscription UA_Subscription;
 
+/* Registered nodes are handed out as numerical NodeIds in the namespace of the
+ * original node. The identifier is the handle base plus the index in the
+ * table of the Session. Every entry holds a reference to the node in the
+ * Nodestore. So Read and Write can access the node without a lookup. */
+#define UA_REGISTEREDNODE_HANDLEBASE 0xFFFF0000
+#define UA_MAXREGISTEREDNODES 0x10000
+
+typedef struct UA_RegisteredNode {
+    ZIP_ENTRY(UA_RegisteredNode) treeEntry; /* Lookup by the original NodeId */
+    UA_NodeId nodeId;      /* The original NodeId */
+    UA_NodePointer node;   /* Direct pointer to the node */
+    UA_UInt32 handle;      /* Index in the table of the Session */
+    UA_UInt32 registered;  /* Number of times the NodeId was registered */
+} UA_RegisteredNode;
+
+typedef ZIP_HEAD(UA_RegisteredNodeTree, UA_RegisteredNode) UA_RegisteredNodeTree;
+
 #ifdef UA_ENABLE_SUBSCRIPTIONS
 typedef struct UA_PublishResponseEntry {
     SIMPLEQ_ENTRY(UA_PublishResponseEntry) listEntry;
@@ -68,6 +87,13 @@ struct UA_Session {
     size_t localeIdsSize;
     UA_String *localeIds;
 
+    /* Registered nodes */
+    UA_RegisteredNode **registeredNodes; /* Table indexed by the handle */
+    size_t registeredNodesSize;          /* Size of the table */
+    size_t registeredNodesCount;         /* Used entries in the table */
+    size_t registeredNodesFree;          /* No free entry below this index */
+    UA_RegisteredNodeTree registeredNodesTree;
+
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     /* The queue is ordered according to the priority byte (higher bytes come
      * first). When a late subscription finally publishes, then it is pushed to
@@ -82,6 +108,16 @@ struct UA_Session {
     size_t totalRetransmissionQueueSize; /* Retransmissions of all subscriptions */
 #endif
 
+#if UA_MULTITHREADING >= 100
+    /* Parallel operations and services executed under the shared server lock
+     * release the lock in between (see UA_ServerWorkers_processOperations and
+     * lockServerShared). The session is pinned while they run. If the session
+     * is removed in the meantime, freeing it is deferred until the last pin is
+     * released. Pinned atomically, as shared lock holders pin concurrently. */
+    volatile size_t pinned;
+    UA_Boolean freePending;
+#endif
+
 #ifdef UA_ENABLE_DIAGNOSTICS
     UA_SessionSecurityDiagnosticsDataType securityDiagnostics;
     UA_SessionDiagnosticsDataType diagnostics;
@@ -102,6 +138,59 @@ UA_StatusCode UA_Session_generateNonce(UA_Session *session);
 void UA_Session_updateLifetime(UA_Session *session, UA_DateTime now,
                                UA_DateTime nowMonotonic);
 
+/**
+ * Registered Nodes
+ * ---------------- */
+
+/* Returns the handle in the registeredNodeId. If no handle can be assigned
+ * (e.g. the node does not exist), the original NodeId is returned. Fails with
+ * BadTooManyOperations if the session has reached the configured
+ * maxRegisteredNodesPerSession. */
+UA_StatusCode
+UA_Session_registerNode(UA_Server *server, UA_Session *session,
+                        const UA_NodeId *nodeId, UA_NodeId *registeredNodeId);
+
+void
+UA_Session_unregisterNode(UA_Server *server, UA_Session *session,
+                          const UA_NodeId *registeredNodeId);
+
+/* Can the NodeId be a handle of some Session? */
+static UA_INLINE UA_Boolean
+UA_RegisteredNode_isHandle(const UA_NodeId *nodeId) {
+    return (nodeId->identifierType == UA_NODEIDTYPE_NUMERIC &&
+            nodeId->identifier.numeric >= UA_REGISTEREDNODE_HANDLEBASE);
+}
+
+/* Returns NULL if the NodeId is not a handle of the Session */
+static UA_INLINE UA_RegisteredNode *
+UA_Session_getRegisteredNode(const UA_Session *session, const UA_NodeId *nodeId) {
+    if(session->registeredNodesCount == 0 || !UA_RegisteredNode_isHandle(nodeId))
+        return NULL;
+    UA_UInt32 handle = nodeId->identifier.numeric - UA_REGISTEREDNODE_HANDLEBASE;
+    if(handle >= session->registeredNodesSize)
+        return NULL;
+    UA_RegisteredNode *rn = session->registeredNodes[handle];
+    if(!rn || rn->nodeId.namespaceIndex != nodeId->namespaceIndex)
+        return NULL;
+    return rn;
+}
+
+/* Get the node behind a handle without a lookup in the Nodestore. If the node
+ * was replaced in the meantime, the cached pointer is updated. */
+const UA_Node *
+UA_RegisteredNode_getNode(UA_Server *server, UA_RegisteredNode *rn);
+
+UA_Node *
+UA_RegisteredNode_getEditNode(UA_Server *server, UA_RegisteredNode *rn);
+
+/* Returns the original NodeId for a registered handle. Otherwise the input
+ * NodeId is returned. */
+static UA_INLINE const UA_NodeId *
+UA_Session_resolveNodeId(const UA_Session *session, const UA_NodeId *nodeId) {
+    UA_RegisteredNode *rn = UA_Session_getRegisteredNode(session, nodeId);
+    return (rn) ? &rn->nodeId : nodeId;
+}
+
 /**
  * Subscription handling
  * --------------------- */
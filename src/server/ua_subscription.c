@@ -22,6 +22,7 @@
 #include "ua_server_internal.h"
 #include "ua_subscription.h"
 #include "itoa.h"
+#include "../ua_types_encoding_binary.h"
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS /* conditional compilation */
 
@@ -36,13 +37,22 @@ static void UA_Notification_enqueueSub(UA_Notification *n);
 static void UA_Notification_dequeueSub(UA_Notification *n);
 
 UA_Notification *
-UA_Notification_new(void) {
-    UA_Notification *n = (UA_Notification*)UA_calloc(1, sizeof(UA_Notification));
+UA_Notification_new(UA_Subscription *sub) {
+    UA_Notification *n = sub->freeNotifications;
     if(n) {
-        /* Set the sentinel for a notification that is not enqueued a
-         * subscription */
-        TAILQ_NEXT(n, subEntry) = UA_SUBSCRIPTION_QUEUE_SENTINEL;
+        /* Take from the free list of the Subscription */
+        sub->freeNotifications = TAILQ_NEXT(n, monEntry);
+        sub->freeNotificationsSize--;
+        memset(n, 0, sizeof(UA_Notification));
+    } else {
+        n = (UA_Notification*)UA_calloc(1, sizeof(UA_Notification));
+        if(!n)
+            return NULL;
     }
+
+    /* Set the sentinel for a notification that is not enqueued a
+     * subscription */
+    TAILQ_NEXT(n, subEntry) = UA_SUBSCRIPTION_QUEUE_SENTINEL;
     return n;
 }
 
@@ -63,6 +73,18 @@ UA_Notification_delete(UA_Notification *n) {
         UA_MonitoredItemNotification_clear(&n->data.dataChange);
         break;
     }
+
+    /* Keep for reuse in the Subscription */
+    UA_Subscription *sub = n->mon->subscription;
+    size_t maxFree = sub->monitoredItemsSize;
+    if(maxFree < UA_SUBSCRIPTION_NOTIFICATIONCACHE)
+        maxFree = UA_SUBSCRIPTION_NOTIFICATIONCACHE;
+    if(sub->freeNotificationsSize < maxFree) {
+        TAILQ_NEXT(n, monEntry) = sub->freeNotifications;
+        sub->freeNotifications = n;
+        sub->freeNotificationsSize++;
+        return;
+    }
     UA_free(n);
 }
 
@@ -271,6 +293,16 @@ UA_Subscription_new(void) {
     return newSub;
 }
 
+void
+UA_Subscription_clearFreeNotifications(UA_Subscription *sub) {
+    UA_Notification *n;
+    while((n = sub->freeNotifications)) {
+        sub->freeNotifications = TAILQ_NEXT(n, monEntry);
+        UA_free(n);
+    }
+    sub->freeNotificationsSize = 0;
+}
+
 static void
 delayedFreeSubscription(void *app, void *context) {
     UA_free(context);
@@ -291,13 +323,6 @@ UA_Subscription_delete(UA_Server *server, UA_Subscription *sub) {
         sub->delayedCallbackRegistered = false;
     }
 
-    /* Remove the diagnostics object for the subscription */
-#ifdef UA_ENABLE_DIAGNOSTICS
-    if(!UA_NodeId_isNull(&sub->ns0Id))
-        deleteNode(server, sub->ns0Id, true);
-    UA_NodeId_clear(&sub->ns0Id);
-#endif
-
     UA_LOG_INFO_SUBSCRIPTION(server->config.logging, sub, "Subscription deleted");
 
     /* Detach from the session if necessary */
@@ -324,7 +349,7 @@ UA_Subscription_delete(UA_Server *server, UA_Subscription *sub) {
     UA_NotificationMessageEntry *nme, *nme_tmp;
     TAILQ_FOREACH_SAFE(nme, &sub->retransmissionQueue, listEntry, nme_tmp) {
         TAILQ_REMOVE(&sub->retransmissionQueue, nme, listEntry);
-        UA_NotificationMessage_clear(&nme->message);
+        UA_ByteString_clear(&nme->message);
         UA_free(nme);
         if(sub->session)
             --sub->session->totalRetransmissionQueueSize;
@@ -332,6 +357,9 @@ UA_Subscription_delete(UA_Server *server, UA_Subscription *sub) {
     }
     UA_assert(sub->retransmissionQueueSize == 0);
 
+    /* Free the Notifications kept for reuse */
+    UA_Subscription_clearFreeNotifications(sub);
+
     /* Pointers to the subscription may still exist upwards in the call stack.
      * Add a delayed callback to remove the Subscription when the current jobs
      * have completed. */
@@ -361,7 +389,7 @@ removeOldestRetransmissionMessageFromSub(UA_Subscription *sub) {
     UA_NotificationMessageEntry *oldestEntry =
         TAILQ_LAST(&sub->retransmissionQueue, NotificationMessageQueue);
     TAILQ_REMOVE(&sub->retransmissionQueue, oldestEntry, listEntry);
-    UA_NotificationMessage_clear(&oldestEntry->message);
+    UA_ByteString_clear(&oldestEntry->message);
     UA_free(oldestEntry);
     --sub->retransmissionQueueSize;
     if(sub->session)
@@ -382,7 +410,7 @@ removeOldestRetransmissionMessageFromSession(UA_Session *session) {
             TAILQ_LAST(&sub->retransmissionQueue, NotificationMessageQueue);
         if(!first)
             continue;
-        if(!oldestEntry || oldestEntry->message.publishTime > first->message.publishTime) {
+        if(!oldestEntry || oldestEntry->publishTime > first->publishTime) {
             oldestEntry = first;
             oldestSub = sub;
         }
@@ -422,7 +450,7 @@ UA_Subscription_removeRetransmissionMessage(UA_Subscription *sub, UA_UInt32 sequ
     /* Find the retransmission message */
     UA_NotificationMessageEntry *entry;
     TAILQ_FOREACH(entry, &sub->retransmissionQueue, listEntry) {
-        if(entry->message.sequenceNumber == sequenceNumber)
+        if(entry->sequenceNumber == sequenceNumber)
             break;
     }
     if(!entry)
@@ -431,7 +459,7 @@ UA_Subscription_removeRetransmissionMessage(UA_Subscription *sub, UA_UInt32 sequ
     /* Remove the retransmission message */
     TAILQ_REMOVE(&sub->retransmissionQueue, entry, listEntry);
     --sub->retransmissionQueueSize;
-    UA_NotificationMessage_clear(&entry->message);
+    UA_ByteString_clear(&entry->message);
     UA_free(entry);
 
     if(sub->session)
@@ -440,104 +468,162 @@ UA_Subscription_removeRetransmissionMessage(UA_Subscription *sub, UA_UInt32 sequ
     return UA_STATUSCODE_GOOD;
 }
 
-/* The output counters are only set when the preparation is successful */
+/* Size of the binary encoding of a queued Notification. Returns zero if an
+ * error occurs. */
+static size_t
+calcSizeNotification(UA_Notification *n, UA_EncodeBinaryOptions *encOpts) {
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    if(n->mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER)
+        return UA_calcSizeBinary(&n->data.event,
+                                 &UA_TYPES[UA_TYPES_EVENTFIELDLIST], encOpts);
+#endif
+    return UA_calcSizeBinary(&n->data.dataChange,
+                             &UA_TYPES[UA_TYPES_MONITOREDITEMNOTIFICATION], encOpts);
+}
+
+/* Encode the content of an ExtensionObject in the notificationData array of
+ * the NotificationMessage. The body is an array of the first
+ * maxNotifications queued Notifications that are events (or not). */
 static UA_StatusCode
-prepareNotificationMessage(UA_Server *server, UA_Subscription *sub,
-                           UA_NotificationMessage *message,
-                           size_t maxNotifications) {
-    UA_assert(maxNotifications > 0);
-
-    /* Allocate an ExtensionObject for Event- and DataChange-Notifications. Also
-     * there can be StatusChange-Notifications. The standard says in Part 4,
-     * 7.2.1:
-     *
-     * If a Subscription contains MonitoredItems for events and data, this array
-     * should have not more than 2 elements. */
-    message->notificationData = (UA_ExtensionObject*)
-        UA_Array_new(2, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]);
-    if(!message->notificationData)
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-    message->notificationDataSize = 2;
-
-    /* Pre-allocate DataChangeNotifications */
-    size_t notificationDataIdx = 0;
-    size_t dcnPos = 0; /* How many DataChangeNotifications? */
-    UA_DataChangeNotification *dcn = NULL;
-    if(sub->dataChangeNotifications > 0) {
-        dcn = UA_DataChangeNotification_new();
-        if(!dcn) {
-            UA_NotificationMessage_clear(message);
-            return UA_STATUSCODE_BADOUTOFMEMORY;
-        }
-        UA_ExtensionObject_setValue(message->notificationData, dcn,
-                                    &UA_TYPES[UA_TYPES_DATACHANGENOTIFICATION]);
-        size_t dcnSize = sub->dataChangeNotifications;
-        if(dcnSize > maxNotifications)
-            dcnSize = maxNotifications;
-        dcn->monitoredItems = (UA_MonitoredItemNotification*)
-            UA_Array_new(dcnSize, &UA_TYPES[UA_TYPES_MONITOREDITEMNOTIFICATION]);
-        if(!dcn->monitoredItems) {
-            UA_NotificationMessage_clear(message); /* Also frees the dcn */
-            return UA_STATUSCODE_BADOUTOFMEMORY;
+encodeNotificationData(UA_Subscription *sub, size_t maxNotifications,
+                       UA_Boolean events, const UA_DataType *type,
+                       size_t count, size_t bodySize,
+                       UA_Byte **pos, const UA_Byte **end,
+                       UA_EncodeBinaryOptions *encOpts) {
+    /* ExtensionObject header */
+    UA_Byte encoding = UA_EXTENSIONOBJECT_ENCODED_BYTESTRING;
+    UA_Int32 signedBodySize = (UA_Int32)bodySize;
+    UA_StatusCode res =
+        UA_encodeBinaryInternal(&type->binaryEncodingId, &UA_TYPES[UA_TYPES_NODEID],
+                                pos, end, encOpts, NULL, NULL);
+    res |= UA_encodeBinaryInternal(&encoding, &UA_TYPES[UA_TYPES_BYTE],
+                                   pos, end, encOpts, NULL, NULL);
+    res |= UA_encodeBinaryInternal(&signedBodySize, &UA_TYPES[UA_TYPES_INT32],
+                                   pos, end, encOpts, NULL, NULL);
+
+    /* Array of MonitoredItemNotifications or EventFieldLists */
+    UA_Int32 signedCount = (UA_Int32)count;
+    res |= UA_encodeBinaryInternal(&signedCount, &UA_TYPES[UA_TYPES_INT32],
+                                   pos, end, encOpts, NULL, NULL);
+    size_t i = 0;
+    UA_Notification *n;
+    TAILQ_FOREACH(n, &sub->notificationQueue, subEntry) {
+        if(i++ >= maxNotifications || res != UA_STATUSCODE_GOOD)
+            break;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+        if(n->mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER) {
+            if(events)
+                res = UA_encodeBinaryInternal(&n->data.event,
+                                              &UA_TYPES[UA_TYPES_EVENTFIELDLIST],
+                                              pos, end, encOpts, NULL, NULL);
+            continue;
         }
-        dcn->monitoredItemsSize = dcnSize;
-        notificationDataIdx++;
+#endif
+        if(!events)
+            res = UA_encodeBinaryInternal(&n->data.dataChange,
+                                          &UA_TYPES[UA_TYPES_MONITOREDITEMNOTIFICATION],
+                                          pos, end, encOpts, NULL, NULL);
+    }
+
+    /* The DataChangeNotification has an (empty) array of DiagnosticInfos */
+    if(!events) {
+        UA_Int32 noDiagnostics = -1;
+        res |= UA_encodeBinaryInternal(&noDiagnostics, &UA_TYPES[UA_TYPES_INT32],
+                                       pos, end, encOpts, NULL, NULL);
     }
+    return res;
+}
 
+/* Encode a NotificationMessage with (up to) maxNotifications Notifications
+ * from the queue of the Subscription. The Notifications are encoded directly
+ * from the queue into a buffer of the exact size. The result is identical to
+ * the encoding of a UA_NotificationMessage with a DataChangeNotification and an
+ * EventNotificationList (in that order). But the intermediate structure is
+ * never built. The encoded Notifications are removed from the queues. If
+ * maxNotifications is zero, a KeepAlive message is encoded. */
+static UA_StatusCode
+encodeNotificationMessage(UA_Subscription *sub, size_t maxNotifications,
+                          UA_UInt32 sequenceNumber, UA_DateTime publishTime,
+                          UA_EncodeBinaryOptions *encOpts,
+                          UA_ByteString *encoded) {
+    /* Compute the size of the array bodies */
+    size_t dcnCount = 0, dcnSize = 0; /* DataChangeNotification */
+    size_t enlCount = 0, enlSize = 0; /* EventNotificationList */
+    size_t i = 0;
+    UA_Notification *n;
+    TAILQ_FOREACH(n, &sub->notificationQueue, subEntry) {
+        if(i++ >= maxNotifications)
+            break;
+        size_t nSize = calcSizeNotification(n, encOpts);
+        if(nSize == 0)
+            return UA_STATUSCODE_BADENCODINGERROR;
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
-    size_t enlPos = 0; /* How many EventNotifications? */
-    UA_EventNotificationList *enl = NULL;
-    if(sub->eventNotifications > 0) {
-        enl = UA_EventNotificationList_new();
-        if(!enl) {
-            UA_NotificationMessage_clear(message);
-            return UA_STATUSCODE_BADOUTOFMEMORY;
-        }
-        UA_ExtensionObject_setValue(&message->notificationData[notificationDataIdx],
-                                    enl, &UA_TYPES[UA_TYPES_EVENTNOTIFICATIONLIST]);
-        size_t enlSize = sub->eventNotifications;
-        if(enlSize > maxNotifications)
-            enlSize = maxNotifications;
-        enl->events = (UA_EventFieldList*)
-            UA_Array_new(enlSize, &UA_TYPES[UA_TYPES_EVENTFIELDLIST]);
-        if(!enl->events) {
-            UA_NotificationMessage_clear(message);
-            return UA_STATUSCODE_BADOUTOFMEMORY;
+        if(n->mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER) {
+            enlCount++;
+            enlSize += nSize;
+            continue;
         }
-        enl->eventsSize = enlSize;
-        notificationDataIdx++;
-    }
 #endif
+        dcnCount++;
+        dcnSize += nSize;
+    }
 
-    UA_assert(notificationDataIdx > 0);
-    message->notificationDataSize = notificationDataIdx;
+    /* Compute the overall size. The NotificationMessage starts with the
+     * sequenceNumber, publishTime and the length of the notificationData
+     * array. Every ExtensionObject has the NodeId of the encoding, the encoding
+     * byte and the body length. The bodies contain the array length(s). */
+    const UA_DataType *dcnType = &UA_TYPES[UA_TYPES_DATACHANGENOTIFICATION];
+    const UA_DataType *enlType = &UA_TYPES[UA_TYPES_EVENTNOTIFICATIONLIST];
+    UA_Int32 dataSize = -1; /* No notificationData for a KeepAlive */
+    size_t total = 4 + 8 + 4;
+    if(dcnCount > 0) {
+        dcnSize += 4 + 4; /* Length of the monitoredItems and diagnosticInfos */
+        total += UA_calcSizeBinary(&dcnType->binaryEncodingId,
+                                   &UA_TYPES[UA_TYPES_NODEID], NULL) + 1 + 4 + dcnSize;
+        dataSize = 1;
+    }
+    if(enlCount > 0) {
+        enlSize += 4; /* Length of the events array */
+        total += UA_calcSizeBinary(&enlType->binaryEncodingId,
+                                   &UA_TYPES[UA_TYPES_NODEID], NULL) + 1 + 4 + enlSize;
+        dataSize = (dataSize > 0) ? 2 : 1;
+    }
+    if(total > UA_INT32_MAX)
+        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
 
-    /* <-- The point of no return --> */
+    /* Allocate the buffer */
+    UA_StatusCode res = UA_ByteString_allocBuffer(encoded, total);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
 
-    /* How many notifications were moved to the response overall? */
-    size_t totalNotifications = 0;
-    UA_Notification *n, *n_tmp;
-    TAILQ_FOREACH_SAFE(n, &sub->notificationQueue, subEntry, n_tmp) {
-        if(totalNotifications >= maxNotifications)
-            break;
+    /* Encode */
+    UA_Byte *pos = encoded->data;
+    const UA_Byte *end = &encoded->data[encoded->length];
+    res |= UA_encodeBinaryInternal(&sequenceNumber, &UA_TYPES[UA_TYPES_UINT32],
+                                   &pos, &end, encOpts, NULL, NULL);
+    res |= UA_encodeBinaryInternal(&publishTime, &UA_TYPES[UA_TYPES_DATETIME],
+                                   &pos, &end, encOpts, NULL, NULL);
+    res |= UA_encodeBinaryInternal(&dataSize, &UA_TYPES[UA_TYPES_INT32],
+                                   &pos, &end, encOpts, NULL, NULL);
+    if(res == UA_STATUSCODE_GOOD && dcnCount > 0)
+        res = encodeNotificationData(sub, maxNotifications, false, dcnType,
+                                     dcnCount, dcnSize, &pos, &end, encOpts);
+    if(res == UA_STATUSCODE_GOOD && enlCount > 0)
+        res = encodeNotificationData(sub, maxNotifications, true, enlType,
+                                     enlCount, enlSize, &pos, &end, encOpts);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(encoded);
+        return res;
+    }
+    UA_assert(pos == end);
 
-        /* Move the content to the response */
-        switch(n->mon->itemToMonitor.attributeId) {
-#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
-        case UA_ATTRIBUTEID_EVENTNOTIFIER:
-            UA_assert(enl != NULL); /* Have at least one event notification */
-            enl->events[enlPos] = n->data.event;
-            UA_EventFieldList_init(&n->data.event);
-            enlPos++;
-            break;
-#endif
-        default:
-            UA_assert(dcn != NULL); /* Have at least one change notification */
-            dcn->monitoredItems[dcnPos] = n->data.dataChange;
-            UA_DataValue_init(&n->data.dataChange.value);
-            dcnPos++;
+    /* <-- The point of no return --> */
+
+    /* Remove the encoded Notifications */
+    for(i = 0; i < maxNotifications; i++) {
+        n = TAILQ_FIRST(&sub->notificationQueue);
+        if(!n)
             break;
-        }
 
         /* If there are Notifications *before this one* in the MonitoredItem-
          * local queue, remove all of them. These are earlier Notifications that
@@ -553,29 +639,8 @@ prepareNotificationMessage(UA_Server *server, UA_Subscription *sub,
 
         /* Delete the notification, remove from the queues and decrease the counters */
         UA_Notification_delete(n);
-
-        totalNotifications++;
-    }
-
-    /* Set sizes */
-    if(dcn) {
-        dcn->monitoredItemsSize = dcnPos;
-        if(dcnPos == 0) {
-            UA_free(dcn->monitoredItems);
-            dcn->monitoredItems = NULL;
-        }
     }
 
-#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
-    if(enl) {
-        enl->eventsSize = enlPos;
-        if(enlPos == 0) {
-            UA_free(enl->events);
-            enl->events = NULL;
-        }
-    }
-#endif
-
     return UA_STATUSCODE_GOOD;
 }
 
@@ -803,63 +868,66 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
 
     /* Prepare the response */
     UA_PublishResponse *response = &pre->response;
-    UA_NotificationMessage *message = &response->notificationMessage;
     UA_NotificationMessageEntry *retransmission = NULL;
 #ifdef UA_ENABLE_DIAGNOSTICS
     size_t priorDataChangeNotifications = sub->dataChangeNotifications;
     size_t priorEventNotifications = sub->eventNotifications;
 #endif
-    if(notifications > 0) {
-        if(server->config.enableRetransmissionQueue) {
-            /* Allocate the retransmission entry */
-            retransmission = (UA_NotificationMessageEntry*)
-                UA_malloc(sizeof(UA_NotificationMessageEntry));
-            if(!retransmission) {
-                UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
-                                            "Could not allocate memory for retransmission. "
-                                            "The subscription is late.");
-                sub->late = true;
-                UA_Session_queuePublishReq(sub->session, pre, true); /* Re-enqueue */
-                return;
-            }
-        }
-
-        /* Prepare the response */
-        UA_StatusCode retval =
-            prepareNotificationMessage(server, sub, message, notifications);
-        if(retval != UA_STATUSCODE_GOOD) {
+    if(notifications > 0 && server->config.enableRetransmissionQueue) {
+        /* Allocate the retransmission entry */
+        retransmission = (UA_NotificationMessageEntry*)
+            UA_malloc(sizeof(UA_NotificationMessageEntry));
+        if(!retransmission) {
             UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
-                                        "Could not prepare the notification message. "
+                                        "Could not allocate memory for retransmission. "
                                         "The subscription is late.");
-            /* If the retransmission queue is enabled a retransmission message is allocated */
-            if(retransmission)
-                UA_free(retransmission);
             sub->late = true;
             UA_Session_queuePublishReq(sub->session, pre, true); /* Re-enqueue */
             return;
         }
     }
 
+    /* Encode the NotificationMessage from the queued notifications. Set
+     * sequence number to message. Started at 1 which is given during creating a
+     * new subscription. The 1 is required for initial publish response with or
+     * without an monitored item. */
+    UA_SecureChannel *channel = sub->session->channel;
+    UA_EncodeBinaryOptions encOpts;
+    memset(&encOpts, 0, sizeof(UA_EncodeBinaryOptions));
+    encOpts.namespaceMapping = channel->namespaceMapping;
+    UA_ByteString message = UA_BYTESTRING_NULL;
+    UA_DateTime publishTime = el->dateTime_now(el);
+    UA_StatusCode retval =
+        encodeNotificationMessage(sub, notifications, sub->nextSequenceNumber,
+                                  publishTime, &encOpts, &message);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
+                                    "Could not prepare the notification message. "
+                                    "The subscription is late.");
+        /* If the retransmission queue is enabled a retransmission message is allocated */
+        if(retransmission)
+            UA_free(retransmission);
+        sub->late = true;
+        UA_Session_queuePublishReq(sub->session, pre, true); /* Re-enqueue */
+        return;
+    }
+
     /* <-- The point of no return --> */
 
     /* Set up the response */
     response->subscriptionId = sub->subscriptionId;
     response->moreNotifications = (sub->notificationQueueSize > 0);
-    message->publishTime = el->dateTime_now(el);
-
-    /* Set sequence number to message. Started at 1 which is given during
-     * creating a new subscription. The 1 is required for initial publish
-     * response with or without an monitored item. */
-    message->sequenceNumber = sub->nextSequenceNumber;
 
     if(notifications > 0) {
         /* If the retransmission queue is enabled a retransmission message is
          * allocated */
         if(retransmission) {
-            /* Put the notification message into the retransmission queue. This
-             * needs to be done here, so that the message itself is included in
-             * the available sequence numbers for acknowledgement. */
-            retransmission->message = response->notificationMessage;
+            /* Put the encoded notification message into the retransmission
+             * queue. This needs to be done here, so that the message itself is
+             * included in the available sequence numbers for acknowledgement. */
+            retransmission->sequenceNumber = sub->nextSequenceNumber;
+            retransmission->publishTime = publishTime;
+            retransmission->message = message;
             UA_Subscription_addRetransmissionMessage(server, sub, retransmission);
         }
         /* Only if a notification was created, the sequence number must be
@@ -876,17 +944,19 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     size_t i = 0;
     UA_NotificationMessageEntry *nme;
     TAILQ_FOREACH(nme, &sub->retransmissionQueue, listEntry) {
-        response->availableSequenceNumbers[i] = nme->message.sequenceNumber;
+        response->availableSequenceNumbers[i] = nme->sequenceNumber;
         ++i;
     }
     UA_assert(i == sub->retransmissionQueueSize);
 
-    /* Send the response */
+    /* Send the response. The encoded NotificationMessage is copied into the
+     * message chunks. */
     UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, sub,
                               "Sending out a publish response with %" PRIu32
                               " notifications", notifications);
-    sendResponse(server, sub->session->channel, pre->requestId,
-                 (UA_Response*)response, &UA_TYPES[UA_TYPES_PUBLISHRESPONSE]);
+    sendResponseWithNotificationMessage(server, channel, pre->requestId,
+                                        (UA_Response*)response,
+                                        &UA_TYPES[UA_TYPES_PUBLISHRESPONSE], &message);
 
     /* Reset the Subscription state to NORMAL. But only if all notifications
      * have been sent out. Otherwise keep the Subscription in the LATE state. So
@@ -901,11 +971,10 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     /* Reset the KeepAlive after publishing */
     sub->currentKeepAliveCount = 0;
 
-    /* Free the response */
-    if(retransmission) {
-        /* NotificationMessage was moved into retransmission queue */
-        UA_NotificationMessage_init(&response->notificationMessage);
-    }
+    /* Free the response. The encoded NotificationMessage was moved into the
+     * retransmission queue. */
+    if(!retransmission)
+        UA_ByteString_clear(&message);
     response->availableSequenceNumbers = NULL;
     response->availableSequenceNumbersSize = 0;
     UA_PublishResponse_clear(&pre->response);
@@ -1101,7 +1170,7 @@ createEventOverflowNotification(UA_Server *server, UA_Subscription *sub,
     efl.eventFieldsSize = 1;
 
     /* Allocate the notification */
-    UA_Notification *overflowNotification = UA_Notification_new();
+    UA_Notification *overflowNotification = UA_Notification_new(sub);
     if(!overflowNotification) {
         UA_Variant_delete(efl.eventFields);
         return UA_STATUSCODE_BADOUTOFMEMORY;
@@ -1409,6 +1478,10 @@ UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *mon) {
     /* Remove the settings */
     UA_ReadValueId_clear(&mon->itemToMonitor);
     UA_MonitoringParameters_clear(&mon->parameters);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    UA_EventFilterCompiled_delete(mon->eventFilter);
+    mon->eventFilter = NULL;
+#endif
 
     /* Remove the last samples */
     UA_DataValue_clear(&mon->lastValue);
@@ -1543,13 +1616,154 @@ UA_MonitoredItem_ensureQueueSpace(UA_Server *server, UA_MonitoredItem *mon) {
     }
 }
 
+/******************/
+/* SamplingGroups */
+/******************/
+
+static enum ZIP_CMP
+cmpSampledNode(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
+
+ZIP_FUNCTIONS(UA_SampledNodeTree, UA_SampledNode, treeEntry,
+              UA_NodeId, nodeId, cmpSampledNode)
+
+static void
+UA_SampledNode_delete(UA_SamplingGroup *sg, UA_SampledNode *sn) {
+    UA_assert(LIST_EMPTY(&sn->monitoredItems));
+    if(sg->nextSample == sn)
+        sg->nextSample = TAILQ_NEXT(sn, listEntry);
+    ZIP_REMOVE(UA_SampledNodeTree, &sg->nodeTree, sn);
+    TAILQ_REMOVE(&sg->nodes, sn, listEntry);
+    UA_NodeId_clear(&sn->nodeId);
+    UA_free(sn);
+}
+
+static void
+UA_SamplingGroup_delete(UA_Server *server, UA_SamplingGroup *sg) {
+    UA_assert(sg->monitoredItemsSize == 0);
+    UA_assert(TAILQ_EMPTY(&sg->nodes));
+    removeCallback(server, sg->callbackId);
+    LIST_REMOVE(sg, listEntry);
+    UA_free(sg);
+}
+
+/* Remove the SampledNodes that became empty during the sampling pass. Remove
+ * the entire group if it is empty. */
+static void
+UA_SamplingGroup_cleanup(UA_Server *server, UA_SamplingGroup *sg) {
+    UA_SampledNode *sn, *sn_tmp;
+    TAILQ_FOREACH_SAFE(sn, &sg->nodes, listEntry, sn_tmp) {
+        if(LIST_EMPTY(&sn->monitoredItems))
+            UA_SampledNode_delete(sg, sn);
+    }
+    sg->removed = false;
+    if(sg->monitoredItemsSize == 0)
+        UA_SamplingGroup_delete(server, sg);
+}
+
+/* Sample all MonitoredItems of the group. The node is looked up once for all
+ * MonitoredItems that sample it. The iterators in the group and the
+ * SampledNode are advanced if the current element is removed during the pass.
+ * So this is robust against MonitoredItems being removed while sampling. */
 static void
-UA_MonitoredItem_lockAndSample(UA_Server *server, UA_MonitoredItem *mon) {
+UA_SamplingGroup_sample(UA_Server *server, UA_SamplingGroup *sg) {
     lockServer(server);
-    UA_MonitoredItem_sample(server, mon);
+
+    sg->sampling = true;
+    UA_SampledNode *sn = TAILQ_FIRST(&sg->nodes);
+    for(; sn; sn = sg->nextSample) {
+        sg->nextSample = TAILQ_NEXT(sn, listEntry);
+        const UA_Node *node = UA_NODESTORE_GET(server, &sn->nodeId);
+        UA_MonitoredItem *mon = LIST_FIRST(&sn->monitoredItems);
+        for(; mon; mon = sn->nextSample) {
+            sn->nextSample = LIST_NEXT(mon, sampling.cyclic.listEntry);
+            UA_MonitoredItem_sampleNode(server, mon, node);
+        }
+        if(node)
+            UA_NODESTORE_RELEASE(server, node);
+    }
+    sg->sampling = false;
+
+    if(sg->removed)
+        UA_SamplingGroup_cleanup(server, sg);
+
     unlockServer(server);
 }
 
+static UA_StatusCode
+addSamplingGroupItem(UA_Server *server, UA_MonitoredItem *mon) {
+    /* Find the group for the sampling interval. Create a new group with its
+     * own timer if required. The phase of the group is defined by the first
+     * MonitoredItem. */
+    UA_Double interval = mon->parameters.samplingInterval;
+    UA_SamplingGroup *sg;
+    LIST_FOREACH(sg, &server->samplingGroups, listEntry) {
+        if(sg->samplingInterval == interval)
+            break;
+    }
+    if(!sg) {
+        sg = (UA_SamplingGroup*)UA_calloc(1, sizeof(UA_SamplingGroup));
+        if(!sg)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        sg->samplingInterval = interval;
+        TAILQ_INIT(&sg->nodes);
+        UA_StatusCode res =
+            addRepeatedCallback(server, (UA_ServerCallback)UA_SamplingGroup_sample,
+                                sg, interval, &sg->callbackId);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(sg);
+            return res;
+        }
+        LIST_INSERT_HEAD(&server->samplingGroups, sg, listEntry);
+    }
+
+    /* Find or create the SampledNode */
+    UA_SampledNode *sn =
+        ZIP_FIND(UA_SampledNodeTree, &sg->nodeTree, &mon->itemToMonitor.nodeId);
+    if(!sn) {
+        sn = (UA_SampledNode*)UA_calloc(1, sizeof(UA_SampledNode));
+        UA_StatusCode res = (sn) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADOUTOFMEMORY;
+        if(sn)
+            res = UA_NodeId_copy(&mon->itemToMonitor.nodeId, &sn->nodeId);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(sn);
+            if(sg->monitoredItemsSize == 0 && !sg->sampling)
+                UA_SamplingGroup_delete(server, sg);
+            return res;
+        }
+        sn->group = sg;
+        ZIP_INSERT(UA_SampledNodeTree, &sg->nodeTree, sn);
+        TAILQ_INSERT_TAIL(&sg->nodes, sn, listEntry);
+    }
+
+    LIST_INSERT_HEAD(&sn->monitoredItems, mon, sampling.cyclic.listEntry);
+    mon->sampling.cyclic.node = sn;
+    sg->monitoredItemsSize++;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+removeSamplingGroupItem(UA_Server *server, UA_MonitoredItem *mon) {
+    UA_SampledNode *sn = mon->sampling.cyclic.node;
+    UA_SamplingGroup *sg = sn->group;
+    if(sn->nextSample == mon)
+        sn->nextSample = LIST_NEXT(mon, sampling.cyclic.listEntry);
+    LIST_REMOVE(mon, sampling.cyclic.listEntry);
+    sg->monitoredItemsSize--;
+
+    /* Cleaned up after the sampling pass */
+    if(sg->sampling) {
+        sg->removed = true;
+        return;
+    }
+
+    if(LIST_EMPTY(&sn->monitoredItems))
+        UA_SampledNode_delete(sg, sn);
+    if(sg->monitoredItemsSize == 0)
+        UA_SamplingGroup_delete(server, sg);
+}
+
 UA_StatusCode
 UA_MonitoredItem_registerSampling(UA_Server *server, UA_MonitoredItem *mon) {
     UA_LOCK_ASSERT(&server->serviceMutex);
@@ -1572,19 +1786,20 @@ UA_MonitoredItem_registerSampling(UA_Server *server, UA_MonitoredItem *mon) {
                                  addMonitoredItemBackpointer, mon);
         if(res == UA_STATUSCODE_GOOD)
             mon->samplingType = UA_MONITOREDITEMSAMPLINGTYPE_EVENT;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+        if(res == UA_STATUSCODE_GOOD &&
+           mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER)
+            UA_EventIndex_nodeChanged(server, &mon->itemToMonitor.nodeId);
+#endif
     } else if(mon->parameters.samplingInterval == sub->publishingInterval) {
         /* Add to the subscription for sampling before every publish */
         LIST_INSERT_HEAD(&sub->samplingMonitoredItems, mon,
                          sampling.subscriptionSampling);
         mon->samplingType = UA_MONITOREDITEMSAMPLINGTYPE_PUBLISH;
     } else {
-        /* DataChange MonitoredItems with a positive sampling interval have a
-         * repeated callback. Other MonitoredItems are attached to the Node in a
-         * linked list of backpointers. */
-        res = addRepeatedCallback(server,
-                                  (UA_ServerCallback)UA_MonitoredItem_lockAndSample,
-                                  mon, mon->parameters.samplingInterval,
-                                  &mon->sampling.callbackId);
+        /* DataChange MonitoredItems with a positive sampling interval are
+         * sampled cyclically in the SamplingGroup for their interval */
+        res = addSamplingGroupItem(server, mon);
         if(res == UA_STATUSCODE_GOOD)
             mon->samplingType = UA_MONITOREDITEMSAMPLINGTYPE_CYCLIC;
     }
@@ -1598,8 +1813,8 @@ UA_MonitoredItem_unregisterSampling(UA_Server *server, UA_MonitoredItem *mon) {
 
     switch(mon->samplingType) {
     case UA_MONITOREDITEMSAMPLINGTYPE_CYCLIC:
-        /* Remove repeated callback */
-        removeCallback(server, mon->sampling.callbackId);
+        /* Remove from the SamplingGroup */
+        removeSamplingGroupItem(server, mon);
         break;
 
     case UA_MONITOREDITEMSAMPLINGTYPE_EVENT: {
@@ -1608,6 +1823,10 @@ UA_MonitoredItem_unregisterSampling(UA_Server *server, UA_MonitoredItem *mon) {
         UA_Server_editNode(server, &server->adminSession, &mon->itemToMonitor.nodeId,
                            0, UA_REFERENCETYPESET_NONE, UA_BROWSEDIRECTION_INVALID,
                            removeMonitoredItemBackPointer, mon);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+        if(mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER)
+            UA_EventIndex_nodeChanged(server, &mon->itemToMonitor.nodeId);
+#endif
         break;
     }
 
@@ -24,6 +24,7 @@
 
 #include "ua_session.h"
 #include "../util/ua_util_internal.h"
+#include "ziptree.h"
 
 _UA_BEGIN_DECLS
 
@@ -71,8 +72,10 @@ typedef struct UA_Notification {
 } UA_Notification;
 
 /* Initializes and sets the sentinel pointers. Only create a notification if it
- * is also going to be immediately enqueued to a MonitoredItem (see below). */
-UA_Notification * UA_Notification_new(void);
+ * is also going to be immediately enqueued to a MonitoredItem (see below).
+ * Notifications are taken from (and deleted into) the free list of the
+ * Subscription if possible. */
+UA_Notification * UA_Notification_new(UA_Subscription *sub);
 
 /* Notifications are always added to the queue of a MonitoredItem. That queue
  * can overflow. If Notifications are reported, they are also added to the queue
@@ -86,10 +89,14 @@ void UA_Notification_enqueueAndTrigger(UA_Server *server,
                                        UA_Notification *n);
 
 /* A NotificationMessage contains an array of notifications.
- * Sent NotificationMessages are stored for the republish service. */
+ * Sent NotificationMessages are stored for the republish service. They are
+ * kept in the binary encoding (with the namespace mapping of the SecureChannel
+ * at the time of publishing). So a Republish only copies the bytes. */
 typedef struct UA_NotificationMessageEntry {
     TAILQ_ENTRY(UA_NotificationMessageEntry) listEntry;
-    UA_NotificationMessage message;
+    UA_UInt32 sequenceNumber;
+    UA_DateTime publishTime;
+    UA_ByteString message; /* Binary-encoded UA_NotificationMessage */
 } UA_NotificationMessageEntry;
 
 /* Queue Definitions */
@@ -115,6 +122,43 @@ typedef enum {
     UA_MONITOREDITEMSAMPLINGTYPE_PUBLISH /* Attached to the subscription */
 } UA_MonitoredItemSamplingType;
 
+/* Cyclic MonitoredItems with the same sampling interval share a
+ * SamplingGroup with a single timer. So all items of the group are sampled in
+ * one pass and with a single acquisition of the server lock. Within the group,
+ * the items are bucketed by the sampled NodeId. Then every node is looked up
+ * only once per sampling pass, also if it is monitored by many items. */
+struct UA_SamplingGroup;
+typedef struct UA_SamplingGroup UA_SamplingGroup;
+
+typedef struct UA_SampledNode {
+    ZIP_ENTRY(UA_SampledNode) treeEntry;   /* Lookup by the NodeId */
+    TAILQ_ENTRY(UA_SampledNode) listEntry; /* Order of the sampling pass */
+    UA_SamplingGroup *group;
+    UA_NodeId nodeId;
+    LIST_HEAD(, UA_MonitoredItem) monitoredItems;
+    UA_MonitoredItem *nextSample; /* Iterator during the sampling pass */
+} UA_SampledNode;
+
+typedef ZIP_HEAD(UA_SampledNodeTree, UA_SampledNode) UA_SampledNodeTree;
+
+struct UA_SamplingGroup {
+    LIST_ENTRY(UA_SamplingGroup) listEntry; /* List in the server */
+    UA_Double samplingInterval;
+    UA_UInt64 callbackId;
+    size_t monitoredItemsSize;
+    UA_SampledNodeTree nodeTree;
+    TAILQ_HEAD(, UA_SampledNode) nodes;
+    UA_SampledNode *nextSample; /* Iterator during the sampling pass */
+
+    /* Empty SampledNodes and an empty group are not removed during the
+     * sampling pass. This is done once the pass is complete. */
+    UA_Boolean sampling;
+    UA_Boolean removed; /* A MonitoredItem was removed during the pass */
+};
+
+/* Maximum memSize of a scalar value stored inline in the MonitoredItem */
+#define UA_MONITOREDITEM_INLINEVALUE 16
+
 struct UA_MonitoredItem {
     UA_DelayedCallback delayedFreePointers;
     LIST_ENTRY(UA_MonitoredItem) listEntry; /* Linked list in the Subscription */
@@ -151,13 +195,26 @@ struct UA_MonitoredItem {
     /* Sampling */
     UA_MonitoredItemSamplingType samplingType;
     union {
-        UA_UInt64 callbackId;
+        struct {
+            LIST_ENTRY(UA_MonitoredItem) listEntry;
+            UA_SampledNode *node;
+        } cyclic; /* Cyclic: Member of a SamplingGroup */
         UA_MonitoredItem *nodeListNext; /* Event-Based: Attached to Node */
         LIST_ENTRY(UA_MonitoredItem) subscriptionSampling; /* Linked to publish
                                                             * interval */
     } sampling;
     UA_DataValue lastValue;
 
+    /* Small pointer-free scalars (numbers, DateTime, Guid, ...) of the
+     * lastValue are stored inline. The variant then has the storage type
+     * UA_VARIANT_DATA_NODELETE and points here. This way a changed sample can
+     * be moved to the Notification without allocating a second copy. */
+    union {
+        UA_UInt64 u64;
+        UA_Double d;
+        UA_Byte bytes[UA_MONITOREDITEM_INLINEVALUE];
+    } lastValueData;
+
     /* Triggering Links */
     size_t triggeringLinksSize;
     UA_UInt32 *triggeringLinks;
@@ -168,6 +225,12 @@ struct UA_MonitoredItem {
                        * (maximum) queueSize in the parameters. */
     size_t eventOverflows; /* Separate counter for the queue. Can at most double
                             * the queue size */
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    /* Compiled form of the EventFilter in the parameters. Rebuilt when the
+     * MonitoredItem is modified. NULL falls back to interpreting the filter. */
+    struct UA_EventFilterCompiled *eventFilter;
+#endif
 };
 
 void UA_MonitoredItem_init(UA_MonitoredItem *mon);
@@ -175,8 +238,8 @@ void UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *mon);
 void UA_MonitoredItem_removeOverflowInfoBits(UA_MonitoredItem *mon);
 void UA_Server_registerMonitoredItem(UA_Server *server, UA_MonitoredItem *mon);
 
-/* Register sampling. Either by adding a repeated callback or by adding the
- * MonitoredItem to a linked list in the node. */
+/* Register sampling. Either by adding the MonitoredItem to the SamplingGroup
+ * for its interval, to the Subscription or to a linked list in the node. */
 UA_StatusCode
 UA_MonitoredItem_registerSampling(UA_Server *server, UA_MonitoredItem *mon);
 
@@ -190,6 +253,12 @@ UA_MonitoredItem_setMonitoringMode(UA_Server *server, UA_MonitoredItem *mon,
 void
 UA_MonitoredItem_sample(UA_Server *server, UA_MonitoredItem *mon);
 
+/* Sample from a node that was already looked up by the caller. The node can be
+ * NULL if it does not exist. */
+void
+UA_MonitoredItem_sampleNode(UA_Server *server, UA_MonitoredItem *mon,
+                            const UA_Node *node);
+
 /* Do not use the value after calling this. It will be moved to mon or freed. */
 void
 UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
@@ -228,6 +297,9 @@ typedef enum {
  * subscription is always generated for a Session. But the CloseSession Service
  * may keep Subscriptions intact beyond the Session lifetime. They can then be
  * re-bound to a new Session with the TransferSubscription Service. */
+/* Minimum number of deleted Notifications kept for reuse in a Subscription */
+#define UA_SUBSCRIPTION_NOTIFICATIONCACHE 64
+
 struct UA_Subscription {
     UA_DelayedCallback delayedFreePointers;
     LIST_ENTRY(UA_Subscription) serverListEntry;
@@ -276,6 +348,13 @@ struct UA_Subscription {
     UA_UInt32 dataChangeNotifications;
     UA_UInt32 eventNotifications;
 
+    /* Deleted Notifications are kept for reuse, linked via their monEntry. The
+     * list holds at most max(UA_SUBSCRIPTION_NOTIFICATIONCACHE,
+     * monitoredItemsSize) entries. So a steady stream of changes does not go
+     * through the allocator. */
+    UA_Notification *freeNotifications;
+    size_t freeNotificationsSize;
+
     /* Retransmission Queue */
     NotificationMessageQueue retransmissionQueue;
     size_t retransmissionQueueSize;
@@ -283,8 +362,6 @@ struct UA_Subscription {
     /* Statistics for the server diagnostics. The fields are defined according
      * to the SubscriptionDiagnosticsDataType (Part 5, §12.15). */
 #ifdef UA_ENABLE_DIAGNOSTICS
-    UA_NodeId ns0Id; /* Representation in the Session object */
-
     UA_UInt32 modifyCount;
     UA_UInt32 enableCount;
     UA_UInt32 disableCount;
@@ -306,6 +383,10 @@ struct UA_Subscription {
 
 UA_Subscription * UA_Subscription_new(void);
 
+/* Free the Notifications kept for reuse */
+void
+UA_Subscription_clearFreeNotifications(UA_Subscription *sub);
+
 void
 UA_Subscription_delete(UA_Server *server, UA_Subscription *sub);
 
@@ -347,10 +428,67 @@ typedef struct UA_ConditionSource UA_ConditionSource;
 #define UA_EVENTFILTER_MAXOPERANDS 64 /* Max operands per operator */
 #define UA_EVENTFILTER_MAXSELECT   64 /* Max select clauses */
 
+/* Browse paths of node events that were resolved to the field node. The cache
+ * lives for the duration of a single triggered event and is shared by all
+ * MonitoredItems receiving the event. So every field is browsed once per event
+ * and not once per subscriber. */
+typedef struct {
+    size_t browsePathSize;
+    UA_QualifiedName *browsePath;
+    UA_NodeId target;
+    UA_StatusCode status;
+} UA_EventFieldCacheEntry;
+
+typedef struct {
+    UA_Boolean hasEventType;
+    UA_StatusCode eventTypeStatus;
+    UA_NodeId eventType;
+    size_t entriesSize;
+    UA_EventFieldCacheEntry *entries;
+} UA_EventFieldCache;
+
+void
+UA_EventFieldCache_clear(UA_EventFieldCache *cache);
+
+/* An event is either represented as a node in the information model or as a
+ * flat map of fields keyed by their browse path (see
+ * UA_Server_triggerEventFields). Exactly one of the two is set. */
+typedef struct {
+    const UA_NodeId *eventNode;
+    const UA_KeyValueMap *eventFields;
+    UA_EventFieldCache *cache; /* Can be NULL */
+} UA_EventInstance;
+
+/* EventFilter compiled when the MonitoredItem is created or modified. Select
+ * clauses whose TypeDefinition is not BaseEventType apply only to some
+ * EventTypes. Their applicability is cached for the last seen EventType. */
+#define UA_SELECTCLAUSE_TYPED 0x01 /* Check against the EventType */
+#define UA_SELECTCLAUSE_VALID 0x02 /* Applies to the cached EventType */
+
+typedef struct UA_EventFilterCompiled {
+    UA_NodeId eventType; /* EventType for which the VALID flags were computed */
+    size_t selectClausesSize;
+    UA_Byte *selectClauses; /* Flags for each select clause */
+} UA_EventFilterCompiled;
+
+UA_EventFilterCompiled *
+UA_EventFilter_compile(const UA_EventFilter *filter);
+
+void
+UA_EventFilterCompiled_delete(UA_EventFilterCompiled *ef);
+
+/* Replace the compiled filter after the parameters have changed */
+void
+UA_MonitoredItem_compileEventFilter(UA_MonitoredItem *mon);
+
 UA_StatusCode
 UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
                           const UA_NodeId *event);
 
+UA_StatusCode
+UA_MonitoredItem_addEventInstance(UA_Server *server, UA_MonitoredItem *mon,
+                                  const UA_EventInstance *event);
+
 UA_StatusCode
 generateEventId(UA_ByteString *generatedId);
 
@@ -124,6 +124,23 @@ detectValueChange(UA_Server *server, UA_MonitoredItem *mon, const UA_DataValue *
                      &UA_TYPES[UA_TYPES_VARIANT]);
 }
 
+/* Takes ownership of the value if successful */
+static UA_StatusCode
+enqueueDataChangeNotification(UA_Server *server, UA_MonitoredItem *mon,
+                              UA_DataValue *dv) {
+    /* Allocate a new notification */
+    UA_Notification *n = UA_Notification_new(mon->subscription);
+    if(!n)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Prepare and enqueue the notification */
+    n->mon = mon;
+    n->data.dataChange.value = *dv;
+    n->data.dataChange.clientHandle = mon->parameters.clientHandle;
+    UA_Notification_enqueueAndTrigger(server, n);
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_MonitoredItem_createDataChangeNotification(UA_Server *server, UA_MonitoredItem *mon,
                                               const UA_DataValue *dv) {
@@ -133,19 +150,20 @@ UA_MonitoredItem_createDataChangeNotification(UA_Server *server, UA_MonitoredIte
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
-    /* Allocate a new notification */
-    UA_Notification *n = UA_Notification_new();
-    if(!n) {
+    retval = enqueueDataChangeNotification(server, mon, &valueCopy);
+    if(retval != UA_STATUSCODE_GOOD)
         UA_DataValue_clear(&valueCopy);
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-    }
+    return retval;
+}
 
-    /* Prepare and enqueue the notification */
-    n->mon = mon;
-    n->data.dataChange.value = valueCopy;
-    n->data.dataChange.clientHandle = mon->parameters.clientHandle;
-    UA_Notification_enqueueAndTrigger(server, n);
-    return UA_STATUSCODE_GOOD;
+/* Can the value be stored in mon->lastValueData? */
+static UA_Boolean
+storeInline(const UA_MonitoredItem *mon, const UA_DataValue *dv) {
+    const UA_DataType *type = dv->value.type;
+    return (dv->hasValue && type && type->pointerFree &&
+            type->memSize <= sizeof(mon->lastValueData) &&
+            dv->value.storageType == UA_VARIANT_DATA &&
+            UA_Variant_isScalar(&dv->value));
 }
 
 void
@@ -164,9 +182,22 @@ UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
         return;
     }
 
-    /* Prepare a notification and enqueue it */
-    UA_StatusCode res =
-        UA_MonitoredItem_createDataChangeNotification(server, mon, value);
+    /* Prepare a notification and enqueue it. Small scalars are moved into the
+     * notification and a shallow copy is kept inline in the MonitoredItem.
+     * Otherwise the notification gets a copy and the sample is moved to
+     * mon->lastValue. The notification can be deleted right away during the
+     * enqueueing (queue overflow). So keep the inline copy on the stack until
+     * then. */
+    UA_StatusCode res;
+    UA_DataValue last = *value;
+    UA_Boolean inlined = storeInline(mon, value);
+    UA_Byte lastData[sizeof(mon->lastValueData)];
+    if(inlined) {
+        memcpy(lastData, value->value.data, value->value.type->memSize);
+        res = enqueueDataChangeNotification(server, mon, value);
+    } else {
+        res = UA_MonitoredItem_createDataChangeNotification(server, mon, value);
+    }
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, mon->subscription,
                                     "MonitoredItem %" PRIi32 " | "
@@ -178,7 +209,12 @@ UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
 
     /* Move/store the value for filter comparison and TransferSubscription */
     UA_DataValue_clear(&mon->lastValue);
-    mon->lastValue = *value;
+    mon->lastValue = last;
+    if(inlined) {
+        memcpy(mon->lastValueData.bytes, lastData, last.value.type->memSize);
+        mon->lastValue.value.data = mon->lastValueData.bytes;
+        mon->lastValue.value.storageType = UA_VARIANT_DATA_NODELETE;
+    }
 
     /* Call the local callback if the MonitoredItem is not attached to a
      * subscription. Do this at the very end. Because the callback might delete
@@ -190,7 +226,8 @@ UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
         localMon->callback.dataChangeCallback(server,
                                               mon->monitoredItemId, localMon->context,
                                               &mon->itemToMonitor.nodeId, nodeContext,
-                                              mon->itemToMonitor.attributeId, value);
+                                              mon->itemToMonitor.attributeId,
+                                              &mon->lastValue);
     }
 }
 
@@ -214,4 +251,33 @@ UA_MonitoredItem_sample(UA_Server *server, UA_MonitoredItem *mon) {
     UA_MonitoredItem_processSampledValue(server, mon, &dv);
 }
 
+void
+UA_MonitoredItem_sampleNode(UA_Server *server, UA_MonitoredItem *mon,
+                            const UA_Node *node) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    UA_assert(mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER);
+
+    UA_Subscription *sub = mon->subscription;
+    UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, sub, "MonitoredItem %" PRIi32
+                              " | Sample callback called", mon->monitoredItemId);
+
+    /* Same as in readWithSession, but without looking up the node again */
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    UA_Session *session = (sub) ? sub->session : &server->adminSession;
+    if(!session) {
+        dv.hasStatus = true;
+        dv.status = UA_STATUSCODE_BADUSERACCESSDENIED;
+    } else if(!node) {
+        dv.hasStatus = true;
+        dv.status = UA_STATUSCODE_BADNODEIDUNKNOWN;
+    } else {
+        ReadWithNode(node, server, session, mon->timestampsToReturn,
+                     &mon->itemToMonitor, &dv);
+    }
+
+    /* Process the sample. This always clears the value. */
+    UA_MonitoredItem_processSampledValue(server, mon, &dv);
+}
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
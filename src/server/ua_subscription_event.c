@@ -176,8 +176,8 @@ eventSetStandardFields(UA_Server *server, const UA_NodeId *event,
 /* Filters an event according to the filter specified by mon and then adds it to
  * mons notification queue */
 UA_StatusCode
-UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
-                          const UA_NodeId *event) {
+UA_MonitoredItem_addEventInstance(UA_Server *server, UA_MonitoredItem *mon,
+                                  const UA_EventInstance *event) {
     /* Get the filter */
     if(mon->parameters.filter.content.decoded.type != &UA_TYPES[UA_TYPES_EVENTFILTER])
         return UA_STATUSCODE_BADFILTERNOTALLOWED;
@@ -198,8 +198,8 @@ UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
     UA_EventFilterResult_init(&efr);
 
     /* Evaluate the filter. Return if it doesn't match. */
-    UA_StatusCode ret = filterEvent(server, sub->session, event,
-                                    eventFilter, &values, &efr);
+    UA_StatusCode ret = filterEvent(server, sub->session, event, eventFilter,
+                                    mon->eventFilter, &values, &efr);
     UA_EventFilterResult_clear(&efr);
     if(ret != UA_STATUSCODE_GOOD) {
         UA_EventFieldList_clear(&values);
@@ -209,7 +209,7 @@ UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
     }
 
     /* Allocate memory for the notification */
-    UA_Notification *notification = UA_Notification_new();
+    UA_Notification *notification = UA_Notification_new(sub);
     if(!notification) {
         UA_EventFieldList_clear(&values);
         return UA_STATUSCODE_BADOUTOFMEMORY;
@@ -223,10 +223,17 @@ UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
+                          const UA_NodeId *event) {
+    UA_EventInstance ei = {event, NULL, NULL};
+    return UA_MonitoredItem_addEventInstance(server, mon, &ei);
+}
+
 #ifdef UA_ENABLE_HISTORIZING
 static void
 setHistoricalEvent(UA_Server *server, const UA_NodeId *origin,
-                   const UA_NodeId *emitNodeId, const UA_NodeId *eventNodeId) {
+                   const UA_NodeId *emitNodeId, const UA_EventInstance *event) {
     UA_Variant historicalEventFilterValue;
     UA_Variant_init(&historicalEventFilterValue);
 
@@ -260,7 +267,8 @@ setHistoricalEvent(UA_Server *server, const UA_NodeId *origin,
     UA_EventFilter *filter = (UA_EventFilter*) historicalEventFilterValue.data;
     UA_EventFieldList efl;
     UA_EventFilterResult result;
-    retval = filterEvent(server, &server->adminSession, eventNodeId, filter, &efl, &result);
+    retval = filterEvent(server, &server->adminSession, event, filter,
+                         NULL, &efl, &result);
     if(retval == UA_STATUSCODE_GOOD)
         server->config.historyDatabase.setEvent(server, server->config.historyDatabase.context,
                                                 origin, emitNodeId, filter, &efl);
@@ -282,29 +290,10 @@ static const UA_NodeId isInFolderReferences[2] =
     {{0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_ORGANIZES}},
      {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_HASCOMPONENT}}};
 
-UA_StatusCode
-triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
-             const UA_NodeId origin, UA_ByteString *outEventId,
-             const UA_Boolean deleteEventNode) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
-
-    UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
-                 "Events: An event is triggered on node %N", origin);
-
-#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
-    UA_Boolean isCallerAC = false;
-    if(isConditionOrBranch(server, &eventNodeId, &origin, &isCallerAC)) {
-        if(!isCallerAC) {
-          UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                                 "Condition Events: Please use A&C API to trigger Condition Events 0x%08X",
-                                  UA_STATUSCODE_BADINVALIDARGUMENT);
-          return UA_STATUSCODE_BADINVALIDARGUMENT;
-        }
-    }
-#endif /* UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS */
-
-    /* Check that the origin node exists */
-    const UA_Node *originNode = UA_NODESTORE_GET(server, &origin);
+/* Check that the origin node exists and is in the ObjectsFolder */
+static UA_StatusCode
+checkEventOrigin(UA_Server *server, const UA_NodeId *origin) {
+    const UA_Node *originNode = UA_NODESTORE_GET(server, origin);
     if(!originNode) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_USERLAND,
                      "Origin node for event does not exist.");
@@ -328,21 +317,163 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
         refTypes = UA_ReferenceTypeSet_union(refTypes, tmpRefTypes);
     }
 
-    if(!isNodeInTree(server, &origin, &objectsFolderId, &refTypes)) {
+    if(!isNodeInTree(server, origin, &objectsFolderId, &refTypes)) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_USERLAND,
                      "Node for event must be in ObjectsFolder!");
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
+    return UA_STATUSCODE_GOOD;
+}
 
-    /* Update the standard fields of the event */
-    retval = eventSetStandardFields(server, &eventNodeId, &origin, outEventId);
-    if(retval != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                       "Events: Could not set the standard event fields with StatusCode %s",
-                       UA_StatusCode_name(retval));
-        return retval;
+/***************************/
+/* Event Propagation Index */
+/***************************/
+
+/* Events propagate from the origin upwards in the node hierarchy. The nodes
+ * visited on the way and their event MonitoredItems are cached for every
+ * origin. A cached entry remains valid until the references over which events
+ * propagate or the event MonitoredItems change on one of the visited nodes.
+ * Then the entire index is dropped and rebuilt lazily. */
+
+#define UA_EVENTINDEX_MAXORIGINS 1024
+
+typedef struct UA_EventIndexEntry {
+    ZIP_ENTRY(UA_EventIndexEntry) treeEntry; /* Lookup by the origin NodeId */
+    UA_NodeId origin;
+    UA_Boolean cached; /* Temporary entries are not added to the index */
+    size_t emitNodesSize;
+    UA_NodeId *emitNodes; /* Objects emitting the event (for historizing) */
+    size_t monsSize;
+    UA_MonitoredItem **mons; /* Event MonitoredItems of the emitting objects */
+} UA_EventIndexEntry;
+
+typedef ZIP_HEAD(UA_EventIndexTree, UA_EventIndexEntry) UA_EventIndexTree;
+
+struct UA_EventIndex {
+    UA_EventIndexTree origins;
+    size_t originsSize;
+    RefTree visited; /* Union of the nodes visited for the cached origins */
+    UA_ReferenceTypeSet refTypes; /* Events propagate over these references */
+    size_t inUse;     /* Cached entries currently used for a propagation */
+    UA_Boolean stale; /* Invalidated while in use. Dropped after use. */
+};
+
+static enum ZIP_CMP
+cmpEventIndexEntry(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
+
+ZIP_FUNCTIONS(UA_EventIndexTree, UA_EventIndexEntry, treeEntry,
+              UA_NodeId, origin, cmpEventIndexEntry)
+
+static void
+UA_EventIndexEntry_delete(UA_EventIndexEntry *entry) {
+    UA_NodeId_clear(&entry->origin);
+    UA_Array_delete(entry->emitNodes, entry->emitNodesSize,
+                    &UA_TYPES[UA_TYPES_NODEID]);
+    UA_free(entry->mons);
+    UA_free(entry);
+}
+
+static void *
+deleteEventIndexEntryCallback(void *context, UA_EventIndexEntry *entry) {
+    UA_EventIndexEntry_delete(entry);
+    return NULL;
+}
+
+void
+UA_EventIndex_delete(UA_Server *server) {
+    struct UA_EventIndex *ei = server->eventIndex;
+    if(!ei)
+        return;
+    UA_assert(ei->inUse == 0);
+    ZIP_ITER(UA_EventIndexTree, &ei->origins,
+             deleteEventIndexEntryCallback, NULL);
+    RefTree_clear(&ei->visited);
+    UA_free(ei);
+    server->eventIndex = NULL;
+}
+
+static void
+invalidateEventIndex(UA_Server *server) {
+    struct UA_EventIndex *ei = server->eventIndex;
+    if(ei->inUse > 0)
+        ei->stale = true; /* Pointers into the index are still used */
+    else
+        UA_EventIndex_delete(server);
+}
+
+void
+UA_EventIndex_nodeChanged(UA_Server *server, const UA_NodeId *nodeId) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    struct UA_EventIndex *ei = server->eventIndex;
+    if(ei && !ei->stale && RefTree_containsNodeId(&ei->visited, nodeId))
+        invalidateEventIndex(server);
+}
+
+void
+UA_EventIndex_referenceChanged(UA_Server *server, UA_Byte refTypeIndex,
+                               const UA_NodeId *sourceId,
+                               const UA_NodeId *targetId) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    struct UA_EventIndex *ei = server->eventIndex;
+    if(!ei || ei->stale)
+        return;
+
+    /* A change in the type hierarchy can add ReferenceTypes over which events
+     * propagate */
+    if(refTypeIndex == UA_REFERENCETYPEINDEX_HASSUBTYPE) {
+        invalidateEventIndex(server);
+        return;
+    }
+
+    if(!UA_ReferenceTypeSet_contains(&ei->refTypes, refTypeIndex))
+        return;
+    if(RefTree_containsNodeId(&ei->visited, sourceId) ||
+       RefTree_containsNodeId(&ei->visited, targetId))
+        invalidateEventIndex(server);
+}
+
+/* Get all ReferenceTypes over which the events propagate */
+static UA_StatusCode
+getEmitReferenceTypes(UA_Server *server, UA_ReferenceTypeSet *emitRefTypes) {
+    UA_ReferenceTypeSet_init(emitRefTypes);
+    for(size_t i = 0; i < EMIT_REFS_ROOT_COUNT; i++) {
+        UA_ReferenceTypeSet tmpRefTypes;
+        UA_StatusCode retval =
+            referenceTypeIndices(server, &emitReferencesRoots[i], &tmpRefTypes, true);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                           "Events: Could not create the list of references for event "
+                           "propagation with StatusCode %s", UA_StatusCode_name(retval));
+            return retval;
+        }
+        *emitRefTypes = UA_ReferenceTypeSet_union(*emitRefTypes, tmpRefTypes);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static struct UA_EventIndex *
+getEventIndex(UA_Server *server) {
+    if(server->eventIndex)
+        return server->eventIndex;
+    struct UA_EventIndex *ei = (struct UA_EventIndex*)
+        UA_calloc(1, sizeof(struct UA_EventIndex));
+    if(!ei)
+        return NULL;
+    if(getEmitReferenceTypes(server, &ei->refTypes) != UA_STATUSCODE_GOOD ||
+       RefTree_init(&ei->visited) != UA_STATUSCODE_GOOD) {
+        UA_free(ei);
+        return NULL;
     }
+    server->eventIndex = ei;
+    return ei;
+}
 
+/* Collect the nodes that emit the event and their event MonitoredItems */
+static UA_StatusCode
+buildEventIndexEntry(UA_Server *server, const UA_ReferenceTypeSet *emitRefTypes,
+                     RefTree *visited, UA_EventIndexEntry *entry) {
     /* List of nodes that emit the node. Events propagate upwards (bubble up) in
      * the node hierarchy. */
     UA_ExpandedNodeId *emitNodes = NULL;
@@ -356,37 +487,35 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
      * a Server and as such has implied HasEventSource References to every event
      * source in a Server. */
     UA_NodeId emitStartNodes[2];
-    emitStartNodes[0] = origin;
+    emitStartNodes[0] = entry->origin;
     emitStartNodes[1] = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
 
-    /* Get all ReferenceTypes over which the events propagate */
-    UA_ReferenceTypeSet emitRefTypes;
-    UA_ReferenceTypeSet_init(&emitRefTypes);
-    for(size_t i = 0; i < EMIT_REFS_ROOT_COUNT; i++) {
-        UA_ReferenceTypeSet tmpRefTypes;
-        retval = referenceTypeIndices(server, &emitReferencesRoots[i], &tmpRefTypes, true);
-        if(retval != UA_STATUSCODE_GOOD) {
-            UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                           "Events: Could not create the list of references for event "
-                           "propagation with StatusCode %s", UA_StatusCode_name(retval));
-            goto cleanup;
-        }
-        emitRefTypes = UA_ReferenceTypeSet_union(emitRefTypes, tmpRefTypes);
-    }
-
     /* Get the list of nodes in the hierarchy that emits the event. */
-    retval = browseRecursive(server, 2, emitStartNodes, UA_BROWSEDIRECTION_INVERSE,
-                             &emitRefTypes, UA_NODECLASS_UNSPECIFIED, true,
-                             &emitNodesSize, &emitNodes);
+    UA_StatusCode retval =
+        browseRecursive(server, 2, emitStartNodes, UA_BROWSEDIRECTION_INVERSE,
+                        emitRefTypes, UA_NODECLASS_UNSPECIFIED, true,
+                        &emitNodesSize, &emitNodes);
     if(retval != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
                        "Events: Could not create the list of nodes listening on the "
                        "event with StatusCode %s", UA_StatusCode_name(retval));
+        return retval;
+    }
+
+    entry->emitNodes = (UA_NodeId*)UA_calloc(emitNodesSize, sizeof(UA_NodeId));
+    if(emitNodesSize > 0 && !entry->emitNodes) {
+        retval = UA_STATUSCODE_BADOUTOFMEMORY;
         goto cleanup;
     }
 
-    /* Add the event to the listening MonitoredItems at each relevant node */
     for(size_t i = 0; i < emitNodesSize; i++) {
+        /* Changes to every visited node invalidate the cached entry */
+        if(visited) {
+            retval = RefTree_addNodeId(visited, &emitNodes[i].nodeId, NULL);
+            if(retval != UA_STATUSCODE_GOOD)
+                goto cleanup;
+        }
+
         /* Get the node */
         const UA_Node *node = UA_NODESTORE_GET(server, &emitNodes[i].nodeId);
         if(!node)
@@ -398,30 +527,191 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
             continue;
         }
 
-        /* Add event to monitoreditems */
+        /* Collect the Event-MonitoredItems */
+        size_t mons = 0;
         UA_MonitoredItem *mon = node->head.monitoredItems;
         for(; mon != NULL; mon = mon->sampling.nodeListNext) {
-            /* Is this an Event-MonitoredItem? */
-            if(mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER)
-                continue;
-            retval = UA_MonitoredItem_addEvent(server, mon, &eventNodeId);
-            if(retval != UA_STATUSCODE_GOOD) {
-                UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                               "Events: Could not add the event to a listening "
-                               "node with StatusCode %s", UA_StatusCode_name(retval));
-                retval = UA_STATUSCODE_GOOD; /* Only log problems with individual emit nodes */
+            if(mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER)
+                mons++;
+        }
+        if(mons > 0) {
+            UA_MonitoredItem **newMons = (UA_MonitoredItem**)
+                UA_realloc(entry->mons, sizeof(UA_MonitoredItem*) *
+                           (entry->monsSize + mons));
+            if(!newMons) {
+                UA_NODESTORE_RELEASE(server, node);
+                retval = UA_STATUSCODE_BADOUTOFMEMORY;
+                goto cleanup;
+            }
+            entry->mons = newMons;
+            for(mon = node->head.monitoredItems; mon; mon = mon->sampling.nodeListNext) {
+                if(mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER)
+                    entry->mons[entry->monsSize++] = mon;
             }
         }
 
         UA_NODESTORE_RELEASE(server, node);
 
-        /* Add event entry in the historical database */
+        /* Move the NodeId of the emitting object */
+        entry->emitNodes[entry->emitNodesSize++] = emitNodes[i].nodeId;
+        UA_NodeId_init(&emitNodes[i].nodeId);
+    }
+
+ cleanup:
+    UA_Array_delete(emitNodes, emitNodesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    return retval;
+}
+
+/* Get the entry for the origin from the index. Or build a new entry if the
+ * origin is not cached. The entry must be released after the propagation. */
+static UA_StatusCode
+acquireEventIndexEntry(UA_Server *server, const UA_NodeId *origin,
+                       UA_EventIndexEntry **outEntry) {
+    struct UA_EventIndex *ei = getEventIndex(server);
+    if(ei && ei->stale)
+        ei = NULL; /* Don't use the index until it is dropped */
+
+    /* Cache hit. The origin was already checked when the entry was built. */
+    UA_EventIndexEntry *entry = NULL;
+    if(ei) {
+        entry = ZIP_FIND(UA_EventIndexTree, &ei->origins, origin);
+        if(entry) {
+            ei->inUse++;
+            *outEntry = entry;
+            return UA_STATUSCODE_GOOD;
+        }
+    }
+
+    UA_StatusCode retval = checkEventOrigin(server, origin);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Drop the index if it is full. If entries are still in use, the new entry
+     * is only used temporarily. */
+    if(ei && ei->originsSize >= UA_EVENTINDEX_MAXORIGINS) {
+        invalidateEventIndex(server);
+        ei = getEventIndex(server);
+        if(ei && ei->stale)
+            ei = NULL;
+    }
+
+    UA_ReferenceTypeSet emitRefTypes;
+    if(ei) {
+        emitRefTypes = ei->refTypes;
+    } else {
+        retval = getEmitReferenceTypes(server, &emitRefTypes);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+
+    entry = (UA_EventIndexEntry*)UA_calloc(1, sizeof(UA_EventIndexEntry));
+    if(!entry)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    retval = UA_NodeId_copy(origin, &entry->origin);
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = buildEventIndexEntry(server, &emitRefTypes,
+                                      (ei) ? &ei->visited : NULL, entry);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_EventIndexEntry_delete(entry);
+        return retval;
+    }
+
+    if(ei) {
+        entry->cached = true;
+        ZIP_INSERT(UA_EventIndexTree, &ei->origins, entry);
+        ei->originsSize++;
+        ei->inUse++;
+    }
+
+    *outEntry = entry;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+releaseEventIndexEntry(UA_Server *server, UA_EventIndexEntry *entry) {
+    if(!entry->cached) {
+        UA_EventIndexEntry_delete(entry);
+        return;
+    }
+    struct UA_EventIndex *ei = server->eventIndex;
+    UA_assert(ei && ei->inUse > 0);
+    ei->inUse--;
+    if(ei->inUse == 0 && ei->stale)
+        UA_EventIndex_delete(server);
+}
+
+/* Add the event to the MonitoredItems of the origin and all nodes above it */
+static void
+propagateEvent(UA_Server *server, const UA_EventInstance *event,
+               const UA_NodeId *origin, const UA_EventIndexEntry *entry) {
+    /* Add event to monitoreditems. The MonitoredItems are freed in a delayed
+     * callback. So the pointers remain valid also if the index is invalidated
+     * during the propagation. */
+    for(size_t i = 0; i < entry->monsSize; i++) {
+        UA_StatusCode retval =
+            UA_MonitoredItem_addEventInstance(server, entry->mons[i], event);
+        if(retval != UA_STATUSCODE_GOOD) {
+            /* Only log problems with individual emit nodes */
+            UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                           "Events: Could not add the event to a listening "
+                           "node with StatusCode %s", UA_StatusCode_name(retval));
+        }
+    }
+
+    /* Add event entry in the historical database */
 #ifdef UA_ENABLE_HISTORIZING
-        if(server->config.historyDatabase.setEvent)
-            setHistoricalEvent(server, &origin, &emitNodes[i].nodeId, &eventNodeId);
+    if(server->config.historyDatabase.setEvent) {
+        for(size_t i = 0; i < entry->emitNodesSize; i++)
+            setHistoricalEvent(server, origin, &entry->emitNodes[i], event);
+    }
 #endif
+}
+
+UA_StatusCode
+triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
+             const UA_NodeId origin, UA_ByteString *outEventId,
+             const UA_Boolean deleteEventNode) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
+                 "Events: An event is triggered on node %N", origin);
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    UA_Boolean isCallerAC = false;
+    if(isConditionOrBranch(server, &eventNodeId, &origin, &isCallerAC)) {
+        if(!isCallerAC) {
+          UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                                 "Condition Events: Please use A&C API to trigger Condition Events 0x%08X",
+                                  UA_STATUSCODE_BADINVALIDARGUMENT);
+          return UA_STATUSCODE_BADINVALIDARGUMENT;
+        }
+    }
+#endif /* UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS */
+
+    /* Check the origin and get the listening MonitoredItems */
+    UA_EventIndexEntry *entry = NULL;
+    UA_StatusCode retval = acquireEventIndexEntry(server, &origin, &entry);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Update the standard fields of the event */
+    retval = eventSetStandardFields(server, &eventNodeId, &origin, outEventId);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "Events: Could not set the standard event fields with StatusCode %s",
+                       UA_StatusCode_name(retval));
+        releaseEventIndexEntry(server, entry);
+        return retval;
     }
 
+    /* The resolved fields are cached for all receiving MonitoredItems */
+    UA_EventFieldCache cache;
+    memset(&cache, 0, sizeof(UA_EventFieldCache));
+    UA_EventInstance event = {&eventNodeId, NULL, &cache};
+    propagateEvent(server, &event, &origin, entry);
+    UA_EventFieldCache_clear(&cache);
+    releaseEventIndexEntry(server, entry);
+
     /* Delete the node representation of the event */
     if(deleteEventNode) {
         retval = deleteNode(server, eventNodeId, true);
@@ -432,8 +722,6 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
         }
     }
 
- cleanup:
-    UA_Array_delete(emitNodes, emitNodesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
     return retval;
 }
 
@@ -448,4 +736,91 @@ UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
     return res;
 }
 
+#define EVENT_STANDARD_FIELDS 4
+
+UA_StatusCode
+triggerEventFields(UA_Server *server, const UA_NodeId eventType,
+                   const UA_NodeId origin, const UA_KeyValueMap *eventFields,
+                   UA_ByteString *outEventId) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
+                 "Events: A field-map event is triggered on node %N", origin);
+
+    /* Make sure the eventType is a subtype of BaseEventType */
+    UA_NodeId baseEventTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+    if(!isNodeInTree_singleRef(server, &eventType, &baseEventTypeId,
+                               UA_REFERENCETYPEINDEX_HASSUBTYPE)) {
+        UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_USERLAND,
+                     "Event type must be a subtype of BaseEventType!");
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    }
+
+    UA_ByteString eventId = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = generateEventId(&eventId);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Shallow copy of the user-defined fields behind the standard fields. The
+     * first match wins during the lookup. So the standard fields set by the
+     * server take precedence. */
+    size_t userFields = (eventFields) ? eventFields->mapSize : 0;
+    UA_KeyValuePair *fields = (UA_KeyValuePair*)
+        UA_malloc(sizeof(UA_KeyValuePair) * (EVENT_STANDARD_FIELDS + userFields));
+    if(!fields) {
+        UA_ByteString_clear(&eventId);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    /* Check the origin and get the listening MonitoredItems */
+    UA_EventIndexEntry *entry = NULL;
+    retval = acquireEventIndexEntry(server, &origin, &entry);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_free(fields);
+        UA_ByteString_clear(&eventId);
+        return retval;
+    }
+    if(userFields > 0)
+        memcpy(&fields[EVENT_STANDARD_FIELDS], eventFields->map,
+               sizeof(UA_KeyValuePair) * userFields);
+
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime rcvTime = el->dateTime_now(el);
+    fields[0].key = UA_QUALIFIEDNAME(0, "EventId");
+    UA_Variant_setScalar(&fields[0].value, &eventId, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    fields[1].key = UA_QUALIFIEDNAME(0, "EventType");
+    UA_Variant_setScalar(&fields[1].value, (void*)(uintptr_t)&eventType,
+                         &UA_TYPES[UA_TYPES_NODEID]);
+    fields[2].key = UA_QUALIFIEDNAME(0, "SourceNode");
+    UA_Variant_setScalar(&fields[2].value, (void*)(uintptr_t)&origin,
+                         &UA_TYPES[UA_TYPES_NODEID]);
+    fields[3].key = UA_QUALIFIEDNAME(0, "ReceiveTime");
+    UA_Variant_setScalar(&fields[3].value, &rcvTime, &UA_TYPES[UA_TYPES_DATETIME]);
+
+    UA_KeyValueMap map = {EVENT_STANDARD_FIELDS + userFields, fields};
+    UA_EventInstance event = {NULL, &map, NULL};
+    propagateEvent(server, &event, &origin, entry);
+    releaseEventIndexEntry(server, entry);
+    UA_free(fields);
+
+    /* Return the EventId */
+    if(outEventId)
+        *outEventId = eventId;
+    else
+        UA_ByteString_clear(&eventId);
+    return retval;
+}
+
+UA_StatusCode
+UA_Server_triggerEventFields(UA_Server *server, const UA_NodeId eventType,
+                             const UA_NodeId origin,
+                             const UA_KeyValueMap *eventFields,
+                             UA_ByteString *outEventId) {
+    lockServer(server);
+    UA_StatusCode res =
+        triggerEventFields(server, eventType, origin, eventFields, outEventId);
+    unlockServer(server);
+    return res;
+}
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS_EVENTS */
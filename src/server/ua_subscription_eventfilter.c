@@ -454,7 +454,7 @@ castImplicit(const UA_Variant *in, const UA_DataType *outType, UA_Variant *out)
 typedef struct {
     UA_Server *server;
     UA_Session *session;
-    const UA_NodeId *eventNode;
+    const UA_EventInstance *event;
     const UA_ContentFilter *filter;
     UA_ContentFilterResult *filterResult;
     UA_Variant results[UA_EVENTFILTER_MAXELEMENTS];
@@ -469,13 +469,199 @@ typedef struct {
  * ~~~~~~~~~~~~~~~~~
  * Methods that all resolve an operator operand to a Variant. */
 
+/* Field-map events store each field under its browse path. Nested fields use
+ * a single key with the path elements separated by "/". All path elements
+ * must be in the namespace of the key. */
+static UA_Boolean
+matchFieldKey(const UA_QualifiedName *key, size_t pathSize,
+              const UA_QualifiedName *path) {
+    if(pathSize == 0)
+        return false;
+    size_t pos = 0;
+    for(size_t i = 0; i < pathSize; i++) {
+        if(path[i].namespaceIndex != key->namespaceIndex)
+            return false;
+        if(i > 0) {
+            if(pos >= key->name.length || key->name.data[pos] != '/')
+                return false;
+            pos++;
+        }
+        const UA_String *name = &path[i].name;
+        if(key->name.length - pos < name->length)
+            return false;
+        if(name->length > 0 &&
+           memcmp(&key->name.data[pos], name->data, name->length) != 0)
+            return false;
+        pos += name->length;
+    }
+    return (pos == key->name.length);
+}
+
+static const UA_Variant *
+getEventField(const UA_KeyValueMap *fields, size_t pathSize,
+              const UA_QualifiedName *path) {
+    for(size_t i = 0; i < fields->mapSize; i++) {
+        if(matchFieldKey(&fields->map[i].key, pathSize, path))
+            return &fields->map[i].value;
+    }
+    return NULL;
+}
+
+/* Field-map events have no node representation. Only the value attribute of
+ * the fields can be selected. */
+static UA_StatusCode
+resolveEventFieldOperand(const UA_KeyValueMap *fields,
+                         const UA_SimpleAttributeOperand *sao,
+                         UA_Variant *value) {
+    if(sao->attributeId != UA_ATTRIBUTEID_VALUE)
+        return UA_STATUSCODE_BADATTRIBUTEIDINVALID;
+    const UA_Variant *field =
+        getEventField(fields, sao->browsePathSize, sao->browsePath);
+    if(!field)
+        return UA_STATUSCODE_BADNOTFOUND;
+    if(UA_Variant_isEmpty(field))
+        return UA_STATUSCODE_BADNODATAAVAILABLE;
+    if(sao->indexRange.length == 0)
+        return UA_Variant_copy(field, value);
+    UA_NumericRange range;
+    UA_StatusCode res = UA_NumericRange_parse(&range, sao->indexRange);
+    UA_CHECK_STATUS(res, return res);
+    res = UA_Variant_copyRange(field, value, range);
+    UA_free(range.dimensions);
+    return res;
+}
+
+void
+UA_EventFieldCache_clear(UA_EventFieldCache *cache) {
+    for(size_t i = 0; i < cache->entriesSize; i++) {
+        UA_EventFieldCacheEntry *e = &cache->entries[i];
+        UA_Array_delete(e->browsePath, e->browsePathSize,
+                        &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+        UA_NodeId_clear(&e->target);
+    }
+    UA_free(cache->entries);
+    UA_NodeId_clear(&cache->eventType);
+    memset(cache, 0, sizeof(UA_EventFieldCache));
+}
+
+static UA_EventFieldCacheEntry *
+findCachedField(UA_EventFieldCache *cache, size_t pathSize,
+                const UA_QualifiedName *path) {
+    for(size_t i = 0; i < cache->entriesSize; i++) {
+        UA_EventFieldCacheEntry *e = &cache->entries[i];
+        if(e->browsePathSize != pathSize)
+            continue;
+        size_t j = 0;
+        for(; j < pathSize; j++) {
+            if(!UA_QualifiedName_equal(&e->browsePath[j], &path[j]))
+                break;
+        }
+        if(j == pathSize)
+            return e;
+    }
+    return NULL;
+}
+
+/* Resolve the browse path of a field of a node event. Starts from the event
+ * node (and not the typeDefinitionId). The result is cached for the other
+ * MonitoredItems receiving the same event. */
+static UA_StatusCode
+resolveEventFieldNode(UA_Server *server, const UA_EventInstance *event,
+                      size_t pathSize, const UA_QualifiedName *path,
+                      UA_NodeId *target) {
+    UA_EventFieldCache *cache = event->cache;
+    if(cache) {
+        UA_EventFieldCacheEntry *e = findCachedField(cache, pathSize, path);
+        if(e) {
+            if(e->status != UA_STATUSCODE_GOOD)
+                return e->status;
+            return UA_NodeId_copy(&e->target, target);
+        }
+    }
+
+    UA_BrowsePathResult bpr =
+        browseSimplifiedBrowsePath(server, *event->eventNode, pathSize, path);
+    if(bpr.targetsSize == 0 && bpr.statusCode == UA_STATUSCODE_GOOD)
+        bpr.statusCode = UA_STATUSCODE_BADNOTFOUND;
+
+    /* Use the first match */
+    UA_StatusCode res = bpr.statusCode;
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_NodeId_copy(&bpr.targets[0].targetId.nodeId, target);
+    UA_BrowsePathResult_clear(&bpr);
+
+    /* Add to the cache. Failures are not critical and only prevent caching. */
+    if(cache && res != UA_STATUSCODE_BADOUTOFMEMORY) {
+        UA_EventFieldCacheEntry *entries = (UA_EventFieldCacheEntry*)
+            UA_realloc(cache->entries,
+                       sizeof(UA_EventFieldCacheEntry) * (cache->entriesSize + 1));
+        if(!entries)
+            return res;
+        cache->entries = entries;
+        UA_EventFieldCacheEntry *e = &entries[cache->entriesSize];
+        memset(e, 0, sizeof(UA_EventFieldCacheEntry));
+        e->status = res;
+        if(UA_Array_copy(path, pathSize, (void**)&e->browsePath,
+                         &UA_TYPES[UA_TYPES_QUALIFIEDNAME]) != UA_STATUSCODE_GOOD)
+            return res;
+        e->browsePathSize = pathSize;
+        if(res == UA_STATUSCODE_GOOD &&
+           UA_NodeId_copy(target, &e->target) != UA_STATUSCODE_GOOD) {
+            UA_Array_delete(e->browsePath, pathSize, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+            return res;
+        }
+        cache->entriesSize++;
+    }
+    return res;
+}
+
+/* Read the EventType of a node or field-map event */
+static UA_StatusCode
+readEventType(UA_Server *server, const UA_EventInstance *event, UA_Variant *out) {
+    if(!event->eventFields) {
+        UA_EventFieldCache *cache = event->cache;
+        if(!cache)
+            return readObjectProperty(server, *event->eventNode,
+                                      UA_QUALIFIEDNAME(0, "EventType"), out);
+        if(!cache->hasEventType) {
+            UA_Variant v;
+            UA_Variant_init(&v);
+            cache->eventTypeStatus =
+                readObjectProperty(server, *event->eventNode,
+                                   UA_QUALIFIEDNAME(0, "EventType"), &v);
+            if(cache->eventTypeStatus == UA_STATUSCODE_GOOD) {
+                if(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_NODEID]))
+                    cache->eventTypeStatus =
+                        UA_NodeId_copy((UA_NodeId*)v.data, &cache->eventType);
+                else
+                    cache->eventTypeStatus = UA_STATUSCODE_BADTYPEMISMATCH;
+            }
+            UA_Variant_clear(&v);
+            cache->hasEventType = true;
+        }
+        if(cache->eventTypeStatus != UA_STATUSCODE_GOOD)
+            return cache->eventTypeStatus;
+        return UA_Variant_setScalarCopy(out, &cache->eventType,
+                                        &UA_TYPES[UA_TYPES_NODEID]);
+    }
+    UA_QualifiedName name = UA_QUALIFIEDNAME(0, "EventType");
+    const UA_Variant *field = getEventField(event->eventFields, 1, &name);
+    if(!field)
+        return UA_STATUSCODE_BADNOTFOUND;
+    return UA_Variant_copy(field, out);
+}
+
 /* Part 4, 7.4.4.5 SimpleAttributeOperand: The clause can point to any attribute
  * of nodes. Either a child of the event node and also the event type. */
 static UA_StatusCode
 resolveSimpleAttributeOperand(UA_Server *server, UA_Session *session,
-                              const UA_NodeId *origin,
+                              const UA_EventInstance *event,
                               const UA_SimpleAttributeOperand *sao,
                               UA_Variant *value) {
+    if(event->eventFields)
+        return resolveEventFieldOperand(event->eventFields, sao, value);
+    const UA_NodeId *origin = event->eventNode;
+
     /* Prepare the ReadValueId */
     UA_ReadValueId rvi;
     UA_ReadValueId_init(&rvi);
@@ -503,23 +689,13 @@ resolveSimpleAttributeOperand(UA_Server *server, UA_Session *session,
 
         v = readWithSession(server, session, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
     } else {
-        /* Resolve the browse path, starting from the event-source (and not the
-         * typeDefinitionId). */
-        UA_BrowsePathResult bpr =
-            browseSimplifiedBrowsePath(server, *origin,
-                                       sao->browsePathSize, sao->browsePath);
-        if(bpr.targetsSize == 0 && bpr.statusCode == UA_STATUSCODE_GOOD)
-            bpr.statusCode = UA_STATUSCODE_BADNOTFOUND;
-        if(bpr.statusCode != UA_STATUSCODE_GOOD) {
-            UA_StatusCode res = bpr.statusCode;
-            UA_BrowsePathResult_clear(&bpr);
-            return res;
-        }
-
-        /* Use the first match */
-        rvi.nodeId = bpr.targets[0].targetId.nodeId;
+        /* Resolve the browse path to the field node */
+        UA_StatusCode res =
+            resolveEventFieldNode(server, event, sao->browsePathSize,
+                                  sao->browsePath, &rvi.nodeId);
+        UA_CHECK_STATUS(res, return res);
         v = readWithSession(server, session, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
-        UA_BrowsePathResult_clear(&bpr);
+        UA_NodeId_clear(&rvi.nodeId);
     }
 
     /* Validate the result */
@@ -562,7 +738,7 @@ resolveOperand(UA_FilterEvalContext *ctx, UA_ExtensionObject *op, UA_Variant *ou
         UA_SimpleAttributeOperand *sao =
             (UA_SimpleAttributeOperand*)op->content.decoded.data;
         return resolveSimpleAttributeOperand(ctx->server, ctx->session,
-                                             ctx->eventNode, sao, out);
+                                             ctx->event, sao, out);
     }
 
     return UA_STATUSCODE_BADFILTEROPERATORUNSUPPORTED;
@@ -598,8 +774,7 @@ ofTypeOperator(UA_FilterEvalContext *ctx, size_t index) {
     UA_Variant eventTypeVar;
     UA_Variant_init(&eventTypeVar);
     const UA_NodeId *operandTypeId = (const UA_NodeId *)op0->data;
-    res = readObjectProperty(ctx->server, *ctx->eventNode,
-                             UA_QUALIFIEDNAME(0, "EventType"), &eventTypeVar);
+    res = readEventType(ctx->server, ctx->event, &eventTypeVar);
     UA_CHECK_STATUS(res, return res);
 
     if(!UA_Variant_hasScalarType(&eventTypeVar, &UA_TYPES[UA_TYPES_NODEID])) {
@@ -922,10 +1097,11 @@ static const UA_FilterOperatorJumptableElement operatorJumptable[18] = {
     {bitwiseOrOperator, 2, 2}
 };
 
-UA_StatusCode
-evaluateWhereClause(UA_Server *server, UA_Session *session, const UA_NodeId *eventNode,
-                    const UA_ContentFilter *contentFilter,
-                    UA_ContentFilterResult *contentFilterResult) {
+static UA_StatusCode
+evaluateEventWhereClause(UA_Server *server, UA_Session *session,
+                         const UA_EventInstance *event,
+                         const UA_ContentFilter *contentFilter,
+                         UA_ContentFilterResult *contentFilterResult) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
     /* An empty filter always succeeds */
@@ -938,7 +1114,7 @@ evaluateWhereClause(UA_Server *server, UA_Session *session, const UA_NodeId *eve
     ctx.filter = contentFilter;
     ctx.server = server;
     ctx.session = session;
-    ctx.eventNode = eventNode;
+    ctx.event = event;
     ctx.top = 0;
 
     /* Pacify some compilers by initializing the first result */
@@ -969,60 +1145,134 @@ evaluateWhereClause(UA_Server *server, UA_Session *session, const UA_NodeId *eve
     return res;
 }
 
+UA_StatusCode
+evaluateWhereClause(UA_Server *server, UA_Session *session, const UA_NodeId *eventNode,
+                    const UA_ContentFilter *contentFilter,
+                    UA_ContentFilterResult *contentFilterResult) {
+    UA_EventInstance event = {eventNode, NULL, NULL};
+    return evaluateEventWhereClause(server, session, &event,
+                                    contentFilter, contentFilterResult);
+}
+
+static UA_Boolean
+isValidEventType(UA_Server *server, const UA_NodeId *validEventParent,
+                 const UA_NodeId *tEventType) {
+    /* Check whether the EventType is a Subtype of CondtionType (Part 9 first
+     * implementation) */
+    UA_NodeId conditionTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_CONDITIONTYPE);
+    if(UA_NodeId_equal(validEventParent, &conditionTypeId) &&
+       isNodeInTree_singleRef(server, tEventType, &conditionTypeId,
+                              UA_REFERENCETYPEINDEX_HASSUBTYPE))
+        return true;
+
+    /* EventType is not a Subtype of CondtionType (ConditionId Clause won't be
+     * present in Events, which are not Conditions) */
+    /* Check whether Valid Event other than Conditions */
+    UA_NodeId baseEventTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+    return isNodeInTree_singleRef(server, tEventType, &baseEventTypeId,
+                                  UA_REFERENCETYPEINDEX_HASSUBTYPE);
+}
+
 static UA_Boolean
 isValidEvent(UA_Server *server, const UA_NodeId *validEventParent,
-             const UA_NodeId *eventId) {
+             const UA_EventInstance *event) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    /* Find the eventType variableNode */
-    UA_QualifiedName findName = UA_QUALIFIEDNAME(0, "EventType");
-    UA_BrowsePathResult bpr = browseSimplifiedBrowsePath(server, *eventId, 1, &findName);
-    if(bpr.statusCode != UA_STATUSCODE_GOOD || bpr.targetsSize < 1) {
-        UA_BrowsePathResult_clear(&bpr);
-        return false;
-    }
-
-    /* Get the EventType Property Node */
+    /* Read the EventType (the value should be a NodeId) */
     UA_Variant tOutVariant;
     UA_Variant_init(&tOutVariant);
-    /* Read the Value of EventType Property Node (the Value should be a NodeId) */
-    UA_StatusCode retval = readWithReadValue(server, &bpr.targets[0].targetId.nodeId,
-                                             UA_ATTRIBUTEID_VALUE, &tOutVariant);
+    UA_StatusCode retval = readEventType(server, event, &tOutVariant);
     if(retval != UA_STATUSCODE_GOOD ||
        !UA_Variant_hasScalarType(&tOutVariant, &UA_TYPES[UA_TYPES_NODEID])) {
-        UA_BrowsePathResult_clear(&bpr);
+        UA_Variant_clear(&tOutVariant);
         return false;
     }
 
-    const UA_NodeId *tEventType = (UA_NodeId*)tOutVariant.data;
+    UA_Boolean valid = isValidEventType(server, validEventParent,
+                                        (UA_NodeId*)tOutVariant.data);
+    UA_Variant_clear(&tOutVariant);
+    return valid;
+}
 
-    /* Check whether the EventType is a Subtype of CondtionType (Part 9 first
-     * implementation) */
-    UA_NodeId conditionTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_CONDITIONTYPE);
-    if(UA_NodeId_equal(validEventParent, &conditionTypeId) &&
-       isNodeInTree_singleRef(server, tEventType, &conditionTypeId,
-                              UA_REFERENCETYPEINDEX_HASSUBTYPE)) {
-        UA_BrowsePathResult_clear(&bpr);
-        UA_Variant_clear(&tOutVariant);
-        return true;
-    }
+UA_EventFilterCompiled *
+UA_EventFilter_compile(const UA_EventFilter *filter) {
+    /* Allocate the flags behind the structure */
+    UA_EventFilterCompiled *ef = (UA_EventFilterCompiled*)
+        UA_calloc(1, sizeof(UA_EventFilterCompiled) + filter->selectClausesSize);
+    if(!ef)
+        return NULL;
+    ef->selectClausesSize = filter->selectClausesSize;
+    ef->selectClauses = (UA_Byte*)&ef[1];
 
-    /* EventType is not a Subtype of CondtionType (ConditionId Clause won't be
-     * present in Events, which are not Conditions) */
-    /* Check whether Valid Event other than Conditions */
+    /* BaseEventType clauses apply to every event */
     UA_NodeId baseEventTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
-    UA_Boolean isSubtypeOfBaseEvent =
-        isNodeInTree_singleRef(server, tEventType, &baseEventTypeId,
-                               UA_REFERENCETYPEINDEX_HASSUBTYPE);
+    for(size_t i = 0; i < filter->selectClausesSize; i++) {
+        if(!UA_NodeId_equal(&filter->selectClauses[i].typeDefinitionId,
+                            &baseEventTypeId))
+            ef->selectClauses[i] = UA_SELECTCLAUSE_TYPED;
+    }
+    return ef;
+}
 
-    UA_BrowsePathResult_clear(&bpr);
-    UA_Variant_clear(&tOutVariant);
-    return isSubtypeOfBaseEvent;
+void
+UA_EventFilterCompiled_delete(UA_EventFilterCompiled *ef) {
+    if(!ef)
+        return;
+    UA_NodeId_clear(&ef->eventType);
+    UA_free(ef);
+}
+
+void
+UA_MonitoredItem_compileEventFilter(UA_MonitoredItem *mon) {
+    UA_EventFilterCompiled_delete(mon->eventFilter);
+    mon->eventFilter = NULL;
+    if(mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER ||
+       mon->parameters.filter.content.decoded.type != &UA_TYPES[UA_TYPES_EVENTFILTER])
+        return;
+    mon->eventFilter = UA_EventFilter_compile((const UA_EventFilter*)
+                                              mon->parameters.filter.content.decoded.data);
+}
+
+/* Recompute the applicability of the typed select clauses if the EventType
+ * differs from the last event */
+static void
+updateCompiledEventType(UA_Server *server, const UA_EventFilter *filter,
+                        UA_EventFilterCompiled *ef, const UA_EventInstance *event) {
+    UA_Variant v;
+    UA_Variant_init(&v);
+    UA_StatusCode res = readEventType(server, event, &v);
+    const UA_NodeId *eventType = NULL;
+    if(res == UA_STATUSCODE_GOOD &&
+       UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_NODEID]))
+        eventType = (const UA_NodeId*)v.data;
+
+    if(eventType && UA_NodeId_equal(eventType, &ef->eventType)) {
+        UA_Variant_clear(&v);
+        return;
+    }
+
+    /* Cache the EventType. An invalid EventType is cached as the null
+     * NodeId. */
+    UA_NodeId_clear(&ef->eventType);
+    if(eventType)
+        UA_NodeId_copy(eventType, &ef->eventType);
+    for(size_t i = 0; i < ef->selectClausesSize; i++) {
+        UA_Byte *flags = &ef->selectClauses[i];
+        *flags &= (UA_Byte)~UA_SELECTCLAUSE_VALID;
+        if(!(*flags & UA_SELECTCLAUSE_TYPED))
+            continue;
+        if(eventType &&
+           isValidEventType(server, &filter->selectClauses[i].typeDefinitionId,
+                            eventType))
+            *flags |= UA_SELECTCLAUSE_VALID;
+    }
+    UA_Variant_clear(&v);
 }
 
 UA_StatusCode
 filterEvent(UA_Server *server, UA_Session *session,
-            const UA_NodeId *eventNode, UA_EventFilter *filter,
+            const UA_EventInstance *event, UA_EventFilter *filter,
+            UA_EventFilterCompiled *compiled,
             UA_EventFieldList *efl, UA_EventFilterResult *result) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
@@ -1075,23 +1325,36 @@ filterEvent(UA_Server *server, UA_Session *session,
     }
 
     /* Evaluate the where filter. Do we event need to consider the event? */
-    UA_StatusCode res = evaluateWhereClause(server, session, eventNode,
-                                            &filter->whereClause,
-                                            &result->whereClauseResult);
+    UA_StatusCode res = evaluateEventWhereClause(server, session, event,
+                                                 &filter->whereClause,
+                                                 &result->whereClauseResult);
     if(res != UA_STATUSCODE_GOOD){
         UA_EventFieldList_clear(efl);
         UA_EventFilterResult_clear(result);
         return res;
     }
 
+    /* The compiled filter must match the select clauses */
+    if(compiled && compiled->selectClausesSize != filter->selectClausesSize)
+        compiled = NULL;
+    if(compiled)
+        updateCompiledEventType(server, filter, compiled, event);
+
     /* Apply the select filter */
     UA_NodeId baseEventTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
     for(size_t i = 0; i < filter->selectClausesSize; i++) {
         UA_SimpleAttributeOperand *sc = &filter->selectClauses[i];
         /* Check if the browsePath is BaseEventType, in which case nothing more
          * needs to be checked */
-        if(!UA_NodeId_equal(&sc->typeDefinitionId, &baseEventTypeId) &&
-           !isValidEvent(server, &sc->typeDefinitionId, eventNode)) {
+        UA_Boolean valid;
+        if(compiled) {
+            UA_Byte flags = compiled->selectClauses[i];
+            valid = !(flags & UA_SELECTCLAUSE_TYPED) || (flags & UA_SELECTCLAUSE_VALID);
+        } else {
+            valid = UA_NodeId_equal(&sc->typeDefinitionId, &baseEventTypeId) ||
+                isValidEvent(server, &sc->typeDefinitionId, event);
+        }
+        if(!valid) {
             UA_Variant_init(&efl->eventFields[i]);
             /* EventFilterResult currently isn't being used
                notification->result.selectClauseResults[i] =
@@ -1102,7 +1365,7 @@ filterEvent(UA_Server *server, UA_Session *session,
         /* Lookup the field. The overall filter can succeed even if a single
          * select-field cannot be resolved. */
         result->selectClauseResults[i] =
-            resolveSimpleAttributeOperand(server, session, eventNode,
+            resolveSimpleAttributeOperand(server, session, event,
                                           sc, &efl->eventFields[i]);
     }
 
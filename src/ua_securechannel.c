@@ -29,6 +29,9 @@ UA_SecureChannel_init(UA_SecureChannel *channel) {
     /* Normal linked lists are initialized by zeroing out */
     memset(channel, 0, sizeof(UA_SecureChannel));
     TAILQ_INIT(&channel->chunks);
+#if UA_MULTITHREADING >= 100
+    SIMPLEQ_INIT(&channel->serviceJobs);
+#endif
 }
 
 UA_StatusCode
@@ -198,6 +201,9 @@ UA_SecureChannel_clear(UA_SecureChannel *channel) {
     /* Clean up endpointUrl */
     UA_String_clear(&channel->endpointUrl);
 
+    /* Release the memory for decoded requests */
+    UA_Arena_clear(&channel->requestArena);
+
     /* Delete remaining chunks */
     UA_SecureChannel_deleteBuffered(channel);
 
@@ -400,8 +406,10 @@ sendSymmetricChunk(UA_MessageContext *mc) {
                          (long unsigned int)
                          ((uintptr_t)mc->buf_pos - (uintptr_t)mc->messageBuffer.data));
 
-    /* Add padding if the message is encrypted */
-    if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT)
+    /* Add padding if the message is encrypted. Authenticated encryption
+     * operates on a stream and needs no padding. */
+    if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT &&
+       !sp->symmetricModule.encryptAuthenticated)
         padChunk(channel, &sp->symmetricModule.cryptoModule,
                  &mc->messageBuffer.data[UA_SECURECHANNEL_SYMMETRIC_HEADER_UNENCRYPTEDLENGTH],
                  &mc->buf_pos);
@@ -524,6 +532,30 @@ UA_MessageContext_encode(UA_MessageContext *mc, const void *content,
     return res;
 }
 
+UA_StatusCode
+UA_MessageContext_encodeBuffer(UA_MessageContext *mc, const UA_ByteString *buf) {
+    size_t pos = 0;
+    while(pos < buf->length) {
+        /* Send out the full chunk and continue with a fresh buffer */
+        if(mc->buf_pos == mc->buf_end) {
+            UA_StatusCode res =
+                sendSymmetricEncodingCallback(mc, &mc->buf_pos, &mc->buf_end);
+            if(res != UA_STATUSCODE_GOOD) {
+                if(mc->messageBuffer.length > 0)
+                    UA_MessageContext_abort(mc);
+                return res;
+            }
+        }
+        size_t len = (uintptr_t)mc->buf_end - (uintptr_t)mc->buf_pos;
+        if(len > buf->length - pos)
+            len = buf->length - pos;
+        memcpy(mc->buf_pos, &buf->data[pos], len);
+        mc->buf_pos += len;
+        pos += len;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_MessageContext_finish(UA_MessageContext *mc) {
     mc->final = true;
@@ -693,9 +725,14 @@ unpackPayloadMSG(UA_SecureChannel *channel, UA_Chunk *chunk,
     UA_CHECK_STATUS(res, return res);
 
     /* Decrypt the chunk payload */
-    res = decryptAndVerifyChunk(channel,
-                                &channel->securityPolicy->symmetricModule.cryptoModule,
-                                chunk->messageType, &chunk->bytes, offset);
+    const UA_SecurityPolicySymmetricModule *sm =
+        &channel->securityPolicy->symmetricModule;
+    if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT &&
+       sm->decryptAuthenticated)
+        res = decryptAuthenticatedChunk(channel, &chunk->bytes, offset);
+    else
+        res = decryptAndVerifyChunk(channel, &sm->cryptoModule,
+                                    chunk->messageType, &chunk->bytes, offset);
     UA_CHECK_STATUS(res, return res);
 
     /* Check the sequence number. Skip sequence number checking for fuzzer to
@@ -964,6 +1001,31 @@ UA_SecureChannel_getCompleteMessage(UA_SecureChannel *channel,
     return UA_STATUSCODE_GOOD;
 }
 
+UA_Boolean
+UA_SecureChannel_onlySymmetricChunks(const UA_SecureChannel *channel) {
+    size_t offset = channel->unprocessedOffset;
+    while(channel->unprocessed.length - offset >= UA_SECURECHANNEL_MESSAGEHEADER_LENGTH) {
+        /* Decoding the header cannot fail */
+        UA_TcpMessageHeader hdr;
+        size_t pos = offset;
+        UA_StatusCode res =
+            UA_decodeBinaryInternal(&channel->unprocessed, &pos, &hdr,
+                                    &UA_TRANSPORT[UA_TRANSPORT_TCPMESSAGEHEADER], NULL);
+        UA_assert(res == UA_STATUSCODE_GOOD);
+        (void)res;
+        UA_MessageType msgType = (UA_MessageType)
+            (hdr.messageTypeAndChunkType & UA_BITMASK_MESSAGETYPE);
+        if(msgType != UA_MESSAGETYPE_MSG && msgType != UA_MESSAGETYPE_CLO)
+            return false;
+        /* Invalid or incomplete chunks are rejected during the extraction */
+        if(hdr.messageSize < UA_SECURECHANNEL_MESSAGE_MIN_LENGTH ||
+           hdr.messageSize > channel->unprocessed.length - offset)
+            break;
+        offset += hdr.messageSize;
+    }
+    return true;
+}
+
 UA_StatusCode
 UA_SecureChannel_persistBuffer(UA_SecureChannel *channel) {
     UA_StatusCode res = UA_STATUSCODE_GOOD;
@@ -31,6 +31,11 @@ typedef struct UA_SecureChannel UA_SecureChannel;
 struct UA_Session;
 typedef struct UA_Session UA_Session;
 
+/* Forward-Declaration for the queue of requests that are processed by the
+ * server worker threads */
+struct UA_ServiceJob;
+typedef struct UA_ServiceJob UA_ServiceJob;
+
 /* The message header of the OPC UA binary protocol is structured as follows:
  *
  * - MessageType (3 Byte)
@@ -147,6 +152,18 @@ struct UA_SecureChannel {
      * used in the server) */
     UA_Session *sessions;
 
+#if UA_MULTITHREADING >= 100
+    /* Requests waiting for the server worker threads. The first entry is
+     * currently being processed. The responses are sent in this order. (Only
+     * used in the server) */
+    SIMPLEQ_HEAD(, UA_ServiceJob) serviceJobs;
+#endif
+
+    /* Decoded MSG requests are allocated in the arena. It is reset after the
+     * response is sent. The requests of a channel are processed one after the
+     * other. (Only used in the server) */
+    UA_Arena requestArena;
+
     /* (Decrypted) chunks waiting to be processed */
     UA_ChunkQueue chunks;
     size_t chunksCount;
@@ -261,6 +278,10 @@ UA_StatusCode
 UA_MessageContext_encode(UA_MessageContext *mc, const void *content,
                          const UA_DataType *contentType);
 
+/* Same as _encode, but appends content that is already binary-encoded */
+UA_StatusCode
+UA_MessageContext_encodeBuffer(UA_MessageContext *mc, const UA_ByteString *buf);
+
 /* Sends a symmetric message already encoded in the context. The context is
  * cleaned up, also in case of errors. */
 UA_StatusCode
@@ -299,6 +320,12 @@ UA_SecureChannel_getCompleteMessage(UA_SecureChannel *channel,
 UA_StatusCode
 UA_SecureChannel_persistBuffer(UA_SecureChannel *channel);
 
+/* All complete chunks in the buffer are MSG or CLO chunks. They are decrypted
+ * with the symmetric keys of the channel only. Other chunks (e.g. OPN) also
+ * access the SecurityPolicy and the certificate verification. */
+UA_Boolean
+UA_SecureChannel_onlySymmetricChunks(const UA_SecureChannel *channel);
+
 /* Internal methods in ua_securechannel_crypto.h */
 
 void
@@ -317,6 +344,14 @@ decryptAndVerifyChunk(const UA_SecureChannel *channel,
                       UA_MessageType messageType, UA_ByteString *chunk,
                       size_t offset);
 
+/* Decrypt and authenticate a symmetric chunk with the single-pass
+ * authenticated encryption of the SecurityPolicy. Everything before the offset
+ * is authenticated as additional data. The chunk length is reduced by the
+ * authentication tag. */
+UA_StatusCode
+decryptAuthenticatedChunk(const UA_SecureChannel *channel, UA_ByteString *chunk,
+                          size_t offset);
+
 size_t
 calculateAsymAlgSecurityHeaderLength(const UA_SecureChannel *channel);
 
@@ -314,8 +314,23 @@ signAndEncryptSym(UA_MessageContext *messageContext,
     if(channel->securityMode == UA_MESSAGESECURITYMODE_NONE)
         return UA_STATUSCODE_GOOD;
 
-    /* Sign */
+    /* Single-pass authenticated encryption. The headers up to the
+     * SequenceHeader are authenticated but remain unencrypted. The tag is
+     * written in place of the signature. */
     const UA_SecurityPolicy *sp = channel->securityPolicy;
+    if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT &&
+       sp->symmetricModule.encryptAuthenticated) {
+        const size_t aadLength = UA_SECURECHANNEL_CHANNELHEADER_LENGTH +
+            UA_SECURECHANNEL_SYMMETRIC_SECURITYHEADER_LENGTH;
+        const UA_ByteString aad = {aadLength, messageContext->messageBuffer.data};
+        UA_ByteString data = {preSigLength - aadLength,
+                              messageContext->messageBuffer.data + aadLength};
+        UA_ByteString tag = {totalLength - preSigLength, messageContext->buf_pos};
+        return sp->symmetricModule.
+            encryptAuthenticated(channel->channelContext, &aad, &data, &tag);
+    }
+
+    /* Sign */
     UA_ByteString dataToSign = messageContext->messageBuffer;
     dataToSign.length = preSigLength;
     UA_ByteString signature;
@@ -356,6 +371,14 @@ setBufPos(UA_MessageContext *mc) {
     const UA_SecurityPolicy *sp = channel->securityPolicy;
     size_t sigsize = sp->symmetricModule.cryptoModule.signatureAlgorithm.
         getLocalSignatureSize(channel->channelContext);
+
+    /* Authenticated encryption does not pad and has no block alignment. Only
+     * leave space for the tag (or the signature in Sign mode). */
+    if(sp->symmetricModule.encryptAuthenticated) {
+        mc->buf_end -= sigsize;
+        return;
+    }
+
     size_t plainBlockSize = sp->symmetricModule.cryptoModule.
         encryptionAlgorithm.getRemotePlainTextBlockSize(channel->channelContext);
 
@@ -422,6 +445,38 @@ verifySignature(const UA_SecureChannel *channel,
     return retval;
 }
 
+/* Decrypts the chunk after the offset in-place and verifies the AEAD tag over
+ * the message header (additional data) and the payload. The tag is hidden
+ * from the chunk afterwards. */
+UA_StatusCode
+decryptAuthenticatedChunk(const UA_SecureChannel *channel, UA_ByteString *chunk,
+                          size_t offset) {
+    const UA_SecurityPolicy *sp = channel->securityPolicy;
+    size_t tagsize = sp->symmetricModule.cryptoModule.signatureAlgorithm.
+        getRemoteSignatureSize(channel->channelContext);
+
+    /* The encrypted payload has to be at least 9 bytes long: 8 byte for the
+     * SequenceHeader and one byte for the actual message */
+    UA_CHECK(offset + tagsize + 9 < chunk->length,
+             UA_LOG_WARNING_CHANNEL(sp->logger, channel,
+                                    "Chunk too short for authenticated decryption");
+             return UA_STATUSCODE_BADSECURITYCHECKSFAILED);
+
+    const UA_ByteString aad = {offset, chunk->data};
+    UA_ByteString data = {chunk->length - offset - tagsize, chunk->data + offset};
+    const UA_ByteString tag = {tagsize, chunk->data + chunk->length - tagsize};
+    UA_StatusCode res = sp->symmetricModule.
+        decryptAuthenticated(channel->channelContext, &aad, &data, &tag);
+    UA_CHECK_STATUS(res,
+       UA_LOG_WARNING_CHANNEL(sp->logger, channel,
+                              "Could not decrypt and authenticate the chunk");
+       return res);
+
+    /* Hide the tag */
+    chunk->length -= tagsize;
+    return UA_STATUSCODE_GOOD;
+}
+
 /* Sets the payload to a pointer inside the chunk buffer. Returns the requestId
  * and the sequenceNumber */
 UA_StatusCode
@@ -492,23 +492,58 @@ UA_NodeId_order(const UA_NodeId *n1, const UA_NodeId *n2) {
     return nodeIdOrder(n1, n2, NULL);
 }
 
-/* sdbm-hash (http://www.cse.yorku.ca/~oz/hash.html) */
+/* Hashing in the style of wyhash (https://github.com/wangyi-fudan/wyhash).
+ * The input is consumed in 8-byte words. Every word is mixed into the state by
+ * a 64x64->128 bit multiplication whose halves are folded with xor. */
+#define UA_HASH_SECRET0 0xa0761d6478bd642fULL
+#define UA_HASH_SECRET1 0xe7037ed1a0b428dbULL
+#define UA_HASH_SECRET2 0x8ebc6af09c88c6e3ULL
+
+static u64
+hashMum(u64 a, u64 b) {
+    /* Portable 64x64->128 bit multiplication */
+    u64 ha = a >> 32, hb = b >> 32, la = (u32)a, lb = (u32)b;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    u64 t = rl + (rm0 << 32);
+    u64 c = (t < rl);
+    u64 lo = t + (rm1 << 32);
+    c += (lo < t);
+    u64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    return hi ^ lo;
+}
+
+static u32
+hashFinish(u64 h) {
+    return (u32)(h ^ (h >> 32));
+}
+
 u32
 UA_ByteString_hash(u32 initialHashValue,
                    const u8 *data, size_t size) {
-    u32 h = initialHashValue;
-    for(size_t i = 0; i < size; i++)
-        h = data[i] + (h << 6) + (h << 16) - h;
-    return h;
+    u64 h = hashMum(initialHashValue ^ UA_HASH_SECRET0,
+                    (u64)size ^ UA_HASH_SECRET1);
+    u64 v;
+    for(; size >= 8; size -= 8, data += 8) {
+        memcpy(&v, data, 8);
+        h = hashMum(h ^ v, UA_HASH_SECRET2);
+    }
+    if(size > 0) {
+        v = 0;
+        memcpy(&v, data, size);
+        h = hashMum(h ^ v, UA_HASH_SECRET2);
+    }
+    return hashFinish(h);
 }
 
 u32
 UA_NodeId_hash(const UA_NodeId *n) {
     switch(n->identifierType) {
     case UA_NODEIDTYPE_NUMERIC:
-    default:
-        return UA_ByteString_hash(n->namespaceIndex, (const u8*)&n->identifier.numeric,
-                                  sizeof(UA_UInt32));
+    default: {
+        /* Fast path. The NodeId fits into a single word. */
+        u64 v = ((u64)n->namespaceIndex << 32) | n->identifier.numeric;
+        return hashFinish(hashMum(v ^ UA_HASH_SECRET0, UA_HASH_SECRET1));
+    }
     case UA_NODEIDTYPE_STRING:
     case UA_NODEIDTYPE_BYTESTRING:
         return UA_ByteString_hash(n->namespaceIndex, n->identifier.string.data,
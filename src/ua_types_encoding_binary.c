@@ -557,7 +557,29 @@ FUNC_ENCODE_BINARY(String) {
     return Array_encodeBinary(ctx, src->data, src->length, &UA_TYPES[UA_TYPES_BYTE]);
 }
 
+/* Point into the input buffer instead of copying */
+static status
+String_borrowBinary(Ctx *ctx, UA_String *dst) {
+    i32 signed_length;
+    status ret = DECODE_DIRECT(&signed_length, UInt32); /* Int32 */
+    UA_CHECK_STATUS(ret, return ret);
+    if(signed_length <= 0) {
+        dst->length = 0;
+        dst->data = (signed_length < 0) ? NULL : (u8*)UA_EMPTY_ARRAY_SENTINEL;
+        return UA_STATUSCODE_GOOD;
+    }
+    size_t length = (size_t)signed_length;
+    UA_CHECK(length <= (size_t)(ctx->end - ctx->pos),
+             return UA_STATUSCODE_BADDECODINGERROR);
+    dst->data = ctx->pos;
+    dst->length = length;
+    ctx->pos += length;
+    return UA_STATUSCODE_GOOD;
+}
+
 FUNC_DECODE_BINARY(String) {
+    if(ctx->opts.borrowStrings && ctx->opts.calloc)
+        return String_borrowBinary(ctx, dst);
     return Array_decodeBinary(ctx, (void**)&dst->data, &dst->length, &UA_TYPES[UA_TYPES_BYTE]);
 }
 
@@ -769,7 +791,7 @@ FUNC_DECODE_BINARY(ExpandedNodeId) {
                                               dst->namespaceUri,
                                               &dst->nodeId.namespaceIndex);
             if(foundNsUri == UA_STATUSCODE_GOOD)
-                UA_String_clear(&dst->namespaceUri);
+                ctxClear(ctx, &dst->namespaceUri, &UA_TYPES[UA_TYPES_STRING]);
         }
     }
 
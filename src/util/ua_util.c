@@ -1283,6 +1283,96 @@ UA_ReadValueId_print(const UA_ReadValueId *rvi, UA_String *out) {
 
 #endif
 
+/*********/
+/* Arena */
+/*********/
+
+/* Allocations are aligned for the largest builtin type */
+#define UA_ARENA_ALIGN 16
+#define UA_ARENA_ROUNDUP(x) (((x) + (UA_ARENA_ALIGN - 1)) & ~(size_t)(UA_ARENA_ALIGN - 1))
+
+struct UA_ArenaBlock {
+    UA_ArenaBlock *next;
+    size_t size; /* Usable bytes after the header */
+    size_t used;
+};
+
+#define UA_ARENA_HEADER UA_ARENA_ROUNDUP(sizeof(UA_ArenaBlock))
+
+void *
+UA_Arena_calloc(void *arenaContext, size_t nelem, size_t elsize) {
+    UA_Arena *arena = (UA_Arena*)arenaContext;
+    if(elsize > 0 && nelem > (SIZE_MAX / 2) / elsize)
+        return NULL;
+    size_t size = UA_ARENA_ROUNDUP(nelem * elsize);
+
+    /* Allocate from the current block */
+    UA_ArenaBlock *b = arena->blocks;
+    if(b && b->size - b->used >= size) {
+        UA_Byte *p = (UA_Byte*)b + UA_ARENA_HEADER + b->used;
+        b->used += size;
+        memset(p, 0, size);
+        return p;
+    }
+
+    /* Large allocations get a dedicated block behind the current block. So the
+     * remaining space in the current block is not lost. */
+    if(size > UA_ARENA_BLOCKSIZE / 4) {
+        UA_ArenaBlock *lb = (UA_ArenaBlock*)UA_calloc(1, UA_ARENA_HEADER + size);
+        if(!lb)
+            return NULL;
+        lb->size = size;
+        lb->used = size;
+        if(b) {
+            lb->next = b->next;
+            b->next = lb;
+        } else {
+            arena->blocks = lb;
+        }
+        return (UA_Byte*)lb + UA_ARENA_HEADER;
+    }
+
+    /* Start a new block */
+    UA_ArenaBlock *nb = (UA_ArenaBlock*)UA_malloc(UA_ARENA_HEADER + UA_ARENA_BLOCKSIZE);
+    if(!nb)
+        return NULL;
+    nb->next = b;
+    nb->size = UA_ARENA_BLOCKSIZE;
+    nb->used = size;
+    arena->blocks = nb;
+    UA_Byte *p = (UA_Byte*)nb + UA_ARENA_HEADER;
+    memset(p, 0, size);
+    return p;
+}
+
+void
+UA_Arena_reset(UA_Arena *arena) {
+    /* Keep the current block if it has the default size */
+    UA_ArenaBlock *keep = arena->blocks;
+    UA_ArenaBlock *b = NULL;
+    if(keep && keep->size == UA_ARENA_BLOCKSIZE) {
+        b = keep->next;
+        keep->next = NULL;
+        keep->used = 0;
+    } else {
+        b = keep;
+        keep = NULL;
+    }
+    while(b) {
+        UA_ArenaBlock *next = b->next;
+        UA_free(b);
+        b = next;
+    }
+    arena->blocks = keep;
+}
+
+void
+UA_Arena_clear(UA_Arena *arena) {
+    UA_Arena_reset(arena);
+    UA_free(arena->blocks);
+    arena->blocks = NULL;
+}
+
 /************************/
 /* Cryptography Helpers */
 /************************/
@@ -272,6 +272,29 @@ UA_dump_hex_pkg(UA_Byte* buffer, size_t bufferLen);
  * certificates */
 UA_ByteString getLeafCertificate(UA_ByteString chain);
 
+/* Arena for short-lived allocations that are released all at once. Memory is
+ * taken from a list of blocks. The first block is kept when the arena is reset
+ * for the next use. A zeroed-out arena is initialized with the default block
+ * size. UA_Arena_calloc matches the calloc override of the binary decoding
+ * (see UA_DecodeBinaryOptions). */
+#define UA_ARENA_BLOCKSIZE 16384
+
+typedef struct UA_ArenaBlock UA_ArenaBlock;
+
+typedef struct {
+    UA_ArenaBlock *blocks; /* The first block is the current one */
+} UA_Arena;
+
+void *
+UA_Arena_calloc(void *arena, size_t nelem, size_t elsize);
+
+/* Release all memory except for the first block */
+void
+UA_Arena_reset(UA_Arena *arena);
+
+void
+UA_Arena_clear(UA_Arena *arena);
+
 /* Unions that represent any of the supported request or response message */
 typedef union {
     UA_RequestHeader requestHeader;
@@ -7,6 +7,8 @@
 #include "open62541/types.h"
 #include "open62541/types_generated.h"
 
+#include "../arch/posix/eventloop_posix.h"
+
 #include "testing_clock.h"
 #include <time.h>
 #include <stdlib.h>
@@ -17,6 +19,7 @@ static unsigned connCount;
 static char *testMsg = "open62541";
 static uintptr_t clientId;
 static UA_Boolean received;
+static size_t receivedBytes;
 
 static void
 connectionCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
@@ -180,11 +183,364 @@ START_TEST(connectTCP) {
     el = NULL;
 } END_TEST
 
+/* Counts the received bytes instead of checking the content */
+static void
+countingCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                 void *application, void **connectionContext,
+                 UA_ConnectionState status,
+                 const UA_KeyValueMap *params,
+                 UA_ByteString msg) {
+    if(*connectionContext != NULL)
+        clientId = connectionId;
+    if(msg.length == 0 && status == UA_CONNECTIONSTATE_ESTABLISHED)
+        connCount++;
+    if(status == UA_CONNECTIONSTATE_CLOSING)
+        connCount--;
+    receivedBytes += msg.length;
+}
+
+static UA_ConnectionManager *
+openTestConnections(UA_UInt32 sendBacklog, size_t *listenSockets) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    UA_KeyValueMap_setScalar(&cm->eventSource.params,
+                             UA_QUALIFIEDNAME(0, "send-backlog"),
+                             &sendBacklog, &UA_TYPES[UA_TYPES_UINT32]);
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+
+    UA_UInt16 port = 4840;
+    UA_Boolean listen = true;
+    UA_String host = UA_STRING("localhost");
+
+    UA_KeyValuePair params[3];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+
+    UA_KeyValueMap paramsMap;
+    paramsMap.map = params;
+    paramsMap.mapSize = 3;
+
+    connCount = 0;
+    receivedBytes = 0;
+    cm->openConnection(cm, &paramsMap, NULL, NULL, countingCallback);
+    *listenSockets = connCount;
+
+    clientId = 0;
+    listen = false;
+    UA_StatusCode retval =
+        cm->openConnection(cm, &paramsMap, NULL, (void*)0x01, countingCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert(clientId != 0);
+    ck_assert_uint_eq(connCount, *listenSockets + 2);
+    return cm;
+}
+
+static void
+stopEventLoop(void) {
+    int max_stop_iteration_count = 10;
+    int iteration = 0;
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED &&
+          iteration < max_stop_iteration_count) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+        iteration++;
+    }
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    el->free(el);
+    el = NULL;
+}
+
+#define LARGE_MESSAGE_SIZE (1u << 20)
+#define LARGE_MESSAGE_COUNT 16
+
+/* Sending more than fits into the socket buffers does not block. The data is
+ * queued and sent out from the EventLoop. */
+START_TEST(sendQueuedTCP) {
+    size_t listenSockets = 0;
+    UA_ConnectionManager *cm = openTestConnections(0, &listenSockets);
+
+    for(size_t i = 0; i < LARGE_MESSAGE_COUNT; i++) {
+        UA_ByteString snd;
+        UA_StatusCode retval =
+            cm->allocNetworkBuffer(cm, clientId, &snd, LARGE_MESSAGE_SIZE);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        memset(snd.data, (int)i, snd.length);
+        retval = cm->sendWithConnection(cm, clientId, NULL, &snd);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    size_t total = LARGE_MESSAGE_SIZE * LARGE_MESSAGE_COUNT;
+    for(size_t i = 0; i < 10000 && receivedBytes < total; i++)
+        el->run(el, 1);
+    ck_assert_uint_eq(receivedBytes, total);
+    ck_assert_uint_eq(connCount, listenSockets + 2);
+
+    stopEventLoop();
+} END_TEST
+
+/* A peer that does not receive is closed when the backlog limit is hit */
+START_TEST(sendBacklogTCP) {
+    size_t listenSockets = 0;
+    UA_ConnectionManager *cm = openTestConnections(1u << 16, &listenSockets);
+
+    /* Don't run the EventLoop in between, so the peer does not receive */
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < 64 && retval == UA_STATUSCODE_GOOD; i++) {
+        UA_ByteString snd;
+        retval = cm->allocNetworkBuffer(cm, clientId, &snd, LARGE_MESSAGE_SIZE);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        memset(snd.data, 0, snd.length);
+        retval = cm->sendWithConnection(cm, clientId, NULL, &snd);
+    }
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADCONNECTIONCLOSED);
+
+    /* The connection is closed */
+    for(size_t i = 0; i < 100 && connCount > listenSockets; i++)
+        el->run(el, 1);
+    ck_assert_uint_eq(connCount, listenSockets);
+
+    stopEventLoop();
+} END_TEST
+
+#if UA_MULTITHREADING >= 100 && defined(__linux__)
+
+#define REACTOR_THREADS 3
+#define REACTOR_CLIENTS 16
+
+static uintptr_t reactorClients[REACTOR_CLIENTS];
+static size_t reactorClientsSize;
+static pthread_t reactorThreads[REACTOR_THREADS + 1];
+static size_t reactorThreadsSize;
+
+/* Remember the client connections and the threads where they are opened. The
+ * reactor threads call without the EventLoop lock. So take it here. */
+static void
+reactorCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                void *application, void **connectionContext,
+                UA_ConnectionState status,
+                const UA_KeyValueMap *params,
+                UA_ByteString msg) {
+    el->lock(el);
+    if(*connectionContext != NULL && msg.length == 0 &&
+       status == UA_CONNECTIONSTATE_ESTABLISHED) {
+        ck_assert_uint_lt(reactorClientsSize, REACTOR_CLIENTS);
+        reactorClients[reactorClientsSize++] = connectionId;
+        pthread_t self = pthread_self();
+        size_t i = 0;
+        for(; i < reactorThreadsSize; i++) {
+            if(pthread_equal(reactorThreads[i], self))
+                break;
+        }
+        if(i == reactorThreadsSize) {
+            ck_assert_uint_lt(reactorThreadsSize, REACTOR_THREADS + 1);
+            reactorThreads[reactorThreadsSize++] = self;
+        }
+    }
+    countingCallback(cm, connectionId, application, connectionContext,
+                     status, params, msg);
+    el->unlock(el);
+}
+
+/* Connections are spread over the reactor threads. The listen sockets are
+ * shared with SO_REUSEPORT. */
+START_TEST(reactorsTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_UInt16 reactors = REACTOR_THREADS;
+    UA_KeyValueMap_setScalar(&el->params, UA_QUALIFIEDNAME(0, "reactor-threads"),
+                             &reactors, &UA_TYPES[UA_TYPES_UINT16]);
+    el->registerEventSource(el, &cm->eventSource);
+    UA_StatusCode retval = el->start(el);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_UInt16 port = 4840;
+    UA_Boolean listen = true;
+    UA_String host = UA_STRING("localhost");
+
+    UA_KeyValuePair params[3];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+
+    UA_KeyValueMap paramsMap;
+    paramsMap.map = params;
+    paramsMap.mapSize = 3;
+
+    connCount = 0;
+    receivedBytes = 0;
+    reactorClientsSize = 0;
+    reactorThreadsSize = 0;
+    retval = cm->openConnection(cm, &paramsMap, NULL, NULL, reactorCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* One listen socket per reactor and address */
+    el->lock(el);
+    size_t listenSockets = connCount;
+    el->unlock(el);
+    ck_assert_uint_eq(listenSockets % (REACTOR_THREADS + 1), 0);
+
+    /* Open the client connections */
+    listen = false;
+    for(size_t i = 0; i < REACTOR_CLIENTS; i++) {
+        retval = cm->openConnection(cm, &paramsMap, NULL, (void*)0x01, reactorCallback);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    for(size_t i = 0; i < 1000; i++) {
+        el->lock(el);
+        UA_Boolean done = (connCount == listenSockets + 2 * REACTOR_CLIENTS &&
+                           reactorClientsSize == REACTOR_CLIENTS);
+        el->unlock(el);
+        if(done)
+            break;
+        el->run(el, 1);
+    }
+    el->lock(el);
+    ck_assert_uint_eq(reactorClientsSize, REACTOR_CLIENTS);
+    ck_assert_uint_eq(connCount, listenSockets + 2 * REACTOR_CLIENTS);
+    ck_assert_uint_eq(reactorThreadsSize, REACTOR_THREADS + 1);
+    el->unlock(el);
+
+    /* Send from every client */
+    for(size_t i = 0; i < REACTOR_CLIENTS; i++) {
+        UA_ByteString snd;
+        retval = cm->allocNetworkBuffer(cm, reactorClients[i], &snd, strlen(testMsg));
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        memcpy(snd.data, testMsg, strlen(testMsg));
+        retval = cm->sendWithConnection(cm, reactorClients[i], NULL, &snd);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    size_t total = REACTOR_CLIENTS * strlen(testMsg);
+    for(size_t i = 0; i < 1000; i++) {
+        el->lock(el);
+        UA_Boolean done = (receivedBytes == total);
+        el->unlock(el);
+        if(done)
+            break;
+        el->run(el, 1);
+    }
+    el->lock(el);
+    ck_assert_uint_eq(receivedBytes, total);
+    el->unlock(el);
+
+    /* Closing happens in the reactor threads */
+    for(size_t i = 0; i < REACTOR_CLIENTS; i++) {
+        retval = cm->closeConnection(cm, reactorClients[i]);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    for(size_t i = 0; i < 1000; i++) {
+        el->lock(el);
+        UA_Boolean done = (connCount == listenSockets);
+        el->unlock(el);
+        if(done)
+            break;
+        el->run(el, 1);
+    }
+    ck_assert_uint_eq(connCount, listenSockets);
+
+    /* Stop the EventLoop and join the reactor threads */
+    el->stop(el);
+    for(size_t i = 0; i < 1000 && el->state != UA_EVENTLOOPSTATE_STOPPED; i++)
+        el->run(el, 1);
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    ck_assert_uint_eq(connCount, 0);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+
+static size_t reactorTimerCount;
+static UA_Boolean reactorTimerThread;
+
+static void
+reactorTimerCallback(void *application, void *data) {
+    pthread_t *mainThread = (pthread_t*)data;
+    el->lock(el);
+    reactorTimerCount++;
+    reactorTimerThread = !pthread_equal(*mainThread, pthread_self());
+    el->unlock(el);
+}
+
+/* The timer of a reactor is processed in the reactor thread */
+START_TEST(reactorTimer) {
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_UInt16 reactors = 2;
+    UA_KeyValueMap_setScalar(&el->params, UA_QUALIFIEDNAME(0, "reactor-threads"),
+                             &reactors, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_StatusCode retval = el->start(el);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    reactorTimerCount = 0;
+    reactorTimerThread = false;
+    pthread_t mainThread = pthread_self();
+    UA_EventLoopPOSIX *pel = (UA_EventLoopPOSIX*)el;
+    ck_assert_uint_eq(UA_EventLoopPOSIX_reactorsSize(pel), 3);
+    UA_UInt64 id = 0;
+    retval = UA_EventLoopPOSIX_addReactorTimer(pel, 2, reactorTimerCallback,
+                                               NULL, &mainThread, 5.0, NULL,
+                                               UA_TIMERPOLICY_CURRENTTIME, &id);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The reactor does not exist */
+    UA_UInt64 id2 = 0;
+    retval = UA_EventLoopPOSIX_addReactorTimer(pel, 3, reactorTimerCallback,
+                                               NULL, &mainThread, 5.0, NULL,
+                                               UA_TIMERPOLICY_CURRENTTIME, &id2);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADINTERNALERROR);
+
+    for(size_t i = 0; i < 1000; i++) {
+        el->lock(el);
+        UA_Boolean done = (reactorTimerCount >= 3);
+        el->unlock(el);
+        if(done)
+            break;
+        el->run(el, 1);
+    }
+    el->lock(el);
+    ck_assert_uint_ge(reactorTimerCount, 3);
+    ck_assert(reactorTimerThread);
+    el->unlock(el);
+
+    UA_EventLoopPOSIX_removeReactorTimer(pel, 2, id);
+
+    el->stop(el);
+    for(size_t i = 0; i < 1000 && el->state != UA_EVENTLOOPSTATE_STOPPED; i++)
+        el->run(el, 1);
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
+#endif /* UA_HAVE_EVENTLOOP_REACTORS */
+
+#endif
+
 int main(void) {
     Suite *s  = suite_create("Test TCP EventLoop");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, listenTCP);
     tcase_add_test(tc, connectTCP);
+    tcase_add_test(tc, sendQueuedTCP);
+    tcase_add_test(tc, sendBacklogTCP);
+#if UA_MULTITHREADING >= 100 && defined(__linux__)
+    tcase_add_test(tc, reactorsTCP);
+#endif
+#ifdef UA_HAVE_EVENTLOOP_REACTORS
+    tcase_add_test(tc, reactorTimer);
+#endif
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
@@ -0,0 +1,332 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/eventloop.h>
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/server.h>
+
+#include "test_helpers.h"
+#include "testing_clock.h"
+#include "thread_wrapper.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <check.h>
+
+#define CONNECTIONS 64
+#define ROUNDTRIPS 200
+
+typedef UA_ConnectionManager * (*CMConstructor)(const UA_String eventSourceName);
+
+static const CMConstructor cmConstructors[2] = {
+    UA_ConnectionManager_new_POSIX_TCP,
+    UA_ConnectionManager_new_POSIX_TCP_IOURING
+};
+
+static const char *cmNames[2] = {"epoll", "io_uring"};
+
+static UA_EventLoop *el;
+static UA_ConnectionManager *cm;
+static char *testMsg = "open62541";
+
+/* Per-connection state. The client connections have a context, the server
+ * side connections use the shared server context. */
+typedef struct {
+    uintptr_t id;
+    size_t received;
+    size_t roundtrips;
+    UA_Boolean established;
+} TestConnection;
+
+static TestConnection clients[CONNECTIONS];
+static size_t clientsSize;
+static unsigned connCount;
+static unsigned serverConns;
+static size_t serverReceived;
+static UA_Boolean echo;
+
+static void
+sendMsg(uintptr_t connectionId) {
+    UA_ByteString snd;
+    UA_StatusCode res = cm->allocNetworkBuffer(cm, connectionId, &snd, strlen(testMsg));
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    memcpy(snd.data, testMsg, strlen(testMsg));
+    res = cm->sendWithConnection(cm, connectionId, &UA_KEYVALUEMAP_NULL, &snd);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void
+connectionCallback(UA_ConnectionManager *cm_, uintptr_t connectionId,
+                   void *application, void **connectionContext,
+                   UA_ConnectionState status,
+                   const UA_KeyValueMap *params,
+                   UA_ByteString msg) {
+    TestConnection *tc = (TestConnection*)*connectionContext;
+    if(status == UA_CONNECTIONSTATE_CLOSING) {
+        connCount--;
+        if(tc)
+            tc->established = false;
+        return;
+    }
+    if(status == UA_CONNECTIONSTATE_OPENING)
+        return;
+
+    if(msg.length == 0) {
+        connCount++;
+        if(tc) {
+            tc->id = connectionId;
+            tc->established = true;
+        } else if(!UA_KeyValueMap_contains(params, UA_QUALIFIEDNAME(0, "listen-port"))) {
+            serverConns++;
+        }
+        return;
+    }
+
+    /* Server side: Count and echo the data */
+    if(!tc) {
+        serverReceived += msg.length;
+        if(echo) {
+            UA_ByteString snd;
+            UA_StatusCode res = cm->allocNetworkBuffer(cm, connectionId, &snd, msg.length);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+            memcpy(snd.data, msg.data, msg.length);
+            res = cm->sendWithConnection(cm, connectionId, &UA_KEYVALUEMAP_NULL, &snd);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        }
+        return;
+    }
+
+    /* Client side: Send the next message once the echo is complete */
+    tc->received += msg.length;
+    if(tc->received < strlen(testMsg))
+        return;
+    tc->received -= strlen(testMsg);
+    tc->roundtrips++;
+    if(tc->roundtrips < ROUNDTRIPS)
+        sendMsg(tc->id);
+}
+
+static void
+setupEventLoop(size_t cmIndex) {
+    connCount = 0;
+    serverConns = 0;
+    serverReceived = 0;
+    clientsSize = 0;
+    echo = false;
+    memset(clients, 0, sizeof(clients));
+
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    cm = cmConstructors[cmIndex](UA_STRING("tcpCM"));
+    ck_assert(cm != NULL);
+    el->registerEventSource(el, &cm->eventSource);
+    UA_StatusCode res = el->start(el);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void
+listenAndConnect(size_t connections) {
+    UA_UInt16 port = 4840;
+    UA_Boolean listen = true;
+    UA_String host = UA_STRING("localhost");
+    UA_KeyValuePair params[3];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+    UA_KeyValueMap paramsMap = {3, params};
+
+    UA_StatusCode res = cm->openConnection(cm, &paramsMap, NULL, NULL, connectionCallback);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    unsigned listenSockets = connCount;
+    ck_assert_uint_gt(listenSockets, 0);
+
+    listen = false;
+    for(size_t i = 0; i < connections; i++) {
+        res = cm->openConnection(cm, &paramsMap, NULL, &clients[i], connectionCallback);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    clientsSize = connections;
+
+    for(size_t i = 0; i < 1000 && connCount < listenSockets + 2 * connections; i++)
+        el->run(el, 1);
+    ck_assert_uint_eq(connCount, listenSockets + 2 * connections);
+    ck_assert_uint_eq(serverConns, connections);
+}
+
+static void
+stopEventLoop(void) {
+    el->stop(el);
+    for(size_t i = 0; i < 1000 && el->state != UA_EVENTLOOPSTATE_STOPPED; i++)
+        el->run(el, 1);
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    ck_assert_uint_eq(connCount, 0);
+    el->free(el);
+    el = NULL;
+}
+
+START_TEST(uringSendReceive) {
+    setupEventLoop(1);
+    listenAndConnect(1);
+
+    sendMsg(clients[0].id);
+    for(size_t i = 0; i < 1000 && serverReceived < strlen(testMsg); i++)
+        el->run(el, 1);
+    ck_assert_uint_eq(serverReceived, strlen(testMsg));
+
+    /* Close from the client side. The server side follows. */
+    UA_StatusCode res = cm->closeConnection(cm, clients[0].id);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    unsigned listenSockets = connCount - 2;
+    for(size_t i = 0; i < 1000 && connCount > listenSockets; i++)
+        el->run(el, 1);
+    ck_assert_uint_eq(connCount, listenSockets);
+
+    stopEventLoop();
+} END_TEST
+
+/* A message that is sent right before closing still arrives */
+START_TEST(uringSendBeforeClose) {
+    setupEventLoop(1);
+    listenAndConnect(1);
+
+    sendMsg(clients[0].id);
+    UA_StatusCode res = cm->closeConnection(cm, clients[0].id);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    unsigned listenSockets = connCount - 2;
+    for(size_t i = 0; i < 1000 && connCount > listenSockets; i++)
+        el->run(el, 1);
+    ck_assert_uint_eq(serverReceived, strlen(testMsg));
+    ck_assert_uint_eq(connCount, listenSockets);
+
+    stopEventLoop();
+} END_TEST
+
+/* Stopping the EventLoop closes the open connections */
+START_TEST(uringStopWithConnections) {
+    setupEventLoop(1);
+    listenAndConnect(8);
+    stopEventLoop();
+} END_TEST
+
+/* Large messages are split over several receive buffers */
+START_TEST(uringLargeMessage) {
+    setupEventLoop(1);
+    listenAndConnect(1);
+
+    size_t size = 1u << 22; /* 4MB */
+    UA_ByteString snd;
+    UA_StatusCode res = cm->allocNetworkBuffer(cm, clients[0].id, &snd, size);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    memset(snd.data, 'a', size);
+    res = cm->sendWithConnection(cm, clients[0].id, &UA_KEYVALUEMAP_NULL, &snd);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 10000 && serverReceived < size; i++)
+        el->run(el, 1);
+    ck_assert_uint_eq(serverReceived, size);
+
+    stopEventLoop();
+} END_TEST
+
+/* Ping-pong over many connections with both ConnectionManagers */
+START_TEST(pingPong) {
+    setupEventLoop((size_t)_i);
+    listenAndConnect(CONNECTIONS);
+    echo = true;
+
+    UA_DateTime begin = UA_DateTime_nowMonotonic();
+    for(size_t i = 0; i < CONNECTIONS; i++)
+        sendMsg(clients[i].id);
+    size_t done = 0;
+    for(size_t i = 0; i < 100000 && done < CONNECTIONS; i++) {
+        el->run(el, 1);
+        done = 0;
+        for(size_t j = 0; j < CONNECTIONS; j++) {
+            if(clients[j].roundtrips >= ROUNDTRIPS)
+                done++;
+        }
+    }
+    UA_DateTime duration = UA_DateTime_nowMonotonic() - begin;
+    ck_assert_uint_eq(done, CONNECTIONS);
+    printf("%s: %u roundtrips over %u connections in %.2f ms (%.2f us per roundtrip)\n",
+           cmNames[_i], ROUNDTRIPS * CONNECTIONS, CONNECTIONS,
+           (double)duration / UA_DATETIME_MSEC,
+           (double)duration / UA_DATETIME_USEC / (ROUNDTRIPS * CONNECTIONS));
+
+    stopEventLoop();
+} END_TEST
+
+/* The server works with the io_uring ConnectionManager in place of the
+ * TCP ConnectionManager */
+static UA_Server *server;
+static UA_Boolean running;
+static THREAD_HANDLE server_thread;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+START_TEST(uringServer) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_EventLoop *sel = config->eventLoop;
+    UA_String tcpName = UA_STRING("tcp");
+    for(UA_EventSource *es = sel->eventSources; es; es = es->next) {
+        if(es->eventSourceType == UA_EVENTSOURCETYPE_CONNECTIONMANAGER &&
+           UA_String_equal(&((UA_ConnectionManager*)es)->protocol, &tcpName)) {
+            sel->deregisterEventSource(sel, es);
+            es->free(es);
+            break;
+        }
+    }
+    UA_ConnectionManager *ucm =
+        UA_ConnectionManager_new_POSIX_TCP_IOURING(UA_STRING("io_uring tcp"));
+    sel->registerEventSource(sel, &ucm->eventSource);
+
+    UA_StatusCode res = UA_Server_run_startup(server);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 10; i++) {
+        UA_Variant val;
+        res = UA_Client_readValueAttribute(client,
+                  UA_NS0ID(SERVER_SERVERSTATUS_STATE), &val);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        UA_Variant_clear(&val);
+    }
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+} END_TEST
+
+int main(void) {
+    Suite *s  = suite_create("Test io_uring TCP EventLoop");
+    TCase *tc = tcase_create("test cases");
+    tcase_add_test(tc, uringSendReceive);
+    tcase_add_test(tc, uringSendBeforeClose);
+    tcase_add_test(tc, uringStopWithConnections);
+    tcase_add_test(tc, uringLargeMessage);
+    tcase_add_loop_test(tc, pingPong, 0, 2);
+    tcase_add_test(tc, uringServer);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all (sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
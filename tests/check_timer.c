@@ -10,6 +10,8 @@
 #include <stdio.h>
 
 #define N_EVENTS 10000
+#define N_ORDER_EVENTS 2000
+#define N_SPEED_EVENTS 100000
 
 size_t count = 0;
 
@@ -53,10 +55,279 @@ START_TEST(benchmarkTimer) {
     UA_Timer_clear(&timer);
 } END_TEST
 
+typedef struct {
+    UA_DateTime nextTime;
+    size_t executed;
+} TestEntry;
+
+static UA_DateTime testNow;
+static UA_DateTime lastExecuted;
+
+static void
+orderCallback(void *application, void *data) {
+    TestEntry *e = (TestEntry*)data;
+    ck_assert(e->nextTime <= testNow);
+    ck_assert(e->nextTime >= lastExecuted);
+    lastExecuted = e->nextTime;
+    e->executed++;
+}
+
+/* Simple deterministic pseudo-random numbers */
+static UA_UInt64 rndState = 42;
+static UA_UInt64
+rnd(void) {
+    rndState = rndState * 6364136223846793005ULL + 1442695040888963407ULL;
+    return rndState >> 33;
+}
+
+/* Single-shot callbacks from sub-millisecond up to beyond the ~81 days that
+ * are covered by the levels of the timing wheel */
+START_TEST(timerOrder) {
+    UA_Timer timer;
+    UA_Timer_init(&timer);
+
+    static TestEntry entries[N_ORDER_EVENTS];
+    testNow = 0;
+    lastExecuted = 0;
+    for(size_t i = 0; i < N_ORDER_EVENTS; i++) {
+        UA_UInt32 magnitude = (UA_UInt32)(rnd() % 11); /* Up to ~115 days */
+        UA_Double interval = (UA_Double)(rnd() % 1000 + 1) / 20.0;
+        for(UA_UInt32 j = 0; j < magnitude; j++)
+            interval *= 5.0;
+        entries[i].nextTime = (UA_DateTime)(interval * UA_DATETIME_MSEC);
+        entries[i].executed = 0;
+        UA_StatusCode retval =
+            UA_Timer_add(&timer, orderCallback, NULL, &entries[i], interval,
+                         testNow, NULL, UA_TIMERPOLICY_ONCE, NULL);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    /* Jump to the next timer. It has to be exact. */
+    size_t executed = 0;
+    while(executed < N_ORDER_EVENTS) {
+        UA_DateTime next = UA_Timer_next(&timer);
+        UA_DateTime min = UA_INT64_MAX;
+        for(size_t i = 0; i < N_ORDER_EVENTS; i++) {
+            if(!entries[i].executed && entries[i].nextTime < min)
+                min = entries[i].nextTime;
+        }
+        ck_assert_int_eq(next, min);
+
+        /* Stop shortly before to test that nothing is executed early */
+        if(rnd() % 2 == 0) {
+            testNow = next - 1;
+            ck_assert_int_eq(UA_Timer_process(&timer, testNow), next);
+        }
+
+        testNow = next;
+        UA_Timer_process(&timer, testNow);
+        executed = 0;
+        for(size_t i = 0; i < N_ORDER_EVENTS; i++) {
+            ck_assert_uint_le(entries[i].executed, 1);
+            if(entries[i].nextTime <= testNow)
+                ck_assert_uint_eq(entries[i].executed, 1);
+            executed += entries[i].executed;
+        }
+    }
+    ck_assert_int_eq(UA_Timer_next(&timer), UA_INT64_MAX);
+
+    UA_Timer_clear(&timer);
+} END_TEST
+
+static size_t baseTimeCount;
+static size_t currentTimeCount;
+
+static void
+baseTimeCallback(void *application, void *data) {
+    baseTimeCount++;
+}
+
+static void
+currentTimeCallback(void *application, void *data) {
+    currentTimeCount++;
+}
+
+/* Missed execution windows are handled according to the timer policy */
+START_TEST(timerPolicies) {
+    UA_Timer timer;
+    UA_Timer_init(&timer);
+    baseTimeCount = 0;
+    currentTimeCount = 0;
+
+    UA_DateTime baseTime = 0;
+    UA_Timer_add(&timer, baseTimeCallback, NULL, NULL, 10.0, 0,
+                 &baseTime, UA_TIMERPOLICY_BASETIME, NULL);
+    UA_Timer_add(&timer, currentTimeCallback, NULL, NULL, 10.0, 0,
+                 NULL, UA_TIMERPOLICY_CURRENTTIME, NULL);
+    ck_assert_int_eq(UA_Timer_next(&timer), 10 * UA_DATETIME_MSEC);
+
+    /* Miss the windows at 20ms and 30ms */
+    UA_DateTime next = UA_Timer_process(&timer, 35 * UA_DATETIME_MSEC);
+    ck_assert_uint_eq(baseTimeCount, 1);
+    ck_assert_uint_eq(currentTimeCount, 1);
+    ck_assert_int_eq(next, 40 * UA_DATETIME_MSEC);
+
+    next = UA_Timer_process(&timer, next);
+    ck_assert_uint_eq(baseTimeCount, 2);
+    ck_assert_uint_eq(currentTimeCount, 1);
+    ck_assert_int_eq(next, 45 * UA_DATETIME_MSEC);
+
+    next = UA_Timer_process(&timer, next);
+    ck_assert_uint_eq(baseTimeCount, 2);
+    ck_assert_uint_eq(currentTimeCount, 2);
+    ck_assert_int_eq(next, 50 * UA_DATETIME_MSEC);
+
+    UA_Timer_clear(&timer);
+} END_TEST
+
+static UA_Timer modTimer;
+static UA_UInt64 removeId;
+static UA_UInt64 modifyId;
+static size_t removedCount;
+static size_t modifiedCount;
+
+static void
+removeCallback(void *application, void *data) {
+    UA_Timer_remove(&modTimer, removeId);
+}
+
+static void
+removedCallback(void *application, void *data) {
+    removedCount++;
+}
+
+static void
+modifyCallback(void *application, void *data) {
+    modifiedCount++;
+    UA_DateTime now = *(UA_DateTime*)data;
+    UA_Timer_modify(&modTimer, modifyId, 50.0, now, NULL,
+                    UA_TIMERPOLICY_CURRENTTIME);
+}
+
+/* Remove and modify entries from within the callbacks of the same batch */
+START_TEST(timerModifyDuringProcessing) {
+    UA_Timer_init(&modTimer);
+    removedCount = 0;
+    modifiedCount = 0;
+
+    /* The entry with the remove callback is executed first */
+    UA_DateTime now = 0;
+    UA_Timer_add(&modTimer, removeCallback, NULL, NULL, 10.0, now,
+                 NULL, UA_TIMERPOLICY_BASETIME, NULL);
+    now = 1;
+    UA_Timer_add(&modTimer, removedCallback, NULL, NULL, 10.0, now,
+                 NULL, UA_TIMERPOLICY_BASETIME, &removeId);
+    UA_Timer_add(&modTimer, modifyCallback, NULL, &now, 10.0, now,
+                 NULL, UA_TIMERPOLICY_BASETIME, &modifyId);
+
+    now = 20 * UA_DATETIME_MSEC;
+    UA_Timer_process(&modTimer, now);
+    ck_assert_uint_eq(removedCount, 0);
+    ck_assert_uint_eq(modifiedCount, 1);
+
+    /* The modified entry is executed 50ms after the modification. The entry
+     * with the remove callback runs every 10ms. */
+    for(size_t i = 0; i < 5; i++) {
+        now += 10 * UA_DATETIME_MSEC;
+        UA_Timer_process(&modTimer, now);
+        ck_assert_uint_eq(modifiedCount, (i < 4) ? 1 : 2);
+    }
+    ck_assert_uint_eq(removedCount, 0);
+
+    UA_Timer_clear(&modTimer);
+} END_TEST
+
+static void
+nopCallback(void *application, void *data) {
+    count++;
+}
+
+/* Many cyclic callbacks with intervals between 1ms and 1s that are spread over
+ * the interval. Process every millisecond over 10s. */
+START_TEST(benchmarkTimerWheel) {
+    UA_Timer timer;
+    UA_Timer_init(&timer);
+
+    UA_UInt64 *ids = (UA_UInt64*)UA_malloc(N_SPEED_EVENTS * sizeof(UA_UInt64));
+    ck_assert_ptr_ne(ids, NULL);
+
+    clock_t begin = clock();
+    for(size_t i = 0; i < N_SPEED_EVENTS; i++) {
+        UA_Double interval = (UA_Double)(rnd() % 1000 + 1);
+        UA_DateTime baseTime = (UA_DateTime)(rnd() % (UA_UInt64)(interval * UA_DATETIME_MSEC));
+        UA_StatusCode retval =
+            UA_Timer_add(&timer, nopCallback, NULL, NULL, interval, 0,
+                         &baseTime, UA_TIMERPOLICY_BASETIME, &ids[i]);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    clock_t added = clock();
+
+    count = 0;
+    for(UA_DateTime now = 0; now <= 10 * UA_DATETIME_SEC; now += UA_DATETIME_MSEC)
+        UA_Timer_process(&timer, now);
+    clock_t processed = clock();
+
+    for(size_t i = 0; i < N_SPEED_EVENTS; i++)
+        UA_Timer_remove(&timer, ids[i]);
+    clock_t removed = clock();
+    ck_assert_int_eq(UA_Timer_next(&timer), UA_INT64_MAX);
+
+    double addTime = (double)(added - begin) / CLOCKS_PER_SEC;
+    double processTime = (double)(processed - added) / CLOCKS_PER_SEC;
+    double removeTime = (double)(removed - processed) / CLOCKS_PER_SEC;
+    printf("%u timers: add %f s, remove %f s\n", N_SPEED_EVENTS, addTime, removeTime);
+    printf("%lu callbacks processed in %f s (%.1f ns per callback)\n",
+           (unsigned long)count, processTime, processTime * 1e9 / (double)count);
+
+    UA_free(ids);
+    UA_Timer_clear(&timer);
+} END_TEST
+
+/* Remove the entries of one large slot in the order of their nextTime. The
+ * slot minimum is recomputed lazily, so this is linear in the slot size. */
+START_TEST(removeLargeSlotInOrder) {
+    UA_Timer timer;
+    UA_Timer_init(&timer);
+
+    UA_UInt64 *ids = (UA_UInt64*)UA_malloc(N_SPEED_EVENTS * sizeof(UA_UInt64));
+    ck_assert_ptr_ne(ids, NULL);
+    UA_DateTime base = 10 * UA_DATETIME_SEC;
+    for(size_t i = 0; i < N_SPEED_EVENTS; i++) {
+        UA_DateTime baseTime = base + (UA_DateTime)i;
+        UA_StatusCode retval =
+            UA_Timer_add(&timer, timerCallback, NULL, NULL, 0.0, 0,
+                         &baseTime, UA_TIMERPOLICY_ONCE, &ids[i]);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_int_eq(UA_Timer_next(&timer), base);
+
+    /* The next time is exact after every removal of the earliest entry */
+    for(size_t i = 0; i < 100; i++) {
+        UA_Timer_remove(&timer, ids[i]);
+        ck_assert_int_eq(UA_Timer_next(&timer), base + (UA_DateTime)i + 1);
+    }
+
+    clock_t begin = clock();
+    for(size_t i = 100; i < N_SPEED_EVENTS; i++)
+        UA_Timer_remove(&timer, ids[i]);
+    clock_t removed = clock();
+    ck_assert_int_eq(UA_Timer_next(&timer), UA_INT64_MAX);
+    printf("%u timers of one slot removed in order in %f s\n", N_SPEED_EVENTS,
+           (double)(removed - begin) / CLOCKS_PER_SEC);
+
+    UA_free(ids);
+    UA_Timer_clear(&timer);
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test Event Timer");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, benchmarkTimer);
+    tcase_add_test(tc, timerOrder);
+    tcase_add_test(tc, timerPolicies);
+    tcase_add_test(tc, timerModifyDuringProcessing);
+    tcase_add_test(tc, benchmarkTimerWheel);
+    tcase_add_test(tc, removeLargeSlotInOrder);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
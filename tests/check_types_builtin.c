@@ -9,6 +9,7 @@
 #include "util/ua_util_internal.h"
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <check.h>
 #include <float.h>
 #include <math.h>
@@ -601,6 +602,55 @@ START_TEST(UA_Variant_decodeWithTooSmallSourceShallReturnWithError) {
 }
 END_TEST
 
+START_TEST(UA_ReadRequest_decodeIntoArenaShallBorrowStrings) {
+    // given
+    UA_ReadValueId rvi[100];
+    char names[100][16];
+    for(size_t i = 0; i < 100; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        snprintf(names[i], 16, "Variable %u", (unsigned)i);
+        rvi[i].nodeId = UA_NODEID_STRING(1, names[i]);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest req;
+    UA_ReadRequest_init(&req);
+    req.nodesToRead = rvi;
+    req.nodesToReadSize = 100;
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode retval =
+        UA_encodeBinary(&req, &UA_TYPES[UA_TYPES_READREQUEST], &buf, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Arena arena;
+    memset(&arena, 0, sizeof(UA_Arena));
+    UA_DecodeBinaryOptions opt;
+    memset(&opt, 0, sizeof(UA_DecodeBinaryOptions));
+    opt.callocContext = &arena;
+    opt.calloc = UA_Arena_calloc;
+    opt.borrowStrings = true;
+
+    // when
+    for(size_t round = 0; round < 2; round++) {
+        UA_ReadRequest dst;
+        retval = UA_decodeBinary(&buf, &dst, &UA_TYPES[UA_TYPES_READREQUEST], &opt);
+
+        // then
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(dst.nodesToReadSize, 100);
+        for(size_t i = 0; i < 100; i++) {
+            UA_String *id = &dst.nodesToRead[i].nodeId.identifier.string;
+            ck_assert(UA_NodeId_equal(&dst.nodesToRead[i].nodeId, &rvi[i].nodeId));
+            ck_assert(id->data >= buf.data && id->data + id->length <= buf.data + buf.length);
+        }
+        UA_Arena_reset(&arena);
+    }
+
+    // finally
+    UA_Arena_clear(&arena);
+    UA_ByteString_clear(&buf);
+}
+END_TEST
+
 START_TEST(UA_Byte_encode_test) {
     // given
     UA_Byte src       = 8;
@@ -1784,6 +1834,7 @@ static Suite *testSuite_builtin(void) {
     tcase_add_test(tc_decode, UA_Variant_decodeWithArrayFlagSetShallSetVTAndAllocateMemoryForArray);
     tcase_add_test(tc_decode, UA_Variant_decodeWithOutDeleteMembersShallFailInCheckMem);
     tcase_add_test(tc_decode, UA_Variant_decodeWithTooSmallSourceShallReturnWithError);
+    tcase_add_test(tc_decode, UA_ReadRequest_decodeIntoArenaShallBorrowStrings);
     suite_add_tcase(s, tc_decode);
 
     TCase *tc_encode = tcase_create("encode");
@@ -13,6 +13,8 @@
 #include <check.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "test_helpers.h"
 #include "testing_clock.h"
@@ -279,6 +281,155 @@ START_TEST(Client_connectivity_check) {
         UA_Client_delete(client);
 }END_TEST
 
+#define PIPELINE_DEPTH 20000
+
+typedef struct {
+    UA_UInt32 received;
+    UA_UInt32 good;
+    UA_UInt32 timedOut;
+    UA_UInt32 firstRequestId;
+    UA_UInt32 *timeoutHints; /* Indexed by requestId - firstRequestId */
+    UA_UInt32 lastTimeoutHint;
+    UA_Boolean inOrder;
+} PipelineCounter;
+
+static void
+pipelineReadCallback(UA_Client *client, void *userdata,
+                     UA_UInt32 requestId, const UA_ReadResponse *response) {
+    PipelineCounter *pc = (PipelineCounter*)userdata;
+    pc->received++;
+    if(response->responseHeader.serviceResult == UA_STATUSCODE_GOOD)
+        pc->good++;
+    if(response->responseHeader.serviceResult == UA_STATUSCODE_BADTIMEOUT) {
+        pc->timedOut++;
+        /* All requests were sent at the same time. So the timeouts have to be
+         * processed in the order of the timeoutHint. */
+        UA_UInt32 hint = pc->timeoutHints[requestId - pc->firstRequestId];
+        if(hint < pc->lastTimeoutHint)
+            pc->inOrder = false;
+        pc->lastTimeoutHint = hint;
+    }
+}
+
+static UA_StatusCode
+sendPipelinedRead(UA_Client *client, UA_UInt32 timeoutHint,
+                  PipelineCounter *pc, UA_UInt32 *requestId) {
+    UA_ReadValueId rvid;
+    UA_ReadValueId_init(&rvid);
+    rvid.attributeId = UA_ATTRIBUTEID_VALUE;
+    rvid.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+    UA_ReadRequest rr;
+    UA_ReadRequest_init(&rr);
+    rr.nodesToRead = &rvid;
+    rr.nodesToReadSize = 1;
+    rr.requestHeader.timeoutHint = timeoutHint;
+    return __UA_Client_AsyncService(client, &rr, &UA_TYPES[UA_TYPES_READREQUEST],
+                                    (UA_ClientAsyncServiceCallback)pipelineReadCallback,
+                                    &UA_TYPES[UA_TYPES_READRESPONSE], pc, requestId);
+}
+
+/* Keep a deep queue of requests in flight and measure the rate at which the
+ * responses are correlated with the pending calls */
+START_TEST(Client_read_async_pipelining) {
+        UA_Client *client = UA_Client_newForUnitTest();
+        UA_ClientConfig *clientConfig = UA_Client_getConfig(client);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        clientConfig->outStandingPublishRequests = 0;
+#endif
+        clientConfig->connectivityCheckInterval = 0;
+
+        UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        UA_Client_run_iterate(client, 1);
+
+        PipelineCounter pc;
+        memset(&pc, 0, sizeof(PipelineCounter));
+
+        clock_t begin = clock();
+        for(size_t i = 0; i < PIPELINE_DEPTH; i++) {
+            retval = sendPipelinedRead(client, 0, &pc, NULL);
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        }
+        ck_assert_uint_eq(client->asyncServiceCallsSize, PIPELINE_DEPTH);
+
+        for(size_t i = 0; i < 100000 && pc.received < PIPELINE_DEPTH; i++) {
+            retval = UA_Client_run_iterate(client, 10);
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        }
+        clock_t finish = clock();
+        double time_spent = (double)(finish - begin) / CLOCKS_PER_SEC;
+        printf("%i pipelined requests:\t Duration was %f s (%.0f responses/s)\n",
+               PIPELINE_DEPTH, time_spent, (double)PIPELINE_DEPTH / time_spent);
+
+        ck_assert_uint_eq(pc.received, PIPELINE_DEPTH);
+        ck_assert_uint_eq(pc.good, PIPELINE_DEPTH);
+        ck_assert_uint_eq(client->asyncServiceCallsSize, 0);
+
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+} END_TEST
+
+/* Deep queue of requests that are never answered. They time out in the order
+ * of their deadline and only once the deadline has passed. */
+START_TEST(Client_read_async_pipelining_timeout) {
+        UA_Client *client = UA_Client_newForUnitTest();
+        UA_ClientConfig *clientConfig = UA_Client_getConfig(client);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        clientConfig->outStandingPublishRequests = 0;
+#endif
+        clientConfig->connectivityCheckInterval = 0;
+
+        UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        UA_Client_run_iterate(client, 1);
+
+        /* The server no longer answers */
+        running = false;
+        THREAD_JOIN(server_thread);
+
+        /* Later requests get an earlier deadline (10s down to 1s) */
+        PipelineCounter pc;
+        memset(&pc, 0, sizeof(PipelineCounter));
+        pc.inOrder = true;
+        pc.timeoutHints = (UA_UInt32*)UA_malloc(PIPELINE_DEPTH * sizeof(UA_UInt32));
+        ck_assert(pc.timeoutHints != NULL);
+        for(size_t i = 0; i < PIPELINE_DEPTH; i++) {
+            UA_UInt32 requestId = 0;
+            pc.timeoutHints[i] = 10000 - (UA_UInt32)((i * 9000) / PIPELINE_DEPTH);
+            retval = sendPipelinedRead(client, pc.timeoutHints[i], &pc, &requestId);
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+            if(i == 0)
+                pc.firstRequestId = requestId;
+            ck_assert_uint_eq(requestId, pc.firstRequestId + i);
+        }
+
+        /* Nothing has expired yet */
+        retval = UA_Client_run_iterate(client, 0);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(pc.timedOut, 0);
+
+        /* Half of the deadlines have passed */
+        UA_fakeSleep(5500);
+        UA_Client_run_iterate(client, 0);
+        ck_assert_uint_eq(pc.timedOut, PIPELINE_DEPTH / 2);
+        ck_assert_uint_eq(client->asyncServiceCallsSize, PIPELINE_DEPTH / 2);
+
+        /* All of them */
+        UA_fakeSleep(4500);
+        UA_Client_run_iterate(client, 0);
+        ck_assert_uint_eq(pc.timedOut, PIPELINE_DEPTH);
+        ck_assert(pc.inOrder);
+        ck_assert_uint_eq(client->asyncServiceCallsSize, 0);
+        UA_free(pc.timeoutHints);
+
+        /* Get the server back up */
+        running = true;
+        THREAD_CREATE(server_thread, serverloop);
+
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+} END_TEST
+
 static Suite* testSuite_Client(void) {
     Suite *s = suite_create("Client");
     TCase *tc_client = tcase_create("Client Basic");
@@ -288,6 +439,8 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_client, Client_read_async_timed);
     tcase_add_test(tc_client, Client_connectivity_check);
     tcase_add_test(tc_client, Client_highlevel_async_readValue);
+    tcase_add_test(tc_client, Client_read_async_pipelining);
+    tcase_add_test(tc_client, Client_read_async_pipelining_timeout);
 
     suite_add_tcase(s, tc_client);
     return s;
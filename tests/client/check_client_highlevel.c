@@ -347,6 +347,129 @@ START_TEST(Node_Register) {
 END_TEST
 
 
+/* Hitting the per-session limit in the middle of a request fails the request
+ * and rolls back the handles that were already assigned for it */
+START_TEST(Node_RegisterLimit) {
+    UA_Server_getConfig(server)->maxRegisteredNodesPerSession = 2;
+
+    UA_NodeId toRegister[3];
+    toRegister[0] = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    toRegister[1] = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    toRegister[2] = UA_NODEID_NUMERIC(0, UA_NS0ID_TYPESFOLDER);
+    UA_RegisterNodesRequest req;
+    UA_RegisterNodesRequest_init(&req);
+    req.nodesToRegister = toRegister;
+    req.nodesToRegisterSize = 3;
+    UA_RegisterNodesResponse res = UA_Client_Service_registerNodes(client, req);
+    ck_assert_uint_eq(res.responseHeader.serviceResult,
+                      UA_STATUSCODE_BADTOOMANYOPERATIONS);
+    ck_assert_uint_eq(res.registeredNodeIdsSize, 0);
+    UA_RegisterNodesResponse_clear(&res);
+
+    /* The limit is not used up by the failed request */
+    req.nodesToRegisterSize = 2;
+    res = UA_Client_Service_registerNodes(client, req);
+    ck_assert_uint_eq(res.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(res.registeredNodeIdsSize, 2);
+    ck_assert(!UA_NodeId_equal(&toRegister[0], &res.registeredNodeIds[0]));
+    ck_assert(!UA_NodeId_equal(&toRegister[1], &res.registeredNodeIds[1]));
+
+    /* Registering the same nodes again does not need new handles */
+    UA_RegisterNodesResponse res2 = UA_Client_Service_registerNodes(client, req);
+    ck_assert_uint_eq(res2.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_RegisterNodesResponse_clear(&res2);
+
+    /* The limit is reached */
+    req.nodesToRegister = &toRegister[2];
+    req.nodesToRegisterSize = 1;
+    res2 = UA_Client_Service_registerNodes(client, req);
+    ck_assert_uint_eq(res2.responseHeader.serviceResult,
+                      UA_STATUSCODE_BADTOOMANYOPERATIONS);
+    UA_RegisterNodesResponse_clear(&res2);
+    UA_RegisterNodesResponse_clear(&res);
+}
+END_TEST
+
+
+#ifdef UA_ENABLE_NODEMANAGEMENT
+/* Registered nodes are returned as handles that can be used for Read and
+ * Write. The same NodeId returns the same handle. Unknown NodeIds are returned
+ * unchanged. */
+START_TEST(Node_RegisterReadWrite) {
+    UA_NodeId varId = UA_NODEID_STRING(1, "RegisteredVariable");
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 value = 42;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "RegisteredVariable");
+    UA_StatusCode retval =
+        UA_Client_addVariableNode(client, varId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "RegisteredVariable"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_NodeId toRegister[3];
+    toRegister[0] = varId;
+    toRegister[1] = varId;
+    toRegister[2] = UA_NODEID_STRING(1, "MissingVariable");
+    UA_RegisterNodesRequest req;
+    UA_RegisterNodesRequest_init(&req);
+    req.nodesToRegister = toRegister;
+    req.nodesToRegisterSize = 3;
+    UA_RegisterNodesResponse res = UA_Client_Service_registerNodes(client, req);
+    ck_assert_uint_eq(res.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(res.registeredNodeIdsSize, 3);
+    UA_NodeId handle = res.registeredNodeIds[0];
+    ck_assert_uint_eq(handle.identifierType, UA_NODEIDTYPE_NUMERIC);
+    ck_assert_uint_eq(handle.namespaceIndex, 1);
+    ck_assert(UA_NodeId_equal(&handle, &res.registeredNodeIds[1]));
+    ck_assert(UA_NodeId_equal(&toRegister[2], &res.registeredNodeIds[2]));
+
+    /* Read and write with the handle */
+    UA_Variant val;
+    retval = UA_Client_readValueAttribute(client, handle, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)val.data, 42);
+    UA_Variant_clear(&val);
+
+    value = 43;
+    UA_Variant_setScalar(&val, &value, &UA_TYPES[UA_TYPES_INT32]);
+    retval = UA_Client_writeValueAttribute(client, handle, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    retval = UA_Client_readValueAttribute(client, varId, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)val.data, 43);
+    UA_Variant_clear(&val);
+
+    /* The handle is valid until it was unregistered as often as registered */
+    UA_UnregisterNodesRequest reqUn;
+    UA_UnregisterNodesRequest_init(&reqUn);
+    reqUn.nodesToUnregister = &handle;
+    reqUn.nodesToUnregisterSize = 1;
+    UA_UnregisterNodesResponse resUn = UA_Client_Service_unregisterNodes(client, reqUn);
+    ck_assert_uint_eq(resUn.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UnregisterNodesResponse_clear(&resUn);
+
+    retval = UA_Client_readValueAttribute(client, handle, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&val);
+
+    resUn = UA_Client_Service_unregisterNodes(client, reqUn);
+    ck_assert_uint_eq(resUn.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UnregisterNodesResponse_clear(&resUn);
+
+    retval = UA_Client_readValueAttribute(client, handle, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    UA_RegisterNodesResponse_clear(&res);
+}
+END_TEST
+#endif
+
 
 // NodeIds for ReadWrite testing
 UA_NodeId nodeReadWriteUnitTest;
@@ -1049,6 +1172,10 @@ static Suite *testSuite_Client(void) {
 #endif
     tcase_add_test(tc_nodes, Node_Browse);
     tcase_add_test(tc_nodes, Node_Register);
+    tcase_add_test(tc_nodes, Node_RegisterLimit);
+#ifdef UA_ENABLE_NODEMANAGEMENT
+    tcase_add_test(tc_nodes, Node_RegisterReadWrite);
+#endif
     suite_add_tcase(s, tc_nodes);
 
 #ifdef UA_ENABLE_NODEMANAGEMENT
@@ -172,6 +172,96 @@ START_TEST(Client_subscription) {
 }
 END_TEST
 
+START_TEST(Client_subscription_republish) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    UA_CreateSubscriptionResponse response = UA_Client_Subscriptions_create(client, request,
+                                                                            NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UInt32 subId = response.subscriptionId;
+
+    UA_MonitoredItemCreateRequest monRequest =
+        UA_MonitoredItemCreateRequest_default(UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE));
+    UA_MonitoredItemCreateResult monResponse =
+        UA_Client_MonitoredItems_createDataChange(client, subId,
+                                                  UA_TIMESTAMPSTORETURN_BOTH,
+                                                  monRequest, NULL, dataChangeHandler, NULL);
+    ck_assert_uint_eq(monResponse.statusCode, UA_STATUSCODE_GOOD);
+    UA_UInt32 monId = monResponse.monitoredItemId;
+
+    /* Don't send new publish requests. They would acknowledge the received
+     * NotificationMessage and remove it from the retransmission queue. */
+    UA_UInt16 outStanding = client->config.outStandingPublishRequests;
+    client->config.outStandingPublishRequests = 0;
+
+    /* manually control the server thread */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    UA_Server_run_iterate(server, true);
+    retval = UA_Client_run_iterate(client, 1);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+
+    notificationReceived = false;
+    UA_Server_run_iterate(server, true);
+    retval = UA_Client_run_iterate(client, 1);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(notificationReceived, true);
+
+    UA_Client_Subscription *sub = LIST_FIRST(&client->subscriptions);
+    ck_assert_ptr_ne(sub, NULL);
+    UA_UInt32 sequenceNumber = sub->sequenceNumber;
+
+    /* run the server in an independent thread again */
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    /* The republished message is the same as the published one */
+    UA_RepublishRequest repRequest;
+    UA_RepublishRequest_init(&repRequest);
+    repRequest.subscriptionId = subId;
+    repRequest.retransmitSequenceNumber = sequenceNumber;
+    UA_RepublishResponse repResponse;
+    __UA_Client_Service(client, &repRequest, &UA_TYPES[UA_TYPES_REPUBLISHREQUEST],
+                        &repResponse, &UA_TYPES[UA_TYPES_REPUBLISHRESPONSE]);
+    ck_assert_uint_eq(repResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_NotificationMessage *msg = &repResponse.notificationMessage;
+    ck_assert_uint_eq(msg->sequenceNumber, sequenceNumber);
+    ck_assert_uint_eq(msg->notificationDataSize, 1);
+    ck_assert(msg->notificationData[0].content.decoded.type ==
+              &UA_TYPES[UA_TYPES_DATACHANGENOTIFICATION]);
+    UA_DataChangeNotification *dcn = (UA_DataChangeNotification*)
+        msg->notificationData[0].content.decoded.data;
+    ck_assert_uint_eq(dcn->monitoredItemsSize, 1);
+    ck_assert(dcn->monitoredItems[0].value.hasValue);
+    UA_RepublishResponse_clear(&repResponse);
+
+    /* Unknown sequence number */
+    repRequest.retransmitSequenceNumber = sequenceNumber + 100;
+    __UA_Client_Service(client, &repRequest, &UA_TYPES[UA_TYPES_REPUBLISHREQUEST],
+                        &repResponse, &UA_TYPES[UA_TYPES_REPUBLISHRESPONSE]);
+    ck_assert_uint_eq(repResponse.responseHeader.serviceResult,
+                      UA_STATUSCODE_BADMESSAGENOTAVAILABLE);
+    UA_RepublishResponse_clear(&repResponse);
+
+    client->config.outStandingPublishRequests = outStanding;
+
+    retval = UA_Client_MonitoredItems_deleteSingle(client, subId, monId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    retval = UA_Client_Subscriptions_deleteSingle(client, subId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 START_TEST(Client_subscription_async) {
     UA_Client *client = UA_Client_newForUnitTest();
     UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
@@ -1648,6 +1738,7 @@ static Suite* testSuite_Client(void) {
     TCase *tc_client = tcase_create("Client Subscription Basic");
     tcase_add_checked_fixture(tc_client, setup, teardown);
     tcase_add_test(tc_client, Client_subscription);
+    tcase_add_test(tc_client, Client_subscription_republish);
     tcase_add_test(tc_client, Client_subscription_async);
     tcase_add_test(tc_client, Client_subscription_statusChange);
     tcase_add_test(tc_client, Client_subscription_timeout);
@@ -0,0 +1,187 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/certificategroup_default.h>
+#include <open62541/plugin/create_certificate.h>
+#include <open62541/plugin/log_stdout.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "check.h"
+#include "testing_clock.h"
+
+#define VERIFICATIONS 2000
+
+static UA_ByteString certificate;
+static UA_ByteString certificate2;
+static UA_CertificateGroup certGroup;
+
+static void
+generateCertificate(UA_ByteString *cert) {
+    UA_String subject[3] = {UA_STRING_STATIC("C=DE"),
+                            UA_STRING_STATIC("O=SampleOrganization"),
+                            UA_STRING_STATIC("CN=Open62541Client@localhost")};
+    UA_String subjectAltName[2]= {
+        UA_STRING_STATIC("DNS:localhost"),
+        UA_STRING_STATIC("URI:urn:open62541.unconfigured.application")
+    };
+    UA_KeyValueMap *kvm = UA_KeyValueMap_new();
+    UA_UInt16 expiresIn = 14;
+    UA_KeyValueMap_setScalar(kvm, UA_QUALIFIEDNAME(0, "expires-in-days"),
+                             (void *)&expiresIn, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_UInt16 keyLength = 2048;
+    UA_KeyValueMap_setScalar(kvm, UA_QUALIFIEDNAME(0, "key-size-bits"),
+                             (void *)&keyLength, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_ByteString privateKey = UA_BYTESTRING_NULL;
+    UA_StatusCode res =
+        UA_CreateCertificate(UA_Log_Stdout, subject, 3, subjectAltName, 2,
+                             UA_CERTIFICATEFORMAT_DER, kvm, &privateKey, cert);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ByteString_clear(&privateKey);
+    UA_KeyValueMap_delete(kvm);
+}
+
+static void
+trustCertificates(UA_TrustListDataType *trustList) {
+    memset(trustList, 0, sizeof(UA_TrustListDataType));
+    trustList->specifiedLists = UA_TRUSTLISTMASKS_TRUSTEDCERTIFICATES;
+    trustList->trustedCertificates = &certificate;
+    trustList->trustedCertificatesSize = 1;
+}
+
+/* Set up a memorystore that trusts the first certificate. Without
+ * setCacheSize and with ttl == 0 the defaults are used. */
+static void
+initCertGroup(UA_UInt32 cacheSize, UA_UInt32 ttl, UA_Boolean setCacheSize) {
+    UA_KeyValueMap params = UA_KEYVALUEMAP_NULL;
+    if(setCacheSize)
+        UA_KeyValueMap_setScalar(&params, UA_QUALIFIEDNAME(0, "maxVerificationCacheSize"),
+                                 &cacheSize, &UA_TYPES[UA_TYPES_UINT32]);
+    if(ttl > 0)
+        UA_KeyValueMap_setScalar(&params, UA_QUALIFIEDNAME(0, "verificationCacheTtl"),
+                                 &ttl, &UA_TYPES[UA_TYPES_UINT32]);
+
+    UA_TrustListDataType trustList;
+    trustCertificates(&trustList);
+    UA_NodeId groupId = UA_NS0ID(SERVERCONFIGURATION_CERTIFICATEGROUPS_DEFAULTAPPLICATIONGROUP);
+    memset(&certGroup, 0, sizeof(UA_CertificateGroup));
+    UA_StatusCode res =
+        UA_CertificateGroup_Memorystore(&certGroup, &groupId, &trustList,
+                                        UA_Log_Stdout, &params);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_KeyValueMap_clear(&params);
+}
+
+static void setup(void) {
+    generateCertificate(&certificate);
+    generateCertificate(&certificate2);
+}
+
+static void teardown(void) {
+    if(certGroup.clear)
+        certGroup.clear(&certGroup);
+    UA_ByteString_clear(&certificate);
+    UA_ByteString_clear(&certificate2);
+}
+
+START_TEST(cache_verify) {
+    initCertGroup(0, 0, false);
+    for(size_t i = 0; i < 3; i++) {
+        ck_assert_uint_eq(certGroup.verifyCertificate(&certGroup, &certificate),
+                          UA_STATUSCODE_GOOD);
+        ck_assert_uint_ne(certGroup.verifyCertificate(&certGroup, &certificate2),
+                          UA_STATUSCODE_GOOD);
+    }
+} END_TEST
+
+/* Changing the trust list invalidates the cached results */
+START_TEST(cache_invalidateOnTrustListChange) {
+    initCertGroup(0, 0, false);
+    ck_assert_uint_eq(certGroup.verifyCertificate(&certGroup, &certificate),
+                      UA_STATUSCODE_GOOD);
+
+    UA_TrustListDataType trustList;
+    trustCertificates(&trustList);
+    UA_StatusCode res = certGroup.removeFromTrustList(&certGroup, &trustList);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_ne(certGroup.verifyCertificate(&certGroup, &certificate),
+                      UA_STATUSCODE_GOOD);
+
+    res = certGroup.addToTrustList(&certGroup, &trustList);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(certGroup.verifyCertificate(&certGroup, &certificate),
+                      UA_STATUSCODE_GOOD);
+
+    /* Replace the trust list with one that trusts only the second certificate */
+    trustList.trustedCertificates = &certificate2;
+    res = certGroup.setTrustList(&certGroup, &trustList);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_ne(certGroup.verifyCertificate(&certGroup, &certificate),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(certGroup.verifyCertificate(&certGroup, &certificate2),
+                      UA_STATUSCODE_GOOD);
+} END_TEST
+
+/* Expired entries and a full cache fall back to the full verification */
+START_TEST(cache_ttlAndEviction) {
+    initCertGroup(1, 1, true);
+    ck_assert_uint_eq(certGroup.verifyCertificate(&certGroup, &certificate),
+                      UA_STATUSCODE_GOOD);
+    UA_realSleep(5);
+    ck_assert_uint_eq(certGroup.verifyCertificate(&certGroup, &certificate),
+                      UA_STATUSCODE_GOOD);
+
+    UA_TrustListDataType trustList;
+    trustCertificates(&trustList);
+    trustList.trustedCertificates = &certificate2;
+    UA_StatusCode res = certGroup.addToTrustList(&certGroup, &trustList);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 3; i++) {
+        ck_assert_uint_eq(certGroup.verifyCertificate(&certGroup, &certificate),
+                          UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(certGroup.verifyCertificate(&certGroup, &certificate2),
+                          UA_STATUSCODE_GOOD);
+    }
+} END_TEST
+
+/* Many clients reconnecting with the same certificate */
+START_TEST(cache_speed) {
+    for(size_t c = 0; c < 2; c++) {
+        initCertGroup(0, 0, (c == 0));
+        UA_DateTime begin = UA_DateTime_nowMonotonic();
+        for(size_t i = 0; i < VERIFICATIONS; i++) {
+            ck_assert_uint_eq(certGroup.verifyCertificate(&certGroup, &certificate),
+                              UA_STATUSCODE_GOOD);
+        }
+        UA_DateTime duration = UA_DateTime_nowMonotonic() - begin;
+        printf("%s: %u verifications in %.2f ms (%.2f us per verification)\n",
+               (c == 0) ? "uncached" : "cached", VERIFICATIONS,
+               (double)duration / UA_DATETIME_MSEC,
+               (double)duration / UA_DATETIME_USEC / VERIFICATIONS);
+        certGroup.clear(&certGroup);
+    }
+} END_TEST
+
+static Suite *testSuite_verificationCache(void) {
+    Suite *s = suite_create("Certificate Verification Cache");
+    TCase *tc = tcase_create("Memorystore");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, cache_verify);
+    tcase_add_test(tc, cache_invalidateOnTrustListChange);
+    tcase_add_test(tc, cache_ttlAndEviction);
+    tcase_add_test(tc, cache_speed);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_verificationCache();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
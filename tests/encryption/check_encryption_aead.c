@@ -0,0 +1,245 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+#include <open62541/plugin/securitypolicy_default.h>
+#include <open62541/plugin/certificategroup_default.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+#include "certificates.h"
+#include "check.h"
+#include "testing_clock.h"
+#include "thread_wrapper.h"
+
+/* Large enough to be split into several chunks */
+#define LARGEVALUE_LENGTH 200000
+
+typedef UA_StatusCode
+(*PolicyConstructor)(UA_SecurityPolicy *policy, const UA_ByteString localCertificate,
+                     const UA_ByteString localPrivateKey, const UA_Logger *logger);
+
+static const PolicyConstructor policies[] = {
+    UA_SecurityPolicy_Aes256GcmRsaPss,
+    UA_SecurityPolicy_ChaCha20Poly1305RsaPss
+};
+
+static const char *policyUris[] = {
+    "http://open62541.org/UA/SecurityPolicy#Aes256Gcm_RsaPss",
+    "http://open62541.org/UA/SecurityPolicy#ChaCha20Poly1305_RsaPss"
+};
+
+#define POLICIES (sizeof(policies) / sizeof(policies[0]))
+
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+/* Append a policy to the array and initialize it with the local keys */
+static void
+addPolicy(size_t *policiesSize, UA_SecurityPolicy **policyArray,
+          PolicyConstructor constructor, const UA_Logger *logger) {
+    UA_ByteString certificate = {CERT_DER_LENGTH, CERT_DER_DATA};
+    UA_ByteString privateKey = {KEY_DER_LENGTH, KEY_DER_DATA};
+    UA_SecurityPolicy *tmp = (UA_SecurityPolicy*)
+        UA_realloc(*policyArray, sizeof(UA_SecurityPolicy) * (*policiesSize + 1));
+    ck_assert(tmp != NULL);
+    *policyArray = tmp;
+    UA_StatusCode res =
+        constructor(&tmp[*policiesSize], certificate, privateKey, logger);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    (*policiesSize)++;
+}
+
+static void setup(void) {
+    running = true;
+    UA_ByteString certificate = {CERT_DER_LENGTH, CERT_DER_DATA};
+    UA_ByteString privateKey = {KEY_DER_LENGTH, KEY_DER_DATA};
+    server = UA_Server_newForUnitTestWithSecurityPolicies(4840, &certificate, &privateKey,
+                                                          NULL, 0, NULL, 0, NULL, 0);
+    ck_assert(server != NULL);
+
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_CertificateGroup_AcceptAll(&config->secureChannelPKI);
+    UA_CertificateGroup_AcceptAll(&config->sessionPKI);
+    UA_String_clear(&config->applicationDescription.applicationUri);
+    config->applicationDescription.applicationUri =
+        UA_STRING_ALLOC("urn:unconfigured:application");
+
+    /* Add the AEAD policies with endpoints for Sign and SignAndEncrypt */
+    for(size_t i = 0; i < POLICIES; i++) {
+        addPolicy(&config->securityPoliciesSize, &config->securityPolicies,
+                  policies[i], config->logging);
+        UA_StatusCode res =
+            UA_ServerConfig_addEndpoint(config, UA_STRING((char*)(uintptr_t)policyUris[i]),
+                                        UA_MESSAGESECURITYMODE_SIGN);
+        res |= UA_ServerConfig_addEndpoint(config, UA_STRING((char*)(uintptr_t)policyUris[i]),
+                                           UA_MESSAGESECURITYMODE_SIGNANDENCRYPT);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    /* A large value that is sent in several chunks */
+    UA_ByteString largeValue;
+    UA_ByteString_allocBuffer(&largeValue, LARGEVALUE_LENGTH);
+    for(size_t i = 0; i < LARGEVALUE_LENGTH; i++)
+        largeValue.data[i] = (UA_Byte)(i * 7);
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Variant_setScalar(&attr.value, &largeValue, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, UA_NODEID_STRING(1, "large.value"),
+                                  UA_NS0ID(OBJECTSFOLDER), UA_NS0ID(ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "large value"),
+                                  UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ByteString_clear(&largeValue);
+
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void teardown(void) {
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static UA_Client *
+newClient(size_t policyIndex, UA_MessageSecurityMode mode) {
+    UA_ByteString certificate = {CERT_DER_LENGTH, CERT_DER_DATA};
+    UA_ByteString privateKey = {KEY_DER_LENGTH, KEY_DER_DATA};
+    UA_Client *client = UA_Client_newForUnitTest();
+    ck_assert(client != NULL);
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    UA_ClientConfig_setDefaultEncryption(cc, certificate, privateKey,
+                                         NULL, 0, NULL, 0);
+    cc->certificateVerification.clear(&cc->certificateVerification);
+    UA_CertificateGroup_AcceptAll(&cc->certificateVerification);
+    addPolicy(&cc->securityPoliciesSize, &cc->securityPolicies,
+              policies[policyIndex], cc->logging);
+    addPolicy(&cc->authSecurityPoliciesSize, &cc->authSecurityPolicies,
+              policies[policyIndex], cc->logging);
+    cc->securityPolicyUri = UA_STRING_ALLOC(policyUris[policyIndex]);
+    cc->securityMode = mode;
+    return client;
+}
+
+static void
+readLargeValue(UA_Client *client) {
+    UA_Variant val;
+    UA_StatusCode res =
+        UA_Client_readValueAttribute(client, UA_NODEID_STRING(1, "large.value"), &val);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&val, &UA_TYPES[UA_TYPES_BYTESTRING]));
+    UA_ByteString *bs = (UA_ByteString*)val.data;
+    ck_assert_uint_eq(bs->length, LARGEVALUE_LENGTH);
+    for(size_t i = 0; i < LARGEVALUE_LENGTH; i++)
+        ck_assert_uint_eq(bs->data[i], (UA_Byte)(i * 7));
+    UA_Variant_clear(&val);
+}
+
+/* Loop over the policies and the modes Sign/SignAndEncrypt */
+START_TEST(aead_connect) {
+    UA_MessageSecurityMode mode = (_i % 2 == 0) ?
+        UA_MESSAGESECURITYMODE_SIGN : UA_MESSAGESECURITYMODE_SIGNANDENCRYPT;
+    UA_Client *client = newClient((size_t)_i / 2, mode);
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    readLargeValue(client);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+/* The AEAD keys are renewed with every SecurityToken. Keep a subscription
+ * running so that messages are exchanged in both directions while the
+ * channel is renewed several times. */
+START_TEST(aead_renewSecureChannel) {
+    UA_Client *client = newClient((size_t)_i, UA_MESSAGESECURITYMODE_SIGNANDENCRYPT);
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    cc->secureChannelLifeTime = 5000;
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    request.requestedPublishingInterval = 1000;
+    request.requestedMaxKeepAliveCount = 1;
+    UA_CreateSubscriptionResponse response =
+        UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_CreateSubscriptionResponse_clear(&response);
+
+    /* Manually control the server thread */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    /* Small time steps. The client renews after 75% of the lifetime and
+     * starts using the new token before the old one expires on the server. */
+    for(size_t i = 0; i < 100; i++) {
+        UA_fakeSleep(200);
+        UA_Server_run_iterate(server, false);
+        res = UA_Client_run_iterate(client, 1);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    /* Run the server in an independent thread again */
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    readLargeValue(client);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+/* A client that does not support the AEAD policy cannot connect to it */
+START_TEST(aead_unknownPolicy) {
+    UA_ByteString certificate = {CERT_DER_LENGTH, CERT_DER_DATA};
+    UA_ByteString privateKey = {KEY_DER_LENGTH, KEY_DER_DATA};
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    UA_ClientConfig_setDefaultEncryption(cc, certificate, privateKey,
+                                         NULL, 0, NULL, 0);
+    cc->certificateVerification.clear(&cc->certificateVerification);
+    UA_CertificateGroup_AcceptAll(&cc->certificateVerification);
+    cc->securityPolicyUri = UA_STRING_ALLOC(policyUris[0]);
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_ne(res, UA_STATUSCODE_GOOD);
+    UA_Client_delete(client);
+} END_TEST
+
+static Suite *testSuite_encryption_aead(void) {
+    Suite *s = suite_create("Encryption AEAD");
+    TCase *tc_aead = tcase_create("AEAD");
+    tcase_add_checked_fixture(tc_aead, setup, teardown);
+    tcase_add_loop_test(tc_aead, aead_connect, 0, (int)POLICIES * 2);
+    tcase_add_loop_test(tc_aead, aead_renewSecureChannel, 0, (int)POLICIES);
+    tcase_add_test(tc_aead, aead_unknownPolicy);
+    suite_add_tcase(s, tc_aead);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_encryption_aead();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
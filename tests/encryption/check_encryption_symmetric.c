@@ -0,0 +1,309 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Symmetric sign/encrypt of SecureChannel chunks directly through the
+ * SecurityPolicy plugin API. Checks that the channel keys can be renewed and
+ * measures the chunk throughput for SignAndEncrypt (and for the single-pass
+ * authenticated encryption of the AEAD policies). */
+
+#include <open62541/plugin/securitypolicy.h>
+#include <open62541/plugin/securitypolicy_default.h>
+#include <open62541/plugin/log_stdout.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "certificates.h"
+#include "check.h"
+
+#define CHUNKSIZE 8192
+#define CHUNKS 20000
+
+typedef UA_StatusCode
+(*PolicyConstructor)(UA_SecurityPolicy *policy, const UA_ByteString localCertificate,
+                     const UA_ByteString localPrivateKey, const UA_Logger *logger);
+
+static const PolicyConstructor policies[] = {
+    UA_SecurityPolicy_Basic128Rsa15,
+    UA_SecurityPolicy_Basic256,
+    UA_SecurityPolicy_Basic256Sha256,
+    UA_SecurityPolicy_Aes128Sha256RsaOaep,
+    UA_SecurityPolicy_Aes256Sha256RsaPss
+};
+
+static UA_SecurityPolicy policy;
+static void *channelContext;
+
+static void
+setupPolicy(PolicyConstructor constructor) {
+    UA_ByteString certificate = {CERT_DER_LENGTH, CERT_DER_DATA};
+    UA_ByteString privateKey = {KEY_DER_LENGTH, KEY_DER_DATA};
+    UA_StatusCode res = constructor(&policy, certificate, privateKey, UA_Log_Stdout);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = policy.channelModule.newContext(&policy, &certificate, &channelContext);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void
+teardownPolicy(void) {
+    policy.channelModule.deleteContext(channelContext);
+    policy.clear(&policy);
+}
+
+/* Set the same keys for both directions, so that the chunks can be decrypted
+ * and verified again */
+static void
+setKeys(UA_Byte seed) {
+    const UA_SecurityPolicySymmetricModule *sm = &policy.symmetricModule;
+    size_t sigKeyLen = sm->cryptoModule.signatureAlgorithm.getLocalKeyLength(channelContext);
+    size_t encKeyLen = sm->cryptoModule.encryptionAlgorithm.getLocalKeyLength(channelContext);
+    size_t ivLen = sm->cryptoModule.encryptionAlgorithm.getRemoteBlockSize(channelContext);
+
+    UA_Byte buf[3][64];
+    ck_assert(sigKeyLen <= 64 && encKeyLen <= 64 && ivLen <= 64);
+    for(size_t i = 0; i < 64; i++) {
+        buf[0][i] = (UA_Byte)(seed + i);
+        buf[1][i] = (UA_Byte)(seed * 3 + i);
+        buf[2][i] = (UA_Byte)(seed * 7 + i);
+    }
+    UA_ByteString sigKey = {sigKeyLen, buf[0]};
+    UA_ByteString encKey = {encKeyLen, buf[1]};
+    UA_ByteString iv = {ivLen, buf[2]};
+
+    const UA_SecurityPolicyChannelModule *cm = &policy.channelModule;
+    UA_StatusCode res = cm->setLocalSymSigningKey(channelContext, &sigKey);
+    res |= cm->setLocalSymEncryptingKey(channelContext, &encKey);
+    res |= cm->setLocalSymIv(channelContext, &iv);
+    res |= cm->setRemoteSymSigningKey(channelContext, &sigKey);
+    res |= cm->setRemoteSymEncryptingKey(channelContext, &encKey);
+    res |= cm->setRemoteSymIv(channelContext, &iv);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+/* Sign the chunk content and append the signature, then encrypt everything */
+static UA_StatusCode
+signAndEncrypt(UA_ByteString *chunk) {
+    const UA_SecurityPolicySymmetricModule *sm = &policy.symmetricModule;
+    size_t sigLen =
+        sm->cryptoModule.signatureAlgorithm.getLocalSignatureSize(channelContext);
+    UA_ByteString content = {chunk->length - sigLen, chunk->data};
+    UA_ByteString signature = {sigLen, chunk->data + content.length};
+    UA_StatusCode res =
+        sm->cryptoModule.signatureAlgorithm.sign(channelContext, &content, &signature);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    return sm->cryptoModule.encryptionAlgorithm.encrypt(channelContext, chunk);
+}
+
+static UA_StatusCode
+decryptAndVerify(UA_ByteString *chunk) {
+    const UA_SecurityPolicySymmetricModule *sm = &policy.symmetricModule;
+    UA_StatusCode res =
+        sm->cryptoModule.encryptionAlgorithm.decrypt(channelContext, chunk);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    size_t sigLen =
+        sm->cryptoModule.signatureAlgorithm.getRemoteSignatureSize(channelContext);
+    UA_ByteString content = {chunk->length - sigLen, chunk->data};
+    UA_ByteString signature = {sigLen, chunk->data + content.length};
+    return sm->cryptoModule.signatureAlgorithm.verify(channelContext, &content, &signature);
+}
+
+static void
+fillChunk(UA_ByteString *chunk) {
+    for(size_t i = 0; i < chunk->length; i++)
+        chunk->data[i] = (UA_Byte)(i * 13);
+}
+
+START_TEST(symmetricRoundtrip) {
+    setupPolicy(policies[_i]);
+
+    UA_ByteString plain, first, chunk;
+    UA_ByteString_allocBuffer(&plain, CHUNKSIZE);
+    UA_ByteString_allocBuffer(&first, CHUNKSIZE);
+    UA_ByteString_allocBuffer(&chunk, CHUNKSIZE);
+
+    for(UA_Byte token = 1; token <= 3; token++) {
+        setKeys(token);
+
+        /* Every chunk starts with the IV of the token. So the same content
+         * encrypts to the same ciphertext. */
+        fillChunk(&plain);
+        memcpy(first.data, plain.data, CHUNKSIZE);
+        ck_assert_uint_eq(signAndEncrypt(&first), UA_STATUSCODE_GOOD);
+        memcpy(chunk.data, plain.data, CHUNKSIZE);
+        ck_assert_uint_eq(signAndEncrypt(&chunk), UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(chunk.length, CHUNKSIZE);
+        ck_assert(UA_ByteString_equal(&first, &chunk));
+
+        /* Roundtrip. The signature was appended to the content. */
+        ck_assert_uint_eq(decryptAndVerify(&chunk), UA_STATUSCODE_GOOD);
+        size_t sigLen = policy.symmetricModule.cryptoModule.signatureAlgorithm.
+            getLocalSignatureSize(channelContext);
+        ck_assert(memcmp(chunk.data, plain.data, CHUNKSIZE - sigLen) == 0);
+
+        /* A tampered chunk does not verify */
+        memcpy(chunk.data, first.data, CHUNKSIZE);
+        chunk.data[CHUNKSIZE - 1] ^= 0x01;
+        ck_assert_uint_ne(decryptAndVerify(&chunk), UA_STATUSCODE_GOOD);
+    }
+
+    UA_ByteString_clear(&plain);
+    UA_ByteString_clear(&first);
+    UA_ByteString_clear(&chunk);
+    teardownPolicy();
+} END_TEST
+
+/* Publish responses are often much smaller than a full chunk. Measure both. */
+static const size_t speedChunkSizes[] = {512, CHUNKSIZE};
+
+START_TEST(signAndEncryptSpeed) {
+    setupPolicy(UA_SecurityPolicy_Basic256Sha256);
+    setKeys(1);
+
+    size_t chunkSize = speedChunkSizes[_i];
+    UA_ByteString chunk;
+    UA_ByteString_allocBuffer(&chunk, chunkSize);
+    fillChunk(&chunk);
+
+    clock_t begin = clock();
+    for(size_t i = 0; i < CHUNKS; i++) {
+        UA_StatusCode res = signAndEncrypt(&chunk);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    clock_t finish = clock();
+
+    double time_spent = (double)(finish - begin) / CLOCKS_PER_SEC;
+    printf("Basic256Sha256 SignAndEncrypt of %u chunks with %u bytes took %f s "
+           "(%.0f chunks/s)\n", (unsigned)CHUNKS, (unsigned)chunkSize, time_spent,
+           (double)CHUNKS / time_spent);
+
+    UA_ByteString_clear(&chunk);
+    teardownPolicy();
+} END_TEST
+
+#ifdef UA_ENABLE_ENCRYPTION_OPENSSL
+/* The tag is appended to the chunk. The first 16 bytes are the unencrypted
+ * headers. */
+static UA_StatusCode
+encryptAuthenticated(UA_ByteString *chunk) {
+    const UA_SecurityPolicySymmetricModule *sm = &policy.symmetricModule;
+    size_t tagLen =
+        sm->cryptoModule.signatureAlgorithm.getLocalSignatureSize(channelContext);
+    UA_ByteString aad = {16, chunk->data};
+    UA_ByteString data = {chunk->length - 16 - tagLen, chunk->data + 16};
+    UA_ByteString tag = {tagLen, chunk->data + chunk->length - tagLen};
+    return sm->encryptAuthenticated(channelContext, &aad, &data, &tag);
+}
+
+static UA_StatusCode
+decryptAuthenticated(UA_ByteString *chunk) {
+    const UA_SecurityPolicySymmetricModule *sm = &policy.symmetricModule;
+    size_t tagLen =
+        sm->cryptoModule.signatureAlgorithm.getRemoteSignatureSize(channelContext);
+    UA_ByteString aad = {16, chunk->data};
+    UA_ByteString data = {chunk->length - 16 - tagLen, chunk->data + 16};
+    UA_ByteString tag = {tagLen, chunk->data + chunk->length - tagLen};
+    return sm->decryptAuthenticated(channelContext, &aad, &data, &tag);
+}
+
+static const PolicyConstructor aeadPolicies[] = {
+    UA_SecurityPolicy_Aes256GcmRsaPss,
+    UA_SecurityPolicy_ChaCha20Poly1305RsaPss
+};
+
+START_TEST(aeadRoundtrip) {
+    setupPolicy(aeadPolicies[_i]);
+    ck_assert(policy.symmetricModule.encryptAuthenticated != NULL);
+    ck_assert(policy.symmetricModule.decryptAuthenticated != NULL);
+
+    UA_ByteString plain, chunk;
+    UA_ByteString_allocBuffer(&plain, CHUNKSIZE);
+    UA_ByteString_allocBuffer(&chunk, CHUNKSIZE);
+    fillChunk(&plain);
+
+    for(UA_Byte token = 1; token <= 3; token++) {
+        /* The counters for both directions start at zero */
+        setKeys(token);
+
+        /* Every chunk gets a fresh nonce. The same content does not encrypt
+         * to the same ciphertext. */
+        UA_ByteString first;
+        UA_ByteString_copy(&plain, &first);
+        ck_assert_uint_eq(encryptAuthenticated(&first), UA_STATUSCODE_GOOD);
+        memcpy(chunk.data, plain.data, CHUNKSIZE);
+        ck_assert_uint_eq(encryptAuthenticated(&chunk), UA_STATUSCODE_GOOD);
+        ck_assert(memcmp(first.data + 16, chunk.data + 16, CHUNKSIZE - 16) != 0);
+
+        /* Decrypt in the same order */
+        ck_assert_uint_eq(decryptAuthenticated(&first), UA_STATUSCODE_GOOD);
+        ck_assert(memcmp(first.data, plain.data, CHUNKSIZE - 16) == 0);
+
+        /* Tampering with the unencrypted header is detected */
+        chunk.data[3] ^= 0x01;
+        ck_assert_uint_ne(decryptAuthenticated(&chunk), UA_STATUSCODE_GOOD);
+        UA_ByteString_clear(&first);
+    }
+
+    UA_ByteString_clear(&plain);
+    UA_ByteString_clear(&chunk);
+    teardownPolicy();
+} END_TEST
+
+START_TEST(aeadSpeed) {
+    setupPolicy(UA_SecurityPolicy_Aes256GcmRsaPss);
+    setKeys(1);
+
+    size_t chunkSize = speedChunkSizes[_i];
+    UA_ByteString chunk;
+    UA_ByteString_allocBuffer(&chunk, chunkSize);
+    fillChunk(&chunk);
+
+    clock_t begin = clock();
+    for(size_t i = 0; i < CHUNKS; i++) {
+        UA_StatusCode res = encryptAuthenticated(&chunk);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    clock_t finish = clock();
+
+    double time_spent = (double)(finish - begin) / CLOCKS_PER_SEC;
+    printf("Aes256Gcm authenticated encryption of %u chunks with %u bytes took %f s "
+           "(%.0f chunks/s)\n", (unsigned)CHUNKS, (unsigned)chunkSize, time_spent,
+           (double)CHUNKS / time_spent);
+
+    UA_ByteString_clear(&chunk);
+    teardownPolicy();
+} END_TEST
+#endif
+
+static Suite *testSuite_encryption_symmetric(void) {
+    Suite *s = suite_create("Encryption Symmetric");
+    TCase *tc_roundtrip = tcase_create("Roundtrip");
+    tcase_add_loop_test(tc_roundtrip, symmetricRoundtrip, 0,
+                        sizeof(policies) / sizeof(policies[0]));
+    suite_add_tcase(s, tc_roundtrip);
+    TCase *tc_speed = tcase_create("Speed");
+    tcase_add_loop_test(tc_speed, signAndEncryptSpeed, 0,
+                        sizeof(speedChunkSizes) / sizeof(speedChunkSizes[0]));
+#ifdef UA_ENABLE_ENCRYPTION_OPENSSL
+    tcase_add_loop_test(tc_roundtrip, aeadRoundtrip, 0,
+                        sizeof(aeadPolicies) / sizeof(aeadPolicies[0]));
+    tcase_add_loop_test(tc_speed, aeadSpeed, 0,
+                        sizeof(speedChunkSizes) / sizeof(speedChunkSizes[0]));
+#endif
+    suite_add_tcase(s, tc_speed);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_encryption_symmetric();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
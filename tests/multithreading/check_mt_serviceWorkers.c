@@ -0,0 +1,678 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_highlevel_async.h>
+#include <open62541/client_subscriptions.h>
+#include <open62541/plugin/nodestore_default.h>
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "ua_server_internal.h"
+#include "test_helpers.h"
+#include "testing_clock.h"
+#include "thread_wrapper.h"
+#include "mt_testing.h"
+
+#define NUMBER_OF_SERVICE_WORKERS 4
+#define NUMBER_OF_CLIENTS 8
+#define ITERATIONS_PER_CLIENT 200
+#define PIPELINED_REQUESTS 20
+#define PARALLEL_OPERATIONS 64
+#define CONCURRENT_READS 500
+#define MAX_READ_CLIENTS 8
+#define PUBLISH_NOTIFICATIONS 20
+
+UA_NodeId counterId = {1, UA_NODEIDTYPE_NUMERIC, {1001}};
+UA_DateTime startTime;
+
+static void
+addVariableNode(void) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 myInteger = 42;
+    UA_Variant_setScalar(&attr.value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+    attr.displayName = UA_LOCALIZEDTEXT("en-US","Counter");
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_StatusCode res =
+        UA_Server_addVariableNode(tc.server, counterId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Counter"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_int_eq(UA_STATUSCODE_GOOD, res);
+}
+
+static void setup(void) {
+    tc.running = true;
+    tc.server = UA_Server_newForUnitTest();
+    ck_assert(tc.server != NULL);
+    UA_Server_getConfig(tc.server)->serviceWorkers = NUMBER_OF_SERVICE_WORKERS;
+    addVariableNode();
+    UA_Server_run_startup(tc.server);
+    THREAD_CREATE(server_thread, serverloop);
+    startTime = UA_DateTime_nowMonotonic();
+}
+
+static void
+checkThroughput(void) {
+    UA_DateTime duration = UA_DateTime_nowMonotonic() - startTime;
+    size_t requests = NUMBER_OF_CLIENTS * ITERATIONS_PER_CLIENT;
+    printf("%lu requests with %u service workers in %.2f ms\n",
+           (unsigned long)requests, NUMBER_OF_SERVICE_WORKERS,
+           (double)duration / UA_DATETIME_MSEC);
+}
+
+static void
+client_readValueAttribute(void *value) {
+    ThreadContext tmp = (*(ThreadContext *) value);
+    UA_Variant val;
+    UA_StatusCode retval =
+        UA_Client_readValueAttribute(tc.clients[tmp.index], counterId, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&val, &UA_TYPES[UA_TYPES_INT32]));
+    ck_assert_int_eq(42, *(UA_Int32 *)val.data);
+    UA_Variant_clear(&val);
+}
+
+static void
+initReadTest(void) {
+    for(size_t i = 0; i < tc.numberofClients; i++)
+        setThreadContext(&tc.clientContext[i], i, ITERATIONS_PER_CLIENT,
+                         client_readValueAttribute);
+}
+
+START_TEST(readValueAttributeWorkers) {
+    startMultithreading();
+} END_TEST
+
+/* Send several requests before waiting for the responses. The responses must
+ * arrive in the order of the requests. */
+static UA_UInt32 lastRequestId;
+static size_t responsesReceived;
+
+static void
+readCallback(UA_Client *client, void *userdata, UA_UInt32 requestId,
+             UA_ReadResponse *response) {
+    ck_assert_uint_gt(requestId, lastRequestId);
+    lastRequestId = requestId;
+    ck_assert_uint_eq(response->responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response->resultsSize, 1);
+    ck_assert_int_eq(42, *(UA_Int32*)response->results[0].value.data);
+    responsesReceived++;
+}
+
+START_TEST(pipelinedRequests) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = counterId;
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = &rvi;
+    request.nodesToReadSize = 1;
+
+    lastRequestId = 0;
+    responsesReceived = 0;
+    for(size_t i = 0; i < PIPELINED_REQUESTS; i++) {
+        retval = UA_Client_sendAsyncReadRequest(client, &request, readCallback,
+                                                NULL, NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    for(size_t i = 0; i < 1000 && responsesReceived < PIPELINED_REQUESTS; i++)
+        UA_Client_run_iterate(client, 10);
+    ck_assert_uint_eq(responsesReceived, PIPELINED_REQUESTS);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+/* Large requests are split across the service workers. The results must be
+ * returned in the order of the operations. */
+static void
+slowOperation(void) {
+    UA_DateTime end = UA_DateTime_nowMonotonic() + UA_DATETIME_MSEC;
+    while(UA_DateTime_nowMonotonic() < end) {}
+}
+
+/* Close the session from within the first operation. The other operations of
+ * the batch still use the session. */
+static UA_Boolean closeSessionInRead;
+
+static UA_StatusCode
+readIndex(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+          const UA_NodeId *nodeId, void *nodeContext, UA_Boolean sourceTimeStamp,
+          const UA_NumericRange *range, UA_DataValue *value) {
+    slowOperation();
+    UA_UInt32 index = (UA_UInt32)(uintptr_t)nodeContext;
+    if(closeSessionInRead && index == 0) {
+        ck_assert_uint_eq(UA_Server_closeSession(server, sessionId),
+                          UA_STATUSCODE_GOOD);
+        /* Give the EventLoop time to process the delayed cleanup */
+        UA_realSleep(1000);
+    }
+    value->hasValue = true;
+    return UA_Variant_setScalarCopy(&value->value, &index, &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+static UA_StatusCode
+doubleMethod(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+             const UA_NodeId *methodId, void *methodContext,
+             const UA_NodeId *objectId, void *objectContext,
+             size_t inputSize, const UA_Variant *input,
+             size_t outputSize, UA_Variant *output) {
+    slowOperation();
+    UA_UInt32 res = *(UA_UInt32*)input[0].data * 2;
+    return UA_Variant_setScalarCopy(output, &res, &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+static void
+addParallelNodes(void) {
+
+    for(UA_UInt32 i = 0; i < PARALLEL_OPERATIONS; i++) {
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+        UA_DataSource ds = {readIndex, NULL};
+        UA_StatusCode res =
+            UA_Server_addDataSourceVariableNode(tc.server, UA_NODEID_NUMERIC(1, 2000 + i),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                    UA_QUALIFIEDNAME(1, "Index"),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                    attr, ds, (void*)(uintptr_t)i, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    UA_Argument arg;
+    UA_Argument_init(&arg);
+    arg.dataType = UA_TYPES[UA_TYPES_UINT32].typeId;
+    arg.valueRank = UA_VALUERANK_SCALAR;
+    UA_MethodAttributes mattr = UA_MethodAttributes_default;
+    mattr.executable = true;
+    mattr.userExecutable = true;
+    UA_StatusCode res =
+        UA_Server_addMethodNode(tc.server, UA_NODEID_NUMERIC(1, 3000),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                UA_QUALIFIEDNAME(1, "Double"), mattr, doubleMethod,
+                                1, &arg, 1, &arg, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void setupParallel(void) {
+    tc.running = true;
+    tc.server = UA_Server_newForUnitTest();
+    ck_assert(tc.server != NULL);
+    UA_ServerConfig *config = UA_Server_getConfig(tc.server);
+    config->serviceWorkers = NUMBER_OF_SERVICE_WORKERS;
+    config->parallelOperationsThreshold = 16;
+    addParallelNodes();
+    UA_Server_run_startup(tc.server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+/* The chunks of a Read request take the server lock in shared mode */
+static void setupParallelShared(void) {
+    tc.running = true;
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_StatusCode res = UA_Nodestore_HashMapConcurrent(&config.nodestore);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ServerConfig_setDefault(&config);
+    config.eventLoop->dateTime_now = UA_DateTime_now_fake;
+    config.eventLoop->dateTime_nowMonotonic = UA_DateTime_now_fake;
+    config.tcpReuseAddr = true;
+    config.serviceWorkers = NUMBER_OF_SERVICE_WORKERS;
+    config.parallelOperationsThreshold = 16;
+    config.concurrentReadServices = true;
+    tc.server = UA_Server_newWithConfig(&config);
+    ck_assert(tc.server != NULL);
+    addParallelNodes();
+    UA_Server_run_startup(tc.server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+START_TEST(parallelRead) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_ReadValueId rvi[PARALLEL_OPERATIONS];
+    for(UA_UInt32 i = 0; i < PARALLEL_OPERATIONS; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        rvi[i].nodeId = UA_NODEID_NUMERIC(1, 2000 + i);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = rvi;
+    request.nodesToReadSize = PARALLEL_OPERATIONS;
+
+    UA_ReadResponse response = UA_Client_Service_read(client, request);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, PARALLEL_OPERATIONS);
+    for(UA_UInt32 i = 0; i < PARALLEL_OPERATIONS; i++) {
+        UA_Variant *v = &response.results[i].value;
+        ck_assert(UA_Variant_hasScalarType(v, &UA_TYPES[UA_TYPES_UINT32]));
+        ck_assert_uint_eq(*(UA_UInt32*)v->data, i);
+    }
+    UA_ReadResponse_clear(&response);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+START_TEST(parallelReadCloseSession) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_ReadValueId rvi[PARALLEL_OPERATIONS];
+    for(UA_UInt32 i = 0; i < PARALLEL_OPERATIONS; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        rvi[i].nodeId = UA_NODEID_NUMERIC(1, 2000 + i);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = rvi;
+    request.nodesToReadSize = PARALLEL_OPERATIONS;
+
+    /* The response is still sent. The session is freed only afterwards. */
+    closeSessionInRead = true;
+    UA_ReadResponse response = UA_Client_Service_read(client, request);
+    closeSessionInRead = false;
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, PARALLEL_OPERATIONS);
+    UA_ReadResponse_clear(&response);
+
+    /* The session is gone */
+    UA_Variant val;
+    retval = UA_Client_readValueAttribute(client, UA_NODEID_NUMERIC(1, 2000), &val);
+    ck_assert_uint_ne(retval, UA_STATUSCODE_GOOD);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+START_TEST(parallelCall) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_UInt32 inputs[PARALLEL_OPERATIONS];
+    UA_Variant args[PARALLEL_OPERATIONS];
+    UA_CallMethodRequest cmr[PARALLEL_OPERATIONS];
+    for(UA_UInt32 i = 0; i < PARALLEL_OPERATIONS; i++) {
+        inputs[i] = i;
+        UA_Variant_setScalar(&args[i], &inputs[i], &UA_TYPES[UA_TYPES_UINT32]);
+        UA_CallMethodRequest_init(&cmr[i]);
+        cmr[i].objectId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+        cmr[i].methodId = UA_NODEID_NUMERIC(1, 3000);
+        cmr[i].inputArguments = &args[i];
+        cmr[i].inputArgumentsSize = 1;
+    }
+    UA_CallRequest request;
+    UA_CallRequest_init(&request);
+    request.methodsToCall = cmr;
+    request.methodsToCallSize = PARALLEL_OPERATIONS;
+
+    UA_CallResponse response = UA_Client_Service_call(client, request);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, PARALLEL_OPERATIONS);
+    for(UA_UInt32 i = 0; i < PARALLEL_OPERATIONS; i++) {
+        UA_CallMethodResult *r = &response.results[i];
+        ck_assert_uint_eq(r->statusCode, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(r->outputArgumentsSize, 1);
+        ck_assert_uint_eq(*(UA_UInt32*)r->outputArguments[0].data, 2 * i);
+    }
+    UA_CallResponse_clear(&response);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+static volatile size_t operationsDone;
+
+static void
+countOperation(UA_Server *server, void *context, size_t index) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    operationsDone++;
+}
+
+/* The lock cannot be released if it is held more than once. Then the
+ * operations are executed sequentially. */
+START_TEST(parallelNestedLock) {
+    operationsDone = 0;
+    lockServer(tc.server);
+    lockServer(tc.server);
+    UA_ServerWorkers_processOperations(tc.server, &tc.server->adminSession,
+                                       countOperation, NULL, PARALLEL_OPERATIONS);
+    unlockServer(tc.server);
+    unlockServer(tc.server);
+    ck_assert_uint_eq(operationsDone, PARALLEL_OPERATIONS);
+} END_TEST
+
+/* With a Nodestore that supports concurrent reads, Read and Browse requests
+ * are executed under the shared server lock. Meanwhile, the value is written
+ * under the exclusive lock. */
+static void setupConcurrentRead(void) {
+    tc.running = true;
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_StatusCode res = UA_Nodestore_HashMapConcurrent(&config.nodestore);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ServerConfig_setDefault(&config);
+    config.eventLoop->dateTime_now = UA_DateTime_now_fake;
+    config.eventLoop->dateTime_nowMonotonic = UA_DateTime_now_fake;
+    config.tcpReuseAddr = true;
+    config.serviceWorkers = NUMBER_OF_SERVICE_WORKERS;
+    config.concurrentReadServices = true;
+    tc.server = UA_Server_newWithConfig(&config);
+    ck_assert(tc.server != NULL);
+    addVariableNode();
+    UA_Server_run_startup(tc.server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static UA_Client *readClients[MAX_READ_CLIENTS];
+static THREAD_HANDLE readThreads[MAX_READ_CLIENTS];
+static size_t readClientIndex[MAX_READ_CLIENTS];
+static volatile UA_Boolean writing;
+
+/* The continuation point is added to the session under the exclusive lock */
+static void
+browseWithContinuationPoint(UA_Client *client) {
+    UA_BrowseRequest request;
+    UA_BrowseRequest_init(&request);
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    request.requestedMaxReferencesPerNode = 1;
+    request.nodesToBrowse = &bd;
+    request.nodesToBrowseSize = 1;
+    UA_BrowseResponse response = UA_Client_Service_browse(client, request);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 1);
+    ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.results[0].referencesSize, 1);
+    ck_assert(response.results[0].continuationPoint.length > 0);
+
+    UA_BrowseNextRequest nextRequest;
+    UA_BrowseNextRequest_init(&nextRequest);
+    nextRequest.releaseContinuationPoints = true;
+    nextRequest.continuationPoints = &response.results[0].continuationPoint;
+    nextRequest.continuationPointsSize = 1;
+    UA_BrowseNextResponse nextResponse =
+        UA_Client_Service_browseNext(client, nextRequest);
+    ck_assert_uint_eq(nextResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_BrowseNextResponse_clear(&nextResponse);
+    UA_BrowseResponse_clear(&response);
+}
+
+THREAD_CALLBACK_PARAM(readLoop, val) {
+    UA_Client *client = readClients[*(size_t*)val];
+    /* Has the prefix of the virtual diagnostics nodes */
+    UA_Byte unknownIdBuf[28] = {'D', 'I', 'A', 'G'};
+    UA_NodeId unknownId = UA_NODEID_BYTESTRING(1, NULL);
+    unknownId.identifier.byteString.length = sizeof(unknownIdBuf);
+    unknownId.identifier.byteString.data = unknownIdBuf;
+    for(size_t i = 0; i < CONCURRENT_READS; i++) {
+        UA_Variant val;
+        UA_StatusCode res = UA_Client_readValueAttribute(client, counterId, &val);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert(UA_Variant_hasScalarType(&val, &UA_TYPES[UA_TYPES_INT32]));
+        ck_assert_int_eq(42, *(UA_Int32*)val.data);
+        UA_Variant_clear(&val);
+
+        /* Virtual diagnostics nodes are looked up under the shared lock */
+        if(i % 10 == 0) {
+            UA_LocalizedText lt;
+            res = UA_Client_readDisplayNameAttribute(client, unknownId, &lt);
+            ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+        }
+
+        if(i % 10 == 5)
+            browseWithContinuationPoint(client);
+    }
+    return 0;
+}
+
+THREAD_CALLBACK(writeLoop) {
+    UA_Int32 value = 42;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+    while(writing) {
+        UA_StatusCode res = UA_Server_writeValue(tc.server, counterId, v);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    return 0;
+}
+
+/* Returns the reads per second */
+static double
+readWithClients(size_t clients) {
+    for(size_t i = 0; i < clients; i++) {
+        readClients[i] = UA_Client_newForUnitTest();
+        UA_StatusCode res = UA_Client_connect(readClients[i], "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        readClientIndex[i] = i;
+    }
+
+    UA_DateTime begin = UA_DateTime_nowMonotonic();
+    for(size_t i = 0; i < clients; i++)
+        THREAD_CREATE_PARAM(readThreads[i], readLoop, readClientIndex[i]);
+    for(size_t i = 0; i < clients; i++)
+        THREAD_JOIN(readThreads[i]);
+    UA_DateTime duration = UA_DateTime_nowMonotonic() - begin;
+
+    for(size_t i = 0; i < clients; i++) {
+        UA_Client_disconnect(readClients[i]);
+        UA_Client_delete(readClients[i]);
+    }
+    return (double)(clients * CONCURRENT_READS) /
+        ((double)duration / UA_DATETIME_SEC);
+}
+
+START_TEST(concurrentReadWhileWriting) {
+    writing = true;
+    THREAD_HANDLE writer;
+    THREAD_CREATE(writer, writeLoop);
+    readWithClients(4);
+    writing = false;
+    THREAD_JOIN(writer);
+} END_TEST
+
+/* Benchmark the Read throughput for an increasing number of clients. The
+ * throughput scales with the number of clients up to the number of service
+ * workers and CPU cores. */
+START_TEST(concurrentReadScaling) {
+    for(size_t clients = 1; clients <= MAX_READ_CLIENTS; clients *= 2) {
+        double rate = readWithClients(clients);
+        printf("Concurrent Read: %lu clients, %u service workers: %.0f reads/s\n",
+               (unsigned long)clients, NUMBER_OF_SERVICE_WORKERS, rate);
+    }
+} END_TEST
+
+/* The EventLoop polls the sockets in additional reactor threads. They dispatch
+ * the received messages without the EventLoop lock. */
+static void setupReactors(void) {
+    tc.running = true;
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_StatusCode res = UA_Nodestore_HashMapConcurrent(&config.nodestore);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The default config starts the EventLoop. Configure it before. */
+    config.eventLoop = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_UInt16 reactors = 2;
+    UA_KeyValueMap_setScalar(&config.eventLoop->params,
+                             UA_QUALIFIEDNAME(0, "reactor-threads"),
+                             &reactors, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_ConnectionManager *tcpCM =
+        UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcp connection manager"));
+    config.eventLoop->registerEventSource(config.eventLoop, &tcpCM->eventSource);
+    UA_ServerConfig_setDefault(&config);
+    config.eventLoop->dateTime_now = UA_DateTime_now_fake;
+    config.eventLoop->dateTime_nowMonotonic = UA_DateTime_now_fake;
+    config.tcpReuseAddr = true;
+    config.serviceWorkers = NUMBER_OF_SERVICE_WORKERS;
+    config.concurrentReadServices = true;
+    tc.server = UA_Server_newWithConfig(&config);
+    ck_assert(tc.server != NULL);
+    addVariableNode();
+    UA_Server_run_startup(tc.server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+START_TEST(readWithReactors) {
+    writing = true;
+    THREAD_HANDLE writer;
+    THREAD_CREATE(writer, writeLoop);
+    readWithClients(MAX_READ_CLIENTS);
+    writing = false;
+    THREAD_JOIN(writer);
+} END_TEST
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+
+/* Publish responses are sent while other clients send requests. The sending of
+ * a worker that holds the server lock must not wait for the EventLoop. */
+static void setupPublish(void) {
+    tc.running = true;
+    tc.server = UA_Server_new(); /* The real clock drives the publishing */
+    ck_assert(tc.server != NULL);
+    UA_ServerConfig *config = UA_Server_getConfig(tc.server);
+    config->tcpReuseAddr = true;
+    config->serviceWorkers = NUMBER_OF_SERVICE_WORKERS;
+    addVariableNode();
+    UA_Server_run_startup(tc.server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static volatile UA_Boolean publishing;
+static volatile size_t notifications;
+
+static void
+dataChangeHandler(UA_Client *client, UA_UInt32 subId, void *subContext,
+                  UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    notifications++;
+}
+
+THREAD_CALLBACK(subscriberLoop) {
+    UA_Client *client = UA_Client_new();
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    request.requestedPublishingInterval = 10.0;
+    UA_CreateSubscriptionResponse response =
+        UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+
+    /* The current time changes with every sample */
+    UA_MonitoredItemCreateRequest item =
+        UA_MonitoredItemCreateRequest_default(
+            UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME));
+    item.requestedParameters.samplingInterval = 10.0;
+    UA_MonitoredItemCreateResult result =
+        UA_Client_MonitoredItems_createDataChange(client, response.subscriptionId,
+                                                  UA_TIMESTAMPSTORETURN_BOTH, item,
+                                                  NULL, dataChangeHandler, NULL);
+    ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+
+    while(publishing) {
+        res = UA_Client_run_iterate(client, 10);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    return 0;
+}
+
+START_TEST(publishWhileRequests) {
+    notifications = 0;
+    publishing = true;
+    THREAD_HANDLE subscriber;
+    THREAD_CREATE(subscriber, subscriberLoop);
+    for(size_t i = 0; i < 10 && notifications < PUBLISH_NOTIFICATIONS; i++)
+        readWithClients(4);
+    publishing = false;
+    THREAD_JOIN(subscriber);
+    ck_assert_uint_ge(notifications, PUBLISH_NOTIFICATIONS);
+} END_TEST
+
+#endif /* UA_ENABLE_SUBSCRIPTIONS */
+
+static void teardownServer(void) {
+    tc.running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(tc.server);
+    UA_Server_delete(tc.server);
+}
+
+static Suite* testSuite_serviceWorkers(void) {
+    Suite *s = suite_create("Service Workers");
+    TCase *tc_read = tcase_create("Concurrent Read");
+    tcase_add_checked_fixture(tc_read, setup, teardown);
+    tcase_add_test(tc_read, readValueAttributeWorkers);
+    suite_add_tcase(s, tc_read);
+    TCase *tc_pipelined = tcase_create("Pipelined Requests");
+    tcase_add_checked_fixture(tc_pipelined, setup, teardownServer);
+    tcase_add_test(tc_pipelined, pipelinedRequests);
+    suite_add_tcase(s, tc_pipelined);
+    TCase *tc_parallel = tcase_create("Parallel Operations");
+    tcase_add_checked_fixture(tc_parallel, setupParallel, teardownServer);
+    tcase_add_test(tc_parallel, parallelRead);
+    tcase_add_test(tc_parallel, parallelReadCloseSession);
+    tcase_add_test(tc_parallel, parallelCall);
+    tcase_add_test(tc_parallel, parallelNestedLock);
+    suite_add_tcase(s, tc_parallel);
+    TCase *tc_parallel_shared = tcase_create("Parallel Operations Shared Lock");
+    tcase_add_checked_fixture(tc_parallel_shared, setupParallelShared, teardownServer);
+    tcase_add_test(tc_parallel_shared, parallelRead);
+    tcase_add_test(tc_parallel_shared, parallelReadCloseSession);
+    suite_add_tcase(s, tc_parallel_shared);
+    TCase *tc_concurrent = tcase_create("Concurrent Read Nodestore");
+    tcase_add_checked_fixture(tc_concurrent, setupConcurrentRead, teardownServer);
+    tcase_add_test(tc_concurrent, concurrentReadWhileWriting);
+    tcase_add_test(tc_concurrent, concurrentReadScaling);
+    suite_add_tcase(s, tc_concurrent);
+    TCase *tc_reactors = tcase_create("Reactor Threads");
+    tcase_add_checked_fixture(tc_reactors, setupReactors, teardownServer);
+    tcase_add_test(tc_reactors, readWithReactors);
+    suite_add_tcase(s, tc_reactors);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    TCase *tc_publish = tcase_create("Publish while Requests");
+    tcase_add_checked_fixture(tc_publish, setupPublish, teardownServer);
+    tcase_add_test(tc_publish, publishWhileRequests);
+    suite_add_tcase(s, tc_publish);
+#endif
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_serviceWorkers();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+
+    createThreadContext(0, NUMBER_OF_CLIENTS, checkThroughput);
+    initReadTest();
+    srunner_run_all(sr, CK_NORMAL);
+    deleteThreadContext();
+
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -13,19 +13,28 @@
 #include <time.h>
 #include "check.h"
 
-#if UA_MULTITHREADING >= 200
+#if UA_MULTITHREADING >= 100
 #include <pthread.h>
 #endif
 
 UA_Nodestore ns;
+UA_StatusCode (*resolveReferences)(UA_Nodestore *ns);
 
 static void setupZipTree(void) {
     UA_Nodestore_ZipTree(&ns);
+    resolveReferences = UA_Nodestore_ZipTree_resolveReferences;
 }
 
 static void setupHashMap(void) {
     UA_Nodestore_HashMap(&ns);
+    resolveReferences = UA_Nodestore_HashMap_resolveReferences;
+}
+
+#if UA_MULTITHREADING >= 100
+static void setupHashMapConcurrent(void) {
+    UA_Nodestore_HashMapConcurrent(&ns);
 }
+#endif
 
 static void teardown(void) {
     ns.clear(ns.context);
@@ -219,6 +228,207 @@ static void *profileGetThread(void *arg) {
 }
 #endif
 
+/* Returns the target with the NodeId in the first ReferenceKind of the node */
+static const UA_ReferenceTarget *
+getTarget(const UA_Node *node, const UA_NodeId *id) {
+    UA_ExpandedNodeId en;
+    UA_ExpandedNodeId_init(&en);
+    en.nodeId = *id;
+    ck_assert_uint_eq(node->head.referencesSize, 1);
+    return UA_NodeReferenceKind_findTarget(&node->head.references[0], &en);
+}
+
+START_TEST(resolveReferencesToNodePointers) {
+    UA_NodeId srcId = UA_NODEID_NUMERIC(1, 1);
+    UA_NodeId ids[4] = {UA_NODEID_NUMERIC(1, 2), UA_NODEID_NUMERIC(1, 3),
+                        UA_NODEID_STRING(1, "string"), UA_NODEID_NUMERIC(1, 99)};
+
+    /* The source points to three nodes and one NodeId without a node */
+    UA_Node *src = createNode(1, 1);
+    for(size_t i = 0; i < 4; i++) {
+        UA_ExpandedNodeId en;
+        UA_ExpandedNodeId_init(&en);
+        en.nodeId = ids[i];
+        ck_assert_int_eq(UA_Node_addReference(src, 0, true, &en, 0),
+                         UA_STATUSCODE_GOOD);
+    }
+    ck_assert_int_eq(ns.insertNode(ns.context, src, NULL), UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 3; i++) {
+        UA_Node *n = ns.newNode(ns.context, UA_NODECLASS_VARIABLE);
+        UA_NodeId_copy(&ids[i], &n->head.nodeId);
+        ck_assert_int_eq(ns.insertNode(ns.context, n, NULL), UA_STATUSCODE_GOOD);
+    }
+
+    ck_assert_int_eq(resolveReferences(&ns), UA_STATUSCODE_GOOD);
+
+    /* The targets point directly to the nodes */
+    const UA_Node *node = ns.getNode(ns.context, &srcId, ~(UA_UInt32)0,
+                                     UA_REFERENCETYPESET_ALL,
+                                     UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_ne(node, NULL);
+    const UA_ReferenceTarget *t[4];
+    for(size_t i = 0; i < 4; i++) {
+        t[i] = getTarget(node, &ids[i]);
+        ck_assert_ptr_ne(t[i], NULL);
+    }
+    for(size_t i = 0; i < 3; i++) {
+        const UA_NodeHead *head = UA_NodePointer_getNode(t[i]->targetId);
+        ck_assert_ptr_ne(head, NULL);
+        ck_assert(UA_NodeId_equal(&head->nodeId, &ids[i]));
+        const UA_Node *target =
+            ns.getNodeFromPtr(ns.context, t[i]->targetId, ~(UA_UInt32)0,
+                              UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+        ck_assert_ptr_eq((const void*)target, (const void*)head);
+        ns.releaseNode(ns.context, target);
+    }
+    ck_assert_ptr_eq(UA_NodePointer_getNode(t[3]->targetId), NULL);
+
+    /* Replace one target and remove the others. The pointers are still safe to
+     * use and lead to the current version of the node. */
+    UA_Node *copy = NULL;
+    ck_assert_int_eq(ns.getNodeCopy(ns.context, &ids[0], &copy), UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(ns.replaceNode(ns.context, copy), UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(ns.removeNode(ns.context, &ids[1]), UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(ns.removeNode(ns.context, &ids[2]), UA_STATUSCODE_GOOD);
+    const UA_Node *target =
+        ns.getNodeFromPtr(ns.context, t[0]->targetId, ~(UA_UInt32)0,
+                          UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_eq(target, copy);
+    ns.releaseNode(ns.context, target);
+    for(size_t i = 1; i < 3; i++) {
+        ck_assert_ptr_eq(ns.getNodeFromPtr(ns.context, t[i]->targetId, ~(UA_UInt32)0,
+                                           UA_REFERENCETYPESET_ALL,
+                                           UA_BROWSEDIRECTION_BOTH), NULL);
+        UA_NodeId id = UA_NodePointer_toNodeId(t[i]->targetId);
+        ck_assert(UA_NodeId_equal(&id, &ids[i]));
+    }
+
+    /* Resolve again. The removed nodes become NodeIds again. */
+    ck_assert_int_eq(resolveReferences(&ns), UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(UA_NodePointer_getNode(t[0]->targetId), &copy->head);
+    for(size_t i = 1; i < 4; i++) {
+        ck_assert_ptr_eq(UA_NodePointer_getNode(t[i]->targetId), NULL);
+        ck_assert_ptr_eq(getTarget(node, &ids[i]), t[i]);
+    }
+
+    /* References to direct targets can be removed */
+    UA_ExpandedNodeId en;
+    UA_ExpandedNodeId_init(&en);
+    en.nodeId = ids[0];
+    ck_assert_int_eq(UA_Node_deleteReference((UA_Node*)(uintptr_t)node, 0, true, &en),
+                     UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(getTarget(node, &ids[0]), NULL);
+    ns.releaseNode(ns.context, node);
+}
+END_TEST
+
+/* Removing the nodes that point to removed nodes frees the tombstones. Enough
+ * rounds to trigger several sweeps of the graveyard. */
+START_TEST(removeSourcesOfDirectPointers) {
+    for(UA_UInt32 round = 0; round < 500; round++) {
+        UA_NodeId srcId = UA_NODEID_NUMERIC(1, 1);
+        UA_NodeId targetId = UA_NODEID_NUMERIC(1, 2);
+        UA_Node *src = createNode(1, 1);
+        UA_ExpandedNodeId en;
+        UA_ExpandedNodeId_init(&en);
+        en.nodeId = targetId;
+        ck_assert_int_eq(UA_Node_addReference(src, 0, true, &en, 0),
+                         UA_STATUSCODE_GOOD);
+        /* Point to itself */
+        en.nodeId = srcId;
+        ck_assert_int_eq(UA_Node_addReference(src, 0, true, &en, 0),
+                         UA_STATUSCODE_GOOD);
+        ck_assert_int_eq(ns.insertNode(ns.context, src, NULL), UA_STATUSCODE_GOOD);
+        UA_Node *target = createNode(1, 2);
+        ck_assert_int_eq(ns.insertNode(ns.context, target, NULL), UA_STATUSCODE_GOOD);
+        ck_assert_int_eq(resolveReferences(&ns), UA_STATUSCODE_GOOD);
+
+        /* The target becomes a tombstone. The source resolves the pointer via
+         * the NodeId to the new version of the target. */
+        ck_assert_int_eq(ns.removeNode(ns.context, &targetId), UA_STATUSCODE_GOOD);
+        target = createNode(1, 2);
+        ck_assert_int_eq(ns.insertNode(ns.context, target, NULL), UA_STATUSCODE_GOOD);
+        const UA_Node *node = ns.getNode(ns.context, &srcId, ~(UA_UInt32)0,
+                                         UA_REFERENCETYPESET_ALL,
+                                         UA_BROWSEDIRECTION_BOTH);
+        ck_assert_ptr_ne(node, NULL);
+        ck_assert_uint_eq(node->head.references[0].targetsSize, 2);
+        for(size_t i = 0; i < 2; i++) {
+            const UA_Node *t =
+                ns.getNodeFromPtr(ns.context,
+                                  node->head.references[0].targets.array[i].targetId,
+                                  ~(UA_UInt32)0, UA_REFERENCETYPESET_ALL,
+                                  UA_BROWSEDIRECTION_BOTH);
+            ck_assert_ptr_ne(t, NULL);
+            ns.releaseNode(ns.context, t);
+        }
+        ns.releaseNode(ns.context, node);
+
+        /* Removing the source drops the last pointer to the tombstone */
+        ck_assert_int_eq(ns.removeNode(ns.context, &srcId), UA_STATUSCODE_GOOD);
+        ck_assert_int_eq(ns.removeNode(ns.context, &targetId), UA_STATUSCODE_GOOD);
+    }
+}
+END_TEST
+
+/* The table grows and shrinks incrementally. All nodes remain reachable while
+ * entries are migrated between the slot arrays. */
+#define RESIZE_NODES 200000
+
+static UA_Boolean
+hasNode(UA_UInt32 i) {
+    UA_NodeId id = UA_NODEID_NUMERIC(1, i);
+    const UA_Node *n = ns.getNode(ns.context, &id, 0, UA_REFERENCETYPESET_NONE,
+                                  UA_BROWSEDIRECTION_INVALID);
+    if(!n)
+        return false;
+    ns.releaseNode(ns.context, n);
+    return true;
+}
+
+static void countVisitor(void *context, const UA_Node *node) {
+    (*(size_t*)context)++;
+}
+
+START_TEST(resizeIncrementally) {
+    UA_DateTime maxStall = 0;
+    for(UA_UInt32 i = 1; i <= RESIZE_NODES; i++) {
+        UA_DateTime before = UA_DateTime_nowMonotonic();
+        ck_assert_int_eq(ns.insertNode(ns.context, createNode(1, i), NULL),
+                         UA_STATUSCODE_GOOD);
+        UA_DateTime stall = UA_DateTime_nowMonotonic() - before;
+        if(stall > maxStall)
+            maxStall = stall;
+        /* Spot checks during the migration */
+        ck_assert(hasNode(i));
+        ck_assert(hasNode((i / 2) + 1));
+        ck_assert(!hasNode(RESIZE_NODES + i));
+    }
+    printf("Insert %d nodes: max stall %.3fms\n", RESIZE_NODES,
+           (double)maxStall / UA_DATETIME_MSEC);
+
+    /* Inserting an existing NodeId fails also during a migration */
+    ck_assert_int_eq(ns.insertNode(ns.context, createNode(1, 1), NULL),
+                     UA_STATUSCODE_BADNODEIDEXISTS);
+
+    /* Remove most nodes. This shrinks the table. */
+    for(UA_UInt32 i = 1; i <= RESIZE_NODES; i++) {
+        if(i % 16 == 0)
+            continue;
+        UA_NodeId id = UA_NODEID_NUMERIC(1, i);
+        ck_assert_int_eq(ns.removeNode(ns.context, &id), UA_STATUSCODE_GOOD);
+        ck_assert(!hasNode(i));
+        ck_assert(hasNode(((i / 16) + 1) * 16));
+    }
+
+    size_t count = 0;
+    ns.iterate(ns.context, countVisitor, &count);
+    ck_assert_uint_eq(count, RESIZE_NODES / 16);
+    for(UA_UInt32 i = 16; i <= RESIZE_NODES; i += 16)
+        ck_assert(hasNode(i));
+}
+END_TEST
+
 #define N 10000 /* make bigger to test */
 
 START_TEST(profileGetDelete) {
@@ -257,6 +467,300 @@ START_TEST(profileGetDelete) {
 }
 END_TEST
 
+/* Lookup throughput in a nodestore with 1M nodes. For numeric and string
+ * NodeIds. */
+#define LOOKUP_NODES 1000000
+
+static void
+profileLookup(UA_Boolean stringIds) {
+    char buf[32];
+    UA_NodeId *ids = (UA_NodeId*)UA_calloc(LOOKUP_NODES, sizeof(UA_NodeId));
+    ck_assert_ptr_ne(ids, NULL);
+    for(UA_UInt32 i = 0; i < LOOKUP_NODES; i++) {
+        if(stringIds) {
+            snprintf(buf, sizeof(buf), "Plant.Line%u.Tag%u", i % 100, i);
+            ids[i] = UA_NODEID_STRING_ALLOC(1, buf);
+        } else {
+            ids[i] = UA_NODEID_NUMERIC(1, i + 1);
+        }
+        UA_Node *n = ns.newNode(ns.context, UA_NODECLASS_OBJECT);
+        UA_NodeId_copy(&ids[i], &n->head.nodeId);
+        ck_assert_int_eq(ns.insertNode(ns.context, n, NULL), UA_STATUSCODE_GOOD);
+    }
+
+    /* Lookup in a pseudo-random order to defeat the caches */
+    UA_UInt32 seed = 42;
+    UA_DateTime begin = UA_DateTime_nowMonotonic();
+    for(UA_UInt32 i = 0; i < LOOKUP_NODES; i++) {
+        seed = seed * 1103515245u + 12345u;
+        const UA_NodeId *id = &ids[(seed >> 4) % LOOKUP_NODES];
+        const UA_Node *n = ns.getNode(ns.context, id, 0, UA_REFERENCETYPESET_NONE,
+                                      UA_BROWSEDIRECTION_INVALID);
+        ck_assert_ptr_ne(n, NULL);
+        ns.releaseNode(ns.context, n);
+    }
+    UA_DateTime end = UA_DateTime_nowMonotonic();
+    printf("%d lookups of %s NodeIds in a nodestore with %d nodes: %.2fM lookups/s\n",
+           LOOKUP_NODES, stringIds ? "string" : "numeric", LOOKUP_NODES,
+           (double)LOOKUP_NODES / ((double)(end - begin) / UA_DATETIME_SEC) / 1e6);
+
+    UA_Array_delete(ids, LOOKUP_NODES, &UA_TYPES[UA_TYPES_NODEID]);
+}
+
+START_TEST(profileLookupNumeric) {
+    profileLookup(false);
+}
+END_TEST
+
+START_TEST(profileLookupString) {
+    profileLookup(true);
+}
+END_TEST
+
+#if UA_MULTITHREADING >= 100
+
+/* Edits are copy-on-write. The original stays visible until the release. */
+START_TEST(editNodeIsCopyOnWrite) {
+    UA_Node *n1 = createNode(0, 2253);
+    ns.insertNode(ns.context, n1, NULL);
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 2253);
+
+    const UA_Node *held = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                     UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    UA_Node *edit = ns.getEditNode(ns.context, &id, ~(UA_UInt32)0,
+                                   UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_ne(edit, NULL);
+    ck_assert_ptr_ne(edit, held);
+    edit->head.writeMask = 42;
+
+    const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                  UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_uint_eq(n->head.writeMask, 0);
+    ns.releaseNode(ns.context, n);
+
+    /* Nested edits share the copy. Releasing the inner edit publishes the
+     * changes made so far. */
+    UA_Node *edit2 = ns.getEditNode(ns.context, &id, ~(UA_UInt32)0,
+                                    UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_eq(edit, edit2);
+    ns.releaseNode(ns.context, edit2);
+
+    n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                   UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_uint_eq(n->head.writeMask, 42);
+    ns.releaseNode(ns.context, n);
+
+    /* Publish the outer edit */
+    edit->head.writeMask = 43;
+    ns.releaseNode(ns.context, edit);
+    n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                   UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_uint_eq(n->head.writeMask, 43);
+    ns.releaseNode(ns.context, n);
+
+    /* The held node is still valid (but outdated) */
+    ck_assert_uint_eq(held->head.writeMask, 0);
+    ns.releaseNode(ns.context, held);
+}
+END_TEST
+
+/* A replace cannot overwrite an open edit. The edit of a removed node is
+ * discarded on release. */
+START_TEST(replaceDuringEdit) {
+    UA_Node *n1 = createNode(0, 2253);
+    ns.insertNode(ns.context, n1, NULL);
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 2253);
+
+    UA_Node *copy;
+    ck_assert_uint_eq(ns.getNodeCopy(ns.context, &id, &copy), UA_STATUSCODE_GOOD);
+    copy->head.writeMask = 1;
+    UA_Node *edit = ns.getEditNode(ns.context, &id, ~(UA_UInt32)0,
+                                   UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    edit->head.writeMask = 2;
+    ck_assert_uint_eq(ns.replaceNode(ns.context, copy), UA_STATUSCODE_BADINTERNALERROR);
+    ns.releaseNode(ns.context, edit);
+
+    const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                  UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_uint_eq(n->head.writeMask, 2);
+    ns.releaseNode(ns.context, n);
+
+    /* Remove while the edit is open */
+    edit = ns.getEditNode(ns.context, &id, ~(UA_UInt32)0,
+                          UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    edit->head.writeMask = 3;
+    ck_assert_uint_eq(ns.removeNode(ns.context, &id), UA_STATUSCODE_GOOD);
+    ns.releaseNode(ns.context, edit);
+    n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                   UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_eq(n, NULL);
+}
+END_TEST
+
+#define RACE_ROUNDS 20000
+
+static void *
+replaceThread(void *arg) {
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 2253);
+    for(size_t i = 0; i < RACE_ROUNDS; i++) {
+        UA_StatusCode res;
+        do {
+            UA_Node *copy;
+            res = ns.getNodeCopy(ns.context, &id, &copy);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+            copy->head.writeMask++;
+            res = ns.replaceNode(ns.context, copy);
+        } while(res == UA_STATUSCODE_BADINTERNALERROR); /* Retry on conflict */
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    return NULL;
+}
+
+/* Every update is applied exactly once when edits and replacements of the
+ * same node race */
+START_TEST(replaceRacesEdit) {
+    UA_Node *n1 = createNode(0, 2253);
+    ns.insertNode(ns.context, n1, NULL);
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 2253);
+
+    pthread_t t;
+    pthread_create(&t, NULL, replaceThread, NULL);
+    for(size_t i = 0; i < RACE_ROUNDS; i++) {
+        UA_Node *edit = ns.getEditNode(ns.context, &id, ~(UA_UInt32)0,
+                                       UA_REFERENCETYPESET_ALL,
+                                       UA_BROWSEDIRECTION_BOTH);
+        ck_assert_ptr_ne(edit, NULL);
+        edit->head.writeMask++;
+        ns.releaseNode(ns.context, edit);
+    }
+    pthread_join(t, NULL);
+
+    const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                  UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_uint_eq(n->head.writeMask, 2 * RACE_ROUNDS);
+    ns.releaseNode(ns.context, n);
+}
+END_TEST
+
+#define CN 100000 /* Nodes for the concurrent read tests */
+#define CREADS 1000000 /* Lookups per thread */
+#define CTHREADS_MAX 8
+
+static pthread_mutex_t nsLock = PTHREAD_MUTEX_INITIALIZER;
+static UA_Boolean useLock;
+static volatile UA_Boolean writerRunning;
+static volatile size_t readErrors;
+
+static void *
+concurrentReadThread(void *arg) {
+    UA_UInt32 seed = (UA_UInt32)(uintptr_t)arg;
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 0);
+    for(size_t i = 0; i < CREADS; i++) {
+        seed = seed * 1103515245u + 12345u; /* Cheap LCG */
+        id.identifier.numeric = ((seed >> 8) % CN) + 1;
+        if(useLock)
+            pthread_mutex_lock(&nsLock);
+        const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                      UA_REFERENCETYPESET_ALL,
+                                      UA_BROWSEDIRECTION_BOTH);
+        if(!n || n->head.nodeId.identifier.numeric != id.identifier.numeric)
+            readErrors++;
+        ns.releaseNode(ns.context, n);
+        if(useLock)
+            pthread_mutex_unlock(&nsLock);
+    }
+    return NULL;
+}
+
+/* Replace nodes and add/remove extra nodes while the readers are active. This
+ * forces the table to be resized. */
+static void *
+concurrentWriteThread(void *arg) {
+    UA_UInt32 i = 0;
+    while(writerRunning) {
+        UA_NodeId id = UA_NODEID_NUMERIC(0, (i % CN) + 1);
+        UA_Node *edit = ns.getEditNode(ns.context, &id, ~(UA_UInt32)0,
+                                       UA_REFERENCETYPESET_ALL,
+                                       UA_BROWSEDIRECTION_BOTH);
+        if(edit) {
+            edit->head.writeMask = i;
+            ns.releaseNode(ns.context, edit);
+        }
+        UA_Node *n = createNode(1, (i % 1000) + 1);
+        ns.insertNode(ns.context, n, NULL);
+        if(i % 1000 == 999) {
+            for(UA_UInt32 j = 1; j <= 1000; j++) {
+                id = UA_NODEID_NUMERIC(1, j);
+                ns.removeNode(ns.context, &id);
+            }
+        }
+        i++;
+    }
+    return NULL;
+}
+
+static double
+runConcurrentReads(size_t threads, UA_Boolean withWriter) {
+    pthread_t t[CTHREADS_MAX];
+    pthread_t w;
+    readErrors = 0;
+    writerRunning = withWriter;
+    if(withWriter)
+        pthread_create(&w, NULL, concurrentWriteThread, NULL);
+    UA_DateTime begin = UA_DateTime_nowMonotonic();
+    for(size_t i = 0; i < threads; i++)
+        pthread_create(&t[i], NULL, concurrentReadThread, (void*)(uintptr_t)(i + 1));
+    for(size_t i = 0; i < threads; i++)
+        pthread_join(t[i], NULL);
+    UA_DateTime end = UA_DateTime_nowMonotonic();
+    if(withWriter) {
+        writerRunning = false;
+        pthread_join(w, NULL);
+    }
+    ck_assert_uint_eq(readErrors, 0);
+    return (double)(threads * CREADS) /
+        ((double)(end - begin) / (double)UA_DATETIME_SEC);
+}
+
+static void
+populate(void) {
+    for(UA_UInt32 i = 0; i < CN; i++) {
+        UA_Node *n = createNode(0, i+1);
+        ns.insertNode(ns.context, n, NULL);
+    }
+}
+
+START_TEST(concurrentReadDuringWrites) {
+    populate();
+    runConcurrentReads(4, true);
+}
+END_TEST
+
+/* Lookups per second for an increasing number of reader threads. The plain
+ * HashMap needs a lock to be used from several threads. */
+START_TEST(profileConcurrentRead) {
+    for(size_t threads = 1; threads <= CTHREADS_MAX; threads *= 2) {
+        UA_Nodestore_HashMap(&ns);
+        populate();
+        useLock = true;
+        double locked = runConcurrentReads(threads, false);
+        ns.clear(ns.context);
+
+        UA_Nodestore_HashMapConcurrent(&ns);
+        populate();
+        useLock = false;
+        double lockfree = runConcurrentReads(threads, false);
+        ns.clear(ns.context);
+
+        printf("%u reader threads: HashMap with lock %.2fM lookups/s, "
+               "HashMapConcurrent %.2fM lookups/s\n", (unsigned)threads,
+               locked / 1e6, lockfree / 1e6);
+    }
+}
+END_TEST
+
+#endif /* UA_MULTITHREADING >= 100 */
+
 static Suite * namespace_suite (void) {
     Suite *s = suite_create ("UA_NodeStore");
 
@@ -273,6 +777,8 @@ static Suite * namespace_suite (void) {
     tcase_add_checked_fixture(tc_replace, setupZipTree, teardown);
     tcase_add_test (tc_replace, replaceExistingNode);
     tcase_add_test (tc_replace, replaceOldNode);
+    tcase_add_test (tc_replace, resolveReferencesToNodePointers);
+    tcase_add_test (tc_replace, removeSourcesOfDirectPointers);
     suite_add_tcase (s, tc_replace);
 
     TCase* tc_iterate = tcase_create ("Iterate-ZipTree");
@@ -293,12 +799,15 @@ static Suite * namespace_suite (void) {
     tcase_add_test (tc_find_hm, findNodeInExpandedNamespace);
     tcase_add_test (tc_find_hm, failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries);
     tcase_add_test (tc_find_hm, failToFindNodeInOtherUA_NodeStore);
+    tcase_add_test (tc_find_hm, resizeIncrementally);
     suite_add_tcase (s, tc_find_hm);
 
     TCase *tc_replace_hm = tcase_create("Replace-HashMap");
     tcase_add_checked_fixture(tc_replace_hm, setupHashMap, teardown);
     tcase_add_test (tc_replace_hm, replaceExistingNode);
     tcase_add_test (tc_replace_hm, replaceOldNode);
+    tcase_add_test (tc_replace_hm, resolveReferencesToNodePointers);
+    tcase_add_test (tc_replace_hm, removeSourcesOfDirectPointers);
     suite_add_tcase (s, tc_replace_hm);
 
     TCase* tc_iterate_hm = tcase_create ("Iterate-HashMap");
@@ -310,8 +819,48 @@ static Suite * namespace_suite (void) {
     TCase* tc_profile_hm = tcase_create ("Profile-HashMap");
     tcase_add_checked_fixture(tc_profile_hm, setupHashMap, teardown);
     tcase_add_test (tc_profile_hm, profileGetDelete);
+    tcase_add_test (tc_profile_hm, profileLookupNumeric);
+    tcase_add_test (tc_profile_hm, profileLookupString);
+    tcase_set_timeout(tc_profile_hm, 60);
     suite_add_tcase (s, tc_profile_hm);
 
+#if UA_MULTITHREADING >= 100
+    TCase* tc_find_chm = tcase_create ("Find-HashMapConcurrent");
+    tcase_add_checked_fixture(tc_find_chm, setupHashMapConcurrent, teardown);
+    tcase_add_test (tc_find_chm, findNodeInUA_NodeStoreWithSingleEntry);
+    tcase_add_test (tc_find_chm, findNodeInUA_NodeStoreWithSeveralEntries);
+    tcase_add_test (tc_find_chm, findNodeInExpandedNamespace);
+    tcase_add_test (tc_find_chm, failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries);
+    tcase_add_test (tc_find_chm, failToFindNodeInOtherUA_NodeStore);
+    suite_add_tcase (s, tc_find_chm);
+
+    TCase *tc_replace_chm = tcase_create("Replace-HashMapConcurrent");
+    tcase_add_checked_fixture(tc_replace_chm, setupHashMapConcurrent, teardown);
+    tcase_add_test (tc_replace_chm, replaceExistingNode);
+    tcase_add_test (tc_replace_chm, replaceOldNode);
+    tcase_add_test (tc_replace_chm, editNodeIsCopyOnWrite);
+    tcase_add_test (tc_replace_chm, replaceDuringEdit);
+    tcase_add_test (tc_replace_chm, replaceRacesEdit);
+    suite_add_tcase (s, tc_replace_chm);
+
+    TCase* tc_iterate_chm = tcase_create ("Iterate-HashMapConcurrent");
+    tcase_add_checked_fixture(tc_iterate_chm, setupHashMapConcurrent, teardown);
+    tcase_add_test (tc_iterate_chm, iterateOverUA_NodeStoreShallNotVisitEmptyNodes);
+    tcase_add_test (tc_iterate_chm, iterateOverExpandedNamespaceShallNotVisitEmptyNodes);
+    suite_add_tcase (s, tc_iterate_chm);
+
+    TCase* tc_concurrent_chm = tcase_create ("Concurrent-HashMapConcurrent");
+    tcase_add_checked_fixture(tc_concurrent_chm, setupHashMapConcurrent, teardown);
+    tcase_add_test (tc_concurrent_chm, concurrentReadDuringWrites);
+    tcase_set_timeout(tc_concurrent_chm, 60);
+    suite_add_tcase (s, tc_concurrent_chm);
+
+    TCase* tc_profile_chm = tcase_create ("Profile-HashMapConcurrent");
+    tcase_add_test (tc_profile_chm, profileConcurrentRead);
+    tcase_set_timeout(tc_profile_chm, 120);
+    suite_add_tcase (s, tc_profile_chm);
+#endif
+
     return s;
 }
 
@@ -0,0 +1,267 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/plugin/nodestore_default.h>
+
+#include "test_helpers.h"
+
+#include <stdio.h>
+#include <time.h>
+#ifdef UA_ARCHITECTURE_POSIX
+#include <unistd.h>
+#endif
+
+#include "check.h"
+
+#define IMAGE_VARIABLE 62541
+
+static UA_ByteString image;
+static size_t imageNodes;
+
+static void
+countVisitor(void *visitorCtx, const UA_Node *node) {
+    (*(size_t*)visitorCtx)++;
+}
+
+static size_t
+countNodes(UA_Server *server) {
+    size_t count = 0;
+    UA_Nodestore *ns = &UA_Server_getConfig(server)->nodestore;
+    ns->iterate(ns->context, countVisitor, &count);
+    return count;
+}
+
+static UA_Server *
+newServerFromImage(void) {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_StatusCode res = UA_Nodestore_Image(&config.nodestore, &image, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ServerConfig_setDefault(&config);
+    config.eventLoop->dateTime_now = UA_DateTime_now_fake;
+    config.eventLoop->dateTime_nowMonotonic = UA_DateTime_now_fake;
+    config.tcpReuseAddr = true;
+    return UA_Server_newWithConfig(&config);
+}
+
+static void setup(void) {
+    clock_t begin = clock();
+    UA_Server *server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    clock_t end = clock();
+    printf("Server startup: %f ms\n", (double)(end - begin) / CLOCKS_PER_SEC * 1000.0);
+
+    /* Add a variable with a static value */
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 value = 42;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, IMAGE_VARIABLE),
+                                  UA_NS0ID(OBJECTSFOLDER), UA_NS0ID(ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "ImageVariable"),
+                                  UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    imageNodes = countNodes(server);
+    res = UA_Nodestore_saveImage(&UA_Server_getConfig(server)->nodestore, &image);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Server_delete(server);
+}
+
+static void teardown(void) {
+    UA_ByteString_clear(&image);
+}
+
+START_TEST(startFromImage) {
+    clock_t begin = clock();
+    UA_Server *server = newServerFromImage();
+    ck_assert(server != NULL);
+    clock_t end = clock();
+    printf("Server startup from image (%u bytes): %f ms\n", (unsigned)image.length,
+           (double)(end - begin) / CLOCKS_PER_SEC * 1000.0);
+
+    UA_StatusCode res = UA_Server_run_startup(server);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The static value comes from the image */
+    UA_Variant value;
+    res = UA_Server_readValue(server, UA_NODEID_NUMERIC(1, IMAGE_VARIABLE), &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_INT32]));
+    ck_assert_int_eq(*(UA_Int32*)value.data, 42);
+    UA_Variant_clear(&value);
+
+    /* The DataSources of ns0 are attached again */
+    res = UA_Server_readValue(server, UA_NS0ID(SERVER_SERVERSTATUS_CURRENTTIME), &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_DATETIME]));
+    UA_Variant_clear(&value);
+
+    /* Browse the references loaded from the image */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NS0ID(OBJECTSFOLDER);
+    bd.referenceTypeId = UA_NS0ID(ORGANIZES);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_BROWSENAME;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    UA_Boolean found = false;
+    for(size_t i = 0; i < br.referencesSize; i++) {
+        if(br.references[i].nodeId.nodeId.identifier.numeric == IMAGE_VARIABLE) {
+            UA_QualifiedName qn = UA_QUALIFIEDNAME(1, "ImageVariable");
+            ck_assert(UA_QualifiedName_equal(&br.references[i].browseName, &qn));
+            found = true;
+        }
+    }
+    ck_assert(found);
+    UA_BrowseResult_clear(&br);
+
+    ck_assert_uint_eq(countNodes(server), imageNodes);
+
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+} END_TEST
+
+START_TEST(editOverlay) {
+    UA_Server *server = newServerFromImage();
+    ck_assert(server != NULL);
+
+    /* Write into a node from the image */
+    UA_Int32 v = 43;
+    UA_Variant value;
+    UA_Variant_setScalar(&value, &v, &UA_TYPES[UA_TYPES_INT32]);
+    UA_NodeId varId = UA_NODEID_NUMERIC(1, IMAGE_VARIABLE);
+    UA_StatusCode res = UA_Server_writeValue(server, varId, value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_readValue(server, varId, &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)value.data, 43);
+    UA_Variant_clear(&value);
+
+    /* The NodeIds in the image are taken */
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    res = UA_Server_addObjectNode(server, UA_NS0ID(SERVER), UA_NS0ID(OBJECTSFOLDER),
+                                  UA_NS0ID(ORGANIZES), UA_QUALIFIEDNAME(1, "Server2"),
+                                  UA_NS0ID(BASEOBJECTTYPE), oattr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDEXISTS);
+
+    /* New nodes get a fresh NodeId */
+    UA_NodeId newId;
+    res = UA_Server_addObjectNode(server, UA_NODEID_NUMERIC(1, 0), UA_NS0ID(OBJECTSFOLDER),
+                                  UA_NS0ID(ORGANIZES), UA_QUALIFIEDNAME(1, "NewObject"),
+                                  UA_NS0ID(BASEOBJECTTYPE), oattr, NULL, &newId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(!UA_NodeId_equal(&newId, &varId));
+    UA_QualifiedName bn;
+    res = UA_Server_readBrowseName(server, newId, &bn);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_QualifiedName_clear(&bn);
+
+    /* Removed nodes are not loaded again from the image */
+    res = UA_Server_deleteNode(server, varId, true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_readValue(server, varId, &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    ck_assert_uint_eq(countNodes(server), imageNodes);
+
+    /* A removed NodeId can be used again */
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    res = UA_Server_addVariableNode(server, varId, UA_NS0ID(OBJECTSFOLDER),
+                                    UA_NS0ID(ORGANIZES), UA_QUALIFIEDNAME(1, "Again"),
+                                    UA_NS0ID(BASEDATAVARIABLETYPE), vattr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Server_delete(server);
+} END_TEST
+
+START_TEST(saveLoadedImage) {
+    /* Saving from an Image Nodestore yields the same nodes */
+    UA_Nodestore ns;
+    UA_StatusCode res = UA_Nodestore_Image(&ns, &image, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ByteString image2;
+    res = UA_Nodestore_saveImage(&ns, &image2);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(image2.length, image.length);
+    ns.clear(ns.context);
+
+    UA_Nodestore ns2;
+    res = UA_Nodestore_Image(&ns2, &image2, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    size_t count = 0;
+    ns2.iterate(ns2.context, countVisitor, &count);
+    ck_assert_uint_eq(count, imageNodes);
+    ns2.clear(ns2.context);
+    UA_ByteString_clear(&image2);
+} END_TEST
+
+START_TEST(invalidImage) {
+    UA_Nodestore ns;
+    UA_ByteString truncated = {image.length / 2, image.data};
+    UA_StatusCode res = UA_Nodestore_Image(&ns, &truncated, NULL);
+    ck_assert_uint_ne(res, UA_STATUSCODE_GOOD);
+
+    UA_ByteString corrupt;
+    UA_ByteString_copy(&image, &corrupt);
+    corrupt.data[0] ^= 0xff;
+    res = UA_Nodestore_Image(&ns, &corrupt, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADDECODINGERROR);
+    UA_ByteString_clear(&corrupt);
+} END_TEST
+
+#ifdef UA_ARCHITECTURE_POSIX
+START_TEST(mapImageFile) {
+    char path[] = "/tmp/open62541_image_XXXXXX";
+    int fd = mkstemp(path);
+    ck_assert_int_ge(fd, 0);
+    FILE *f = fdopen(fd, "wb");
+    ck_assert(f != NULL);
+    ck_assert_uint_eq(fwrite(image.data, 1, image.length, f), image.length);
+    fclose(f);
+
+    UA_Nodestore ns;
+    UA_StatusCode res = UA_Nodestore_ImageFile(&ns, path, NULL);
+    unlink(path);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_NodeId varId = UA_NODEID_NUMERIC(1, IMAGE_VARIABLE);
+    const UA_Node *node = ns.getNode(ns.context, &varId, UA_NODEATTRIBUTESMASK_ALL,
+                                     UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert(node != NULL);
+    ck_assert_uint_eq(node->head.nodeClass, UA_NODECLASS_VARIABLE);
+    ns.releaseNode(ns.context, node);
+    ns.clear(ns.context);
+
+    res = UA_Nodestore_ImageFile(&ns, path, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNOTFOUND);
+} END_TEST
+#endif
+
+static Suite *testSuite_NodestoreImage(void) {
+    Suite *s = suite_create("Nodestore Image");
+    TCase *tc = tcase_create("Image");
+    tcase_add_unchecked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, startFromImage);
+    tcase_add_test(tc, editOverlay);
+    tcase_add_test(tc, saveLoadedImage);
+    tcase_add_test(tc, invalidImage);
+#ifdef UA_ARCHITECTURE_POSIX
+    tcase_add_test(tc, mapImageFile);
+#endif
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_NodestoreImage();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
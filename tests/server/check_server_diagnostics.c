@@ -0,0 +1,340 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "server/ua_server_internal.h"
+#include "server/ua_services.h"
+#include "server/ua_subscription.h"
+
+#include <check.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+
+static UA_Server *server = NULL;
+static UA_Session *session = NULL;
+
+static void
+createSession(void) {
+    UA_CreateSessionRequest request;
+    UA_CreateSessionRequest_init(&request);
+    request.requestedSessionTimeout = UA_UINT32_MAX;
+    lockServer(server);
+    UA_StatusCode retval = UA_Server_createSession(server, NULL, &request, &session);
+    session->sessionName = UA_STRING_ALLOC("TestSession");
+    unlockServer(server);
+    ck_assert_uint_eq(retval, 0);
+}
+
+/* Count the nodes that are allocated outside of the Nodestore and not yet
+ * deleted or handed over to the Nodestore. Synthesized nodes are never handed
+ * over. */
+static UA_Nodestore origNs;
+static size_t pendingNodes;
+
+static UA_Node *
+countNewNode(void *nsCtx, UA_NodeClass nodeClass) {
+    UA_Node *node = origNs.newNode(nsCtx, nodeClass);
+    if(node)
+        pendingNodes++;
+    return node;
+}
+
+static UA_StatusCode
+countGetNodeCopy(void *nsCtx, const UA_NodeId *nodeId, UA_Node **outNode) {
+    UA_StatusCode res = origNs.getNodeCopy(nsCtx, nodeId, outNode);
+    if(res == UA_STATUSCODE_GOOD)
+        pendingNodes++;
+    return res;
+}
+
+static void
+countDeleteNode(void *nsCtx, UA_Node *node) {
+    pendingNodes--;
+    origNs.deleteNode(nsCtx, node);
+}
+
+static UA_StatusCode
+countInsertNode(void *nsCtx, UA_Node *node, UA_NodeId *addedNodeId) {
+    pendingNodes--;
+    return origNs.insertNode(nsCtx, node, addedNodeId);
+}
+
+static UA_StatusCode
+countReplaceNode(void *nsCtx, UA_Node *node) {
+    pendingNodes--;
+    return origNs.replaceNode(nsCtx, node);
+}
+
+static void setup(void) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_run_startup(server);
+    createSession();
+
+    UA_Nodestore *ns = &UA_Server_getConfig(server)->nodestore;
+    origNs = *ns;
+    ns->newNode = countNewNode;
+    ns->getNodeCopy = countGetNodeCopy;
+    ns->deleteNode = countDeleteNode;
+    ns->insertNode = countInsertNode;
+    ns->replaceNode = countReplaceNode;
+    pendingNodes = 0;
+}
+
+static void teardown(void) {
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static void
+countNodes(void *visitorCtx, const UA_Node *node) {
+    (*(size_t*)visitorCtx)++;
+}
+
+static size_t
+nodestoreSize(void) {
+    size_t count = 0;
+    server->config.nodestore.iterate(server->config.nodestore.context,
+                                     countNodes, &count);
+    return count;
+}
+
+/* Browse the forward HasComponent references */
+static UA_BrowseResult
+browseComponents(const UA_NodeId nodeId) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = nodeId;
+    bd.referenceTypeId = UA_NS0ID(HASCOMPONENT);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    return UA_Server_browse(server, 0, &bd);
+}
+
+static UA_NodeId
+findChild(const UA_NodeId origin, char *name) {
+    UA_QualifiedName qn = UA_QUALIFIEDNAME(0, name);
+    UA_BrowsePathResult bpr = UA_Server_browseSimplifiedBrowsePath(server, origin, 1, &qn);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targetsSize, 1);
+    UA_NodeId result;
+    UA_NodeId_copy(&bpr.targets[0].targetId.nodeId, &result);
+    UA_BrowsePathResult_clear(&bpr);
+    return result;
+}
+
+START_TEST(browseSessionObject) {
+    UA_BrowseResult br =
+        browseComponents(UA_NS0ID(SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY));
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    UA_Boolean found = false;
+    for(size_t i = 0; i < br.referencesSize; i++) {
+        UA_ReferenceDescription *rd = &br.references[i];
+        if(!UA_NodeId_equal(&rd->nodeId.nodeId, &session->sessionId))
+            continue;
+        UA_String name = UA_STRING("TestSession");
+        ck_assert(UA_String_equal(&rd->browseName.name, &name));
+        ck_assert_uint_eq(rd->nodeClass, UA_NODECLASS_OBJECT);
+        UA_NodeId typeId = UA_NS0ID(SESSIONDIAGNOSTICSOBJECTTYPE);
+        ck_assert(UA_NodeId_equal(&rd->typeDefinition.nodeId, &typeId));
+        found = true;
+    }
+    ck_assert(found);
+    UA_BrowseResult_clear(&br);
+
+    /* Only the SessionId has the prefix of the virtual nodes */
+    ck_assert(isDiagnosticsNodeId(&session->sessionId));
+    UA_NodeId guidId = UA_NODEID_GUID(1, UA_Guid_random());
+    ck_assert(!isDiagnosticsNodeId(&guidId));
+
+    /* The mandatory children of the SessionDiagnosticsObjectType */
+    br = browseComponents(session->sessionId);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br.referencesSize, 3);
+    UA_BrowseResult_clear(&br);
+
+    /* Browse the inverse reference back to the session object */
+    UA_NodeId sd = findChild(session->sessionId, "SessionDiagnostics");
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = sd;
+    bd.referenceTypeId = UA_NS0ID(HASCOMPONENT);
+    bd.browseDirection = UA_BROWSEDIRECTION_INVERSE;
+    br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br.referencesSize, 1);
+    ck_assert(UA_NodeId_equal(&br.references[0].nodeId.nodeId, &session->sessionId));
+    UA_BrowseResult_clear(&br);
+    UA_NodeId_clear(&sd);
+
+    /* All synthesized nodes were released */
+    ck_assert_uint_eq(pendingNodes, 0);
+} END_TEST
+
+START_TEST(readSessionDiagnostics) {
+    UA_NodeId sd = findChild(session->sessionId, "SessionDiagnostics");
+    UA_NodeId sn = findChild(sd, "SessionName");
+
+    /* Read the structure */
+    UA_Variant value;
+    UA_StatusCode res = UA_Server_readValue(server, sd, &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_SESSIONDIAGNOSTICSDATATYPE]));
+    UA_SessionDiagnosticsDataType *sddt = (UA_SessionDiagnosticsDataType*)value.data;
+    ck_assert(UA_NodeId_equal(&sddt->sessionId, &session->sessionId));
+    UA_Variant_clear(&value);
+
+    /* Read a member. Values are taken from the session of the node, not from
+     * the (admin) session that reads. */
+    res = UA_Server_readValue(server, sn, &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_STRING]));
+    UA_String name = UA_STRING("TestSession");
+    ck_assert(UA_String_equal((UA_String*)value.data, &name));
+    UA_Variant_clear(&value);
+
+    /* The node is gone with the session */
+    lockServer(server);
+    UA_Server_removeSessionByToken(server, &session->authenticationToken,
+                                   UA_SHUTDOWNREASON_CLOSE);
+    unlockServer(server);
+    res = UA_Server_readValue(server, sn, &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    UA_NodeId_clear(&sn);
+    UA_NodeId_clear(&sd);
+    ck_assert_uint_eq(pendingNodes, 0);
+} END_TEST
+
+START_TEST(noNodestoreStorage) {
+    /* The session created in the setup added no nodes. Neither does a second
+     * session or browsing and reading the diagnostics. */
+    size_t before = nodestoreSize();
+    UA_Session *first = session;
+    createSession();
+
+    UA_BrowseResult br =
+        browseComponents(UA_NS0ID(SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY));
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    size_t sessions = 0;
+    for(size_t i = 0; i < br.referencesSize; i++) {
+        if(UA_NodeId_equal(&br.references[i].nodeId.nodeId, &first->sessionId) ||
+           UA_NodeId_equal(&br.references[i].nodeId.nodeId, &session->sessionId))
+            sessions++;
+    }
+    ck_assert_uint_eq(sessions, 2);
+    UA_BrowseResult_clear(&br);
+
+    UA_NodeId ssd = findChild(session->sessionId, "SessionSecurityDiagnostics");
+    UA_Variant value;
+    UA_StatusCode res = UA_Server_readValue(server, ssd, &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&value);
+    UA_NodeId_clear(&ssd);
+
+    ck_assert_uint_eq(nodestoreSize(), before);
+    ck_assert_uint_eq(pendingNodes, 0);
+} END_TEST
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+
+static UA_UInt32
+createSubscription(void) {
+    UA_CreateSubscriptionRequest request;
+    UA_CreateSubscriptionRequest_init(&request);
+    request.publishingEnabled = true;
+    UA_CreateSubscriptionResponse response;
+    UA_CreateSubscriptionResponse_init(&response);
+    lockServer(server);
+    Service_CreateSubscription(server, session, &request, &response);
+    unlockServer(server);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UInt32 subscriptionId = response.subscriptionId;
+    UA_CreateSubscriptionResponse_clear(&response);
+    return subscriptionId;
+}
+
+START_TEST(subscriptionDiagnostics) {
+    size_t before = nodestoreSize();
+    UA_UInt32 subscriptionId = createSubscription();
+    ck_assert_uint_eq(nodestoreSize(), before);
+
+    /* Referenced from the server-wide array */
+    UA_BrowseResult br =
+        browseComponents(UA_NS0ID(SERVER_SERVERDIAGNOSTICS_SUBSCRIPTIONDIAGNOSTICSARRAY));
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br.referencesSize, 1);
+    UA_NodeId subNode;
+    UA_NodeId_copy(&br.references[0].nodeId.nodeId, &subNode);
+    UA_BrowseResult_clear(&br);
+
+    /* And from the array in the session object */
+    UA_NodeId sessionArray = findChild(session->sessionId, "SubscriptionDiagnosticsArray");
+    br = browseComponents(sessionArray);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br.referencesSize, 1);
+    ck_assert(UA_NodeId_equal(&br.references[0].nodeId.nodeId, &subNode));
+    UA_BrowseResult_clear(&br);
+
+    /* Read the variable and a member */
+    UA_Variant value;
+    UA_StatusCode res = UA_Server_readValue(server, subNode, &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&value,
+                                       &UA_TYPES[UA_TYPES_SUBSCRIPTIONDIAGNOSTICSDATATYPE]));
+    UA_SubscriptionDiagnosticsDataType *sddt =
+        (UA_SubscriptionDiagnosticsDataType*)value.data;
+    ck_assert_uint_eq(sddt->subscriptionId, subscriptionId);
+    UA_Variant_clear(&value);
+
+    UA_NodeId idNode = findChild(subNode, "SubscriptionId");
+    res = UA_Server_readValue(server, idNode, &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_UINT32]));
+    ck_assert_uint_eq(*(UA_UInt32*)value.data, subscriptionId);
+    UA_Variant_clear(&value);
+
+    /* The node is gone with the subscription */
+    lockServer(server);
+    UA_Subscription *sub = UA_Session_getSubscriptionById(session, subscriptionId);
+    ck_assert(sub != NULL);
+    UA_Subscription_delete(server, sub);
+    unlockServer(server);
+    res = UA_Server_readValue(server, idNode, &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    UA_NodeId_clear(&idNode);
+    UA_NodeId_clear(&sessionArray);
+    UA_NodeId_clear(&subNode);
+    ck_assert_uint_eq(pendingNodes, 0);
+} END_TEST
+
+#endif
+
+static Suite* testSuite_Diagnostics(void) {
+    Suite *s = suite_create("Server Diagnostics");
+    TCase *tc = tcase_create("Virtual Nodes");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, browseSessionObject);
+    tcase_add_test(tc, readSessionDiagnostics);
+    tcase_add_test(tc, noNodestoreStorage);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    tcase_add_test(tc, subscriptionDiagnostics);
+#endif
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_Diagnostics();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -83,12 +83,125 @@ START_TEST(monitorIntegerNoChanges) {
 }
 END_TEST
 
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+/* Count the allocations during sampling */
+static size_t allocCount = 0;
+
+static void *
+countingMalloc(size_t size) {
+    allocCount++;
+    return malloc(size);
+}
+
+static void *
+countingCalloc(size_t nelem, size_t elsize) {
+    allocCount++;
+    return calloc(nelem, elsize);
+}
+
+static void *
+countingRealloc(void *ptr, size_t size) {
+    allocCount++;
+    return realloc(ptr, size);
+}
+#endif
+
+START_TEST(monitorIntegerChanges) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 myInteger = 0;
+    UA_Variant_setScalar(&attr.value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+    attr.displayName = UA_LOCALIZEDTEXT("en-US","the answer");
+    UA_NodeId myIntegerNodeId = UA_NODEID_STRING(1, "the.answer");
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, myIntegerNodeId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "the answer"),
+                                  UA_NODEID_NULL, attr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Sample manually */
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = myIntegerNodeId;
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_VALUE;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    item.requestedParameters.samplingInterval = 1000000.0;
+    UA_MonitoredItemCreateResult res =
+        UA_Server_createDataChangeMonitoredItem(server, UA_TIMESTAMPSTORETURN_NEITHER,
+                                                item, NULL, dataChangeNotificationCallback);
+    ck_assert_uint_eq(res.statusCode, UA_STATUSCODE_GOOD);
+
+    UA_MonitoredItem *mon = LIST_FIRST(&server->adminSubscription->monitoredItems);
+    ck_assert_ptr_ne(mon, NULL);
+
+    /* Every sample is a change. The queue has size one. So the previous
+     * notification is deleted and can be reused for the next change. */
+    UA_Notification *seen[2] = {NULL, NULL};
+    size_t samples = 100000;
+    size_t samplingAllocs = 0;
+    clock_t samplingTime = 0;
+    for(size_t i = 1; i <= samples; i++) {
+        myInteger = (UA_Int32)i;
+        UA_Variant value;
+        UA_Variant_setScalar(&value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+        retval = UA_Server_writeValue(server, myIntegerNodeId, value);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+        clock_t begin = clock();
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+        allocCount = 0;
+        UA_mallocSingleton = countingMalloc;
+        UA_callocSingleton = countingCalloc;
+        UA_reallocSingleton = countingRealloc;
+#endif
+        UA_LOCK(&server->serviceMutex);
+        UA_MonitoredItem_sample(server, mon);
+        UA_UNLOCK(&server->serviceMutex);
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+        UA_mallocSingleton = malloc;
+        UA_callocSingleton = calloc;
+        UA_reallocSingleton = realloc;
+        if(i > 2)
+            samplingAllocs += allocCount;
+#endif
+        samplingTime += clock() - begin;
+
+        /* The sampled value is the last value and the single notification */
+        ck_assert_uint_eq(mon->queueSize, 1);
+        UA_Notification *n = TAILQ_FIRST(&mon->queue);
+        ck_assert_int_eq(*(UA_Int32*)n->data.dataChange.value.value.data, myInteger);
+        ck_assert_int_eq(*(UA_Int32*)mon->lastValue.value.data, myInteger);
+
+        /* After warmup the two notifications alternate */
+        if(i <= 2)
+            seen[i - 1] = n;
+        else
+            ck_assert(n == seen[0] || n == seen[1]);
+    }
+
+    double time_spent = (double)samplingTime / CLOCKS_PER_SEC;
+    printf("%lu changed samples took %f s\n", (unsigned long)samples, time_spent);
+
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    /* Only the value from the read is allocated. It is moved into the
+     * notification without further copies. */
+    printf("allocations per changed sample: %f\n",
+           (double)samplingAllocs / (double)(samples - 2));
+    ck_assert_uint_le(samplingAllocs, samples - 2);
+#endif
+
+    UA_Server_deleteMonitoredItem(server, res.monitoredItemId);
+}
+END_TEST
+
 static Suite * monitoring_speed_suite (void) {
     Suite *s = suite_create ("Monitoring Speed");
 
     TCase* tc_datachange = tcase_create ("DataChange");
     tcase_add_checked_fixture(tc_datachange, setup, teardown);
     tcase_add_test (tc_datachange, monitorIntegerNoChanges);
+    tcase_add_test (tc_datachange, monitorIntegerChanges);
     suite_add_tcase (s, tc_datachange);
 
     return s;
@@ -49,12 +49,47 @@ START_TEST(addVariable) {
 }
 END_TEST
 
+/* Record the longest single AddNodes call while the address space grows. The
+ * Nodestore resizes incrementally, so no single call should pay for a full
+ * rehash. */
+#define STALL_NODES 200000
+
+START_TEST(addVariableMaxStall) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 myInteger = 42;
+    UA_Variant_setScalar(&attr.value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+    UA_QualifiedName name = UA_QUALIFIEDNAME(1, "stall");
+    UA_NodeId parentNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId parentReferenceNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+
+    UA_DateTime maxStall = 0;
+    UA_DateTime begin = UA_DateTime_nowMonotonic();
+    for(UA_UInt32 i = 0; i < STALL_NODES; i++) {
+        UA_DateTime before = UA_DateTime_nowMonotonic();
+        UA_StatusCode res =
+            UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, i + 1),
+                                      parentNodeId, parentReferenceNodeId, name,
+                                      UA_NODEID_NULL, attr, NULL, NULL);
+        UA_DateTime stall = UA_DateTime_nowMonotonic() - before;
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+        if(stall > maxStall)
+            maxStall = stall;
+    }
+    UA_DateTime end = UA_DateTime_nowMonotonic();
+    printf("%i nodes:\t Duration was %f s, max stall %.3f ms\n", STALL_NODES,
+           (double)(end - begin) / UA_DATETIME_SEC,
+           (double)maxStall / UA_DATETIME_MSEC);
+}
+END_TEST
+
 static Suite * service_speed_suite (void) {
     Suite *s = suite_create ("Service Speed");
 
     TCase* tc_addnodes = tcase_create ("AddNodes");
     tcase_add_checked_fixture(tc_addnodes, setup, teardown);
     tcase_add_test(tc_addnodes, addVariable);
+    tcase_add_test(tc_addnodes, addVariableMaxStall);
+    tcase_set_timeout(tc_addnodes, 120);
     suite_add_tcase(s, tc_addnodes);
 
     return s;
@@ -863,6 +863,83 @@ START_TEST(Server_negativeSamplingInterval) {
 }
 END_TEST
 
+/* MonitoredItems with the same sampling interval share a SamplingGroup. Within
+ * the group they are bucketed by the sampled node. */
+START_TEST(Server_samplingGroup) {
+    createSubscription();
+
+    UA_MonitoredItemCreateRequest items[10];
+    for(size_t i = 0; i < 10; i++) {
+        UA_MonitoredItemCreateRequest_init(&items[i]);
+        items[i].itemToMonitor.nodeId = (i < 6) ?
+            UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER) :
+            UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+        items[i].itemToMonitor.attributeId = (i < 6) ?
+            UA_ATTRIBUTEID_BROWSENAME : UA_ATTRIBUTEID_VALUE;
+        items[i].monitoringMode = UA_MONITORINGMODE_REPORTING;
+        items[i].requestedParameters.samplingInterval = 250.0;
+        items[i].requestedParameters.queueSize = 10;
+    }
+
+    UA_CreateMonitoredItemsRequest request;
+    UA_CreateMonitoredItemsRequest_init(&request);
+    request.subscriptionId = subscriptionId;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_SERVER;
+    request.itemsToCreateSize = 10;
+    request.itemsToCreate = items;
+
+    UA_CreateMonitoredItemsResponse response;
+    UA_CreateMonitoredItemsResponse_init(&response);
+    lockServer(server);
+    Service_CreateMonitoredItems(server, session, &request, &response);
+    unlockServer(server);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 10);
+    UA_UInt32 ids[10];
+    for(size_t i = 0; i < 10; i++) {
+        ck_assert_uint_eq(response.results[i].statusCode, UA_STATUSCODE_GOOD);
+        ck_assert(response.results[i].revisedSamplingInterval == 250.0);
+        ids[i] = response.results[i].monitoredItemId;
+    }
+    UA_CreateMonitoredItemsResponse_clear(&response);
+
+    /* One group with two sampled nodes */
+    UA_SamplingGroup *sg = LIST_FIRST(&server->samplingGroups);
+    ck_assert_ptr_ne(sg, NULL);
+    ck_assert_ptr_eq(LIST_NEXT(sg, listEntry), NULL);
+    ck_assert_uint_eq(sg->monitoredItemsSize, 10);
+    UA_SampledNode *sn = TAILQ_FIRST(&sg->nodes);
+    ck_assert_ptr_ne(sn, NULL);
+    ck_assert_ptr_ne(TAILQ_NEXT(sn, listEntry), NULL);
+    ck_assert_ptr_eq(TAILQ_NEXT(TAILQ_NEXT(sn, listEntry), listEntry), NULL);
+
+    /* The changing CurrentTime is sampled for all its MonitoredItems */
+    UA_Subscription *sub = getSubscriptionById(server, subscriptionId);
+    ck_assert_ptr_ne(sub, NULL);
+    UA_MonitoredItem *mon = UA_Subscription_getMonitoredItem(sub, ids[9]);
+    ck_assert_ptr_ne(mon, NULL);
+    size_t queueSize = mon->queueSize;
+    UA_fakeSleep(251);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_gt(mon->queueSize, queueSize);
+
+    /* Deleting the MonitoredItems removes the group */
+    UA_DeleteMonitoredItemsRequest deleteRequest;
+    UA_DeleteMonitoredItemsRequest_init(&deleteRequest);
+    deleteRequest.subscriptionId = subscriptionId;
+    deleteRequest.monitoredItemIds = ids;
+    deleteRequest.monitoredItemIdsSize = 10;
+    UA_DeleteMonitoredItemsResponse deleteResponse;
+    UA_DeleteMonitoredItemsResponse_init(&deleteResponse);
+    lockServer(server);
+    Service_DeleteMonitoredItems(server, session, &deleteRequest, &deleteResponse);
+    unlockServer(server);
+    ck_assert_uint_eq(deleteResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert(LIST_EMPTY(&server->samplingGroups));
+    UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
+}
+END_TEST
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
 
 static Suite* testSuite_Client(void) {
@@ -885,6 +962,7 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_server, Server_publishCallback);
     tcase_add_test(tc_server, Server_lifeTimeCount);
     tcase_add_test(tc_server, Server_invalidPublishingInterval);
+    tcase_add_test(tc_server, Server_samplingGroup);
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
     suite_add_tcase(s, tc_server);
 
@@ -6,6 +6,7 @@
 #include <open62541/client_config_default.h>
 #include <open62541/server.h>
 #include <open62541/server_config_default.h>
+#include <open62541/plugin/nodestore_default.h>
 
 #include "server/ua_server_internal.h"
 
@@ -303,6 +304,102 @@ START_TEST(Service_Browse_Recursive) {
 }
 END_TEST
 
+/* Browse all nodes reachable from the root. Returns the number of
+ * references. */
+static size_t
+browseAll(UA_Server *server, size_t *nodesSize, UA_ExpandedNodeId **nodes) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ROOTFOLDER);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+    bd.includeSubtypes = true;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    UA_StatusCode res = UA_Server_browseRecursive(server, &bd, nodesSize, nodes);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    size_t refs = 0;
+    bd.referenceTypeId = UA_NODEID_NULL;
+    bd.browseDirection = UA_BROWSEDIRECTION_BOTH;
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    for(size_t i = 0; i < *nodesSize; i++) {
+        bd.nodeId = (*nodes)[i].nodeId;
+        UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+        ck_assert_int_eq(br.statusCode, UA_STATUSCODE_GOOD);
+        refs += br.referencesSize;
+        UA_BrowseResult_clear(&br);
+    }
+    return refs;
+}
+
+START_TEST(Service_Browse_DirectNodePointers) {
+    UA_Server *server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Nodestore *ns = &UA_Server_getConfig(server)->nodestore;
+
+    /* Browse before and after resolving the references to node pointers */
+    size_t nodesSize = 0, directNodesSize = 0;
+    UA_ExpandedNodeId *nodes = NULL, *directNodes = NULL;
+    UA_DateTime begin = UA_DateTime_nowMonotonic();
+    size_t refs = browseAll(server, &nodesSize, &nodes);
+    UA_DateTime mid = UA_DateTime_nowMonotonic();
+    ck_assert_int_eq(UA_Nodestore_HashMap_resolveReferences(ns), UA_STATUSCODE_GOOD);
+    UA_DateTime resolved = UA_DateTime_nowMonotonic();
+    size_t directRefs = browseAll(server, &directNodesSize, &directNodes);
+    UA_DateTime end = UA_DateTime_nowMonotonic();
+    printf("Browse %u nodes with %u references: %.2fms with NodeIds, "
+           "%.2fms with node pointers (resolved in %.2fms)\n",
+           (unsigned)nodesSize, (unsigned)refs,
+           (double)(mid - begin) / UA_DATETIME_MSEC,
+           (double)(end - resolved) / UA_DATETIME_MSEC,
+           (double)(resolved - mid) / UA_DATETIME_MSEC);
+    ck_assert_uint_eq(refs, directRefs);
+    ck_assert_uint_eq(nodesSize, directNodesSize);
+    for(size_t i = 0; i < nodesSize; i++)
+        ck_assert(UA_ExpandedNodeId_equal(&nodes[i], &directNodes[i]));
+    UA_Array_delete(nodes, nodesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    UA_Array_delete(directNodes, directNodesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+
+    /* Add a node and resolve the references to it */
+    UA_NodeId objects = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId organizes = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    UA_NodeId newId = UA_NODEID_STRING(1, "DirectTarget");
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    UA_StatusCode res =
+        UA_Server_addObjectNode(server, newId, objects, organizes,
+                                UA_QUALIFIEDNAME(1, "DirectTarget"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                oAttr, NULL, NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(UA_Nodestore_HashMap_resolveReferences(ns), UA_STATUSCODE_GOOD);
+
+    /* Remove only the inverse reference. Then the forward reference from the
+     * ObjectsFolder remains when the node is deleted. */
+    UA_ExpandedNodeId objectsEn = UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    res = UA_Server_deleteReference(server, newId, organizes, false, objectsEn, false);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_deleteNode(server, newId, true);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The dangling reference is skipped before and after the next resolve */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = objects;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    for(size_t i = 0; i < 2; i++) {
+        UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+        ck_assert_int_eq(br.statusCode, UA_STATUSCODE_GOOD);
+        for(size_t j = 0; j < br.referencesSize; j++)
+            ck_assert(!UA_NodeId_equal(&br.references[j].nodeId.nodeId, &newId));
+        UA_BrowseResult_clear(&br);
+        ck_assert_int_eq(UA_Nodestore_HashMap_resolveReferences(ns),
+                         UA_STATUSCODE_GOOD);
+    }
+
+    UA_Server_delete(server);
+}
+END_TEST
+
 START_TEST(Service_Browse_Localization) {
     UA_Server *server = UA_Server_newForUnitTest();
     ck_assert(server != NULL);
@@ -502,6 +599,7 @@ static Suite *testSuite_Service_TranslateBrowsePathsToNodeIds(void) {
     tcase_add_test(tc_browse, Service_Browse_ReferenceTypes);
     tcase_add_test(tc_browse, Service_Browse_WithMaxResults);
     tcase_add_test(tc_browse, Service_Browse_Recursive);
+    tcase_add_test(tc_browse, Service_Browse_DirectNodePointers);
     tcase_add_test(tc_browse, Service_Browse_Localization);
     suite_add_tcase(s, tc_browse);
 
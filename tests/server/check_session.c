@@ -8,12 +8,14 @@
 #include <open62541/server_config_default.h>
 #include <open62541/types.h>
 
+#include "server/ua_server_internal.h"
 #include "server/ua_services.h"
 #include "client/ua_client_internal.h"
 #include "test_helpers.h"
 
 #include <check.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 #include "thread_wrapper.h"
 
@@ -158,6 +160,124 @@ START_TEST(Session_setSessionAttribute_ShallWork) {
 }
 END_TEST
 
+#define SCALE_SESSIONS 5000
+
+/* Many concurrent sessions. Lookups by AuthenticationToken and SessionId go
+ * through the hash indexes of the server. */
+START_TEST(Session_manySessions) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->maxSessions = SCALE_SESSIONS;
+
+    UA_NodeId *tokens = (UA_NodeId*)
+        UA_Array_new(SCALE_SESSIONS, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_NodeId *ids = (UA_NodeId*)
+        UA_Array_new(SCALE_SESSIONS, &UA_TYPES[UA_TYPES_NODEID]);
+    ck_assert_ptr_ne(tokens, NULL);
+    ck_assert_ptr_ne(ids, NULL);
+
+    UA_CreateSessionRequest createReq;
+    UA_CreateSessionRequest_init(&createReq);
+
+    lockServer(server);
+    for(size_t i = 0; i < SCALE_SESSIONS; i++) {
+        UA_Session *session = NULL;
+        UA_StatusCode res = UA_Server_createSession(server, NULL, &createReq, &session);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        UA_NodeId_copy(&session->authenticationToken, &tokens[i]);
+        UA_NodeId_copy(&session->sessionId, &ids[i]);
+    }
+
+    UA_DateTime begin = UA_DateTime_nowMonotonic();
+    for(size_t i = 0; i < SCALE_SESSIONS; i++) {
+        UA_Session *session = getSessionByToken(server, &tokens[i]);
+        ck_assert_ptr_ne(session, NULL);
+        ck_assert(UA_NodeId_equal(&session->sessionId, &ids[i]));
+        ck_assert_ptr_eq(getSessionById(server, &ids[i]), session);
+    }
+    UA_DateTime duration = UA_DateTime_nowMonotonic() - begin;
+    printf("%u sessions: %.1f ns per lookup\n", SCALE_SESSIONS,
+           (double)(duration * 100) / (2.0 * SCALE_SESSIONS));
+
+    /* Unknown tokens are not found */
+    UA_NodeId unknown = UA_NODEID_GUID(1, UA_Guid_random());
+    ck_assert_ptr_eq(getSessionByToken(server, &unknown), NULL);
+    ck_assert_ptr_eq(getSessionById(server, &unknown), NULL);
+    unlockServer(server);
+
+    /* Close every other session */
+    for(size_t i = 0; i < SCALE_SESSIONS; i += 2)
+        ck_assert_uint_eq(UA_Server_closeSession(server, &ids[i]), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(UA_Server_closeSession(server, &ids[0]),
+                      UA_STATUSCODE_BADSESSIONIDINVALID);
+
+    lockServer(server);
+    for(size_t i = 0; i < SCALE_SESSIONS; i++) {
+        UA_Session *session = getSessionByToken(server, &tokens[i]);
+        if(i % 2 == 0) {
+            ck_assert_ptr_eq(session, NULL);
+            ck_assert_ptr_eq(getSessionById(server, &ids[i]), NULL);
+        } else {
+            ck_assert_ptr_ne(session, NULL);
+            ck_assert_ptr_eq(getSessionById(server, &ids[i]), session);
+        }
+    }
+    unlockServer(server);
+
+    UA_Array_delete(tokens, SCALE_SESSIONS, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_Array_delete(ids, SCALE_SESSIONS, &UA_TYPES[UA_TYPES_NODEID]);
+} END_TEST
+
+#define BOUND_SESSIONS 200
+
+/* Many sessions on one SecureChannel. Requests with the token of a session
+ * that is not activated are rejected with BadSessionNotActivated. Unknown
+ * tokens are rejected with BadSessionIdInvalid. */
+START_TEST(Session_manySessionsOnChannel) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->maxSessions = BOUND_SESSIONS;
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connectSecureChannel(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_NodeId tokens[BOUND_SESSIONS];
+    for(size_t i = 0; i < BOUND_SESSIONS; i++) {
+        UA_CreateSessionRequest createReq;
+        UA_CreateSessionResponse createRes;
+        UA_CreateSessionRequest_init(&createReq);
+        __UA_Client_Service(client, &createReq, &UA_TYPES[UA_TYPES_CREATESESSIONREQUEST],
+                            &createRes, &UA_TYPES[UA_TYPES_CREATESESSIONRESPONSE]);
+        ck_assert_uint_eq(createRes.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+        UA_NodeId_copy(&createRes.authenticationToken, &tokens[i]);
+        UA_CreateSessionResponse_clear(&createRes);
+    }
+
+    for(size_t i = 0; i <= BOUND_SESSIONS; i++) {
+        UA_ReadValueId rvi;
+        UA_ReadValueId_init(&rvi);
+        rvi.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+        rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+        UA_ReadRequest readReq;
+        UA_ReadRequest_init(&readReq);
+        readReq.nodesToRead = &rvi;
+        readReq.nodesToReadSize = 1;
+        readReq.requestHeader.authenticationToken = (i < BOUND_SESSIONS) ?
+            tokens[i] : UA_NODEID_GUID(1, UA_Guid_random());
+        UA_ReadResponse readRes;
+        __UA_Client_Service(client, &readReq, &UA_TYPES[UA_TYPES_READREQUEST],
+                            &readRes, &UA_TYPES[UA_TYPES_READRESPONSE]);
+        ck_assert_uint_eq(readRes.responseHeader.serviceResult,
+                          (i < BOUND_SESSIONS) ? UA_STATUSCODE_BADSESSIONNOTACTIVATED :
+                          UA_STATUSCODE_BADSESSIONIDINVALID);
+        UA_ReadResponse_clear(&readRes);
+    }
+
+    for(size_t i = 0; i < BOUND_SESSIONS; i++)
+        UA_NodeId_clear(&tokens[i]);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
 static Suite* testSuite_Session(void) {
     Suite *s = suite_create("Session");
     TCase *tc_session = tcase_create("Core");
@@ -166,6 +286,8 @@ static Suite* testSuite_Session(void) {
     tcase_add_test(tc_session, Session_init_ShallWork);
     tcase_add_test(tc_session, Session_updateLifetime_ShallWork);
     tcase_add_test(tc_session, Session_setSessionAttribute_ShallWork);
+    tcase_add_test(tc_session, Session_manySessions);
+    tcase_add_test(tc_session, Session_manySessionsOnChannel);
     suite_add_tcase(s,tc_session);
     return s;
 }
@@ -390,6 +390,251 @@ START_TEST(generateEvents) {
     UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
 } END_TEST
 
+/* Trigger an event from a field map without a node representation */
+START_TEST(generateFieldMapEvents) {
+    UA_MonitoredItemCreateResult createResult =
+        addMonitoredItem(handler_events_simple, true, true);
+    ck_assert_uint_eq(createResult.statusCode, UA_STATUSCODE_GOOD);
+    monitoredItemId = createResult.monitoredItemId;
+
+    UA_UInt16 eventSeverity = 1000;
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("en-US", "Generated Event");
+    UA_KeyValuePair fields[2];
+    fields[0].key = UA_QUALIFIEDNAME(0, "Severity");
+    UA_Variant_setScalar(&fields[0].value, &eventSeverity, &UA_TYPES[UA_TYPES_UINT16]);
+    fields[1].key = UA_QUALIFIEDNAME(0, "Message");
+    UA_Variant_setScalar(&fields[1].value, &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    UA_KeyValueMap eventFields = {2, fields};
+
+    serverMutexLock();
+    UA_ByteString eventId = UA_BYTESTRING_NULL;
+    UA_StatusCode retval =
+        UA_Server_triggerEventFields(server, eventType,
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                     &eventFields, &eventId);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(eventId.length, 16);
+    UA_ByteString_clear(&eventId);
+
+    notificationReceived = false;
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval |= UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(notificationReceived, true);
+
+    /* The event type must be a subtype of BaseEventType */
+    serverMutexLock();
+    retval = UA_Server_triggerEventFields(server, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                          UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                          &eventFields, NULL);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADINVALIDARGUMENT);
+
+    /* Delete the monitoredItem */
+    UA_DeleteMonitoredItemsRequest deleteRequest;
+    UA_DeleteMonitoredItemsRequest_init(&deleteRequest);
+    deleteRequest.subscriptionId = subscriptionId;
+    deleteRequest.monitoredItemIds = &monitoredItemId;
+    deleteRequest.monitoredItemIdsSize = 1;
+    UA_DeleteMonitoredItemsResponse deleteResponse =
+        UA_Client_MonitoredItems_delete(client, deleteRequest);
+    ck_assert_uint_eq(deleteResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
+} END_TEST
+
+/* Select and where clauses read directly from the field map */
+START_TEST(filterFieldMapEvent) {
+    UA_UInt16 eventSeverity = 500;
+    UA_Boolean enabled = true;
+    UA_KeyValuePair fields[3];
+    fields[0].key = UA_QUALIFIEDNAME(0, "EventType");
+    UA_Variant_setScalar(&fields[0].value, &eventType, &UA_TYPES[UA_TYPES_NODEID]);
+    fields[1].key = UA_QUALIFIEDNAME(0, "Severity");
+    UA_Variant_setScalar(&fields[1].value, &eventSeverity, &UA_TYPES[UA_TYPES_UINT16]);
+    fields[2].key = UA_QUALIFIEDNAME(0, "EnabledState/Id");
+    UA_Variant_setScalar(&fields[2].value, &enabled, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_KeyValueMap eventFields = {3, fields};
+    UA_EventInstance event = {NULL, &eventFields, NULL};
+
+    /* Select Severity, EnabledState/Id and a missing field */
+    UA_QualifiedName severityPath = UA_QUALIFIEDNAME(0, "Severity");
+    UA_QualifiedName enabledPath[2] =
+        {UA_QUALIFIEDNAME(0, "EnabledState"), UA_QUALIFIEDNAME(0, "Id")};
+    UA_QualifiedName missingPath = UA_QUALIFIEDNAME(0, "Message");
+    UA_SimpleAttributeOperand select[3];
+    for(size_t i = 0; i < 3; i++) {
+        UA_SimpleAttributeOperand_init(&select[i]);
+        select[i].typeDefinitionId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+        select[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    select[0].browsePathSize = 1;
+    select[0].browsePath = &severityPath;
+    select[1].browsePathSize = 2;
+    select[1].browsePath = enabledPath;
+    select[2].browsePathSize = 1;
+    select[2].browsePath = &missingPath;
+
+    /* Where: OfType(eventType) */
+    UA_LiteralOperand lo;
+    UA_LiteralOperand_init(&lo);
+    UA_Variant_setScalar(&lo.value, &eventType, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_ExtensionObject operand;
+    UA_ExtensionObject_setValue(&operand, &lo, &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+    UA_ContentFilterElement element;
+    UA_ContentFilterElement_init(&element);
+    element.filterOperator = UA_FILTEROPERATOR_OFTYPE;
+    element.filterOperands = &operand;
+    element.filterOperandsSize = 1;
+
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClauses = select;
+    filter.selectClausesSize = 3;
+    filter.whereClause.elements = &element;
+    filter.whereClause.elementsSize = 1;
+
+    UA_EventFieldList efl;
+    UA_EventFilterResult result;
+    serverMutexLock();
+    lockServer(server);
+    UA_StatusCode retval =
+        filterEvent(server, &server->adminSession, &event, &filter, NULL, &efl, &result);
+    unlockServer(server);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(efl.eventFieldsSize, 3);
+    ck_assert(UA_Variant_hasScalarType(&efl.eventFields[0], &UA_TYPES[UA_TYPES_UINT16]));
+    ck_assert_uint_eq(*(UA_UInt16*)efl.eventFields[0].data, 500);
+    ck_assert(UA_Variant_hasScalarType(&efl.eventFields[1], &UA_TYPES[UA_TYPES_BOOLEAN]));
+    ck_assert(*(UA_Boolean*)efl.eventFields[1].data);
+    ck_assert(UA_Variant_isEmpty(&efl.eventFields[2]));
+    ck_assert_uint_eq(result.selectClauseResults[2], UA_STATUSCODE_BADNOTFOUND);
+    UA_EventFieldList_clear(&efl);
+    UA_EventFilterResult_clear(&result);
+
+    /* The event is not of the BaseModelChangeEventType */
+    UA_NodeId otherType = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEMODELCHANGEEVENTTYPE);
+    UA_Variant_setScalar(&lo.value, &otherType, &UA_TYPES[UA_TYPES_NODEID]);
+    serverMutexLock();
+    lockServer(server);
+    retval = filterEvent(server, &server->adminSession, &event, &filter, NULL, &efl, &result);
+    unlockServer(server);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOMATCH);
+    UA_EventFilterResult_clear(&result);
+} END_TEST
+
+/* Compiled select clauses cache their applicability per EventType */
+START_TEST(compiledSelectClauses) {
+    UA_UInt16 eventSeverity = 500;
+    UA_KeyValuePair fields[2];
+    fields[0].key = UA_QUALIFIEDNAME(0, "EventType");
+    UA_Variant_setScalar(&fields[0].value, &eventType, &UA_TYPES[UA_TYPES_NODEID]);
+    fields[1].key = UA_QUALIFIEDNAME(0, "Severity");
+    UA_Variant_setScalar(&fields[1].value, &eventSeverity, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_KeyValueMap eventFields = {2, fields};
+    UA_EventInstance event = {NULL, &eventFields, NULL};
+
+    /* The second clause is checked against the EventType */
+    UA_QualifiedName severityPath = UA_QUALIFIEDNAME(0, "Severity");
+    UA_SimpleAttributeOperand select[2];
+    for(size_t i = 0; i < 2; i++) {
+        UA_SimpleAttributeOperand_init(&select[i]);
+        select[i].typeDefinitionId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+        select[i].attributeId = UA_ATTRIBUTEID_VALUE;
+        select[i].browsePathSize = 1;
+        select[i].browsePath = &severityPath;
+    }
+    select[1].typeDefinitionId = eventType;
+
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClauses = select;
+    filter.selectClausesSize = 2;
+
+    UA_EventFilterCompiled *ef = UA_EventFilter_compile(&filter);
+    ck_assert_ptr_ne(ef, NULL);
+    ck_assert_uint_eq(ef->selectClauses[0], 0);
+    ck_assert_uint_eq(ef->selectClauses[1], UA_SELECTCLAUSE_TYPED);
+
+    UA_EventFieldList efl;
+    UA_EventFilterResult result;
+    serverMutexLock();
+    lockServer(server);
+    UA_StatusCode retval =
+        filterEvent(server, &server->adminSession, &event, &filter, ef, &efl, &result);
+    unlockServer(server);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_NodeId_equal(&ef->eventType, &eventType));
+    ck_assert(ef->selectClauses[1] & UA_SELECTCLAUSE_VALID);
+    ck_assert(UA_Variant_hasScalarType(&efl.eventFields[1], &UA_TYPES[UA_TYPES_UINT16]));
+    UA_EventFieldList_clear(&efl);
+    UA_EventFilterResult_clear(&result);
+
+    /* A different EventType invalidates the cached flags. The typed clause
+     * does not apply if the EventType is not an event type. */
+    UA_NodeId otherType = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
+    UA_Variant_setScalar(&fields[0].value, &otherType, &UA_TYPES[UA_TYPES_NODEID]);
+    serverMutexLock();
+    lockServer(server);
+    retval = filterEvent(server, &server->adminSession, &event, &filter, ef, &efl, &result);
+    unlockServer(server);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_NodeId_equal(&ef->eventType, &otherType));
+    ck_assert(!(ef->selectClauses[1] & UA_SELECTCLAUSE_VALID));
+    ck_assert(UA_Variant_hasScalarType(&efl.eventFields[0], &UA_TYPES[UA_TYPES_UINT16]));
+    ck_assert(UA_Variant_isEmpty(&efl.eventFields[1]));
+    UA_EventFieldList_clear(&efl);
+    UA_EventFilterResult_clear(&result);
+    UA_EventFilterCompiled_delete(ef);
+} END_TEST
+
+/* The fields of a node event are resolved once and shared by all filters */
+START_TEST(eventFieldCache) {
+    UA_NodeId eventNodeId;
+    UA_StatusCode retval = eventSetup(&eventNodeId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_EventFieldCache cache;
+    memset(&cache, 0, sizeof(UA_EventFieldCache));
+    UA_EventInstance event = {&eventNodeId, NULL, &cache};
+
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClauses = selectClauses;
+    filter.selectClausesSize = nSelectClauses;
+
+    for(size_t i = 0; i < 3; i++) {
+        UA_EventFieldList efl;
+        UA_EventFilterResult result;
+        serverMutexLock();
+        lockServer(server);
+        retval = filterEvent(server, &server->adminSession, &event, &filter,
+                             NULL, &efl, &result);
+        unlockServer(server);
+        serverMutexUnlock();
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert(UA_Variant_hasScalarType(&efl.eventFields[0], &UA_TYPES[UA_TYPES_UINT16]));
+        ck_assert_uint_eq(*(UA_UInt16*)efl.eventFields[0].data, 1000);
+        ck_assert(UA_Variant_hasScalarType(&efl.eventFields[2], &UA_TYPES[UA_TYPES_NODEID]));
+        ck_assert(UA_NodeId_equal((UA_NodeId*)efl.eventFields[2].data, &eventType));
+        UA_EventFieldList_clear(&efl);
+        UA_EventFilterResult_clear(&result);
+        ck_assert_uint_eq(cache.entriesSize, nSelectClauses);
+    }
+    UA_EventFieldCache_clear(&cache);
+
+    serverMutexLock();
+    retval = UA_Server_deleteNode(server, eventNodeId, true);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+} END_TEST
+
 static bool hasBaseModelChangeEventType(void) {
 
     UA_QualifiedName readBrowsename;
@@ -919,6 +1164,10 @@ static Suite *testSuite_Client(void) {
     tcase_add_unchecked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, generateEventEmptyFilter);
     tcase_add_test(tc_server, generateEvents);
+    tcase_add_test(tc_server, generateFieldMapEvents);
+    tcase_add_test(tc_server, filterFieldMapEvent);
+    tcase_add_test(tc_server, compiledSelectClauses);
+    tcase_add_test(tc_server, eventFieldCache);
     tcase_add_test(tc_server, createAbstractEvent);
     tcase_add_test(tc_server, createAbstractEventWithParent);
     tcase_add_test(tc_server, createNonAbstractEventWithParent);
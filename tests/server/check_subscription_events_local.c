@@ -117,11 +117,107 @@ START_TEST(generateEvents) {
     ck_assert_uint_eq(callbackCount, 3);
 } END_TEST
 
+static unsigned areaCallbackCount = 0;
+
+static void
+areaEventCallback(UA_Server *server, UA_UInt32 monitoredItemId,
+                  void *monitoredItemContext, const UA_KeyValueMap eventFields) {
+    areaCallbackCount++;
+}
+
+static UA_NodeId
+addEventObject(const char *name) {
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    attr.eventNotifier = UA_EVENTNOTIFIER_SUBSCRIBE_TO_EVENT;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", (char*)(uintptr_t)name);
+    UA_NodeId nodeId;
+    UA_StatusCode res =
+        UA_Server_addObjectNode(server, UA_NODEID_NULL,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                attr, NULL, &nodeId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    return nodeId;
+}
+
+/* The cached propagation from an origin follows changes of the notifier
+ * references and of the event MonitoredItems */
+START_TEST(propagationIndex) {
+    UA_NodeId area = addEventObject("Area");
+    UA_NodeId source = addEventObject("Source");
+
+    UA_EventFilter ef;
+    UA_EventFilter_init(&ef);
+    ef.selectClauses = UA_SimpleAttributeOperand_new();
+    ef.selectClausesSize = 1;
+    UA_SimpleAttributeOperand_parse(&ef.selectClauses[0], UA_STRING("/Severity"));
+    UA_MonitoredItemCreateResult res =
+        UA_Server_createEventMonitoredItem(server, area, ef, NULL, areaEventCallback);
+    ck_assert_uint_eq(res.statusCode, UA_STATUSCODE_GOOD);
+    UA_EventFilter_clear(&ef);
+
+    UA_NodeId eventNodeId;
+    eventSetup(&eventNodeId);
+
+    /* Source is not below Area */
+    unsigned serverCount = callbackCount;
+    UA_Server_triggerEvent(server, eventNodeId, source, NULL, false);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, serverCount + 1);
+    ck_assert_uint_eq(areaCallbackCount, 0);
+
+    /* Area becomes a notifier of Source */
+    UA_StatusCode retval =
+        UA_Server_addReference(server, area, UA_NODEID_NUMERIC(0, UA_NS0ID_HASNOTIFIER),
+                               UA_EXPANDEDNODEID_NODEID(source), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Server_triggerEvent(server, eventNodeId, source, NULL, false);
+    UA_Server_triggerEvent(server, eventNodeId, source, NULL, false);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, serverCount + 3);
+    ck_assert_uint_eq(areaCallbackCount, 2);
+
+    /* Remove the notifier reference */
+    retval = UA_Server_deleteReference(server, area,
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_HASNOTIFIER),
+                                       true, UA_EXPANDEDNODEID_NODEID(source), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Server_triggerEvent(server, eventNodeId, source, NULL, false);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, serverCount + 4);
+    ck_assert_uint_eq(areaCallbackCount, 2);
+
+    /* Re-add the reference and remove the MonitoredItem */
+    retval = UA_Server_addReference(server, area, UA_NODEID_NUMERIC(0, UA_NS0ID_HASNOTIFIER),
+                                    UA_EXPANDEDNODEID_NODEID(source), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Server_triggerEvent(server, eventNodeId, source, NULL, false);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(areaCallbackCount, 3);
+    retval = UA_Server_deleteMonitoredItem(server, res.monitoredItemId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Server_triggerEvent(server, eventNodeId, source, NULL, false);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, serverCount + 6);
+    ck_assert_uint_eq(areaCallbackCount, 3);
+
+    /* The deleted origin is no longer cached */
+    retval = UA_Server_deleteNode(server, source, true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_triggerEvent(server, eventNodeId, source, NULL, false);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOTFOUND);
+
+    UA_Server_deleteNode(server, eventNodeId, true);
+} END_TEST
+
 static Suite *testSuite_event(void) {
     Suite *s = suite_create("Server Local Subscription Events");
     TCase *tc_server = tcase_create("Server Local Subscription Events");
     tcase_add_unchecked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, generateEvents);
+    tcase_add_test(tc_server, propagationIndex);
     suite_add_tcase(s, tc_server);
     return s;
 }